@@ -98,6 +98,11 @@ struct tac_function {
 	// Using a singly linked list here for convenience, although it is super
 	// inefficient.
 	struct tac_instruction *start;
+
+	// Variables and labels are numbered per function, so functions can be
+	// generated independently (e.g. in parallel).
+	uint64_t variable_count;
+	uint64_t label_count;
 };
 
 struct tac_instruction {
@@ -117,51 +122,51 @@ struct tac_instruction {
 
 // -------------------------------------------------------------------- TAC Generator
 
-struct tac_variable gen_variable(enum tac_variable_type type)
+struct tac_variable gen_variable(struct tac_function *function, enum tac_variable_type type)
 {
-	static uint64_t variable_index = 1;
+	assert(function);
 
 	return (struct tac_variable){
 	    .type = type,
-	    .identifier = variable_index++,
+	    .identifier = ++function->variable_count,
 	};
 }
 
-struct tac_instruction *gen_label(void)
+struct tac_instruction *gen_label(struct tac_function *function)
 {
-	static uint64_t label_index = 1;
+	assert(function);
 
 	struct tac_instruction *result = malloc(sizeof(*result));
 	assert(result);
 
 	*result = (struct tac_instruction){
 	    .op = TAC_INSTRUCTION_OP_LABEL,
-	    .label = label_index++,
+	    .label = ++function->label_count,
 	};
 	return result;
 }
 
-struct tac_instruction *gen_const_int(long value)
+struct tac_instruction *gen_const_int(struct tac_function *function, long value)
 {
 	struct tac_instruction *result = malloc(sizeof(*result));
 	assert(result);
 
 	*result = (struct tac_instruction){
 	    .op = TAC_INSTRUCTION_OP_CONST,
-	    .result = gen_variable(TAC_VARIABLE_TYPE_INT),
+	    .result = gen_variable(function, TAC_VARIABLE_TYPE_INT),
 	    .int_constant = value,
 	};
 	return result;
 }
 
-struct tac_instruction *gen_const_float(double value)
+struct tac_instruction *gen_const_float(struct tac_function *function, double value)
 {
 	struct tac_instruction *result = malloc(sizeof(*result));
 	assert(result);
 
 	*result = (struct tac_instruction){
 	    .op = TAC_INSTRUCTION_OP_CONST,
-	    .result = gen_variable(TAC_VARIABLE_TYPE_FLOAT),
+	    .result = gen_variable(function, TAC_VARIABLE_TYPE_FLOAT),
 	    .float_constant = value,
 	};
 	return result;
@@ -182,7 +187,7 @@ struct tac_instruction *gen_assign(struct tac_variable lhs, struct tac_variable
 	return result;
 }
 
-struct tac_instruction *gen_add(struct tac_variable lhs, struct tac_variable rhs)
+struct tac_instruction *gen_add(struct tac_function *function, struct tac_variable lhs, struct tac_variable rhs)
 {
 	assert(lhs.type == rhs.type);
 
@@ -193,7 +198,7 @@ struct tac_instruction *gen_add(struct tac_variable lhs, struct tac_variable rhs
 	    .op = TAC_INSTRUCTION_OP_ADD,
 	    .arg1 = lhs,
 	    .arg2 = rhs,
-	    .result = gen_variable(lhs.type),
+	    .result = gen_variable(function, lhs.type),
 	};
 	return result;
 }
@@ -228,15 +233,15 @@ struct tac_instruction *gen_jump_if(uint64_t label, struct tac_variable conditio
 	return result;
 }
 
-struct tac_instruction *gen_call(const char *function, enum tac_variable_type result_type)
+struct tac_instruction *gen_call(struct tac_function *function, const char *callee, enum tac_variable_type result_type)
 {
 	struct tac_instruction *result = malloc(sizeof(*result));
 	assert(result);
 
 	*result = (struct tac_instruction){
 	    .op = TAC_INSTRUCTION_OP_CALL,
-	    .result = gen_variable(result_type),
-	    .function = function,
+	    .result = gen_variable(function, result_type),
+	    .function = callee,
 	};
 	return result;
 }
@@ -276,14 +281,14 @@ struct tac_instruction *gen_push(struct tac_variable variable)
 	return result;
 }
 
-struct tac_instruction *gen_pop(enum tac_variable_type result_type)
+struct tac_instruction *gen_pop(struct tac_function *function, enum tac_variable_type result_type)
 {
 	struct tac_instruction *result = malloc(sizeof(*result));
 	assert(result);
 
 	*result = (struct tac_instruction){
 	    .op = TAC_INSTRUCTION_OP_POP,
-	    .result = gen_variable(result_type),
+	    .result = gen_variable(function, result_type),
 	};
 	return result;
 }
@@ -388,36 +393,36 @@ int main(void)
 	    .name = "My TAC Function",
 	};
 
-	struct tac_instruction *inst1 = gen_pop(TAC_VARIABLE_TYPE_INT);
+	struct tac_instruction *inst1 = gen_pop(&my_function, TAC_VARIABLE_TYPE_INT);
 	append_instruction(&my_function, inst1);
 
-	struct tac_instruction *c1 = gen_const_int(1);
+	struct tac_instruction *c1 = gen_const_int(&my_function, 1);
 	append_instruction(&my_function, c1);
 
-	struct tac_instruction *c2 = gen_const_int(2);
+	struct tac_instruction *c2 = gen_const_int(&my_function, 2);
 	append_instruction(&my_function, c2);
 
-	struct tac_instruction *inst2 = gen_add(c1->result, c2->result);
+	struct tac_instruction *inst2 = gen_add(&my_function, c1->result, c2->result);
 	append_instruction(&my_function, inst2);
 
-	struct tac_instruction *inst3 = gen_add(inst2->result, inst1->result);
+	struct tac_instruction *inst3 = gen_add(&my_function, inst2->result, inst1->result);
 	append_instruction(&my_function, inst3);
 
-	struct tac_instruction *l1 = gen_label();
+	struct tac_instruction *l1 = gen_label(&my_function);
 	struct tac_instruction *inst4 = gen_jump_if(l1->label, inst3->result);
 	append_instruction(&my_function, inst4);
 
-	struct tac_instruction *inst5 = gen_add(inst3->result, c1->result);
+	struct tac_instruction *inst5 = gen_add(&my_function, inst3->result, c1->result);
 	append_instruction(&my_function, inst5);
 	append_instruction(&my_function, gen_assign(inst3->result, inst5->result));
 
-	struct tac_instruction *l2 = gen_label();
+	struct tac_instruction *l2 = gen_label(&my_function);
 	struct tac_instruction *inst7 = gen_jump(l2->label);
 	append_instruction(&my_function, inst7);
 
 	append_instruction(&my_function, l1);
 
-	struct tac_instruction *inst8 = gen_add(inst3->result, c2->result);
+	struct tac_instruction *inst8 = gen_add(&my_function, inst3->result, c2->result);
 	append_instruction(&my_function, inst8);
 	append_instruction(&my_function, gen_assign(inst3->result, inst8->result));
 
@@ -427,7 +432,7 @@ int main(void)
 	append_instruction(&my_function, gen_push(c1->result));
 	append_instruction(&my_function, gen_push(inst3->result));
 
-	struct tac_instruction *inst9 = gen_call("some_function", TAC_VARIABLE_TYPE_FLOAT);
+	struct tac_instruction *inst9 = gen_call(&my_function, "some_function", TAC_VARIABLE_TYPE_FLOAT);
 	append_instruction(&my_function, inst9);
 
 	append_instruction(&my_function, gen_return_variable(inst9->result));
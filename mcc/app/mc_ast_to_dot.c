@@ -1,28 +1,189 @@
+#include <getopt.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "mcc/ast.h"
 #include "mcc/ast_print.h"
+#include "mcc/ast_stats.h"
 #include "mcc/parser.h"
 
-int main(void)
+enum {
+	OPTION_FORMAT = 256,
+	OPTION_STATS,
+};
+
+static void print_usage(const char *prg)
+{
+	printf("usage: %s [OPTIONS] <file>\n\n", prg);
+	printf("Utility for printing an abstract syntax tree in the DOT format. The output\n");
+	printf("can be visualised using Graphviz. Errors are reported on invalid inputs.\n\n");
+	printf("Use '-' as input file to read from stdin.\n\n");
+	printf("OPTIONS:\n");
+	printf("  -h, --help                display this help message\n");
+	printf("  -o, --output <out-file>   write the output to <out-file> (defaults to stdout)\n");
+	printf("  -f, --function <name>     print the AST of the given function\n");
+	printf("  -d, --depth <depth>       replace nodes deeper than <depth> by a placeholder\n");
+	printf("      --format <format>     output format: dot (default), json, or sexpr\n");
+	printf("      --stats               print AST and front-end statistics to stderr\n");
+}
+
+static bool parse_format(const char *s, enum mcc_ast_print_format *format)
 {
-	struct mcc_ast_expression *expr = NULL;
+	if (strcmp(s, "dot") == 0) {
+		*format = MCC_AST_PRINT_FORMAT_DOT;
+	} else if (strcmp(s, "json") == 0) {
+		*format = MCC_AST_PRINT_FORMAT_JSON;
+	} else if (strcmp(s, "sexpr") == 0) {
+		*format = MCC_AST_PRINT_FORMAT_SEXPR;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+static bool parse_depth(const char *s, unsigned *depth)
+{
+	char *end;
+	unsigned long value = strtoul(s, &end, 10);
+	if (*s == '\0' || *s == '-' || *end != '\0' || value == 0 || value > 100000) {
+		return false;
+	}
+	*depth = (unsigned)value;
+	return true;
+}
+
+static struct mcc_ast_function *find_function(struct mcc_ast_program *program, const char *name)
+{
+	for (size_t i = 0; i < program->functions_count; i++) {
+		if (strcmp(program->functions[i]->identifier->name, name) == 0) {
+			return program->functions[i];
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+	    {"help", no_argument, NULL, 'h'},
+	    {"output", required_argument, NULL, 'o'},
+	    {"function", required_argument, NULL, 'f'},
+	    {"depth", required_argument, NULL, 'd'},
+	    {"format", required_argument, NULL, OPTION_FORMAT},
+	    {"stats", no_argument, NULL, OPTION_STATS},
+	    {NULL, 0, NULL, 0},
+	};
+
+	const char *output = NULL;
+	const char *function_name = NULL;
+	struct mcc_ast_print_options print_options = {.format = MCC_AST_PRINT_FORMAT_DOT};
+	bool stats = false;
+
+	int c;
+	while ((c = getopt_long(argc, argv, "ho:f:d:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'h':
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		case 'o':
+			output = optarg;
+			break;
+		case 'f':
+			function_name = optarg;
+			break;
+		case 'd':
+			if (!parse_depth(optarg, &print_options.max_depth)) {
+				fprintf(stderr, "invalid depth: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case OPTION_FORMAT:
+			if (!parse_format(optarg, &print_options.format)) {
+				fprintf(stderr, "unknown format: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case OPTION_STATS:
+			stats = true;
+			break;
+		default:
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// determine input source
+	FILE *in;
+	const char *filepath = argv[optind];
+	if (strcmp("-", filepath) == 0) {
+		in = stdin;
+		filepath = "<stdin>";
+	} else {
+		in = fopen(filepath, "r");
+		if (!in) {
+			perror("fopen");
+			return EXIT_FAILURE;
+		}
+	}
+
+	struct mcc_ast_program *program = NULL;
 
 	// parsing phase
 	{
-		struct mcc_parser_result result = mcc_parse_file(stdin, "<stdin>");
+		struct mcc_parser_result result = mcc_parse_file(in, filepath);
+		fclose(in);
 		if (result.error) {
 			mcc_parser_result_print_error(stderr, &result);
 			return EXIT_FAILURE;
 		}
-		expr = result.expression;
+		program = result.program;
+
+		if (stats) {
+			struct mcc_ast_stats ast_stats;
+			mcc_ast_stats_collect(&ast_stats, program, &result.lexer_stats);
+			mcc_ast_stats_print(stderr, &ast_stats);
+		}
+	}
+
+	struct mcc_ast_function *function = NULL;
+	if (function_name) {
+		function = find_function(program, function_name);
+		if (!function) {
+			fprintf(stderr, "unknown function: %s\n", function_name);
+			mcc_ast_delete_program(program);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE *out = stdout;
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			perror("fopen");
+			mcc_ast_delete_program(program);
+			return EXIT_FAILURE;
+		}
 	}
 
-	mcc_ast_print_dot_expression(stdout, expr);
+	bool ok = function ? mcc_ast_print_function(out, function, &print_options)
+	                   : mcc_ast_print_program(out, program, &print_options);
+	if (!ok) {
+		perror("write");
+	}
 
 	// cleanup
-	mcc_ast_delete_expression(expr);
+	if (out != stdout && fclose(out) != 0) {
+		perror("fclose");
+		ok = false;
+	}
+	mcc_ast_delete_program(program);
 
-	return EXIT_SUCCESS;
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,181 @@
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mcc/ast.h"
+#include "mcc/cfg.h"
+#include "mcc/parser.h"
+#include "mcc/semantic.h"
+#include "mcc/ssa.h"
+#include "mcc/tac.h"
+#include "mcc/tac_binary.h"
+#include "mcc/tac_lower.h"
+
+static void print_usage(const char *prg)
+{
+	printf("usage: %s [OPTIONS] <file>\n\n", prg);
+	printf("Utility for viewing the generated intermediate representation. Errors are\n");
+	printf("reported on invalid inputs.\n\n");
+	printf("Use '-' as input file to read from stdin.\n\n");
+	printf("OPTIONS:\n");
+	printf("  -h, --help                display this help message\n");
+	printf("  -o, --output <out-file>   write the output to <out-file> (defaults to stdout)\n");
+	printf("  -f, --function <name>     print the IR of the given function\n");
+	printf("  -s, --ssa                 print the IR in SSA form\n");
+	printf("  -b, --binary              write the IR and control flow graphs in binary form\n");
+}
+
+static bool write_binary(FILE *out, const struct mcc_tac_function *functions, size_t count)
+{
+	struct mcc_cfg *cfgs = calloc(count ? count : 1, sizeof(*cfgs));
+	bool ok = cfgs != NULL;
+	for (size_t i = 0; ok && i < count; i++) {
+		ok = mcc_cfg_build(&cfgs[i], &functions[i]);
+	}
+	ok = ok && mcc_tac_binary_write(out, functions, count, cfgs);
+
+	for (size_t i = 0; cfgs && i < count; i++) {
+		mcc_cfg_deinit(&cfgs[i]);
+	}
+	free(cfgs);
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+	    {"help", no_argument, NULL, 'h'},
+	    {"output", required_argument, NULL, 'o'},
+	    {"function", required_argument, NULL, 'f'},
+	    {"ssa", no_argument, NULL, 's'},
+	    {"binary", no_argument, NULL, 'b'},
+	    {NULL, 0, NULL, 0},
+	};
+
+	const char *output = NULL;
+	const char *function_name = NULL;
+	bool ssa = false;
+	bool binary = false;
+
+	int c;
+	while ((c = getopt_long(argc, argv, "ho:f:sb", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'h':
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		case 'o':
+			output = optarg;
+			break;
+		case 'f':
+			function_name = optarg;
+			break;
+		case 's':
+			ssa = true;
+			break;
+		case 'b':
+			binary = true;
+			break;
+		default:
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// determine input source
+	FILE *in;
+	const char *filepath = argv[optind];
+	if (strcmp("-", filepath) == 0) {
+		in = stdin;
+		filepath = "<stdin>";
+	} else {
+		in = fopen(filepath, "r");
+		if (!in) {
+			perror("fopen");
+			return EXIT_FAILURE;
+		}
+	}
+
+	struct mcc_ast_program *program = NULL;
+
+	// parsing phase
+	{
+		struct mcc_parser_result result = mcc_parse_file(in, filepath);
+		fclose(in);
+		if (result.error) {
+			mcc_parser_result_print_error(stderr, &result);
+			return EXIT_FAILURE;
+		}
+		program = result.program;
+	}
+
+	// semantic checks
+	{
+		struct mcc_semantic_result result = mcc_semantic_check(program, NULL);
+		if (result.error) {
+			mcc_semantic_result_print_errors(stderr, &result, filepath);
+			mcc_semantic_result_deinit(&result);
+			mcc_ast_delete_program(program);
+			return EXIT_FAILURE;
+		}
+		mcc_semantic_result_deinit(&result);
+	}
+
+	// lowering
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	bool ok = mcc_tac_lower_program(&tac, program, NULL);
+	mcc_ast_delete_program(program);
+	for (size_t i = 0; ok && ssa && i < tac.functions_count; i++) {
+		ok = mcc_ssa_construct(&tac.functions[i]);
+	}
+	if (!ok) {
+		fprintf(stderr, "out of memory\n");
+		mcc_tac_program_deinit(&tac);
+		return EXIT_FAILURE;
+	}
+
+	const struct mcc_tac_function *function = NULL;
+	if (function_name) {
+		function = mcc_tac_program_find_function(&tac, function_name);
+		if (!function) {
+			fprintf(stderr, "unknown function: %s\n", function_name);
+			mcc_tac_program_deinit(&tac);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE *out = stdout;
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			perror("fopen");
+			mcc_tac_program_deinit(&tac);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (binary) {
+		ok = write_binary(out, function ? function : tac.functions, function ? 1 : tac.functions_count);
+	} else {
+		ok = function ? mcc_tac_print_function(out, function) : mcc_tac_print_program(out, &tac);
+	}
+	if (!ok) {
+		perror("write");
+	}
+
+	// cleanup
+	if (out != stdout && fclose(out) != 0) {
+		perror("fclose");
+		ok = false;
+	}
+	mcc_tac_program_deinit(&tac);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,294 @@
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mcc/pass.h"
+#include "mcc/tac.h"
+#include "mcc/tac_binary.h"
+#include "mcc/tac_parser.h"
+
+#define MAX_PASSES 64
+
+static void print_usage(const char *prg)
+{
+	printf("usage: %s [OPTIONS] <file>\n\n", prg);
+	printf("Runs optimisation passes on TAC, read in textual or binary form, and prints\n");
+	printf("the result. The time taken and the change in instructions of each pass are\n");
+	printf("reported on stderr.\n\n");
+	printf("Use '-' as input file to read from stdin.\n\n");
+	printf("OPTIONS:\n");
+	printf("  -h, --help                display this help message\n");
+	printf("  -o, --output <out-file>   write the output to <out-file> (defaults to stdout)\n");
+	printf("  -p, --passes <list>       run the comma-separated passes in order, also -passes=<list>\n");
+	printf("  -l, --list-passes         list the available passes\n");
+	printf("  -b, --binary              write the IR in binary form\n");
+	printf("  -r, --repeat <n>          run the pipeline <n> times, reporting the mean time\n");
+	printf("  -q, --quiet               do not report pass statistics\n");
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static size_t count_instructions(const struct mcc_tac_program *program)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < program->functions_count; i++) {
+		count += program->functions[i].instructions_count - program->functions[i].removed_count;
+	}
+	return count;
+}
+
+// Splits `list` at commas. Returns false on unknown passes.
+static bool parse_pipeline(const char *list, const struct mcc_pass **passes, size_t *count)
+{
+	*count = 0;
+	while (*list) {
+		size_t length = strcspn(list, ",");
+		const struct mcc_pass *pass = mcc_pass_find(list, length);
+		if (!pass) {
+			fprintf(stderr, "unknown pass: %.*s\n", (int)length, list);
+			return false;
+		}
+		if (*count == MAX_PASSES) {
+			fprintf(stderr, "too many passes\n");
+			return false;
+		}
+		passes[(*count)++] = pass;
+
+		list += length;
+		if (*list == ',') {
+			list++;
+		}
+	}
+	return true;
+}
+
+static bool read_input(FILE *in, char **data, size_t *size)
+{
+	size_t capacity = 4096;
+	*size = 0;
+	*data = malloc(capacity);
+	while (*data) {
+		*size += fread(*data + *size, 1, capacity - *size, in);
+		if (*size < capacity) {
+			return !ferror(in);
+		}
+
+		char *grown = realloc(*data, capacity * 2);
+		if (!grown) {
+			free(*data);
+			*data = NULL;
+		} else {
+			*data = grown;
+			capacity *= 2;
+		}
+	}
+	return false;
+}
+
+// Decodes `data` into `program`, which has to be initialised.
+static bool load(struct mcc_tac_program *program, char *data, size_t size, const char *filepath)
+{
+	if (mcc_tac_binary_is_image(data, size)) {
+		if (!mcc_tac_binary_read(program, NULL, data, size)) {
+			fprintf(stderr, "%s: invalid or incompatible binary IR\n", filepath);
+			return false;
+		}
+		return true;
+	}
+
+	if (size == 0) {
+		return true;
+	}
+
+	FILE *in = fmemopen(data, size, "r");
+	if (!in) {
+		perror("fmemopen");
+		return false;
+	}
+	struct mcc_tac_parser_result result = mcc_tac_parse_file(program, in, filepath);
+	fclose(in);
+	if (result.error) {
+		mcc_tac_parser_result_print_error(stderr, &result);
+		return false;
+	}
+	return true;
+}
+
+struct pass_stats {
+	double time;
+	size_t before;
+	size_t after;
+};
+
+static void print_row(const char *name, double time, size_t before, size_t after)
+{
+	fprintf(stderr, "%-20s %12.3f   %zu -> %zu (%+ld)\n", name, time * 1e3, before, after,
+	        (long)after - (long)before);
+}
+
+static void print_stats(const struct mcc_pass **passes, const struct pass_stats *stats, size_t count, size_t repeat)
+{
+	fprintf(stderr, "%-20s %12s   %s\n", "pass", "time (ms)", "instructions");
+
+	double total = 0;
+	for (size_t i = 0; i < count; i++) {
+		print_row(passes[i]->name, stats[i].time / (double)repeat, stats[i].before, stats[i].after);
+		total += stats[i].time / (double)repeat;
+	}
+	if (count > 0) {
+		print_row("total", total, stats[0].before, stats[count - 1].after);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+	    {"help", no_argument, NULL, 'h'},
+	    {"output", required_argument, NULL, 'o'},
+	    {"passes", required_argument, NULL, 'p'},
+	    {"list-passes", no_argument, NULL, 'l'},
+	    {"binary", no_argument, NULL, 'b'},
+	    {"repeat", required_argument, NULL, 'r'},
+	    {"quiet", no_argument, NULL, 'q'},
+	    {NULL, 0, NULL, 0},
+	};
+
+	const char *output = NULL;
+	const struct mcc_pass *passes[MAX_PASSES];
+	size_t passes_count = 0;
+	bool binary = false;
+	bool quiet = false;
+	long repeat = 1;
+
+	// Long options may be given with a single dash, like `-passes=dce`.
+	int c;
+	while ((c = getopt_long_only(argc, argv, "ho:p:lbr:q", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'h':
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		case 'o':
+			output = optarg;
+			break;
+		case 'p':
+			if (!parse_pipeline(optarg, passes, &passes_count)) {
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'l':
+			for (size_t i = 0; i < mcc_passes_count; i++) {
+				printf("  %-22s  %s\n", mcc_passes[i].name, mcc_passes[i].description);
+			}
+			return EXIT_SUCCESS;
+		case 'b':
+			binary = true;
+			break;
+		case 'r':
+			repeat = strtol(optarg, NULL, 10);
+			if (repeat < 1) {
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'q':
+			quiet = true;
+			break;
+		default:
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// determine input source
+	FILE *in;
+	const char *filepath = argv[optind];
+	if (strcmp("-", filepath) == 0) {
+		in = stdin;
+		filepath = "<stdin>";
+	} else {
+		in = fopen(filepath, "r");
+		if (!in) {
+			perror("fopen");
+			return EXIT_FAILURE;
+		}
+	}
+
+	char *data;
+	size_t size;
+	bool ok = read_input(in, &data, &size);
+	if (in != stdin) {
+		fclose(in);
+	}
+	if (!ok) {
+		perror("read");
+		return EXIT_FAILURE;
+	}
+
+	// Each repetition starts over from the input, the last result is kept.
+	struct pass_stats stats[MAX_PASSES] = {0};
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	for (long r = 0; ok && r < repeat; r++) {
+		mcc_tac_program_deinit(&tac);
+		mcc_tac_program_init(&tac);
+		ok = load(&tac, data, size, filepath);
+
+		for (size_t i = 0; ok && i < passes_count; i++) {
+			stats[i].before = count_instructions(&tac);
+			double start = now();
+			ok = mcc_pass_run(passes[i], &tac);
+			stats[i].time += now() - start;
+			stats[i].after = count_instructions(&tac);
+			if (!ok) {
+				fprintf(stderr, "%s: out of memory\n", passes[i]->name);
+			}
+		}
+	}
+	free(data);
+	if (!ok) {
+		mcc_tac_program_deinit(&tac);
+		return EXIT_FAILURE;
+	}
+
+	if (!quiet) {
+		print_stats(passes, stats, passes_count, (size_t)repeat);
+	}
+
+	FILE *out = stdout;
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			perror("fopen");
+			mcc_tac_program_deinit(&tac);
+			return EXIT_FAILURE;
+		}
+	}
+
+	ok = binary ? mcc_tac_binary_write(out, tac.functions, tac.functions_count, NULL)
+	            : mcc_tac_print_program(out, &tac);
+	if (!ok) {
+		perror("write");
+	}
+
+	// cleanup
+	if (out != stdout && fclose(out) != 0) {
+		perror("fclose");
+		ok = false;
+	}
+	mcc_tac_program_deinit(&tac);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,56 +1,251 @@
+#include <getopt.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "mcc/ast.h"
+#include "mcc/ast_stats.h"
+#include "mcc/jit.h"
 #include "mcc/parser.h"
+#include "mcc/pass.h"
+#include "mcc/semantic.h"
+#include "mcc/tac.h"
+#include "mcc/tac_lower.h"
+#include "mcc/vm.h"
 
-void print_usage(const char *prg)
+enum {
+	OPTION_ALL_ERRORS = 256,
+	OPTION_STATS,
+	OPTION_RUN,
+	OPTION_JIT,
+};
+
+// Passes which can be enabled with -f<name>.
+static const char *const optional_passes[] = {"auto-memoize"};
+
+static void print_usage(const char *prg)
 {
-	printf("usage: %s <FILE>\n\n", prg);
-	printf("  <FILE>        Input filepath or - for stdin\n");
+	printf("usage: %s [OPTIONS] <file>\n\n", prg);
+	printf("The mC compiler. It takes an mC input file and produces an executable.\n");
+	printf("Errors are reported on invalid inputs.\n\n");
+	printf("Use '-' as input file to read from stdin.\n\n");
+	printf("OPTIONS:\n");
+	printf("  -h, --help                display this help message\n");
+	printf("  -q, --quiet               suppress error output\n");
+	printf("  -j, --jobs <n>            check and lower functions using <n> threads\n");
+	printf("  -O, --optimize            run the default optimisation passes on the IR\n");
+	printf("  -f<pass>                  run an optional pass on the IR, after the default ones:\n");
+	printf("                              -fauto-memoize   cache results of recursive pure functions\n");
+	printf("      --all-errors          report all semantic errors instead of the first one\n");
+	printf("      --stats               print AST and front-end statistics to stderr\n");
+	printf("      --run                 execute the program in the bytecode VM instead of compiling it,\n");
+	printf("                            exiting with the value returned by main\n");
+	printf("      --jit                 like --run, but compile the program to x86-64 machine code in memory\n");
 }
 
 int main(int argc, char *argv[])
 {
-	if (argc < 2) {
+	static const struct option long_options[] = {
+	    {"help", no_argument, NULL, 'h'},
+	    {"quiet", no_argument, NULL, 'q'},
+	    {"jobs", required_argument, NULL, 'j'},
+	    {"optimize", no_argument, NULL, 'O'},
+	    {"all-errors", no_argument, NULL, OPTION_ALL_ERRORS},
+	    {"stats", no_argument, NULL, OPTION_STATS},
+	    {"run", no_argument, NULL, OPTION_RUN},
+	    {"jit", no_argument, NULL, OPTION_JIT},
+	    {NULL, 0, NULL, 0},
+	};
+
+	bool quiet = false;
+	struct mcc_semantic_options semantic_options = {0};
+	bool stats = false;
+	bool optimize = false;
+	const struct mcc_pass *extra_passes[8];
+	size_t extra_passes_count = 0;
+	bool run = false;
+	bool jit = false;
+
+	int c;
+	while ((c = getopt_long(argc, argv, "hqj:Of:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'h':
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		case 'q':
+			quiet = true;
+			break;
+		case 'j': {
+			char *end;
+			long jobs = strtol(optarg, &end, 10);
+			if (*optarg == '\0' || *end != '\0' || jobs < 1) {
+				fprintf(stderr, "invalid number of jobs '%s'\n", optarg);
+				return EXIT_FAILURE;
+			}
+			semantic_options.threads = (size_t)jobs;
+			break;
+		}
+		case 'O':
+			optimize = true;
+			break;
+		case 'f': {
+			const struct mcc_pass *pass = NULL;
+			for (size_t i = 0; i < sizeof(optional_passes) / sizeof(*optional_passes); i++) {
+				if (strcmp(optarg, optional_passes[i]) == 0) {
+					pass = mcc_pass_find(optarg, strlen(optarg));
+				}
+			}
+			if (!pass || extra_passes_count == sizeof(extra_passes) / sizeof(*extra_passes)) {
+				fprintf(stderr, "invalid option '-f%s'\n", optarg);
+				return EXIT_FAILURE;
+			}
+			extra_passes[extra_passes_count++] = pass;
+			break;
+		}
+		case OPTION_ALL_ERRORS:
+			semantic_options.collect_all = true;
+			break;
+		case OPTION_STATS:
+			stats = true;
+			break;
+		case OPTION_RUN:
+			run = true;
+			break;
+		case OPTION_JIT:
+			jit = true;
+			break;
+		default:
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
 		print_usage(argv[0]);
 		return EXIT_FAILURE;
 	}
 
 	// determine input source
 	FILE *in;
-	if (strcmp("-", argv[1]) == 0) {
+	const char *filepath = argv[optind];
+	if (strcmp("-", filepath) == 0) {
 		in = stdin;
+		filepath = "<stdin>";
 	} else {
-		in = fopen(argv[1], "r");
+		in = fopen(filepath, "r");
 		if (!in) {
-			perror("fopen");
+			if (!quiet) {
+				perror("fopen");
+			}
 			return EXIT_FAILURE;
 		}
 	}
 
-	struct mcc_ast_expression *expr = NULL;
+	struct mcc_ast_program *program = NULL;
 
 	// parsing phase
 	{
-		struct mcc_parser_result result = mcc_parse_file(in, in == stdin ? "<stdin>" : NULL);
+		struct mcc_parser_result result = mcc_parse_file(in, filepath);
 		fclose(in);
 		if (result.error) {
-			mcc_parser_result_print_error(stderr, &result);
+			if (!quiet) {
+				mcc_parser_result_print_error(stderr, &result);
+			}
+			return EXIT_FAILURE;
+		}
+		program = result.program;
+
+		if (stats) {
+			struct mcc_ast_stats ast_stats;
+			mcc_ast_stats_collect(&ast_stats, program, &result.lexer_stats);
+			mcc_ast_stats_print(stderr, &ast_stats);
+		}
+	}
+
+	// semantic checks
+	{
+		struct mcc_semantic_result result = mcc_semantic_check(program, &semantic_options);
+		if (result.error) {
+			if (!quiet) {
+				mcc_semantic_result_print_errors(stderr, &result, filepath);
+			}
+			mcc_semantic_result_deinit(&result);
+			mcc_ast_delete_program(program);
 			return EXIT_FAILURE;
 		}
-		expr = result.expression;
+		mcc_semantic_result_deinit(&result);
+	}
+
+	// lowering
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	{
+		struct mcc_tac_lower_options lower_options = {.threads = semantic_options.threads};
+		bool ok = mcc_tac_lower_program(&tac, program, &lower_options);
+		mcc_ast_delete_program(program);
+		if (!ok) {
+			if (!quiet) {
+				fprintf(stderr, "out of memory\n");
+			}
+			mcc_tac_program_deinit(&tac);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// optimisation
+	bool optimized = !optimize || mcc_pass_run_pipeline(mcc_pass_default_pipeline, &tac);
+	for (size_t i = 0; optimized && i < extra_passes_count; i++) {
+		optimized = mcc_pass_run(extra_passes[i], &tac);
+	}
+	if (!optimized) {
+		if (!quiet) {
+			fprintf(stderr, "out of memory\n");
+		}
+		mcc_tac_program_deinit(&tac);
+		return EXIT_FAILURE;
+	}
+
+	// execution
+	int status = EXIT_SUCCESS;
+	if (run) {
+		struct mcc_vm vm;
+		struct mcc_vm_result result = mcc_vm_compile(&vm, &tac);
+		if (!result.error) {
+			result = mcc_vm_call(&vm, "main", NULL, 0, NULL);
+		}
+		if (result.error) {
+			if (!quiet) {
+				mcc_vm_result_print_error(stderr, &result);
+			}
+			status = EXIT_FAILURE;
+		} else {
+			status = result.value.i;
+		}
+		mcc_vm_deinit(&vm);
+	} else if (jit) {
+		struct mcc_jit compiled;
+		struct mcc_jit_result result = mcc_jit_compile(&compiled, &tac);
+		if (!result.error) {
+			result = mcc_jit_call(&compiled, "main", NULL, 0, NULL);
+		}
+		if (result.error) {
+			if (!quiet) {
+				mcc_jit_result_print_error(stderr, &result);
+			}
+			status = EXIT_FAILURE;
+		} else {
+			status = result.value.i;
+		}
+		mcc_jit_deinit(&compiled);
 	}
 
 	// TODO:
-	// - run semantic checks
-	// - create three-address code
 	// - output assembly code
 	// - invoke backend compiler
 
 	// cleanup
-	mcc_ast_delete_expression(expr);
+	mcc_tac_program_deinit(&tac);
 
-	return EXIT_SUCCESS;
+	return status;
 }
@@ -7,17 +7,29 @@
 // member `mmc_ast_node` which serves as a *base-class*. It holds data
 // independent from the actual node type, like the source location.
 //
+// Identifiers and string literals are interned in the program's string pool;
+// they can be compared by pointer.
+//
 // Also note that this makes excessive use of C11's *anonymous structs and
 // unions* feature.
 
 #ifndef MCC_AST_H
 #define MCC_AST_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "mcc/sloc.h"
+#include "mcc/string_pool.h"
+#include "mcc/type.h"
 
 // Forward Declarations
 struct mcc_ast_expression;
 struct mcc_ast_literal;
+struct mcc_ast_identifier;
+struct mcc_ast_statement;
+struct mcc_ast_declaration;
+struct mcc_ast_function;
 
 // ------------------------------------------------------------------- AST Node
 
@@ -27,24 +39,71 @@ struct mcc_ast_node {
 
 // ------------------------------------------------------------------ Operators
 
+enum mcc_ast_unary_op {
+	MCC_AST_UNARY_OP_NEG,
+	MCC_AST_UNARY_OP_NOT,
+};
+
 enum mcc_ast_binary_op {
 	MCC_AST_BINARY_OP_ADD,
 	MCC_AST_BINARY_OP_SUB,
 	MCC_AST_BINARY_OP_MUL,
 	MCC_AST_BINARY_OP_DIV,
+	MCC_AST_BINARY_OP_LT,
+	MCC_AST_BINARY_OP_GT,
+	MCC_AST_BINARY_OP_LE,
+	MCC_AST_BINARY_OP_GE,
+	MCC_AST_BINARY_OP_AND,
+	MCC_AST_BINARY_OP_OR,
+	MCC_AST_BINARY_OP_EQ,
+	MCC_AST_BINARY_OP_NE,
+};
+
+// ----------------------------------------------------------------- Data Types
+
+enum mcc_ast_data_type {
+	MCC_AST_DATA_TYPE_VOID,
+	MCC_AST_DATA_TYPE_BOOL,
+	MCC_AST_DATA_TYPE_INT,
+	MCC_AST_DATA_TYPE_FLOAT,
+	MCC_AST_DATA_TYPE_STRING,
 };
 
+// ---------------------------------------------------------------- Identifiers
+
+struct mcc_ast_identifier {
+	struct mcc_ast_node node;
+
+	const char *name;
+
+	// Resolved by semantic analysis: `declaration` for variables,
+	// `function` for function names.
+	struct mcc_ast_declaration *declaration;
+	struct mcc_ast_function *function;
+};
+
+struct mcc_ast_identifier *mcc_ast_new_identifier(const char *name);
+
+void mcc_ast_delete_identifier(struct mcc_ast_identifier *identifier);
+
 // ---------------------------------------------------------------- Expressions
 
 enum mcc_ast_expression_type {
 	MCC_AST_EXPRESSION_TYPE_LITERAL,
 	MCC_AST_EXPRESSION_TYPE_BINARY_OP,
 	MCC_AST_EXPRESSION_TYPE_PARENTH,
+	MCC_AST_EXPRESSION_TYPE_UNARY_OP,
+	MCC_AST_EXPRESSION_TYPE_IDENTIFIER,
+	MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT,
+	MCC_AST_EXPRESSION_TYPE_CALL,
 };
 
 struct mcc_ast_expression {
 	struct mcc_ast_node node;
 
+	// Computed by semantic analysis, interned in the program's type pool.
+	const struct mcc_type *data_type;
+
 	enum mcc_ast_expression_type type;
 	union {
 		// MCC_AST_EXPRESSION_TYPE_LITERAL
@@ -59,6 +118,29 @@ struct mcc_ast_expression {
 
 		// MCC_AST_EXPRESSION_TYPE_PARENTH
 		struct mcc_ast_expression *expression;
+
+		// MCC_AST_EXPRESSION_TYPE_UNARY_OP
+		struct {
+			enum mcc_ast_unary_op unary_op;
+			struct mcc_ast_expression *operand;
+		};
+
+		// MCC_AST_EXPRESSION_TYPE_IDENTIFIER
+		struct mcc_ast_identifier *identifier;
+
+		// MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT
+		struct {
+			struct mcc_ast_identifier *array;
+			struct mcc_ast_expression *index;
+		};
+
+		// MCC_AST_EXPRESSION_TYPE_CALL
+		struct {
+			struct mcc_ast_identifier *callee;
+			struct mcc_ast_expression **arguments;
+			size_t arguments_count;
+			size_t arguments_capacity;
+		};
 	};
 };
 
@@ -70,6 +152,21 @@ struct mcc_ast_expression *mcc_ast_new_expression_binary_op(enum mcc_ast_binary_
 
 struct mcc_ast_expression *mcc_ast_new_expression_parenth(struct mcc_ast_expression *expression);
 
+struct mcc_ast_expression *mcc_ast_new_expression_unary_op(enum mcc_ast_unary_op op,
+                                                           struct mcc_ast_expression *operand);
+
+struct mcc_ast_expression *mcc_ast_new_expression_identifier(struct mcc_ast_identifier *identifier);
+
+struct mcc_ast_expression *mcc_ast_new_expression_array_element(struct mcc_ast_identifier *array,
+                                                                struct mcc_ast_expression *index);
+
+// Arguments are added afterwards using `mcc_ast_add_argument`.
+struct mcc_ast_expression *mcc_ast_new_expression_call(struct mcc_ast_identifier *callee);
+
+// Returns false on allocation failure, ownership of `argument` remains with
+// the caller in this case.
+bool mcc_ast_add_argument(struct mcc_ast_expression *call, struct mcc_ast_expression *argument);
+
 void mcc_ast_delete_expression(struct mcc_ast_expression *expression);
 
 // ------------------------------------------------------------------- Literals
@@ -77,6 +174,8 @@ void mcc_ast_delete_expression(struct mcc_ast_expression *expression);
 enum mcc_ast_literal_type {
 	MCC_AST_LITERAL_TYPE_INT,
 	MCC_AST_LITERAL_TYPE_FLOAT,
+	MCC_AST_LITERAL_TYPE_BOOL,
+	MCC_AST_LITERAL_TYPE_STRING,
 };
 
 struct mcc_ast_literal {
@@ -89,6 +188,12 @@ struct mcc_ast_literal {
 
 		// MCC_AST_LITERAL_TYPE_FLOAT
 		double f_value;
+
+		// MCC_AST_LITERAL_TYPE_BOOL
+		bool b_value;
+
+		// MCC_AST_LITERAL_TYPE_STRING
+		const char *s_value;
 	};
 };
 
@@ -96,6 +201,198 @@ struct mcc_ast_literal *mcc_ast_new_literal_int(long value);
 
 struct mcc_ast_literal *mcc_ast_new_literal_float(double value);
 
+struct mcc_ast_literal *mcc_ast_new_literal_bool(bool value);
+
+struct mcc_ast_literal *mcc_ast_new_literal_string(const char *value);
+
 void mcc_ast_delete_literal(struct mcc_ast_literal *literal);
 
+// --------------------------------------------------------------- Declarations
+
+struct mcc_ast_declaration {
+	struct mcc_ast_node node;
+
+	enum mcc_ast_data_type data_type;
+
+	// `array_size` is only meaningful for array declarations.
+	bool is_array;
+	long array_size;
+
+	struct mcc_ast_identifier *identifier;
+
+	// The declared type, computed by semantic analysis.
+	const struct mcc_type *resolved_type;
+};
+
+struct mcc_ast_declaration *mcc_ast_new_declaration(enum mcc_ast_data_type data_type,
+                                                    struct mcc_ast_identifier *identifier);
+
+struct mcc_ast_declaration *mcc_ast_new_declaration_array(enum mcc_ast_data_type data_type,
+                                                          long array_size,
+                                                          struct mcc_ast_identifier *identifier);
+
+void mcc_ast_delete_declaration(struct mcc_ast_declaration *declaration);
+
+// ---------------------------------------------------------------- Assignments
+
+struct mcc_ast_assignment {
+	struct mcc_ast_node node;
+
+	struct mcc_ast_identifier *identifier;
+
+	// Set iff an array element is assigned.
+	struct mcc_ast_expression *index;
+
+	struct mcc_ast_expression *rhs;
+};
+
+// `index` may be NULL.
+struct mcc_ast_assignment *mcc_ast_new_assignment(struct mcc_ast_identifier *identifier,
+                                                  struct mcc_ast_expression *index,
+                                                  struct mcc_ast_expression *rhs);
+
+void mcc_ast_delete_assignment(struct mcc_ast_assignment *assignment);
+
+// ----------------------------------------------------------------- Statements
+
+enum mcc_ast_statement_type {
+	MCC_AST_STATEMENT_TYPE_IF,
+	MCC_AST_STATEMENT_TYPE_WHILE,
+	MCC_AST_STATEMENT_TYPE_RETURN,
+	MCC_AST_STATEMENT_TYPE_DECLARATION,
+	MCC_AST_STATEMENT_TYPE_ASSIGNMENT,
+	MCC_AST_STATEMENT_TYPE_EXPRESSION,
+	MCC_AST_STATEMENT_TYPE_COMPOUND,
+};
+
+struct mcc_ast_statement {
+	struct mcc_ast_node node;
+
+	enum mcc_ast_statement_type type;
+	union {
+		// MCC_AST_STATEMENT_TYPE_IF
+		struct {
+			struct mcc_ast_expression *if_condition;
+			struct mcc_ast_statement *if_on_true;
+
+			// NULL if there is no else branch.
+			struct mcc_ast_statement *if_on_false;
+		};
+
+		// MCC_AST_STATEMENT_TYPE_WHILE
+		struct {
+			struct mcc_ast_expression *while_condition;
+			struct mcc_ast_statement *while_body;
+		};
+
+		// MCC_AST_STATEMENT_TYPE_RETURN
+		// NULL when returning from a void function.
+		struct mcc_ast_expression *return_value;
+
+		// MCC_AST_STATEMENT_TYPE_DECLARATION
+		struct mcc_ast_declaration *declaration;
+
+		// MCC_AST_STATEMENT_TYPE_ASSIGNMENT
+		struct mcc_ast_assignment *assignment;
+
+		// MCC_AST_STATEMENT_TYPE_EXPRESSION
+		struct mcc_ast_expression *expression;
+
+		// MCC_AST_STATEMENT_TYPE_COMPOUND
+		struct {
+			struct mcc_ast_statement **statements;
+			size_t statements_count;
+			size_t statements_capacity;
+		};
+	};
+};
+
+// `on_false` may be NULL.
+struct mcc_ast_statement *mcc_ast_new_statement_if(struct mcc_ast_expression *condition,
+                                                   struct mcc_ast_statement *on_true,
+                                                   struct mcc_ast_statement *on_false);
+
+struct mcc_ast_statement *mcc_ast_new_statement_while(struct mcc_ast_expression *condition,
+                                                      struct mcc_ast_statement *body);
+
+// `value` may be NULL.
+struct mcc_ast_statement *mcc_ast_new_statement_return(struct mcc_ast_expression *value);
+
+struct mcc_ast_statement *mcc_ast_new_statement_declaration(struct mcc_ast_declaration *declaration);
+
+struct mcc_ast_statement *mcc_ast_new_statement_assignment(struct mcc_ast_assignment *assignment);
+
+struct mcc_ast_statement *mcc_ast_new_statement_expression(struct mcc_ast_expression *expression);
+
+// Statements are added afterwards using `mcc_ast_add_statement`.
+struct mcc_ast_statement *mcc_ast_new_statement_compound(void);
+
+// Returns false on allocation failure, ownership of `statement` remains with
+// the caller in this case.
+bool mcc_ast_add_statement(struct mcc_ast_statement *compound, struct mcc_ast_statement *statement);
+
+void mcc_ast_delete_statement(struct mcc_ast_statement *statement);
+
+// ------------------------------------------------------------------ Functions
+
+struct mcc_ast_function {
+	struct mcc_ast_node node;
+
+	enum mcc_ast_data_type return_type;
+	struct mcc_ast_identifier *identifier;
+
+	struct mcc_ast_declaration **parameters;
+	size_t parameters_count;
+	size_t parameters_capacity;
+
+	// A compound statement, NULL until assigned.
+	struct mcc_ast_statement *body;
+};
+
+// Parameters are added afterwards using `mcc_ast_add_parameter`, the body is
+// assigned directly.
+struct mcc_ast_function *mcc_ast_new_function(enum mcc_ast_data_type return_type,
+                                              struct mcc_ast_identifier *identifier);
+
+// Returns false on allocation failure, ownership of `parameter` remains with
+// the caller in this case.
+bool mcc_ast_add_parameter(struct mcc_ast_function *function, struct mcc_ast_declaration *parameter);
+
+void mcc_ast_delete_function(struct mcc_ast_function *function);
+
+// -------------------------------------------------------------------- Program
+
+struct mcc_ast_program {
+	struct mcc_ast_node node;
+
+	struct mcc_ast_function **functions;
+	size_t functions_count;
+	size_t functions_capacity;
+
+	// Declarations of the built-in functions, added by semantic analysis.
+	// Their body is NULL.
+	struct mcc_ast_function **builtins;
+	size_t builtins_count;
+	size_t builtins_capacity;
+
+	// Owns all identifiers and string literals referenced by the program.
+	struct mcc_string_pool strings;
+
+	// Owns the array types referenced by the program.
+	struct mcc_type_pool types;
+};
+
+// Functions are added afterwards using `mcc_ast_add_function`.
+struct mcc_ast_program *mcc_ast_new_program(void);
+
+// Returns false on allocation failure, ownership of `function` remains with
+// the caller in this case.
+bool mcc_ast_add_function(struct mcc_ast_program *program, struct mcc_ast_function *function);
+
+// Same as `mcc_ast_add_function`, for built-in function declarations.
+bool mcc_ast_add_builtin(struct mcc_ast_program *program, struct mcc_ast_function *function);
+
+// Also releases the program's string and type pools.
+void mcc_ast_delete_program(struct mcc_ast_program *program);
+
 #endif // MCC_AST_H
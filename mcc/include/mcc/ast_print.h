@@ -1,21 +1,65 @@
 // AST Print Infrastructure
 //
 // This module provides basic printing infrastructure for the AST data
-// structure. The DOT printer enables easy visualisation of an AST.
+// structure. The DOT printer enables easy visualisation of an AST, the JSON
+// and S-expression printers target tooling.
+//
+// Nodes are numbered sequentially in pre-order, hence the output for a given
+// input is stable and can be diffed.
 
 #ifndef MCC_AST_PRINT_H
 #define MCC_AST_PRINT_H
 
+#include <stdbool.h>
 #include <stdio.h>
 
 #include "mcc/ast.h"
 
+const char *mcc_ast_print_unary_op(enum mcc_ast_unary_op op);
+
 const char *mcc_ast_print_binary_op(enum mcc_ast_binary_op op);
 
-// ---------------------------------------------------------------- DOT Printer
+const char *mcc_ast_print_data_type(enum mcc_ast_data_type type);
+
+// -------------------------------------------------------------------- Printer
+
+enum mcc_ast_print_format {
+	// Graphviz DOT, one node statement and one edge statement per node.
+	MCC_AST_PRINT_FORMAT_DOT,
+
+	// Compact JSON, each node is an object holding `id`, `edge` (except for the
+	// root), `kind`, `label` (if any), and `children` (if any).
+	MCC_AST_PRINT_FORMAT_JSON,
+
+	// Compact S-expressions, `(kind "label" :edge child ...)`.
+	MCC_AST_PRINT_FORMAT_SEXPR,
+};
+
+struct mcc_ast_print_options {
+	enum mcc_ast_print_format format;
+
+	// Nodes deeper than this are replaced by a `...` placeholder, the root is
+	// at depth 0. Set to 0 to disable the limit.
+	unsigned max_depth;
+};
+
+// The following functions return false on write errors. `options` may be NULL
+// to print DOT without depth limit.
+
+bool mcc_ast_print_program(FILE *out, struct mcc_ast_program *program, const struct mcc_ast_print_options *options);
+
+bool mcc_ast_print_function(FILE *out,
+                            struct mcc_ast_function *function,
+                            const struct mcc_ast_print_options *options);
+
+bool mcc_ast_print_statement(FILE *out,
+                             struct mcc_ast_statement *statement,
+                             const struct mcc_ast_print_options *options);
 
-void mcc_ast_print_dot_expression(FILE *out, struct mcc_ast_expression *expression);
+bool mcc_ast_print_expression(FILE *out,
+                              struct mcc_ast_expression *expression,
+                              const struct mcc_ast_print_options *options);
 
-void mcc_ast_print_dot_literal(FILE *out, struct mcc_ast_literal *literal);
+bool mcc_ast_print_literal(FILE *out, struct mcc_ast_literal *literal, const struct mcc_ast_print_options *options);
 
 #endif // MCC_AST_PRINT_H
@@ -0,0 +1,64 @@
+// AST Statistics
+//
+// Collects node counts and memory usage of a parsed program, broken down by
+// node kind. Together with the lexer's statistics this gives an overview of
+// the front-end's memory footprint.
+//
+// Bytes are computed from the sizes of the allocated structs and the
+// capacities of child arrays; allocator overhead is not included. The number
+// of allocation calls is exact.
+
+#ifndef MCC_AST_STATS_H
+#define MCC_AST_STATS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "mcc/ast.h"
+#include "mcc/lexer.h"
+
+enum mcc_ast_stats_kind {
+	MCC_AST_STATS_KIND_PROGRAM,
+	MCC_AST_STATS_KIND_FUNCTION,
+	MCC_AST_STATS_KIND_DECLARATION,
+	MCC_AST_STATS_KIND_ASSIGNMENT,
+	MCC_AST_STATS_KIND_STATEMENT,
+	MCC_AST_STATS_KIND_EXPRESSION,
+	MCC_AST_STATS_KIND_LITERAL,
+	MCC_AST_STATS_KIND_IDENTIFIER,
+
+	// Child arrays of calls, compound statements, functions, and programs.
+	MCC_AST_STATS_KIND_ARRAY,
+
+	MCC_AST_STATS_KIND_COUNT,
+};
+
+struct mcc_ast_stats_entry {
+	size_t count;
+	size_t bytes;
+	size_t allocations;
+};
+
+struct mcc_ast_stats {
+	struct mcc_ast_stats_entry kinds[MCC_AST_STATS_KIND_COUNT];
+
+	// Interned identifiers and string literals, including the pool's table.
+	struct mcc_ast_stats_entry strings;
+
+	struct mcc_lexer_stats lexer;
+
+	// Sums over all kinds and strings.
+	size_t total_bytes;
+	size_t total_allocations;
+};
+
+// `lexer_stats` may be NULL, leaving the lexer's statistics zeroed.
+void mcc_ast_stats_collect(struct mcc_ast_stats *stats,
+                           struct mcc_ast_program *program,
+                           const struct mcc_lexer_stats *lexer_stats);
+
+const char *mcc_ast_stats_kind_to_string(enum mcc_ast_stats_kind kind);
+
+void mcc_ast_stats_print(FILE *out, const struct mcc_ast_stats *stats);
+
+#endif // MCC_AST_STATS_H
@@ -22,8 +22,14 @@ enum mcc_ast_visit_order {
 };
 
 // Callbacks
+typedef void (*mcc_ast_visit_identifier_cb)(struct mcc_ast_identifier *, void *userdata);
 typedef void (*mcc_ast_visit_expression_cb)(struct mcc_ast_expression *, void *userdata);
 typedef void (*mcc_ast_visit_literal_cb)(struct mcc_ast_literal *, void *userdata);
+typedef void (*mcc_ast_visit_declaration_cb)(struct mcc_ast_declaration *, void *userdata);
+typedef void (*mcc_ast_visit_assignment_cb)(struct mcc_ast_assignment *, void *userdata);
+typedef void (*mcc_ast_visit_statement_cb)(struct mcc_ast_statement *, void *userdata);
+typedef void (*mcc_ast_visit_function_cb)(struct mcc_ast_function *, void *userdata);
+typedef void (*mcc_ast_visit_program_cb)(struct mcc_ast_program *, void *userdata);
 
 struct mcc_ast_visitor {
 	enum mcc_ast_visit_traversal traversal;
@@ -33,18 +39,53 @@ struct mcc_ast_visitor {
 	// node. Use it to share data while traversing the tree.
 	void *userdata;
 
+	mcc_ast_visit_identifier_cb identifier;
+
 	mcc_ast_visit_expression_cb expression;
 	mcc_ast_visit_expression_cb expression_literal;
 	mcc_ast_visit_expression_cb expression_binary_op;
 	mcc_ast_visit_expression_cb expression_parenth;
+	mcc_ast_visit_expression_cb expression_unary_op;
+	mcc_ast_visit_expression_cb expression_identifier;
+	mcc_ast_visit_expression_cb expression_array_element;
+	mcc_ast_visit_expression_cb expression_call;
 
 	mcc_ast_visit_literal_cb literal;
 	mcc_ast_visit_literal_cb literal_int;
 	mcc_ast_visit_literal_cb literal_float;
+	mcc_ast_visit_literal_cb literal_bool;
+	mcc_ast_visit_literal_cb literal_string;
+
+	mcc_ast_visit_declaration_cb declaration;
+	mcc_ast_visit_assignment_cb assignment;
+
+	mcc_ast_visit_statement_cb statement;
+	mcc_ast_visit_statement_cb statement_if;
+	mcc_ast_visit_statement_cb statement_while;
+	mcc_ast_visit_statement_cb statement_return;
+	mcc_ast_visit_statement_cb statement_declaration;
+	mcc_ast_visit_statement_cb statement_assignment;
+	mcc_ast_visit_statement_cb statement_expression;
+	mcc_ast_visit_statement_cb statement_compound;
+
+	mcc_ast_visit_function_cb function;
+	mcc_ast_visit_program_cb program;
 };
 
+void mcc_ast_visit_identifier(struct mcc_ast_identifier *identifier, struct mcc_ast_visitor *visitor);
+
 void mcc_ast_visit_expression(struct mcc_ast_expression *expression, struct mcc_ast_visitor *visitor);
 
 void mcc_ast_visit_literal(struct mcc_ast_literal *literal, struct mcc_ast_visitor *visitor);
 
+void mcc_ast_visit_declaration(struct mcc_ast_declaration *declaration, struct mcc_ast_visitor *visitor);
+
+void mcc_ast_visit_assignment(struct mcc_ast_assignment *assignment, struct mcc_ast_visitor *visitor);
+
+void mcc_ast_visit_statement(struct mcc_ast_statement *statement, struct mcc_ast_visitor *visitor);
+
+void mcc_ast_visit_function(struct mcc_ast_function *function, struct mcc_ast_visitor *visitor);
+
+void mcc_ast_visit_program(struct mcc_ast_program *program, struct mcc_ast_visitor *visitor);
+
 #endif // MCC_AST_VISIT_H
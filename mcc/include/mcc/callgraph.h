@@ -0,0 +1,60 @@
+// Call Graph
+//
+// Records which functions of a program call which, one edge per call
+// instruction. Calls of builtins, and of any other name the program does not
+// define, are not part of the graph.
+//
+// Mutually recursive functions form a strongly connected component of the
+// graph, found by Tarjan's algorithm. Components are numbered bottom-up: a
+// function only calls functions of its own component or of components with a
+// lower number, so walking `order` visits callees before their callers,
+// recursion aside. A function is recursive if its component has more than one
+// function, or if it calls itself.
+
+#ifndef MCC_CALLGRAPH_H
+#define MCC_CALLGRAPH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcc/tac.h"
+
+struct mcc_callgraph {
+	size_t functions_count;
+
+	// The callees of function `f` are the entries of `callees` from
+	// `callees_begin[f]` up to, but excluding, `callees_begin[f + 1]`, once
+	// per call in instruction order.
+	size_t *callees_begin;
+	uint32_t *callees;
+
+	// Component of each function, indexed by function.
+	uint32_t *components;
+	size_t components_count;
+
+	// All functions, ordered by component.
+	uint32_t *order;
+
+	// Whether each function is recursive, indexed by function.
+	bool *recursive;
+};
+
+// Builds the call graph of `program`, which must not gain or lose functions
+// while the graph is in use. Returns false on allocation failure, `graph`
+// must be deinitialised anyway.
+bool mcc_callgraph_build(struct mcc_callgraph *graph, const struct mcc_tac_program *program);
+
+void mcc_callgraph_deinit(struct mcc_callgraph *graph);
+
+static inline const uint32_t *mcc_callgraph_callees(const struct mcc_callgraph *graph, uint32_t function)
+{
+	return graph->callees + graph->callees_begin[function];
+}
+
+static inline size_t mcc_callgraph_callees_count(const struct mcc_callgraph *graph, uint32_t function)
+{
+	return graph->callees_begin[function + 1] - graph->callees_begin[function];
+}
+
+#endif // MCC_CALLGRAPH_H
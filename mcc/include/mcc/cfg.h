@@ -0,0 +1,81 @@
+// Control Flow Graph
+//
+// Partitions a TAC function into basic blocks and records the edges between
+// them. A block starts at the first instruction, at each label, and after
+// each jump or return; block 0 is the entry. Blocks refer to ranges of the
+// function's instruction array, so the graph has to be rebuilt once
+// instructions are inserted or compacted.
+//
+// Dominators are computed along with the graph, using the iterative
+// algorithm by Cooper, Harvey, and Kennedy over the reverse postorder.
+
+#ifndef MCC_CFG_H
+#define MCC_CFG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcc/tac.h"
+
+// Denotes a missing block.
+#define MCC_CFG_NONE UINT32_MAX
+
+struct mcc_cfg_block {
+	// Instructions `begin` up to, but excluding, `end`.
+	size_t begin, end;
+
+	// The jump target comes first, the fall-through block second. A block
+	// jumping to its fall-through block has a single successor.
+	uint32_t successors[2];
+	uint32_t successors_count;
+
+	// `predecessors_count` entries of `predecessors`, starting at
+	// `predecessors_begin`, in ascending order.
+	size_t predecessors_begin;
+	uint32_t predecessors_count;
+
+	// Immediate dominator, the entry block dominates itself. MCC_CFG_NONE for
+	// unreachable blocks.
+	uint32_t idom;
+
+	// Position in `order`, MCC_CFG_NONE for unreachable blocks.
+	uint32_t order;
+};
+
+struct mcc_cfg {
+	struct mcc_cfg_block *blocks;
+	size_t blocks_count;
+
+	uint32_t *predecessors;
+
+	// Reachable blocks in reverse postorder, starting with the entry.
+	uint32_t *order;
+	size_t order_count;
+
+	// Block of each label, indexed by label. Entry 0 is unused.
+	uint32_t *label_blocks;
+	size_t labels_count;
+};
+
+// Builds the graph of `function`, which must not be modified while the graph
+// is in use. Every label jumped to must be placed. Returns false on
+// allocation failure, `cfg` must be deinitialised anyway.
+bool mcc_cfg_build(struct mcc_cfg *cfg, const struct mcc_tac_function *function);
+
+void mcc_cfg_deinit(struct mcc_cfg *cfg);
+
+static inline const uint32_t *mcc_cfg_block_predecessors(const struct mcc_cfg *cfg, uint32_t block)
+{
+	return cfg->predecessors + cfg->blocks[block].predecessors_begin;
+}
+
+// Returns the index of the last instruction of `block` that is not a
+// tombstone, or `block->end` if there is none.
+size_t mcc_cfg_block_last_instruction(const struct mcc_tac_function *function, const struct mcc_cfg_block *block);
+
+// Returns whether `a` dominates `b`, both must be reachable. This walks the
+// dominator tree upwards from `b`.
+bool mcc_cfg_dominates(const struct mcc_cfg *cfg, uint32_t a, uint32_t b);
+
+#endif // MCC_CFG_H
@@ -0,0 +1,54 @@
+// Copy Propagation and Dead Code Elimination
+//
+// Lowering leaves behind many copies between variables and temporaries that
+// are never read. Copy propagation replaces reads of a variable that was
+// copied from another by reads of the source, provided neither was assigned
+// since the copy on any path. Which copies hold where is a forward dataflow
+// problem over the control flow graph, solved with one bit per copy.
+//
+// Dead code elimination removes instructions without effect besides their
+// result when that result is not live afterwards, see mcc/liveness.h. Stores
+// into arrays the function creates but never reads are removed as well, and
+// so are copies of a temporary computed right before the copy, the
+// instruction computing it assigns the copy's destination instead.
+// Calls are kept, and so is integer division, which may trap. Removing an
+// instruction can make the definitions of its operands dead, and propagation
+// leaves copies nobody reads, so both run until nothing changes.
+//
+// Each round takes time linear in the number of instructions times the
+// number of words of the bit vectors. Removed instructions become
+// tombstones, the control flow graph stays the same. Functions must not be in
+// SSA form.
+
+#ifndef MCC_DCE_H
+#define MCC_DCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+struct mcc_dce_stats {
+	// Variable reads renamed by copy propagation.
+	size_t propagated;
+
+	// Instructions removed.
+	size_t removed;
+};
+
+// Renames reads of copied variables to their source. The number of reads
+// renamed is added to `propagated` if not NULL. Returns false on allocation
+// failure, the function is unchanged then.
+bool mcc_dce_propagate_copies(struct mcc_tac_function *function, size_t *propagated);
+
+// Removes dead instructions until there are none left. The number of
+// instructions removed is added to `removed` if not NULL. Returns false on
+// allocation failure, the instructions removed so far stay removed.
+bool mcc_dce_eliminate(struct mcc_tac_function *function, size_t *removed);
+
+// Alternates copy propagation and dead code elimination until neither
+// changes anything. The counts are added to `stats` if not NULL. Returns
+// false on allocation failure.
+bool mcc_dce_function(struct mcc_tac_function *function, struct mcc_dce_stats *stats);
+
+#endif // MCC_DCE_H
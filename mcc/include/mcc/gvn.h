@@ -0,0 +1,43 @@
+// Global Value Numbering
+//
+// Finds instructions computing a value already computed by a dominating
+// instruction and replaces them by copies of it, following the dominator
+// based value numbering of Briggs, Cooper, and Simpson. The dominator tree is
+// walked depth first with a scoped table of the expressions available in the
+// current block: an expression computed in a block is available in all
+// blocks it dominates and forgotten once the walk leaves them.
+//
+// Expressions are keyed by operation, type, and the value numbers of their
+// operands. Copies share the value number of their source, as do constants
+// of the same type and bits, and phis whose incoming values all share one.
+// Operands of commutative operations are ordered, and `a > b` is written as
+// `b < a`. No other algebraic identities are applied, so floats are only
+// ever matched against the exact same computation.
+//
+// Only operations without side effects are numbered, loads, calls, and
+// parameters are not. Integer division by zero fails at runtime, but a
+// division is only replaced if the same one already succeeded.
+//
+// The function must be in SSA form, so every variable holds a single value
+// wherever it is read. The copies left behind are for copy propagation to
+// remove.
+
+#ifndef MCC_GVN_H
+#define MCC_GVN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+struct mcc_gvn_stats {
+	// Instructions replaced by copies of an available value.
+	size_t eliminated;
+};
+
+// Numbers the values of `function`, which must be in SSA form. The count is
+// added to `stats` if not NULL. Returns false on allocation failure, the
+// function is unchanged then.
+bool mcc_gvn_function(struct mcc_tac_function *function, struct mcc_gvn_stats *stats);
+
+#endif // MCC_GVN_H
@@ -0,0 +1,65 @@
+// Function Inlining
+//
+// Replaces calls of small functions by a copy of the callee's body. This
+// saves passing arguments and the call itself, and lets the other passes
+// optimise the body together with the caller, with constant arguments
+// propagated into it.
+//
+// Parameters become copies of the arguments, so assigning a parameter does
+// not change the caller's variable. Arrays are passed by reference: the copy
+// of an array parameter refers to the caller's array, stores through it are
+// seen by the caller just as before. Returns become a copy of the value into
+// the call's result and a jump past the copied body. Variables and labels of
+// the callee are renamed to new ones of the caller.
+//
+// Whether a call is inlined is decided by its cost, the number of
+// instructions it adds: the callee's size minus its parameters, its return,
+// and the call. Calls within loops run more often and may cost twice as much
+// as others. Callers do not grow beyond a maximum size.
+//
+// Functions are visited bottom-up along their call graph, see
+// mcc/callgraph.h, so callees have their own calls inlined first and are
+// judged by their final size. Calls between functions of the same component,
+// including calls of a function to itself, are never inlined, recursion
+// would unfold without end. Callees creating arrays are not inlined either,
+// every run of the copied body would share the same array.
+//
+// The program must not be in SSA form.
+
+#ifndef MCC_INLINE_H
+#define MCC_INLINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+#define MCC_INLINE_DEFAULT_THRESHOLD 24
+#define MCC_INLINE_DEFAULT_MAX_SIZE 2000
+
+struct mcc_inline_options {
+	// Maximum cost of calls outside of loops, twice as much within loops.
+	// Defaults to MCC_INLINE_DEFAULT_THRESHOLD if 0.
+	size_t threshold;
+
+	// Callers stop growing once they reach this number of instructions.
+	// Defaults to MCC_INLINE_DEFAULT_MAX_SIZE if 0.
+	size_t max_size;
+};
+
+struct mcc_inline_stats {
+	// Calls replaced by the callee's body.
+	size_t inlined;
+
+	// Instructions inserted for them.
+	size_t instructions;
+};
+
+// Inlines calls in all functions of `program`. `options` may be NULL for the
+// defaults. The counts are added to `stats` if not NULL. Returns false on
+// allocation failure, the program still computes the same then.
+bool mcc_inline_program(struct mcc_tac_program *program,
+                        const struct mcc_inline_options *options,
+                        struct mcc_inline_stats *stats);
+
+#endif // MCC_INLINE_H
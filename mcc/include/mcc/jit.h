@@ -0,0 +1,91 @@
+// x86-64 JIT Compiler
+//
+// Translates TAC programs into x86-64 machine code in memory, so programs
+// can be run without an assembler or linker. All functions of a program are
+// emitted into one buffer which is mapped writable while emitting and
+// executable afterwards.
+//
+// Code generation is template-based: every TAC variable lives in an 8-byte
+// slot of the function's stack frame, and each instruction loads its
+// operands into scratch registers, computes its result, and stores it back.
+// A comparison followed by a conditional jump on its result is emitted as a
+// compare-and-branch. Ints and bools use 32-bit integer instructions, floats
+// use scalar SSE instructions. Dividing an int by a constant assigned earlier
+// in the same block multiplies by a magic number and shifts instead.
+//
+// Compiled functions take a pointer to their arguments, one slot each, and
+// return their value in rax. Builtins, and the runtime functions of
+// memoisation, are C functions called following the System V ABI. A call
+// whose result is returned right away reuses the caller's argument slots if
+// the callee takes no more arguments, and jumps to the callee after
+// releasing the caller's frame, so such sibling calls take no stack. Like
+// native code, the generated code does not check for runtime errors:
+// dividing by zero raises SIGFPE and unbounded recursion overflows the stack.
+//
+// The JIT is available on x86-64 System V platforms only. Elsewhere,
+// compiling reports MCC_JIT_ERROR_UNSUPPORTED.
+
+#ifndef MCC_JIT_H
+#define MCC_JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "mcc/tac.h"
+#include "mcc/vm.h"
+
+struct mcc_jit {
+	// Mapped code of all functions.
+	void *code;
+	size_t code_size;
+
+	// Offset of each function's entry in `code`, in the order of the
+	// program's functions.
+	size_t *entries;
+	size_t functions_count;
+
+	const struct mcc_tac_program *program;
+};
+
+enum mcc_jit_error {
+	MCC_JIT_ERROR_NONE = 0,
+	MCC_JIT_ERROR_ALLOCATION_ERROR,
+	MCC_JIT_ERROR_INVALID_PROGRAM,
+	MCC_JIT_ERROR_UNKNOWN_FUNCTION,
+	MCC_JIT_ERROR_MAPPING_ERROR,
+	MCC_JIT_ERROR_UNSUPPORTED,
+};
+
+struct mcc_jit_result {
+	enum mcc_jit_error error;
+	char error_msg[256];
+
+	// Value returned by the called function, zero for void functions.
+	union mcc_vm_value value;
+};
+
+struct mcc_jit_options {
+	// Streams used by the builtins, stdin and stdout if NULL.
+	FILE *in;
+	FILE *out;
+};
+
+void mcc_jit_result_print_error(FILE *out, const struct mcc_jit_result *result);
+
+// Compiles all functions of `program`, which has to stay alive while `jit`
+// is used as string constants are referenced, not copied. Phis are not
+// supported, SSA form has to be destructed first.
+struct mcc_jit_result mcc_jit_compile(struct mcc_jit *jit, const struct mcc_tac_program *program);
+
+void mcc_jit_deinit(struct mcc_jit *jit);
+
+// Calls the compiled function `name` with `arguments_count` arguments,
+// represented as in the VM. Arrays cannot be passed. `options` can be NULL.
+struct mcc_jit_result mcc_jit_call(const struct mcc_jit *jit,
+                                   const char *name,
+                                   const union mcc_vm_value *arguments,
+                                   size_t arguments_count,
+                                   const struct mcc_jit_options *options);
+
+#endif // MCC_JIT_H
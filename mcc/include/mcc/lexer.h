@@ -5,8 +5,9 @@
 // digestable tokens for the parser. Numbers are automatically parsed to `long`
 // or `double`.
 //
-// Ownership of the lexeme's `s_value` field is maintained by the lexer
-// instance.
+// Identifiers and string literals are interned in the lexer's string pool,
+// which therefore owns the lexeme's `s_value` field. The pool can be taken
+// over by the caller, keeping these strings alive beyond the lexer.
 
 #ifndef MCC_LEXER_H
 #define MCC_LEXER_H
@@ -14,6 +15,7 @@
 #include <stdio.h>
 
 #include "mcc/sloc.h"
+#include "mcc/string_pool.h"
 
 // For simplicity we set an upper bound on the length of lexemes. Note that this
 // does not cover comments as comments are discarded by the lexer anyway.
@@ -25,6 +27,15 @@ enum mcc_token {
 	// Keywords:
 	MCC_TOKEN_TRUE,
 	MCC_TOKEN_FALSE,
+	MCC_TOKEN_BOOL,
+	MCC_TOKEN_INT,
+	MCC_TOKEN_FLOAT,
+	MCC_TOKEN_STRING,
+	MCC_TOKEN_VOID,
+	MCC_TOKEN_IF,
+	MCC_TOKEN_ELSE,
+	MCC_TOKEN_WHILE,
+	MCC_TOKEN_RETURN,
 
 	// Literals:
 	MCC_TOKEN_INT_LITERAL,
@@ -34,11 +45,28 @@ enum mcc_token {
 	// Punctuation:
 	MCC_TOKEN_PARENTH_LEFT,
 	MCC_TOKEN_PARENTH_RIGHT,
+	MCC_TOKEN_BRACKET_LEFT,
+	MCC_TOKEN_BRACKET_RIGHT,
+	MCC_TOKEN_BRACE_LEFT,
+	MCC_TOKEN_BRACE_RIGHT,
+	MCC_TOKEN_SEMICOLON,
+	MCC_TOKEN_COMMA,
 
 	// Operators:
 	MCC_TOKEN_PLUS,
+	MCC_TOKEN_MINUS,
 	MCC_TOKEN_ASTERISK,
 	MCC_TOKEN_SLASH,
+	MCC_TOKEN_LESS,
+	MCC_TOKEN_GREATER,
+	MCC_TOKEN_LESS_EQUAL,
+	MCC_TOKEN_GREATER_EQUAL,
+	MCC_TOKEN_AND,
+	MCC_TOKEN_OR,
+	MCC_TOKEN_EQUAL,
+	MCC_TOKEN_NOT_EQUAL,
+	MCC_TOKEN_NOT,
+	MCC_TOKEN_ASSIGN,
 
 	MCC_TOKEN_EOF,
 
@@ -67,7 +95,7 @@ struct mcc_lexeme {
 		// MCC_TOKEN_IDENTIFIER
 		// MCC_TOKEN_STRING_LITERAL
 		// MCC_TOKEN_UNKNOWN
-		char *s_value;
+		const char *s_value;
 	};
 };
 
@@ -83,6 +111,15 @@ enum mcc_lexer_error {
 
 const char *mcc_lexer_error_to_string(enum mcc_lexer_error error);
 
+struct mcc_lexer_stats {
+	// Longest sequence of characters aggregated in the lexer's internal
+	// buffer, compare with MCC_MAX_LEXEME_LENGTH.
+	size_t buffer_high_water;
+
+	// Number of lexemes handed out, including the final EOF.
+	size_t lexemes;
+};
+
 struct mcc_lexer {
 	FILE *stream;
 
@@ -97,18 +134,22 @@ struct mcc_lexer {
 	char buffer[MCC_MAX_LEXEME_LENGTH];
 	size_t buffer_index;
 
-	// This array of strings *owns* all identifiers, string literals, etc.
-	// discovered during the lexing phase. The lexem's `s_value` field
-	// references a string in this array if set.
-	char **strings;
-	size_t strings_count;
-	size_t strings_capacity;
+	// This pool *owns* all identifiers, string literals, etc. discovered
+	// during the lexing phase. The lexem's `s_value` field references a
+	// string in this pool if set.
+	struct mcc_string_pool strings;
+
+	struct mcc_lexer_stats stats;
 };
 
 void mcc_lexer_init(struct mcc_lexer *lexer, FILE *stream);
 
 void mcc_lexer_deinit(struct mcc_lexer *lexer);
 
+// Moves the lexer's string pool to `pool`. Strings obtained so far stay valid
+// until `pool` is deinitialised.
+void mcc_lexer_take_strings(struct mcc_lexer *lexer, struct mcc_string_pool *pool);
+
 // Call this function consecutively to obtain lexemes, one after another, until
 // MCC_TOKEN_EOF is reached.
 struct mcc_lexeme mcc_lexer_lex(struct mcc_lexer *lexer);
@@ -0,0 +1,57 @@
+// Loop-Invariant Code Motion
+//
+// Moves instructions computing the same value in every iteration of a loop
+// to the loop's preheader, see mcc/loops.h, so they run once before the
+// loop instead. Loops are given preheaders first. Inner loops are handled
+// before the loops containing them, instructions hoisted out of an inner loop
+// may then leave the outer one as well.
+//
+// An instruction is invariant if none of its operands is assigned within the
+// loop, or only by instructions hoisted already. It is hoisted if it is the
+// only assignment of its result in the loop, no read of the result in the
+// loop sees an earlier value, and the result is not read after leaving the
+// loop on a path the instruction was not executed on.
+//
+// Arithmetic, comparisons, logical operations, and copies cannot fail and are
+// hoisted from anywhere in the loop, even if the loop runs zero times.
+// Integer divisions by anything but a nonzero constant and calls can fail,
+// they are only hoisted from the loop header, which always runs, when
+// nothing before them in the header has an effect or can fail. Calls must be
+// of pure functions, see mcc/purity.h, without array arguments. Constants
+// are only hoisted along with an instruction reading them, they are as cheap
+// as reading a variable.
+//
+// Functions must not be in SSA form.
+
+#ifndef MCC_LICM_H
+#define MCC_LICM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+struct mcc_licm_stats {
+	// Instructions moved to a preheader, an instruction leaving nested loops
+	// counts once per loop.
+	size_t hoisted;
+
+	// Preheaders inserted.
+	size_t preheaders;
+};
+
+// Hoists invariant instructions out of the loops of `function`. `pure`
+// tells for each function of `program` whether it is pure, calls are only
+// hoisted if both are given. The counts are added to `stats` if not NULL.
+// Returns false on allocation failure, the function still computes the same
+// then.
+bool mcc_licm_function(struct mcc_tac_function *function,
+                       const struct mcc_tac_program *program,
+                       const bool *pure,
+                       struct mcc_licm_stats *stats);
+
+// Runs mcc_licm_function on every function of `program`, analysing which
+// functions are pure first.
+bool mcc_licm_program(struct mcc_tac_program *program, struct mcc_licm_stats *stats);
+
+#endif // MCC_LICM_H
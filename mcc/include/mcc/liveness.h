@@ -0,0 +1,67 @@
+// Liveness Analysis
+//
+// A variable is live at a point of a function if some path from there reads
+// it before assigning it again. Liveness is recorded per basic block of a
+// control flow graph, as the sets of variables live on entry to and on exit
+// from each block; passes recover it for individual instructions by walking
+// a block backwards from its exit.
+//
+// Sets are bit vectors with one bit per variable. They are found by
+// iterating the backward dataflow equations over all blocks in postorder
+// until nothing changes, which takes a few rounds more than the deepest loop
+// nesting.
+//
+// The function must not be in SSA form, phis are not understood.
+
+#ifndef MCC_LIVENESS_H
+#define MCC_LIVENESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcc/cfg.h"
+#include "mcc/tac.h"
+
+struct mcc_liveness {
+	// Words of 64 bits per set.
+	size_t words;
+
+	// `words` words per block, indexed by block.
+	uint64_t *live_in;
+	uint64_t *live_out;
+};
+
+// Computes the liveness of the variables of `function` over its graph `cfg`.
+// `function` is not modified. Returns false on allocation failure,
+// `liveness` must be deinitialised anyway.
+bool mcc_liveness_compute(struct mcc_liveness *liveness, const struct mcc_cfg *cfg, struct mcc_tac_function *function);
+
+void mcc_liveness_deinit(struct mcc_liveness *liveness);
+
+static inline bool mcc_liveness_set_contains(const uint64_t *set, uint32_t variable)
+{
+	return set[variable / 64] >> (variable % 64) & 1;
+}
+
+static inline void mcc_liveness_set_add(uint64_t *set, uint32_t variable)
+{
+	set[variable / 64] |= UINT64_C(1) << (variable % 64);
+}
+
+static inline void mcc_liveness_set_remove(uint64_t *set, uint32_t variable)
+{
+	set[variable / 64] &= ~(UINT64_C(1) << (variable % 64));
+}
+
+static inline const uint64_t *mcc_liveness_out(const struct mcc_liveness *liveness, uint32_t block)
+{
+	return liveness->live_out + block * liveness->words;
+}
+
+static inline const uint64_t *mcc_liveness_in(const struct mcc_liveness *liveness, uint32_t block)
+{
+	return liveness->live_in + block * liveness->words;
+}
+
+#endif // MCC_LIVENESS_H
@@ -0,0 +1,102 @@
+// Natural Loops
+//
+// An edge from a block to one of its dominators is a back edge, the
+// dominator is the header of a loop. The loop consists of the header and all
+// blocks reaching the edge's source without passing through the header.
+// Loops sharing a header are merged into one. Cycles entered at more than
+// one block have no back edge and are not found as loops.
+//
+// Two loops are either disjoint or one contains the other, so the loops of a
+// function form a forest, the loop nest. Each loop records its parent, the
+// innermost loop containing it, and each block the innermost loop it belongs
+// to.
+//
+// A preheader is a block outside a loop whose only successor is the loop's
+// header and which is the header's only predecessor outside the loop.
+// Instructions moved out of a loop are placed there.
+
+#ifndef MCC_LOOPS_H
+#define MCC_LOOPS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcc/cfg.h"
+#include "mcc/tac.h"
+
+struct mcc_loop {
+	uint32_t header;
+
+	// Innermost loop containing this one, MCC_CFG_NONE for outermost loops.
+	// Outermost loops have depth 1.
+	uint32_t parent;
+	uint32_t depth;
+
+	// `blocks_count` entries of `blocks`, starting at `blocks_begin`, in
+	// ascending order. They include the blocks of nested loops.
+	size_t blocks_begin;
+	uint32_t blocks_count;
+};
+
+struct mcc_loops {
+	// Ordered by the position of their header in the reverse postorder, so a
+	// loop comes before the loops nested in it.
+	struct mcc_loop *loops;
+	size_t loops_count;
+
+	uint32_t *blocks;
+
+	// Innermost loop of each block, indexed by block. MCC_CFG_NONE for blocks
+	// outside of all loops.
+	uint32_t *block_loops;
+};
+
+// Finds the loops of the graph `cfg`. Returns false on allocation failure,
+// `loops` must be deinitialised anyway.
+bool mcc_loops_find(struct mcc_loops *loops, const struct mcc_cfg *cfg);
+
+void mcc_loops_deinit(struct mcc_loops *loops);
+
+static inline const uint32_t *mcc_loops_blocks(const struct mcc_loops *loops, uint32_t loop)
+{
+	return loops->blocks + loops->loops[loop].blocks_begin;
+}
+
+// Returns whether `block` belongs to `loop`, directly or through a nested
+// loop. This walks the loop nest upwards from the block's innermost loop.
+bool mcc_loops_contains(const struct mcc_loops *loops, uint32_t loop, uint32_t block);
+
+// Counts the assignments of each variable within `loop`, adding them to
+// `counts`, which is indexed by variable. The index of the last assignment of
+// each variable is stored in `last_definitions` if not NULL. With `reset`,
+// the counts of the variables assigned within the loop are set to zero
+// instead, clearing `counts` without touching every variable. `cfg` is the
+// graph of `function`.
+void mcc_loops_count_definitions(const struct mcc_loops *loops,
+                                 const struct mcc_cfg *cfg,
+                                 const struct mcc_tac_function *function,
+                                 uint32_t loop,
+                                 bool reset,
+                                 uint32_t *counts,
+                                 uint32_t *last_definitions);
+
+// Returns the preheader of `loop`, MCC_CFG_NONE if it has none. `cfg` is the
+// graph of `function`. Blocks ending in a conditional jump do not count as
+// preheaders, instructions could not be added at their end.
+uint32_t mcc_loops_preheader(const struct mcc_loops *loops,
+                             const struct mcc_cfg *cfg,
+                             const struct mcc_tac_function *function,
+                             uint32_t loop);
+
+// Gives every loop of `function` a preheader, inserting a labelled block
+// right before the header where there is none. Jumps entering the loop are
+// redirected to the new block, a block inside the loop falling through to
+// the header jumps to it instead. The number of blocks inserted is added to
+// `inserted` if not NULL. The graph of the function has to be rebuilt
+// afterwards.
+//
+// Returns false on allocation failure, the function is unchanged then.
+bool mcc_loops_insert_preheaders(struct mcc_tac_function *function, size_t *inserted);
+
+#endif // MCC_LOOPS_H
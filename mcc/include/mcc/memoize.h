@@ -0,0 +1,44 @@
+// Automatic Memoisation
+//
+// Caches the results of pure functions calling themselves more than once,
+// like the doubly recursive definition of Fibonacci numbers, which turns
+// exponential running times into linear ones. Only functions with one or two
+// int, bool, or float parameters and such a result are transformed.
+//
+// A memoised function first looks up its arguments in a table provided by
+// the runtime and returns the cached result on a hit. Otherwise it runs its
+// original body, storing the result in the table before returning it. The
+// table is direct-mapped: colliding entries replace each other, so a lookup
+// may miss and fall back to computing the result again.
+//
+// The table is accessed through the runtime functions below, which the VM
+// and the JIT provide. Keys and results are passed as their 32-bit patterns,
+// the table number tells the functions of a program apart.
+
+#ifndef MCC_MEMOIZE_H
+#define MCC_MEMOIZE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+// bool find(int table, key1, key2): returns whether the table holds a
+// result for the keys.
+#define MCC_MEMOIZE_FIND "__mcc_memo_find"
+
+// result get(): returns the result found by the last successful find.
+#define MCC_MEMOIZE_GET "__mcc_memo_get"
+
+// void put(int table, key1, key2, result): stores the result for the keys.
+#define MCC_MEMOIZE_PUT "__mcc_memo_put"
+
+// Memoises all qualifying functions of `program`, adding their number to
+// `memoized` if not NULL. Functions already memoised are left alone, as are
+// all functions if the program defines one of the runtime functions itself.
+//
+// The program must not be in SSA form. Returns false on allocation failure,
+// the functions memoised so far are kept.
+bool mcc_memoize_program(struct mcc_tac_program *program, size_t *memoized);
+
+#endif // MCC_MEMOIZE_H
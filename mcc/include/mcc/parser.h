@@ -12,6 +12,8 @@
 #include <stdio.h>
 
 #include "mcc/ast.h"
+#include "mcc/lexer.h"
+#include "mcc/string_pool.h"
 
 enum mcc_parser_error {
 	MCC_PARSER_ERROR_NONE = 0,
@@ -22,18 +24,33 @@ enum mcc_parser_error {
 };
 
 struct mcc_parser_result {
+	// Set by `mcc_parse_string`.
 	struct mcc_ast_expression *expression;
 
+	// Set by `mcc_parse_file` and `mcc_parse_program_string`.
+	struct mcc_ast_program *program;
+
+	// Owns identifiers and string literals referenced by `expression`, release
+	// it along with the expression. A program owns its strings itself, hence
+	// this pool stays empty when parsing programs.
+	struct mcc_string_pool strings;
+
+	struct mcc_lexer_stats lexer_stats;
+
 	enum mcc_parser_error error;
 	char error_msg[1024];
 };
 
 void mcc_parser_result_print_error(FILE *out, struct mcc_parser_result *result);
 
+// Parses a single expression, mainly useful for testing.
 struct mcc_parser_result mcc_parse_string(const char *input);
 
-// Runs the parser on the given `input`. `filepath` is only used for prefixing
-// error messages and can be NULL.
+// Parses a whole mC program.
+struct mcc_parser_result mcc_parse_program_string(const char *input);
+
+// Runs the parser on the given `input`, expecting a whole mC program.
+// `filepath` is only used for prefixing error messages and can be NULL.
 struct mcc_parser_result mcc_parse_file(FILE *input, const char *filepath);
 
 #endif // MCC_PARSER_H
@@ -0,0 +1,44 @@
+// Optimisation Passes
+//
+// Passes transform a TAC program in place. They are registered in a table
+// and looked up by name, which is how tools assemble pipelines such as
+// `ssa,out-of-ssa`. Most passes work on one function at a time, the others
+// see the whole program.
+
+#ifndef MCC_PASS_H
+#define MCC_PASS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+struct mcc_pass {
+	const char *name;
+	const char *description;
+
+	// Exactly one of these is set. They return false on allocation failure,
+	// leaving the IR valid but possibly only partially transformed.
+	bool (*run_function)(struct mcc_tac_function *function);
+	bool (*run_program)(struct mcc_tac_program *program);
+};
+
+// All passes, in no particular order.
+extern const struct mcc_pass mcc_passes[];
+extern const size_t mcc_passes_count;
+
+// Returns NULL if there is no pass with the first `length` characters of
+// `name` as its name.
+const struct mcc_pass *mcc_pass_find(const char *name, size_t length);
+
+// Runs `pass` on `program`. Returns false on allocation failure.
+bool mcc_pass_run(const struct mcc_pass *pass, struct mcc_tac_program *program);
+
+// Passes run by `mcc -O`, separated by commas.
+extern const char mcc_pass_default_pipeline[];
+
+// Runs the comma-separated passes of `pipeline` in order, all of them must
+// exist. Returns false on allocation failure.
+bool mcc_pass_run_pipeline(const char *pipeline, struct mcc_tac_program *program);
+
+#endif // MCC_PASS_H
@@ -0,0 +1,43 @@
+// Purity Analysis and Compile-Time Evaluation
+//
+// A function is pure if calling it has no effect besides computing its
+// result: it reaches no builtin, neither directly nor through the functions
+// it calls, and never stores into an array it did not create itself. The
+// runtime functions of memoisation, see mcc/memoize.h, do not count. Pure
+// functions may read arrays passed to them, so only calls without array
+// arguments are guaranteed to depend on their arguments alone.
+//
+// Recursive functions are assumed pure until shown otherwise, the analysis
+// iterates over the program until nothing changes.
+//
+// Calls of pure functions whose arguments are all constants are evaluated at
+// compile time by running them in the bytecode VM and replaced by their
+// result. Each evaluation gets a limited amount of fuel, calls running out of
+// it, or failing at runtime, are left alone. Arguments count as constant if
+// they are defined by a constant earlier in the same basic block.
+
+#ifndef MCC_PURITY_H
+#define MCC_PURITY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+// Fuel of each evaluation if none is given, see mcc_vm_options.
+#define MCC_PURITY_DEFAULT_FUEL 100000
+
+// Stores whether each function of `program` is pure in `pure`, which has an
+// entry per function. Returns false on allocation failure.
+bool mcc_purity_analyse(const struct mcc_tac_program *program, bool *pure);
+
+// Replaces calls of pure functions with constant arguments by their result,
+// calls of void functions are removed. `fuel` bounds each evaluation,
+// MCC_PURITY_DEFAULT_FUEL is used if 0. The number of calls replaced is added
+// to `folded` if not NULL.
+//
+// The program must not be in SSA form. Returns false on allocation failure,
+// the calls folded so far are kept.
+bool mcc_purity_fold_calls(struct mcc_tac_program *program, size_t fuel, size_t *folded);
+
+#endif // MCC_PURITY_H
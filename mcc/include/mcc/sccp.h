@@ -0,0 +1,50 @@
+// Sparse Conditional Constant Propagation
+//
+// Finds variables holding the same int, float, or bool constant whenever
+// they are read, together with the blocks that can execute at all, following
+// Wegman and Zadeck. Both start out optimistic: a block is only considered
+// once an edge leading to it is found executable, and a conditional jump on a
+// constant makes only its taken edge executable. This finds constants flowing
+// around loops and through branches that plain propagation misses.
+//
+// Values flow along def-use chains rather than through every block. In SSA
+// form each read has a single definition and phis merge the values arriving
+// on executable edges. Otherwise the chains come from reaching definitions
+// over the control flow graph, a read sees the meet of the definitions
+// reaching it from executable blocks. Variables read before any assignment
+// read zero, as they do at runtime.
+//
+// Operations are folded the way the VM evaluates them: ints wrap around at
+// 32 bits, floats have single precision, and division by zero is left to
+// fail at runtime.
+//
+// Definitions found constant are replaced by CONST instructions, conditional
+// jumps on constants become unconditional jumps or are removed, and the
+// instructions of unreachable blocks are removed. Removed instructions become
+// tombstones.
+
+#ifndef MCC_SCCP_H
+#define MCC_SCCP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+struct mcc_sccp_stats {
+	// Definitions replaced by constants.
+	size_t constants;
+
+	// Conditional jumps made unconditional or removed.
+	size_t branches;
+
+	// Blocks removed as unreachable.
+	size_t unreachable;
+};
+
+// Propagates constants through `function`, which may be in SSA form. The
+// counts are added to `stats` if not NULL. Returns false on allocation
+// failure, the function is unchanged then.
+bool mcc_sccp_function(struct mcc_tac_function *function, struct mcc_sccp_stats *stats);
+
+#endif // MCC_SCCP_H
@@ -0,0 +1,69 @@
+// Semantic Analysis
+//
+// Checks a parsed program against the semantic rules of mC in a single pass
+// over the AST: declarations and their uses, function definitions and calls,
+// the `main` function, return paths, and types.
+//
+// On the way, the AST is annotated so later stages need neither lookups nor
+// type inference: each expression's `data_type` is set, identifiers refer to
+// their declaration or function, and the program receives declarations of
+// the built-in functions.
+//
+// Function signatures are collected first, afterwards function bodies are
+// checked independently, optionally on multiple threads. Diagnostics do not
+// depend on the number of threads.
+//
+// The analysis stops on the first error, in source order, unless told to
+// collect all errors. Annotations are only complete if no error occurred.
+
+#ifndef MCC_SEMANTIC_H
+#define MCC_SEMANTIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "mcc/ast.h"
+#include "mcc/sloc.h"
+
+enum mcc_semantic_error {
+	MCC_SEMANTIC_ERROR_NONE = 0,
+	MCC_SEMANTIC_ERROR_CHECK_FAILED,
+	MCC_SEMANTIC_ERROR_ALLOCATION_ERROR,
+};
+
+struct mcc_semantic_diagnostic {
+	struct mcc_sloc sloc;
+	char message[256];
+};
+
+struct mcc_semantic_options {
+	// Keep going after the first error. Expressions depending on an erroneous
+	// one are not checked, avoiding follow-up errors.
+	bool collect_all;
+
+	// Number of threads checking function bodies, 0 and 1 check them on the
+	// calling thread.
+	size_t threads;
+};
+
+struct mcc_semantic_result {
+	enum mcc_semantic_error error;
+
+	// In source order.
+	struct mcc_semantic_diagnostic *diagnostics;
+	size_t diagnostics_count;
+	size_t diagnostics_capacity;
+};
+
+// `options` may be NULL to stop on the first error. Release the result with
+// `mcc_semantic_result_deinit`.
+struct mcc_semantic_result mcc_semantic_check(struct mcc_ast_program *program,
+                                              const struct mcc_semantic_options *options);
+
+// `filepath` is only used for prefixing error messages and can be NULL.
+void mcc_semantic_result_print_errors(FILE *out, const struct mcc_semantic_result *result, const char *filepath);
+
+void mcc_semantic_result_deinit(struct mcc_semantic_result *result);
+
+#endif // MCC_SEMANTIC_H
@@ -0,0 +1,64 @@
+// Static Single Assignment Form
+//
+// In SSA form every variable is defined by exactly one instruction, which
+// dominates all uses of the variable. Where control flow merges, phi
+// instructions select the value flowing in from each predecessor.
+//
+// Construction follows Cytron et al.: phis are placed at the iterated
+// dominance frontier of a variable's definitions, but only where the
+// variable is live (pruned form). Definitions are then renamed in a walk of
+// the dominator tree, the first definition of a variable keeps its number.
+// Variables read before any definition read zero. Unreachable blocks are
+// dropped and every block starts with a label, phis name their predecessors
+// by these labels.
+//
+// Destruction replaces phis by copies at the end of the predecessors.
+// Variables connected by phis or copies are coalesced into one if their live
+// ranges do not interfere, which removes the copy. The copies remaining on
+// an edge happen in parallel, they are sequentialised using a temporary to
+// break cycles. Critical edges are split where copies have to be placed.
+
+#ifndef MCC_SSA_H
+#define MCC_SSA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcc/tac.h"
+
+// Rewrites `function` into SSA form. Returns false on allocation failure,
+// the function then still computes the same but may not be in SSA form.
+bool mcc_ssa_construct(struct mcc_tac_function *function);
+
+// Translates `function`, which must be in SSA form, out of it, leaving no
+// phis behind. Returns false on allocation failure, the instructions are
+// unchanged in that case.
+bool mcc_ssa_destruct(struct mcc_tac_function *function);
+
+// ---------------------------------------------------------------- Def-Use
+
+#define MCC_SSA_NO_DEFINITION SIZE_MAX
+
+// Definition and uses of each variable of a function in SSA form, indexed by
+// variable. Entries refer to instruction indices.
+struct mcc_ssa_def_use {
+	size_t variables_count;
+
+	// MCC_SSA_NO_DEFINITION for variables without definition.
+	size_t *definitions;
+
+	// The uses of variable `v` are `uses[uses_begin[v]]` up to, but
+	// excluding, `uses[uses_begin[v + 1]]`, in instruction order. An
+	// instruction reading a variable twice is listed twice.
+	size_t *uses_begin;
+	size_t *uses;
+};
+
+// `function` is not modified. Returns false on allocation failure,
+// `def_use` must be deinitialised anyway.
+bool mcc_ssa_def_use_build(struct mcc_ssa_def_use *def_use, struct mcc_tac_function *function);
+
+void mcc_ssa_def_use_deinit(struct mcc_ssa_def_use *def_use);
+
+#endif // MCC_SSA_H
@@ -0,0 +1,48 @@
+// Induction Variable Strength Reduction
+//
+// A basic induction variable is assigned once within a loop, by adding or
+// subtracting a loop-invariant step to itself, like the counter of a loop
+// walking an array. Multiplying it by an invariant factor yields a derived
+// induction variable, which changes by step times factor whenever the basic
+// one changes.
+//
+// Such multiplications are replaced by reading a new variable, initialised
+// to the product in the loop's preheader, see mcc/loops.h, and updated by an
+// addition right after each assignment of the basic induction variable.
+// Multiplications sharing variable and factor share the new variable. Only
+// multiplications in blocks running in every iteration are replaced, others
+// would not pay for the update.
+//
+// Array elements are addressed by index, see mcc/tac.h, scaling the index is
+// left to the backends. Factors are therefore the multiplications of the
+// source program, like `i * 4 + j` indexing a matrix.
+//
+// Operands count as invariant if they are not assigned within the loop, or
+// hold a constant assigned once before they are read. All arithmetic wraps
+// around, so the new variable equals the product even if either overflows.
+//
+// Functions must not be in SSA form.
+
+#ifndef MCC_STRENGTH_H
+#define MCC_STRENGTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+struct mcc_strength_stats {
+	// Multiplications replaced by a copy.
+	size_t reduced;
+
+	// Variables introduced, one per basic induction variable and factor.
+	size_t variables;
+};
+
+// Reduces multiplications of induction variables in the loops of `function`,
+// inserting preheaders where needed. The counts are added to `stats` if not
+// NULL. Returns false on allocation failure, the function still computes the
+// same then.
+bool mcc_strength_reduce_function(struct mcc_tac_function *function, struct mcc_strength_stats *stats);
+
+#endif // MCC_STRENGTH_H
@@ -0,0 +1,41 @@
+// String Pool
+//
+// A string pool *interns* strings: equal strings added to the same pool yield
+// the very same, immutable copy. Interned strings can therefore be compared by
+// pointer instead of `strcmp`.
+//
+// The pool owns all strings added to it. They are released on deinit.
+
+#ifndef MCC_STRING_POOL_H
+#define MCC_STRING_POOL_H
+
+#include <stddef.h>
+
+struct mcc_string_pool {
+	// Open addressing hash table, empty slots are NULL. `capacity` is always
+	// zero or a power of two.
+	char **slots;
+	size_t count;
+	size_t capacity;
+
+	// Total number of bytes held by interned strings, including terminators.
+	size_t bytes;
+
+	// Number of allocation calls issued by the pool so far.
+	size_t allocations;
+};
+
+void mcc_string_pool_init(struct mcc_string_pool *pool);
+
+void mcc_string_pool_deinit(struct mcc_string_pool *pool);
+
+// Returns the interned copy of the first `length` characters of `s`. NULL is
+// returned on allocation failure.
+const char *mcc_string_pool_intern(struct mcc_string_pool *pool, const char *s, size_t length);
+
+// Returns the interned copy of the first `length` characters of `s`, or NULL
+// if there is none. Unlike interning, this does not modify the pool and may
+// be called concurrently.
+const char *mcc_string_pool_find(const struct mcc_string_pool *pool, const char *s, size_t length);
+
+#endif // MCC_STRING_POOL_H
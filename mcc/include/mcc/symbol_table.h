@@ -0,0 +1,109 @@
+// Symbol Table
+//
+// A scoped symbol table mapping interned identifiers to their declarations.
+// Identifiers must originate from the same string pool, they are compared by
+// pointer.
+//
+// All symbols live in a single open addressing hash map. Each slot refers to
+// the innermost visible declaration of its name, which in turn links to the
+// declaration it shadows, forming a per-name declaration stack. Declarations
+// are appended to a log; leaving a scope pops the scope's part of the log and
+// restores the shadowed declarations. Lookups, declarations, and entering a
+// scope are therefore O(1), independent of nesting depth and scope size;
+// leaving a scope is linear in the number of symbols it declared.
+
+#ifndef MCC_SYMBOL_TABLE_H
+#define MCC_SYMBOL_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/ast.h"
+
+enum mcc_symbol_kind {
+	MCC_SYMBOL_KIND_VARIABLE,
+	MCC_SYMBOL_KIND_FUNCTION,
+};
+
+struct mcc_symbol {
+	const char *name;
+
+	enum mcc_symbol_kind kind;
+	union {
+		// MCC_SYMBOL_KIND_VARIABLE, covers parameters as well
+		struct mcc_ast_declaration *declaration;
+
+		// MCC_SYMBOL_KIND_FUNCTION
+		struct mcc_ast_function *function;
+	};
+
+	// Nesting depth of the declaring scope, the outermost scope has depth 0.
+	size_t scope;
+};
+
+struct mcc_symbol_table_entry {
+	struct mcc_symbol symbol;
+
+	// Index of the shadowed entry of the same name, or
+	// MCC_SYMBOL_TABLE_NONE.
+	size_t shadowed;
+};
+
+struct mcc_symbol_table_slot {
+	const char *name;
+
+	// Index of the innermost visible entry, or MCC_SYMBOL_TABLE_NONE. Slots
+	// are never removed, hence no tombstones are needed.
+	size_t top;
+};
+
+#define MCC_SYMBOL_TABLE_NONE ((size_t)-1)
+
+struct mcc_symbol_table {
+	// Open addressing hash map keyed by name, `slots_capacity` is always zero
+	// or a power of two.
+	struct mcc_symbol_table_slot *slots;
+	size_t slots_count;
+	size_t slots_capacity;
+
+	// Declarations in order, doubling as scope-exit log.
+	struct mcc_symbol_table_entry *entries;
+	size_t entries_count;
+	size_t entries_capacity;
+
+	// For each open scope, the number of entries at the time it was entered.
+	size_t *scopes;
+	size_t scopes_count;
+	size_t scopes_capacity;
+};
+
+enum mcc_symbol_table_error {
+	MCC_SYMBOL_TABLE_ERROR_NONE = 0,
+	MCC_SYMBOL_TABLE_ERROR_REDECLARATION,
+	MCC_SYMBOL_TABLE_ERROR_ALLOCATION_ERROR,
+};
+
+// The table starts out with a single, outermost scope.
+void mcc_symbol_table_init(struct mcc_symbol_table *table);
+
+void mcc_symbol_table_deinit(struct mcc_symbol_table *table);
+
+// Returns false on allocation failure.
+bool mcc_symbol_table_enter_scope(struct mcc_symbol_table *table);
+
+// Must not be called for the outermost scope.
+void mcc_symbol_table_exit_scope(struct mcc_symbol_table *table);
+
+// Nesting depth of the current scope.
+size_t mcc_symbol_table_scope(const struct mcc_symbol_table *table);
+
+// Declares `symbol` in the current scope, shadowing declarations of the same
+// name in enclosing scopes. The `scope` member is set by the table.
+// Redeclarations within the same scope are rejected.
+enum mcc_symbol_table_error mcc_symbol_table_declare(struct mcc_symbol_table *table, struct mcc_symbol symbol);
+
+// Returns the innermost visible symbol named `name`, or NULL. The result is
+// invalidated by the next declaration or scope exit.
+const struct mcc_symbol *mcc_symbol_table_lookup(const struct mcc_symbol_table *table, const char *name);
+
+#endif // MCC_SYMBOL_TABLE_H
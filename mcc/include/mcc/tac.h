@@ -0,0 +1,273 @@
+// Three-Address Code
+//
+// The compiler's intermediate representation. A TAC program consists of
+// functions, each holding a flat sequence of instructions. Most instructions
+// compute a `result` variable from up to two argument variables; control flow
+// uses numbered labels and calls refer to their callee by name, listing their
+// arguments explicitly.
+//
+// Variables and labels are numbered per function starting at 1, 0 denotes an
+// unused operand. Each mC variable maps to exactly one TAC variable, which
+// may be assigned more than once.
+//
+// Instructions are packed into 16 bytes: an opcode, a type, and three 32-bit
+// operands. Operands too large for 32 bits live in side tables of the
+// function: numeric constants in `constants`, string constants and callee
+// names in `strings`, argument lists in `operands`; the instruction refers to
+// them by index.
+//
+// A function's instructions are stored contiguously and referred to by index.
+// Appending is amortised O(1). Removing an instruction leaves a tombstone
+// (MCC_TAC_OP_NOP) so the indices of the other instructions stay valid until
+// the function is compacted. Passes inserting many instructions are better off
+// rebuilding the sequence in a new array.
+
+#ifndef MCC_TAC_H
+#define MCC_TAC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "mcc/string_pool.h"
+
+enum mcc_tac_type {
+	MCC_TAC_TYPE_VOID = 0,
+	MCC_TAC_TYPE_BOOL,
+	MCC_TAC_TYPE_INT,
+	MCC_TAC_TYPE_FLOAT,
+	MCC_TAC_TYPE_STRING,
+
+	// A reference to an array. Elements are untyped, the instructions
+	// accessing them determine their type.
+	MCC_TAC_TYPE_ARRAY,
+};
+
+const char *mcc_tac_type_to_string(enum mcc_tac_type type);
+
+// A typed variable handle, as handed out when building functions.
+// Instructions only store the identifier, the type is recorded in the
+// function's `variable_types`.
+struct mcc_tac_variable {
+	enum mcc_tac_type type;
+	uint32_t identifier;
+};
+
+// Unless noted otherwise, an instruction's `type` is the type of its operands
+// and result.
+enum mcc_tac_op {
+	// Tombstone of a removed instruction.
+	MCC_TAC_OP_NOP,
+
+	// result = constant, `arg1` indexes `constants`, or `strings` for string
+	// constants.
+	MCC_TAC_OP_CONST,
+
+	// result = arg1
+	MCC_TAC_OP_ASSIGN,
+
+	// result = arg1 <op> arg2, on int or float
+	MCC_TAC_OP_ADD,
+	MCC_TAC_OP_SUB,
+	MCC_TAC_OP_MUL,
+	MCC_TAC_OP_DIV,
+
+	// result = -arg1, on int or float
+	MCC_TAC_OP_NEG,
+
+	// result = arg1 <op> arg2, the result is a bool
+	MCC_TAC_OP_EQ,
+	MCC_TAC_OP_NE,
+	MCC_TAC_OP_LT,
+	MCC_TAC_OP_LE,
+	MCC_TAC_OP_GT,
+	MCC_TAC_OP_GE,
+
+	// Logical operations on bool, both operands are always evaluated.
+	MCC_TAC_OP_AND,
+	MCC_TAC_OP_OR,
+	MCC_TAC_OP_NOT,
+
+	// result = new array, `arg1` indexes its size in `constants`. `type` is
+	// the element type.
+	MCC_TAC_OP_ARRAY,
+	// result = arg1[arg2], `type` is the element type.
+	MCC_TAC_OP_LOAD,
+	// result[arg1] = arg2, note that `result` is read, not written. `type` is
+	// the element type.
+	MCC_TAC_OP_STORE,
+
+	// Control flow, the label is always `arg2`. Conditional jumps test arg1.
+	MCC_TAC_OP_LABEL,
+	MCC_TAC_OP_JUMP,
+	MCC_TAC_OP_JUMP_IF,
+	MCC_TAC_OP_JUMP_IF_NOT,
+
+	// result = parameter number `arg1`, counting from 0. A function starts
+	// with one PARAM per parameter, in order.
+	MCC_TAC_OP_PARAM,
+
+	// result = call of the function named by `strings[arg1]`. `arg2` indexes
+	// the number of arguments in `operands`, followed by the argument
+	// variables. The `type` of CALL and RETURN is void if there is no value.
+	MCC_TAC_OP_CALL,
+	MCC_TAC_OP_RETURN,
+
+	// SSA form only, see mcc/ssa.h. result = phi(...), `arg1` indexes `arg2`
+	// pairs of a predecessor's label and the incoming value in `operands`.
+	// Phis are placed at the start of a block, right after its label.
+	MCC_TAC_OP_PHI,
+};
+
+const char *mcc_tac_op_to_string(enum mcc_tac_op op);
+
+// Returns whether `op` assigns its `result`. Calls of void functions have no
+// result regardless.
+bool mcc_tac_op_defines_result(enum mcc_tac_op op);
+
+struct mcc_tac_instruction {
+	uint8_t op;   // enum mcc_tac_op
+	uint8_t type; // enum mcc_tac_type
+	uint32_t result, arg1, arg2;
+};
+
+_Static_assert(sizeof(struct mcc_tac_instruction) == 16, "TAC instructions are packed into 16 bytes");
+
+// ------------------------------------------------------------------ Function
+
+struct mcc_tac_function {
+	const char *name;
+	enum mcc_tac_type return_type;
+	size_t parameters_count;
+
+	struct mcc_tac_instruction *instructions;
+	size_t instructions_count;
+	size_t instructions_capacity;
+
+	// Number of tombstones among `instructions`.
+	size_t removed_count;
+
+	// Highest variable and label number in use. `variable_types` is indexed
+	// by variable, entry 0 is unused.
+	uint32_t variables_count;
+	uint32_t labels_count;
+	uint8_t *variable_types;
+	size_t variable_types_capacity;
+
+	// Bit patterns of int, float, and bool constants, as well as array sizes.
+	uint64_t *constants;
+	size_t constants_count;
+	size_t constants_capacity;
+
+	// String constants and callee names, they are not owned by the function.
+	const char **strings;
+	size_t strings_count;
+	size_t strings_capacity;
+
+	// Operand lists of instructions taking more than two arguments.
+	uint32_t *operands;
+	size_t operands_count;
+	size_t operands_capacity;
+};
+
+// Releases the function's instructions and side tables, but not the function
+// itself.
+void mcc_tac_function_deinit(struct mcc_tac_function *function);
+
+// Returns an unused variable with identifier 0 on allocation failure.
+struct mcc_tac_variable mcc_tac_function_new_variable(struct mcc_tac_function *function, enum mcc_tac_type type);
+
+uint32_t mcc_tac_function_new_label(struct mcc_tac_function *function);
+
+// Append to the side tables, returning the new entry's index. Entries are not
+// deduplicated. Return false on allocation failure.
+bool mcc_tac_function_add_constant(struct mcc_tac_function *function, uint64_t bits, uint32_t *index);
+bool mcc_tac_function_add_string(struct mcc_tac_function *function, const char *string, uint32_t *index);
+bool mcc_tac_function_add_operands(struct mcc_tac_function *function,
+                                   const uint32_t *operands,
+                                   size_t count,
+                                   uint32_t *index);
+
+// Conversions between constants and their bit patterns in `constants`, bools
+// are stored as 0 and 1.
+uint64_t mcc_tac_int_bits(long value);
+uint64_t mcc_tac_float_bits(double value);
+long mcc_tac_bits_int(uint64_t bits);
+double mcc_tac_bits_float(uint64_t bits);
+
+// `variable` must exist.
+enum mcc_tac_type mcc_tac_function_variable_type(const struct mcc_tac_function *function, uint32_t variable);
+
+// Returns whether `function` has ARRAY instructions. Their storage lives
+// until the function returns.
+bool mcc_tac_function_creates_arrays(const struct mcc_tac_function *function);
+
+// Returns the variable defined by `instruction`, 0 if there is none.
+uint32_t mcc_tac_instruction_definition(const struct mcc_tac_instruction *instruction);
+
+typedef void (*mcc_tac_use_callback)(uint32_t *variable, void *userdata);
+
+// Invokes `callback` for each variable read by `instruction`, in operand
+// order. The callback may rename the variable. `function` provides operand
+// lists and is not modified otherwise.
+void mcc_tac_function_visit_uses(struct mcc_tac_function *function,
+                                 struct mcc_tac_instruction *instruction,
+                                 mcc_tac_use_callback callback,
+                                 void *userdata);
+
+// Returns false on allocation failure, leaving the function untouched.
+bool mcc_tac_function_reserve(struct mcc_tac_function *function, size_t count);
+
+// Appends an instruction, its index is `instructions_count - 1` afterwards.
+// Returns false on allocation failure.
+bool mcc_tac_function_append(struct mcc_tac_function *function, struct mcc_tac_instruction instruction);
+
+// Inserts `count` instructions before `index`, shifting all following ones.
+// This is linear in the number of instructions, hence insert in batches.
+// Returns false on allocation failure.
+bool mcc_tac_function_insert(struct mcc_tac_function *function,
+                             size_t index,
+                             const struct mcc_tac_instruction *instructions,
+                             size_t count);
+
+// Replaces the instruction at `index` by a tombstone in O(1).
+void mcc_tac_function_remove(struct mcc_tac_function *function, size_t index);
+
+// Drops all tombstones, which changes instruction indices.
+void mcc_tac_function_compact(struct mcc_tac_function *function);
+
+// ------------------------------------------------------------------- Program
+
+struct mcc_tac_program {
+	struct mcc_tac_function *functions;
+	size_t functions_count;
+	size_t functions_capacity;
+
+	// Owns function names, callee names, and string constants.
+	struct mcc_string_pool strings;
+};
+
+void mcc_tac_program_init(struct mcc_tac_program *program);
+
+void mcc_tac_program_deinit(struct mcc_tac_program *program);
+
+// Adds an empty function, `name` is interned. The returned function is valid
+// until the next function is added. Returns NULL on allocation failure.
+struct mcc_tac_function *mcc_tac_program_add_function(struct mcc_tac_program *program,
+                                                      const char *name,
+                                                      enum mcc_tac_type return_type);
+
+// Returns NULL if there is no function called `name`.
+const struct mcc_tac_function *mcc_tac_program_find_function(const struct mcc_tac_program *program,
+                                                             const char *name);
+
+// ------------------------------------------------------------------ Printing
+
+// Prints one instruction per line, tombstones are skipped. Returns false if
+// writing to `out` failed.
+bool mcc_tac_print_function(FILE *out, const struct mcc_tac_function *function);
+
+bool mcc_tac_print_program(FILE *out, const struct mcc_tac_program *program);
+
+#endif // MCC_TAC_H
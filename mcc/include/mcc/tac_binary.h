@@ -0,0 +1,66 @@
+// TAC Binary Format
+//
+// A stable encoding of TAC functions, optionally along with their control flow
+// graphs, for caching IR and shipping it between processes.
+//
+// An image consists of a 16-byte header (the magic "MCCTAC\0\0", the format
+// version, and the number of functions) followed by one record per function.
+// A record starts with its size in bytes and a fixed header of counts,
+// followed by the function's name, instructions, constants, operands,
+// variable types, strings, and optionally its graph.
+//
+// All integers are little-endian and every array starts at a multiple of 8
+// bytes. Instructions keep the in-memory layout of `struct
+// mcc_tac_instruction` with zeroed padding. On little-endian hosts decoding
+// thus boils down to copying arrays, straight out of a mapped file if need be.
+//
+// Records are self-contained and independent of addresses: equal functions
+// encode to equal bytes, regardless of the program they belong to. Images of
+// a different version are rejected, the version is bumped whenever the
+// encoding or the meaning of the IR changes.
+
+#ifndef MCC_TAC_BINARY_H
+#define MCC_TAC_BINARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "mcc/cfg.h"
+#include "mcc/tac.h"
+
+#define MCC_TAC_BINARY_VERSION 1
+
+// Writes an image of `functions_count` functions. If `cfgs` is not NULL, it
+// holds the graph of each function, which is encoded along with it. Returns
+// false on allocation or write failure.
+bool mcc_tac_binary_write(FILE *out,
+                          const struct mcc_tac_function *functions,
+                          size_t functions_count,
+                          const struct mcc_cfg *cfgs);
+
+// Returns whether `data` starts like an image of any version.
+bool mcc_tac_binary_is_image(const void *data, size_t size);
+
+// Appends the functions of the image in `data` to `program`, interning their
+// strings in the program's pool. If `cfgs` is not NULL, it receives an array
+// holding the graph of each appended function: decoded if the image holds it,
+// built otherwise. The caller deinitialises the graphs and frees the array.
+//
+// The image is validated, so it may come from an untrusted source: operands
+// must be in range, no two instructions may share operands, PARAM indices
+// must be below the parameter count, and calls from or to the appended
+// functions must match the callee's arity. Returns false if it is malformed,
+// of a different version, or on allocation failure.
+// `program` may have received some of the functions in that case.
+bool mcc_tac_binary_read(struct mcc_tac_program *program, struct mcc_cfg **cfgs, const void *data, size_t size);
+
+// Like `mcc_tac_binary_read`, mapping the file at `path` into memory.
+bool mcc_tac_binary_read_file(struct mcc_tac_program *program, struct mcc_cfg **cfgs, const char *path);
+
+// Computes a 64-bit FNV-1a hash of the encoding of `function`, without its
+// graph. Suitable as a cache key. Returns false on allocation failure.
+bool mcc_tac_binary_hash(const struct mcc_tac_function *function, uint64_t *hash);
+
+#endif // MCC_TAC_BINARY_H
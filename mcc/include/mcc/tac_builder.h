@@ -0,0 +1,134 @@
+// TAC Builder
+//
+// Constructs a single TAC function. The builder owns the function under
+// construction, including its instruction storage and the counters handing
+// out variables and labels. Builders share no state, so any number of
+// functions can be built concurrently, each numbering its variables and
+// labels densely from 1.
+//
+// Allocation failures are sticky: once an instruction could not be added, all
+// further ones are dropped and `mcc_tac_builder_finish` reports the failure.
+// Code generators can therefore emit without checking every step.
+//
+// Equal constants and strings share an entry in the function's side tables.
+
+#ifndef MCC_TAC_BUILDER_H
+#define MCC_TAC_BUILDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcc/tac.h"
+
+// Maps side table entries to their index, private to the builder.
+struct mcc_tac_builder_pool_entry {
+	uint64_t key;
+	uint32_t index; // plus one, 0 marks an empty slot
+};
+
+struct mcc_tac_builder_pool {
+	struct mcc_tac_builder_pool_entry *entries;
+	size_t count;
+	size_t capacity;
+};
+
+struct mcc_tac_builder {
+	struct mcc_tac_function function;
+	struct mcc_tac_builder_pool constants;
+	struct mcc_tac_builder_pool strings;
+	bool failed;
+};
+
+// `name` must outlive the built function, typically it is interned in the
+// pool of the program receiving the function.
+void mcc_tac_builder_init(struct mcc_tac_builder *builder,
+                          const char *name,
+                          enum mcc_tac_type return_type,
+                          size_t parameters_count);
+
+// Releases the function under construction, if any.
+void mcc_tac_builder_deinit(struct mcc_tac_builder *builder);
+
+// Moves the built function into `function`, the builder starts over with an
+// empty function of the same signature. Returns false if an allocation
+// failed, `function` is left untouched in that case.
+bool mcc_tac_builder_finish(struct mcc_tac_builder *builder, struct mcc_tac_function *function);
+
+struct mcc_tac_variable mcc_tac_builder_variable(struct mcc_tac_builder *builder, enum mcc_tac_type type);
+
+uint32_t mcc_tac_builder_label(struct mcc_tac_builder *builder);
+
+// Appends `instruction`. Operands referring to side tables must have been
+// added to the builder's function already.
+void mcc_tac_builder_emit(struct mcc_tac_builder *builder, struct mcc_tac_instruction instruction);
+
+// ---------------------------------------------------------------- Emitters
+//
+// Shorthands for `mcc_tac_builder_emit`, instructions computing a value
+// return their freshly allocated result variable.
+
+struct mcc_tac_variable mcc_tac_builder_const_int(struct mcc_tac_builder *builder, long value);
+
+struct mcc_tac_variable mcc_tac_builder_const_float(struct mcc_tac_builder *builder, double value);
+
+struct mcc_tac_variable mcc_tac_builder_const_bool(struct mcc_tac_builder *builder, bool value);
+
+// `value` must outlive the built function.
+struct mcc_tac_variable mcc_tac_builder_const_string(struct mcc_tac_builder *builder, const char *value);
+
+void mcc_tac_builder_assign(struct mcc_tac_builder *builder,
+                            struct mcc_tac_variable destination,
+                            struct mcc_tac_variable source);
+
+// `op` takes one argument, like MCC_TAC_OP_NEG, its result is of `type`.
+struct mcc_tac_variable mcc_tac_builder_unary(struct mcc_tac_builder *builder,
+                                              enum mcc_tac_op op,
+                                              enum mcc_tac_type type,
+                                              struct mcc_tac_variable operand);
+
+// `op` takes two arguments, like MCC_TAC_OP_ADD, its result is of `type`.
+struct mcc_tac_variable mcc_tac_builder_binary(struct mcc_tac_builder *builder,
+                                               enum mcc_tac_op op,
+                                               enum mcc_tac_type type,
+                                               struct mcc_tac_variable lhs,
+                                               struct mcc_tac_variable rhs);
+
+// `type` is the element type.
+struct mcc_tac_variable mcc_tac_builder_array(struct mcc_tac_builder *builder, enum mcc_tac_type type, long size);
+
+struct mcc_tac_variable mcc_tac_builder_load(struct mcc_tac_builder *builder,
+                                             enum mcc_tac_type type,
+                                             struct mcc_tac_variable array,
+                                             struct mcc_tac_variable index);
+
+void mcc_tac_builder_store(struct mcc_tac_builder *builder,
+                           struct mcc_tac_variable array,
+                           struct mcc_tac_variable index,
+                           struct mcc_tac_variable value);
+
+void mcc_tac_builder_place_label(struct mcc_tac_builder *builder, uint32_t label);
+
+void mcc_tac_builder_jump(struct mcc_tac_builder *builder, uint32_t label);
+
+// Jumps to `label` if `condition` equals `when`.
+void mcc_tac_builder_jump_if(struct mcc_tac_builder *builder,
+                             uint32_t label,
+                             struct mcc_tac_variable condition,
+                             bool when);
+
+// Defines parameter number `index`, counting from 0.
+struct mcc_tac_variable mcc_tac_builder_param(struct mcc_tac_builder *builder, enum mcc_tac_type type, uint32_t index);
+
+// `function` must outlive the built function. The result is unused for void
+// functions.
+struct mcc_tac_variable mcc_tac_builder_call(struct mcc_tac_builder *builder,
+                                             const char *function,
+                                             enum mcc_tac_type type,
+                                             const struct mcc_tac_variable *arguments,
+                                             size_t arguments_count);
+
+// Pass an unused variable to return from a void function.
+void mcc_tac_builder_return(struct mcc_tac_builder *builder, struct mcc_tac_variable value);
+
+#endif // MCC_TAC_BUILDER_H
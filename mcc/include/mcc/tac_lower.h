@@ -0,0 +1,36 @@
+// AST to TAC Lowering
+//
+// Translates a semantically checked program to three-address code. Lowering
+// relies on the annotations left by semantic analysis (resolved identifiers
+// and expression types) and does not modify the AST.
+//
+// Expressions are evaluated left to right into fresh temporaries; `if` and
+// `while` become conditional jumps around their bodies. Built-in functions
+// are not lowered, calls refer to them by name.
+//
+// Functions are lowered independently of each other, optionally on multiple
+// threads. The result does not depend on the number of threads.
+
+#ifndef MCC_TAC_LOWER_H
+#define MCC_TAC_LOWER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/ast.h"
+#include "mcc/tac.h"
+
+struct mcc_tac_lower_options {
+	// Number of threads lowering functions, 0 and 1 lower them on the calling
+	// thread.
+	size_t threads;
+};
+
+// Appends the lowered functions of `program` to `tac`, in source order.
+// `options` may be NULL. Returns false on allocation failure, `tac` must be
+// deinitialised anyway.
+bool mcc_tac_lower_program(struct mcc_tac_program *tac,
+                           struct mcc_ast_program *program,
+                           const struct mcc_tac_lower_options *options);
+
+#endif // MCC_TAC_LOWER_H
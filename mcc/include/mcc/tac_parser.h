@@ -0,0 +1,42 @@
+// TAC Parser
+//
+// Reads TAC in the textual form written by `mcc_tac_print_program`, so IR can
+// be stored, edited, and fed to the optimiser without going through the
+// front end. Besides printed programs, the parser accepts blank lines,
+// comments starting with '#', and arbitrary indentation.
+//
+// Variable types are not part of the text, they are inferred from the
+// instructions defining and using each variable. Variable numbers that do not
+// occur at all are given type int. The number of variables and labels of a
+// function is the highest one occurring in it.
+
+#ifndef MCC_TAC_PARSER_H
+#define MCC_TAC_PARSER_H
+
+#include <stdio.h>
+
+#include "mcc/tac.h"
+
+enum mcc_tac_parser_error {
+	MCC_TAC_PARSER_ERROR_NONE = 0,
+	MCC_TAC_PARSER_ERROR_PARSE_ERROR,
+	MCC_TAC_PARSER_ERROR_ALLOCATION_ERROR,
+	MCC_TAC_PARSER_ERROR_UNABLE_TO_OPEN_STREAM,
+};
+
+struct mcc_tac_parser_result {
+	enum mcc_tac_parser_error error;
+	char error_msg[1024];
+};
+
+void mcc_tac_parser_result_print_error(FILE *out, const struct mcc_tac_parser_result *result);
+
+// Appends the functions read from `input` to `program`, strings are interned
+// in the program's pool. On error, `program` may have received some of the
+// functions. `filepath` is only used for prefixing error messages and can be
+// NULL.
+struct mcc_tac_parser_result mcc_tac_parse_file(struct mcc_tac_program *program, FILE *input, const char *filepath);
+
+struct mcc_tac_parser_result mcc_tac_parse_string(struct mcc_tac_program *program, const char *input);
+
+#endif // MCC_TAC_PARSER_H
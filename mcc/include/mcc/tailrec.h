@@ -0,0 +1,36 @@
+// Tail Recursion Elimination
+//
+// A call of a function to itself is a tail call if the function returns its
+// result right away, possibly through copies and jumps. Such calls become a
+// loop: the arguments are copied to the parameters and the function jumps
+// back to its start, right after its PARAM instructions. The recursion then
+// runs in constant stack space and saves setting up a frame per call.
+//
+// Arguments are copied in parallel, an argument which is another parameter
+// is read before that parameter is assigned. Functions creating arrays are
+// left alone: each call has arrays of its own, a loop would reuse them.
+//
+// Calls of other functions whose result is returned right away are sibling
+// calls, which the JIT compiler turns into jumps, see mcc/jit.h.
+//
+// Functions must not be in SSA form.
+
+#ifndef MCC_TAILREC_H
+#define MCC_TAILREC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mcc/tac.h"
+
+struct mcc_tailrec_stats {
+	// Calls replaced by a jump.
+	size_t eliminated;
+};
+
+// Replaces tail calls of `function` to itself by jumps to its start. The
+// count is added to `stats` if not NULL. Returns false on allocation failure,
+// the function still computes the same then.
+bool mcc_tailrec_function(struct mcc_tac_function *function, struct mcc_tailrec_stats *stats);
+
+#endif // MCC_TAILREC_H
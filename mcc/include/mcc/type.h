@@ -0,0 +1,67 @@
+// Types
+//
+// mC knows the scalar types `bool`, `int`, `float`, and `string`, and one
+// dimensional arrays thereof. An array's size is part of its type. `void` is
+// only used as return type.
+//
+// Types are canonical, immutable objects: two types are equal iff they are
+// the same object, hence they are compared by pointer. Scalar types are
+// global constants, array types are interned in a type pool. Types from
+// different pools must not be mixed.
+//
+// Each type carries its size and alignment on the x86 target.
+
+#ifndef MCC_TYPE_H
+#define MCC_TYPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+enum mcc_type_kind {
+	MCC_TYPE_KIND_VOID,
+	MCC_TYPE_KIND_BOOL,
+	MCC_TYPE_KIND_INT,
+	MCC_TYPE_KIND_FLOAT,
+	MCC_TYPE_KIND_STRING,
+	MCC_TYPE_KIND_ARRAY,
+};
+
+struct mcc_type {
+	enum mcc_type_kind kind;
+
+	// MCC_TYPE_KIND_ARRAY, the element type is always scalar.
+	const struct mcc_type *element;
+	long array_size;
+
+	// In bytes. The size of huge arrays saturates at SIZE_MAX.
+	size_t size;
+	size_t alignment;
+};
+
+// Returns the canonical scalar type of the given kind, which must not be
+// MCC_TYPE_KIND_ARRAY.
+const struct mcc_type *mcc_type_scalar(enum mcc_type_kind kind);
+
+// Writes the type's spelling, like `int[10]`, to `buffer` and returns it.
+const char *mcc_type_to_string(const struct mcc_type *type, char *buffer, size_t size);
+
+// ----------------------------------------------------------------- Type Pool
+
+struct mcc_type_pool {
+	// Open addressing hash table of array types, empty slots are NULL.
+	// `capacity` is always zero or a power of two.
+	struct mcc_type **slots;
+	size_t count;
+	size_t capacity;
+};
+
+void mcc_type_pool_init(struct mcc_type_pool *pool);
+
+// Releases all types handed out by the pool.
+void mcc_type_pool_deinit(struct mcc_type_pool *pool);
+
+// Returns the canonical array type of `size` elements of the scalar type
+// `element`. NULL is returned on allocation failure.
+const struct mcc_type *mcc_type_pool_array(struct mcc_type_pool *pool, const struct mcc_type *element, long size);
+
+#endif // MCC_TYPE_H
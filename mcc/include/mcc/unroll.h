@@ -0,0 +1,65 @@
+// Loop Unrolling
+//
+// mC only has while loops, counted loops are written as
+//
+//     i = 0; while (i < n) { ...; i = i + 1; }
+//
+// A loop is counted if its header only tests its induction variable against
+// a bound, the body is a single block, the variable is assigned once in the
+// body by adding a constant step towards the bound, and the bound is not
+// assigned within the loop. The bound may be a constant or only known at
+// runtime.
+//
+// Such loops get an unrolled copy placed in front of them, running `factor`
+// copies of the body per test of the induction variable. It keeps running
+// while at least `factor` iterations remain, the original loop then runs the
+// remaining ones. Limits near the ends of the int range, where the test
+// would overflow, skip the unrolled copy. If the trip count is known and
+// less than the factor, the loop is left alone. The test of the unrolled
+// copy comes at its end, so it costs one branch per `factor` iterations.
+//
+// Variables assigned and only read within one iteration of the body are
+// renamed in each copy, so they remain temporaries.
+//
+// Functions must not be in SSA form.
+
+#ifndef MCC_UNROLL_H
+#define MCC_UNROLL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcc/tac.h"
+
+#define MCC_UNROLL_DEFAULT_FACTOR 4
+#define MCC_UNROLL_DEFAULT_BUDGET 64
+
+struct mcc_unroll_options {
+	// Copies of the body per iteration of the unrolled loop. Defaults to
+	// MCC_UNROLL_DEFAULT_FACTOR if 0.
+	uint32_t factor;
+
+	// Maximum number of instructions in the unrolled body, the factor is
+	// reduced to stay within it, loops not fitting twice are not unrolled.
+	// Defaults to MCC_UNROLL_DEFAULT_BUDGET if 0.
+	size_t budget;
+};
+
+struct mcc_unroll_stats {
+	// Loops given an unrolled copy.
+	size_t unrolled;
+
+	// Copies of loop bodies inserted.
+	size_t copies;
+};
+
+// Unrolls the counted loops of `function`, inserting preheaders where
+// needed. `options` may be NULL for the defaults. The counts are added to
+// `stats` if not NULL. Returns false on allocation failure, the function
+// still computes the same then.
+bool mcc_unroll_function(struct mcc_tac_function *function,
+                         const struct mcc_unroll_options *options,
+                         struct mcc_unroll_stats *stats);
+
+#endif // MCC_UNROLL_H
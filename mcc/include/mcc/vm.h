@@ -0,0 +1,108 @@
+// Bytecode Virtual Machine
+//
+// Executes TAC programs directly, without going through a native back end.
+// Functions are translated into a register-based bytecode: each TAC variable
+// becomes a register of the function's frame and instructions are specialised
+// by type. Common instruction pairs are fused into superinstructions:
+//
+//  - an arithmetic operation or comparison with a constant operand,
+//  - a comparison followed by a conditional jump on its result, and
+//  - an instruction followed by the assignment of its result to a variable.
+//
+// When compiled with GCC or Clang, dispatch is direct-threaded: every
+// bytecode instruction holds the address of its handler, which ends by
+// jumping to the handler of the next one. Other compilers, or defining
+// MCC_VM_SWITCH, fall back to a switch in a loop.
+//
+// The builtins of mC are provided natively, reading from and writing to the
+// streams given in the options. So are the runtime functions of memoisation,
+// with a table per call of mcc_vm_call. Runtime errors, like a division by
+// zero or an access outside the VM's stack, stop the execution and are
+// reported in the result. As in C, array indices are not checked against the
+// array's size.
+
+#ifndef MCC_VM_H
+#define MCC_VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "mcc/tac.h"
+
+// Stack size in registers used if none is given in the options.
+#define MCC_VM_DEFAULT_STACK_SIZE (1u << 20)
+
+// A register. Bools are stored as int 0 or 1, arrays as a pointer to their
+// first element, which lives on the VM's stack.
+union mcc_vm_value {
+	int32_t i;
+	float f;
+	const char *s;
+	union mcc_vm_value *a;
+};
+
+struct mcc_vm_function;
+
+struct mcc_vm {
+	// Compiled functions in the order of the program's functions.
+	struct mcc_vm_function *functions;
+	size_t functions_count;
+
+	// The program the functions were compiled from.
+	const struct mcc_tac_program *program;
+};
+
+enum mcc_vm_error {
+	MCC_VM_ERROR_NONE = 0,
+	MCC_VM_ERROR_ALLOCATION_ERROR,
+	MCC_VM_ERROR_INVALID_PROGRAM,
+	MCC_VM_ERROR_UNKNOWN_FUNCTION,
+	MCC_VM_ERROR_DIVISION_BY_ZERO,
+	MCC_VM_ERROR_INVALID_ACCESS,
+	MCC_VM_ERROR_STACK_OVERFLOW,
+	MCC_VM_ERROR_OUT_OF_FUEL,
+};
+
+struct mcc_vm_result {
+	enum mcc_vm_error error;
+	char error_msg[256];
+
+	// Value returned by the called function, zero for void functions.
+	union mcc_vm_value value;
+};
+
+struct mcc_vm_options {
+	// Streams used by the builtins, stdin and stdout if NULL.
+	FILE *in;
+	FILE *out;
+
+	// Number of registers available to all frames together. Defaults to
+	// MCC_VM_DEFAULT_STACK_SIZE if 0.
+	size_t stack_size;
+
+	// Execution is stopped with MCC_VM_ERROR_OUT_OF_FUEL when about to take
+	// the `fuel`th jump or make the `fuel`th call, which bounds the time taken
+	// by programs that may not terminate. Unlimited if 0.
+	size_t fuel;
+};
+
+void mcc_vm_result_print_error(FILE *out, const struct mcc_vm_result *result);
+
+// Compiles all functions of `program`, which has to stay alive and unchanged
+// while `vm` is used. Phis are not supported, SSA form has to be destructed
+// first. Calls are resolved to the program's functions and to the builtins.
+struct mcc_vm_result mcc_vm_compile(struct mcc_vm *vm, const struct mcc_tac_program *program);
+
+void mcc_vm_deinit(struct mcc_vm *vm);
+
+// Calls the function `name` with `arguments_count` arguments and runs it to
+// completion. Arrays cannot be passed, they have to live on the VM's stack.
+// `options` can be NULL.
+struct mcc_vm_result mcc_vm_call(const struct mcc_vm *vm,
+                                 const char *name,
+                                 const union mcc_vm_value *arguments,
+                                 size_t arguments_count,
+                                 const struct mcc_vm_options *options);
+
+#endif // MCC_VM_H
@@ -0,0 +1,63 @@
+// Growable Arrays
+//
+// Private helpers shared by the library for arrays growing by doubling their
+// capacity. The growth policy is fixed so the number of allocation calls can
+// be derived from an array's capacity afterwards.
+
+#ifndef MCC_ARRAY_H
+#define MCC_ARRAY_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MCC_ARRAY_INITIAL_CAPACITY 4
+
+// Ensures the array pointed to by `items_ptr` (a pointer to the array's
+// element pointer) can hold at least `count + 1` elements of `item_size`
+// bytes. Returns false on allocation failure, leaving the array untouched.
+//
+// The element pointer is accessed via `memcpy` to stay clear of strict
+// aliasing issues when called with arbitrary element types.
+static inline bool mcc_array_reserve(void *items_ptr, size_t *capacity, size_t count, size_t item_size)
+{
+	assert(items_ptr);
+	assert(capacity);
+
+	if (count < *capacity) {
+		return true;
+	}
+
+	void *items;
+	memcpy(&items, items_ptr, sizeof(items));
+
+	size_t new_capacity = *capacity ? *capacity * 2 : MCC_ARRAY_INITIAL_CAPACITY;
+	void *new_items = realloc(items, new_capacity * item_size);
+	if (!new_items) {
+		return false;
+	}
+
+	memcpy(items_ptr, &new_items, sizeof(new_items));
+	*capacity = new_capacity;
+	return true;
+}
+
+// Number of allocation calls `mcc_array_reserve` issued to reach `capacity`.
+static inline size_t mcc_array_allocations(size_t capacity)
+{
+	size_t allocations = 0;
+	for (size_t c = MCC_ARRAY_INITIAL_CAPACITY; c <= capacity; c *= 2) {
+		allocations++;
+	}
+	return allocations;
+}
+
+// Convenience wrapper, `array` and `capacity` are lvalues of the array's
+// element pointer and capacity.
+#define mcc_array_push(array, count, capacity, item) \
+	(mcc_array_reserve(&(array), &(capacity), (count), sizeof(*(array))) \
+	     ? ((array)[(count)++] = (item), true) \
+	     : false)
+
+#endif // MCC_ARRAY_H
@@ -3,6 +3,30 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include "array.h"
+
+// ---------------------------------------------------------------- Identifiers
+
+struct mcc_ast_identifier *mcc_ast_new_identifier(const char *name)
+{
+	assert(name);
+
+	struct mcc_ast_identifier *identifier = malloc(sizeof(*identifier));
+	if (!identifier) {
+		return NULL;
+	}
+
+	*identifier = (struct mcc_ast_identifier){
+	    .name = name,
+	};
+	return identifier;
+}
+
+void mcc_ast_delete_identifier(struct mcc_ast_identifier *identifier)
+{
+	free(identifier);
+}
+
 // ---------------------------------------------------------------- Expressions
 
 struct mcc_ast_expression *mcc_ast_new_expression_literal(struct mcc_ast_literal *literal)
@@ -58,6 +82,84 @@ struct mcc_ast_expression *mcc_ast_new_expression_parenth(struct mcc_ast_express
 	return expr;
 }
 
+struct mcc_ast_expression *mcc_ast_new_expression_unary_op(enum mcc_ast_unary_op op,
+                                                           struct mcc_ast_expression *operand)
+{
+	assert(operand);
+
+	struct mcc_ast_expression *expr = malloc(sizeof(*expr));
+	if (!expr) {
+		return NULL;
+	}
+
+	*expr = (struct mcc_ast_expression){
+	    .type = MCC_AST_EXPRESSION_TYPE_UNARY_OP,
+	    .unary_op = op,
+	    .operand = operand,
+	};
+	return expr;
+}
+
+struct mcc_ast_expression *mcc_ast_new_expression_identifier(struct mcc_ast_identifier *identifier)
+{
+	assert(identifier);
+
+	struct mcc_ast_expression *expr = malloc(sizeof(*expr));
+	if (!expr) {
+		return NULL;
+	}
+
+	*expr = (struct mcc_ast_expression){
+	    .type = MCC_AST_EXPRESSION_TYPE_IDENTIFIER,
+	    .identifier = identifier,
+	};
+	return expr;
+}
+
+struct mcc_ast_expression *mcc_ast_new_expression_array_element(struct mcc_ast_identifier *array,
+                                                                struct mcc_ast_expression *index)
+{
+	assert(array);
+	assert(index);
+
+	struct mcc_ast_expression *expr = malloc(sizeof(*expr));
+	if (!expr) {
+		return NULL;
+	}
+
+	*expr = (struct mcc_ast_expression){
+	    .type = MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT,
+	    .array = array,
+	    .index = index,
+	};
+	return expr;
+}
+
+struct mcc_ast_expression *mcc_ast_new_expression_call(struct mcc_ast_identifier *callee)
+{
+	assert(callee);
+
+	struct mcc_ast_expression *expr = malloc(sizeof(*expr));
+	if (!expr) {
+		return NULL;
+	}
+
+	*expr = (struct mcc_ast_expression){
+	    .type = MCC_AST_EXPRESSION_TYPE_CALL,
+	    .callee = callee,
+	};
+	return expr;
+}
+
+bool mcc_ast_add_argument(struct mcc_ast_expression *call, struct mcc_ast_expression *argument)
+{
+	assert(call);
+	assert(call->type == MCC_AST_EXPRESSION_TYPE_CALL);
+	assert(argument);
+
+	return mcc_array_push(call->arguments, call->arguments_count, call->arguments_capacity, argument);
+}
+
 void mcc_ast_delete_expression(struct mcc_ast_expression *expression)
 {
 	if (!expression) {
@@ -77,6 +179,27 @@ void mcc_ast_delete_expression(struct mcc_ast_expression *expression)
 	case MCC_AST_EXPRESSION_TYPE_PARENTH:
 		mcc_ast_delete_expression(expression->expression);
 		break;
+
+	case MCC_AST_EXPRESSION_TYPE_UNARY_OP:
+		mcc_ast_delete_expression(expression->operand);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_IDENTIFIER:
+		mcc_ast_delete_identifier(expression->identifier);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT:
+		mcc_ast_delete_identifier(expression->array);
+		mcc_ast_delete_expression(expression->index);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_CALL:
+		mcc_ast_delete_identifier(expression->callee);
+		for (size_t i = 0; i < expression->arguments_count; i++) {
+			mcc_ast_delete_expression(expression->arguments[i]);
+		}
+		free(expression->arguments);
+		break;
 	}
 
 	free(expression);
@@ -112,7 +235,378 @@ struct mcc_ast_literal *mcc_ast_new_literal_float(double value)
 	return lit;
 }
 
+struct mcc_ast_literal *mcc_ast_new_literal_bool(bool value)
+{
+	struct mcc_ast_literal *lit = malloc(sizeof(*lit));
+	if (!lit) {
+		return NULL;
+	}
+
+	*lit = (struct mcc_ast_literal){
+	    .type = MCC_AST_LITERAL_TYPE_BOOL,
+	    .b_value = value,
+	};
+	return lit;
+}
+
+struct mcc_ast_literal *mcc_ast_new_literal_string(const char *value)
+{
+	assert(value);
+
+	struct mcc_ast_literal *lit = malloc(sizeof(*lit));
+	if (!lit) {
+		return NULL;
+	}
+
+	*lit = (struct mcc_ast_literal){
+	    .type = MCC_AST_LITERAL_TYPE_STRING,
+	    .s_value = value,
+	};
+	return lit;
+}
+
 void mcc_ast_delete_literal(struct mcc_ast_literal *literal)
 {
 	free(literal);
 }
+
+// --------------------------------------------------------------- Declarations
+
+struct mcc_ast_declaration *mcc_ast_new_declaration(enum mcc_ast_data_type data_type,
+                                                    struct mcc_ast_identifier *identifier)
+{
+	assert(identifier);
+
+	struct mcc_ast_declaration *decl = malloc(sizeof(*decl));
+	if (!decl) {
+		return NULL;
+	}
+
+	*decl = (struct mcc_ast_declaration){
+	    .data_type = data_type,
+	    .identifier = identifier,
+	};
+	return decl;
+}
+
+struct mcc_ast_declaration *mcc_ast_new_declaration_array(enum mcc_ast_data_type data_type,
+                                                          long array_size,
+                                                          struct mcc_ast_identifier *identifier)
+{
+	struct mcc_ast_declaration *decl = mcc_ast_new_declaration(data_type, identifier);
+	if (!decl) {
+		return NULL;
+	}
+
+	decl->is_array = true;
+	decl->array_size = array_size;
+	return decl;
+}
+
+void mcc_ast_delete_declaration(struct mcc_ast_declaration *declaration)
+{
+	if (!declaration) {
+		return;
+	}
+
+	mcc_ast_delete_identifier(declaration->identifier);
+	free(declaration);
+}
+
+// ---------------------------------------------------------------- Assignments
+
+struct mcc_ast_assignment *mcc_ast_new_assignment(struct mcc_ast_identifier *identifier,
+                                                  struct mcc_ast_expression *index,
+                                                  struct mcc_ast_expression *rhs)
+{
+	assert(identifier);
+	assert(rhs);
+
+	struct mcc_ast_assignment *assignment = malloc(sizeof(*assignment));
+	if (!assignment) {
+		return NULL;
+	}
+
+	*assignment = (struct mcc_ast_assignment){
+	    .identifier = identifier,
+	    .index = index,
+	    .rhs = rhs,
+	};
+	return assignment;
+}
+
+void mcc_ast_delete_assignment(struct mcc_ast_assignment *assignment)
+{
+	if (!assignment) {
+		return;
+	}
+
+	mcc_ast_delete_identifier(assignment->identifier);
+	mcc_ast_delete_expression(assignment->index);
+	mcc_ast_delete_expression(assignment->rhs);
+	free(assignment);
+}
+
+// ----------------------------------------------------------------- Statements
+
+struct mcc_ast_statement *mcc_ast_new_statement_if(struct mcc_ast_expression *condition,
+                                                   struct mcc_ast_statement *on_true,
+                                                   struct mcc_ast_statement *on_false)
+{
+	assert(condition);
+	assert(on_true);
+
+	struct mcc_ast_statement *stmt = malloc(sizeof(*stmt));
+	if (!stmt) {
+		return NULL;
+	}
+
+	*stmt = (struct mcc_ast_statement){
+	    .type = MCC_AST_STATEMENT_TYPE_IF,
+	    .if_condition = condition,
+	    .if_on_true = on_true,
+	    .if_on_false = on_false,
+	};
+	return stmt;
+}
+
+struct mcc_ast_statement *mcc_ast_new_statement_while(struct mcc_ast_expression *condition,
+                                                      struct mcc_ast_statement *body)
+{
+	assert(condition);
+	assert(body);
+
+	struct mcc_ast_statement *stmt = malloc(sizeof(*stmt));
+	if (!stmt) {
+		return NULL;
+	}
+
+	*stmt = (struct mcc_ast_statement){
+	    .type = MCC_AST_STATEMENT_TYPE_WHILE,
+	    .while_condition = condition,
+	    .while_body = body,
+	};
+	return stmt;
+}
+
+struct mcc_ast_statement *mcc_ast_new_statement_return(struct mcc_ast_expression *value)
+{
+	struct mcc_ast_statement *stmt = malloc(sizeof(*stmt));
+	if (!stmt) {
+		return NULL;
+	}
+
+	*stmt = (struct mcc_ast_statement){
+	    .type = MCC_AST_STATEMENT_TYPE_RETURN,
+	    .return_value = value,
+	};
+	return stmt;
+}
+
+struct mcc_ast_statement *mcc_ast_new_statement_declaration(struct mcc_ast_declaration *declaration)
+{
+	assert(declaration);
+
+	struct mcc_ast_statement *stmt = malloc(sizeof(*stmt));
+	if (!stmt) {
+		return NULL;
+	}
+
+	*stmt = (struct mcc_ast_statement){
+	    .type = MCC_AST_STATEMENT_TYPE_DECLARATION,
+	    .declaration = declaration,
+	};
+	return stmt;
+}
+
+struct mcc_ast_statement *mcc_ast_new_statement_assignment(struct mcc_ast_assignment *assignment)
+{
+	assert(assignment);
+
+	struct mcc_ast_statement *stmt = malloc(sizeof(*stmt));
+	if (!stmt) {
+		return NULL;
+	}
+
+	*stmt = (struct mcc_ast_statement){
+	    .type = MCC_AST_STATEMENT_TYPE_ASSIGNMENT,
+	    .assignment = assignment,
+	};
+	return stmt;
+}
+
+struct mcc_ast_statement *mcc_ast_new_statement_expression(struct mcc_ast_expression *expression)
+{
+	assert(expression);
+
+	struct mcc_ast_statement *stmt = malloc(sizeof(*stmt));
+	if (!stmt) {
+		return NULL;
+	}
+
+	*stmt = (struct mcc_ast_statement){
+	    .type = MCC_AST_STATEMENT_TYPE_EXPRESSION,
+	    .expression = expression,
+	};
+	return stmt;
+}
+
+struct mcc_ast_statement *mcc_ast_new_statement_compound(void)
+{
+	struct mcc_ast_statement *stmt = malloc(sizeof(*stmt));
+	if (!stmt) {
+		return NULL;
+	}
+
+	*stmt = (struct mcc_ast_statement){
+	    .type = MCC_AST_STATEMENT_TYPE_COMPOUND,
+	};
+	return stmt;
+}
+
+bool mcc_ast_add_statement(struct mcc_ast_statement *compound, struct mcc_ast_statement *statement)
+{
+	assert(compound);
+	assert(compound->type == MCC_AST_STATEMENT_TYPE_COMPOUND);
+	assert(statement);
+
+	return mcc_array_push(compound->statements, compound->statements_count, compound->statements_capacity,
+	                      statement);
+}
+
+void mcc_ast_delete_statement(struct mcc_ast_statement *statement)
+{
+	if (!statement) {
+		return;
+	}
+
+	switch (statement->type) {
+	case MCC_AST_STATEMENT_TYPE_IF:
+		mcc_ast_delete_expression(statement->if_condition);
+		mcc_ast_delete_statement(statement->if_on_true);
+		mcc_ast_delete_statement(statement->if_on_false);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_WHILE:
+		mcc_ast_delete_expression(statement->while_condition);
+		mcc_ast_delete_statement(statement->while_body);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_RETURN:
+		mcc_ast_delete_expression(statement->return_value);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_DECLARATION:
+		mcc_ast_delete_declaration(statement->declaration);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_ASSIGNMENT:
+		mcc_ast_delete_assignment(statement->assignment);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_EXPRESSION:
+		mcc_ast_delete_expression(statement->expression);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_COMPOUND:
+		for (size_t i = 0; i < statement->statements_count; i++) {
+			mcc_ast_delete_statement(statement->statements[i]);
+		}
+		free(statement->statements);
+		break;
+	}
+
+	free(statement);
+}
+
+// ------------------------------------------------------------------ Functions
+
+struct mcc_ast_function *mcc_ast_new_function(enum mcc_ast_data_type return_type,
+                                              struct mcc_ast_identifier *identifier)
+{
+	assert(identifier);
+
+	struct mcc_ast_function *function = malloc(sizeof(*function));
+	if (!function) {
+		return NULL;
+	}
+
+	*function = (struct mcc_ast_function){
+	    .return_type = return_type,
+	    .identifier = identifier,
+	};
+	return function;
+}
+
+bool mcc_ast_add_parameter(struct mcc_ast_function *function, struct mcc_ast_declaration *parameter)
+{
+	assert(function);
+	assert(parameter);
+
+	return mcc_array_push(function->parameters, function->parameters_count, function->parameters_capacity,
+	                      parameter);
+}
+
+void mcc_ast_delete_function(struct mcc_ast_function *function)
+{
+	if (!function) {
+		return;
+	}
+
+	mcc_ast_delete_identifier(function->identifier);
+	for (size_t i = 0; i < function->parameters_count; i++) {
+		mcc_ast_delete_declaration(function->parameters[i]);
+	}
+	free(function->parameters);
+	mcc_ast_delete_statement(function->body);
+	free(function);
+}
+
+// -------------------------------------------------------------------- Program
+
+struct mcc_ast_program *mcc_ast_new_program(void)
+{
+	struct mcc_ast_program *program = malloc(sizeof(*program));
+	if (!program) {
+		return NULL;
+	}
+
+	*program = (struct mcc_ast_program){0};
+	mcc_string_pool_init(&program->strings);
+	return program;
+}
+
+bool mcc_ast_add_function(struct mcc_ast_program *program, struct mcc_ast_function *function)
+{
+	assert(program);
+	assert(function);
+
+	return mcc_array_push(program->functions, program->functions_count, program->functions_capacity, function);
+}
+
+bool mcc_ast_add_builtin(struct mcc_ast_program *program, struct mcc_ast_function *function)
+{
+	assert(program);
+	assert(function);
+
+	return mcc_array_push(program->builtins, program->builtins_count, program->builtins_capacity, function);
+}
+
+void mcc_ast_delete_program(struct mcc_ast_program *program)
+{
+	if (!program) {
+		return;
+	}
+
+	for (size_t i = 0; i < program->functions_count; i++) {
+		mcc_ast_delete_function(program->functions[i]);
+	}
+	free(program->functions);
+	for (size_t i = 0; i < program->builtins_count; i++) {
+		mcc_ast_delete_function(program->builtins[i]);
+	}
+	free(program->builtins);
+	mcc_string_pool_deinit(&program->strings);
+	mcc_type_pool_deinit(&program->types);
+	free(program);
+}
@@ -2,7 +2,19 @@
 
 #include <assert.h>
 
-#include "mcc/ast_visit.h"
+#include "print_buffer.h"
+
+const char *mcc_ast_print_unary_op(enum mcc_ast_unary_op op)
+{
+	switch (op) {
+	case MCC_AST_UNARY_OP_NEG:
+		return "-";
+	case MCC_AST_UNARY_OP_NOT:
+		return "!";
+	}
+
+	return "unknown op";
+}
 
 const char *mcc_ast_print_binary_op(enum mcc_ast_binary_op op)
 {
@@ -15,149 +27,603 @@ const char *mcc_ast_print_binary_op(enum mcc_ast_binary_op op)
 		return "*";
 	case MCC_AST_BINARY_OP_DIV:
 		return "/";
+	case MCC_AST_BINARY_OP_LT:
+		return "<";
+	case MCC_AST_BINARY_OP_GT:
+		return ">";
+	case MCC_AST_BINARY_OP_LE:
+		return "<=";
+	case MCC_AST_BINARY_OP_GE:
+		return ">=";
+	case MCC_AST_BINARY_OP_AND:
+		return "&&";
+	case MCC_AST_BINARY_OP_OR:
+		return "||";
+	case MCC_AST_BINARY_OP_EQ:
+		return "==";
+	case MCC_AST_BINARY_OP_NE:
+		return "!=";
 	}
 
 	return "unknown op";
 }
 
-// ---------------------------------------------------------------- DOT Printer
+const char *mcc_ast_print_data_type(enum mcc_ast_data_type type)
+{
+	switch (type) {
+	case MCC_AST_DATA_TYPE_VOID:
+		return "void";
+	case MCC_AST_DATA_TYPE_BOOL:
+		return "bool";
+	case MCC_AST_DATA_TYPE_INT:
+		return "int";
+	case MCC_AST_DATA_TYPE_FLOAT:
+		return "float";
+	case MCC_AST_DATA_TYPE_STRING:
+		return "string";
+	}
+
+	return "unknown type";
+}
+
+// -------------------------------------------------------------------- Printer
+
+struct printer {
+	enum mcc_ast_print_format format;
+	unsigned max_depth;
+
+	size_t next_id;
 
-#define LABEL_SIZE 64
+	struct mcc_print_buffer buffer;
+};
 
-static void print_dot_begin(FILE *out)
+struct node {
+	size_t id;
+	unsigned depth;
+	size_t children;
+};
+
+static void printer_init(struct printer *printer, FILE *out, const struct mcc_ast_print_options *options)
 {
+	assert(printer);
 	assert(out);
 
-	fprintf(out, "digraph \"AST\" {\n"
-	             "\tnodesep=0.6\n");
+	printer->format = options ? options->format : MCC_AST_PRINT_FORMAT_DOT;
+	printer->max_depth = options ? options->max_depth : 0;
+	printer->next_id = 0;
+	mcc_print_buffer_init(&printer->buffer, out);
 }
 
-static void print_dot_end(FILE *out)
+static void put(struct printer *printer, const char *s)
 {
-	assert(out);
+	mcc_print_buffer_put_string(&printer->buffer, s);
+}
 
-	fprintf(out, "}\n");
+// The escape sequences used below are valid in DOT, JSON, and S-expression
+// strings alike.
+static void put_escaped(struct printer *printer, const char *s)
+{
+	for (; *s; s++) {
+		switch (*s) {
+		case '"':
+			put(printer, "\\\"");
+			break;
+		case '\\':
+			put(printer, "\\\\");
+			break;
+		case '\n':
+			put(printer, "\\n");
+			break;
+		case '\t':
+			put(printer, "\\t");
+			break;
+		default:
+			mcc_print_buffer_put_char(&printer->buffer, *s);
+		}
+	}
 }
 
-static void print_dot_node(FILE *out, const void *node, const char *label)
+// A node's label; `quoted` labels (string literals) are surrounded by quotes.
+struct label {
+	const char *text;
+	bool quoted;
+};
+
+static void put_label(struct printer *printer, struct label label)
 {
-	assert(out);
+	if (label.quoted) {
+		put(printer, "\\\"");
+	}
+	put_escaped(printer, label.text);
+	if (label.quoted) {
+		put(printer, "\\\"");
+	}
+}
+
+static void begin(struct printer *printer)
+{
+	if (printer->format == MCC_AST_PRINT_FORMAT_DOT) {
+		put(printer, "digraph \"AST\" {\n"
+		             "\tnodesep=0.6\n"
+		             "\tnode [shape=box];\n");
+	}
+}
+
+static bool end(struct printer *printer)
+{
+	put(printer, printer->format == MCC_AST_PRINT_FORMAT_DOT ? "}\n" : "\n");
+	return mcc_print_buffer_flush(&printer->buffer) && fflush(printer->buffer.out) == 0;
+}
+
+// Emits the part of a node preceding its children and attaches it to
+// `parent` via `edge`. The root has no parent. Returns false if the depth
+// limit is exceeded, a placeholder is emitted instead and the node must
+// neither get children nor be closed.
+static bool open_node(struct printer *printer,
+                      struct node *parent,
+                      const char *edge,
+                      struct node *node,
+                      const char *kind,
+                      struct label label)
+{
+	assert(printer);
 	assert(node);
-	assert(label);
+	assert(kind);
+	assert(!parent || edge);
+
+	*node = (struct node){
+	    .id = printer->next_id++,
+	    .depth = parent ? parent->depth + 1 : 0,
+	};
 
-	fprintf(out, "\t\"%p\" [shape=box, label=\"%s\"];\n", node, label);
+	bool truncated = printer->max_depth && node->depth > printer->max_depth;
+	if (truncated) {
+		kind = "...";
+		label.text = NULL;
+	}
+
+	switch (printer->format) {
+	case MCC_AST_PRINT_FORMAT_DOT:
+		put(printer, "\t");
+		mcc_print_buffer_put_unsigned(&printer->buffer, node->id);
+		put(printer, " [label=\"");
+		put_escaped(printer, kind);
+		if (label.text) {
+			put(printer, ": ");
+			put_label(printer, label);
+		}
+		put(printer, "\"];\n");
+
+		if (parent) {
+			put(printer, "\t");
+			mcc_print_buffer_put_unsigned(&printer->buffer, parent->id);
+			put(printer, " -> ");
+			mcc_print_buffer_put_unsigned(&printer->buffer, node->id);
+			put(printer, " [label=\"");
+			put_escaped(printer, edge);
+			put(printer, "\"];\n");
+		}
+		break;
+
+	case MCC_AST_PRINT_FORMAT_JSON:
+		if (parent) {
+			put(printer, parent->children == 0 ? ",\"children\":[" : ",");
+		}
+		put(printer, "{\"id\":");
+		mcc_print_buffer_put_unsigned(&printer->buffer, node->id);
+		if (parent) {
+			put(printer, ",\"edge\":\"");
+			put_escaped(printer, edge);
+			put(printer, "\"");
+		}
+		put(printer, ",\"kind\":\"");
+		put_escaped(printer, kind);
+		put(printer, "\"");
+		if (label.text) {
+			put(printer, ",\"label\":\"");
+			put_label(printer, label);
+			put(printer, "\"");
+		}
+		if (truncated) {
+			put(printer, "}");
+		}
+		break;
+
+	case MCC_AST_PRINT_FORMAT_SEXPR:
+		if (parent) {
+			put(printer, " :");
+			put(printer, edge);
+			put(printer, " ");
+		}
+		if (truncated) {
+			put(printer, "...");
+			break;
+		}
+		put(printer, "(");
+		put(printer, kind);
+		if (label.text) {
+			put(printer, " \"");
+			put_label(printer, label);
+			put(printer, "\"");
+		}
+		break;
+	}
+
+	if (parent) {
+		parent->children++;
+	}
+
+	return !truncated;
 }
 
-static void print_dot_edge(FILE *out, const void *src_node, const void *dst_node, const char *label)
+static void close_node(struct printer *printer, struct node *node)
 {
-	assert(out);
-	assert(src_node);
-	assert(dst_node);
-	assert(label);
+	assert(printer);
+	assert(node);
+
+	switch (printer->format) {
+	case MCC_AST_PRINT_FORMAT_DOT:
+		break;
+
+	case MCC_AST_PRINT_FORMAT_JSON:
+		put(printer, node->children ? "]}" : "}");
+		break;
+
+	case MCC_AST_PRINT_FORMAT_SEXPR:
+		put(printer, ")");
+		break;
+	}
+}
+
+static const struct label no_label = {0};
 
-	fprintf(out, "\t\"%p\" -> \"%p\" [label=\"%s\"];\n", src_node, dst_node, label);
+static struct label plain(const char *text)
+{
+	return (struct label){.text = text};
 }
 
-static void print_dot_expression_literal(struct mcc_ast_expression *expression, void *data)
+// Children of a node's child array are attached via their index.
+#define INDEX_EDGE_SIZE (MCC_PRINT_BUFFER_INTEGER_SIZE + 1)
+
+static const char *index_edge(char edge[INDEX_EDGE_SIZE], size_t index)
 {
-	assert(expression);
-	assert(data);
+	char *p = mcc_print_buffer_format_unsigned(edge, index);
+	edge[INDEX_EDGE_SIZE - 1] = '\0';
+	return p;
+}
 
-	FILE *out = data;
-	print_dot_node(out, expression, "expr: lit");
-	print_dot_edge(out, expression, expression->literal, "literal");
+static void print_identifier(struct printer *printer,
+                             struct node *parent,
+                             const char *edge,
+                             struct mcc_ast_identifier *identifier)
+{
+	assert(identifier);
+
+	struct node node;
+	if (open_node(printer, parent, edge, &node, "ident", plain(identifier->name))) {
+		close_node(printer, &node);
+	}
 }
 
-static void print_dot_expression_binary_op(struct mcc_ast_expression *expression, void *data)
+static void print_literal(struct printer *printer,
+                          struct node *parent,
+                          const char *edge,
+                          struct mcc_ast_literal *literal)
 {
-	assert(expression);
-	assert(data);
+	assert(literal);
 
-	char label[LABEL_SIZE] = {0};
-	snprintf(label, sizeof(label), "expr: %s", mcc_ast_print_binary_op(expression->op));
+	// Large enough for any integer and for doubles in %g notation.
+	char text[32];
+	struct label label = plain(text);
+
+	switch (literal->type) {
+	case MCC_AST_LITERAL_TYPE_INT:
+		label.text = mcc_print_buffer_format_unsigned(text, literal->i_value);
+		text[MCC_PRINT_BUFFER_INTEGER_SIZE] = '\0';
+		break;
+	case MCC_AST_LITERAL_TYPE_FLOAT:
+		snprintf(text, sizeof(text), "%g", literal->f_value);
+		break;
+	case MCC_AST_LITERAL_TYPE_BOOL:
+		label.text = literal->b_value ? "true" : "false";
+		break;
+	case MCC_AST_LITERAL_TYPE_STRING:
+		label = (struct label){.text = literal->s_value, .quoted = true};
+		break;
+	}
 
-	FILE *out = data;
-	print_dot_node(out, expression, label);
-	print_dot_edge(out, expression, expression->lhs, "lhs");
-	print_dot_edge(out, expression, expression->rhs, "rhs");
+	struct node node;
+	if (open_node(printer, parent, edge, &node, "lit", label)) {
+		close_node(printer, &node);
+	}
 }
 
-static void print_dot_expression_parenth(struct mcc_ast_expression *expression, void *data)
+static void print_expression(struct printer *printer,
+                             struct node *parent,
+                             const char *edge,
+                             struct mcc_ast_expression *expression)
 {
 	assert(expression);
-	assert(data);
 
-	FILE *out = data;
-	print_dot_node(out, expression, "( )");
-	print_dot_edge(out, expression, expression->expression, "expression");
+	struct node node;
+
+	switch (expression->type) {
+	case MCC_AST_EXPRESSION_TYPE_LITERAL:
+		if (!open_node(printer, parent, edge, &node, "expr", no_label)) {
+			return;
+		}
+		print_literal(printer, &node, "literal", expression->literal);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_BINARY_OP:
+		if (!open_node(printer, parent, edge, &node, "expr", plain(mcc_ast_print_binary_op(expression->op)))) {
+			return;
+		}
+		print_expression(printer, &node, "lhs", expression->lhs);
+		print_expression(printer, &node, "rhs", expression->rhs);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_PARENTH:
+		if (!open_node(printer, parent, edge, &node, "expr", plain("( )"))) {
+			return;
+		}
+		print_expression(printer, &node, "expression", expression->expression);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_UNARY_OP:
+		if (!open_node(printer, parent, edge, &node, "expr",
+		               plain(mcc_ast_print_unary_op(expression->unary_op)))) {
+			return;
+		}
+		print_expression(printer, &node, "operand", expression->operand);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_IDENTIFIER:
+		if (!open_node(printer, parent, edge, &node, "expr", no_label)) {
+			return;
+		}
+		print_identifier(printer, &node, "identifier", expression->identifier);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT:
+		if (!open_node(printer, parent, edge, &node, "expr", plain("[ ]"))) {
+			return;
+		}
+		print_identifier(printer, &node, "array", expression->array);
+		print_expression(printer, &node, "index", expression->index);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_CALL:
+		if (!open_node(printer, parent, edge, &node, "expr", plain("call"))) {
+			return;
+		}
+		print_identifier(printer, &node, "callee", expression->callee);
+		for (size_t i = 0; i < expression->arguments_count; i++) {
+			char index[INDEX_EDGE_SIZE];
+			print_expression(printer, &node, index_edge(index, i), expression->arguments[i]);
+		}
+		break;
+	}
+
+	close_node(printer, &node);
 }
 
-static void print_dot_literal_int(struct mcc_ast_literal *literal, void *data)
+static void print_declaration(struct printer *printer,
+                              struct node *parent,
+                              const char *edge,
+                              struct mcc_ast_declaration *declaration)
 {
-	assert(literal);
-	assert(data);
+	assert(declaration);
+
+	char text[32];
+	if (declaration->is_array) {
+		snprintf(text, sizeof(text), "%s[%ld]", mcc_ast_print_data_type(declaration->data_type),
+		         declaration->array_size);
+	} else {
+		snprintf(text, sizeof(text), "%s", mcc_ast_print_data_type(declaration->data_type));
+	}
+
+	struct node node;
+	if (!open_node(printer, parent, edge, &node, "decl", plain(text))) {
+		return;
+	}
+	print_identifier(printer, &node, "identifier", declaration->identifier);
+	close_node(printer, &node);
+}
 
-	char label[LABEL_SIZE] = {0};
-	snprintf(label, sizeof(label), "%ld", literal->i_value);
+static void print_assignment(struct printer *printer,
+                             struct node *parent,
+                             const char *edge,
+                             struct mcc_ast_assignment *assignment)
+{
+	assert(assignment);
 
-	FILE *out = data;
-	print_dot_node(out, literal, label);
+	struct node node;
+	if (!open_node(printer, parent, edge, &node, "assign", no_label)) {
+		return;
+	}
+	print_identifier(printer, &node, "identifier", assignment->identifier);
+	if (assignment->index) {
+		print_expression(printer, &node, "index", assignment->index);
+	}
+	print_expression(printer, &node, "rhs", assignment->rhs);
+	close_node(printer, &node);
 }
 
-static void print_dot_literal_float(struct mcc_ast_literal *literal, void *data)
+static void print_statement(struct printer *printer,
+                            struct node *parent,
+                            const char *edge,
+                            struct mcc_ast_statement *statement)
 {
-	assert(literal);
-	assert(data);
+	assert(statement);
+
+	struct node node;
+
+	switch (statement->type) {
+	case MCC_AST_STATEMENT_TYPE_IF:
+		if (!open_node(printer, parent, edge, &node, "if", no_label)) {
+			return;
+		}
+		print_expression(printer, &node, "condition", statement->if_condition);
+		print_statement(printer, &node, "on_true", statement->if_on_true);
+		if (statement->if_on_false) {
+			print_statement(printer, &node, "on_false", statement->if_on_false);
+		}
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_WHILE:
+		if (!open_node(printer, parent, edge, &node, "while", no_label)) {
+			return;
+		}
+		print_expression(printer, &node, "condition", statement->while_condition);
+		print_statement(printer, &node, "body", statement->while_body);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_RETURN:
+		if (!open_node(printer, parent, edge, &node, "return", no_label)) {
+			return;
+		}
+		if (statement->return_value) {
+			print_expression(printer, &node, "value", statement->return_value);
+		}
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_DECLARATION:
+		if (!open_node(printer, parent, edge, &node, "stmt", plain("decl"))) {
+			return;
+		}
+		print_declaration(printer, &node, "declaration", statement->declaration);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_ASSIGNMENT:
+		if (!open_node(printer, parent, edge, &node, "stmt", plain("assign"))) {
+			return;
+		}
+		print_assignment(printer, &node, "assignment", statement->assignment);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_EXPRESSION:
+		if (!open_node(printer, parent, edge, &node, "stmt", plain("expr"))) {
+			return;
+		}
+		print_expression(printer, &node, "expression", statement->expression);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_COMPOUND:
+		if (!open_node(printer, parent, edge, &node, "compound", no_label)) {
+			return;
+		}
+		for (size_t i = 0; i < statement->statements_count; i++) {
+			char index[INDEX_EDGE_SIZE];
+			print_statement(printer, &node, index_edge(index, i), statement->statements[i]);
+		}
+		break;
+	}
+
+	close_node(printer, &node);
+}
+
+static void print_function(struct printer *printer,
+                           struct node *parent,
+                           const char *edge,
+                           struct mcc_ast_function *function)
+{
+	assert(function);
+
+	struct node node;
+	if (!open_node(printer, parent, edge, &node, "function",
+	               plain(mcc_ast_print_data_type(function->return_type)))) {
+		return;
+	}
+	print_identifier(printer, &node, "identifier", function->identifier);
+	for (size_t i = 0; i < function->parameters_count; i++) {
+		char index[INDEX_EDGE_SIZE];
+		print_declaration(printer, &node, index_edge(index, i), function->parameters[i]);
+	}
+	print_statement(printer, &node, "body", function->body);
+	close_node(printer, &node);
+}
+
+static void print_program(struct printer *printer, struct mcc_ast_program *program)
+{
+	assert(program);
+
+	struct node node;
+	open_node(printer, NULL, NULL, &node, "program", no_label);
+	for (size_t i = 0; i < program->functions_count; i++) {
+		char index[INDEX_EDGE_SIZE];
+		print_function(printer, &node, index_edge(index, i), program->functions[i]);
+	}
+	close_node(printer, &node);
+}
+
+bool mcc_ast_print_program(FILE *out, struct mcc_ast_program *program, const struct mcc_ast_print_options *options)
+{
+	assert(out);
+	assert(program);
 
-	char label[LABEL_SIZE] = {0};
-	snprintf(label, sizeof(label), "%f", literal->f_value);
+	struct printer printer;
+	printer_init(&printer, out, options);
 
-	FILE *out = data;
-	print_dot_node(out, literal, label);
+	begin(&printer);
+	print_program(&printer, program);
+	return end(&printer);
 }
 
-// Setup an AST Visitor for printing.
-static struct mcc_ast_visitor print_dot_visitor(FILE *out)
+bool mcc_ast_print_function(FILE *out,
+                            struct mcc_ast_function *function,
+                            const struct mcc_ast_print_options *options)
 {
 	assert(out);
+	assert(function);
+
+	struct printer printer;
+	printer_init(&printer, out, options);
 
-	return (struct mcc_ast_visitor){
-	    .traversal = MCC_AST_VISIT_DEPTH_FIRST,
-	    .order = MCC_AST_VISIT_PRE_ORDER,
+	begin(&printer);
+	print_function(&printer, NULL, NULL, function);
+	return end(&printer);
+}
 
-	    .userdata = out,
+bool mcc_ast_print_statement(FILE *out,
+                             struct mcc_ast_statement *statement,
+                             const struct mcc_ast_print_options *options)
+{
+	assert(out);
+	assert(statement);
 
-	    .expression_literal = print_dot_expression_literal,
-	    .expression_binary_op = print_dot_expression_binary_op,
-	    .expression_parenth = print_dot_expression_parenth,
+	struct printer printer;
+	printer_init(&printer, out, options);
 
-	    .literal_int = print_dot_literal_int,
-	    .literal_float = print_dot_literal_float,
-	};
+	begin(&printer);
+	print_statement(&printer, NULL, NULL, statement);
+	return end(&printer);
 }
 
-void mcc_ast_print_dot_expression(FILE *out, struct mcc_ast_expression *expression)
+bool mcc_ast_print_expression(FILE *out,
+                              struct mcc_ast_expression *expression,
+                              const struct mcc_ast_print_options *options)
 {
 	assert(out);
 	assert(expression);
 
-	print_dot_begin(out);
-
-	struct mcc_ast_visitor visitor = print_dot_visitor(out);
-	mcc_ast_visit_expression(expression, &visitor);
+	struct printer printer;
+	printer_init(&printer, out, options);
 
-	print_dot_end(out);
+	begin(&printer);
+	print_expression(&printer, NULL, NULL, expression);
+	return end(&printer);
 }
 
-void mcc_ast_print_dot_literal(FILE *out, struct mcc_ast_literal *literal)
+bool mcc_ast_print_literal(FILE *out, struct mcc_ast_literal *literal, const struct mcc_ast_print_options *options)
 {
 	assert(out);
 	assert(literal);
 
-	print_dot_begin(out);
-
-	struct mcc_ast_visitor visitor = print_dot_visitor(out);
-	mcc_ast_visit_literal(literal, &visitor);
+	struct printer printer;
+	printer_init(&printer, out, options);
 
-	print_dot_end(out);
+	begin(&printer);
+	print_literal(&printer, NULL, NULL, literal);
+	return end(&printer);
 }
@@ -0,0 +1,175 @@
+#include "mcc/ast_stats.h"
+
+#include <assert.h>
+
+#include "array.h"
+#include "mcc/ast_visit.h"
+
+static void add_node(struct mcc_ast_stats *stats, enum mcc_ast_stats_kind kind, size_t size)
+{
+	assert(stats);
+
+	stats->kinds[kind].count++;
+	stats->kinds[kind].bytes += size;
+	stats->kinds[kind].allocations++;
+}
+
+// Child arrays are only allocated once the first element is added.
+static void add_array(struct mcc_ast_stats *stats, size_t capacity, size_t item_size)
+{
+	assert(stats);
+
+	if (capacity == 0) {
+		return;
+	}
+
+	stats->kinds[MCC_AST_STATS_KIND_ARRAY].count++;
+	stats->kinds[MCC_AST_STATS_KIND_ARRAY].bytes += capacity * item_size;
+	stats->kinds[MCC_AST_STATS_KIND_ARRAY].allocations += mcc_array_allocations(capacity);
+}
+
+static void stats_identifier(struct mcc_ast_identifier *identifier, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_IDENTIFIER, sizeof(*identifier));
+}
+
+static void stats_expression(struct mcc_ast_expression *expression, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_EXPRESSION, sizeof(*expression));
+}
+
+static void stats_expression_call(struct mcc_ast_expression *expression, void *data)
+{
+	add_array(data, expression->arguments_capacity, sizeof(*expression->arguments));
+}
+
+static void stats_literal(struct mcc_ast_literal *literal, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_LITERAL, sizeof(*literal));
+}
+
+static void stats_declaration(struct mcc_ast_declaration *declaration, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_DECLARATION, sizeof(*declaration));
+}
+
+static void stats_assignment(struct mcc_ast_assignment *assignment, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_ASSIGNMENT, sizeof(*assignment));
+}
+
+static void stats_statement(struct mcc_ast_statement *statement, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_STATEMENT, sizeof(*statement));
+}
+
+static void stats_statement_compound(struct mcc_ast_statement *statement, void *data)
+{
+	add_array(data, statement->statements_capacity, sizeof(*statement->statements));
+}
+
+static void stats_function(struct mcc_ast_function *function, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_FUNCTION, sizeof(*function));
+	add_array(data, function->parameters_capacity, sizeof(*function->parameters));
+}
+
+static void stats_program(struct mcc_ast_program *program, void *data)
+{
+	add_node(data, MCC_AST_STATS_KIND_PROGRAM, sizeof(*program));
+	add_array(data, program->functions_capacity, sizeof(*program->functions));
+}
+
+void mcc_ast_stats_collect(struct mcc_ast_stats *stats,
+                           struct mcc_ast_program *program,
+                           const struct mcc_lexer_stats *lexer_stats)
+{
+	assert(stats);
+	assert(program);
+
+	*stats = (struct mcc_ast_stats){0};
+
+	struct mcc_ast_visitor visitor = {
+	    .traversal = MCC_AST_VISIT_DEPTH_FIRST,
+	    .order = MCC_AST_VISIT_PRE_ORDER,
+
+	    .userdata = stats,
+
+	    .identifier = stats_identifier,
+	    .expression = stats_expression,
+	    .expression_call = stats_expression_call,
+	    .literal = stats_literal,
+	    .declaration = stats_declaration,
+	    .assignment = stats_assignment,
+	    .statement = stats_statement,
+	    .statement_compound = stats_statement_compound,
+	    .function = stats_function,
+	    .program = stats_program,
+	};
+	mcc_ast_visit_program(program, &visitor);
+
+	const struct mcc_string_pool *strings = &program->strings;
+	stats->strings.count = strings->count;
+	stats->strings.bytes = strings->bytes + strings->capacity * sizeof(*strings->slots);
+	stats->strings.allocations = strings->allocations;
+
+	if (lexer_stats) {
+		stats->lexer = *lexer_stats;
+	}
+
+	for (size_t i = 0; i < MCC_AST_STATS_KIND_COUNT; i++) {
+		stats->total_bytes += stats->kinds[i].bytes;
+		stats->total_allocations += stats->kinds[i].allocations;
+	}
+	stats->total_bytes += stats->strings.bytes;
+	stats->total_allocations += stats->strings.allocations;
+}
+
+const char *mcc_ast_stats_kind_to_string(enum mcc_ast_stats_kind kind)
+{
+	switch (kind) {
+	case MCC_AST_STATS_KIND_PROGRAM:
+		return "program";
+	case MCC_AST_STATS_KIND_FUNCTION:
+		return "function";
+	case MCC_AST_STATS_KIND_DECLARATION:
+		return "declaration";
+	case MCC_AST_STATS_KIND_ASSIGNMENT:
+		return "assignment";
+	case MCC_AST_STATS_KIND_STATEMENT:
+		return "statement";
+	case MCC_AST_STATS_KIND_EXPRESSION:
+		return "expression";
+	case MCC_AST_STATS_KIND_LITERAL:
+		return "literal";
+	case MCC_AST_STATS_KIND_IDENTIFIER:
+		return "identifier";
+	case MCC_AST_STATS_KIND_ARRAY:
+		return "child array";
+	case MCC_AST_STATS_KIND_COUNT:
+		break;
+	}
+
+	return "unknown kind";
+}
+
+static void print_entry(FILE *out, const char *name, const struct mcc_ast_stats_entry *entry)
+{
+	fprintf(out, "%-16s %10zu %12zu %12zu\n", name, entry->count, entry->bytes, entry->allocations);
+}
+
+void mcc_ast_stats_print(FILE *out, const struct mcc_ast_stats *stats)
+{
+	assert(out);
+	assert(stats);
+
+	fprintf(out, "%-16s %10s %12s %12s\n", "kind", "count", "bytes", "allocations");
+	for (size_t i = 0; i < MCC_AST_STATS_KIND_COUNT; i++) {
+		print_entry(out, mcc_ast_stats_kind_to_string(i), &stats->kinds[i]);
+	}
+	print_entry(out, "interned string", &stats->strings);
+	fprintf(out, "%-16s %10s %12zu %12zu\n", "total", "", stats->total_bytes, stats->total_allocations);
+
+	fprintf(out, "\nlexemes: %zu\n", stats->lexer.lexemes);
+	fprintf(out, "lexer buffer high-water: %zu / %d\n", stats->lexer.buffer_high_water, MCC_MAX_LEXEME_LENGTH);
+}
@@ -22,6 +22,14 @@
 #define visit_if_post_order(node, callback, visitor) \
 	visit_if((visitor)->order == MCC_AST_VISIT_POST_ORDER, node, callback, visitor)
 
+void mcc_ast_visit_identifier(struct mcc_ast_identifier *identifier, struct mcc_ast_visitor *visitor)
+{
+	assert(identifier);
+	assert(visitor);
+
+	visit(identifier, visitor->identifier, visitor);
+}
+
 void mcc_ast_visit_expression(struct mcc_ast_expression *expression, struct mcc_ast_visitor *visitor)
 {
 	assert(expression);
@@ -48,6 +56,34 @@ void mcc_ast_visit_expression(struct mcc_ast_expression *expression, struct mcc_
 		mcc_ast_visit_expression(expression->expression, visitor);
 		visit_if_post_order(expression, visitor->expression_parenth, visitor);
 		break;
+
+	case MCC_AST_EXPRESSION_TYPE_UNARY_OP:
+		visit_if_pre_order(expression, visitor->expression_unary_op, visitor);
+		mcc_ast_visit_expression(expression->operand, visitor);
+		visit_if_post_order(expression, visitor->expression_unary_op, visitor);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_IDENTIFIER:
+		visit_if_pre_order(expression, visitor->expression_identifier, visitor);
+		mcc_ast_visit_identifier(expression->identifier, visitor);
+		visit_if_post_order(expression, visitor->expression_identifier, visitor);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT:
+		visit_if_pre_order(expression, visitor->expression_array_element, visitor);
+		mcc_ast_visit_identifier(expression->array, visitor);
+		mcc_ast_visit_expression(expression->index, visitor);
+		visit_if_post_order(expression, visitor->expression_array_element, visitor);
+		break;
+
+	case MCC_AST_EXPRESSION_TYPE_CALL:
+		visit_if_pre_order(expression, visitor->expression_call, visitor);
+		mcc_ast_visit_identifier(expression->callee, visitor);
+		for (size_t i = 0; i < expression->arguments_count; i++) {
+			mcc_ast_visit_expression(expression->arguments[i], visitor);
+		}
+		visit_if_post_order(expression, visitor->expression_call, visitor);
+		break;
 	}
 
 	visit_if_post_order(expression, visitor->expression, visitor);
@@ -68,7 +104,132 @@ void mcc_ast_visit_literal(struct mcc_ast_literal *literal, struct mcc_ast_visit
 	case MCC_AST_LITERAL_TYPE_FLOAT:
 		visit(literal, visitor->literal_float, visitor);
 		break;
+
+	case MCC_AST_LITERAL_TYPE_BOOL:
+		visit(literal, visitor->literal_bool, visitor);
+		break;
+
+	case MCC_AST_LITERAL_TYPE_STRING:
+		visit(literal, visitor->literal_string, visitor);
+		break;
 	}
 
 	visit_if_post_order(literal, visitor->literal, visitor);
 }
+
+void mcc_ast_visit_declaration(struct mcc_ast_declaration *declaration, struct mcc_ast_visitor *visitor)
+{
+	assert(declaration);
+	assert(visitor);
+
+	visit_if_pre_order(declaration, visitor->declaration, visitor);
+	mcc_ast_visit_identifier(declaration->identifier, visitor);
+	visit_if_post_order(declaration, visitor->declaration, visitor);
+}
+
+void mcc_ast_visit_assignment(struct mcc_ast_assignment *assignment, struct mcc_ast_visitor *visitor)
+{
+	assert(assignment);
+	assert(visitor);
+
+	visit_if_pre_order(assignment, visitor->assignment, visitor);
+	mcc_ast_visit_identifier(assignment->identifier, visitor);
+	if (assignment->index) {
+		mcc_ast_visit_expression(assignment->index, visitor);
+	}
+	mcc_ast_visit_expression(assignment->rhs, visitor);
+	visit_if_post_order(assignment, visitor->assignment, visitor);
+}
+
+void mcc_ast_visit_statement(struct mcc_ast_statement *statement, struct mcc_ast_visitor *visitor)
+{
+	assert(statement);
+	assert(visitor);
+
+	visit_if_pre_order(statement, visitor->statement, visitor);
+
+	switch (statement->type) {
+	case MCC_AST_STATEMENT_TYPE_IF:
+		visit_if_pre_order(statement, visitor->statement_if, visitor);
+		mcc_ast_visit_expression(statement->if_condition, visitor);
+		mcc_ast_visit_statement(statement->if_on_true, visitor);
+		if (statement->if_on_false) {
+			mcc_ast_visit_statement(statement->if_on_false, visitor);
+		}
+		visit_if_post_order(statement, visitor->statement_if, visitor);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_WHILE:
+		visit_if_pre_order(statement, visitor->statement_while, visitor);
+		mcc_ast_visit_expression(statement->while_condition, visitor);
+		mcc_ast_visit_statement(statement->while_body, visitor);
+		visit_if_post_order(statement, visitor->statement_while, visitor);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_RETURN:
+		visit_if_pre_order(statement, visitor->statement_return, visitor);
+		if (statement->return_value) {
+			mcc_ast_visit_expression(statement->return_value, visitor);
+		}
+		visit_if_post_order(statement, visitor->statement_return, visitor);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_DECLARATION:
+		visit_if_pre_order(statement, visitor->statement_declaration, visitor);
+		mcc_ast_visit_declaration(statement->declaration, visitor);
+		visit_if_post_order(statement, visitor->statement_declaration, visitor);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_ASSIGNMENT:
+		visit_if_pre_order(statement, visitor->statement_assignment, visitor);
+		mcc_ast_visit_assignment(statement->assignment, visitor);
+		visit_if_post_order(statement, visitor->statement_assignment, visitor);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_EXPRESSION:
+		visit_if_pre_order(statement, visitor->statement_expression, visitor);
+		mcc_ast_visit_expression(statement->expression, visitor);
+		visit_if_post_order(statement, visitor->statement_expression, visitor);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_COMPOUND:
+		visit_if_pre_order(statement, visitor->statement_compound, visitor);
+		for (size_t i = 0; i < statement->statements_count; i++) {
+			mcc_ast_visit_statement(statement->statements[i], visitor);
+		}
+		visit_if_post_order(statement, visitor->statement_compound, visitor);
+		break;
+	}
+
+	visit_if_post_order(statement, visitor->statement, visitor);
+}
+
+void mcc_ast_visit_function(struct mcc_ast_function *function, struct mcc_ast_visitor *visitor)
+{
+	assert(function);
+	assert(visitor);
+
+	visit_if_pre_order(function, visitor->function, visitor);
+
+	mcc_ast_visit_identifier(function->identifier, visitor);
+	for (size_t i = 0; i < function->parameters_count; i++) {
+		mcc_ast_visit_declaration(function->parameters[i], visitor);
+	}
+	mcc_ast_visit_statement(function->body, visitor);
+
+	visit_if_post_order(function, visitor->function, visitor);
+}
+
+void mcc_ast_visit_program(struct mcc_ast_program *program, struct mcc_ast_visitor *visitor)
+{
+	assert(program);
+	assert(visitor);
+
+	visit_if_pre_order(program, visitor->program, visitor);
+
+	for (size_t i = 0; i < program->functions_count; i++) {
+		mcc_ast_visit_function(program->functions[i], visitor);
+	}
+
+	visit_if_post_order(program, visitor->program, visitor);
+}
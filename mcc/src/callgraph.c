@@ -0,0 +1,167 @@
+#include "mcc/callgraph.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define UNVISITED UINT32_MAX
+
+static bool collect_callees(struct mcc_callgraph *graph, const struct mcc_tac_program *program)
+{
+	size_t count = 0;
+	for (size_t f = 0; f < program->functions_count; f++) {
+		const struct mcc_tac_function *function = &program->functions[f];
+		for (size_t i = 0; i < function->instructions_count; i++) {
+			count += function->instructions[i].op == MCC_TAC_OP_CALL;
+		}
+	}
+
+	graph->callees_begin = malloc((program->functions_count + 1) * sizeof(*graph->callees_begin));
+	graph->callees = malloc((count + 1) * sizeof(*graph->callees));
+	if (!graph->callees_begin || !graph->callees) {
+		return false;
+	}
+
+	size_t edges = 0;
+	for (size_t f = 0; f < program->functions_count; f++) {
+		const struct mcc_tac_function *function = &program->functions[f];
+		graph->callees_begin[f] = edges;
+		for (size_t i = 0; i < function->instructions_count; i++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[i];
+			if (instruction->op != MCC_TAC_OP_CALL) {
+				continue;
+			}
+
+			const struct mcc_tac_function *callee =
+			    mcc_tac_program_find_function(program, function->strings[instruction->arg1]);
+			if (callee) {
+				graph->callees[edges++] = (uint32_t)(callee - program->functions);
+			}
+		}
+	}
+	graph->callees_begin[program->functions_count] = edges;
+	return true;
+}
+
+// Tarjan's algorithm with an explicit stack of the functions being visited
+// and the next edge to follow from each.
+static bool find_components(struct mcc_callgraph *graph)
+{
+	size_t n = graph->functions_count;
+	uint32_t *index = malloc((n + 1) * sizeof(*index));
+	uint32_t *low = malloc((n + 1) * sizeof(*low));
+	bool *on_stack = calloc(n + 1, sizeof(*on_stack));
+	uint32_t *stack = malloc((n + 1) * sizeof(*stack));
+	uint32_t *visiting = malloc((n + 1) * sizeof(*visiting));
+	size_t *edges = malloc((n + 1) * sizeof(*edges));
+	bool ok = index && low && on_stack && stack && visiting && edges;
+
+	for (size_t f = 0; ok && f < n; f++) {
+		index[f] = UNVISITED;
+	}
+
+	uint32_t next_index = 0;
+	size_t stack_count = 0;
+	size_t ordered = 0;
+	for (uint32_t root = 0; ok && root < n; root++) {
+		if (index[root] != UNVISITED) {
+			continue;
+		}
+
+		size_t depth = 0;
+		visiting[depth] = root;
+		edges[depth] = graph->callees_begin[root];
+		index[root] = low[root] = next_index++;
+		stack[stack_count++] = root;
+		on_stack[root] = true;
+
+		while (true) {
+			uint32_t f = visiting[depth];
+			if (edges[depth] < graph->callees_begin[f + 1]) {
+				uint32_t callee = graph->callees[edges[depth]++];
+				if (callee == f) {
+					graph->recursive[f] = true;
+				}
+				if (index[callee] == UNVISITED) {
+					depth++;
+					visiting[depth] = callee;
+					edges[depth] = graph->callees_begin[callee];
+					index[callee] = low[callee] = next_index++;
+					stack[stack_count++] = callee;
+					on_stack[callee] = true;
+				} else if (on_stack[callee] && index[callee] < low[f]) {
+					low[f] = index[callee];
+				}
+				continue;
+			}
+
+			// All edges followed, `f` is the root of a component if
+			// nothing it reaches is on the stack below it.
+			if (low[f] == index[f]) {
+				uint32_t component = (uint32_t)graph->components_count++;
+				size_t first = ordered;
+				uint32_t member;
+				do {
+					member = stack[--stack_count];
+					on_stack[member] = false;
+					graph->components[member] = component;
+					graph->order[ordered++] = member;
+				} while (member != f);
+
+				if (ordered - first > 1) {
+					for (size_t i = first; i < ordered; i++) {
+						graph->recursive[graph->order[i]] = true;
+					}
+				}
+			}
+
+			if (depth == 0) {
+				break;
+			}
+			depth--;
+			uint32_t caller = visiting[depth];
+			if (low[f] < low[caller]) {
+				low[caller] = low[f];
+			}
+		}
+	}
+
+	free(index);
+	free(low);
+	free(on_stack);
+	free(stack);
+	free(visiting);
+	free(edges);
+	return ok;
+}
+
+bool mcc_callgraph_build(struct mcc_callgraph *graph, const struct mcc_tac_program *program)
+{
+	assert(graph);
+	assert(program);
+
+	*graph = (struct mcc_callgraph){.functions_count = program->functions_count};
+
+	size_t n = program->functions_count;
+	graph->components = malloc((n + 1) * sizeof(*graph->components));
+	graph->order = malloc((n + 1) * sizeof(*graph->order));
+	graph->recursive = calloc(n + 1, sizeof(*graph->recursive));
+	if (!graph->components || !graph->order || !graph->recursive) {
+		return false;
+	}
+
+	return collect_callees(graph, program) && find_components(graph);
+}
+
+void mcc_callgraph_deinit(struct mcc_callgraph *graph)
+{
+	if (!graph) {
+		return;
+	}
+
+	free(graph->callees_begin);
+	free(graph->callees);
+	free(graph->components);
+	free(graph->order);
+	free(graph->recursive);
+	*graph = (struct mcc_callgraph){0};
+}
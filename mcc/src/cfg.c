@@ -0,0 +1,248 @@
+#include "mcc/cfg.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+static bool is_terminator(enum mcc_tac_op op)
+{
+	return op == MCC_TAC_OP_JUMP || op == MCC_TAC_OP_JUMP_IF || op == MCC_TAC_OP_JUMP_IF_NOT ||
+	       op == MCC_TAC_OP_RETURN;
+}
+
+size_t mcc_cfg_block_last_instruction(const struct mcc_tac_function *function, const struct mcc_cfg_block *block)
+{
+	assert(function);
+	assert(block);
+
+	for (size_t i = block->end; i > block->begin; i--) {
+		if (function->instructions[i - 1].op != MCC_TAC_OP_NOP) {
+			return i - 1;
+		}
+	}
+	return block->end;
+}
+
+static bool split_blocks(struct mcc_cfg *cfg, const struct mcc_tac_function *function)
+{
+	size_t count = 1;
+	for (size_t i = 1; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *previous = &function->instructions[i - 1];
+		if (function->instructions[i].op == MCC_TAC_OP_LABEL || is_terminator(previous->op)) {
+			count++;
+		}
+	}
+
+	cfg->labels_count = function->labels_count;
+	cfg->blocks = calloc(count, sizeof(*cfg->blocks));
+	cfg->label_blocks = malloc((cfg->labels_count + 1) * sizeof(*cfg->label_blocks));
+	if (!cfg->blocks || !cfg->label_blocks) {
+		return false;
+	}
+	cfg->blocks_count = count;
+	for (size_t i = 0; i <= cfg->labels_count; i++) {
+		cfg->label_blocks[i] = MCC_CFG_NONE;
+	}
+
+	size_t block = 0;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (i > 0 && (instruction->op == MCC_TAC_OP_LABEL || is_terminator(function->instructions[i - 1].op))) {
+			cfg->blocks[block].end = i;
+			cfg->blocks[++block].begin = i;
+		}
+		if (instruction->op == MCC_TAC_OP_LABEL) {
+			assert(instruction->arg2 <= cfg->labels_count);
+			cfg->label_blocks[instruction->arg2] = (uint32_t)block;
+		}
+	}
+	cfg->blocks[block].end = function->instructions_count;
+	return true;
+}
+
+static void add_successor(struct mcc_cfg_block *block, uint32_t successor)
+{
+	if (block->successors_count == 0 || block->successors[0] != successor) {
+		block->successors[block->successors_count++] = successor;
+	}
+}
+
+static bool connect_blocks(struct mcc_cfg *cfg, const struct mcc_tac_function *function)
+{
+	size_t edges = 0;
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		struct mcc_cfg_block *block = &cfg->blocks[b];
+		uint32_t next = b + 1 < cfg->blocks_count ? (uint32_t)(b + 1) : MCC_CFG_NONE;
+
+		size_t last = mcc_cfg_block_last_instruction(function, block);
+		enum mcc_tac_op op = last < block->end ? function->instructions[last].op : MCC_TAC_OP_NOP;
+		if (op == MCC_TAC_OP_JUMP || op == MCC_TAC_OP_JUMP_IF || op == MCC_TAC_OP_JUMP_IF_NOT) {
+			uint32_t label = function->instructions[last].arg2;
+			assert(label <= cfg->labels_count && cfg->label_blocks[label] != MCC_CFG_NONE);
+			add_successor(block, cfg->label_blocks[label]);
+		}
+		if (op != MCC_TAC_OP_JUMP && op != MCC_TAC_OP_RETURN && next != MCC_CFG_NONE) {
+			add_successor(block, next);
+		}
+		edges += block->successors_count;
+	}
+
+	cfg->predecessors = malloc((edges ? edges : 1) * sizeof(*cfg->predecessors));
+	if (!cfg->predecessors) {
+		return false;
+	}
+
+	// Counting sort by successor, which keeps the predecessors ascending.
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		for (uint32_t s = 0; s < cfg->blocks[b].successors_count; s++) {
+			cfg->blocks[cfg->blocks[b].successors[s]].predecessors_count++;
+		}
+	}
+	size_t offset = 0;
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		cfg->blocks[b].predecessors_begin = offset;
+		offset += cfg->blocks[b].predecessors_count;
+		cfg->blocks[b].predecessors_count = 0;
+	}
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		for (uint32_t s = 0; s < cfg->blocks[b].successors_count; s++) {
+			struct mcc_cfg_block *successor = &cfg->blocks[cfg->blocks[b].successors[s]];
+			uint32_t *predecessors = &cfg->predecessors[successor->predecessors_begin];
+			predecessors[successor->predecessors_count++] = (uint32_t)b;
+		}
+	}
+	return true;
+}
+
+// Iterative depth-first search, the stack holds blocks along with the index
+// of their next successor to visit.
+static bool compute_order(struct mcc_cfg *cfg)
+{
+	cfg->order = malloc(cfg->blocks_count * sizeof(*cfg->order));
+	uint32_t *stack = malloc(cfg->blocks_count * sizeof(*stack));
+	uint32_t *next = calloc(cfg->blocks_count, sizeof(*next));
+	if (!cfg->order || !stack || !next) {
+		free(stack);
+		free(next);
+		return false;
+	}
+
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		cfg->blocks[b].order = MCC_CFG_NONE;
+		cfg->blocks[b].idom = MCC_CFG_NONE;
+	}
+
+	// Blocks are marked visited by a temporary order of 0, postorder is
+	// recorded at the end of `order` and reversed below.
+	size_t depth = 0;
+	size_t postorder = 0;
+	stack[depth++] = 0;
+	cfg->blocks[0].order = 0;
+	while (depth > 0) {
+		uint32_t b = stack[depth - 1];
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		if (next[b] < block->successors_count) {
+			uint32_t successor = block->successors[next[b]++];
+			if (cfg->blocks[successor].order == MCC_CFG_NONE) {
+				cfg->blocks[successor].order = 0;
+				stack[depth++] = successor;
+			}
+		} else {
+			cfg->order[postorder++] = b;
+			depth--;
+		}
+	}
+
+	cfg->order_count = postorder;
+	for (size_t i = 0; i < postorder / 2; i++) {
+		uint32_t tmp = cfg->order[i];
+		cfg->order[i] = cfg->order[postorder - 1 - i];
+		cfg->order[postorder - 1 - i] = tmp;
+	}
+	for (size_t i = 0; i < postorder; i++) {
+		cfg->blocks[cfg->order[i]].order = (uint32_t)i;
+	}
+
+	free(stack);
+	free(next);
+	return true;
+}
+
+static uint32_t intersect(const struct mcc_cfg *cfg, uint32_t a, uint32_t b)
+{
+	while (a != b) {
+		while (cfg->blocks[a].order > cfg->blocks[b].order) {
+			a = cfg->blocks[a].idom;
+		}
+		while (cfg->blocks[b].order > cfg->blocks[a].order) {
+			b = cfg->blocks[b].idom;
+		}
+	}
+	return a;
+}
+
+static void compute_dominators(struct mcc_cfg *cfg)
+{
+	cfg->blocks[0].idom = 0;
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t i = 1; i < cfg->order_count; i++) {
+			uint32_t b = cfg->order[i];
+			const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, b);
+
+			uint32_t idom = MCC_CFG_NONE;
+			for (uint32_t p = 0; p < cfg->blocks[b].predecessors_count; p++) {
+				uint32_t predecessor = predecessors[p];
+				if (cfg->blocks[predecessor].idom == MCC_CFG_NONE) {
+					continue;
+				}
+				idom = idom == MCC_CFG_NONE ? predecessor : intersect(cfg, predecessor, idom);
+			}
+
+			if (cfg->blocks[b].idom != idom) {
+				cfg->blocks[b].idom = idom;
+				changed = true;
+			}
+		}
+	}
+}
+
+bool mcc_cfg_build(struct mcc_cfg *cfg, const struct mcc_tac_function *function)
+{
+	assert(cfg);
+	assert(function);
+
+	*cfg = (struct mcc_cfg){0};
+	if (!split_blocks(cfg, function) || !connect_blocks(cfg, function) || !compute_order(cfg)) {
+		return false;
+	}
+	compute_dominators(cfg);
+	return true;
+}
+
+void mcc_cfg_deinit(struct mcc_cfg *cfg)
+{
+	if (!cfg) {
+		return;
+	}
+
+	free(cfg->blocks);
+	free(cfg->predecessors);
+	free(cfg->order);
+	free(cfg->label_blocks);
+	*cfg = (struct mcc_cfg){0};
+}
+
+bool mcc_cfg_dominates(const struct mcc_cfg *cfg, uint32_t a, uint32_t b)
+{
+	assert(cfg);
+	assert(a < cfg->blocks_count && cfg->blocks[a].order != MCC_CFG_NONE);
+	assert(b < cfg->blocks_count && cfg->blocks[b].order != MCC_CFG_NONE);
+
+	// Dominators precede the blocks they dominate in reverse postorder.
+	while (cfg->blocks[b].order > cfg->blocks[a].order) {
+		b = cfg->blocks[b].idom;
+	}
+	return a == b;
+}
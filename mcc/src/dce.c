@@ -0,0 +1,510 @@
+#include "mcc/dce.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mcc/cfg.h"
+#include "mcc/liveness.h"
+
+#define NO_COPY UINT32_MAX
+
+// ---------------------------------------------------------- Copy Propagation
+
+struct copy {
+	uint32_t destination, source;
+};
+
+struct propagation {
+	const struct mcc_cfg *cfg;
+	struct mcc_tac_function *function;
+
+	struct copy *copies;
+	size_t copies_count;
+	size_t words;
+
+	// Copies each variable takes part in, as destination or source, are
+	// entries `involved_begin[v]` up to `involved_begin[v + 1]` of `involved`.
+	uint32_t *involved_begin;
+	uint32_t *involved;
+
+	// Number of the first copy in each block, copies are numbered in
+	// instruction order.
+	uint32_t *first_copy;
+
+	// `words` words per block. A copy is available at the entry of a block if
+	// it holds on all paths leading there.
+	uint64_t *gen, *kill, *in, *out;
+
+	// Copies available at the instruction being renamed.
+	uint64_t *available;
+	size_t renamed;
+};
+
+static bool is_copy(const struct mcc_tac_instruction *instruction)
+{
+	return instruction->op == MCC_TAC_OP_ASSIGN && instruction->result != instruction->arg1;
+}
+
+static void propagation_deinit(struct propagation *propagation)
+{
+	free(propagation->copies);
+	free(propagation->involved_begin);
+	free(propagation->involved);
+	free(propagation->first_copy);
+	free(propagation->gen);
+	free(propagation->kill);
+	free(propagation->in);
+	free(propagation->out);
+	free(propagation->available);
+}
+
+static bool collect_copies(struct propagation *propagation)
+{
+	const struct mcc_tac_function *function = propagation->function;
+	size_t count = 0;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (is_copy(&function->instructions[i])) {
+			count++;
+		}
+	}
+
+	size_t variables = function->variables_count + 1;
+	size_t blocks = propagation->cfg->blocks_count;
+	size_t words = (count + 63) / 64;
+	propagation->copies_count = count;
+	propagation->words = words;
+	propagation->copies = malloc((count ? count : 1) * sizeof(*propagation->copies));
+	propagation->involved_begin = calloc(variables + 1, sizeof(*propagation->involved_begin));
+	propagation->involved = malloc((count ? 2 * count : 1) * sizeof(*propagation->involved));
+	propagation->first_copy = malloc(blocks * sizeof(*propagation->first_copy));
+	propagation->gen = calloc(blocks * words + 1, sizeof(*propagation->gen));
+	propagation->kill = calloc(blocks * words + 1, sizeof(*propagation->kill));
+	propagation->in = calloc(blocks * words + 1, sizeof(*propagation->in));
+	propagation->out = calloc(blocks * words + 1, sizeof(*propagation->out));
+	propagation->available = calloc(words + 1, sizeof(*propagation->available));
+	if (!propagation->copies || !propagation->involved_begin || !propagation->involved ||
+	    !propagation->first_copy || !propagation->gen || !propagation->kill || !propagation->in ||
+	    !propagation->out || !propagation->available) {
+		return false;
+	}
+
+	// Blocks cover the instructions in order, so copies are numbered in
+	// instruction order.
+	size_t c = 0;
+	for (size_t b = 0; b < blocks; b++) {
+		const struct mcc_cfg_block *block = &propagation->cfg->blocks[b];
+		propagation->first_copy[b] = (uint32_t)c;
+		for (size_t i = block->begin; i < block->end; i++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[i];
+			if (is_copy(instruction)) {
+				propagation->copies[c++] = (struct copy){instruction->result, instruction->arg1};
+			}
+		}
+	}
+	assert(c == count);
+
+	// Counting sort by variable.
+	uint32_t *begin = propagation->involved_begin;
+	for (size_t k = 0; k < count; k++) {
+		begin[propagation->copies[k].destination + 1]++;
+		begin[propagation->copies[k].source + 1]++;
+	}
+	for (size_t v = 1; v <= variables; v++) {
+		begin[v] += begin[v - 1];
+	}
+	for (size_t k = 0; k < count; k++) {
+		propagation->involved[begin[propagation->copies[k].destination]++] = (uint32_t)k;
+		propagation->involved[begin[propagation->copies[k].source]++] = (uint32_t)k;
+	}
+	for (size_t v = variables; v > 0; v--) {
+		begin[v] = begin[v - 1];
+	}
+	begin[0] = 0;
+	return true;
+}
+
+// Removes the copies involving `variable` from `set`, adding them to `kill`
+// if not NULL.
+static void kill_copies(const struct propagation *propagation, uint32_t variable, uint64_t *set, uint64_t *kill)
+{
+	for (uint32_t k = propagation->involved_begin[variable]; k < propagation->involved_begin[variable + 1]; k++) {
+		uint32_t c = propagation->involved[k];
+		mcc_liveness_set_remove(set, c);
+		if (kill) {
+			mcc_liveness_set_add(kill, c);
+		}
+	}
+}
+
+static void compute_local_sets(struct propagation *propagation)
+{
+	const struct mcc_tac_function *function = propagation->function;
+	size_t words = propagation->words;
+
+	for (size_t b = 0; b < propagation->cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &propagation->cfg->blocks[b];
+		uint64_t *gen = propagation->gen + b * words;
+		uint64_t *kill = propagation->kill + b * words;
+		uint32_t c = propagation->first_copy[b];
+		for (size_t i = block->begin; i < block->end; i++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[i];
+			uint32_t definition = mcc_tac_instruction_definition(instruction);
+			if (definition) {
+				kill_copies(propagation, definition, gen, kill);
+			}
+			if (is_copy(instruction)) {
+				mcc_liveness_set_add(gen, c++);
+			}
+		}
+	}
+}
+
+// Intersects the copies leaving the reachable predecessors, iterating in
+// reverse postorder. Unreachable blocks start without available copies.
+static void compute_available(struct propagation *propagation)
+{
+	const struct mcc_cfg *cfg = propagation->cfg;
+	size_t words = propagation->words;
+
+	for (size_t i = 1; i < cfg->order_count; i++) {
+		memset(propagation->out + cfg->order[i] * words, 0xff, words * sizeof(*propagation->out));
+	}
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t i = 0; i < cfg->order_count; i++) {
+			uint32_t b = cfg->order[i];
+			uint64_t *in = propagation->in + b * words;
+			uint64_t *out = propagation->out + b * words;
+			const uint64_t *gen = propagation->gen + b * words;
+			const uint64_t *kill = propagation->kill + b * words;
+
+			if (b != 0) {
+				memset(in, 0xff, words * sizeof(*in));
+				const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, b);
+				for (uint32_t p = 0; p < cfg->blocks[b].predecessors_count; p++) {
+					if (cfg->blocks[predecessors[p]].order == MCC_CFG_NONE) {
+						continue;
+					}
+					const uint64_t *predecessor_out = propagation->out + predecessors[p] * words;
+					for (size_t w = 0; w < words; w++) {
+						in[w] &= predecessor_out[w];
+					}
+				}
+			}
+
+			for (size_t w = 0; w < words; w++) {
+				uint64_t word = gen[w] | (in[w] & ~kill[w]);
+				changed |= word != out[w];
+				out[w] = word;
+			}
+		}
+	}
+}
+
+static uint32_t available_copy(const struct propagation *propagation, uint32_t variable)
+{
+	for (uint32_t k = propagation->involved_begin[variable]; k < propagation->involved_begin[variable + 1]; k++) {
+		uint32_t c = propagation->involved[k];
+		if (propagation->copies[c].destination == variable &&
+		    mcc_liveness_set_contains(propagation->available, c)) {
+			return c;
+		}
+	}
+	return NO_COPY;
+}
+
+// Follows chains of available copies to their first source. Copies cannot
+// form a cycle, the last copy of a cycle kills the one reading its
+// destination.
+static void rename_use(uint32_t *variable, void *userdata)
+{
+	struct propagation *propagation = userdata;
+
+	uint32_t c = available_copy(propagation, *variable);
+	if (c == NO_COPY) {
+		return;
+	}
+	while (c != NO_COPY) {
+		*variable = propagation->copies[c].source;
+		c = available_copy(propagation, *variable);
+	}
+	propagation->renamed++;
+}
+
+static void rename_uses(struct propagation *propagation)
+{
+	struct mcc_tac_function *function = propagation->function;
+	size_t words = propagation->words;
+
+	for (size_t b = 0; b < propagation->cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &propagation->cfg->blocks[b];
+		memcpy(propagation->available, propagation->in + b * words, words * sizeof(*propagation->available));
+
+		// Copies are recognised before renaming, a renamed copy still holds
+		// for its original source.
+		uint32_t c = propagation->first_copy[b];
+		for (size_t i = block->begin; i < block->end; i++) {
+			struct mcc_tac_instruction *instruction = &function->instructions[i];
+			bool copy = is_copy(instruction);
+			mcc_tac_function_visit_uses(function, instruction, rename_use, propagation);
+
+			uint32_t definition = mcc_tac_instruction_definition(instruction);
+			if (definition) {
+				kill_copies(propagation, definition, propagation->available, NULL);
+			}
+			if (copy) {
+				mcc_liveness_set_add(propagation->available, c++);
+			}
+		}
+	}
+}
+
+static bool propagate(const struct mcc_cfg *cfg, struct mcc_tac_function *function, size_t *propagated)
+{
+	struct propagation propagation = {.cfg = cfg, .function = function};
+	bool ok = collect_copies(&propagation);
+	if (ok && propagation.copies_count > 0) {
+		compute_local_sets(&propagation);
+		compute_available(&propagation);
+		rename_uses(&propagation);
+		*propagated += propagation.renamed;
+	}
+	propagation_deinit(&propagation);
+	return ok;
+}
+
+// ------------------------------------------------------- Dead Code Elimination
+
+// Per variable, which kinds of instructions define and read it.
+enum {
+	DEFINED_BY_ARRAY = 1,
+	DEFINED_OTHERWISE = 2,
+	READ = 4,
+};
+
+struct elimination {
+	struct mcc_tac_function *function;
+	uint8_t *variables;
+	uint64_t *live;
+};
+
+static void mark_read(uint32_t *variable, void *userdata)
+{
+	struct elimination *elimination = userdata;
+	elimination->variables[*variable] |= READ;
+}
+
+// Storing into an array does not read it.
+static void classify_variables(struct elimination *elimination)
+{
+	struct mcc_tac_function *function = elimination->function;
+	memset(elimination->variables, 0, (function->variables_count + 1) * sizeof(*elimination->variables));
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_STORE) {
+			elimination->variables[instruction->arg1] |= READ;
+			elimination->variables[instruction->arg2] |= READ;
+			continue;
+		}
+		mcc_tac_function_visit_uses(function, instruction, mark_read, elimination);
+
+		uint32_t definition = mcc_tac_instruction_definition(instruction);
+		if (definition) {
+			elimination->variables[definition] |=
+			    instruction->op == MCC_TAC_OP_ARRAY ? DEFINED_BY_ARRAY : DEFINED_OTHERWISE;
+		}
+	}
+}
+
+static bool is_dead(const struct elimination *elimination, const struct mcc_tac_instruction *instruction)
+{
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_ASSIGN:
+		if (instruction->result == instruction->arg1) {
+			return true;
+		}
+		return !mcc_liveness_set_contains(elimination->live, instruction->result);
+
+	case MCC_TAC_OP_DIV:
+		if (instruction->type == MCC_TAC_TYPE_INT) {
+			return false;
+		}
+		return !mcc_liveness_set_contains(elimination->live, instruction->result);
+
+	case MCC_TAC_OP_CONST:
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+	case MCC_TAC_OP_NOT:
+	case MCC_TAC_OP_ARRAY:
+	case MCC_TAC_OP_LOAD:
+		return !mcc_liveness_set_contains(elimination->live, instruction->result);
+
+	case MCC_TAC_OP_STORE:
+		return elimination->variables[instruction->result] == DEFINED_BY_ARRAY;
+
+	default:
+		return false;
+	}
+}
+
+// Lets the instruction defining the source of a copy, right before it,
+// define the copy's destination instead, if the source is not read later.
+static bool coalesce_copy(struct elimination *elimination, const struct mcc_cfg_block *block, size_t index)
+{
+	const struct mcc_tac_instruction *copy = &elimination->function->instructions[index];
+	if (!is_copy(copy) || mcc_liveness_set_contains(elimination->live, copy->arg1)) {
+		return false;
+	}
+
+	size_t previous = index;
+	while (previous > block->begin && elimination->function->instructions[previous - 1].op == MCC_TAC_OP_NOP) {
+		previous--;
+	}
+	if (previous == block->begin) {
+		return false;
+	}
+
+	struct mcc_tac_instruction *definition = &elimination->function->instructions[previous - 1];
+	if (definition->op == MCC_TAC_OP_PARAM || mcc_tac_instruction_definition(definition) != copy->arg1) {
+		return false;
+	}
+	definition->result = copy->result;
+	return true;
+}
+
+static void add_live(uint32_t *variable, void *userdata)
+{
+	struct elimination *elimination = userdata;
+	mcc_liveness_set_add(elimination->live, *variable);
+}
+
+// Walks each block backwards from the variables live at its exit. Returns
+// the number of instructions removed.
+static size_t sweep(struct elimination *elimination, const struct mcc_cfg *cfg, const struct mcc_liveness *liveness)
+{
+	struct mcc_tac_function *function = elimination->function;
+	size_t removed = 0;
+
+	for (uint32_t b = 0; b < cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		memcpy(elimination->live, mcc_liveness_out(liveness, b), liveness->words * sizeof(*elimination->live));
+
+		for (size_t i = block->end; i > block->begin; i--) {
+			struct mcc_tac_instruction *instruction = &function->instructions[i - 1];
+			if (instruction->op == MCC_TAC_OP_NOP) {
+				continue;
+			}
+			if (is_dead(elimination, instruction) || coalesce_copy(elimination, block, i - 1)) {
+				mcc_tac_function_remove(function, i - 1);
+				removed++;
+				continue;
+			}
+
+			uint32_t definition = mcc_tac_instruction_definition(instruction);
+			if (definition) {
+				mcc_liveness_set_remove(elimination->live, definition);
+			}
+			mcc_tac_function_visit_uses(function, instruction, add_live, elimination);
+		}
+	}
+	return removed;
+}
+
+static bool eliminate(const struct mcc_cfg *cfg, struct mcc_tac_function *function, size_t *removed)
+{
+	struct elimination elimination = {
+	    .function = function,
+	    .variables = malloc((function->variables_count + 1) * sizeof(*elimination.variables)),
+	    .live = malloc(((function->variables_count + 1 + 63) / 64) * sizeof(*elimination.live)),
+	};
+	bool ok = elimination.variables && elimination.live;
+
+	size_t round_removed = 1;
+	while (ok && round_removed > 0) {
+		struct mcc_liveness liveness;
+		ok = mcc_liveness_compute(&liveness, cfg, function);
+		if (ok) {
+			classify_variables(&elimination);
+			round_removed = sweep(&elimination, cfg, &liveness);
+			*removed += round_removed;
+		}
+		mcc_liveness_deinit(&liveness);
+	}
+
+	free(elimination.variables);
+	free(elimination.live);
+	return ok;
+}
+
+// ------------------------------------------------------------------- Driver
+
+bool mcc_dce_propagate_copies(struct mcc_tac_function *function, size_t *propagated)
+{
+	assert(function);
+
+	size_t count = 0;
+	struct mcc_cfg cfg;
+	bool ok = mcc_cfg_build(&cfg, function) && propagate(&cfg, function, &count);
+	mcc_cfg_deinit(&cfg);
+
+	if (propagated) {
+		*propagated += count;
+	}
+	return ok;
+}
+
+bool mcc_dce_eliminate(struct mcc_tac_function *function, size_t *removed)
+{
+	assert(function);
+
+	size_t count = 0;
+	struct mcc_cfg cfg;
+	bool ok = mcc_cfg_build(&cfg, function) && eliminate(&cfg, function, &count);
+	mcc_cfg_deinit(&cfg);
+
+	if (removed) {
+		*removed += count;
+	}
+	return ok;
+}
+
+bool mcc_dce_function(struct mcc_tac_function *function, struct mcc_dce_stats *stats)
+{
+	assert(function);
+
+	// Neither transformation changes the graph, tombstones stay in their
+	// blocks.
+	struct mcc_cfg cfg;
+	bool ok = mcc_cfg_build(&cfg, function);
+
+	struct mcc_dce_stats total = {0};
+	bool changed = true;
+	while (ok && changed) {
+		struct mcc_dce_stats round = {0};
+		ok = propagate(&cfg, function, &round.propagated) && eliminate(&cfg, function, &round.removed);
+		changed = round.propagated > 0 || round.removed > 0;
+		total.propagated += round.propagated;
+		total.removed += round.removed;
+	}
+	mcc_cfg_deinit(&cfg);
+
+	if (stats) {
+		stats->propagated += total.propagated;
+		stats->removed += total.removed;
+	}
+	return ok;
+}
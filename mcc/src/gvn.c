@@ -0,0 +1,343 @@
+#include "mcc/gvn.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "mcc/cfg.h"
+
+#define NONE UINT32_MAX
+
+struct expression {
+	uint8_t op;
+	uint8_t type;
+	uint32_t a, b;
+};
+
+// An available expression and the variable holding its value. Entries of a
+// bucket are chained from the most recent one, so leaving a scope pops
+// entries in the reverse order they were pushed and restores the buckets.
+struct entry {
+	struct expression expression;
+	uint32_t variable;
+	uint32_t next;
+};
+
+struct gvn {
+	struct mcc_tac_function *function;
+	const struct mcc_cfg *cfg;
+
+	// Value number of each variable, named after the variable first holding
+	// the value. Variables not defined yet number themselves.
+	uint32_t *numbers;
+
+	uint32_t *buckets;
+	size_t mask;
+	struct entry *entries;
+	size_t entries_count;
+
+	// Children of block `b` in the dominator tree are
+	// `children[children_begin[b]]` up to `children[children_begin[b + 1]]`.
+	uint32_t *children_begin;
+	uint32_t *children;
+
+	size_t eliminated;
+};
+
+static void gvn_deinit(struct gvn *gvn)
+{
+	free(gvn->numbers);
+	free(gvn->buckets);
+	free(gvn->entries);
+	free(gvn->children_begin);
+	free(gvn->children);
+}
+
+static bool gvn_init(struct gvn *gvn)
+{
+	const struct mcc_tac_function *function = gvn->function;
+	const struct mcc_cfg *cfg = gvn->cfg;
+
+	size_t capacity = 16;
+	while (capacity < 2 * function->instructions_count) {
+		capacity *= 2;
+	}
+	gvn->mask = capacity - 1;
+
+	gvn->numbers = malloc((function->variables_count + 1) * sizeof(*gvn->numbers));
+	gvn->buckets = malloc(capacity * sizeof(*gvn->buckets));
+	gvn->entries = malloc((function->instructions_count + 1) * sizeof(*gvn->entries));
+	gvn->children_begin = calloc(cfg->blocks_count + 1, sizeof(*gvn->children_begin));
+	gvn->children = malloc((cfg->blocks_count + 1) * sizeof(*gvn->children));
+	if (!gvn->numbers || !gvn->buckets || !gvn->entries || !gvn->children_begin || !gvn->children) {
+		return false;
+	}
+
+	for (uint32_t v = 0; v <= function->variables_count; v++) {
+		gvn->numbers[v] = v;
+	}
+	for (size_t i = 0; i < capacity; i++) {
+		gvn->buckets[i] = NONE;
+	}
+
+	// Children are listed in reverse postorder, counting sort by parent.
+	for (size_t i = 1; i < cfg->order_count; i++) {
+		gvn->children_begin[cfg->blocks[cfg->order[i]].idom + 1]++;
+	}
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		gvn->children_begin[b + 1] += gvn->children_begin[b];
+	}
+	for (size_t i = 1; i < cfg->order_count; i++) {
+		uint32_t b = cfg->order[i];
+		gvn->children[gvn->children_begin[cfg->blocks[b].idom]++] = b;
+	}
+	for (size_t b = cfg->blocks_count; b > 0; b--) {
+		gvn->children_begin[b] = gvn->children_begin[b - 1];
+	}
+	gvn->children_begin[0] = 0;
+	return true;
+}
+
+// ------------------------------------------------------------ Expressions
+
+static size_t hash_expression(const struct expression *expression)
+{
+	uint64_t hash = (uint64_t)expression->op << 8 | expression->type;
+	hash = (hash ^ expression->a) * UINT64_C(11400714819323198485);
+	hash = (hash ^ expression->b) * UINT64_C(11400714819323198485);
+	return (size_t)(hash >> 32);
+}
+
+static bool expressions_equal(const struct expression *a, const struct expression *b)
+{
+	return a->op == b->op && a->type == b->type && a->a == b->a && a->b == b->b;
+}
+
+static uint32_t lookup(const struct gvn *gvn, const struct expression *expression)
+{
+	uint32_t e = gvn->buckets[hash_expression(expression) & gvn->mask];
+	while (e != NONE && !expressions_equal(&gvn->entries[e].expression, expression)) {
+		e = gvn->entries[e].next;
+	}
+	return e == NONE ? NONE : gvn->entries[e].variable;
+}
+
+static void insert(struct gvn *gvn, const struct expression *expression, uint32_t variable)
+{
+	// Each instruction adds at most one entry.
+	assert(gvn->entries_count <= gvn->function->instructions_count);
+
+	uint32_t *bucket = &gvn->buckets[hash_expression(expression) & gvn->mask];
+	uint32_t e = (uint32_t)gvn->entries_count++;
+	gvn->entries[e] = (struct entry){.expression = *expression, .variable = variable, .next = *bucket};
+	*bucket = e;
+}
+
+// Forgets the entries from `count` on.
+static void pop(struct gvn *gvn, size_t count)
+{
+	while (gvn->entries_count > count) {
+		const struct entry *entry = &gvn->entries[--gvn->entries_count];
+		gvn->buckets[hash_expression(&entry->expression) & gvn->mask] = entry->next;
+	}
+}
+
+static bool is_commutative(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Mirrored comparisons, swapping the operands. This holds for floats as
+// well, comparisons involving NaN are false either way.
+static enum mcc_tac_op mirror(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_LT:
+		return MCC_TAC_OP_GT;
+	case MCC_TAC_OP_LE:
+		return MCC_TAC_OP_GE;
+	case MCC_TAC_OP_GT:
+		return MCC_TAC_OP_LT;
+	case MCC_TAC_OP_GE:
+		return MCC_TAC_OP_LE;
+	default:
+		return op;
+	}
+}
+
+// Builds the key of the value computed by `instruction`, returns false if
+// it is not numbered.
+static bool describe(const struct gvn *gvn,
+                     const struct mcc_tac_instruction *instruction,
+                     struct expression *expression)
+{
+	const struct mcc_tac_function *function = gvn->function;
+	enum mcc_tac_op op = (enum mcc_tac_op)instruction->op;
+	*expression = (struct expression){.op = instruction->op, .type = instruction->type};
+
+	switch (op) {
+	case MCC_TAC_OP_CONST:
+		if (instruction->type == MCC_TAC_TYPE_STRING) {
+			expression->a = instruction->arg1;
+		} else {
+			uint64_t bits = function->constants[instruction->arg1];
+			expression->a = (uint32_t)bits;
+			expression->b = (uint32_t)(bits >> 32);
+		}
+		return true;
+
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_NOT:
+		expression->a = gvn->numbers[instruction->arg1];
+		return true;
+
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+		expression->a = gvn->numbers[instruction->arg1];
+		expression->b = gvn->numbers[instruction->arg2];
+		if (expression->a > expression->b && (is_commutative(op) || mirror(op) != op)) {
+			uint32_t a = expression->a;
+			expression->a = expression->b;
+			expression->b = a;
+			expression->op = (uint8_t)mirror(op);
+		}
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+// ---------------------------------------------------------------- Blocks
+
+// A phi whose incoming values share one number has that number, values
+// flowing in along back edges have not been numbered yet and only match
+// themselves.
+static void number_phi(struct gvn *gvn, const struct mcc_tac_instruction *phi)
+{
+	const uint32_t *operands = &gvn->function->operands[phi->arg1];
+	uint32_t number = gvn->numbers[operands[1]];
+	for (uint32_t i = 1; i < phi->arg2; i++) {
+		if (gvn->numbers[operands[2 * i + 1]] != number) {
+			return;
+		}
+	}
+	gvn->numbers[phi->result] = number;
+}
+
+static void number_block(struct gvn *gvn, uint32_t b)
+{
+	struct mcc_tac_function *function = gvn->function;
+	const struct mcc_cfg_block *block = &gvn->cfg->blocks[b];
+
+	for (size_t i = block->begin; i < block->end; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_PHI) {
+			number_phi(gvn, instruction);
+			continue;
+		}
+		if (instruction->op == MCC_TAC_OP_ASSIGN) {
+			gvn->numbers[instruction->result] = gvn->numbers[instruction->arg1];
+			continue;
+		}
+
+		struct expression expression;
+		if (!describe(gvn, instruction, &expression)) {
+			continue;
+		}
+		uint32_t available = lookup(gvn, &expression);
+		if (available == NONE) {
+			insert(gvn, &expression, instruction->result);
+			continue;
+		}
+
+		gvn->numbers[instruction->result] = available;
+		// Constants are as cheap as copies, they are only numbered.
+		if (instruction->op != MCC_TAC_OP_CONST) {
+			*instruction = (struct mcc_tac_instruction){
+			    .op = MCC_TAC_OP_ASSIGN,
+			    .type = (uint8_t)mcc_tac_function_variable_type(function, instruction->result),
+			    .result = instruction->result,
+			    .arg1 = available,
+			};
+			gvn->eliminated++;
+		}
+	}
+}
+
+// Walks the dominator tree depth first, scoping the table to each subtree.
+static bool walk(struct gvn *gvn)
+{
+	const struct mcc_cfg *cfg = gvn->cfg;
+
+	struct frame {
+		uint32_t block;
+		uint32_t child;
+		size_t entries_count;
+	};
+	struct frame *stack = malloc((cfg->blocks_count + 1) * sizeof(*stack));
+	if (!stack) {
+		return false;
+	}
+
+	size_t depth = 0;
+	if (cfg->order_count > 0) {
+		stack[depth++] = (struct frame){.block = cfg->order[0], .child = gvn->children_begin[cfg->order[0]]};
+		number_block(gvn, cfg->order[0]);
+	}
+	while (depth > 0) {
+		struct frame *frame = &stack[depth - 1];
+		if (frame->child == gvn->children_begin[frame->block + 1]) {
+			pop(gvn, frame->entries_count);
+			depth--;
+			continue;
+		}
+
+		uint32_t child = gvn->children[frame->child++];
+		stack[depth++] = (struct frame){
+		    .block = child,
+		    .child = gvn->children_begin[child],
+		    .entries_count = gvn->entries_count,
+		};
+		number_block(gvn, child);
+	}
+
+	free(stack);
+	return true;
+}
+
+bool mcc_gvn_function(struct mcc_tac_function *function, struct mcc_gvn_stats *stats)
+{
+	assert(function);
+
+	struct mcc_cfg cfg;
+	struct gvn gvn = {.function = function, .cfg = &cfg};
+	bool ok = mcc_cfg_build(&cfg, function) && gvn_init(&gvn) && walk(&gvn);
+	gvn_deinit(&gvn);
+	mcc_cfg_deinit(&cfg);
+
+	if (ok && stats) {
+		stats->eliminated += gvn.eliminated;
+	}
+	return ok;
+}
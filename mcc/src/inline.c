@@ -0,0 +1,290 @@
+#include "mcc/inline.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/callgraph.h"
+#include "mcc/cfg.h"
+#include "mcc/loops.h"
+
+// A call which may be inlined, by instruction index.
+struct site {
+	size_t index;
+	bool in_loop;
+};
+
+struct sites {
+	struct site *sites;
+	size_t sites_count;
+	size_t sites_capacity;
+};
+
+static size_t size_of(const struct mcc_tac_function *function)
+{
+	return function->instructions_count - function->removed_count;
+}
+
+// Instructions added by inlining a call of `callee`. Copies of parameters
+// and the result are left to copy propagation, they do not count.
+static size_t cost_of(const struct mcc_tac_function *callee)
+{
+	size_t saved = callee->parameters_count + 2;
+	size_t size = size_of(callee);
+	return size > saved ? size - saved : 0;
+}
+
+static const struct mcc_tac_function *find_callee(const struct mcc_tac_program *program,
+                                                  const struct mcc_tac_function *caller,
+                                                  const struct mcc_tac_instruction *call)
+{
+	return mcc_tac_program_find_function(program, caller->strings[call->arg1]);
+}
+
+// Collects the reachable calls of function `f` whose callee is in another
+// component, in instruction order.
+static bool find_sites(const struct mcc_tac_program *program,
+                       const struct mcc_callgraph *graph,
+                       uint32_t f,
+                       struct sites *sites)
+{
+	const struct mcc_tac_function *caller = &program->functions[f];
+
+	struct mcc_cfg cfg;
+	struct mcc_loops loops = {0};
+	bool ok = mcc_cfg_build(&cfg, caller) && mcc_loops_find(&loops, &cfg);
+
+	for (uint32_t b = 0; ok && b < cfg.blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg.blocks[b];
+		if (block->order == MCC_CFG_NONE) {
+			continue;
+		}
+
+		for (size_t i = block->begin; ok && i < block->end; i++) {
+			const struct mcc_tac_instruction *instruction = &caller->instructions[i];
+			if (instruction->op != MCC_TAC_OP_CALL) {
+				continue;
+			}
+
+			const struct mcc_tac_function *callee = find_callee(program, caller, instruction);
+			if (!callee || graph->components[callee - program->functions] == graph->components[f]) {
+				continue;
+			}
+
+			struct site site = {.index = i, .in_loop = loops.block_loops[b] != MCC_CFG_NONE};
+			ok = mcc_array_push(sites->sites, sites->sites_count, sites->sites_capacity, site);
+		}
+	}
+
+	mcc_loops_deinit(&loops);
+	mcc_cfg_deinit(&cfg);
+	return ok;
+}
+
+static void rename_variable(uint32_t *variable, void *userdata)
+{
+	*variable += *(const uint32_t *)userdata;
+}
+
+// Copies `callee` into `caller` in place of the call at `index`. The number
+// of instructions inserted is stored in `inserted`.
+static bool inline_call(struct mcc_tac_function *caller,
+                        const struct mcc_tac_function *callee,
+                        size_t index,
+                        size_t *inserted)
+{
+	const struct mcc_tac_instruction call = caller->instructions[index];
+	assert(call.op == MCC_TAC_OP_CALL);
+	assert(caller->operands[call.arg2] == callee->parameters_count);
+
+	// Returns may take two instructions, the end label one more.
+	size_t arguments_count = (size_t)callee->parameters_count + 1;
+	uint32_t *arguments = malloc(arguments_count * sizeof(*arguments));
+	struct mcc_tac_instruction *body = malloc((2 * callee->instructions_count + 1) * sizeof(*body));
+	uint32_t *operands = NULL;
+	size_t operands_capacity = 0;
+	bool ok = arguments && body;
+	if (ok) {
+		memcpy(arguments, &caller->operands[call.arg2], arguments_count * sizeof(*arguments));
+	}
+
+	// Variable `v` of the callee becomes `variables + v` of the caller, label
+	// `l` becomes `labels + l`.
+	uint32_t variables = caller->variables_count;
+	for (uint32_t v = 1; ok && v <= callee->variables_count; v++) {
+		enum mcc_tac_type type = mcc_tac_function_variable_type(callee, v);
+		ok = mcc_tac_function_new_variable(caller, type).identifier == variables + v;
+	}
+	uint32_t labels = caller->labels_count;
+	for (uint32_t l = 1; ok && l <= callee->labels_count; l++) {
+		mcc_tac_function_new_label(caller);
+	}
+	uint32_t end = ok ? mcc_tac_function_new_label(caller) : 0;
+
+	size_t last = callee->instructions_count;
+	while (last > 0 && callee->instructions[last - 1].op == MCC_TAC_OP_NOP) {
+		last--;
+	}
+
+	size_t count = 0;
+	for (size_t i = 0; ok && i < callee->instructions_count; i++) {
+		struct mcc_tac_instruction instruction = callee->instructions[i];
+
+		switch ((enum mcc_tac_op)instruction.op) {
+		case MCC_TAC_OP_NOP:
+			continue;
+
+		case MCC_TAC_OP_PARAM:
+			body[count++] = (struct mcc_tac_instruction){
+			    .op = MCC_TAC_OP_ASSIGN,
+			    .type = instruction.type,
+			    .result = variables + instruction.result,
+			    .arg1 = arguments[instruction.arg1 + 1],
+			};
+			continue;
+
+		case MCC_TAC_OP_RETURN:
+			if (call.result != 0 && instruction.arg1 != 0) {
+				body[count++] = (struct mcc_tac_instruction){
+				    .op = MCC_TAC_OP_ASSIGN,
+				    .type = call.type,
+				    .result = call.result,
+				    .arg1 = variables + instruction.arg1,
+				};
+			}
+			if (i + 1 < last) {
+				body[count++] = (struct mcc_tac_instruction){.op = MCC_TAC_OP_JUMP, .arg2 = end};
+			}
+			continue;
+
+		case MCC_TAC_OP_CONST:
+			if (instruction.type == MCC_TAC_TYPE_STRING) {
+				ok = mcc_tac_function_add_string(caller, callee->strings[instruction.arg1],
+				                                 &instruction.arg1);
+			} else {
+				ok = mcc_tac_function_add_constant(caller, callee->constants[instruction.arg1],
+				                                   &instruction.arg1);
+			}
+			break;
+
+		case MCC_TAC_OP_CALL: {
+			const uint32_t *from = &callee->operands[instruction.arg2];
+			if (!mcc_array_reserve(&operands, &operands_capacity, (size_t)from[0] + 1, sizeof(*operands))) {
+				ok = false;
+				break;
+			}
+			operands[0] = from[0];
+			for (uint32_t a = 1; a <= from[0]; a++) {
+				operands[a] = variables + from[a];
+			}
+			ok = mcc_tac_function_add_string(caller, callee->strings[instruction.arg1],
+			                                 &instruction.arg1) &&
+			     mcc_tac_function_add_operands(caller, operands, (size_t)from[0] + 1, &instruction.arg2);
+			if (instruction.result != 0) {
+				instruction.result += variables;
+			}
+			body[count++] = instruction;
+			continue;
+		}
+
+		case MCC_TAC_OP_LABEL:
+		case MCC_TAC_OP_JUMP:
+		case MCC_TAC_OP_JUMP_IF:
+		case MCC_TAC_OP_JUMP_IF_NOT:
+			instruction.arg2 += labels;
+			break;
+
+		case MCC_TAC_OP_ARRAY:
+		case MCC_TAC_OP_PHI:
+			assert(!"callees creating arrays or in SSA form are not inlined");
+			break;
+
+		default:
+			break;
+		}
+
+		// Only calls read operand lists, the caller is passed for them.
+		mcc_tac_function_visit_uses(caller, &instruction, rename_variable, &variables);
+		if (mcc_tac_instruction_definition(&instruction) != 0) {
+			instruction.result += variables;
+		}
+		body[count++] = instruction;
+	}
+
+	if (ok) {
+		body[count++] = (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL, .arg2 = end};
+		ok = mcc_tac_function_insert(caller, index + 1, body, count);
+	}
+	if (ok) {
+		mcc_tac_function_remove(caller, index);
+		*inserted = count;
+	}
+
+	free(arguments);
+	free(body);
+	free(operands);
+	return ok;
+}
+
+static bool inline_calls(struct mcc_tac_program *program,
+                         const struct mcc_callgraph *graph,
+                         uint32_t f,
+                         const struct mcc_inline_options *options,
+                         struct mcc_inline_stats *stats)
+{
+	struct mcc_tac_function *caller = &program->functions[f];
+	struct sites sites = {0};
+	bool ok = find_sites(program, graph, f, &sites);
+
+	// Inserting after a call leaves the indices of earlier calls intact.
+	for (size_t s = sites.sites_count; ok && s-- > 0;) {
+		const struct site *site = &sites.sites[s];
+		const struct mcc_tac_function *callee =
+		    find_callee(program, caller, &caller->instructions[site->index]);
+
+		size_t cost = cost_of(callee);
+		size_t limit = site->in_loop ? 2 * options->threshold : options->threshold;
+		if (cost > limit || size_of(caller) + cost > options->max_size ||
+		    mcc_tac_function_creates_arrays(callee)) {
+			continue;
+		}
+
+		size_t inserted = 0;
+		ok = inline_call(caller, callee, site->index, &inserted);
+		if (ok) {
+			stats->inlined++;
+			stats->instructions += inserted;
+		}
+	}
+
+	free(sites.sites);
+	return ok;
+}
+
+bool mcc_inline_program(struct mcc_tac_program *program,
+                        const struct mcc_inline_options *options,
+                        struct mcc_inline_stats *stats)
+{
+	assert(program);
+
+	struct mcc_inline_options resolved = {
+	    .threshold = options && options->threshold ? options->threshold : MCC_INLINE_DEFAULT_THRESHOLD,
+	    .max_size = options && options->max_size ? options->max_size : MCC_INLINE_DEFAULT_MAX_SIZE,
+	};
+	struct mcc_inline_stats counts = {0};
+
+	struct mcc_callgraph graph;
+	bool ok = mcc_callgraph_build(&graph, program);
+	for (size_t k = 0; ok && k < graph.functions_count; k++) {
+		ok = inline_calls(program, &graph, graph.order[k], &resolved, &counts);
+	}
+	mcc_callgraph_deinit(&graph);
+
+	if (stats) {
+		stats->inlined += counts.inlined;
+		stats->instructions += counts.instructions;
+	}
+	return ok;
+}
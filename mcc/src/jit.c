@@ -0,0 +1,1230 @@
+// MAP_ANONYMOUS is not part of POSIX.1-2008.
+#define _DEFAULT_SOURCE
+
+#include "mcc/jit.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/memoize.h"
+#include "memo_table.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define SUPPORTED 1
+#include <sys/mman.h>
+#endif
+
+// --------------------------------------------------------------------- Errors
+
+static void jit_error(struct mcc_jit_result *result, enum mcc_jit_error error, const char *format, ...)
+{
+	result->error = error;
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(result->error_msg, sizeof(result->error_msg), format, args);
+	va_end(args);
+}
+
+void mcc_jit_result_print_error(FILE *out, const struct mcc_jit_result *result)
+{
+	assert(out);
+	assert(result);
+
+	if (*result->error_msg) {
+		fprintf(out, "%s\n", result->error_msg);
+		return;
+	}
+
+	switch (result->error) {
+	case MCC_JIT_ERROR_NONE:
+		fputs("no error\n", out);
+		break;
+	case MCC_JIT_ERROR_ALLOCATION_ERROR:
+		fputs("allocation error\n", out);
+		break;
+	case MCC_JIT_ERROR_INVALID_PROGRAM:
+		fputs("invalid program\n", out);
+		break;
+	case MCC_JIT_ERROR_UNKNOWN_FUNCTION:
+		fputs("unknown function\n", out);
+		break;
+	case MCC_JIT_ERROR_MAPPING_ERROR:
+		fputs("unable to map executable memory\n", out);
+		break;
+	case MCC_JIT_ERROR_UNSUPPORTED:
+		fputs("the JIT is not supported on this platform\n", out);
+		break;
+	}
+}
+
+#ifdef SUPPORTED
+
+// ------------------------------------------------------------------ Builtins
+
+// Streams of the running program, set for the duration of a call.
+static _Thread_local FILE *builtin_in;
+static _Thread_local FILE *builtin_out;
+static _Thread_local struct mcc_memo_table *builtin_memo;
+
+// Mirror resources/mc_builtins.c.
+// Like the interpreter, strings never assigned print as empty.
+static void builtin_print(const char *msg)
+{
+	fputs(msg ? msg : "", builtin_out);
+}
+
+static void builtin_print_nl(void)
+{
+	fputc('\n', builtin_out);
+}
+
+static void builtin_print_int(int x)
+{
+	fprintf(builtin_out, "%d", x);
+}
+
+static void builtin_print_float(float x)
+{
+	fprintf(builtin_out, "%.2f", (double)x);
+}
+
+static int builtin_read_int(void)
+{
+	int ret = 0;
+	if (fscanf(builtin_in, "%d", &ret) != 1) {
+		ret = 0;
+	}
+	return ret;
+}
+
+static float builtin_read_float(void)
+{
+	float ret = 0.0f;
+	if (fscanf(builtin_in, "%f", &ret) != 1) {
+		ret = 0.0f;
+	}
+	return ret;
+}
+
+// Runtime functions of memoisation, keys and values are bit patterns.
+static int builtin_memo_find(uint32_t table, uint32_t key1, uint32_t key2)
+{
+	return mcc_memo_table_find(builtin_memo, table, key1, key2);
+}
+
+static uint32_t builtin_memo_get(void)
+{
+	return mcc_memo_table_get(builtin_memo);
+}
+
+static void builtin_memo_put(uint32_t table, uint32_t key1, uint32_t key2, uint32_t value)
+{
+	mcc_memo_table_put(builtin_memo, table, key1, key2, value);
+}
+
+enum builtin {
+	BUILTIN_PRINT,
+	BUILTIN_PRINT_NL,
+	BUILTIN_PRINT_INT,
+	BUILTIN_PRINT_FLOAT,
+	BUILTIN_READ_INT,
+	BUILTIN_READ_FLOAT,
+	BUILTIN_MEMO_FIND,
+	BUILTIN_MEMO_GET,
+	BUILTIN_MEMO_PUT,
+};
+
+static const struct {
+	const char *name;
+	size_t parameters_count;
+} builtins[] = {
+    [BUILTIN_PRINT] = {"print", 1},
+    [BUILTIN_PRINT_NL] = {"print_nl", 0},
+    [BUILTIN_PRINT_INT] = {"print_int", 1},
+    [BUILTIN_PRINT_FLOAT] = {"print_float", 1},
+    [BUILTIN_READ_INT] = {"read_int", 0},
+    [BUILTIN_READ_FLOAT] = {"read_float", 0},
+    [BUILTIN_MEMO_FIND] = {MCC_MEMOIZE_FIND, 3},
+    [BUILTIN_MEMO_GET] = {MCC_MEMOIZE_GET, 0},
+    [BUILTIN_MEMO_PUT] = {MCC_MEMOIZE_PUT, 4},
+};
+
+static uint64_t builtin_address(enum builtin builtin)
+{
+	switch (builtin) {
+	case BUILTIN_PRINT:
+		return (uint64_t)(uintptr_t)builtin_print;
+	case BUILTIN_PRINT_NL:
+		return (uint64_t)(uintptr_t)builtin_print_nl;
+	case BUILTIN_PRINT_INT:
+		return (uint64_t)(uintptr_t)builtin_print_int;
+	case BUILTIN_PRINT_FLOAT:
+		return (uint64_t)(uintptr_t)builtin_print_float;
+	case BUILTIN_READ_INT:
+		return (uint64_t)(uintptr_t)builtin_read_int;
+	case BUILTIN_READ_FLOAT:
+		return (uint64_t)(uintptr_t)builtin_read_float;
+	case BUILTIN_MEMO_FIND:
+		return (uint64_t)(uintptr_t)builtin_memo_find;
+	case BUILTIN_MEMO_GET:
+		return (uint64_t)(uintptr_t)builtin_memo_get;
+	case BUILTIN_MEMO_PUT:
+		return (uint64_t)(uintptr_t)builtin_memo_put;
+	}
+
+	assert(false);
+	return 0;
+}
+
+// ------------------------------------------------------------------ Encoding
+
+enum reg {
+	RAX = 0,
+	RCX = 1,
+	RDX = 2,
+	RSI = 6,
+	RDI = 7,
+};
+
+// Low nibbles of the condition codes of SETcc and Jcc.
+enum condition {
+	CONDITION_B = 0x2,
+	CONDITION_AE = 0x3,
+	CONDITION_E = 0x4,
+	CONDITION_NE = 0x5,
+	CONDITION_A = 0x7,
+	CONDITION_P = 0xa,
+	CONDITION_NP = 0xb,
+	CONDITION_L = 0xc,
+	CONDITION_GE = 0xd,
+	CONDITION_LE = 0xe,
+	CONDITION_G = 0xf,
+};
+
+// A rel32 operand to be patched once the target's offset is known.
+struct fixup {
+	size_t at;
+	uint32_t target;
+};
+
+struct emitter {
+	uint8_t *bytes;
+	size_t count;
+	size_t capacity;
+	bool failed;
+};
+
+static void emit_bytes(struct emitter *e, const void *bytes, size_t count)
+{
+	for (size_t i = 0; i < count && !e->failed; i++) {
+		if (!mcc_array_push(e->bytes, e->count, e->capacity, ((const uint8_t *)bytes)[i])) {
+			e->failed = true;
+		}
+	}
+}
+
+#define EMIT(e, ...) \
+	do { \
+		static const uint8_t bytes_[] = {__VA_ARGS__}; \
+		emit_bytes((e), bytes_, sizeof(bytes_)); \
+	} while (0)
+
+static void emit_u32(struct emitter *e, uint32_t value)
+{
+	uint8_t bytes[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+	emit_bytes(e, bytes, sizeof(bytes));
+}
+
+static void emit_u64(struct emitter *e, uint64_t value)
+{
+	emit_u32(e, (uint32_t)value);
+	emit_u32(e, (uint32_t)(value >> 32));
+}
+
+static void patch_u32(struct emitter *e, size_t at, uint32_t value)
+{
+	uint8_t bytes[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+	memcpy(e->bytes + at, bytes, sizeof(bytes));
+}
+
+// Emits `opcode` with a ModRM byte addressing [rbp - 8 * slot] and `reg` in
+// its register field. Prefixes are part of `opcode`.
+static void emit_slot(struct emitter *e, const uint8_t *opcode, size_t length, unsigned reg, uint32_t slot)
+{
+	emit_bytes(e, opcode, length);
+	uint8_t modrm = (uint8_t)(0x80 | (reg << 3) | 5);
+	emit_bytes(e, &modrm, 1);
+	emit_u32(e, (uint32_t)(-(int64_t)slot * 8));
+}
+
+#define EMIT_SLOT(e, reg, slot, ...) \
+	do { \
+		static const uint8_t opcode_[] = {__VA_ARGS__}; \
+		emit_slot((e), opcode_, sizeof(opcode_), (reg), (slot)); \
+	} while (0)
+
+// mov r32, [slot]
+static void load32(struct emitter *e, enum reg reg, uint32_t slot)
+{
+	EMIT_SLOT(e, reg, slot, 0x8b);
+}
+
+// mov [slot], r32
+static void store32(struct emitter *e, uint32_t slot, enum reg reg)
+{
+	EMIT_SLOT(e, reg, slot, 0x89);
+}
+
+// mov r64, [slot]
+static void load64(struct emitter *e, enum reg reg, uint32_t slot)
+{
+	EMIT_SLOT(e, reg, slot, 0x48, 0x8b);
+}
+
+// mov [slot], r64
+static void store64(struct emitter *e, uint32_t slot, enum reg reg)
+{
+	EMIT_SLOT(e, reg, slot, 0x48, 0x89);
+}
+
+// movss xmm0, [slot]
+static void load_float(struct emitter *e, uint32_t slot)
+{
+	EMIT_SLOT(e, 0, slot, 0xf3, 0x0f, 0x10);
+}
+
+// movss [slot], xmm0
+static void store_float(struct emitter *e, uint32_t slot)
+{
+	EMIT_SLOT(e, 0, slot, 0xf3, 0x0f, 0x11);
+}
+
+// setcc al; movzx eax, al
+static void emit_setcc(struct emitter *e, enum condition condition)
+{
+	uint8_t bytes[] = {0x0f, (uint8_t)(0x90 | condition), 0xc0, 0x0f, 0xb6, 0xc0};
+	emit_bytes(e, bytes, sizeof(bytes));
+}
+
+// mov rax, imm64; call rax
+static void emit_call_absolute(struct emitter *e, uint64_t address)
+{
+	EMIT(e, 0x48, 0xb8);
+	emit_u64(e, address);
+	EMIT(e, 0xff, 0xd0);
+}
+
+// --------------------------------------------------------------- Compilation
+
+struct compiler {
+	const struct mcc_tac_program *program;
+	const struct mcc_tac_function *function;
+	struct emitter *emitter;
+	struct mcc_jit_result *result;
+
+	// Number of definitions and uses of each variable.
+	uint32_t *definitions;
+	uint32_t *uses;
+
+	// Code offset of each label, SIZE_MAX if not placed.
+	size_t *labels;
+
+	// Jumps to labels of the current function, calls to functions of the
+	// program.
+	struct fixup *jumps;
+	size_t jumps_count;
+	size_t jumps_capacity;
+	struct fixup **calls;
+	size_t *calls_count;
+	size_t *calls_capacity;
+
+	// Slot of the first array element past the variables.
+	uint64_t arrays_size;
+
+	// Whether the function creates arrays, and the slot keeping the pointer
+	// to its arguments for sibling calls, 0 if it makes none.
+	bool creates_arrays;
+	uint32_t incoming_slot;
+};
+
+#define failed() (compiler->result->error != MCC_JIT_ERROR_NONE || compiler->emitter->failed)
+
+static void count_use(uint32_t *variable, void *userdata)
+{
+	uint32_t *uses = userdata;
+	uses[*variable]++;
+}
+
+static bool is_temporary(const struct compiler *compiler, uint32_t variable)
+{
+	return variable != 0 && compiler->definitions[variable] == 1 && compiler->uses[variable] == 1;
+}
+
+static void add_fixup(struct compiler *compiler,
+                      struct fixup **fixups,
+                      size_t *count,
+                      size_t *capacity,
+                      uint32_t target)
+{
+	struct emitter *e = compiler->emitter;
+	struct fixup fixup = {.at = e->count, .target = target};
+	if (!mcc_array_push(*fixups, *count, *capacity, fixup)) {
+		e->failed = true;
+	}
+	emit_u32(e, 0);
+}
+
+// Emits a jump with the given opcode bytes to `label`.
+static void emit_jump(struct compiler *compiler, const uint8_t *opcode, size_t length, uint32_t label)
+{
+	emit_bytes(compiler->emitter, opcode, length);
+	add_fixup(compiler, &compiler->jumps, &compiler->jumps_count, &compiler->jumps_capacity, label);
+}
+
+static void emit_jcc(struct compiler *compiler, enum condition condition, uint32_t label)
+{
+	uint8_t opcode[] = {0x0f, (uint8_t)(0x80 | condition)};
+	emit_jump(compiler, opcode, sizeof(opcode), label);
+}
+
+static enum condition int_condition(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_EQ:
+		return CONDITION_E;
+	case MCC_TAC_OP_NE:
+		return CONDITION_NE;
+	case MCC_TAC_OP_LT:
+		return CONDITION_L;
+	case MCC_TAC_OP_LE:
+		return CONDITION_LE;
+	case MCC_TAC_OP_GT:
+		return CONDITION_G;
+	case MCC_TAC_OP_GE:
+		return CONDITION_GE;
+	default:
+		assert(false);
+		return CONDITION_E;
+	}
+}
+
+// Condition codes come in pairs differing in the lowest bit.
+static enum condition negated(enum condition condition)
+{
+	return (enum condition)(condition ^ 1);
+}
+
+// Returns whether the divisor of the division at `i` is a constant assigned
+// earlier in the same block, and its value.
+static bool constant_divisor(const struct compiler *compiler, size_t i, int32_t *divisor)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	uint32_t variable = function->instructions[i].arg2;
+	while (i > 0) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[--i];
+		switch ((enum mcc_tac_op)instruction->op) {
+		case MCC_TAC_OP_LABEL:
+		case MCC_TAC_OP_JUMP:
+		case MCC_TAC_OP_JUMP_IF:
+		case MCC_TAC_OP_JUMP_IF_NOT:
+		case MCC_TAC_OP_RETURN:
+			return false;
+		default:
+			break;
+		}
+		if (mcc_tac_instruction_definition(instruction) == variable) {
+			if (instruction->op != MCC_TAC_OP_CONST || instruction->type != MCC_TAC_TYPE_INT) {
+				return false;
+			}
+			*divisor = (int32_t)mcc_tac_bits_int(function->constants[instruction->arg1]);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Computes the multiplier and shift dividing by `divisor`, where
+// 2 <= |divisor|, following Hacker's Delight, section 10-4. The quotient is
+// the high half of the product of multiplier and dividend, corrected by the
+// dividend if their signs differ, shifted right, plus one if negative.
+static void division_magic(int32_t divisor, int32_t *multiplier, unsigned *shift)
+{
+	const uint32_t two31 = UINT32_C(1) << 31;
+	uint32_t absolute = divisor < 0 ? 0u - (uint32_t)divisor : (uint32_t)divisor;
+	uint32_t t = two31 + ((uint32_t)divisor >> 31);
+	uint32_t absolute_nc = t - 1 - t % absolute;
+
+	unsigned p = 31;
+	uint32_t q1 = two31 / absolute_nc;
+	uint32_t r1 = two31 - q1 * absolute_nc;
+	uint32_t q2 = two31 / absolute;
+	uint32_t r2 = two31 - q2 * absolute;
+	uint32_t delta;
+	do {
+		p++;
+		q1 *= 2;
+		r1 *= 2;
+		if (r1 >= absolute_nc) {
+			q1++;
+			r1 -= absolute_nc;
+		}
+		q2 *= 2;
+		r2 *= 2;
+		if (r2 >= absolute) {
+			q2++;
+			r2 -= absolute;
+		}
+		delta = absolute - r2;
+	} while (q1 < delta || (q1 == delta && r1 == 0));
+
+	uint32_t magic = q2 + 1;
+	*multiplier = (int32_t)(divisor < 0 ? 0u - magic : magic);
+	*shift = p - 32;
+}
+
+// Divides eax by the nonzero `divisor` without idiv, the quotient is left in
+// eax. The smallest int divided by -1 wraps around, as in the interpreter and
+// the general path of compile_int_binary.
+static void compile_division_by_constant(struct emitter *e, int32_t divisor)
+{
+	assert(divisor != 0);
+
+	if (divisor == 1) {
+		return;
+	}
+	if (divisor == -1) {
+		// neg eax
+		EMIT(e, 0xf7, 0xd8);
+		return;
+	}
+
+	// Positive powers of two round towards zero by adding divisor - 1 to
+	// negative dividends before shifting.
+	if (divisor > 0 && (divisor & (divisor - 1)) == 0) {
+		uint8_t k = 0;
+		while ((INT32_C(1) << k) != divisor) {
+			k++;
+		}
+		// mov edx, eax; sar edx, 31; shr edx, 32 - k; add eax, edx; sar eax, k
+		EMIT(e, 0x89, 0xc2, 0xc1, 0xfa, 0x1f);
+		uint8_t round[] = {0xc1, 0xea, (uint8_t)(32 - k), 0x01, 0xd0, 0xc1, 0xf8, k};
+		emit_bytes(e, round, sizeof(round));
+		return;
+	}
+
+	int32_t multiplier;
+	unsigned shift;
+	division_magic(divisor, &multiplier, &shift);
+
+	// movsxd rcx, eax; imul rax, rcx, multiplier; sar rax, 32
+	EMIT(e, 0x48, 0x63, 0xc8, 0x48, 0x69, 0xc1);
+	emit_u32(e, (uint32_t)multiplier);
+	EMIT(e, 0x48, 0xc1, 0xf8, 0x20);
+	if (divisor > 0 && multiplier < 0) {
+		// add eax, ecx
+		EMIT(e, 0x01, 0xc8);
+	} else if (divisor < 0 && multiplier > 0) {
+		// sub eax, ecx
+		EMIT(e, 0x29, 0xc8);
+	}
+	if (shift > 0) {
+		// sar eax, shift
+		uint8_t sar[] = {0xc1, 0xf8, (uint8_t)shift};
+		emit_bytes(e, sar, sizeof(sar));
+	}
+	// mov edx, eax; shr edx, 31; add eax, edx
+	EMIT(e, 0x89, 0xc2, 0xc1, 0xea, 0x1f, 0x01, 0xd0);
+}
+
+static void compile_int_binary(struct compiler *compiler, size_t i)
+{
+	struct emitter *e = compiler->emitter;
+	const struct mcc_tac_instruction *instruction = &compiler->function->instructions[i];
+	int32_t divisor;
+	load32(e, RAX, instruction->arg1);
+
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_ADD:
+		EMIT_SLOT(e, RAX, instruction->arg2, 0x03);
+		break;
+	case MCC_TAC_OP_SUB:
+		EMIT_SLOT(e, RAX, instruction->arg2, 0x2b);
+		break;
+	case MCC_TAC_OP_MUL:
+		EMIT_SLOT(e, RAX, instruction->arg2, 0x0f, 0xaf);
+		break;
+	case MCC_TAC_OP_DIV:
+		if (constant_divisor(compiler, i, &divisor) && divisor != 0) {
+			compile_division_by_constant(e, divisor);
+			break;
+		}
+		// idiv faults on the smallest int divided by -1, which is negated
+		// instead so the quotient wraps like in the interpreter.
+		// mov ecx, [slot]; cmp ecx, -1; jne .idiv; neg eax; jmp .done
+		// .idiv: cdq; idiv ecx
+		// .done:
+		EMIT_SLOT(e, RCX, instruction->arg2, 0x8b);
+		EMIT(e, 0x83, 0xf9, 0xff, 0x75, 0x04, 0xf7, 0xd8, 0xeb, 0x03, 0x99, 0xf7, 0xf9);
+		break;
+	case MCC_TAC_OP_AND:
+		EMIT_SLOT(e, RAX, instruction->arg2, 0x23);
+		break;
+	case MCC_TAC_OP_OR:
+		EMIT_SLOT(e, RAX, instruction->arg2, 0x0b);
+		break;
+	default:
+		// cmp eax, [slot]
+		EMIT_SLOT(e, RAX, instruction->arg2, 0x3b);
+		emit_setcc(e, int_condition(instruction->op));
+		break;
+	}
+
+	store32(e, instruction->result, RAX);
+}
+
+static void compile_float_binary(struct compiler *compiler, const struct mcc_tac_instruction *instruction)
+{
+	struct emitter *e = compiler->emitter;
+	enum mcc_tac_op op = instruction->op;
+
+	if (op >= MCC_TAC_OP_ADD && op <= MCC_TAC_OP_DIV) {
+		static const uint8_t opcodes[] = {0x58, 0x5c, 0x59, 0x5e};
+		load_float(e, instruction->arg1);
+		uint8_t opcode[] = {0xf3, 0x0f, opcodes[op - MCC_TAC_OP_ADD]};
+		emit_slot(e, opcode, sizeof(opcode), 0, instruction->arg2);
+		store_float(e, instruction->result);
+		return;
+	}
+
+	// ucomiss flags an unordered result like "below" and "equal" along with
+	// parity. Less-than is tested as greater-than with swapped operands, so
+	// NaN compares false throughout.
+	bool swap = op == MCC_TAC_OP_LT || op == MCC_TAC_OP_LE;
+	load_float(e, swap ? instruction->arg2 : instruction->arg1);
+	EMIT_SLOT(e, 0, swap ? instruction->arg1 : instruction->arg2, 0x0f, 0x2e);
+
+	switch (op) {
+	case MCC_TAC_OP_EQ:
+		// sete al; setnp cl; and al, cl
+		EMIT(e, 0x0f, 0x94, 0xc0, 0x0f, 0x9b, 0xc1, 0x20, 0xc8, 0x0f, 0xb6, 0xc0);
+		break;
+	case MCC_TAC_OP_NE:
+		// setne al; setp cl; or al, cl
+		EMIT(e, 0x0f, 0x95, 0xc0, 0x0f, 0x9a, 0xc1, 0x08, 0xc8, 0x0f, 0xb6, 0xc0);
+		break;
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_GT:
+		emit_setcc(e, CONDITION_A);
+		break;
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GE:
+		emit_setcc(e, CONDITION_AE);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+	store32(e, instruction->result, RAX);
+}
+
+// Compiles a comparison of ints followed by a conditional jump on its result
+// into a compare-and-branch, returns false if the pair does not qualify.
+static bool compile_branch(struct compiler *compiler,
+                           const struct mcc_tac_instruction *instruction,
+                           const struct mcc_tac_instruction *next)
+{
+	enum mcc_tac_op op = instruction->op;
+	if (!next || op < MCC_TAC_OP_EQ || op > MCC_TAC_OP_GE || instruction->type == MCC_TAC_TYPE_FLOAT ||
+	    (next->op != MCC_TAC_OP_JUMP_IF && next->op != MCC_TAC_OP_JUMP_IF_NOT) ||
+	    next->arg1 != instruction->result || !is_temporary(compiler, instruction->result)) {
+		return false;
+	}
+
+	load32(compiler->emitter, RAX, instruction->arg1);
+	EMIT_SLOT(compiler->emitter, RAX, instruction->arg2, 0x3b);
+	enum condition condition = int_condition(op);
+	emit_jcc(compiler, next->op == MCC_TAC_OP_JUMP_IF ? condition : negated(condition), next->arg2);
+	return true;
+}
+
+static void compile_call(struct compiler *compiler, const struct mcc_tac_instruction *instruction)
+{
+	struct emitter *e = compiler->emitter;
+	const struct mcc_tac_function *function = compiler->function;
+	const char *name = function->strings[instruction->arg1];
+	const uint32_t *arguments = &function->operands[instruction->arg2];
+
+	const struct mcc_tac_function *callee = mcc_tac_program_find_function(compiler->program, name);
+	if (callee) {
+		if (callee->parameters_count != arguments[0]) {
+			jit_error(compiler->result, MCC_JIT_ERROR_INVALID_PROGRAM,
+			          "%s calls %s with %" PRIu32 " arguments", function->name, name, arguments[0]);
+			return;
+		}
+
+		// Arguments are passed in the outgoing area at the bottom of the
+		// frame: mov rax, [slot]; mov [rsp + 8 * i], rax
+		for (uint32_t i = 0; i < arguments[0]; i++) {
+			load64(e, RAX, arguments[i + 1]);
+			EMIT(e, 0x48, 0x89, 0x84, 0x24);
+			emit_u32(e, 8 * i);
+		}
+		// mov rdi, rsp; call rel32
+		EMIT(e, 0x48, 0x89, 0xe7, 0xe8);
+		uint32_t index = (uint32_t)(callee - compiler->program->functions);
+		add_fixup(compiler, compiler->calls, compiler->calls_count, compiler->calls_capacity, index);
+		if (instruction->result) {
+			store64(e, instruction->result, RAX);
+		}
+		return;
+	}
+
+	for (size_t b = 0; b < sizeof(builtins) / sizeof(*builtins); b++) {
+		if (strcmp(builtins[b].name, name) != 0 || builtins[b].parameters_count != arguments[0]) {
+			continue;
+		}
+
+		switch ((enum builtin)b) {
+		case BUILTIN_PRINT:
+			load64(e, RDI, arguments[1]);
+			break;
+		case BUILTIN_PRINT_INT:
+			load32(e, RDI, arguments[1]);
+			break;
+		case BUILTIN_PRINT_FLOAT:
+			load_float(e, arguments[1]);
+			break;
+		case BUILTIN_MEMO_FIND:
+		case BUILTIN_MEMO_PUT: {
+			static const enum reg registers[] = {RDI, RSI, RDX, RCX};
+			for (uint32_t a = 0; a < arguments[0]; a++) {
+				load32(e, registers[a], arguments[a + 1]);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		emit_call_absolute(e, builtin_address((enum builtin)b));
+
+		if (instruction->result && (b == BUILTIN_READ_INT || b == BUILTIN_MEMO_FIND || b == BUILTIN_MEMO_GET)) {
+			store32(e, instruction->result, RAX);
+		} else if (instruction->result && b == BUILTIN_READ_FLOAT) {
+			store_float(e, instruction->result);
+		}
+		return;
+	}
+
+	jit_error(compiler->result, MCC_JIT_ERROR_UNKNOWN_FUNCTION, "%s calls unknown function %s", function->name,
+	          name);
+}
+
+static void compile_epilogue(struct emitter *e)
+{
+	// leave; ret
+	EMIT(e, 0xc9, 0xc3);
+}
+
+// Returns whether the call `instruction` followed by `next` is a sibling
+// call: a call of a program function whose result is returned right away.
+// Its arguments have to fit into the caller's own arguments, and arrays of
+// the caller's frame must not be passed, the frame is gone by the time the
+// callee runs.
+static bool is_sibling_call(const struct compiler *compiler,
+                            const struct mcc_tac_instruction *instruction,
+                            const struct mcc_tac_instruction *next)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	const struct mcc_tac_function *callee =
+	    mcc_tac_program_find_function(compiler->program, function->strings[instruction->arg1]);
+	const uint32_t *arguments = &function->operands[instruction->arg2];
+	if (!callee || !next || next->op != MCC_TAC_OP_RETURN || arguments[0] != callee->parameters_count ||
+	    callee->parameters_count > function->parameters_count) {
+		return false;
+	}
+
+	// Void callees return 0 like a return without value.
+	bool returned = next->arg1 != 0 ? next->arg1 == instruction->result : callee->return_type == MCC_TAC_TYPE_VOID;
+	if (!returned) {
+		return false;
+	}
+
+	for (uint32_t i = 1; compiler->creates_arrays && i <= arguments[0]; i++) {
+		if (mcc_tac_function_variable_type(function, arguments[i]) == MCC_TAC_TYPE_ARRAY) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Replaces the caller's arguments by the callee's, releases the caller's
+// frame, and jumps to the callee, which returns to the caller's caller.
+static void compile_sibling_call(struct compiler *compiler, const struct mcc_tac_instruction *instruction)
+{
+	struct emitter *e = compiler->emitter;
+	const struct mcc_tac_function *function = compiler->function;
+	const uint32_t *arguments = &function->operands[instruction->arg2];
+
+	// mov rcx, [incoming]; mov rax, [slot]; mov [rcx + 8 * i], rax
+	load64(e, RCX, compiler->incoming_slot);
+	for (uint32_t i = 0; i < arguments[0]; i++) {
+		load64(e, RAX, arguments[i + 1]);
+		EMIT(e, 0x48, 0x89, 0x81);
+		emit_u32(e, 8 * i);
+	}
+
+	// mov rdi, rcx; leave; jmp rel32
+	EMIT(e, 0x48, 0x89, 0xcf, 0xc9, 0xe9);
+	const struct mcc_tac_function *callee =
+	    mcc_tac_program_find_function(compiler->program, function->strings[instruction->arg1]);
+	uint32_t index = (uint32_t)(callee - compiler->program->functions);
+	add_fixup(compiler, compiler->calls, compiler->calls_count, compiler->calls_capacity, index);
+}
+
+// Compiles the `i`th instruction, returns the number of instructions
+// consumed.
+static size_t compile_instruction(struct compiler *compiler, size_t i, const struct mcc_tac_instruction *next)
+{
+	struct emitter *e = compiler->emitter;
+	const struct mcc_tac_function *function = compiler->function;
+	const struct mcc_tac_instruction *instruction = &function->instructions[i];
+
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_NOP:
+	case MCC_TAC_OP_PARAM:
+		// Parameters are copied by the prologue.
+		break;
+
+	case MCC_TAC_OP_CONST:
+		if (instruction->type == MCC_TAC_TYPE_STRING) {
+			EMIT(e, 0x48, 0xb8);
+			emit_u64(e, (uint64_t)(uintptr_t)function->strings[instruction->arg1]);
+			store64(e, instruction->result, RAX);
+		} else {
+			uint64_t bits = function->constants[instruction->arg1];
+			uint32_t value;
+			if (instruction->type == MCC_TAC_TYPE_FLOAT) {
+				float f = (float)mcc_tac_bits_float(bits);
+				memcpy(&value, &f, sizeof(value));
+			} else {
+				value = (uint32_t)mcc_tac_bits_int(bits);
+			}
+			// mov dword [slot], imm32
+			EMIT_SLOT(e, 0, instruction->result, 0xc7);
+			emit_u32(e, value);
+		}
+		break;
+
+	case MCC_TAC_OP_ASSIGN:
+		load64(e, RAX, instruction->arg1);
+		store64(e, instruction->result, RAX);
+		break;
+
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+		if (compile_branch(compiler, instruction, next)) {
+			return 2;
+		}
+		if (instruction->type == MCC_TAC_TYPE_FLOAT) {
+			compile_float_binary(compiler, instruction);
+		} else if (instruction->type == MCC_TAC_TYPE_INT || instruction->type == MCC_TAC_TYPE_BOOL) {
+			compile_int_binary(compiler, i);
+		} else {
+			jit_error(compiler->result, MCC_JIT_ERROR_INVALID_PROGRAM, "%s on %s is not supported in %s",
+			          mcc_tac_op_to_string(instruction->op), mcc_tac_type_to_string(instruction->type),
+			          function->name);
+		}
+		break;
+
+	case MCC_TAC_OP_NEG:
+		load32(e, RAX, instruction->arg1);
+		if (instruction->type == MCC_TAC_TYPE_FLOAT) {
+			// xor eax, 0x80000000
+			EMIT(e, 0x35, 0x00, 0x00, 0x00, 0x80);
+		} else {
+			// neg eax
+			EMIT(e, 0xf7, 0xd8);
+		}
+		store32(e, instruction->result, RAX);
+		break;
+
+	case MCC_TAC_OP_NOT:
+		// xor eax, 1
+		load32(e, RAX, instruction->arg1);
+		EMIT(e, 0x83, 0xf0, 0x01);
+		store32(e, instruction->result, RAX);
+		break;
+
+	case MCC_TAC_OP_ARRAY: {
+		// Elements are stored upwards from the array's lowest slot.
+		uint64_t size = function->constants[instruction->arg1];
+		compiler->arrays_size += size;
+		if (size > INT32_MAX || compiler->arrays_size + function->variables_count > INT32_MAX / 16) {
+			jit_error(compiler->result, MCC_JIT_ERROR_INVALID_PROGRAM, "frame of %s is too large",
+			          function->name);
+			break;
+		}
+		// lea rax, [slot]
+		EMIT_SLOT(e, RAX, (uint32_t)(function->variables_count + compiler->arrays_size), 0x48, 0x8d);
+		store64(e, instruction->result, RAX);
+		break;
+	}
+
+	case MCC_TAC_OP_LOAD:
+		// mov rax, [array]; movsxd rcx, dword [index]; mov rax, [rax + 8 * rcx]
+		load64(e, RAX, instruction->arg1);
+		EMIT_SLOT(e, RCX, instruction->arg2, 0x48, 0x63);
+		EMIT(e, 0x48, 0x8b, 0x04, 0xc8);
+		store64(e, instruction->result, RAX);
+		break;
+
+	case MCC_TAC_OP_STORE:
+		// mov rax, [array]; movsxd rcx, dword [index]; mov rdx, [value];
+		// mov [rax + 8 * rcx], rdx
+		load64(e, RAX, instruction->result);
+		EMIT_SLOT(e, RCX, instruction->arg1, 0x48, 0x63);
+		load64(e, RDX, instruction->arg2);
+		EMIT(e, 0x48, 0x89, 0x14, 0xc8);
+		break;
+
+	case MCC_TAC_OP_LABEL:
+		compiler->labels[instruction->arg2] = e->count;
+		break;
+
+	case MCC_TAC_OP_JUMP: {
+		static const uint8_t jmp[] = {0xe9};
+		emit_jump(compiler, jmp, sizeof(jmp), instruction->arg2);
+		break;
+	}
+
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		// test eax, eax
+		load32(e, RAX, instruction->arg1);
+		EMIT(e, 0x85, 0xc0);
+		emit_jcc(compiler, instruction->op == MCC_TAC_OP_JUMP_IF ? CONDITION_NE : CONDITION_E,
+		         instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_CALL:
+		if (is_sibling_call(compiler, instruction, next)) {
+			compile_sibling_call(compiler, instruction);
+			return 2;
+		}
+		compile_call(compiler, instruction);
+		break;
+
+	case MCC_TAC_OP_RETURN:
+		if (instruction->arg1) {
+			load64(e, RAX, instruction->arg1);
+		} else {
+			// xor eax, eax
+			EMIT(e, 0x31, 0xc0);
+		}
+		compile_epilogue(e);
+		break;
+
+	case MCC_TAC_OP_PHI:
+		jit_error(compiler->result, MCC_JIT_ERROR_INVALID_PROGRAM, "%s is in SSA form", function->name);
+		break;
+	}
+
+	return 1;
+}
+
+// Counts definitions, uses, array slots, and outgoing argument slots, and
+// tells whether there are sibling calls.
+static void analyse_function(struct compiler *compiler, uint64_t *arrays_size, uint32_t *outgoing, bool *siblings)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	compiler->creates_arrays = mcc_tac_function_creates_arrays(function);
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		struct mcc_tac_instruction instruction = function->instructions[i];
+		compiler->definitions[mcc_tac_instruction_definition(&instruction)]++;
+
+		// Visiting uses does not modify the function, only the callback
+		// could.
+		mcc_tac_function_visit_uses((struct mcc_tac_function *)function, &instruction, count_use,
+		                            compiler->uses);
+
+		if (instruction.op == MCC_TAC_OP_ARRAY) {
+			*arrays_size += function->constants[instruction.arg1];
+		} else if (instruction.op == MCC_TAC_OP_CALL) {
+			if (function->operands[instruction.arg2] > *outgoing) {
+				*outgoing = function->operands[instruction.arg2];
+			}
+			const struct mcc_tac_instruction *next =
+			    i + 1 < function->instructions_count ? &function->instructions[i + 1] : NULL;
+			*siblings = *siblings || is_sibling_call(compiler, &instruction, next);
+		}
+	}
+}
+
+static void compile_prologue(struct compiler *compiler, uint64_t frame_slots)
+{
+	struct emitter *e = compiler->emitter;
+	const struct mcc_tac_function *function = compiler->function;
+
+	// push rbp; mov rbp, rsp; sub rsp, imm32
+	EMIT(e, 0x55, 0x48, 0x89, 0xe5, 0x48, 0x81, 0xec);
+	emit_u32(e, (uint32_t)(frame_slots * 8));
+
+	// Frames start zeroed: mov rsi, rdi; mov rdi, rsp; mov ecx, imm32;
+	// xor eax, eax; rep stosq
+	EMIT(e, 0x48, 0x89, 0xfe, 0x48, 0x89, 0xe7, 0xb9);
+	emit_u32(e, (uint32_t)frame_slots);
+	EMIT(e, 0x31, 0xc0, 0xf3, 0x48, 0xab);
+
+	// mov rax, [rsi + 8 * index]; mov [slot], rax
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op != MCC_TAC_OP_PARAM) {
+			continue;
+		}
+		if (instruction->arg1 >= function->parameters_count) {
+			jit_error(compiler->result, MCC_JIT_ERROR_INVALID_PROGRAM, "%s has no parameter %" PRIu32,
+			          function->name, instruction->arg1);
+			return;
+		}
+		EMIT(e, 0x48, 0x8b, 0x86);
+		emit_u32(e, 8 * instruction->arg1);
+		store64(e, instruction->result, RAX);
+	}
+
+	if (compiler->incoming_slot) {
+		store64(e, compiler->incoming_slot, RSI);
+	}
+}
+
+static void compile_function(struct compiler *compiler)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	struct emitter *e = compiler->emitter;
+
+	compiler->definitions = calloc((size_t)function->variables_count + 1, sizeof(*compiler->definitions));
+	compiler->uses = calloc((size_t)function->variables_count + 1, sizeof(*compiler->uses));
+	compiler->labels = malloc(((size_t)function->labels_count + 1) * sizeof(*compiler->labels));
+	if (!compiler->definitions || !compiler->uses || !compiler->labels) {
+		e->failed = true;
+		return;
+	}
+	for (size_t i = 0; i <= function->labels_count; i++) {
+		compiler->labels[i] = SIZE_MAX;
+	}
+
+	// The frame holds the variables, the arrays, the pointer to the
+	// arguments if there are sibling calls, and the outgoing arguments, in
+	// this order from the top. Its size keeps rsp 16-byte aligned.
+	uint64_t arrays_size = 0;
+	uint32_t outgoing = 0;
+	bool siblings = false;
+	analyse_function(compiler, &arrays_size, &outgoing, &siblings);
+	uint64_t frame_slots = (uint64_t)function->variables_count + arrays_size + siblings + outgoing;
+	frame_slots += frame_slots % 2;
+	if (frame_slots > INT32_MAX / 16) {
+		jit_error(compiler->result, MCC_JIT_ERROR_INVALID_PROGRAM, "frame of %s is too large", function->name);
+		return;
+	}
+	compiler->incoming_slot = siblings ? (uint32_t)(function->variables_count + arrays_size + 1) : 0;
+
+	compile_prologue(compiler, frame_slots);
+
+	for (size_t i = 0; i < function->instructions_count && !failed();) {
+		const struct mcc_tac_instruction *next =
+		    i + 1 < function->instructions_count ? &function->instructions[i + 1] : NULL;
+		i += compile_instruction(compiler, i, next);
+	}
+
+	// Functions may run off their end only if they are void: xor eax, eax
+	EMIT(e, 0x31, 0xc0);
+	compile_epilogue(e);
+	if (failed()) {
+		return;
+	}
+
+	for (size_t i = 0; i < compiler->jumps_count; i++) {
+		const struct fixup *jump = &compiler->jumps[i];
+		if (jump->target > function->labels_count || compiler->labels[jump->target] == SIZE_MAX) {
+			jit_error(compiler->result, MCC_JIT_ERROR_INVALID_PROGRAM,
+			          "%s jumps to L%" PRIu32 ", which is not placed", function->name, jump->target);
+			return;
+		}
+		patch_u32(e, jump->at, (uint32_t)(compiler->labels[jump->target] - (jump->at + 4)));
+	}
+}
+
+struct mcc_jit_result mcc_jit_compile(struct mcc_jit *jit, const struct mcc_tac_program *program)
+{
+	assert(jit);
+	assert(program);
+
+	struct mcc_jit_result result = {0};
+	*jit = (struct mcc_jit){
+	    .entries = calloc(program->functions_count + 1, sizeof(*jit->entries)),
+	    .functions_count = program->functions_count,
+	    .program = program,
+	};
+
+	struct emitter emitter = {.failed = !jit->entries};
+	struct fixup *calls = NULL;
+	size_t calls_count = 0;
+	size_t calls_capacity = 0;
+
+	for (size_t f = 0; f < program->functions_count && !result.error && !emitter.failed; f++) {
+		// Entries are 16-byte aligned: int3 padding
+		while (emitter.count % 16 != 0 && !emitter.failed) {
+			EMIT(&emitter, 0xcc);
+		}
+		jit->entries[f] = emitter.count;
+
+		struct compiler compiler = {
+		    .program = program,
+		    .function = &program->functions[f],
+		    .emitter = &emitter,
+		    .result = &result,
+		    .calls = &calls,
+		    .calls_count = &calls_count,
+		    .calls_capacity = &calls_capacity,
+		};
+		compile_function(&compiler);
+
+		free(compiler.definitions);
+		free(compiler.uses);
+		free(compiler.labels);
+		free(compiler.jumps);
+	}
+
+	if (!result.error && !emitter.failed) {
+		for (size_t i = 0; i < calls_count; i++) {
+			patch_u32(&emitter, calls[i].at, (uint32_t)(jit->entries[calls[i].target] - (calls[i].at + 4)));
+		}
+
+		void *code = mmap(NULL, emitter.count ? emitter.count : 1, PROT_READ | PROT_WRITE,
+		                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (code == MAP_FAILED) {
+			jit_error(&result, MCC_JIT_ERROR_MAPPING_ERROR, "unable to map executable memory");
+		} else {
+			memcpy(code, emitter.bytes, emitter.count);
+			jit->code = code;
+			jit->code_size = emitter.count ? emitter.count : 1;
+			if (mprotect(code, jit->code_size, PROT_READ | PROT_EXEC) != 0) {
+				jit_error(&result, MCC_JIT_ERROR_MAPPING_ERROR, "unable to map executable memory");
+			}
+		}
+	}
+	if (emitter.failed && !result.error) {
+		result.error = MCC_JIT_ERROR_ALLOCATION_ERROR;
+	}
+
+	free(emitter.bytes);
+	free(calls);
+	return result;
+}
+
+void mcc_jit_deinit(struct mcc_jit *jit)
+{
+	assert(jit);
+
+	if (jit->code) {
+		munmap(jit->code, jit->code_size);
+	}
+	free(jit->entries);
+}
+
+struct mcc_jit_result mcc_jit_call(const struct mcc_jit *jit,
+                                   const char *name,
+                                   const union mcc_vm_value *arguments,
+                                   size_t arguments_count,
+                                   const struct mcc_jit_options *options)
+{
+	assert(jit);
+	assert(jit->code);
+	assert(name);
+	assert(arguments || arguments_count == 0);
+
+	struct mcc_jit_result result = {0};
+	const struct mcc_tac_function *function = mcc_tac_program_find_function(jit->program, name);
+	if (!function) {
+		jit_error(&result, MCC_JIT_ERROR_UNKNOWN_FUNCTION, "unknown function %s", name);
+		return result;
+	}
+	if (function->parameters_count != arguments_count) {
+		jit_error(&result, MCC_JIT_ERROR_INVALID_PROGRAM, "%s takes %zu arguments", name,
+		          function->parameters_count);
+		return result;
+	}
+
+	// Object pointers cannot be converted to function pointers in ISO C,
+	// their representation can be copied though.
+	uint64_t (*entry)(const union mcc_vm_value *arguments);
+	const uint8_t *address = (const uint8_t *)jit->code + jit->entries[function - jit->program->functions];
+	memcpy(&entry, &address, sizeof(entry));
+
+	FILE *in = builtin_in;
+	FILE *out = builtin_out;
+	struct mcc_memo_table *memo = builtin_memo;
+	struct mcc_memo_table table = {0};
+	builtin_in = options && options->in ? options->in : stdin;
+	builtin_out = options && options->out ? options->out : stdout;
+	builtin_memo = &table;
+
+	uint64_t value = entry(arguments);
+	memcpy(&result.value, &value, sizeof(result.value));
+
+	mcc_memo_table_deinit(&table);
+	builtin_in = in;
+	builtin_out = out;
+	builtin_memo = memo;
+	return result;
+}
+
+#else // SUPPORTED
+
+struct mcc_jit_result mcc_jit_compile(struct mcc_jit *jit, const struct mcc_tac_program *program)
+{
+	assert(jit);
+	assert(program);
+
+	*jit = (struct mcc_jit){.program = program};
+	struct mcc_jit_result result = {.error = MCC_JIT_ERROR_UNSUPPORTED};
+	return result;
+}
+
+void mcc_jit_deinit(struct mcc_jit *jit)
+{
+	assert(jit);
+}
+
+struct mcc_jit_result mcc_jit_call(const struct mcc_jit *jit,
+                                   const char *name,
+                                   const union mcc_vm_value *arguments,
+                                   size_t arguments_count,
+                                   const struct mcc_jit_options *options)
+{
+	(void)jit;
+	(void)name;
+	(void)arguments;
+	(void)arguments_count;
+	(void)options;
+
+	struct mcc_jit_result result = {.error = MCC_JIT_ERROR_UNSUPPORTED};
+	return result;
+}
+
+#endif // SUPPORTED
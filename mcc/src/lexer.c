@@ -15,6 +15,24 @@ const char *mcc_token_to_string(enum mcc_token token)
 		return "true";
 	case MCC_TOKEN_FALSE:
 		return "false";
+	case MCC_TOKEN_BOOL:
+		return "bool";
+	case MCC_TOKEN_INT:
+		return "int";
+	case MCC_TOKEN_FLOAT:
+		return "float";
+	case MCC_TOKEN_STRING:
+		return "string";
+	case MCC_TOKEN_VOID:
+		return "void";
+	case MCC_TOKEN_IF:
+		return "if";
+	case MCC_TOKEN_ELSE:
+		return "else";
+	case MCC_TOKEN_WHILE:
+		return "while";
+	case MCC_TOKEN_RETURN:
+		return "return";
 	case MCC_TOKEN_INT_LITERAL:
 		return "int literal";
 	case MCC_TOKEN_FLOAT_LITERAL:
@@ -25,12 +43,46 @@ const char *mcc_token_to_string(enum mcc_token token)
 		return "(";
 	case MCC_TOKEN_PARENTH_RIGHT:
 		return ")";
+	case MCC_TOKEN_BRACKET_LEFT:
+		return "[";
+	case MCC_TOKEN_BRACKET_RIGHT:
+		return "]";
+	case MCC_TOKEN_BRACE_LEFT:
+		return "{";
+	case MCC_TOKEN_BRACE_RIGHT:
+		return "}";
+	case MCC_TOKEN_SEMICOLON:
+		return ";";
+	case MCC_TOKEN_COMMA:
+		return ",";
 	case MCC_TOKEN_PLUS:
 		return "+";
+	case MCC_TOKEN_MINUS:
+		return "-";
 	case MCC_TOKEN_ASTERISK:
 		return "*";
 	case MCC_TOKEN_SLASH:
 		return "/";
+	case MCC_TOKEN_LESS:
+		return "<";
+	case MCC_TOKEN_GREATER:
+		return ">";
+	case MCC_TOKEN_LESS_EQUAL:
+		return "<=";
+	case MCC_TOKEN_GREATER_EQUAL:
+		return ">=";
+	case MCC_TOKEN_AND:
+		return "&&";
+	case MCC_TOKEN_OR:
+		return "||";
+	case MCC_TOKEN_EQUAL:
+		return "==";
+	case MCC_TOKEN_NOT_EQUAL:
+		return "!=";
+	case MCC_TOKEN_NOT:
+		return "!";
+	case MCC_TOKEN_ASSIGN:
+		return "=";
 	case MCC_TOKEN_EOF:
 		return "<EOF>";
 	case MCC_TOKEN_UNKNOWN:
@@ -111,6 +163,10 @@ static void lexer_buffer_add(struct mcc_lexer *lexer, char c)
 	}
 
 	lexer->buffer[lexer->buffer_index++] = c;
+
+	if (lexer->buffer_index > lexer->stats.buffer_high_water) {
+		lexer->stats.buffer_high_water = lexer->buffer_index;
+	}
 }
 
 static void lexer_buffer_reset(struct mcc_lexer *lexer)
@@ -125,51 +181,20 @@ static bool lexer_buffer_cmp(struct mcc_lexer *lexer, const char *s)
 	return strlen(s) == lexer->buffer_index && strncmp(s, lexer->buffer, lexer->buffer_index) == 0;
 }
 
-static void lexer_grow_strings(struct mcc_lexer *lexer)
+static const char *lexer_add_string(struct mcc_lexer *lexer, const char *s, size_t n)
 {
 	assert(lexer);
 
-	if (lexer->error) {
-		return;
-	}
-
-	size_t new_capacity = lexer->strings_capacity * 2;
-	void *new_strings = realloc(lexer->strings, sizeof(lexer->strings[0]) * new_capacity);
-	if (!new_strings) {
-		lexer->error = MCC_LEXER_ERROR_ALLOCATION_ERROR;
-		return;
-	}
-
-	lexer->strings = new_strings;
-	lexer->strings_capacity = new_capacity;
-}
-
-static char *lexer_add_string(struct mcc_lexer *lexer, const char *s, size_t n)
-{
-	assert(lexer);
-
-	if (lexer->error) {
-		return NULL;
-	}
-
-	if (lexer->strings_count == lexer->strings_capacity) {
-		lexer_grow_strings(lexer);
-	}
-
 	if (lexer->error) {
 		return NULL;
 	}
 
-	char *new_string = strndup(s, n);
-	if (!new_string) {
+	const char *string = mcc_string_pool_intern(&lexer->strings, s, n);
+	if (!string) {
 		lexer->error = MCC_LEXER_ERROR_ALLOCATION_ERROR;
-		return NULL;
 	}
 
-	assert(lexer->strings_count < lexer->strings_capacity);
-	lexer->strings[lexer->strings_count++] = new_string;
-
-	return new_string;
+	return string;
 }
 
 // Grabs the next character from the input stream. Updates `sloc` accordingly.
@@ -210,6 +235,12 @@ static bool lexer_accept(struct mcc_lexer *lexer, char c)
 	return false;
 }
 
+// Keywords are spelled exactly like their `mcc_token_to_string` counterpart.
+static const enum mcc_token keywords[] = {
+    MCC_TOKEN_TRUE,   MCC_TOKEN_FALSE, MCC_TOKEN_BOOL, MCC_TOKEN_INT,   MCC_TOKEN_FLOAT,  MCC_TOKEN_STRING,
+    MCC_TOKEN_VOID,   MCC_TOKEN_IF,    MCC_TOKEN_ELSE, MCC_TOKEN_WHILE, MCC_TOKEN_RETURN,
+};
+
 static void lexer_read_identifier_or_keywords(struct mcc_lexer *lexer, struct mcc_lexeme *lexeme)
 {
 	assert(lexer);
@@ -226,14 +257,15 @@ static void lexer_read_identifier_or_keywords(struct mcc_lexer *lexer, struct mc
 	}
 
 	// check for keywords
-	if (lexer_buffer_cmp(lexer, "true")) {
-		lexeme->token = MCC_TOKEN_TRUE;
-	} else if (lexer_buffer_cmp(lexer, "false")) {
-		lexeme->token = MCC_TOKEN_FALSE;
-	} else {
-		// not a keyword
-		lexeme->s_value = lexer_add_string(lexer, lexer->buffer, lexer->buffer_index);
+	for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+		if (lexer_buffer_cmp(lexer, mcc_token_to_string(keywords[i]))) {
+			lexeme->token = keywords[i];
+			return;
+		}
 	}
+
+	// not a keyword
+	lexeme->s_value = lexer_add_string(lexer, lexer->buffer, lexer->buffer_index);
 }
 
 static void lexer_read_number(struct mcc_lexer *lexer, struct mcc_lexeme *lexeme)
@@ -303,6 +335,30 @@ static void lexer_read_string(struct mcc_lexer *lexer, struct mcc_lexeme *lexeme
 	lexeme->s_value = lexer_add_string(lexer, lexer->buffer, lexer->buffer_index);
 }
 
+// Selects `two` iff the next character is `second`, `one` otherwise. Used for
+// operators like `<` and `<=`.
+static enum mcc_token lexer_one_or_two(struct mcc_lexer *lexer, char second, enum mcc_token one, enum mcc_token two)
+{
+	assert(lexer);
+	return lexer_accept(lexer, second) ? two : one;
+}
+
+// Used for operators consisting of two identical characters, like `&&`. The
+// first character has already been consumed.
+static void lexer_read_doubled(struct mcc_lexer *lexer, struct mcc_lexeme *lexeme, char c, enum mcc_token token)
+{
+	assert(lexer);
+	assert(lexeme);
+
+	if (lexer_accept(lexer, c)) {
+		lexeme->token = token;
+		return;
+	}
+
+	lexeme->token = MCC_TOKEN_UNKNOWN;
+	lexeme->s_value = lexer_add_string(lexer, &c, 1);
+}
+
 static void lexer_skip_comment(struct mcc_lexer *lexer)
 {
 	assert(lexer);
@@ -328,8 +384,6 @@ void mcc_lexer_init(struct mcc_lexer *lexer, FILE *stream)
 {
 	assert(lexer);
 
-	const size_t initial_strings_capacity = 8;
-
 	*lexer = (struct mcc_lexer){
 	    .stream = stream,
 	    .sloc =
@@ -337,14 +391,9 @@ void mcc_lexer_init(struct mcc_lexer *lexer, FILE *stream)
 	            .line = 1,
 	            .column = 1,
 	        },
-	    .strings = malloc(sizeof(lexer->strings[0]) * initial_strings_capacity),
-	    .strings_capacity = initial_strings_capacity,
 	};
 
-	if (!lexer->strings) {
-		lexer->error = MCC_LEXER_ERROR_ALLOCATION_ERROR;
-		return;
-	}
+	mcc_string_pool_init(&lexer->strings);
 
 	// Prime `cur` for the first `mcc_lexer_lex` call.
 	lexer_next(lexer);
@@ -356,11 +405,16 @@ void mcc_lexer_deinit(struct mcc_lexer *lexer)
 		return;
 	}
 
-	for (size_t i = 0; i < lexer->strings_count; i++) {
-		free(lexer->strings[i]);
-	}
+	mcc_string_pool_deinit(&lexer->strings);
+}
 
-	free(lexer->strings);
+void mcc_lexer_take_strings(struct mcc_lexer *lexer, struct mcc_string_pool *pool)
+{
+	assert(lexer);
+	assert(pool);
+
+	*pool = lexer->strings;
+	mcc_string_pool_init(&lexer->strings);
 }
 
 struct mcc_lexeme mcc_lexer_lex(struct mcc_lexer *lexer)
@@ -402,10 +456,38 @@ struct mcc_lexeme mcc_lexer_lex(struct mcc_lexer *lexer)
 				result.token = MCC_TOKEN_PARENTH_RIGHT;
 			}
 
+			else if (lexer_accept(lexer, '[')) {
+				result.token = MCC_TOKEN_BRACKET_LEFT;
+			}
+
+			else if (lexer_accept(lexer, ']')) {
+				result.token = MCC_TOKEN_BRACKET_RIGHT;
+			}
+
+			else if (lexer_accept(lexer, '{')) {
+				result.token = MCC_TOKEN_BRACE_LEFT;
+			}
+
+			else if (lexer_accept(lexer, '}')) {
+				result.token = MCC_TOKEN_BRACE_RIGHT;
+			}
+
+			else if (lexer_accept(lexer, ';')) {
+				result.token = MCC_TOKEN_SEMICOLON;
+			}
+
+			else if (lexer_accept(lexer, ',')) {
+				result.token = MCC_TOKEN_COMMA;
+			}
+
 			else if (lexer_accept(lexer, '+')) {
 				result.token = MCC_TOKEN_PLUS;
 			}
 
+			else if (lexer_accept(lexer, '-')) {
+				result.token = MCC_TOKEN_MINUS;
+			}
+
 			else if (lexer_accept(lexer, '*')) {
 				result.token = MCC_TOKEN_ASTERISK;
 			}
@@ -419,6 +501,30 @@ struct mcc_lexeme mcc_lexer_lex(struct mcc_lexer *lexer)
 				}
 			}
 
+			else if (lexer_accept(lexer, '<')) {
+				result.token = lexer_one_or_two(lexer, '=', MCC_TOKEN_LESS, MCC_TOKEN_LESS_EQUAL);
+			}
+
+			else if (lexer_accept(lexer, '>')) {
+				result.token = lexer_one_or_two(lexer, '=', MCC_TOKEN_GREATER, MCC_TOKEN_GREATER_EQUAL);
+			}
+
+			else if (lexer_accept(lexer, '=')) {
+				result.token = lexer_one_or_two(lexer, '=', MCC_TOKEN_ASSIGN, MCC_TOKEN_EQUAL);
+			}
+
+			else if (lexer_accept(lexer, '!')) {
+				result.token = lexer_one_or_two(lexer, '=', MCC_TOKEN_NOT, MCC_TOKEN_NOT_EQUAL);
+			}
+
+			else if (lexer_accept(lexer, '&')) {
+				lexer_read_doubled(lexer, &result, '&', MCC_TOKEN_AND);
+			}
+
+			else if (lexer_accept(lexer, '|')) {
+				lexer_read_doubled(lexer, &result, '|', MCC_TOKEN_OR);
+			}
+
 			else {
 				result.token = MCC_TOKEN_UNKNOWN;
 				result.s_value = lexer_add_string(lexer, &lexer->cur, 1);
@@ -431,6 +537,7 @@ struct mcc_lexeme mcc_lexer_lex(struct mcc_lexer *lexer)
 			result.sloc = lexer->sloc;
 		}
 
+		lexer->stats.lexemes++;
 		return result;
 	}
 }
@@ -0,0 +1,436 @@
+#include "mcc/licm.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "mcc/cfg.h"
+#include "mcc/liveness.h"
+#include "mcc/loops.h"
+#include "mcc/purity.h"
+
+// Instructions hoisted into a preheader, inserted at `index`.
+struct hoist {
+	size_t index;
+	size_t begin, count;
+};
+
+struct licm {
+	struct mcc_tac_function *function;
+	const struct mcc_tac_program *program;
+	const bool *pure;
+
+	struct mcc_cfg cfg;
+	struct mcc_loops loops;
+	struct mcc_liveness liveness;
+
+	// Assignments of each variable in the function and within the current
+	// loop, the defining instruction of variables assigned once.
+	uint32_t *definitions;
+	uint32_t *loop_definitions;
+	uint32_t *definition_instructions;
+
+	// Exits of the current loop, as pairs of a block inside and a successor
+	// outside.
+	uint32_t *exits;
+	size_t exits_count;
+
+	// Variables read by hoisted instructions are marked with `reads_mark`.
+	uint32_t *reads;
+	uint32_t reads_mark;
+
+	// Hoisted instructions, in the order they are placed in preheaders.
+	bool *hoisted;
+	uint32_t *order;
+	size_t order_count;
+	struct hoist *hoists;
+	size_t hoists_count;
+};
+
+static void licm_deinit(struct licm *licm)
+{
+	mcc_cfg_deinit(&licm->cfg);
+	mcc_loops_deinit(&licm->loops);
+	mcc_liveness_deinit(&licm->liveness);
+	free(licm->definitions);
+	free(licm->loop_definitions);
+	free(licm->definition_instructions);
+	free(licm->exits);
+	free(licm->reads);
+	free(licm->hoisted);
+	free(licm->order);
+	free(licm->hoists);
+}
+
+static bool licm_init(struct licm *licm)
+{
+	struct mcc_tac_function *function = licm->function;
+	if (!mcc_cfg_build(&licm->cfg, function) || !mcc_loops_find(&licm->loops, &licm->cfg) ||
+	    !mcc_liveness_compute(&licm->liveness, &licm->cfg, function)) {
+		return false;
+	}
+
+	size_t variables = function->variables_count + 1;
+	licm->definitions = calloc(variables, sizeof(*licm->definitions));
+	licm->loop_definitions = calloc(variables, sizeof(*licm->loop_definitions));
+	licm->definition_instructions = malloc(variables * sizeof(*licm->definition_instructions));
+	licm->exits = malloc((4 * licm->cfg.blocks_count + 1) * sizeof(*licm->exits));
+	licm->reads = calloc(variables, sizeof(*licm->reads));
+	licm->hoisted = calloc(function->instructions_count + 1, sizeof(*licm->hoisted));
+	licm->order = malloc((function->instructions_count + 1) * sizeof(*licm->order));
+	licm->hoists = malloc((licm->loops.loops_count + 1) * sizeof(*licm->hoists));
+	if (!licm->definitions || !licm->loop_definitions || !licm->definition_instructions || !licm->exits ||
+	    !licm->reads || !licm->hoisted || !licm->order || !licm->hoists) {
+		return false;
+	}
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		uint32_t variable = mcc_tac_instruction_definition(&function->instructions[i]);
+		licm->definitions[variable]++;
+		licm->definition_instructions[variable] = (uint32_t)i;
+	}
+	return true;
+}
+
+// ------------------------------------------------------------- Invariance
+
+static bool is_safe_divisor(const struct licm *licm, uint32_t variable)
+{
+	if (licm->definitions[variable] != 1) {
+		return false;
+	}
+	const struct mcc_tac_function *function = licm->function;
+	const struct mcc_tac_instruction *definition = &function->instructions[licm->definition_instructions[variable]];
+	return definition->op == MCC_TAC_OP_CONST && mcc_tac_bits_int(function->constants[definition->arg1]) != 0;
+}
+
+static bool is_pure_call(const struct licm *licm, const struct mcc_tac_instruction *instruction)
+{
+	if (!licm->program || !licm->pure || instruction->result == 0) {
+		return false;
+	}
+	const struct mcc_tac_function *function = licm->function;
+	const struct mcc_tac_function *callee =
+	    mcc_tac_program_find_function(licm->program, function->strings[instruction->arg1]);
+	if (!callee || !licm->pure[callee - licm->program->functions]) {
+		return false;
+	}
+
+	// Pure functions may read arrays passed to them.
+	const uint32_t *arguments = &function->operands[instruction->arg2];
+	for (uint32_t i = 1; i <= arguments[0]; i++) {
+		if (mcc_tac_function_variable_type(function, arguments[i]) == MCC_TAC_TYPE_ARRAY) {
+			return false;
+		}
+	}
+	return true;
+}
+
+enum kind {
+	// Not hoisted at all.
+	KIND_FIXED,
+	// Cannot fail and has no effect.
+	KIND_SAFE,
+	// Might fail at runtime, or not return.
+	KIND_FALLIBLE,
+};
+
+static enum kind classify(const struct licm *licm, const struct mcc_tac_instruction *instruction)
+{
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_CONST:
+	case MCC_TAC_OP_ASSIGN:
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+	case MCC_TAC_OP_NOT:
+		return KIND_SAFE;
+
+	case MCC_TAC_OP_DIV:
+		if (instruction->type != MCC_TAC_TYPE_INT || is_safe_divisor(licm, instruction->arg2)) {
+			return KIND_SAFE;
+		}
+		return KIND_FALLIBLE;
+
+	case MCC_TAC_OP_CALL:
+		return is_pure_call(licm, instruction) ? KIND_FALLIBLE : KIND_FIXED;
+
+	default:
+		return KIND_FIXED;
+	}
+}
+
+// Instructions that neither fail nor have an effect can be passed over when
+// hoisting fallible instructions from the header.
+static bool is_harmless(const struct licm *licm, const struct mcc_tac_instruction *instruction)
+{
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_NOP:
+	case MCC_TAC_OP_LABEL:
+	case MCC_TAC_OP_ARRAY:
+	case MCC_TAC_OP_PARAM:
+		return true;
+	default:
+		return classify(licm, instruction) == KIND_SAFE;
+	}
+}
+
+struct operands_check {
+	const uint32_t *loop_definitions;
+	bool invariant;
+};
+
+static void check_operand(uint32_t *variable, void *userdata)
+{
+	struct operands_check *check = userdata;
+	if (check->loop_definitions[*variable] != 0) {
+		check->invariant = false;
+	}
+}
+
+// Returns whether the result of the instruction in `block` is the value
+// seen by every read in the loop and after leaving it.
+static bool is_movable(const struct licm *licm, uint32_t loop, uint32_t block, uint32_t result)
+{
+	if (licm->loop_definitions[result] != 1) {
+		return false;
+	}
+	if (mcc_liveness_set_contains(mcc_liveness_in(&licm->liveness, licm->loops.loops[loop].header), result)) {
+		return false;
+	}
+	for (size_t e = 0; e < licm->exits_count; e++) {
+		uint32_t from = licm->exits[2 * e];
+		uint32_t to = licm->exits[2 * e + 1];
+		if (mcc_liveness_set_contains(mcc_liveness_in(&licm->liveness, to), result) &&
+		    !mcc_cfg_dominates(&licm->cfg, block, from)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool is_hoistable(struct licm *licm, uint32_t loop, uint32_t block, size_t i, bool guarded)
+{
+	struct mcc_tac_instruction *instruction = &licm->function->instructions[i];
+	enum kind kind = classify(licm, instruction);
+	if (kind == KIND_FIXED || (kind == KIND_FALLIBLE && (block != licm->loops.loops[loop].header || !guarded))) {
+		return false;
+	}
+
+	struct operands_check check = {.loop_definitions = licm->loop_definitions, .invariant = true};
+	mcc_tac_function_visit_uses(licm->function, instruction, check_operand, &check);
+	return check.invariant && is_movable(licm, loop, block, instruction->result);
+}
+
+// ------------------------------------------------------------------ Loops
+
+static void collect_exits(struct licm *licm, uint32_t loop)
+{
+	licm->exits_count = 0;
+	const uint32_t *blocks = mcc_loops_blocks(&licm->loops, loop);
+	for (uint32_t b = 0; b < licm->loops.loops[loop].blocks_count; b++) {
+		const struct mcc_cfg_block *block = &licm->cfg.blocks[blocks[b]];
+		for (uint32_t s = 0; s < block->successors_count; s++) {
+			if (!mcc_loops_contains(&licm->loops, loop, block->successors[s])) {
+				licm->exits[2 * licm->exits_count] = blocks[b];
+				licm->exits[2 * licm->exits_count + 1] = block->successors[s];
+				licm->exits_count++;
+			}
+		}
+	}
+}
+
+static void mark_read(uint32_t *variable, void *userdata)
+{
+	struct licm *licm = userdata;
+	licm->reads[*variable] = licm->reads_mark;
+}
+
+// Drops the constants no other hoisted instruction reads from the
+// instructions hoisted from `begin` on, returns the number left.
+static size_t keep_read_constants(struct licm *licm, size_t begin)
+{
+	struct mcc_tac_function *function = licm->function;
+
+	licm->reads_mark++;
+	for (size_t k = begin; k < licm->order_count; k++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[licm->order[k]];
+		if (instruction->op != MCC_TAC_OP_CONST) {
+			mcc_tac_function_visit_uses(function, instruction, mark_read, licm);
+		}
+	}
+
+	size_t count = 0;
+	for (size_t k = begin; k < licm->order_count; k++) {
+		uint32_t i = licm->order[k];
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_CONST && licm->reads[instruction->result] != licm->reads_mark) {
+			licm->hoisted[i] = false;
+			continue;
+		}
+		licm->order[begin + count++] = i;
+	}
+	licm->order_count = begin + count;
+	return count;
+}
+
+static void hoist_loop(struct licm *licm, uint32_t loop)
+{
+	struct mcc_tac_function *function = licm->function;
+	const struct mcc_loop *l = &licm->loops.loops[loop];
+	uint32_t preheader = mcc_loops_preheader(&licm->loops, &licm->cfg, function, loop);
+	if (preheader == MCC_CFG_NONE) {
+		return;
+	}
+
+	mcc_loops_count_definitions(&licm->loops, &licm->cfg, licm->function, loop, false, licm->loop_definitions,
+	                            NULL);
+	collect_exits(licm, loop);
+
+	size_t begin = licm->order_count;
+	const uint32_t *blocks = mcc_loops_blocks(&licm->loops, loop);
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (uint32_t b = 0; b < l->blocks_count; b++) {
+			if (licm->loops.block_loops[blocks[b]] != loop) {
+				continue;
+			}
+			const struct mcc_cfg_block *block = &licm->cfg.blocks[blocks[b]];
+			bool guarded = true;
+			for (size_t i = block->begin; i < block->end; i++) {
+				const struct mcc_tac_instruction *instruction = &function->instructions[i];
+				if (!licm->hoisted[i] && is_hoistable(licm, loop, blocks[b], i, guarded)) {
+					licm->hoisted[i] = true;
+					licm->loop_definitions[instruction->result]--;
+					licm->order[licm->order_count++] = (uint32_t)i;
+					changed = true;
+				}
+				guarded = guarded && (licm->hoisted[i] || is_harmless(licm, instruction));
+			}
+		}
+	}
+
+	mcc_loops_count_definitions(&licm->loops, &licm->cfg, licm->function, loop, true, licm->loop_definitions, NULL);
+
+	size_t count = keep_read_constants(licm, begin);
+	if (count == 0) {
+		return;
+	}
+
+	const struct mcc_cfg_block *block = &licm->cfg.blocks[preheader];
+	size_t last = mcc_cfg_block_last_instruction(function, block);
+	bool jumps = last < block->end && function->instructions[last].op == MCC_TAC_OP_JUMP;
+	licm->hoists[licm->hoists_count++] = (struct hoist){
+	    .index = jumps ? last : block->end,
+	    .begin = begin,
+	    .count = count,
+	};
+}
+
+// Moves the hoisted instructions to their preheaders, the originals become
+// tombstones.
+static bool move_hoisted(struct licm *licm)
+{
+	struct mcc_tac_function *function = licm->function;
+	if (!mcc_tac_function_reserve(function, function->instructions_count + licm->order_count)) {
+		return false;
+	}
+
+	struct mcc_tac_instruction *moved = malloc((licm->order_count + 1) * sizeof(*moved));
+	if (!moved) {
+		return false;
+	}
+	for (size_t k = 0; k < licm->order_count; k++) {
+		moved[k] = function->instructions[licm->order[k]];
+		mcc_tac_function_remove(function, licm->order[k]);
+	}
+
+	// Preheaders are distinct blocks, inserting back to front keeps the
+	// indices valid.
+	for (size_t h = 0; h < licm->hoists_count; h++) {
+		size_t latest = h;
+		for (size_t j = h + 1; j < licm->hoists_count; j++) {
+			if (licm->hoists[j].index > licm->hoists[latest].index) {
+				latest = j;
+			}
+		}
+		struct hoist hoist = licm->hoists[latest];
+		licm->hoists[latest] = licm->hoists[h];
+		bool inserted = mcc_tac_function_insert(function, hoist.index, &moved[hoist.begin], hoist.count);
+		assert(inserted);
+		(void)inserted;
+	}
+
+	free(moved);
+	return true;
+}
+
+// Hoists out of every loop once, innermost loops first. Instructions moved
+// to the preheader of a nested loop are considered for the loops around it
+// in the next round.
+static bool hoist_round(struct mcc_tac_function *function,
+                        const struct mcc_tac_program *program,
+                        const bool *pure,
+                        size_t *hoisted)
+{
+	struct licm licm = {.function = function, .program = program, .pure = pure};
+	bool ok = licm_init(&licm);
+	for (size_t l = licm.loops.loops_count; ok && l > 0; l--) {
+		hoist_loop(&licm, (uint32_t)(l - 1));
+	}
+
+	ok = ok && move_hoisted(&licm);
+	if (ok) {
+		*hoisted = licm.order_count;
+	}
+	licm_deinit(&licm);
+	return ok;
+}
+
+bool mcc_licm_function(struct mcc_tac_function *function,
+                       const struct mcc_tac_program *program,
+                       const bool *pure,
+                       struct mcc_licm_stats *stats)
+{
+	assert(function);
+
+	struct mcc_licm_stats counts = {0};
+	if (!mcc_loops_insert_preheaders(function, &counts.preheaders)) {
+		return false;
+	}
+
+	size_t hoisted = 1;
+	bool ok = true;
+	while (ok && hoisted > 0) {
+		ok = hoist_round(function, program, pure, &hoisted);
+		counts.hoisted += ok ? hoisted : 0;
+	}
+
+	if (stats) {
+		stats->hoisted += counts.hoisted;
+		stats->preheaders += counts.preheaders;
+	}
+	return ok;
+}
+
+bool mcc_licm_program(struct mcc_tac_program *program, struct mcc_licm_stats *stats)
+{
+	assert(program);
+
+	bool *pure = malloc((program->functions_count + 1) * sizeof(*pure));
+	bool ok = pure && mcc_purity_analyse(program, pure);
+	for (size_t f = 0; ok && f < program->functions_count; f++) {
+		ok = mcc_licm_function(&program->functions[f], program, pure, stats);
+	}
+	free(pure);
+	return ok;
+}
@@ -0,0 +1,121 @@
+#include "mcc/liveness.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+struct block_sets {
+	uint64_t *uses;
+	const uint64_t *defs;
+};
+
+// Collects variables read before being assigned in the block.
+static void collect_use(uint32_t *variable, void *userdata)
+{
+	struct block_sets *sets = userdata;
+	if (!mcc_liveness_set_contains(sets->defs, *variable)) {
+		mcc_liveness_set_add(sets->uses, *variable);
+	}
+}
+
+static void compute_block_sets(const struct mcc_cfg *cfg,
+                               struct mcc_tac_function *function,
+                               size_t words,
+                               uint64_t *uses,
+                               uint64_t *defs)
+{
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		struct block_sets sets = {.uses = uses + b * words, .defs = defs + b * words};
+		for (size_t i = block->begin; i < block->end; i++) {
+			struct mcc_tac_instruction *instruction = &function->instructions[i];
+			mcc_tac_function_visit_uses(function, instruction, collect_use, &sets);
+
+			uint32_t definition = mcc_tac_instruction_definition(instruction);
+			if (definition) {
+				mcc_liveness_set_add(defs + b * words, definition);
+			}
+		}
+	}
+}
+
+// Recomputes both sets of block `b`, returns whether its entry set changed.
+static bool update_block(struct mcc_liveness *liveness,
+                         const struct mcc_cfg *cfg,
+                         uint32_t b,
+                         const uint64_t *uses,
+                         const uint64_t *defs)
+{
+	size_t words = liveness->words;
+	const struct mcc_cfg_block *block = &cfg->blocks[b];
+	uint64_t *out = liveness->live_out + b * words;
+	uint64_t *in = liveness->live_in + b * words;
+
+	for (uint32_t s = 0; s < block->successors_count; s++) {
+		const uint64_t *successor_in = liveness->live_in + block->successors[s] * words;
+		for (size_t w = 0; w < words; w++) {
+			out[w] |= successor_in[w];
+		}
+	}
+
+	bool changed = false;
+	for (size_t w = 0; w < words; w++) {
+		uint64_t word = uses[b * words + w] | (out[w] & ~defs[b * words + w]);
+		changed |= word != in[w];
+		in[w] = word;
+	}
+	return changed;
+}
+
+bool mcc_liveness_compute(struct mcc_liveness *liveness, const struct mcc_cfg *cfg, struct mcc_tac_function *function)
+{
+	assert(liveness);
+	assert(cfg);
+	assert(function);
+
+	size_t words = (function->variables_count + 1 + 63) / 64;
+	size_t size = cfg->blocks_count * words;
+	liveness->words = words;
+	liveness->live_in = calloc(size, sizeof(*liveness->live_in));
+	liveness->live_out = calloc(size, sizeof(*liveness->live_out));
+	uint64_t *uses = calloc(size, sizeof(*uses));
+	uint64_t *defs = calloc(size, sizeof(*defs));
+	uint32_t *blocks = malloc(cfg->blocks_count * sizeof(*blocks));
+	bool ok = liveness->live_in && liveness->live_out && uses && defs && blocks;
+
+	if (ok) {
+		compute_block_sets(cfg, function, words, uses, defs);
+
+		// Postorder visits successors first, unreachable blocks follow in
+		// any order.
+		size_t count = 0;
+		for (size_t i = cfg->order_count; i > 0; i--) {
+			blocks[count++] = cfg->order[i - 1];
+		}
+		for (size_t b = 0; b < cfg->blocks_count; b++) {
+			if (cfg->blocks[b].order == MCC_CFG_NONE) {
+				blocks[count++] = (uint32_t)b;
+			}
+		}
+
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t i = 0; i < count; i++) {
+				changed |= update_block(liveness, cfg, blocks[i], uses, defs);
+			}
+		}
+	}
+
+	free(uses);
+	free(defs);
+	free(blocks);
+	return ok;
+}
+
+void mcc_liveness_deinit(struct mcc_liveness *liveness)
+{
+	assert(liveness);
+
+	free(liveness->live_in);
+	free(liveness->live_out);
+}
@@ -0,0 +1,308 @@
+#include "mcc/loops.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "array.h"
+
+static bool is_back_edge(const struct mcc_cfg *cfg, uint32_t from, uint32_t to)
+{
+	return cfg->blocks[from].order != MCC_CFG_NONE && mcc_cfg_dominates(cfg, to, from);
+}
+
+static bool is_header(const struct mcc_cfg *cfg, uint32_t block)
+{
+	const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, block);
+	for (uint32_t i = 0; i < cfg->blocks[block].predecessors_count; i++) {
+		if (is_back_edge(cfg, predecessors[i], block)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Marks the blocks of the loop headed by `header` with `mark`, walking
+// backwards from the sources of its back edges. Returns the number of blocks
+// marked.
+static uint32_t mark_body(const struct mcc_cfg *cfg, uint32_t header, uint32_t mark, uint32_t *marks, uint32_t *stack)
+{
+	size_t depth = 0;
+	uint32_t count = 1;
+	marks[header] = mark;
+
+	const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, header);
+	for (uint32_t i = 0; i < cfg->blocks[header].predecessors_count; i++) {
+		uint32_t latch = predecessors[i];
+		if (is_back_edge(cfg, latch, header) && marks[latch] != mark) {
+			marks[latch] = mark;
+			stack[depth++] = latch;
+			count++;
+		}
+	}
+
+	while (depth > 0) {
+		uint32_t block = stack[--depth];
+		predecessors = mcc_cfg_block_predecessors(cfg, block);
+		for (uint32_t i = 0; i < cfg->blocks[block].predecessors_count; i++) {
+			uint32_t predecessor = predecessors[i];
+			if (cfg->blocks[predecessor].order != MCC_CFG_NONE && marks[predecessor] != mark) {
+				marks[predecessor] = mark;
+				stack[depth++] = predecessor;
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+bool mcc_loops_find(struct mcc_loops *loops, const struct mcc_cfg *cfg)
+{
+	assert(loops);
+	assert(cfg);
+
+	*loops = (struct mcc_loops){0};
+
+	size_t count = 0;
+	for (size_t i = 0; i < cfg->order_count; i++) {
+		if (is_header(cfg, cfg->order[i])) {
+			count++;
+		}
+	}
+
+	size_t blocks = cfg->blocks_count + 1;
+	uint32_t *marks = calloc(blocks, sizeof(*marks));
+	uint32_t *stack = malloc(blocks * sizeof(*stack));
+	loops->loops = malloc((count + 1) * sizeof(*loops->loops));
+	loops->block_loops = malloc(blocks * sizeof(*loops->block_loops));
+	bool ok = marks && stack && loops->loops && loops->block_loops;
+
+	size_t blocks_count = 0;
+	size_t blocks_capacity = 0;
+	for (size_t b = 0; ok && b < cfg->blocks_count; b++) {
+		loops->block_loops[b] = MCC_CFG_NONE;
+	}
+
+	for (size_t i = 0; ok && i < cfg->order_count; i++) {
+		uint32_t header = cfg->order[i];
+		if (!is_header(cfg, header)) {
+			continue;
+		}
+
+		uint32_t l = (uint32_t)loops->loops_count++;
+		uint32_t parent = loops->block_loops[header];
+		struct mcc_loop *loop = &loops->loops[l];
+		*loop = (struct mcc_loop){
+		    .header = header,
+		    .parent = parent,
+		    .depth = parent == MCC_CFG_NONE ? 1 : loops->loops[parent].depth + 1,
+		    .blocks_begin = blocks_count,
+		    .blocks_count = mark_body(cfg, header, l + 1, marks, stack),
+		};
+
+		// Nested loops come later and claim their blocks afterwards.
+		for (uint32_t b = 0; ok && b < cfg->blocks_count; b++) {
+			if (marks[b] == l + 1) {
+				ok = mcc_array_push(loops->blocks, blocks_count, blocks_capacity, b);
+				loops->block_loops[b] = l;
+			}
+		}
+	}
+
+	free(marks);
+	free(stack);
+	return ok;
+}
+
+void mcc_loops_deinit(struct mcc_loops *loops)
+{
+	assert(loops);
+
+	free(loops->loops);
+	free(loops->blocks);
+	free(loops->block_loops);
+}
+
+bool mcc_loops_contains(const struct mcc_loops *loops, uint32_t loop, uint32_t block)
+{
+	assert(loops);
+	assert(loop < loops->loops_count);
+
+	for (uint32_t l = loops->block_loops[block]; l != MCC_CFG_NONE; l = loops->loops[l].parent) {
+		if (l == loop) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool is_conditional_jump(const struct mcc_tac_instruction *instruction)
+{
+	return instruction->op == MCC_TAC_OP_JUMP_IF || instruction->op == MCC_TAC_OP_JUMP_IF_NOT;
+}
+
+static bool is_jump(const struct mcc_tac_instruction *instruction)
+{
+	return instruction->op == MCC_TAC_OP_JUMP || is_conditional_jump(instruction);
+}
+
+void mcc_loops_count_definitions(const struct mcc_loops *loops,
+                                 const struct mcc_cfg *cfg,
+                                 const struct mcc_tac_function *function,
+                                 uint32_t loop,
+                                 bool reset,
+                                 uint32_t *counts,
+                                 uint32_t *last_definitions)
+{
+	assert(loops);
+	assert(cfg);
+	assert(function);
+	assert(loop < loops->loops_count);
+	assert(counts);
+
+	const uint32_t *blocks = mcc_loops_blocks(loops, loop);
+	for (uint32_t b = 0; b < loops->loops[loop].blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[blocks[b]];
+		for (size_t i = block->begin; i < block->end; i++) {
+			uint32_t variable = mcc_tac_instruction_definition(&function->instructions[i]);
+			counts[variable] = reset ? 0 : counts[variable] + 1;
+			if (last_definitions) {
+				last_definitions[variable] = (uint32_t)i;
+			}
+		}
+	}
+}
+
+uint32_t mcc_loops_preheader(const struct mcc_loops *loops,
+                             const struct mcc_cfg *cfg,
+                             const struct mcc_tac_function *function,
+                             uint32_t loop)
+{
+	assert(loops);
+	assert(cfg);
+	assert(function);
+	assert(loop < loops->loops_count);
+
+	uint32_t header = loops->loops[loop].header;
+	const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, header);
+
+	uint32_t preheader = MCC_CFG_NONE;
+	for (uint32_t i = 0; i < cfg->blocks[header].predecessors_count; i++) {
+		if (mcc_loops_contains(loops, loop, predecessors[i])) {
+			continue;
+		}
+		if (preheader != MCC_CFG_NONE) {
+			return MCC_CFG_NONE;
+		}
+		preheader = predecessors[i];
+	}
+
+	// The entry block has an implicit predecessor. Instructions are added
+	// before the jump ending a preheader, a condition read there could be
+	// among them.
+	if (preheader == MCC_CFG_NONE || header == 0 || cfg->blocks[preheader].successors_count != 1) {
+		return MCC_CFG_NONE;
+	}
+	size_t last = mcc_cfg_block_last_instruction(function, &cfg->blocks[preheader]);
+	if (last < cfg->blocks[preheader].end && is_conditional_jump(&function->instructions[last])) {
+		return MCC_CFG_NONE;
+	}
+	return preheader;
+}
+
+struct insertion {
+	size_t index;
+	struct mcc_tac_instruction instructions[2];
+	size_t count;
+};
+
+bool mcc_loops_insert_preheaders(struct mcc_tac_function *function, size_t *inserted)
+{
+	assert(function);
+
+	struct mcc_cfg cfg;
+	struct mcc_loops loops = {0};
+	struct insertion *insertions = NULL;
+	bool ok = mcc_cfg_build(&cfg, function) && mcc_loops_find(&loops, &cfg);
+	if (ok) {
+		insertions = malloc((loops.loops_count + 1) * sizeof(*insertions));
+		ok = insertions != NULL;
+	}
+
+	size_t insertions_count = 0;
+	size_t instructions_count = 0;
+	for (uint32_t l = 0; ok && l < loops.loops_count; l++) {
+		if (mcc_loops_preheader(&loops, &cfg, function, l) != MCC_CFG_NONE) {
+			continue;
+		}
+		const struct mcc_cfg_block *header = &cfg.blocks[loops.loops[l].header];
+		assert(function->instructions[header->begin].op == MCC_TAC_OP_LABEL);
+
+		struct insertion *insertion = &insertions[insertions_count++];
+		*insertion = (struct insertion){.index = header->begin};
+		uint32_t label = function->instructions[header->begin].arg2;
+
+		// The block laid out before the header falls through to the new
+		// block unless it belongs to the loop.
+		uint32_t previous = loops.loops[l].header - 1;
+		if (loops.loops[l].header > 0 && cfg.blocks[previous].order != MCC_CFG_NONE &&
+		    mcc_loops_contains(&loops, l, previous)) {
+			size_t last = mcc_cfg_block_last_instruction(function, &cfg.blocks[previous]);
+			enum mcc_tac_op op =
+			    last < cfg.blocks[previous].end ? function->instructions[last].op : MCC_TAC_OP_NOP;
+			if (op != MCC_TAC_OP_JUMP && op != MCC_TAC_OP_RETURN) {
+				insertion->instructions[insertion->count++] = (struct mcc_tac_instruction){
+				    .op = MCC_TAC_OP_JUMP,
+				    .arg2 = label,
+				};
+			}
+		}
+		insertion->instructions[insertion->count++] = (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL};
+		instructions_count += insertion->count;
+	}
+
+	// Nothing may fail once the function is modified.
+	ok = ok && mcc_tac_function_reserve(function, function->instructions_count + instructions_count);
+
+	for (size_t i = 0; ok && i < insertions_count; i++) {
+		struct insertion *insertion = &insertions[i];
+		uint32_t header = cfg.label_blocks[function->instructions[insertion->index].arg2];
+		uint32_t preheader = mcc_tac_function_new_label(function);
+		insertion->instructions[insertion->count - 1].arg2 = preheader;
+
+		const uint32_t *predecessors = mcc_cfg_block_predecessors(&cfg, header);
+		for (uint32_t p = 0; p < cfg.blocks[header].predecessors_count; p++) {
+			if (mcc_loops_contains(&loops, loops.block_loops[header], predecessors[p])) {
+				continue;
+			}
+			size_t last = mcc_cfg_block_last_instruction(function, &cfg.blocks[predecessors[p]]);
+			struct mcc_tac_instruction *jump = &function->instructions[last];
+			if (last < cfg.blocks[predecessors[p]].end && is_jump(jump) && jump->arg2 <= cfg.labels_count &&
+			    cfg.label_blocks[jump->arg2] == header) {
+				jump->arg2 = preheader;
+			}
+		}
+	}
+
+	// Insertions are ordered by header, which follows the reverse postorder
+	// rather than the layout, back to front keeps the indices valid.
+	for (size_t i = 0; ok && i < insertions_count; i++) {
+		size_t latest = i;
+		for (size_t j = i + 1; j < insertions_count; j++) {
+			if (insertions[j].index > insertions[latest].index) {
+				latest = j;
+			}
+		}
+		struct insertion insertion = insertions[latest];
+		insertions[latest] = insertions[i];
+		ok = mcc_tac_function_insert(function, insertion.index, insertion.instructions, insertion.count);
+		assert(ok);
+	}
+
+	if (ok && inserted) {
+		*inserted += insertions_count;
+	}
+	free(insertions);
+	mcc_loops_deinit(&loops);
+	mcc_cfg_deinit(&cfg);
+	return ok;
+}
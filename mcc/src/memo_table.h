@@ -0,0 +1,81 @@
+// Memoisation Table
+//
+// Private runtime support for memoised functions, see mcc/memoize.h, shared
+// by the VM and the JIT. The table is direct-mapped and allocated on the
+// first store; if that fails, lookups keep missing and memoised functions
+// compute every result.
+
+#ifndef MCC_MEMO_TABLE_H
+#define MCC_MEMO_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MCC_MEMO_TABLE_SIZE (1u << 16)
+
+struct mcc_memo_entry {
+	uint32_t table;
+	uint32_t key1, key2;
+	uint32_t value;
+	bool used;
+};
+
+struct mcc_memo_table {
+	struct mcc_memo_entry *entries;
+
+	// Entry found by the last successful lookup.
+	const struct mcc_memo_entry *found;
+};
+
+static inline struct mcc_memo_entry *mcc_memo_table_entry(const struct mcc_memo_table *memo,
+                                                          uint32_t table,
+                                                          uint32_t key1,
+                                                          uint32_t key2)
+{
+	uint32_t hash = table * 0x9e3779b1u ^ key1 * 0x85ebca77u ^ key2 * 0xc2b2ae3du;
+	return &memo->entries[(hash ^ hash >> 16) & (MCC_MEMO_TABLE_SIZE - 1)];
+}
+
+static inline bool mcc_memo_table_find(struct mcc_memo_table *memo, uint32_t table, uint32_t key1, uint32_t key2)
+{
+	if (!memo->entries) {
+		return false;
+	}
+
+	const struct mcc_memo_entry *entry = mcc_memo_table_entry(memo, table, key1, key2);
+	if (!entry->used || entry->table != table || entry->key1 != key1 || entry->key2 != key2) {
+		return false;
+	}
+	memo->found = entry;
+	return true;
+}
+
+static inline uint32_t mcc_memo_table_get(const struct mcc_memo_table *memo)
+{
+	return memo->found ? memo->found->value : 0;
+}
+
+static inline void mcc_memo_table_put(struct mcc_memo_table *memo,
+                                      uint32_t table,
+                                      uint32_t key1,
+                                      uint32_t key2,
+                                      uint32_t value)
+{
+	if (!memo->entries) {
+		memo->entries = calloc(MCC_MEMO_TABLE_SIZE, sizeof(*memo->entries));
+		if (!memo->entries) {
+			return;
+		}
+	}
+
+	*mcc_memo_table_entry(memo, table, key1, key2) =
+	    (struct mcc_memo_entry){.table = table, .key1 = key1, .key2 = key2, .value = value, .used = true};
+}
+
+static inline void mcc_memo_table_deinit(struct mcc_memo_table *memo)
+{
+	free(memo->entries);
+}
+
+#endif // MCC_MEMO_TABLE_H
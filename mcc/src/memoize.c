@@ -0,0 +1,201 @@
+#include "mcc/memoize.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/purity.h"
+
+struct instructions {
+	struct mcc_tac_instruction *items;
+	size_t count;
+	size_t capacity;
+};
+
+static bool push(struct instructions *instructions,
+                 enum mcc_tac_op op,
+                 enum mcc_tac_type type,
+                 uint32_t result,
+                 uint32_t arg1,
+                 uint32_t arg2)
+{
+	struct mcc_tac_instruction instruction = {.op = op, .type = type, .result = result, .arg1 = arg1, .arg2 = arg2};
+	return mcc_array_push(instructions->items, instructions->count, instructions->capacity, instruction);
+}
+
+static bool is_key_type(enum mcc_tac_type type)
+{
+	return type == MCC_TAC_TYPE_INT || type == MCC_TAC_TYPE_BOOL || type == MCC_TAC_TYPE_FLOAT;
+}
+
+// Returns whether `function` qualifies for memoisation, apart from its
+// purity.
+static bool qualifies(const struct mcc_tac_function *function)
+{
+	if (function->parameters_count < 1 || function->parameters_count > 2 || !is_key_type(function->return_type)) {
+		return false;
+	}
+
+	size_t self_calls = 0;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_PARAM &&
+		    !is_key_type(mcc_tac_function_variable_type(function, instruction->result))) {
+			return false;
+		}
+		if (instruction->op != MCC_TAC_OP_CALL) {
+			continue;
+		}
+
+		const char *callee = function->strings[instruction->arg1];
+		if (strcmp(callee, MCC_MEMOIZE_FIND) == 0) {
+			return false;
+		}
+		if (strcmp(callee, function->name) == 0) {
+			self_calls++;
+		}
+	}
+	return self_calls > 1;
+}
+
+// Emits a call of the runtime function `name` with the given arguments.
+static bool push_call(struct mcc_tac_function *function,
+                      struct instructions *instructions,
+                      const char *name,
+                      enum mcc_tac_type type,
+                      uint32_t result,
+                      const uint32_t *arguments,
+                      size_t arguments_count)
+{
+	uint32_t list[5] = {(uint32_t)arguments_count};
+	assert(arguments_count < sizeof(list) / sizeof(*list));
+	for (size_t i = 0; i < arguments_count; i++) {
+		list[i + 1] = arguments[i];
+	}
+
+	uint32_t string, operands;
+	return mcc_tac_function_add_string(function, name, &string) &&
+	       mcc_tac_function_add_operands(function, list, arguments_count + 1, &operands) &&
+	       push(instructions, MCC_TAC_OP_CALL, type, result, string, operands);
+}
+
+// Builds the memoised instruction sequence of `function` in `instructions`.
+static bool rewrite(struct mcc_tac_function *function, uint32_t table, struct instructions *instructions)
+{
+	enum mcc_tac_type type = function->return_type;
+
+	// The table number and keys are kept in fresh variables, the body may
+	// assign its parameters. A missing second key is 0.
+	enum mcc_tac_type key_types[3] = {MCC_TAC_TYPE_INT, MCC_TAC_TYPE_INT, MCC_TAC_TYPE_INT};
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_PARAM) {
+			key_types[instruction->arg1 + 1] =
+			    mcc_tac_function_variable_type(function, instruction->result);
+		}
+	}
+	uint32_t keys[3];
+	for (size_t k = 0; k < 3; k++) {
+		keys[k] = mcc_tac_function_new_variable(function, key_types[k]).identifier;
+	}
+	uint32_t hit = mcc_tac_function_new_variable(function, MCC_TAC_TYPE_BOOL).identifier;
+	uint32_t cached = mcc_tac_function_new_variable(function, type).identifier;
+	uint32_t body = mcc_tac_function_new_label(function);
+	uint32_t table_constant, zero_constant;
+	if (!keys[0] || !keys[1] || !keys[2] || !hit || !cached || !body ||
+	    !mcc_tac_function_add_constant(function, mcc_tac_int_bits(table), &table_constant) ||
+	    !mcc_tac_function_add_constant(function, mcc_tac_int_bits(0), &zero_constant)) {
+		return false;
+	}
+
+	// Parameters stay at the start.
+	size_t i = 0;
+	bool ok = push(instructions, MCC_TAC_OP_CONST, MCC_TAC_TYPE_INT, keys[0], table_constant, 0) &&
+	          (function->parameters_count == 2 ||
+	           push(instructions, MCC_TAC_OP_CONST, MCC_TAC_TYPE_INT, keys[2], zero_constant, 0));
+	for (; ok && i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_NOP) {
+			continue;
+		}
+		if (instruction->op != MCC_TAC_OP_PARAM) {
+			break;
+		}
+
+		enum mcc_tac_type type = mcc_tac_function_variable_type(function, instruction->result);
+		ok = mcc_array_push(instructions->items, instructions->count, instructions->capacity, *instruction) &&
+		     push(instructions, MCC_TAC_OP_ASSIGN, type, keys[instruction->arg1 + 1], instruction->result, 0);
+	}
+
+	ok = ok && push_call(function, instructions, MCC_MEMOIZE_FIND, MCC_TAC_TYPE_BOOL, hit, keys, 3) &&
+	     push(instructions, MCC_TAC_OP_JUMP_IF_NOT, MCC_TAC_TYPE_VOID, 0, hit, body) &&
+	     push_call(function, instructions, MCC_MEMOIZE_GET, type, cached, NULL, 0) &&
+	     push(instructions, MCC_TAC_OP_RETURN, type, 0, cached, 0) &&
+	     push(instructions, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, body);
+
+	for (; ok && i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_NOP) {
+			continue;
+		}
+		if (instruction->op == MCC_TAC_OP_RETURN) {
+			uint32_t arguments[4] = {keys[0], keys[1], keys[2], instruction->arg1};
+			ok = push_call(function, instructions, MCC_MEMOIZE_PUT, MCC_TAC_TYPE_VOID, 0, arguments, 4);
+		}
+		ok = ok && mcc_array_push(instructions->items, instructions->count, instructions->capacity,
+		                          *instruction);
+	}
+	return ok;
+}
+
+static bool memoize_function(struct mcc_tac_function *function, uint32_t table)
+{
+	struct instructions instructions = {0};
+	if (!rewrite(function, table, &instructions)) {
+		free(instructions.items);
+		return false;
+	}
+
+	free(function->instructions);
+	function->instructions = instructions.items;
+	function->instructions_count = instructions.count;
+	function->instructions_capacity = instructions.capacity;
+	function->removed_count = 0;
+	return true;
+}
+
+bool mcc_memoize_program(struct mcc_tac_program *program, size_t *memoized)
+{
+	assert(program);
+
+	static const char *const runtime[] = {MCC_MEMOIZE_FIND, MCC_MEMOIZE_GET, MCC_MEMOIZE_PUT};
+	for (size_t i = 0; i < sizeof(runtime) / sizeof(*runtime); i++) {
+		if (mcc_tac_program_find_function(program, runtime[i])) {
+			return true;
+		}
+	}
+
+	bool *pure = malloc((program->functions_count + 1) * sizeof(*pure));
+	if (!pure || !mcc_purity_analyse(program, pure)) {
+		free(pure);
+		return false;
+	}
+
+	bool ok = true;
+	for (size_t f = 0; ok && f < program->functions_count; f++) {
+		struct mcc_tac_function *function = &program->functions[f];
+		if (!pure[f] || !qualifies(function)) {
+			continue;
+		}
+
+		ok = memoize_function(function, (uint32_t)f);
+		if (ok && memoized) {
+			(*memoized)++;
+		}
+	}
+
+	free(pure);
+	return ok;
+}
@@ -0,0 +1,76 @@
+#include "parallel.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+struct shared {
+	atomic_size_t next;
+	size_t tasks;
+
+	mcc_parallel_task task;
+	void *userdata;
+};
+
+struct worker {
+	pthread_t thread;
+	struct shared *shared;
+	size_t index;
+};
+
+static void *run_worker(void *data)
+{
+	struct worker *worker = data;
+	struct shared *shared = worker->shared;
+
+	while (true) {
+		size_t task = atomic_fetch_add(&shared->next, 1);
+		if (task >= shared->tasks) {
+			break;
+		}
+		shared->task(task, worker->index, shared->userdata);
+	}
+
+	return NULL;
+}
+
+void mcc_parallel_for(size_t tasks, size_t workers, mcc_parallel_task task, void *userdata)
+{
+	assert(task);
+
+	struct shared shared = {
+	    .tasks = tasks,
+	    .task = task,
+	    .userdata = userdata,
+	};
+	atomic_init(&shared.next, 0);
+
+	if (workers > tasks) {
+		workers = tasks;
+	}
+
+	struct worker *threads = NULL;
+	if (workers > 1) {
+		threads = calloc(workers - 1, sizeof(*threads));
+	}
+
+	size_t spawned = 0;
+	if (threads) {
+		for (; spawned < workers - 1; spawned++) {
+			threads[spawned] = (struct worker){.shared = &shared, .index = spawned + 1};
+			if (pthread_create(&threads[spawned].thread, NULL, run_worker, &threads[spawned]) != 0) {
+				break;
+			}
+		}
+	}
+
+	struct worker self = {.shared = &shared, .index = 0};
+	run_worker(&self);
+
+	for (size_t i = 0; i < spawned; i++) {
+		pthread_join(threads[i].thread, NULL);
+	}
+	free(threads);
+}
@@ -0,0 +1,20 @@
+// Parallel Loops
+//
+// Private helper for running independent tasks on a pool of threads. Tasks
+// are handed out dynamically, so uneven task sizes balance out. Each task is
+// told which worker runs it, letting callers keep per-worker scratch state
+// without synchronisation.
+
+#ifndef MCC_PARALLEL_H
+#define MCC_PARALLEL_H
+
+#include <stddef.h>
+
+typedef void (*mcc_parallel_task)(size_t task, size_t worker, void *userdata);
+
+// Runs `task` for every index in [0, `tasks`) using up to `workers` workers,
+// the calling thread being worker 0. Should spawning threads fail, the
+// remaining workers pick up the slack. Returns once all tasks are done.
+void mcc_parallel_for(size_t tasks, size_t workers, mcc_parallel_task task, void *userdata);
+
+#endif // MCC_PARALLEL_H
@@ -121,54 +121,131 @@ static bool parser_expect(struct parser *parser, enum mcc_token token)
 
 // ---------------------------------------------------------------- Operators
 
+// Binary operators are parsed using precedence climbing. Higher values bind
+// tighter, 0 indicates the token is no binary operator.
 static int precedence_from_token(enum mcc_token token)
 {
 	switch (token) {
-	case MCC_TOKEN_PLUS:
+	case MCC_TOKEN_OR:
 		return 1;
-	case MCC_TOKEN_ASTERISK:
+	case MCC_TOKEN_AND:
 		return 2;
+	case MCC_TOKEN_EQUAL:
+	case MCC_TOKEN_NOT_EQUAL:
+		return 3;
+	case MCC_TOKEN_LESS:
+	case MCC_TOKEN_GREATER:
+	case MCC_TOKEN_LESS_EQUAL:
+	case MCC_TOKEN_GREATER_EQUAL:
+		return 4;
+	case MCC_TOKEN_PLUS:
+	case MCC_TOKEN_MINUS:
+		return 5;
+	case MCC_TOKEN_ASTERISK:
+	case MCC_TOKEN_SLASH:
+		return 6;
 	default:
 		return 0;
 	}
 }
 
-static int precedence_from_binary_op(enum mcc_ast_binary_op op)
+static enum mcc_ast_binary_op binary_op_from_token(enum mcc_token token)
 {
-	switch (op) {
-	case MCC_AST_BINARY_OP_ADD:
-	case MCC_AST_BINARY_OP_SUB:
-		return 1;
-	case MCC_AST_BINARY_OP_MUL:
-	case MCC_AST_BINARY_OP_DIV:
-		return 2;
+	switch (token) {
+	case MCC_TOKEN_OR:
+		return MCC_AST_BINARY_OP_OR;
+	case MCC_TOKEN_AND:
+		return MCC_AST_BINARY_OP_AND;
+	case MCC_TOKEN_EQUAL:
+		return MCC_AST_BINARY_OP_EQ;
+	case MCC_TOKEN_NOT_EQUAL:
+		return MCC_AST_BINARY_OP_NE;
+	case MCC_TOKEN_LESS:
+		return MCC_AST_BINARY_OP_LT;
+	case MCC_TOKEN_GREATER:
+		return MCC_AST_BINARY_OP_GT;
+	case MCC_TOKEN_LESS_EQUAL:
+		return MCC_AST_BINARY_OP_LE;
+	case MCC_TOKEN_GREATER_EQUAL:
+		return MCC_AST_BINARY_OP_GE;
+	case MCC_TOKEN_PLUS:
+		return MCC_AST_BINARY_OP_ADD;
+	case MCC_TOKEN_MINUS:
+		return MCC_AST_BINARY_OP_SUB;
+	case MCC_TOKEN_ASTERISK:
+		return MCC_AST_BINARY_OP_MUL;
+	case MCC_TOKEN_SLASH:
+		return MCC_AST_BINARY_OP_DIV;
+	default:
+		break;
 	}
 
-	return 0;
+	assert(false);
+	return MCC_AST_BINARY_OP_ADD;
 }
 
-// Like `parser_accept` but will also take precedence into account. `precedence`
-// is updated with the new precedence iff successful.
-static bool parser_accept_with_precedence(struct parser *parser, enum mcc_token token, int *precedence)
+// ---------------------------------------------------------------- Types
+
+// Accepts one of the types `bool`, `int`, `float`, or `string`.
+static bool parse_type(struct parser *parser, enum mcc_ast_data_type *type)
 {
 	assert(parser);
-	assert(precedence);
-
-	if (parser->lexeme.token != token) {
+	assert(type);
+
+	if (accept(MCC_TOKEN_BOOL)) {
+		*type = MCC_AST_DATA_TYPE_BOOL;
+	} else if (accept(MCC_TOKEN_INT)) {
+		*type = MCC_AST_DATA_TYPE_INT;
+	} else if (accept(MCC_TOKEN_FLOAT)) {
+		*type = MCC_AST_DATA_TYPE_FLOAT;
+	} else if (accept(MCC_TOKEN_STRING)) {
+		*type = MCC_AST_DATA_TYPE_STRING;
+	} else {
 		return false;
 	}
 
-	int token_precedence = precedence_from_token(token);
-	if (*precedence > token_precedence) {
-		return false;
+	return true;
+}
+
+static bool is_type_token(enum mcc_token token)
+{
+	return token == MCC_TOKEN_BOOL || token == MCC_TOKEN_INT || token == MCC_TOKEN_FLOAT ||
+	       token == MCC_TOKEN_STRING;
+}
+
+// ---------------------------------------------------------------- Identifiers
+
+static struct mcc_ast_identifier *parse_identifier(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_lexeme lexeme = parser->lexeme;
+	if (!accept(MCC_TOKEN_IDENTIFIER)) {
+		return NULL;
 	}
 
-	*precedence = token_precedence;
-	parser_next(parser);
-	return true;
+	struct mcc_ast_identifier *result = mcc_ast_new_identifier(lexeme.s_value);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		return NULL;
+	}
+
+	result->node.sloc = lexeme.sloc;
+	return result;
 }
 
-#define accept_with_precedence(token, precedence) parser_accept_with_precedence(parser, token, precedence)
+// Same as `parse_identifier`, but errors out if there is no identifier.
+static struct mcc_ast_identifier *expect_identifier(struct parser *parser)
+{
+	assert(parser);
+
+	if (parser->lexeme.token != MCC_TOKEN_IDENTIFIER) {
+		error("unexpected '%s', expected identifier", mcc_token_to_string(parser->lexeme.token));
+		return NULL;
+	}
+
+	return parse_identifier(parser);
+}
 
 // ---------------------------------------------------------------- Literals
 
@@ -183,6 +260,12 @@ static struct mcc_ast_literal *parse_literal(struct parser *parser)
 		result = mcc_ast_new_literal_int(lexeme.i_value);
 	} else if (accept(MCC_TOKEN_FLOAT_LITERAL)) {
 		result = mcc_ast_new_literal_float(lexeme.f_value);
+	} else if (accept(MCC_TOKEN_TRUE)) {
+		result = mcc_ast_new_literal_bool(true);
+	} else if (accept(MCC_TOKEN_FALSE)) {
+		result = mcc_ast_new_literal_bool(false);
+	} else if (accept(MCC_TOKEN_STRING_LITERAL)) {
+		result = mcc_ast_new_literal_string(lexeme.s_value);
 	} else {
 		return NULL;
 	}
@@ -198,37 +281,54 @@ static struct mcc_ast_literal *parse_literal(struct parser *parser)
 
 // ---------------------------------------------------------------- Expressions
 
-static struct mcc_ast_expression *parse_expression_literal(struct parser *);
-static struct mcc_ast_expression *parse_expression_parenth(struct parser *);
+static struct mcc_ast_expression *parse_expression_unary_op(struct parser *);
 static struct mcc_ast_expression *parse_expression_binary_op(struct parser *, struct mcc_ast_expression *, int);
 
 static struct mcc_ast_expression *parse_expression(struct parser *parser, int precedence)
 {
 	assert(parser);
 
-	struct mcc_ast_expression *result = NULL;
-	struct mcc_sloc sloc = parser->lexeme.sloc;
+	struct mcc_ast_expression *lhs = parse_expression_unary_op(parser);
+	if (!lhs) {
+		return NULL;
+	}
 
-	// expression rules
-	result = result ? result : parse_expression_literal(parser);
-	result = result ? result : parse_expression_parenth(parser);
+	return parse_expression_binary_op(parser, lhs, precedence);
+}
+
+// Same as `parse_expression`, but errors out if there is no expression.
+static struct mcc_ast_expression *expect_expression(struct parser *parser)
+{
+	assert(parser);
 
+	struct mcc_ast_expression *result = parse_expression(parser, 0);
 	if (!result) {
+		error("unexpected '%s', expected expression", mcc_token_to_string(parser->lexeme.token));
+	}
+
+	return result;
+}
+
+// Parses the `[ expression ]` part of an array element.
+static struct mcc_ast_expression *parse_array_index(struct parser *parser)
+{
+	assert(parser);
+
+	if (!accept(MCC_TOKEN_BRACKET_LEFT)) {
 		return NULL;
 	}
 
-	// continuation
-	while (true) {
-		struct mcc_ast_expression *binary_op = parse_expression_binary_op(parser, result, precedence);
-		if (!binary_op) {
-			break;
-		}
-		result->node.sloc = sloc;
-		result = binary_op;
+	struct mcc_ast_expression *index = expect_expression(parser);
+	if (!index) {
+		return NULL;
 	}
 
-	result->node.sloc = sloc;
-	return result;
+	if (!expect(MCC_TOKEN_BRACKET_RIGHT)) {
+		mcc_ast_delete_expression(index);
+		return NULL;
+	}
+
+	return index;
 }
 
 static struct mcc_ast_expression *parse_expression_literal(struct parser *parser)
@@ -279,45 +379,670 @@ static struct mcc_ast_expression *parse_expression_parenth(struct parser *parser
 	return result;
 }
 
+// Parses the argument list of a call to `callee`, which is consumed in any
+// case.
+static struct mcc_ast_expression *parse_expression_call(struct parser *parser, struct mcc_ast_identifier *callee)
+{
+	assert(parser);
+	assert(callee);
+
+	struct mcc_ast_expression *result = mcc_ast_new_expression_call(callee);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_identifier(callee);
+		return NULL;
+	}
+
+	if (!expect(MCC_TOKEN_PARENTH_LEFT)) {
+		mcc_ast_delete_expression(result);
+		return NULL;
+	}
+
+	if (accept(MCC_TOKEN_PARENTH_RIGHT)) {
+		return result;
+	}
+
+	do {
+		struct mcc_ast_expression *argument = expect_expression(parser);
+		if (!argument) {
+			mcc_ast_delete_expression(result);
+			return NULL;
+		}
+
+		if (!mcc_ast_add_argument(result, argument)) {
+			parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+			mcc_ast_delete_expression(argument);
+			mcc_ast_delete_expression(result);
+			return NULL;
+		}
+	} while (accept(MCC_TOKEN_COMMA));
+
+	if (!expect(MCC_TOKEN_PARENTH_RIGHT)) {
+		mcc_ast_delete_expression(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+// Creates an identifier or array element expression, depending on whether
+// `index` is set. Ownership of `identifier` and `index` is taken in any case.
 static struct mcc_ast_expression *
-parse_expression_binary_op(struct parser *parser, struct mcc_ast_expression *lhs, int precedence)
+new_expression_variable(struct parser *parser, struct mcc_ast_identifier *identifier, struct mcc_ast_expression *index)
+{
+	assert(parser);
+	assert(identifier);
+
+	struct mcc_ast_expression *result = index ? mcc_ast_new_expression_array_element(identifier, index)
+	                                          : mcc_ast_new_expression_identifier(identifier);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_identifier(identifier);
+		mcc_ast_delete_expression(index);
+		return NULL;
+	}
+
+	return result;
+}
+
+// Handles identifiers, array elements, and calls.
+static struct mcc_ast_expression *parse_expression_identifier(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_ast_identifier *identifier = parse_identifier(parser);
+	if (!identifier) {
+		return NULL;
+	}
+
+	if (parser->lexeme.token == MCC_TOKEN_PARENTH_LEFT) {
+		return parse_expression_call(parser, identifier);
+	}
+
+	struct mcc_ast_expression *index = parse_array_index(parser);
+	if (!index && parser->error) {
+		mcc_ast_delete_identifier(identifier);
+		return NULL;
+	}
+
+	return new_expression_variable(parser, identifier, index);
+}
+
+static struct mcc_ast_expression *parse_expression_primary(struct parser *parser)
 {
 	assert(parser);
 
-	enum mcc_ast_binary_op op;
-	if (accept_with_precedence(MCC_TOKEN_PLUS, &precedence)) {
-		op = MCC_AST_BINARY_OP_ADD;
-	} else if (accept_with_precedence(MCC_TOKEN_ASTERISK, &precedence)) {
-		op = MCC_AST_BINARY_OP_MUL;
+	struct mcc_ast_expression *result = NULL;
+	struct mcc_sloc sloc = parser->lexeme.sloc;
+
+	// expression rules
+	result = result ? result : parse_expression_literal(parser);
+	result = result ? result : parse_expression_parenth(parser);
+	result = result ? result : parse_expression_identifier(parser);
+
+	if (!result) {
+		return NULL;
+	}
+
+	result->node.sloc = sloc;
+	return result;
+}
+
+static struct mcc_ast_expression *parse_expression_unary_op(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_sloc sloc = parser->lexeme.sloc;
+
+	enum mcc_ast_unary_op op;
+	if (accept(MCC_TOKEN_MINUS)) {
+		op = MCC_AST_UNARY_OP_NEG;
+	} else if (accept(MCC_TOKEN_NOT)) {
+		op = MCC_AST_UNARY_OP_NOT;
 	} else {
+		return parse_expression_primary(parser);
+	}
+
+	struct mcc_ast_expression *operand = parse_expression_unary_op(parser);
+	if (!operand) {
+		error("expression_unary_op: expected operand");
+		return NULL;
+	}
+
+	struct mcc_ast_expression *result = mcc_ast_new_expression_unary_op(op, operand);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_expression(operand);
+		return NULL;
+	}
+
+	result->node.sloc = sloc;
+	return result;
+}
+
+// Continues parsing binary operations with at least the given `precedence`,
+// using `lhs` as left-most operand. Ownership of `lhs` is taken in any case.
+// All binary operators are left-associative.
+static struct mcc_ast_expression *
+parse_expression_binary_op(struct parser *parser, struct mcc_ast_expression *lhs, int precedence)
+{
+	assert(parser);
+	assert(lhs);
+
+	while (true) {
+		enum mcc_token token = parser->lexeme.token;
+		int token_precedence = precedence_from_token(token);
+		if (token_precedence == 0 || token_precedence < precedence) {
+			return lhs;
+		}
+
+		parser_next(parser);
+
+		struct mcc_ast_expression *rhs = parse_expression(parser, token_precedence + 1);
+		if (!rhs) {
+			error("expression_binary_op: expected rhs expression");
+			mcc_ast_delete_expression(lhs);
+			return NULL;
+		}
+
+		struct mcc_ast_expression *result =
+		    mcc_ast_new_expression_binary_op(binary_op_from_token(token), lhs, rhs);
+		if (!result) {
+			parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+			mcc_ast_delete_expression(lhs);
+			mcc_ast_delete_expression(rhs);
+			return NULL;
+		}
+
+		result->node.sloc = lhs->node.sloc;
+		lhs = result;
+	}
+}
+
+// ---------------------------------------------------------------- Declarations
+
+static struct mcc_ast_declaration *parse_declaration(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_sloc sloc = parser->lexeme.sloc;
+
+	enum mcc_ast_data_type type;
+	if (!parse_type(parser, &type)) {
+		return NULL;
+	}
+
+	bool is_array = false;
+	long array_size = 0;
+	if (accept(MCC_TOKEN_BRACKET_LEFT)) {
+		struct mcc_lexeme size = parser->lexeme;
+		if (!expect(MCC_TOKEN_INT_LITERAL) || !expect(MCC_TOKEN_BRACKET_RIGHT)) {
+			return NULL;
+		}
+
+		is_array = true;
+		array_size = size.i_value;
+	}
+
+	struct mcc_ast_identifier *identifier = expect_identifier(parser);
+	if (!identifier) {
+		return NULL;
+	}
+
+	struct mcc_ast_declaration *result = is_array ? mcc_ast_new_declaration_array(type, array_size, identifier)
+	                                              : mcc_ast_new_declaration(type, identifier);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_identifier(identifier);
+		return NULL;
+	}
+
+	result->node.sloc = sloc;
+	return result;
+}
+
+// ---------------------------------------------------------------- Statements
+
+static struct mcc_ast_statement *parse_statement(struct parser *);
+
+// Same as `parse_statement`, but errors out if there is no statement.
+static struct mcc_ast_statement *expect_statement(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_ast_statement *result = parse_statement(parser);
+	if (!result) {
+		error("unexpected '%s', expected statement", mcc_token_to_string(parser->lexeme.token));
+	}
+
+	return result;
+}
+
+// Parses the `( expression )` part of if and while statements.
+static struct mcc_ast_expression *parse_condition(struct parser *parser)
+{
+	assert(parser);
+
+	if (!expect(MCC_TOKEN_PARENTH_LEFT)) {
+		return NULL;
+	}
+
+	struct mcc_ast_expression *condition = expect_expression(parser);
+	if (!condition) {
+		return NULL;
+	}
+
+	if (!expect(MCC_TOKEN_PARENTH_RIGHT)) {
+		mcc_ast_delete_expression(condition);
+		return NULL;
+	}
+
+	return condition;
+}
+
+static struct mcc_ast_statement *parse_statement_if(struct parser *parser)
+{
+	assert(parser);
+
+	if (!accept(MCC_TOKEN_IF)) {
+		return NULL;
+	}
+
+	struct mcc_ast_expression *condition = parse_condition(parser);
+	if (!condition) {
+		return NULL;
+	}
+
+	struct mcc_ast_statement *on_true = expect_statement(parser);
+	if (!on_true) {
+		mcc_ast_delete_expression(condition);
+		return NULL;
+	}
+
+	// A dangling else belongs to the innermost if, which is exactly what
+	// happens by trying to match it here.
+	struct mcc_ast_statement *on_false = NULL;
+	if (accept(MCC_TOKEN_ELSE)) {
+		on_false = expect_statement(parser);
+		if (!on_false) {
+			mcc_ast_delete_expression(condition);
+			mcc_ast_delete_statement(on_true);
+			return NULL;
+		}
+	}
+
+	struct mcc_ast_statement *result = mcc_ast_new_statement_if(condition, on_true, on_false);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_expression(condition);
+		mcc_ast_delete_statement(on_true);
+		mcc_ast_delete_statement(on_false);
+		return NULL;
+	}
+
+	return result;
+}
+
+static struct mcc_ast_statement *parse_statement_while(struct parser *parser)
+{
+	assert(parser);
+
+	if (!accept(MCC_TOKEN_WHILE)) {
+		return NULL;
+	}
+
+	struct mcc_ast_expression *condition = parse_condition(parser);
+	if (!condition) {
+		return NULL;
+	}
+
+	struct mcc_ast_statement *body = expect_statement(parser);
+	if (!body) {
+		mcc_ast_delete_expression(condition);
+		return NULL;
+	}
+
+	struct mcc_ast_statement *result = mcc_ast_new_statement_while(condition, body);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_expression(condition);
+		mcc_ast_delete_statement(body);
+		return NULL;
+	}
+
+	return result;
+}
+
+static struct mcc_ast_statement *parse_statement_return(struct parser *parser)
+{
+	assert(parser);
+
+	if (!accept(MCC_TOKEN_RETURN)) {
+		return NULL;
+	}
+
+	struct mcc_ast_expression *value = NULL;
+	if (!accept(MCC_TOKEN_SEMICOLON)) {
+		value = expect_expression(parser);
+		if (!value) {
+			return NULL;
+		}
+
+		if (!expect(MCC_TOKEN_SEMICOLON)) {
+			mcc_ast_delete_expression(value);
+			return NULL;
+		}
+	}
+
+	struct mcc_ast_statement *result = mcc_ast_new_statement_return(value);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_expression(value);
+		return NULL;
+	}
+
+	return result;
+}
+
+static struct mcc_ast_statement *parse_statement_declaration(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_ast_declaration *declaration = parse_declaration(parser);
+	if (!declaration) {
 		return NULL;
 	}
 
-	struct mcc_ast_expression *rhs = parse_expression(parser, precedence);
-	if (!rhs) {
-		error("expression_binary_op: expected rhs expression");
+	if (!expect(MCC_TOKEN_SEMICOLON)) {
+		mcc_ast_delete_declaration(declaration);
 		return NULL;
 	}
 
-	struct mcc_ast_expression *result = mcc_ast_new_expression_binary_op(op, lhs, rhs);
+	struct mcc_ast_statement *result = mcc_ast_new_statement_declaration(declaration);
 	if (!result) {
 		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_declaration(declaration);
+		return NULL;
+	}
+
+	return result;
+}
+
+static struct mcc_ast_statement *parse_statement_compound(struct parser *parser)
+{
+	assert(parser);
+
+	if (!accept(MCC_TOKEN_BRACE_LEFT)) {
+		return NULL;
+	}
+
+	struct mcc_ast_statement *result = mcc_ast_new_statement_compound();
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		return NULL;
+	}
+
+	while (!accept(MCC_TOKEN_BRACE_RIGHT)) {
+		struct mcc_ast_statement *statement = expect_statement(parser);
+		if (!statement) {
+			mcc_ast_delete_statement(result);
+			return NULL;
+		}
+
+		if (!mcc_ast_add_statement(result, statement)) {
+			parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+			mcc_ast_delete_statement(statement);
+			mcc_ast_delete_statement(result);
+			return NULL;
+		}
+	}
+
+	return result;
+}
+
+// Wraps `expression` in an expression statement terminated by a semicolon.
+// Ownership of `expression` is taken in any case.
+static struct mcc_ast_statement *finish_statement_expression(struct parser *parser,
+                                                             struct mcc_ast_expression *expression)
+{
+	assert(parser);
+
+	if (!expression) {
+		return NULL;
+	}
+
+	if (!expect(MCC_TOKEN_SEMICOLON)) {
+		mcc_ast_delete_expression(expression);
+		return NULL;
+	}
+
+	struct mcc_ast_statement *result = mcc_ast_new_statement_expression(expression);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_expression(expression);
+		return NULL;
+	}
+
+	return result;
+}
+
+// Finishes an assignment whose target has already been parsed. Ownership of
+// `identifier` and `index` is taken in any case.
+static struct mcc_ast_statement *finish_statement_assignment(struct parser *parser,
+                                                             struct mcc_ast_identifier *identifier,
+                                                             struct mcc_ast_expression *index)
+{
+	assert(parser);
+	assert(identifier);
+
+	struct mcc_ast_expression *rhs = expect_expression(parser);
+	if (!rhs || !expect(MCC_TOKEN_SEMICOLON)) {
+		mcc_ast_delete_identifier(identifier);
+		mcc_ast_delete_expression(index);
 		mcc_ast_delete_expression(rhs);
 		return NULL;
 	}
 
-	// Fix associativity, assuming left-to-right associativity.
-	if (rhs->type == MCC_AST_EXPRESSION_TYPE_BINARY_OP &&
-	    precedence_from_binary_op(rhs->op) == precedence_from_binary_op(op)) {
-		// find the first lhs to replace
-		struct mcc_ast_expression *new_rhs = rhs;
-		while (new_rhs->lhs->type == MCC_AST_EXPRESSION_TYPE_BINARY_OP &&
-		       precedence_from_binary_op(new_rhs->lhs->op) == precedence_from_binary_op(op)) {
-			new_rhs = new_rhs->lhs;
+	struct mcc_ast_assignment *assignment = mcc_ast_new_assignment(identifier, index, rhs);
+	if (!assignment) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_identifier(identifier);
+		mcc_ast_delete_expression(index);
+		mcc_ast_delete_expression(rhs);
+		return NULL;
+	}
+	assignment->node.sloc = identifier->node.sloc;
+
+	struct mcc_ast_statement *result = mcc_ast_new_statement_assignment(assignment);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_assignment(assignment);
+		return NULL;
+	}
+
+	return result;
+}
+
+// Assignments and expressions may both start with an identifier, optionally
+// followed by an index. Only the next token tells them apart, therefore the
+// common prefix is parsed first.
+static struct mcc_ast_statement *parse_statement_assignment_or_expression(struct parser *parser)
+{
+	assert(parser);
+
+	if (parser->lexeme.token != MCC_TOKEN_IDENTIFIER) {
+		return finish_statement_expression(parser, parse_expression(parser, 0));
+	}
+
+	struct mcc_sloc sloc = parser->lexeme.sloc;
+	struct mcc_ast_identifier *identifier = parse_identifier(parser);
+	if (!identifier) {
+		return NULL;
+	}
+
+	struct mcc_ast_expression *lhs = NULL;
+	if (parser->lexeme.token == MCC_TOKEN_PARENTH_LEFT) {
+		lhs = parse_expression_call(parser, identifier);
+	} else {
+		struct mcc_ast_expression *index = parse_array_index(parser);
+		if (!index && parser->error) {
+			mcc_ast_delete_identifier(identifier);
+			return NULL;
+		}
+
+		if (accept(MCC_TOKEN_ASSIGN)) {
+			return finish_statement_assignment(parser, identifier, index);
+		}
+
+		lhs = new_expression_variable(parser, identifier, index);
+	}
+
+	if (!lhs) {
+		return NULL;
+	}
+	lhs->node.sloc = sloc;
+
+	return finish_statement_expression(parser, parse_expression_binary_op(parser, lhs, 0));
+}
+
+static struct mcc_ast_statement *parse_statement(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_ast_statement *result = NULL;
+	struct mcc_sloc sloc = parser->lexeme.sloc;
+
+	switch (parser->lexeme.token) {
+	case MCC_TOKEN_IF:
+		result = parse_statement_if(parser);
+		break;
+	case MCC_TOKEN_WHILE:
+		result = parse_statement_while(parser);
+		break;
+	case MCC_TOKEN_RETURN:
+		result = parse_statement_return(parser);
+		break;
+	case MCC_TOKEN_BRACE_LEFT:
+		result = parse_statement_compound(parser);
+		break;
+	default:
+		if (is_type_token(parser->lexeme.token)) {
+			result = parse_statement_declaration(parser);
+		} else {
+			result = parse_statement_assignment_or_expression(parser);
+		}
+		break;
+	}
+
+	if (!result) {
+		return NULL;
+	}
+
+	result->node.sloc = sloc;
+	return result;
+}
+
+// ---------------------------------------------------------------- Functions
+
+static bool parse_parameters(struct parser *parser, struct mcc_ast_function *function)
+{
+	assert(parser);
+	assert(function);
+
+	if (!is_type_token(parser->lexeme.token)) {
+		return true;
+	}
+
+	do {
+		struct mcc_ast_declaration *parameter = parse_declaration(parser);
+		if (!parameter) {
+			error("unexpected '%s', expected parameter", mcc_token_to_string(parser->lexeme.token));
+			return false;
+		}
+
+		if (!mcc_ast_add_parameter(function, parameter)) {
+			parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+			mcc_ast_delete_declaration(parameter);
+			return false;
+		}
+	} while (accept(MCC_TOKEN_COMMA));
+
+	return true;
+}
+
+static struct mcc_ast_function *parse_function(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_sloc sloc = parser->lexeme.sloc;
+
+	enum mcc_ast_data_type return_type = MCC_AST_DATA_TYPE_VOID;
+	if (!accept(MCC_TOKEN_VOID) && !parse_type(parser, &return_type)) {
+		error("unexpected '%s', expected function definition", mcc_token_to_string(parser->lexeme.token));
+		return NULL;
+	}
+
+	struct mcc_ast_identifier *identifier = expect_identifier(parser);
+	if (!identifier) {
+		return NULL;
+	}
+
+	struct mcc_ast_function *result = mcc_ast_new_function(return_type, identifier);
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		mcc_ast_delete_identifier(identifier);
+		return NULL;
+	}
+	result->node.sloc = sloc;
+
+	if (!expect(MCC_TOKEN_PARENTH_LEFT) || !parse_parameters(parser, result) || !expect(MCC_TOKEN_PARENTH_RIGHT)) {
+		mcc_ast_delete_function(result);
+		return NULL;
+	}
+
+	struct mcc_sloc body_sloc = parser->lexeme.sloc;
+	if (parser->lexeme.token != MCC_TOKEN_BRACE_LEFT) {
+		error("unexpected '%s', expected '{'", mcc_token_to_string(parser->lexeme.token));
+		mcc_ast_delete_function(result);
+		return NULL;
+	}
+
+	result->body = parse_statement_compound(parser);
+	if (!result->body) {
+		mcc_ast_delete_function(result);
+		return NULL;
+	}
+	result->body->node.sloc = body_sloc;
+
+	return result;
+}
+
+// ---------------------------------------------------------------- Program
+
+static struct mcc_ast_program *parse_program(struct parser *parser)
+{
+	assert(parser);
+
+	struct mcc_ast_program *result = mcc_ast_new_program();
+	if (!result) {
+		parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+		return NULL;
+	}
+	result->node.sloc = parser->lexeme.sloc;
+
+	while (parser->lexeme.token != MCC_TOKEN_EOF) {
+		struct mcc_ast_function *function = parse_function(parser);
+		if (!function) {
+			mcc_ast_delete_program(result);
+			return NULL;
+		}
+
+		if (!mcc_ast_add_function(result, function)) {
+			parser_error(parser, MCC_PARSER_ERROR_ALLOCATION_ERROR);
+			mcc_ast_delete_function(function);
+			mcc_ast_delete_program(result);
+			return NULL;
 		}
-		result->rhs = new_rhs->lhs;
-		new_rhs->lhs = result;
-		return rhs;
 	}
 
 	return result;
@@ -357,25 +1082,13 @@ void mcc_parser_result_print_error(FILE *out, struct mcc_parser_result *result)
 	}
 }
 
-struct mcc_parser_result mcc_parse_string(const char *input)
-{
-	assert(input);
-
-	FILE *in = fmemopen((void *)input, strlen(input), "r");
-	if (!in) {
-		return (struct mcc_parser_result){
-		    .error = MCC_PARSER_ERROR_UNABLE_TO_OPEN_STREAM,
-		};
-	}
-
-	struct mcc_parser_result result = mcc_parse_file(in, NULL);
-
-	fclose(in);
-
-	return result;
-}
+// Entry points of the parser.
+enum parse_entry {
+	PARSE_ENTRY_EXPRESSION,
+	PARSE_ENTRY_PROGRAM,
+};
 
-struct mcc_parser_result mcc_parse_file(FILE *input, const char *filepath)
+static struct mcc_parser_result parse(FILE *input, const char *filepath, enum parse_entry entry)
 {
 	assert(input);
 
@@ -389,18 +1102,71 @@ struct mcc_parser_result mcc_parse_file(FILE *input, const char *filepath)
 	// Prime first lexeme.
 	parser_next(&parser);
 
-	struct mcc_ast_expression *expr = parse_expression(&parser, 0);
-	if (!expr) {
-		parser_error_msg(&parser, MCC_PARSER_ERROR_PARSE_ERROR, parser.lexeme.sloc, "expected expression");
+	struct mcc_ast_expression *expr = NULL;
+	struct mcc_ast_program *program = NULL;
+
+	if (entry == PARSE_ENTRY_EXPRESSION) {
+		expr = parse_expression(&parser, 0);
+		if (!expr) {
+			parser_error_msg(&parser, MCC_PARSER_ERROR_PARSE_ERROR, parser.lexeme.sloc,
+			                 "expected expression");
+		} else if (!parser_expect(&parser, MCC_TOKEN_EOF)) {
+			mcc_ast_delete_expression(expr);
+			expr = NULL;
+		}
+	} else {
+		program = parse_program(&parser);
 	}
 
 	struct mcc_parser_result result = {
 	    .expression = expr,
+	    .program = program,
+	    .lexer_stats = parser.lexer.stats,
 	    .error = parser.error,
 	};
 	snprintf(result.error_msg, sizeof(result.error_msg), "%s", parser.error_msg);
 
+	// Strings referenced by the AST outlive the lexer.
+	if (program) {
+		mcc_lexer_take_strings(&parser.lexer, &program->strings);
+	} else if (expr) {
+		mcc_lexer_take_strings(&parser.lexer, &result.strings);
+	}
+
 	mcc_lexer_deinit(&parser.lexer);
 
 	return result;
 }
+
+static struct mcc_parser_result parse_string(const char *input, enum parse_entry entry)
+{
+	assert(input);
+
+	FILE *in = fmemopen((void *)input, strlen(input), "r");
+	if (!in) {
+		return (struct mcc_parser_result){
+		    .error = MCC_PARSER_ERROR_UNABLE_TO_OPEN_STREAM,
+		};
+	}
+
+	struct mcc_parser_result result = parse(in, NULL, entry);
+
+	fclose(in);
+
+	return result;
+}
+
+struct mcc_parser_result mcc_parse_string(const char *input)
+{
+	return parse_string(input, PARSE_ENTRY_EXPRESSION);
+}
+
+struct mcc_parser_result mcc_parse_program_string(const char *input)
+{
+	return parse_string(input, PARSE_ENTRY_PROGRAM);
+}
+
+struct mcc_parser_result mcc_parse_file(FILE *input, const char *filepath)
+{
+	return parse(input, filepath, PARSE_ENTRY_PROGRAM);
+}
@@ -0,0 +1,231 @@
+#include "mcc/pass.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "mcc/dce.h"
+#include "mcc/gvn.h"
+#include "mcc/inline.h"
+#include "mcc/licm.h"
+#include "mcc/memoize.h"
+#include "mcc/purity.h"
+#include "mcc/sccp.h"
+#include "mcc/ssa.h"
+#include "mcc/strength.h"
+#include "mcc/tailrec.h"
+#include "mcc/unroll.h"
+
+// Phis only occur in SSA form.
+static bool is_ssa(const struct mcc_tac_function *function)
+{
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (function->instructions[i].op == MCC_TAC_OP_PHI) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool run_out_of_ssa(struct mcc_tac_function *function)
+{
+	return !is_ssa(function) || mcc_ssa_destruct(function);
+}
+
+static bool run_compact(struct mcc_tac_function *function)
+{
+	mcc_tac_function_compact(function);
+	return true;
+}
+
+// Functions in SSA form are left alone.
+static bool run_dce(struct mcc_tac_function *function)
+{
+	return is_ssa(function) || mcc_dce_function(function, NULL);
+}
+
+static bool run_sccp(struct mcc_tac_function *function)
+{
+	return mcc_sccp_function(function, NULL);
+}
+
+// Value numbering needs SSA form, functions not in it are translated there
+// and back.
+static bool run_gvn(struct mcc_tac_function *function)
+{
+	if (is_ssa(function)) {
+		return mcc_gvn_function(function, NULL);
+	}
+	if (!mcc_ssa_construct(function)) {
+		return false;
+	}
+	bool ok = mcc_gvn_function(function, NULL);
+	return mcc_ssa_destruct(function) && ok;
+}
+
+// Functions in SSA form are left alone.
+static bool run_strength_reduce(struct mcc_tac_function *function)
+{
+	return is_ssa(function) || mcc_strength_reduce_function(function, NULL);
+}
+
+// Functions in SSA form are left alone.
+static bool run_unroll(struct mcc_tac_function *function)
+{
+	return is_ssa(function) || mcc_unroll_function(function, NULL, NULL);
+}
+
+// Functions in SSA form are left alone.
+static bool run_tail_recursion(struct mcc_tac_function *function)
+{
+	return is_ssa(function) || mcc_tailrec_function(function, NULL);
+}
+
+static bool run_fold_pure_calls(struct mcc_tac_program *program)
+{
+	return mcc_purity_fold_calls(program, 0, NULL);
+}
+
+// Programs with functions in SSA form are left alone.
+static bool run_inline(struct mcc_tac_program *program)
+{
+	for (size_t f = 0; f < program->functions_count; f++) {
+		if (is_ssa(&program->functions[f])) {
+			return true;
+		}
+	}
+	return mcc_inline_program(program, NULL, NULL);
+}
+
+static bool run_licm(struct mcc_tac_program *program)
+{
+	return mcc_licm_program(program, NULL);
+}
+
+static bool run_auto_memoize(struct mcc_tac_program *program)
+{
+	return mcc_memoize_program(program, NULL);
+}
+
+const struct mcc_pass mcc_passes[] = {
+    {
+        .name = "ssa",
+        .description = "construct pruned SSA form",
+        .run_function = mcc_ssa_construct,
+    },
+    {
+        .name = "out-of-ssa",
+        .description = "replace phis by copies, coalescing where possible",
+        .run_function = run_out_of_ssa,
+    },
+    {
+        .name = "compact",
+        .description = "drop removed instructions",
+        .run_function = run_compact,
+    },
+    {
+        .name = "sccp",
+        .description = "propagate constants along executable paths, removing unreachable blocks",
+        .run_function = run_sccp,
+    },
+    {
+        .name = "dce",
+        .description = "propagate copies and remove dead instructions, to a fixed point",
+        .run_function = run_dce,
+    },
+    {
+        .name = "gvn",
+        .description = "replace recomputed values by copies, by dominator-based value numbering",
+        .run_function = run_gvn,
+    },
+    {
+        .name = "inline",
+        .description = "replace calls of small non-recursive functions by their body, callees first",
+        .run_program = run_inline,
+    },
+    {
+        .name = "licm",
+        .description = "hoist loop-invariant instructions, including pure calls, into loop preheaders",
+        .run_program = run_licm,
+    },
+    {
+        .name = "strength-reduce",
+        .description = "replace multiplications of induction variables by additions",
+        .run_function = run_strength_reduce,
+    },
+    {
+        .name = "unroll",
+        .description = "unroll counted loops, leaving the original loop for the remaining iterations",
+        .run_function = run_unroll,
+    },
+    {
+        .name = "tail-recursion",
+        .description = "turn calls of functions to themselves whose result is returned into loops",
+        .run_function = run_tail_recursion,
+    },
+    {
+        .name = "fold-pure-calls",
+        .description = "evaluate calls of pure functions with constant arguments",
+        .run_program = run_fold_pure_calls,
+    },
+    {
+        .name = "auto-memoize",
+        .description = "cache results of pure functions calling themselves more than once",
+        .run_program = run_auto_memoize,
+    },
+};
+
+const size_t mcc_passes_count = sizeof(mcc_passes) / sizeof(*mcc_passes);
+
+const char mcc_pass_default_pipeline[] = "tail-recursion,sccp,fold-pure-calls,inline,sccp,"
+                                         "gvn,licm,strength-reduce,unroll,dce,compact";
+
+const struct mcc_pass *mcc_pass_find(const char *name, size_t length)
+{
+	assert(name);
+
+	for (size_t i = 0; i < mcc_passes_count; i++) {
+		if (strlen(mcc_passes[i].name) == length && memcmp(mcc_passes[i].name, name, length) == 0) {
+			return &mcc_passes[i];
+		}
+	}
+	return NULL;
+}
+
+bool mcc_pass_run(const struct mcc_pass *pass, struct mcc_tac_program *program)
+{
+	assert(pass);
+	assert(program);
+	assert(!pass->run_function != !pass->run_program);
+
+	if (pass->run_program) {
+		return pass->run_program(program);
+	}
+
+	for (size_t i = 0; i < program->functions_count; i++) {
+		if (!pass->run_function(&program->functions[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool mcc_pass_run_pipeline(const char *pipeline, struct mcc_tac_program *program)
+{
+	assert(pipeline);
+	assert(program);
+
+	while (*pipeline) {
+		size_t length = strcspn(pipeline, ",");
+		const struct mcc_pass *pass = mcc_pass_find(pipeline, length);
+		assert(pass);
+		if (!mcc_pass_run(pass, program)) {
+			return false;
+		}
+
+		pipeline += length;
+		if (*pipeline == ',') {
+			pipeline++;
+		}
+	}
+	return true;
+}
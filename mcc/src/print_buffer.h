@@ -0,0 +1,124 @@
+// Print Buffer
+//
+// Private helpers for printers producing large outputs. Output is aggregated
+// in a fixed-size buffer and handed to the stream in big chunks, integers are
+// formatted by hand to avoid going through `fprintf` for every number.
+//
+// Write errors are sticky, check the result of `mcc_print_buffer_flush`.
+
+#ifndef MCC_PRINT_BUFFER_H
+#define MCC_PRINT_BUFFER_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MCC_PRINT_BUFFER_SIZE (64 * 1024)
+
+struct mcc_print_buffer {
+	FILE *out;
+	bool error;
+
+	size_t length;
+	char data[MCC_PRINT_BUFFER_SIZE];
+};
+
+static inline void mcc_print_buffer_init(struct mcc_print_buffer *buffer, FILE *out)
+{
+	assert(buffer);
+	assert(out);
+
+	buffer->out = out;
+	buffer->error = false;
+	buffer->length = 0;
+	buffer->data[0] = '\0';
+}
+
+// Returns false if any write failed since initialisation.
+static inline bool mcc_print_buffer_flush(struct mcc_print_buffer *buffer)
+{
+	assert(buffer);
+
+	if (buffer->length > 0 && !buffer->error &&
+	    fwrite(buffer->data, 1, buffer->length, buffer->out) != buffer->length) {
+		buffer->error = true;
+	}
+	buffer->length = 0;
+
+	return !buffer->error;
+}
+
+static inline void mcc_print_buffer_put_bytes(struct mcc_print_buffer *buffer, const char *bytes, size_t length)
+{
+	assert(buffer);
+	assert(bytes);
+
+	if (buffer->length + length > MCC_PRINT_BUFFER_SIZE) {
+		mcc_print_buffer_flush(buffer);
+
+		// Chunks larger than the buffer bypass it.
+		if (length > MCC_PRINT_BUFFER_SIZE) {
+			if (!buffer->error && fwrite(bytes, 1, length, buffer->out) != length) {
+				buffer->error = true;
+			}
+			return;
+		}
+	}
+
+	memcpy(buffer->data + buffer->length, bytes, length);
+	buffer->length += length;
+}
+
+static inline void mcc_print_buffer_put_char(struct mcc_print_buffer *buffer, char c)
+{
+	assert(buffer);
+
+	if (buffer->length == MCC_PRINT_BUFFER_SIZE) {
+		mcc_print_buffer_flush(buffer);
+	}
+	buffer->data[buffer->length++] = c;
+}
+
+static inline void mcc_print_buffer_put_string(struct mcc_print_buffer *buffer, const char *s)
+{
+	mcc_print_buffer_put_bytes(buffer, s, strlen(s));
+}
+
+// Large enough for any 64 bit integer in decimal, including sign.
+#define MCC_PRINT_BUFFER_INTEGER_SIZE 21
+
+// Formats `value` right-aligned into `digits`, returns a pointer to the first
+// character. The result is not NUL-terminated.
+static inline char *mcc_print_buffer_format_unsigned(char digits[MCC_PRINT_BUFFER_INTEGER_SIZE],
+                                                     unsigned long long value)
+{
+	char *p = digits + MCC_PRINT_BUFFER_INTEGER_SIZE;
+	do {
+		*--p = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+	return p;
+}
+
+static inline void mcc_print_buffer_put_unsigned(struct mcc_print_buffer *buffer, unsigned long long value)
+{
+	char digits[MCC_PRINT_BUFFER_INTEGER_SIZE];
+	char *p = mcc_print_buffer_format_unsigned(digits, value);
+	mcc_print_buffer_put_bytes(buffer, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+static inline void mcc_print_buffer_put_signed(struct mcc_print_buffer *buffer, long long value)
+{
+	// Negating in unsigned arithmetic keeps LLONG_MIN well-defined.
+	unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+
+	char digits[MCC_PRINT_BUFFER_INTEGER_SIZE];
+	char *p = mcc_print_buffer_format_unsigned(digits, magnitude);
+	if (value < 0) {
+		*--p = '-';
+	}
+	mcc_print_buffer_put_bytes(buffer, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+#endif // MCC_PRINT_BUFFER_H
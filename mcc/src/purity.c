@@ -0,0 +1,394 @@
+#include "mcc/purity.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/memoize.h"
+#include "mcc/vm.h"
+
+// Registers available to each evaluation, deep recursion is left to runtime.
+#define EVALUATION_STACK_SIZE (1u << 16)
+
+#define NO_FUNCTION UINT32_MAX
+
+// ------------------------------------------------------------------ Analysis
+
+// A call of a program function, or of a builtin if `callee` is NO_FUNCTION.
+struct call {
+	uint32_t caller;
+	uint32_t callee;
+
+	// Whether an argument is an array the caller did not create.
+	bool foreign_arrays;
+};
+
+struct analysis {
+	const struct mcc_tac_program *program;
+
+	struct call *calls;
+	size_t calls_count;
+	size_t calls_capacity;
+
+	// Whether a function reaches a builtin, and whether it stores into
+	// arrays it did not create, which can only be its parameters.
+	bool *io;
+	bool *writes_parameters;
+};
+
+// Returns whether all definitions of each variable of `function` are ARRAY
+// instructions, indexed by variable. Returns NULL on allocation failure.
+static bool *find_local_arrays(const struct mcc_tac_function *function)
+{
+	bool *local = calloc((size_t)function->variables_count + 1, sizeof(*local));
+	bool *defined = calloc((size_t)function->variables_count + 1, sizeof(*defined));
+	if (!local || !defined) {
+		free(local);
+		free(defined);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		uint32_t variable = mcc_tac_instruction_definition(instruction);
+		if (variable == 0) {
+			continue;
+		}
+
+		bool array = instruction->op == MCC_TAC_OP_ARRAY;
+		local[variable] = defined[variable] ? local[variable] && array : array;
+		defined[variable] = true;
+	}
+
+	free(defined);
+	return local;
+}
+
+// The runtime functions used by memoised functions have no effect visible to
+// the program.
+static bool is_memoization(const char *name)
+{
+	return strcmp(name, MCC_MEMOIZE_FIND) == 0 || strcmp(name, MCC_MEMOIZE_GET) == 0 ||
+	       strcmp(name, MCC_MEMOIZE_PUT) == 0;
+}
+
+static bool collect_function(struct analysis *analysis, uint32_t f)
+{
+	const struct mcc_tac_function *function = &analysis->program->functions[f];
+	bool *local = find_local_arrays(function);
+	if (!local) {
+		return false;
+	}
+
+	bool ok = true;
+	for (size_t i = 0; ok && i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+
+		if (instruction->op == MCC_TAC_OP_STORE && !local[instruction->result]) {
+			analysis->writes_parameters[f] = true;
+		} else if (instruction->op == MCC_TAC_OP_CALL) {
+			const char *name = function->strings[instruction->arg1];
+			const struct mcc_tac_function *callee = mcc_tac_program_find_function(analysis->program, name);
+			if (!callee && is_memoization(name)) {
+				continue;
+			}
+
+			struct call call = {
+			    .caller = f,
+			    .callee = callee ? (uint32_t)(callee - analysis->program->functions) : NO_FUNCTION,
+			};
+
+			const uint32_t *arguments = &function->operands[instruction->arg2];
+			for (uint32_t a = 1; a <= arguments[0]; a++) {
+				if (mcc_tac_function_variable_type(function, arguments[a]) == MCC_TAC_TYPE_ARRAY &&
+				    !local[arguments[a]]) {
+					call.foreign_arrays = true;
+				}
+			}
+			ok = mcc_array_push(analysis->calls, analysis->calls_count, analysis->calls_capacity, call);
+		}
+	}
+
+	free(local);
+	return ok;
+}
+
+// Propagates effects from callees to callers until nothing changes.
+static void propagate(struct analysis *analysis)
+{
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t i = 0; i < analysis->calls_count; i++) {
+			const struct call *call = &analysis->calls[i];
+			bool io = call->callee == NO_FUNCTION || analysis->io[call->callee];
+			bool writes = call->callee != NO_FUNCTION && call->foreign_arrays &&
+			              analysis->writes_parameters[call->callee];
+
+			if (io && !analysis->io[call->caller]) {
+				analysis->io[call->caller] = true;
+				changed = true;
+			}
+			if (writes && !analysis->writes_parameters[call->caller]) {
+				analysis->writes_parameters[call->caller] = true;
+				changed = true;
+			}
+		}
+	}
+}
+
+bool mcc_purity_analyse(const struct mcc_tac_program *program, bool *pure)
+{
+	assert(program);
+	assert(pure || program->functions_count == 0);
+
+	struct analysis analysis = {
+	    .program = program,
+	    .io = calloc(program->functions_count + 1, sizeof(*analysis.io)),
+	    .writes_parameters = calloc(program->functions_count + 1, sizeof(*analysis.writes_parameters)),
+	};
+
+	bool ok = analysis.io && analysis.writes_parameters;
+	for (size_t f = 0; ok && f < program->functions_count; f++) {
+		ok = collect_function(&analysis, (uint32_t)f);
+	}
+
+	if (ok) {
+		propagate(&analysis);
+		for (size_t f = 0; f < program->functions_count; f++) {
+			pure[f] = !analysis.io[f] && !analysis.writes_parameters[f];
+		}
+	}
+
+	free(analysis.calls);
+	free(analysis.io);
+	free(analysis.writes_parameters);
+	return ok;
+}
+
+// ------------------------------------------------------------------- Folding
+
+// A call replaced by its result.
+struct fold {
+	uint32_t function;
+	size_t index;
+	union mcc_vm_value value;
+};
+
+struct folder {
+	const struct mcc_tac_program *program;
+	const bool *pure;
+	const struct mcc_vm *vm;
+	struct mcc_vm_options options;
+
+	struct fold *folds;
+	size_t folds_count;
+	size_t folds_capacity;
+
+	// Value of each variable of the current function known to be constant,
+	// valid if the variable's stamp equals the current block's.
+	union mcc_vm_value *values;
+	uint32_t *stamps;
+	uint32_t block;
+};
+
+static union mcc_vm_value constant_value(const struct mcc_tac_function *function,
+                                         const struct mcc_tac_instruction *instruction)
+{
+	switch ((enum mcc_tac_type)instruction->type) {
+	case MCC_TAC_TYPE_FLOAT:
+		return (union mcc_vm_value){.f = (float)mcc_tac_bits_float(function->constants[instruction->arg1])};
+	case MCC_TAC_TYPE_STRING:
+		return (union mcc_vm_value){.s = function->strings[instruction->arg1]};
+	default:
+		return (union mcc_vm_value){.i = (int32_t)mcc_tac_bits_int(function->constants[instruction->arg1])};
+	}
+}
+
+// Evaluates the call `instruction` if possible, storing its result in
+// `value`. Returns false if the call cannot be folded, setting `failed` on
+// allocation failure.
+static bool evaluate(struct folder *folder,
+                     const struct mcc_tac_function *function,
+                     const struct mcc_tac_instruction *instruction,
+                     union mcc_vm_value *value,
+                     bool *failed)
+{
+	const struct mcc_tac_function *callee =
+	    mcc_tac_program_find_function(folder->program, function->strings[instruction->arg1]);
+	if (!callee || !folder->pure[callee - folder->program->functions]) {
+		return false;
+	}
+
+	const uint32_t *arguments = &function->operands[instruction->arg2];
+	if (arguments[0] != callee->parameters_count) {
+		return false;
+	}
+	for (uint32_t a = 1; a <= arguments[0]; a++) {
+		if (folder->stamps[arguments[a]] != folder->block) {
+			return false;
+		}
+	}
+
+	union mcc_vm_value *values = malloc((arguments[0] + 1) * sizeof(*values));
+	if (!values) {
+		*failed = true;
+		return false;
+	}
+	for (uint32_t a = 0; a < arguments[0]; a++) {
+		values[a] = folder->values[arguments[a + 1]];
+	}
+
+	struct mcc_vm_result result = mcc_vm_call(folder->vm, callee->name, values, arguments[0], &folder->options);
+	free(values);
+
+	*value = result.value;
+	*failed = result.error == MCC_VM_ERROR_ALLOCATION_ERROR;
+	return result.error == MCC_VM_ERROR_NONE;
+}
+
+static bool find_folds(struct folder *folder, uint32_t f)
+{
+	const struct mcc_tac_function *function = &folder->program->functions[f];
+	folder->values = malloc(((size_t)function->variables_count + 1) * sizeof(*folder->values));
+	folder->stamps = calloc((size_t)function->variables_count + 1, sizeof(*folder->stamps));
+	if (!folder->values || !folder->stamps) {
+		return false;
+	}
+
+	// Stamp 0 marks variables never known.
+	folder->block = 1;
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		uint32_t variable = mcc_tac_instruction_definition(instruction);
+
+		switch ((enum mcc_tac_op)instruction->op) {
+		case MCC_TAC_OP_LABEL:
+		case MCC_TAC_OP_JUMP:
+		case MCC_TAC_OP_JUMP_IF:
+		case MCC_TAC_OP_JUMP_IF_NOT:
+		case MCC_TAC_OP_RETURN:
+			folder->block++;
+			break;
+
+		case MCC_TAC_OP_CONST:
+			folder->values[variable] = constant_value(function, instruction);
+			folder->stamps[variable] = folder->block;
+			continue;
+
+		case MCC_TAC_OP_CALL: {
+			struct fold fold = {.function = f, .index = i};
+			bool failed = false;
+			if (!evaluate(folder, function, instruction, &fold.value, &failed)) {
+				if (failed) {
+					return false;
+				}
+				break;
+			}
+			if (!mcc_array_push(folder->folds, folder->folds_count, folder->folds_capacity, fold)) {
+				return false;
+			}
+			if (variable) {
+				folder->values[variable] = fold.value;
+				folder->stamps[variable] = folder->block;
+			}
+			continue;
+		}
+
+		default:
+			break;
+		}
+
+		if (variable) {
+			folder->stamps[variable] = 0;
+		}
+	}
+	return true;
+}
+
+static bool apply_fold(struct mcc_tac_program *program, const struct fold *fold)
+{
+	struct mcc_tac_function *function = &program->functions[fold->function];
+	struct mcc_tac_instruction *instruction = &function->instructions[fold->index];
+	if (instruction->type == MCC_TAC_TYPE_VOID) {
+		mcc_tac_function_remove(function, fold->index);
+		return true;
+	}
+
+	uint32_t index;
+	bool ok;
+	switch ((enum mcc_tac_type)instruction->type) {
+	case MCC_TAC_TYPE_FLOAT:
+		ok = mcc_tac_function_add_constant(function, mcc_tac_float_bits(fold->value.f), &index);
+		break;
+	case MCC_TAC_TYPE_STRING:
+		ok = mcc_tac_function_add_string(function, fold->value.s, &index);
+		break;
+	default:
+		ok = mcc_tac_function_add_constant(function, mcc_tac_int_bits(fold->value.i), &index);
+		break;
+	}
+	if (ok) {
+		*instruction = (struct mcc_tac_instruction){
+		    .op = MCC_TAC_OP_CONST,
+		    .type = instruction->type,
+		    .result = instruction->result,
+		    .arg1 = index,
+		};
+	}
+	return ok;
+}
+
+bool mcc_purity_fold_calls(struct mcc_tac_program *program, size_t fuel, size_t *folded)
+{
+	assert(program);
+
+	bool *pure = malloc((program->functions_count + 1) * sizeof(*pure));
+	if (!pure || !mcc_purity_analyse(program, pure)) {
+		free(pure);
+		return false;
+	}
+
+	struct mcc_vm vm;
+	struct mcc_vm_result result = mcc_vm_compile(&vm, program);
+	if (result.error) {
+		mcc_vm_deinit(&vm);
+		free(pure);
+		return result.error != MCC_VM_ERROR_ALLOCATION_ERROR;
+	}
+
+	struct folder folder = {
+	    .program = program,
+	    .pure = pure,
+	    .vm = &vm,
+	    .options =
+	        {
+	            .stack_size = EVALUATION_STACK_SIZE,
+	            .fuel = fuel ? fuel : MCC_PURITY_DEFAULT_FUEL,
+	        },
+	};
+
+	bool ok = true;
+	for (size_t f = 0; ok && f < program->functions_count; f++) {
+		ok = find_folds(&folder, (uint32_t)f);
+		free(folder.values);
+		free(folder.stamps);
+	}
+
+	// The VM refers to the program, which is only changed once it is gone.
+	mcc_vm_deinit(&vm);
+	free(pure);
+
+	for (size_t i = 0; ok && i < folder.folds_count; i++) {
+		ok = apply_fold(program, &folder.folds[i]);
+		if (ok && folded) {
+			(*folded)++;
+		}
+	}
+
+	free(folder.folds);
+	return ok;
+}
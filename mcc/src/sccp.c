@@ -0,0 +1,987 @@
+#include "mcc/sccp.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/cfg.h"
+
+#define NONE UINT32_MAX
+
+// Values only ever move down the lattice, from unknown to constant to
+// varying.
+enum lattice {
+	TOP = 0,
+	CONSTANT,
+	BOTTOM,
+};
+
+struct value {
+	enum lattice state;
+	uint64_t bits;
+};
+
+struct sccp {
+	struct mcc_tac_function *function;
+	const struct mcc_cfg *cfg;
+
+	// Definitions 1 up to `variables_count` stand for the zero each variable
+	// holds on entry, the others are the instructions assigning a variable,
+	// numbered in instruction order.
+	size_t definitions_count;
+	uint32_t *definition_instructions;
+	uint32_t *instruction_definitions;
+	uint32_t *instruction_blocks;
+
+	// The definitions of variable `v` are entries `variable_begin[v]` up to
+	// `variable_begin[v + 1]` of `variable_definitions`, starting with its
+	// zero.
+	uint32_t *variable_begin;
+	uint32_t *variable_definitions;
+
+	// Reaching definitions, `words` words per block.
+	size_t words;
+	uint64_t *gen, *kill, *in, *out;
+
+	// The operands whose values matter for instruction `i` are
+	// `operands_begin[i]` up to `operands_begin[i + 1]`. The definitions
+	// operand `o` may read are `chains[chains_begin[o]]` up to, but excluding,
+	// `chains[chains_begin[o + 1]]`.
+	uint32_t *operands_begin;
+	uint32_t *chains_begin;
+	size_t chains_begin_count;
+	size_t chains_begin_capacity;
+	uint32_t *chains;
+	size_t chains_count;
+	size_t chains_capacity;
+
+	// The instructions reading definition `d` are `users[users_begin[d]]` up
+	// to `users[users_begin[d + 1]]`.
+	uint32_t *users_begin;
+	uint32_t *users;
+
+	struct value *values;
+
+	// Executable blocks, and executable edges by block and successor.
+	bool *executable;
+	bool *edges;
+
+	uint32_t *blocks;
+	size_t blocks_count;
+	uint32_t *instructions;
+	size_t instructions_count;
+	bool *queued;
+};
+
+static void sccp_deinit(struct sccp *sccp)
+{
+	free(sccp->definition_instructions);
+	free(sccp->instruction_definitions);
+	free(sccp->instruction_blocks);
+	free(sccp->variable_begin);
+	free(sccp->variable_definitions);
+	free(sccp->gen);
+	free(sccp->kill);
+	free(sccp->in);
+	free(sccp->out);
+	free(sccp->operands_begin);
+	free(sccp->chains_begin);
+	free(sccp->chains);
+	free(sccp->users_begin);
+	free(sccp->users);
+	free(sccp->values);
+	free(sccp->executable);
+	free(sccp->edges);
+	free(sccp->blocks);
+	free(sccp->instructions);
+	free(sccp->queued);
+}
+
+static bool test_bit(const uint64_t *set, uint32_t bit)
+{
+	return set[bit / 64] >> (bit % 64) & 1;
+}
+
+static void set_bit(uint64_t *set, uint32_t bit)
+{
+	set[bit / 64] |= UINT64_C(1) << (bit % 64);
+}
+
+static void clear_bit(uint64_t *set, uint32_t bit)
+{
+	set[bit / 64] &= ~(UINT64_C(1) << (bit % 64));
+}
+
+// Returns the number of operands `instruction` computes its value or
+// decides its jump from.
+static uint32_t value_operands(const struct mcc_tac_instruction *instruction)
+{
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_ASSIGN:
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_NOT:
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		return 1;
+
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+		return 2;
+
+	case MCC_TAC_OP_PHI:
+		return instruction->arg2;
+
+	default:
+		return 0;
+	}
+}
+
+static uint32_t operand_variable(const struct mcc_tac_function *function,
+                                 const struct mcc_tac_instruction *instruction,
+                                 uint32_t operand)
+{
+	if (instruction->op == MCC_TAC_OP_PHI) {
+		return function->operands[instruction->arg1 + 2 * operand + 1];
+	}
+	return operand == 0 ? instruction->arg1 : instruction->arg2;
+}
+
+static uint32_t phi_predecessor(const struct sccp *sccp, const struct mcc_tac_instruction *phi, uint32_t operand)
+{
+	return sccp->cfg->label_blocks[sccp->function->operands[phi->arg1 + 2 * operand]];
+}
+
+// ------------------------------------------------------ Def-Use Chains
+
+static bool number_definitions(struct sccp *sccp)
+{
+	const struct mcc_tac_function *function = sccp->function;
+	const struct mcc_cfg *cfg = sccp->cfg;
+	size_t variables = function->variables_count + 1;
+
+	size_t count = variables;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (mcc_tac_instruction_definition(&function->instructions[i])) {
+			count++;
+		}
+	}
+
+	sccp->definitions_count = count;
+	sccp->definition_instructions = malloc(count * sizeof(*sccp->definition_instructions));
+	sccp->instruction_definitions =
+	    calloc(function->instructions_count + 1, sizeof(*sccp->instruction_definitions));
+	sccp->instruction_blocks = malloc((function->instructions_count + 1) * sizeof(*sccp->instruction_blocks));
+	sccp->variable_begin = calloc(variables + 1, sizeof(*sccp->variable_begin));
+	sccp->variable_definitions = malloc(count * sizeof(*sccp->variable_definitions));
+	if (!sccp->definition_instructions || !sccp->instruction_definitions || !sccp->instruction_blocks ||
+	    !sccp->variable_begin || !sccp->variable_definitions) {
+		return false;
+	}
+
+	for (size_t v = 0; v < variables; v++) {
+		sccp->definition_instructions[v] = NONE;
+		sccp->variable_begin[v + 1] = 1;
+	}
+	uint32_t d = (uint32_t)variables;
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		for (size_t i = cfg->blocks[b].begin; i < cfg->blocks[b].end; i++) {
+			sccp->instruction_blocks[i] = (uint32_t)b;
+			uint32_t variable = mcc_tac_instruction_definition(&function->instructions[i]);
+			if (variable) {
+				sccp->definition_instructions[d] = (uint32_t)i;
+				sccp->instruction_definitions[i] = d++;
+				sccp->variable_begin[variable + 1]++;
+			}
+		}
+	}
+
+	// Counting sort by variable, zeros first.
+	for (size_t v = 1; v <= variables; v++) {
+		sccp->variable_begin[v] += sccp->variable_begin[v - 1];
+	}
+	for (size_t v = 0; v < variables; v++) {
+		sccp->variable_definitions[sccp->variable_begin[v]++] = (uint32_t)v;
+	}
+	for (uint32_t e = (uint32_t)variables; e < count; e++) {
+		const struct mcc_tac_instruction *instruction =
+		    &function->instructions[sccp->definition_instructions[e]];
+		sccp->variable_definitions[sccp->variable_begin[mcc_tac_instruction_definition(instruction)]++] = e;
+	}
+	for (size_t v = variables; v > 0; v--) {
+		sccp->variable_begin[v] = sccp->variable_begin[v - 1];
+	}
+	sccp->variable_begin[0] = 0;
+	return true;
+}
+
+static void kill_definitions(const struct sccp *sccp, uint32_t variable, uint64_t *gen, uint64_t *kill)
+{
+	for (uint32_t k = sccp->variable_begin[variable]; k < sccp->variable_begin[variable + 1]; k++) {
+		clear_bit(gen, sccp->variable_definitions[k]);
+		set_bit(kill, sccp->variable_definitions[k]);
+	}
+}
+
+static bool compute_reaching(struct sccp *sccp)
+{
+	const struct mcc_tac_function *function = sccp->function;
+	const struct mcc_cfg *cfg = sccp->cfg;
+	size_t words = (sccp->definitions_count + 63) / 64;
+	size_t size = cfg->blocks_count * words;
+	sccp->words = words;
+	sccp->gen = calloc(size, sizeof(*sccp->gen));
+	sccp->kill = calloc(size, sizeof(*sccp->kill));
+	sccp->in = calloc(size, sizeof(*sccp->in));
+	sccp->out = calloc(size, sizeof(*sccp->out));
+	if (!sccp->gen || !sccp->kill || !sccp->in || !sccp->out) {
+		return false;
+	}
+
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		uint64_t *gen = sccp->gen + b * words;
+		uint64_t *kill = sccp->kill + b * words;
+		for (size_t i = cfg->blocks[b].begin; i < cfg->blocks[b].end; i++) {
+			uint32_t d = sccp->instruction_definitions[i];
+			if (d) {
+				kill_definitions(sccp, mcc_tac_instruction_definition(&function->instructions[i]),
+				                 gen, kill);
+				set_bit(gen, d);
+			}
+		}
+	}
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t o = 0; o < cfg->order_count; o++) {
+			uint32_t b = cfg->order[o];
+			uint64_t *in = sccp->in + b * words;
+			uint64_t *out = sccp->out + b * words;
+			const uint64_t *gen = sccp->gen + b * words;
+			const uint64_t *kill = sccp->kill + b * words;
+
+			memset(in, 0, words * sizeof(*in));
+			if (b == 0) {
+				for (uint32_t v = 1; v <= function->variables_count; v++) {
+					set_bit(in, v);
+				}
+			}
+			const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, b);
+			for (uint32_t p = 0; p < cfg->blocks[b].predecessors_count; p++) {
+				const uint64_t *predecessor_out = sccp->out + predecessors[p] * words;
+				for (size_t w = 0; w < words; w++) {
+					in[w] |= predecessor_out[w];
+				}
+			}
+
+			for (size_t w = 0; w < words; w++) {
+				uint64_t word = gen[w] | (in[w] & ~kill[w]);
+				changed |= word != out[w];
+				out[w] = word;
+			}
+		}
+	}
+	return true;
+}
+
+static bool push_chain(struct sccp *sccp, uint32_t definition)
+{
+	return mcc_array_push(sccp->chains, sccp->chains_count, sccp->chains_capacity, definition);
+}
+
+// Appends the definitions of `variable` in `set` as a chain.
+static bool push_reaching(struct sccp *sccp, const uint64_t *set, uint32_t variable)
+{
+	bool ok = true;
+	for (uint32_t k = sccp->variable_begin[variable]; ok && k < sccp->variable_begin[variable + 1]; k++) {
+		uint32_t d = sccp->variable_definitions[k];
+		if (test_bit(set, d)) {
+			ok = push_chain(sccp, d);
+		}
+	}
+	return ok;
+}
+
+// Links each operand to the definitions reaching it. Instructions of
+// unreachable blocks get no operands, they never execute.
+static bool build_chains(struct sccp *sccp)
+{
+	struct mcc_tac_function *function = sccp->function;
+	const struct mcc_cfg *cfg = sccp->cfg;
+	size_t variables = function->variables_count + 1;
+
+	// The definition of each variable made earlier in the current block, if
+	// its stamp is the block's number plus one.
+	uint32_t *local = malloc(variables * sizeof(*local));
+	uint32_t *stamps = calloc(variables, sizeof(*stamps));
+	sccp->operands_begin = malloc((function->instructions_count + 1) * sizeof(*sccp->operands_begin));
+	bool ok = local && stamps && sccp->operands_begin;
+
+	for (uint32_t b = 0; ok && b < cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		bool reachable = block->order != MCC_CFG_NONE;
+		for (size_t i = block->begin; ok && i < block->end; i++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[i];
+			sccp->operands_begin[i] = (uint32_t)sccp->chains_begin_count;
+
+			uint32_t count = reachable ? value_operands(instruction) : 0;
+			for (uint32_t o = 0; ok && o < count; o++) {
+				ok = mcc_array_push(sccp->chains_begin, sccp->chains_begin_count,
+				                    sccp->chains_begin_capacity, (uint32_t)sccp->chains_count);
+				uint32_t variable = operand_variable(function, instruction, o);
+				if (!ok) {
+					break;
+				}
+				if (instruction->op == MCC_TAC_OP_PHI) {
+					uint32_t predecessor = phi_predecessor(sccp, instruction, o);
+					ok = predecessor == MCC_CFG_NONE ||
+					     push_reaching(sccp, sccp->out + predecessor * sccp->words, variable);
+				} else if (stamps[variable] == b + 1) {
+					ok = push_chain(sccp, local[variable]);
+				} else {
+					ok = push_reaching(sccp, sccp->in + b * sccp->words, variable);
+				}
+			}
+
+			uint32_t variable = mcc_tac_instruction_definition(instruction);
+			if (variable) {
+				local[variable] = sccp->instruction_definitions[i];
+				stamps[variable] = b + 1;
+			}
+		}
+	}
+	if (ok) {
+		sccp->operands_begin[function->instructions_count] = (uint32_t)sccp->chains_begin_count;
+		ok = mcc_array_push(sccp->chains_begin, sccp->chains_begin_count, sccp->chains_begin_capacity,
+		                    (uint32_t)sccp->chains_count);
+	}
+
+	free(local);
+	free(stamps);
+	return ok;
+}
+
+static bool build_users(struct sccp *sccp)
+{
+	const struct mcc_tac_function *function = sccp->function;
+	sccp->users_begin = calloc(sccp->definitions_count + 1, sizeof(*sccp->users_begin));
+	sccp->users = malloc((sccp->chains_count ? sccp->chains_count : 1) * sizeof(*sccp->users));
+	if (!sccp->users_begin || !sccp->users) {
+		return false;
+	}
+
+	for (size_t c = 0; c < sccp->chains_count; c++) {
+		sccp->users_begin[sccp->chains[c] + 1]++;
+	}
+	for (size_t d = 1; d <= sccp->definitions_count; d++) {
+		sccp->users_begin[d] += sccp->users_begin[d - 1];
+	}
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		for (uint32_t o = sccp->operands_begin[i]; o < sccp->operands_begin[i + 1]; o++) {
+			for (uint32_t c = sccp->chains_begin[o]; c < sccp->chains_begin[o + 1]; c++) {
+				sccp->users[sccp->users_begin[sccp->chains[c]]++] = (uint32_t)i;
+			}
+		}
+	}
+	for (size_t d = sccp->definitions_count; d > 0; d--) {
+		sccp->users_begin[d] = sccp->users_begin[d - 1];
+	}
+	sccp->users_begin[0] = 0;
+	return true;
+}
+
+// ------------------------------------------------------------------ Folding
+
+static uint64_t bool_bits(bool value)
+{
+	return value ? 1 : 0;
+}
+
+static bool fold_int(enum mcc_tac_op op, int32_t a, int32_t b, uint64_t *bits)
+{
+	uint32_t result;
+	switch (op) {
+	case MCC_TAC_OP_ADD:
+		result = (uint32_t)a + (uint32_t)b;
+		break;
+	case MCC_TAC_OP_SUB:
+		result = (uint32_t)a - (uint32_t)b;
+		break;
+	case MCC_TAC_OP_MUL:
+		result = (uint32_t)a * (uint32_t)b;
+		break;
+	case MCC_TAC_OP_DIV:
+		// Dividing by zero fails at runtime, the smallest int divided by -1
+		// wraps around.
+		if (b == 0) {
+			return false;
+		}
+		result = b == -1 ? 0u - (uint32_t)a : (uint32_t)(a / b);
+		break;
+	case MCC_TAC_OP_NEG:
+		result = 0u - (uint32_t)a;
+		break;
+	case MCC_TAC_OP_EQ:
+		*bits = bool_bits(a == b);
+		return true;
+	case MCC_TAC_OP_NE:
+		*bits = bool_bits(a != b);
+		return true;
+	case MCC_TAC_OP_LT:
+		*bits = bool_bits(a < b);
+		return true;
+	case MCC_TAC_OP_LE:
+		*bits = bool_bits(a <= b);
+		return true;
+	case MCC_TAC_OP_GT:
+		*bits = bool_bits(a > b);
+		return true;
+	case MCC_TAC_OP_GE:
+		*bits = bool_bits(a >= b);
+		return true;
+	default:
+		return false;
+	}
+	*bits = mcc_tac_int_bits((int32_t)result);
+	return true;
+}
+
+static bool fold_float(enum mcc_tac_op op, float a, float b, uint64_t *bits)
+{
+	float result;
+	switch (op) {
+	case MCC_TAC_OP_ADD:
+		result = a + b;
+		break;
+	case MCC_TAC_OP_SUB:
+		result = a - b;
+		break;
+	case MCC_TAC_OP_MUL:
+		result = a * b;
+		break;
+	case MCC_TAC_OP_DIV:
+		result = a / b;
+		break;
+	case MCC_TAC_OP_NEG:
+		result = -a;
+		break;
+	case MCC_TAC_OP_EQ:
+		*bits = bool_bits(a == b);
+		return true;
+	case MCC_TAC_OP_NE:
+		*bits = bool_bits(a != b);
+		return true;
+	case MCC_TAC_OP_LT:
+		*bits = bool_bits(a < b);
+		return true;
+	case MCC_TAC_OP_LE:
+		*bits = bool_bits(a <= b);
+		return true;
+	case MCC_TAC_OP_GT:
+		*bits = bool_bits(a > b);
+		return true;
+	case MCC_TAC_OP_GE:
+		*bits = bool_bits(a >= b);
+		return true;
+	default:
+		return false;
+	}
+	*bits = mcc_tac_float_bits(result);
+	return true;
+}
+
+static bool fold_bool(enum mcc_tac_op op, bool a, bool b, uint64_t *bits)
+{
+	switch (op) {
+	case MCC_TAC_OP_AND:
+		*bits = bool_bits(a && b);
+		return true;
+	case MCC_TAC_OP_OR:
+		*bits = bool_bits(a || b);
+		return true;
+	case MCC_TAC_OP_NOT:
+		*bits = bool_bits(!a);
+		return true;
+	case MCC_TAC_OP_EQ:
+		*bits = bool_bits(a == b);
+		return true;
+	case MCC_TAC_OP_NE:
+		*bits = bool_bits(a != b);
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Evaluates `op` on operands of `type`, unary operations ignore `b`. Returns
+// false if the operation cannot be evaluated at compile time.
+static bool fold(enum mcc_tac_op op, enum mcc_tac_type type, uint64_t a, uint64_t b, uint64_t *bits)
+{
+	switch (type) {
+	case MCC_TAC_TYPE_INT:
+		return fold_int(op, (int32_t)mcc_tac_bits_int(a), (int32_t)mcc_tac_bits_int(b), bits);
+	case MCC_TAC_TYPE_FLOAT:
+		return fold_float(op, (float)mcc_tac_bits_float(a), (float)mcc_tac_bits_float(b), bits);
+	case MCC_TAC_TYPE_BOOL:
+		return fold_bool(op, a != 0, b != 0, bits);
+	default:
+		return false;
+	}
+}
+
+// ----------------------------------------------------------------- Solving
+
+static struct value meet(struct value a, struct value b)
+{
+	if (a.state == TOP) {
+		return b;
+	}
+	if (b.state == TOP) {
+		return a;
+	}
+	if (a.state == BOTTOM || b.state == BOTTOM || a.bits != b.bits) {
+		return (struct value){.state = BOTTOM};
+	}
+	return a;
+}
+
+static bool is_executable_definition(const struct sccp *sccp, uint32_t definition)
+{
+	uint32_t instruction = sccp->definition_instructions[definition];
+	return instruction == NONE || sccp->executable[sccp->instruction_blocks[instruction]];
+}
+
+static struct value operand_value(const struct sccp *sccp, size_t instruction, uint32_t operand)
+{
+	uint32_t o = sccp->operands_begin[instruction] + operand;
+	struct value value = {.state = TOP};
+	for (uint32_t c = sccp->chains_begin[o]; c < sccp->chains_begin[o + 1]; c++) {
+		if (is_executable_definition(sccp, sccp->chains[c])) {
+			value = meet(value, sccp->values[sccp->chains[c]]);
+		}
+	}
+	return value;
+}
+
+static bool is_edge_executable(const struct sccp *sccp, uint32_t from, uint32_t to)
+{
+	const struct mcc_cfg_block *block = &sccp->cfg->blocks[from];
+	for (uint32_t s = 0; s < block->successors_count; s++) {
+		if (block->successors[s] == to && sccp->edges[2 * from + s]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static struct value phi_value(const struct sccp *sccp, size_t instruction)
+{
+	const struct mcc_tac_instruction *phi = &sccp->function->instructions[instruction];
+	uint32_t block = sccp->instruction_blocks[instruction];
+
+	struct value value = {.state = TOP};
+	for (uint32_t o = 0; o < phi->arg2; o++) {
+		uint32_t predecessor = phi_predecessor(sccp, phi, o);
+		if (predecessor != MCC_CFG_NONE && is_edge_executable(sccp, predecessor, block)) {
+			value = meet(value, operand_value(sccp, instruction, o));
+		}
+	}
+	return value;
+}
+
+static struct value compute(const struct sccp *sccp, size_t instruction)
+{
+	const struct mcc_tac_instruction *current = &sccp->function->instructions[instruction];
+	enum mcc_tac_type type = current->type;
+
+	switch ((enum mcc_tac_op)current->op) {
+	case MCC_TAC_OP_CONST:
+		if (type == MCC_TAC_TYPE_INT || type == MCC_TAC_TYPE_FLOAT || type == MCC_TAC_TYPE_BOOL) {
+			return (struct value){.state = CONSTANT, .bits = sccp->function->constants[current->arg1]};
+		}
+		return (struct value){.state = BOTTOM};
+
+	case MCC_TAC_OP_ASSIGN:
+		return operand_value(sccp, instruction, 0);
+
+	case MCC_TAC_OP_PHI:
+		return phi_value(sccp, instruction);
+
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_NOT:
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+		break;
+
+	default:
+		return (struct value){.state = BOTTOM};
+	}
+
+	uint32_t count = value_operands(current);
+	struct value a = operand_value(sccp, instruction, 0);
+	struct value b = count > 1 ? operand_value(sccp, instruction, 1) : (struct value){.state = CONSTANT};
+
+	// A false operand decides a conjunction, a true one a disjunction.
+	if (current->op == MCC_TAC_OP_AND || current->op == MCC_TAC_OP_OR) {
+		uint64_t decisive = bool_bits(current->op == MCC_TAC_OP_OR);
+		if ((a.state == CONSTANT && a.bits == decisive) || (b.state == CONSTANT && b.bits == decisive)) {
+			return (struct value){.state = CONSTANT, .bits = decisive};
+		}
+	}
+
+	if (a.state == BOTTOM || b.state == BOTTOM) {
+		return (struct value){.state = BOTTOM};
+	}
+	if (a.state == TOP || b.state == TOP) {
+		return (struct value){.state = TOP};
+	}
+
+	uint64_t bits;
+	if (!fold(current->op, type, a.bits, b.bits, &bits)) {
+		return (struct value){.state = BOTTOM};
+	}
+	return (struct value){.state = CONSTANT, .bits = bits};
+}
+
+static void queue_instruction(struct sccp *sccp, uint32_t instruction)
+{
+	if (!sccp->queued[instruction]) {
+		sccp->queued[instruction] = true;
+		sccp->instructions[sccp->instructions_count++] = instruction;
+	}
+}
+
+static void mark_edge(struct sccp *sccp, uint32_t from, uint32_t to)
+{
+	const struct mcc_cfg_block *block = &sccp->cfg->blocks[from];
+	for (uint32_t s = 0; s < block->successors_count; s++) {
+		if (block->successors[s] != to || sccp->edges[2 * from + s]) {
+			continue;
+		}
+		sccp->edges[2 * from + s] = true;
+
+		if (!sccp->executable[to]) {
+			sccp->executable[to] = true;
+			sccp->blocks[sccp->blocks_count++] = to;
+			continue;
+		}
+
+		// Phis of a block already visited see another incoming value.
+		const struct mcc_cfg_block *target = &sccp->cfg->blocks[to];
+		for (size_t i = target->begin; i < target->end; i++) {
+			enum mcc_tac_op op = sccp->function->instructions[i].op;
+			if (op == MCC_TAC_OP_PHI) {
+				queue_instruction(sccp, (uint32_t)i);
+			} else if (op != MCC_TAC_OP_LABEL && op != MCC_TAC_OP_NOP) {
+				break;
+			}
+		}
+	}
+}
+
+static void mark_successors(struct sccp *sccp, uint32_t block)
+{
+	const struct mcc_cfg_block *current = &sccp->cfg->blocks[block];
+	for (uint32_t s = 0; s < current->successors_count; s++) {
+		mark_edge(sccp, block, current->successors[s]);
+	}
+}
+
+static void evaluate(struct sccp *sccp, size_t instruction)
+{
+	const struct mcc_tac_instruction *current = &sccp->function->instructions[instruction];
+	uint32_t block = sccp->instruction_blocks[instruction];
+
+	if (current->op == MCC_TAC_OP_JUMP) {
+		mark_successors(sccp, block);
+		return;
+	}
+
+	if (current->op == MCC_TAC_OP_JUMP_IF || current->op == MCC_TAC_OP_JUMP_IF_NOT) {
+		struct value condition = operand_value(sccp, instruction, 0);
+		if (condition.state == BOTTOM) {
+			mark_successors(sccp, block);
+		} else if (condition.state == CONSTANT) {
+			bool taken = (condition.bits != 0) == (current->op == MCC_TAC_OP_JUMP_IF);
+			mark_edge(sccp, block, taken ? sccp->cfg->label_blocks[current->arg2] : block + 1);
+		}
+		return;
+	}
+
+	uint32_t definition = sccp->instruction_definitions[instruction];
+	if (!definition) {
+		return;
+	}
+
+	struct value old = sccp->values[definition];
+	struct value value = meet(old, compute(sccp, instruction));
+	if (value.state == old.state && value.bits == old.bits) {
+		return;
+	}
+	sccp->values[definition] = value;
+	for (uint32_t u = sccp->users_begin[definition]; u < sccp->users_begin[definition + 1]; u++) {
+		queue_instruction(sccp, sccp->users[u]);
+	}
+}
+
+static void visit_block(struct sccp *sccp, uint32_t b)
+{
+	const struct mcc_cfg_block *block = &sccp->cfg->blocks[b];
+	enum mcc_tac_op last = MCC_TAC_OP_NOP;
+	for (size_t i = block->begin; i < block->end; i++) {
+		if (sccp->function->instructions[i].op != MCC_TAC_OP_NOP) {
+			last = sccp->function->instructions[i].op;
+			evaluate(sccp, i);
+		}
+	}
+
+	if (last != MCC_TAC_OP_JUMP && last != MCC_TAC_OP_JUMP_IF && last != MCC_TAC_OP_JUMP_IF_NOT &&
+	    last != MCC_TAC_OP_RETURN) {
+		mark_successors(sccp, b);
+	}
+}
+
+static bool solve(struct sccp *sccp)
+{
+	const struct mcc_tac_function *function = sccp->function;
+	size_t blocks = sccp->cfg->blocks_count;
+	sccp->values = calloc(sccp->definitions_count, sizeof(*sccp->values));
+	sccp->executable = calloc(blocks, sizeof(*sccp->executable));
+	sccp->edges = calloc(2 * blocks, sizeof(*sccp->edges));
+	sccp->blocks = malloc(blocks * sizeof(*sccp->blocks));
+	sccp->instructions = malloc((function->instructions_count + 1) * sizeof(*sccp->instructions));
+	sccp->queued = calloc(function->instructions_count + 1, sizeof(*sccp->queued));
+	if (!sccp->values || !sccp->executable || !sccp->edges || !sccp->blocks || !sccp->instructions ||
+	    !sccp->queued) {
+		return false;
+	}
+
+	// Variables of other types are never constant.
+	for (uint32_t v = 1; v <= function->variables_count; v++) {
+		enum mcc_tac_type type = mcc_tac_function_variable_type(function, v);
+		bool zero = type == MCC_TAC_TYPE_INT || type == MCC_TAC_TYPE_FLOAT || type == MCC_TAC_TYPE_BOOL;
+		sccp->values[v] = zero ? (struct value){.state = CONSTANT, .bits = 0} : (struct value){.state = BOTTOM};
+	}
+
+	sccp->executable[0] = true;
+	sccp->blocks[sccp->blocks_count++] = 0;
+	while (sccp->blocks_count > 0 || sccp->instructions_count > 0) {
+		if (sccp->blocks_count > 0) {
+			visit_block(sccp, sccp->blocks[--sccp->blocks_count]);
+			continue;
+		}
+
+		uint32_t instruction = sccp->instructions[--sccp->instructions_count];
+		sccp->queued[instruction] = false;
+		if (sccp->executable[sccp->instruction_blocks[instruction]]) {
+			evaluate(sccp, instruction);
+		}
+	}
+	return true;
+}
+
+// --------------------------------------------------------------- Rewriting
+
+// Whether instruction `i` is replaced by a constant. Calls keep their
+// effects, parameters stay in place.
+static bool is_replaced(const struct sccp *sccp, size_t i)
+{
+	enum mcc_tac_op op = sccp->function->instructions[i].op;
+	uint32_t definition = sccp->instruction_definitions[i];
+	return definition && sccp->executable[sccp->instruction_blocks[i]] && op != MCC_TAC_OP_CONST &&
+	       op != MCC_TAC_OP_CALL && op != MCC_TAC_OP_PARAM && sccp->values[definition].state == CONSTANT;
+}
+
+static void replace_by_constant(struct sccp *sccp, size_t i, uint32_t constant)
+{
+	struct mcc_tac_instruction *instruction = &sccp->function->instructions[i];
+	*instruction = (struct mcc_tac_instruction){
+	    .op = MCC_TAC_OP_CONST,
+	    .type = mcc_tac_function_variable_type(sccp->function, instruction->result),
+	    .result = instruction->result,
+	    .arg1 = constant,
+	};
+}
+
+// Drops the values of a phi arriving on edges that never execute. Phis
+// replaced by constants are moved behind the remaining ones.
+static void rewrite_phis(struct sccp *sccp, uint32_t b, const uint32_t *constants)
+{
+	struct mcc_tac_function *function = sccp->function;
+	const struct mcc_cfg_block *block = &sccp->cfg->blocks[b];
+
+	size_t end = block->begin;
+	while (end < block->end &&
+	       (function->instructions[end].op == MCC_TAC_OP_LABEL ||
+	        function->instructions[end].op == MCC_TAC_OP_NOP ||
+	        function->instructions[end].op == MCC_TAC_OP_PHI)) {
+		end++;
+	}
+
+	for (size_t i = block->begin; i < end; i++) {
+		struct mcc_tac_instruction *phi = &function->instructions[i];
+		if (phi->op != MCC_TAC_OP_PHI) {
+			continue;
+		}
+		if (is_replaced(sccp, i)) {
+			replace_by_constant(sccp, i, constants[i]);
+			continue;
+		}
+
+		uint32_t *pairs = &function->operands[phi->arg1];
+		uint32_t kept = 0;
+		for (uint32_t o = 0; o < phi->arg2; o++) {
+			uint32_t predecessor = phi_predecessor(sccp, phi, o);
+			if (predecessor != MCC_CFG_NONE && is_edge_executable(sccp, predecessor, b)) {
+				pairs[2 * kept] = pairs[2 * o];
+				pairs[2 * kept + 1] = pairs[2 * o + 1];
+				kept++;
+			}
+		}
+		phi->arg2 = kept;
+	}
+
+	// Insertion sort, which is stable and in place.
+	for (size_t i = block->begin; i < end; i++) {
+		struct mcc_tac_instruction phi = function->instructions[i];
+		if (phi.op != MCC_TAC_OP_PHI) {
+			continue;
+		}
+		size_t j = i;
+		while (j > block->begin && function->instructions[j - 1].op == MCC_TAC_OP_CONST) {
+			function->instructions[j] = function->instructions[j - 1];
+			j--;
+		}
+		function->instructions[j] = phi;
+	}
+}
+
+// Returns whether `target` follows `block` once unreachable blocks are
+// removed.
+static bool falls_through(const struct sccp *sccp, uint32_t block, uint32_t target)
+{
+	if (target <= block) {
+		return false;
+	}
+	for (uint32_t b = block + 1; b < target; b++) {
+		if (sccp->executable[b]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void rewrite_block(struct sccp *sccp, uint32_t b, const uint32_t *constants, struct mcc_sccp_stats *stats)
+{
+	struct mcc_tac_function *function = sccp->function;
+	const struct mcc_cfg_block *block = &sccp->cfg->blocks[b];
+
+	for (size_t i = block->begin; i < block->end; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		enum mcc_tac_op op = instruction->op;
+
+		if (op == MCC_TAC_OP_JUMP_IF || op == MCC_TAC_OP_JUMP_IF_NOT) {
+			struct value condition = operand_value(sccp, i, 0);
+			if (condition.state != CONSTANT) {
+				continue;
+			}
+			bool taken = (condition.bits != 0) == (op == MCC_TAC_OP_JUMP_IF);
+			if (taken && !falls_through(sccp, b, sccp->cfg->label_blocks[instruction->arg2])) {
+				*instruction =
+				    (struct mcc_tac_instruction){.op = MCC_TAC_OP_JUMP, .arg2 = instruction->arg2};
+			} else {
+				mcc_tac_function_remove(function, i);
+			}
+			stats->branches++;
+		} else if (op != MCC_TAC_OP_PHI && is_replaced(sccp, i)) {
+			replace_by_constant(sccp, i, constants[i]);
+		}
+	}
+}
+
+static bool rewrite(struct sccp *sccp, struct mcc_sccp_stats *stats)
+{
+	struct mcc_tac_function *function = sccp->function;
+	const struct mcc_cfg *cfg = sccp->cfg;
+
+	// Constants are added up front, so the function stays unchanged if that
+	// fails.
+	uint32_t *constants = malloc((function->instructions_count + 1) * sizeof(*constants));
+	bool ok = constants;
+	for (size_t i = 0; ok && i < function->instructions_count; i++) {
+		if (is_replaced(sccp, i)) {
+			uint64_t bits = sccp->values[sccp->instruction_definitions[i]].bits;
+			ok = mcc_tac_function_add_constant(function, bits, &constants[i]);
+			stats->constants++;
+		}
+	}
+	if (!ok) {
+		free(constants);
+		return false;
+	}
+
+	for (uint32_t b = 0; b < cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		if (sccp->executable[b]) {
+			rewrite_block(sccp, b, constants, stats);
+			rewrite_phis(sccp, b, constants);
+			continue;
+		}
+
+		bool removed = false;
+		for (size_t i = block->begin; i < block->end; i++) {
+			if (function->instructions[i].op != MCC_TAC_OP_NOP) {
+				mcc_tac_function_remove(function, i);
+				removed = true;
+			}
+		}
+		if (removed) {
+			stats->unreachable++;
+		}
+	}
+
+	free(constants);
+	return true;
+}
+
+bool mcc_sccp_function(struct mcc_tac_function *function, struct mcc_sccp_stats *stats)
+{
+	assert(function);
+
+	struct mcc_cfg cfg;
+	struct sccp sccp = {.function = function, .cfg = &cfg};
+	struct mcc_sccp_stats counts = {0};
+	bool ok = mcc_cfg_build(&cfg, function) && number_definitions(&sccp) && compute_reaching(&sccp) &&
+	          build_chains(&sccp) && build_users(&sccp) && solve(&sccp) && rewrite(&sccp, &counts);
+	sccp_deinit(&sccp);
+	mcc_cfg_deinit(&cfg);
+
+	if (ok && stats) {
+		stats->constants += counts.constants;
+		stats->branches += counts.branches;
+		stats->unreachable += counts.unreachable;
+	}
+	return ok;
+}
@@ -0,0 +1,1034 @@
+#include "mcc/semantic.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/ast_print.h"
+#include "mcc/ast_visit.h"
+#include "mcc/symbol_table.h"
+#include "parallel.h"
+
+// Large enough for any type's spelling.
+#define TYPE_STRING_SIZE 32
+
+// Checking happens in two phases. First, the global phase declares all
+// functions in the global symbol table. Afterwards, function bodies are
+// checked independently, each using its worker's symbol table for local
+// scopes and falling back to the then read-only global table.
+struct checker {
+	struct mcc_ast_program *program;
+	bool collect_all;
+
+	struct mcc_symbol_table *symbols;
+
+	// NULL during the global phase.
+	const struct mcc_symbol_table *globals;
+
+	// The function currently being checked.
+	struct mcc_ast_function *function;
+
+	struct mcc_semantic_result *result;
+
+	// Set once checking must not continue.
+	bool stop;
+};
+
+// ------------------------------------------------------------ Error Handling
+
+static void allocation_error(struct checker *checker)
+{
+	assert(checker);
+
+	checker->result->error = MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+	checker->stop = true;
+}
+
+// Diagnostics are kept in source order; they are only out of order for
+// whole-program checks, so the insertion below is cheap.
+static void error(struct checker *checker, struct mcc_sloc sloc, const char *format, ...)
+{
+	assert(checker);
+	assert(format);
+
+	if (checker->stop) {
+		return;
+	}
+
+	struct mcc_semantic_diagnostic diagnostic = {.sloc = sloc};
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(diagnostic.message, sizeof(diagnostic.message), format, args);
+	va_end(args);
+
+	struct mcc_semantic_result *result = checker->result;
+	if (!mcc_array_push(result->diagnostics, result->diagnostics_count, result->diagnostics_capacity, diagnostic)) {
+		allocation_error(checker);
+		return;
+	}
+
+	for (size_t i = result->diagnostics_count - 1; i > 0; i--) {
+		struct mcc_sloc previous = result->diagnostics[i - 1].sloc;
+		if (previous.line < sloc.line || (previous.line == sloc.line && previous.column <= sloc.column)) {
+			break;
+		}
+		result->diagnostics[i] = result->diagnostics[i - 1];
+		result->diagnostics[i - 1] = diagnostic;
+	}
+
+	result->error = MCC_SEMANTIC_ERROR_CHECK_FAILED;
+	if (!checker->collect_all) {
+		checker->stop = true;
+	}
+}
+
+// -------------------------------------------------------------------- Types
+
+static const struct mcc_type *type_from_data_type(enum mcc_ast_data_type data_type)
+{
+	switch (data_type) {
+	case MCC_AST_DATA_TYPE_VOID:
+		return mcc_type_scalar(MCC_TYPE_KIND_VOID);
+	case MCC_AST_DATA_TYPE_BOOL:
+		return mcc_type_scalar(MCC_TYPE_KIND_BOOL);
+	case MCC_AST_DATA_TYPE_INT:
+		return mcc_type_scalar(MCC_TYPE_KIND_INT);
+	case MCC_AST_DATA_TYPE_FLOAT:
+		return mcc_type_scalar(MCC_TYPE_KIND_FLOAT);
+	case MCC_AST_DATA_TYPE_STRING:
+		return mcc_type_scalar(MCC_TYPE_KIND_STRING);
+	}
+
+	assert(false);
+	return mcc_type_scalar(MCC_TYPE_KIND_VOID);
+}
+
+// Sets the declaration's `resolved_type`, returns false on allocation failure.
+static bool resolve_declaration_type(struct checker *checker, struct mcc_ast_declaration *declaration)
+{
+	assert(checker);
+	assert(declaration);
+
+	if (declaration->resolved_type) {
+		return true;
+	}
+
+	const struct mcc_type *type = type_from_data_type(declaration->data_type);
+	if (declaration->is_array) {
+		type = mcc_type_pool_array(&checker->program->types, type, declaration->array_size);
+		if (!type) {
+			allocation_error(checker);
+			return false;
+		}
+	}
+
+	declaration->resolved_type = type;
+	return true;
+}
+
+static bool is_numeric(const struct mcc_type *type)
+{
+	return type->kind == MCC_TYPE_KIND_INT || type->kind == MCC_TYPE_KIND_FLOAT;
+}
+
+// ----------------------------------------------------------------- Builtins
+
+static const struct builtin {
+	const char *name;
+	enum mcc_ast_data_type return_type;
+
+	// Built-ins take at most one parameter.
+	bool has_parameter;
+	enum mcc_ast_data_type parameter_type;
+} builtins[] = {
+    {"print", MCC_AST_DATA_TYPE_VOID, true, MCC_AST_DATA_TYPE_STRING},
+    {"print_nl", MCC_AST_DATA_TYPE_VOID, false, MCC_AST_DATA_TYPE_VOID},
+    {"print_int", MCC_AST_DATA_TYPE_VOID, true, MCC_AST_DATA_TYPE_INT},
+    {"print_float", MCC_AST_DATA_TYPE_VOID, true, MCC_AST_DATA_TYPE_FLOAT},
+    {"read_int", MCC_AST_DATA_TYPE_INT, false, MCC_AST_DATA_TYPE_VOID},
+    {"read_float", MCC_AST_DATA_TYPE_FLOAT, false, MCC_AST_DATA_TYPE_VOID},
+};
+
+static struct mcc_ast_identifier *new_identifier(struct mcc_ast_program *program, const char *name)
+{
+	const char *interned = mcc_string_pool_intern(&program->strings, name, strlen(name));
+	if (!interned) {
+		return NULL;
+	}
+	return mcc_ast_new_identifier(interned);
+}
+
+static struct mcc_ast_function *new_builtin(struct mcc_ast_program *program, const struct builtin *builtin)
+{
+	assert(program);
+	assert(builtin);
+
+	struct mcc_ast_identifier *identifier = new_identifier(program, builtin->name);
+	if (!identifier) {
+		return NULL;
+	}
+
+	struct mcc_ast_function *function = mcc_ast_new_function(builtin->return_type, identifier);
+	if (!function) {
+		mcc_ast_delete_identifier(identifier);
+		return NULL;
+	}
+
+	if (builtin->has_parameter) {
+		struct mcc_ast_identifier *parameter_identifier = new_identifier(program, "value");
+		if (!parameter_identifier) {
+			mcc_ast_delete_function(function);
+			return NULL;
+		}
+
+		struct mcc_ast_declaration *parameter =
+		    mcc_ast_new_declaration(builtin->parameter_type, parameter_identifier);
+		if (!parameter) {
+			mcc_ast_delete_identifier(parameter_identifier);
+			mcc_ast_delete_function(function);
+			return NULL;
+		}
+		parameter_identifier->declaration = parameter;
+
+		if (!mcc_ast_add_parameter(function, parameter)) {
+			mcc_ast_delete_declaration(parameter);
+			mcc_ast_delete_function(function);
+			return NULL;
+		}
+	}
+
+	return function;
+}
+
+// Built-in declarations are added once, checking a program again reuses them.
+static void add_builtins(struct checker *checker)
+{
+	assert(checker);
+
+	struct mcc_ast_program *program = checker->program;
+	if (program->builtins_count > 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+		struct mcc_ast_function *function = new_builtin(program, &builtins[i]);
+		if (!function) {
+			allocation_error(checker);
+			return;
+		}
+
+		if (!mcc_ast_add_builtin(program, function)) {
+			mcc_ast_delete_function(function);
+			allocation_error(checker);
+			return;
+		}
+	}
+}
+
+// ------------------------------------------------------------- Declarations
+
+static void declare_function(struct checker *checker, struct mcc_ast_function *function)
+{
+	assert(checker);
+	assert(function);
+
+	// Parameter types are needed for checking calls before the function's
+	// body is visited.
+	for (size_t i = 0; i < function->parameters_count; i++) {
+		if (!resolve_declaration_type(checker, function->parameters[i])) {
+			return;
+		}
+	}
+
+	struct mcc_symbol symbol = {
+	    .name = function->identifier->name,
+	    .kind = MCC_SYMBOL_KIND_FUNCTION,
+	    .function = function,
+	};
+
+	switch (mcc_symbol_table_declare(checker->symbols, symbol)) {
+	case MCC_SYMBOL_TABLE_ERROR_NONE:
+		function->identifier->function = function;
+		break;
+	case MCC_SYMBOL_TABLE_ERROR_REDECLARATION:
+		error(checker, function->identifier->node.sloc, "redefinition of function '%s'", symbol.name);
+		break;
+	case MCC_SYMBOL_TABLE_ERROR_ALLOCATION_ERROR:
+		allocation_error(checker);
+		break;
+	}
+}
+
+static void declare_variable(struct checker *checker, struct mcc_ast_declaration *declaration)
+{
+	assert(checker);
+	assert(declaration);
+
+	struct mcc_ast_identifier *identifier = declaration->identifier;
+
+	if (declaration->is_array && declaration->array_size <= 0) {
+		error(checker, identifier->node.sloc, "size of array '%s' must be positive", identifier->name);
+		return;
+	}
+
+	if (!resolve_declaration_type(checker, declaration)) {
+		return;
+	}
+
+	struct mcc_symbol symbol = {
+	    .name = identifier->name,
+	    .kind = MCC_SYMBOL_KIND_VARIABLE,
+	    .declaration = declaration,
+	};
+
+	switch (mcc_symbol_table_declare(checker->symbols, symbol)) {
+	case MCC_SYMBOL_TABLE_ERROR_NONE:
+		identifier->declaration = declaration;
+		break;
+	case MCC_SYMBOL_TABLE_ERROR_REDECLARATION:
+		error(checker, identifier->node.sloc, "redeclaration of '%s'", identifier->name);
+		break;
+	case MCC_SYMBOL_TABLE_ERROR_ALLOCATION_ERROR:
+		allocation_error(checker);
+		break;
+	}
+}
+
+static const struct mcc_symbol *lookup(struct checker *checker, const char *name)
+{
+	assert(checker);
+	assert(name);
+
+	const struct mcc_symbol *symbol = mcc_symbol_table_lookup(checker->symbols, name);
+	if (!symbol && checker->globals) {
+		symbol = mcc_symbol_table_lookup(checker->globals, name);
+	}
+	return symbol;
+}
+
+// Resolves a variable use, returns NULL on error.
+static struct mcc_ast_declaration *resolve_variable(struct checker *checker, struct mcc_ast_identifier *identifier)
+{
+	assert(checker);
+	assert(identifier);
+
+	const struct mcc_symbol *symbol = lookup(checker, identifier->name);
+	if (!symbol) {
+		error(checker, identifier->node.sloc, "use of undeclared identifier '%s'", identifier->name);
+		return NULL;
+	}
+	if (symbol->kind != MCC_SYMBOL_KIND_VARIABLE) {
+		error(checker, identifier->node.sloc, "function '%s' used as variable", identifier->name);
+		return NULL;
+	}
+
+	identifier->declaration = symbol->declaration;
+	return symbol->declaration;
+}
+
+// -------------------------------------------------------------- Expressions
+
+static bool check_expression(struct checker *checker, struct mcc_ast_expression *expression);
+
+// Checks `expression` and that it is an `int`, as required for indices.
+static bool check_index(struct checker *checker, struct mcc_ast_expression *index)
+{
+	if (!check_expression(checker, index)) {
+		return false;
+	}
+
+	if (index->data_type->kind != MCC_TYPE_KIND_INT) {
+		char type[TYPE_STRING_SIZE];
+		error(checker, index->node.sloc, "array subscript of type '%s', expected 'int'",
+		      mcc_type_to_string(index->data_type, type, sizeof(type)));
+		return false;
+	}
+	return true;
+}
+
+static bool check_expression_literal(struct checker *checker, struct mcc_ast_expression *expression)
+{
+	(void)checker;
+
+	switch (expression->literal->type) {
+	case MCC_AST_LITERAL_TYPE_INT:
+		expression->data_type = mcc_type_scalar(MCC_TYPE_KIND_INT);
+		break;
+	case MCC_AST_LITERAL_TYPE_FLOAT:
+		expression->data_type = mcc_type_scalar(MCC_TYPE_KIND_FLOAT);
+		break;
+	case MCC_AST_LITERAL_TYPE_BOOL:
+		expression->data_type = mcc_type_scalar(MCC_TYPE_KIND_BOOL);
+		break;
+	case MCC_AST_LITERAL_TYPE_STRING:
+		expression->data_type = mcc_type_scalar(MCC_TYPE_KIND_STRING);
+		break;
+	}
+	return true;
+}
+
+static bool check_expression_binary_op(struct checker *checker, struct mcc_ast_expression *expression)
+{
+	// Both sides are checked to report independent errors.
+	bool lhs_ok = check_expression(checker, expression->lhs);
+	bool rhs_ok = check_expression(checker, expression->rhs);
+	if (!lhs_ok || !rhs_ok) {
+		return false;
+	}
+
+	const struct mcc_type *lhs = expression->lhs->data_type;
+	const struct mcc_type *rhs = expression->rhs->data_type;
+
+	bool supported = false;
+	bool yields_bool = true;
+	switch (expression->op) {
+	case MCC_AST_BINARY_OP_ADD:
+	case MCC_AST_BINARY_OP_SUB:
+	case MCC_AST_BINARY_OP_MUL:
+	case MCC_AST_BINARY_OP_DIV:
+		supported = is_numeric(lhs);
+		yields_bool = false;
+		break;
+	case MCC_AST_BINARY_OP_LT:
+	case MCC_AST_BINARY_OP_GT:
+	case MCC_AST_BINARY_OP_LE:
+	case MCC_AST_BINARY_OP_GE:
+		supported = is_numeric(lhs);
+		break;
+	case MCC_AST_BINARY_OP_EQ:
+	case MCC_AST_BINARY_OP_NE:
+		supported = is_numeric(lhs) || lhs->kind == MCC_TYPE_KIND_BOOL;
+		break;
+	case MCC_AST_BINARY_OP_AND:
+	case MCC_AST_BINARY_OP_OR:
+		supported = lhs->kind == MCC_TYPE_KIND_BOOL;
+		break;
+	}
+
+	if (!supported || lhs != rhs) {
+		char lhs_type[TYPE_STRING_SIZE];
+		char rhs_type[TYPE_STRING_SIZE];
+		error(checker, expression->node.sloc, "invalid operands to binary '%s' (have '%s' and '%s')",
+		      mcc_ast_print_binary_op(expression->op), mcc_type_to_string(lhs, lhs_type, sizeof(lhs_type)),
+		      mcc_type_to_string(rhs, rhs_type, sizeof(rhs_type)));
+		return false;
+	}
+
+	expression->data_type = yields_bool ? mcc_type_scalar(MCC_TYPE_KIND_BOOL) : lhs;
+	return true;
+}
+
+static bool check_expression_unary_op(struct checker *checker, struct mcc_ast_expression *expression)
+{
+	if (!check_expression(checker, expression->operand)) {
+		return false;
+	}
+
+	const struct mcc_type *operand = expression->operand->data_type;
+
+	bool supported = false;
+	switch (expression->unary_op) {
+	case MCC_AST_UNARY_OP_NEG:
+		supported = is_numeric(operand);
+		break;
+	case MCC_AST_UNARY_OP_NOT:
+		supported = operand->kind == MCC_TYPE_KIND_BOOL;
+		break;
+	}
+
+	if (!supported) {
+		char type[TYPE_STRING_SIZE];
+		error(checker, expression->node.sloc, "invalid argument type '%s' to unary '%s'",
+		      mcc_type_to_string(operand, type, sizeof(type)), mcc_ast_print_unary_op(expression->unary_op));
+		return false;
+	}
+
+	expression->data_type = operand;
+	return true;
+}
+
+static bool check_expression_array_element(struct checker *checker, struct mcc_ast_expression *expression)
+{
+	struct mcc_ast_declaration *declaration = resolve_variable(checker, expression->array);
+	bool index_ok = check_index(checker, expression->index);
+	if (!declaration || !index_ok) {
+		return false;
+	}
+
+	if (!declaration->is_array) {
+		error(checker, expression->node.sloc, "subscripted value '%s' is not an array",
+		      expression->array->name);
+		return false;
+	}
+
+	expression->data_type = declaration->resolved_type->element;
+	return true;
+}
+
+static bool check_expression_call(struct checker *checker, struct mcc_ast_expression *expression)
+{
+	struct mcc_ast_identifier *callee = expression->callee;
+
+	bool ok = true;
+	for (size_t i = 0; i < expression->arguments_count; i++) {
+		ok = check_expression(checker, expression->arguments[i]) && ok;
+	}
+
+	const struct mcc_symbol *symbol = lookup(checker, callee->name);
+	if (!symbol) {
+		error(checker, callee->node.sloc, "call to undeclared function '%s'", callee->name);
+		return false;
+	}
+	if (symbol->kind != MCC_SYMBOL_KIND_FUNCTION) {
+		error(checker, callee->node.sloc, "called object '%s' is not a function", callee->name);
+		return false;
+	}
+
+	struct mcc_ast_function *function = symbol->function;
+	callee->function = function;
+
+	if (expression->arguments_count != function->parameters_count) {
+		error(checker, callee->node.sloc, "too %s arguments to function '%s', expected %zu, have %zu",
+		      expression->arguments_count < function->parameters_count ? "few" : "many", callee->name,
+		      function->parameters_count, expression->arguments_count);
+		return false;
+	}
+
+	if (!ok) {
+		return false;
+	}
+
+	for (size_t i = 0; i < expression->arguments_count; i++) {
+		struct mcc_ast_expression *argument = expression->arguments[i];
+		const struct mcc_type *parameter = function->parameters[i]->resolved_type;
+		if (argument->data_type != parameter) {
+			char argument_type[TYPE_STRING_SIZE];
+			char parameter_type[TYPE_STRING_SIZE];
+			error(checker, argument->node.sloc, "passing '%s' to parameter of incompatible type '%s'",
+			      mcc_type_to_string(argument->data_type, argument_type, sizeof(argument_type)),
+			      mcc_type_to_string(parameter, parameter_type, sizeof(parameter_type)));
+			ok = false;
+		}
+	}
+
+	expression->data_type = type_from_data_type(function->return_type);
+	return ok;
+}
+
+static bool check_expression(struct checker *checker, struct mcc_ast_expression *expression)
+{
+	assert(checker);
+	assert(expression);
+
+	if (checker->stop) {
+		return false;
+	}
+
+	switch (expression->type) {
+	case MCC_AST_EXPRESSION_TYPE_LITERAL:
+		return check_expression_literal(checker, expression);
+
+	case MCC_AST_EXPRESSION_TYPE_BINARY_OP:
+		return check_expression_binary_op(checker, expression);
+
+	case MCC_AST_EXPRESSION_TYPE_PARENTH:
+		if (!check_expression(checker, expression->expression)) {
+			return false;
+		}
+		expression->data_type = expression->expression->data_type;
+		return true;
+
+	case MCC_AST_EXPRESSION_TYPE_UNARY_OP:
+		return check_expression_unary_op(checker, expression);
+
+	case MCC_AST_EXPRESSION_TYPE_IDENTIFIER: {
+		struct mcc_ast_declaration *declaration = resolve_variable(checker, expression->identifier);
+		if (!declaration) {
+			return false;
+		}
+		expression->data_type = declaration->resolved_type;
+		return true;
+	}
+
+	case MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT:
+		return check_expression_array_element(checker, expression);
+
+	case MCC_AST_EXPRESSION_TYPE_CALL:
+		return check_expression_call(checker, expression);
+	}
+
+	return false;
+}
+
+// --------------------------------------------------------------- Statements
+
+static void check_statement(struct checker *checker, struct mcc_ast_statement *statement);
+
+static void check_condition(struct checker *checker, struct mcc_ast_expression *condition)
+{
+	if (!check_expression(checker, condition)) {
+		return;
+	}
+
+	if (condition->data_type->kind != MCC_TYPE_KIND_BOOL) {
+		char type[TYPE_STRING_SIZE];
+		error(checker, condition->node.sloc, "condition of type '%s', expected 'bool'",
+		      mcc_type_to_string(condition->data_type, type, sizeof(type)));
+	}
+}
+
+// Branches and loop bodies form a scope of their own, even if they are not a
+// compound statement.
+static void check_substatement(struct checker *checker, struct mcc_ast_statement *statement)
+{
+	if (statement->type == MCC_AST_STATEMENT_TYPE_COMPOUND) {
+		check_statement(checker, statement);
+		return;
+	}
+
+	if (!mcc_symbol_table_enter_scope(checker->symbols)) {
+		allocation_error(checker);
+		return;
+	}
+	check_statement(checker, statement);
+	mcc_symbol_table_exit_scope(checker->symbols);
+}
+
+static void check_statement_return(struct checker *checker, struct mcc_ast_statement *statement)
+{
+	struct mcc_ast_function *function = checker->function;
+	const char *name = function->identifier->name;
+	struct mcc_ast_expression *value = statement->return_value;
+
+	if (function->return_type == MCC_AST_DATA_TYPE_VOID) {
+		if (value) {
+			error(checker, statement->node.sloc, "void function '%s' should not return a value", name);
+		}
+		return;
+	}
+
+	if (!value) {
+		error(checker, statement->node.sloc, "non-void function '%s' should return a value", name);
+		return;
+	}
+
+	if (!check_expression(checker, value)) {
+		return;
+	}
+
+	const struct mcc_type *return_type = type_from_data_type(function->return_type);
+	if (value->data_type != return_type) {
+		char value_type[TYPE_STRING_SIZE];
+		char expected_type[TYPE_STRING_SIZE];
+		error(checker, value->node.sloc, "returning '%s' from function '%s' with return type '%s'",
+		      mcc_type_to_string(value->data_type, value_type, sizeof(value_type)), name,
+		      mcc_type_to_string(return_type, expected_type, sizeof(expected_type)));
+	}
+}
+
+static void check_assignment(struct checker *checker, struct mcc_ast_assignment *assignment)
+{
+	struct mcc_ast_identifier *identifier = assignment->identifier;
+
+	struct mcc_ast_declaration *declaration = resolve_variable(checker, identifier);
+	bool index_ok = !assignment->index || check_index(checker, assignment->index);
+	bool rhs_ok = check_expression(checker, assignment->rhs);
+	if (!declaration || !index_ok || !rhs_ok) {
+		return;
+	}
+
+	const struct mcc_type *target = declaration->resolved_type;
+	if (assignment->index) {
+		if (!declaration->is_array) {
+			error(checker, identifier->node.sloc, "subscripted value '%s' is not an array",
+			      identifier->name);
+			return;
+		}
+		target = target->element;
+	} else if (declaration->is_array) {
+		error(checker, identifier->node.sloc, "cannot assign to array '%s'", identifier->name);
+		return;
+	}
+
+	if (target != assignment->rhs->data_type) {
+		char target_type[TYPE_STRING_SIZE];
+		char rhs_type[TYPE_STRING_SIZE];
+		error(checker, assignment->rhs->node.sloc, "assigning to '%s' from incompatible type '%s'",
+		      mcc_type_to_string(target, target_type, sizeof(target_type)),
+		      mcc_type_to_string(assignment->rhs->data_type, rhs_type, sizeof(rhs_type)));
+	}
+}
+
+static void check_statements(struct checker *checker, struct mcc_ast_statement *compound)
+{
+	for (size_t i = 0; i < compound->statements_count && !checker->stop; i++) {
+		check_statement(checker, compound->statements[i]);
+	}
+}
+
+static void check_statement(struct checker *checker, struct mcc_ast_statement *statement)
+{
+	assert(checker);
+	assert(statement);
+
+	if (checker->stop) {
+		return;
+	}
+
+	switch (statement->type) {
+	case MCC_AST_STATEMENT_TYPE_IF:
+		check_condition(checker, statement->if_condition);
+		check_substatement(checker, statement->if_on_true);
+		if (statement->if_on_false) {
+			check_substatement(checker, statement->if_on_false);
+		}
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_WHILE:
+		check_condition(checker, statement->while_condition);
+		check_substatement(checker, statement->while_body);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_RETURN:
+		check_statement_return(checker, statement);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_DECLARATION:
+		declare_variable(checker, statement->declaration);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_ASSIGNMENT:
+		check_assignment(checker, statement->assignment);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_EXPRESSION:
+		check_expression(checker, statement->expression);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_COMPOUND:
+		if (!mcc_symbol_table_enter_scope(checker->symbols)) {
+			allocation_error(checker);
+			return;
+		}
+		check_statements(checker, statement);
+		mcc_symbol_table_exit_scope(checker->symbols);
+		break;
+	}
+}
+
+// ---------------------------------------------------------------- Functions
+
+// Whether all execution paths through `statement` end in a return. Loops are
+// not considered, we assume there is no dead code.
+static bool always_returns(const struct mcc_ast_statement *statement)
+{
+	switch (statement->type) {
+	case MCC_AST_STATEMENT_TYPE_RETURN:
+		return true;
+
+	case MCC_AST_STATEMENT_TYPE_IF:
+		return statement->if_on_false && always_returns(statement->if_on_true) &&
+		       always_returns(statement->if_on_false);
+
+	case MCC_AST_STATEMENT_TYPE_COMPOUND:
+		for (size_t i = 0; i < statement->statements_count; i++) {
+			if (always_returns(statement->statements[i])) {
+				return true;
+			}
+		}
+		return false;
+
+	default:
+		return false;
+	}
+}
+
+static void check_function(struct checker *checker, struct mcc_ast_function *function)
+{
+	assert(checker);
+	assert(function);
+
+	checker->function = function;
+
+	// Parameters share their scope with the function's body.
+	if (!mcc_symbol_table_enter_scope(checker->symbols)) {
+		allocation_error(checker);
+		return;
+	}
+
+	for (size_t i = 0; i < function->parameters_count && !checker->stop; i++) {
+		declare_variable(checker, function->parameters[i]);
+	}
+	check_statements(checker, function->body);
+
+	mcc_symbol_table_exit_scope(checker->symbols);
+
+	if (function->return_type != MCC_AST_DATA_TYPE_VOID && !always_returns(function->body)) {
+		error(checker, function->identifier->node.sloc,
+		      "non-void function '%s' does not return a value on all paths", function->identifier->name);
+	}
+}
+
+static void check_main(struct checker *checker)
+{
+	assert(checker);
+
+	const char *name = mcc_string_pool_intern(&checker->program->strings, "main", 4);
+	if (!name) {
+		allocation_error(checker);
+		return;
+	}
+
+	const struct mcc_symbol *symbol = lookup(checker, name);
+	if (!symbol) {
+		error(checker, checker->program->node.sloc, "missing 'main' function");
+		return;
+	}
+
+	struct mcc_ast_function *main = symbol->function;
+	if (main->return_type != MCC_AST_DATA_TYPE_INT || main->parameters_count != 0) {
+		error(checker, main->identifier->node.sloc, "'main' must return 'int' and take no parameters");
+	}
+}
+
+// ------------------------------------------------------------ Global Phase
+
+static void resolve_declaration(struct mcc_ast_declaration *declaration, void *data)
+{
+	// Invalid sizes are reported when the declaration is checked.
+	if (!declaration->is_array || declaration->array_size > 0) {
+		resolve_declaration_type(data, declaration);
+	}
+}
+
+static void check_globals(struct checker *checker)
+{
+	assert(checker);
+
+	struct mcc_ast_program *program = checker->program;
+
+	add_builtins(checker);
+
+	// Functions can be called before their definition, hence all of them are
+	// declared upfront. This goes on after an error: function bodies are
+	// checked regardless and would report calls of the remaining functions.
+	bool failed = false;
+	for (size_t i = 0; i < program->builtins_count && !failed; i++) {
+		declare_function(checker, program->builtins[i]);
+		failed = checker->result->error == MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+	}
+	for (size_t i = 0; i < program->functions_count && !failed; i++) {
+		declare_function(checker, program->functions[i]);
+		failed = checker->result->error == MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+	}
+
+	if (!checker->stop) {
+		check_main(checker);
+	}
+
+	// Array types are interned upfront, the type pool is not touched while
+	// function bodies are checked in parallel. This happens even after an
+	// error since function bodies are checked regardless.
+	struct mcc_ast_visitor visitor = {
+	    .traversal = MCC_AST_VISIT_DEPTH_FIRST,
+	    .order = MCC_AST_VISIT_PRE_ORDER,
+	    .userdata = checker,
+	    .declaration = resolve_declaration,
+	};
+	for (size_t i = 0; i < program->functions_count; i++) {
+		mcc_ast_visit_function(program->functions[i], &visitor);
+	}
+}
+
+// ---------------------------------------------------------- Function Phase
+
+struct function_phase {
+	struct mcc_ast_program *program;
+	bool collect_all;
+
+	const struct mcc_symbol_table *globals;
+
+	// One symbol table per worker, reused for all functions it checks.
+	struct mcc_symbol_table *workers;
+
+	// One result per function.
+	struct mcc_semantic_result *results;
+};
+
+static void check_function_task(size_t task, size_t worker, void *data)
+{
+	struct function_phase *phase = data;
+
+	struct checker checker = {
+	    .program = phase->program,
+	    .collect_all = phase->collect_all,
+	    .symbols = &phase->workers[worker],
+	    .globals = phase->globals,
+	    .result = &phase->results[task],
+	};
+	check_function(&checker, phase->program->functions[task]);
+
+	// Scopes left open due to an allocation failure are discarded.
+	while (mcc_symbol_table_scope(checker.symbols) > 0) {
+		mcc_symbol_table_exit_scope(checker.symbols);
+	}
+}
+
+// ------------------------------------------------------------------ Merging
+
+// Merges the diagnostics of all phases into `result` in source order. The
+// per-function lists are in source order and so are the functions, hence
+// their concatenation only needs to be merged with the global list.
+static void merge_results(struct mcc_semantic_result *result,
+                          struct mcc_semantic_result *globals,
+                          const struct mcc_semantic_result *functions,
+                          size_t functions_count,
+                          bool collect_all)
+{
+	size_t total = globals->diagnostics_count;
+	bool allocation_failed = globals->error == MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+	for (size_t i = 0; i < functions_count; i++) {
+		total += functions[i].diagnostics_count;
+		allocation_failed |= functions[i].error == MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+	}
+
+	*result = (struct mcc_semantic_result){0};
+	if (total > 0) {
+		result->diagnostics = malloc(total * sizeof(*result->diagnostics));
+		if (!result->diagnostics) {
+			result->error = MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+			return;
+		}
+		result->diagnostics_capacity = total;
+	}
+
+	const struct mcc_semantic_diagnostic *global = globals->diagnostics;
+	const struct mcc_semantic_diagnostic *global_end = global + globals->diagnostics_count;
+
+	for (size_t i = 0; i < functions_count; i++) {
+		const struct mcc_semantic_diagnostic *local = functions[i].diagnostics;
+		const struct mcc_semantic_diagnostic *local_end = local + functions[i].diagnostics_count;
+
+		while (local != local_end) {
+			bool take_global = global != global_end &&
+			                   (global->sloc.line < local->sloc.line ||
+			                    (global->sloc.line == local->sloc.line &&
+			                     global->sloc.column <= local->sloc.column));
+			result->diagnostics[result->diagnostics_count++] = take_global ? *global++ : *local++;
+		}
+	}
+	while (global != global_end) {
+		result->diagnostics[result->diagnostics_count++] = *global++;
+	}
+
+	// Each phase stopped on its first error, only the overall first one is
+	// reported.
+	if (!collect_all && result->diagnostics_count > 1) {
+		result->diagnostics_count = 1;
+	}
+
+	if (allocation_failed) {
+		result->error = MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+	} else if (result->diagnostics_count > 0) {
+		result->error = MCC_SEMANTIC_ERROR_CHECK_FAILED;
+	}
+}
+
+// ---------------------------------------------------------------- Interface
+
+struct mcc_semantic_result mcc_semantic_check(struct mcc_ast_program *program,
+                                              const struct mcc_semantic_options *options)
+{
+	assert(program);
+
+	bool collect_all = options && options->collect_all;
+	size_t workers = options && options->threads > 1 ? options->threads : 1;
+
+	struct mcc_semantic_result global_result = {0};
+	struct mcc_symbol_table globals;
+	mcc_symbol_table_init(&globals);
+
+	struct checker checker = {
+	    .program = program,
+	    .collect_all = collect_all,
+	    .symbols = &globals,
+	    .result = &global_result,
+	};
+	check_globals(&checker);
+
+	struct mcc_semantic_result result = {0};
+
+	// Function bodies are only checked once all types are interned.
+	if (global_result.error == MCC_SEMANTIC_ERROR_ALLOCATION_ERROR) {
+		mcc_symbol_table_deinit(&globals);
+		mcc_semantic_result_deinit(&global_result);
+		result.error = MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+		return result;
+	}
+
+	struct function_phase phase = {
+	    .program = program,
+	    .collect_all = collect_all,
+	    .globals = &globals,
+	    .workers = calloc(workers, sizeof(*phase.workers)),
+	    .results = calloc(program->functions_count ? program->functions_count : 1, sizeof(*phase.results)),
+	};
+
+	if (phase.workers && phase.results) {
+		for (size_t i = 0; i < workers; i++) {
+			mcc_symbol_table_init(&phase.workers[i]);
+		}
+
+		mcc_parallel_for(program->functions_count, workers, check_function_task, &phase);
+		merge_results(&result, &global_result, phase.results, program->functions_count, collect_all);
+
+		for (size_t i = 0; i < workers; i++) {
+			mcc_symbol_table_deinit(&phase.workers[i]);
+		}
+		for (size_t i = 0; i < program->functions_count; i++) {
+			mcc_semantic_result_deinit(&phase.results[i]);
+		}
+	} else {
+		result.error = MCC_SEMANTIC_ERROR_ALLOCATION_ERROR;
+	}
+
+	free(phase.workers);
+	free(phase.results);
+	mcc_symbol_table_deinit(&globals);
+	mcc_semantic_result_deinit(&global_result);
+
+	return result;
+}
+
+void mcc_semantic_result_print_errors(FILE *out, const struct mcc_semantic_result *result, const char *filepath)
+{
+	assert(out);
+	assert(result);
+
+	if (!filepath) {
+		filepath = "<input>";
+	}
+
+	for (size_t i = 0; i < result->diagnostics_count; i++) {
+		const struct mcc_semantic_diagnostic *diagnostic = &result->diagnostics[i];
+		fprintf(out, "%s:%d:%d: error: %s\n", filepath, diagnostic->sloc.line, diagnostic->sloc.column,
+		        diagnostic->message);
+	}
+
+	if (result->error == MCC_SEMANTIC_ERROR_ALLOCATION_ERROR) {
+		fputs("error: allocation failed\n", out);
+	}
+}
+
+void mcc_semantic_result_deinit(struct mcc_semantic_result *result)
+{
+	if (!result) {
+		return;
+	}
+
+	free(result->diagnostics);
+	*result = (struct mcc_semantic_result){0};
+}
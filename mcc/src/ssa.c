@@ -0,0 +1,1302 @@
+#include "mcc/ssa.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/cfg.h"
+
+// ------------------------------------------------------------------ Helpers
+
+struct pair {
+	uint32_t key, value;
+};
+
+struct pairs {
+	struct pair *items;
+	size_t count;
+	size_t capacity;
+};
+
+static bool pairs_push(struct pairs *pairs, uint32_t key, uint32_t value)
+{
+	return mcc_array_push(pairs->items, pairs->count, pairs->capacity, ((struct pair){key, value}));
+}
+
+// Values grouped by key: the values of key `k` are `values[begin[k]]` up to,
+// but excluding, `values[begin[k + 1]]`, in insertion order.
+struct groups {
+	size_t *begin;
+	uint32_t *values;
+};
+
+static bool groups_build(struct groups *groups, const struct pairs *pairs, size_t keys)
+{
+	groups->begin = calloc(keys + 1, sizeof(*groups->begin));
+	groups->values = malloc((pairs->count ? pairs->count : 1) * sizeof(*groups->values));
+	if (!groups->begin || !groups->values) {
+		return false;
+	}
+
+	for (size_t i = 0; i < pairs->count; i++) {
+		groups->begin[pairs->items[i].key + 1]++;
+	}
+	for (size_t k = 0; k < keys; k++) {
+		groups->begin[k + 1] += groups->begin[k];
+	}
+
+	// Filling advances each key's start to the start of the next key, shift
+	// them back afterwards.
+	for (size_t i = 0; i < pairs->count; i++) {
+		groups->values[groups->begin[pairs->items[i].key]++] = pairs->items[i].value;
+	}
+	for (size_t k = keys; k > 0; k--) {
+		groups->begin[k] = groups->begin[k - 1];
+	}
+	groups->begin[0] = 0;
+	return true;
+}
+
+static void groups_deinit(struct groups *groups)
+{
+	free(groups->begin);
+	free(groups->values);
+}
+
+struct instructions {
+	struct mcc_tac_instruction *items;
+	size_t count;
+	size_t capacity;
+};
+
+static bool instructions_push(struct instructions *instructions, struct mcc_tac_instruction instruction)
+{
+	return mcc_array_push(instructions->items, instructions->count, instructions->capacity, instruction);
+}
+
+// Replaces the instructions of `function` by `instructions`.
+static void install(struct mcc_tac_function *function, struct instructions *instructions)
+{
+	free(function->instructions);
+	function->instructions = instructions->items;
+	function->instructions_count = instructions->count;
+	function->instructions_capacity = instructions->capacity;
+	function->removed_count = 0;
+	*instructions = (struct instructions){0};
+}
+
+// Label at the start of `block`, 0 if there is none.
+static uint32_t block_label(const struct mcc_tac_function *function, const struct mcc_cfg_block *block)
+{
+	if (block->begin < block->end && function->instructions[block->begin].op == MCC_TAC_OP_LABEL) {
+		return function->instructions[block->begin].arg2;
+	}
+	return 0;
+}
+
+// Drops unreachable blocks as well as tombstones, and starts every block with
+// a label. An entry block with predecessors gets a new, empty entry block in
+// front of it, so phis never have to deal with the function's entry.
+static bool normalize(struct mcc_tac_function *function)
+{
+	struct mcc_cfg cfg;
+	struct instructions normalized = {0};
+	bool ok = mcc_cfg_build(&cfg, function);
+
+	uint32_t labels = function->labels_count;
+	if (ok && cfg.blocks[0].predecessors_count > 0) {
+		ok = instructions_push(&normalized,
+		                       (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL, .arg2 = ++labels});
+	}
+
+	for (size_t b = 0; ok && b < cfg.blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg.blocks[b];
+		if (block->order == MCC_CFG_NONE) {
+			continue;
+		}
+
+		if (block_label(function, block) == 0) {
+			ok = instructions_push(&normalized,
+			                       (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL, .arg2 = ++labels});
+		}
+		for (size_t i = block->begin; ok && i < block->end; i++) {
+			if (function->instructions[i].op != MCC_TAC_OP_NOP) {
+				ok = instructions_push(&normalized, function->instructions[i]);
+			}
+		}
+	}
+
+	if (ok) {
+		install(function, &normalized);
+		function->labels_count = labels;
+	}
+	free(normalized.items);
+	mcc_cfg_deinit(&cfg);
+	return ok;
+}
+
+// ------------------------------------------------------------ Construction
+
+struct phi {
+	uint32_t block;
+	uint32_t variable;
+	uint32_t result;
+
+	// Index of the phi's (label, value) pairs in the function's `operands`,
+	// ordered like the block's predecessors.
+	uint32_t operands;
+};
+
+struct undo {
+	uint32_t variable;
+	uint32_t previous;
+};
+
+struct frame {
+	uint32_t block;
+	size_t child;
+	size_t undo_count;
+};
+
+struct construction {
+	struct mcc_tac_function *function;
+	struct mcc_cfg cfg;
+	bool failed;
+
+	// Number of variables before construction, only these get renamed.
+	uint32_t variables_count;
+
+	// Blocks defining each variable, and blocks reading it before any
+	// definition in the same block.
+	struct groups definitions;
+	struct groups exposed_uses;
+	struct groups frontiers;
+
+	struct phi *phis;
+	size_t phis_count;
+	size_t phis_capacity;
+	struct groups block_phis;
+
+	// Renaming state: the current name of each variable, and whether its
+	// original number has been handed out already.
+	uint32_t *current;
+	bool *named;
+	struct undo *undo;
+	size_t undo_count;
+	size_t undo_capacity;
+
+	// Variables holding the zero of each type, 0 until needed.
+	uint32_t zeros[MCC_TAC_TYPE_ARRAY + 1];
+
+	// Scratch state while scanning blocks.
+	uint32_t block;
+	uint32_t *marks;
+	struct pairs *pairs;
+};
+
+static void construction_deinit(struct construction *construction)
+{
+	mcc_cfg_deinit(&construction->cfg);
+	groups_deinit(&construction->definitions);
+	groups_deinit(&construction->exposed_uses);
+	groups_deinit(&construction->frontiers);
+	groups_deinit(&construction->block_phis);
+	free(construction->phis);
+	free(construction->current);
+	free(construction->named);
+	free(construction->undo);
+}
+
+static void collect_exposed_use(uint32_t *variable, void *userdata)
+{
+	struct construction *construction = userdata;
+
+	// `marks` holds the block plus one for variables defined or already
+	// recorded as read in the current block.
+	if (construction->marks[*variable] != construction->block + 1) {
+		construction->marks[*variable] = construction->block + 1;
+		if (!pairs_push(construction->pairs, *variable, construction->block)) {
+			construction->failed = true;
+		}
+	}
+}
+
+static bool collect_variables(struct construction *construction)
+{
+	struct mcc_tac_function *function = construction->function;
+	size_t variables = (size_t)construction->variables_count + 1;
+
+	struct pairs definitions = {0};
+	struct pairs exposed_uses = {0};
+	uint32_t *defined = calloc(variables, sizeof(*defined));
+	uint32_t *read = calloc(variables, sizeof(*read));
+	bool ok = defined && read;
+
+	for (uint32_t b = 0; ok && b < construction->cfg.blocks_count; b++) {
+		const struct mcc_cfg_block *block = &construction->cfg.blocks[b];
+		for (size_t i = block->begin; ok && i < block->end; i++) {
+			struct mcc_tac_instruction *instruction = &function->instructions[i];
+
+			// Variables defined earlier in the block are marked as read, too.
+			construction->block = b;
+			construction->marks = read;
+			construction->pairs = &exposed_uses;
+			mcc_tac_function_visit_uses(function, instruction, collect_exposed_use, construction);
+			ok = !construction->failed;
+
+			uint32_t definition = mcc_tac_instruction_definition(instruction);
+			if (ok && definition != 0) {
+				read[definition] = b + 1;
+				if (defined[definition] != b + 1) {
+					defined[definition] = b + 1;
+					ok = pairs_push(&definitions, definition, b);
+				}
+			}
+		}
+	}
+
+	ok = ok && groups_build(&construction->definitions, &definitions, variables) &&
+	     groups_build(&construction->exposed_uses, &exposed_uses, variables);
+
+	free(definitions.items);
+	free(exposed_uses.items);
+	free(defined);
+	free(read);
+	return ok;
+}
+
+// Dominance frontiers as described by Cooper, Harvey, and Kennedy.
+static bool compute_frontiers(struct construction *construction)
+{
+	const struct mcc_cfg *cfg = &construction->cfg;
+
+	struct pairs frontiers = {0};
+	uint32_t *marks = calloc(cfg->blocks_count, sizeof(*marks));
+	bool ok = marks;
+
+	for (uint32_t b = 0; ok && b < cfg->blocks_count; b++) {
+		if (cfg->blocks[b].predecessors_count < 2) {
+			continue;
+		}
+
+		const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, b);
+		for (uint32_t p = 0; ok && p < cfg->blocks[b].predecessors_count; p++) {
+			for (uint32_t runner = predecessors[p]; ok && runner != cfg->blocks[b].idom;
+			     runner = cfg->blocks[runner].idom) {
+				if (marks[runner] != b + 1) {
+					marks[runner] = b + 1;
+					ok = pairs_push(&frontiers, runner, b);
+				}
+			}
+		}
+	}
+
+	ok = ok && groups_build(&construction->frontiers, &frontiers, cfg->blocks_count);
+	free(frontiers.items);
+	free(marks);
+	return ok;
+}
+
+static bool add_phi(struct construction *construction, uint32_t block, uint32_t variable)
+{
+	struct mcc_tac_function *function = construction->function;
+	const struct mcc_cfg *cfg = &construction->cfg;
+
+	uint32_t count = cfg->blocks[block].predecessors_count;
+	const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, block);
+
+	// Reserve the pairs, the values are filled in while renaming.
+	uint32_t operands = 0;
+	for (uint32_t p = 0; p < count; p++) {
+		uint32_t pair[2] = {block_label(function, &cfg->blocks[predecessors[p]]), 0};
+		uint32_t index;
+		if (!mcc_tac_function_add_operands(function, pair, 2, &index)) {
+			return false;
+		}
+		if (p == 0) {
+			operands = index;
+		}
+	}
+
+	struct phi phi = {.block = block, .variable = variable, .operands = operands};
+	return mcc_array_push(construction->phis, construction->phis_count, construction->phis_capacity, phi);
+}
+
+// Places phis for every variable at the iterated dominance frontier of its
+// definitions, where it is live on entry.
+static bool place_phis(struct construction *construction)
+{
+	const struct mcc_cfg *cfg = &construction->cfg;
+
+	// Per-block marks, tagged with the variable being processed.
+	uint32_t *defines = calloc(cfg->blocks_count, sizeof(*defines));
+	uint32_t *live = calloc(cfg->blocks_count, sizeof(*live));
+	uint32_t *visited = calloc(cfg->blocks_count, sizeof(*visited));
+	uint32_t *queued = calloc(cfg->blocks_count, sizeof(*queued));
+	uint32_t *worklist = malloc(cfg->blocks_count * sizeof(*worklist));
+	bool ok = defines && live && visited && queued && worklist;
+
+	for (uint32_t v = 1; ok && v <= construction->variables_count; v++) {
+		const struct groups *definitions = &construction->definitions;
+		const struct groups *exposed_uses = &construction->exposed_uses;
+		if (definitions->begin[v] == definitions->begin[v + 1] ||
+		    exposed_uses->begin[v] == exposed_uses->begin[v + 1]) {
+			continue;
+		}
+
+		for (size_t i = definitions->begin[v]; i < definitions->begin[v + 1]; i++) {
+			defines[definitions->values[i]] = v;
+		}
+
+		// Live-in blocks, walking upwards from each exposed use until a
+		// definition is found.
+		size_t pending = 0;
+		for (size_t i = exposed_uses->begin[v]; i < exposed_uses->begin[v + 1]; i++) {
+			live[exposed_uses->values[i]] = v;
+			worklist[pending++] = exposed_uses->values[i];
+		}
+		while (pending > 0) {
+			uint32_t b = worklist[--pending];
+			const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, b);
+			for (uint32_t p = 0; p < cfg->blocks[b].predecessors_count; p++) {
+				uint32_t predecessor = predecessors[p];
+				if (live[predecessor] != v && defines[predecessor] != v) {
+					live[predecessor] = v;
+					worklist[pending++] = predecessor;
+				}
+			}
+		}
+
+		for (size_t i = definitions->begin[v]; i < definitions->begin[v + 1]; i++) {
+			queued[definitions->values[i]] = v;
+			worklist[pending++] = definitions->values[i];
+		}
+		while (ok && pending > 0) {
+			uint32_t b = worklist[--pending];
+			const struct groups *frontiers = &construction->frontiers;
+			for (size_t i = frontiers->begin[b]; ok && i < frontiers->begin[b + 1]; i++) {
+				uint32_t frontier = frontiers->values[i];
+				if (visited[frontier] == v) {
+					continue;
+				}
+				visited[frontier] = v;
+				if (live[frontier] == v) {
+					ok = add_phi(construction, frontier, v);
+				}
+				if (queued[frontier] != v) {
+					queued[frontier] = v;
+					worklist[pending++] = frontier;
+				}
+			}
+		}
+	}
+
+	struct pairs block_phis = {0};
+	for (size_t i = 0; ok && i < construction->phis_count; i++) {
+		ok = pairs_push(&block_phis, construction->phis[i].block, (uint32_t)i);
+	}
+	ok = ok && groups_build(&construction->block_phis, &block_phis, cfg->blocks_count);
+
+	free(block_phis.items);
+	free(defines);
+	free(live);
+	free(visited);
+	free(queued);
+	free(worklist);
+	return ok;
+}
+
+static uint32_t new_variable(struct construction *construction, enum mcc_tac_type type)
+{
+	struct mcc_tac_variable variable = mcc_tac_function_new_variable(construction->function, type);
+	if (variable.identifier == 0) {
+		construction->failed = true;
+	}
+	return variable.identifier;
+}
+
+static uint32_t define(struct construction *construction, uint32_t variable)
+{
+	uint32_t name = variable;
+	if (construction->named[variable]) {
+		name = new_variable(construction, mcc_tac_function_variable_type(construction->function, variable));
+	}
+	construction->named[variable] = true;
+
+	struct undo undo = {.variable = variable, .previous = construction->current[variable]};
+	if (!mcc_array_push(construction->undo, construction->undo_count, construction->undo_capacity, undo)) {
+		construction->failed = true;
+	}
+	construction->current[variable] = name;
+	return name;
+}
+
+static uint32_t use(struct construction *construction, uint32_t variable)
+{
+	if (construction->current[variable] != 0) {
+		return construction->current[variable];
+	}
+
+	// Not defined on any path, read zero.
+	enum mcc_tac_type type = mcc_tac_function_variable_type(construction->function, variable);
+	if (construction->zeros[type] == 0) {
+		construction->zeros[type] = new_variable(construction, type);
+	}
+	return construction->zeros[type];
+}
+
+static void rename_use(uint32_t *variable, void *userdata)
+{
+	*variable = use(userdata, *variable);
+}
+
+static void rename_block(struct construction *construction, uint32_t b)
+{
+	struct mcc_tac_function *function = construction->function;
+	const struct mcc_cfg *cfg = &construction->cfg;
+	const struct mcc_cfg_block *block = &cfg->blocks[b];
+	const struct groups *block_phis = &construction->block_phis;
+
+	for (size_t i = block_phis->begin[b]; i < block_phis->begin[b + 1]; i++) {
+		struct phi *phi = &construction->phis[block_phis->values[i]];
+		phi->result = define(construction, phi->variable);
+	}
+
+	for (size_t i = block->begin; i < block->end; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		mcc_tac_function_visit_uses(function, instruction, rename_use, construction);
+
+		uint32_t definition = mcc_tac_instruction_definition(instruction);
+		if (definition != 0) {
+			instruction->result = define(construction, definition);
+		}
+	}
+
+	for (uint32_t s = 0; s < block->successors_count; s++) {
+		uint32_t successor = block->successors[s];
+		const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, successor);
+
+		uint32_t position = 0;
+		while (predecessors[position] != b) {
+			position++;
+		}
+
+		for (size_t i = block_phis->begin[successor]; i < block_phis->begin[successor + 1]; i++) {
+			const struct phi *phi = &construction->phis[block_phis->values[i]];
+			function->operands[phi->operands + 2 * position + 1] = use(construction, phi->variable);
+		}
+	}
+}
+
+// Walks the dominator tree depth first, names defined in a block are visible
+// in the blocks it dominates.
+static bool rename_variables(struct construction *construction)
+{
+	const struct mcc_cfg *cfg = &construction->cfg;
+	size_t variables = (size_t)construction->variables_count + 1;
+
+	struct pairs children_pairs = {0};
+	struct groups children = {0};
+	struct frame *stack = malloc(cfg->blocks_count * sizeof(*stack));
+	construction->current = calloc(variables, sizeof(*construction->current));
+	construction->named = calloc(variables, sizeof(*construction->named));
+	bool ok = stack && construction->current && construction->named;
+
+	for (uint32_t b = 1; ok && b < cfg->blocks_count; b++) {
+		ok = pairs_push(&children_pairs, cfg->blocks[b].idom, b);
+	}
+	ok = ok && groups_build(&children, &children_pairs, cfg->blocks_count);
+
+	size_t depth = 0;
+	if (ok) {
+		rename_block(construction, 0);
+		stack[depth++] = (struct frame){.block = 0, .child = children.begin[0]};
+	}
+	while (depth > 0 && !construction->failed) {
+		struct frame *frame = &stack[depth - 1];
+		if (frame->child < children.begin[frame->block + 1]) {
+			uint32_t child = children.values[frame->child++];
+			size_t undo_count = construction->undo_count;
+			rename_block(construction, child);
+			stack[depth++] = (struct frame){
+			    .block = child,
+			    .child = children.begin[child],
+			    .undo_count = undo_count,
+			};
+			continue;
+		}
+
+		while (construction->undo_count > frame->undo_count) {
+			const struct undo *undo = &construction->undo[--construction->undo_count];
+			construction->current[undo->variable] = undo->previous;
+		}
+		depth--;
+	}
+
+	free(children_pairs.items);
+	groups_deinit(&children);
+	free(stack);
+	return ok && !construction->failed;
+}
+
+static bool emit_zero(struct mcc_tac_function *function,
+                      struct instructions *instructions,
+                      enum mcc_tac_type type,
+                      uint32_t variable)
+{
+	struct mcc_tac_instruction instruction = {.op = MCC_TAC_OP_CONST, .type = type, .result = variable};
+	switch (type) {
+	case MCC_TAC_TYPE_BOOL:
+	case MCC_TAC_TYPE_INT:
+	case MCC_TAC_TYPE_FLOAT:
+		if (!mcc_tac_function_add_constant(function, 0, &instruction.arg1)) {
+			return false;
+		}
+		break;
+	case MCC_TAC_TYPE_STRING:
+		if (!mcc_tac_function_add_string(function, "", &instruction.arg1)) {
+			return false;
+		}
+		break;
+	case MCC_TAC_TYPE_ARRAY:
+		// Arrays are defined at their declaration, this is for robustness.
+		instruction.op = MCC_TAC_OP_ARRAY;
+		instruction.type = MCC_TAC_TYPE_INT;
+		if (!mcc_tac_function_add_constant(function, mcc_tac_int_bits(1), &instruction.arg1)) {
+			return false;
+		}
+		break;
+	case MCC_TAC_TYPE_VOID:
+		assert(false);
+		break;
+	}
+	return instructions_push(instructions, instruction);
+}
+
+// Lays out the renamed instructions with phis after each block's label and
+// the zeros needed at the start of the entry block.
+static bool emit_ssa(struct construction *construction)
+{
+	struct mcc_tac_function *function = construction->function;
+	const struct mcc_cfg *cfg = &construction->cfg;
+
+	struct instructions ssa = {0};
+	bool ok = true;
+
+	for (uint32_t b = 0; ok && b < cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		ok = instructions_push(&ssa, function->instructions[block->begin]);
+
+		if (b == 0) {
+			for (int type = MCC_TAC_TYPE_BOOL; ok && type <= MCC_TAC_TYPE_ARRAY; type++) {
+				if (construction->zeros[type] != 0) {
+					ok = emit_zero(function, &ssa, (enum mcc_tac_type)type,
+					               construction->zeros[type]);
+				}
+			}
+		}
+
+		const struct groups *block_phis = &construction->block_phis;
+		for (size_t i = block_phis->begin[b]; ok && i < block_phis->begin[b + 1]; i++) {
+			const struct phi *phi = &construction->phis[block_phis->values[i]];
+			struct mcc_tac_instruction instruction = {
+			    .op = MCC_TAC_OP_PHI,
+			    .type = mcc_tac_function_variable_type(function, phi->variable),
+			    .result = phi->result,
+			    .arg1 = phi->operands,
+			    .arg2 = block->predecessors_count,
+			};
+			ok = instructions_push(&ssa, instruction);
+		}
+
+		for (size_t i = block->begin + 1; ok && i < block->end; i++) {
+			ok = instructions_push(&ssa, function->instructions[i]);
+		}
+	}
+
+	if (ok) {
+		install(function, &ssa);
+	}
+	free(ssa.items);
+	return ok;
+}
+
+bool mcc_ssa_construct(struct mcc_tac_function *function)
+{
+	assert(function);
+
+	if (!normalize(function)) {
+		return false;
+	}
+
+	struct construction construction = {
+	    .function = function,
+	    .variables_count = function->variables_count,
+	};
+	bool ok = mcc_cfg_build(&construction.cfg, function) && collect_variables(&construction) &&
+	          compute_frontiers(&construction) && place_phis(&construction);
+
+	// Renaming rewrites instructions in place, work on a copy so a failure
+	// leaves the function intact.
+	struct mcc_tac_instruction *original = function->instructions;
+	if (ok) {
+		size_t size = function->instructions_count * sizeof(*original);
+		function->instructions = malloc(size ? size : 1);
+		if (function->instructions) {
+			memcpy(function->instructions, original, size);
+			ok = rename_variables(&construction) && emit_ssa(&construction);
+			if (!ok) {
+				free(function->instructions);
+				function->instructions = original;
+			} else {
+				free(original);
+			}
+		} else {
+			function->instructions = original;
+			ok = false;
+		}
+	}
+
+	construction_deinit(&construction);
+	return ok;
+}
+
+// ------------------------------------------------------------- Destruction
+
+struct destruction {
+	struct mcc_tac_function *function;
+	struct mcc_cfg cfg;
+	struct mcc_ssa_def_use def_use;
+	bool failed;
+
+	// Block of each instruction.
+	uint32_t *blocks;
+
+	// Variables live at the end of each block, interfering variables of each
+	// variable.
+	struct groups live_out;
+	struct groups interference;
+
+	// Coalesced variables form classes, kept in a union-find structure. The
+	// members of a class are linked in a ring, the class is named after its
+	// smallest member.
+	uint32_t *parents;
+	uint32_t *sizes;
+	uint32_t *names;
+	uint32_t *members;
+
+	// Live variables during the interference scan, as a sparse set.
+	uint32_t *live;
+	uint32_t *live_positions;
+	size_t live_count;
+	struct pairs *edges;
+};
+
+static void destruction_deinit(struct destruction *destruction)
+{
+	mcc_cfg_deinit(&destruction->cfg);
+	mcc_ssa_def_use_deinit(&destruction->def_use);
+	free(destruction->blocks);
+	groups_deinit(&destruction->live_out);
+	groups_deinit(&destruction->interference);
+	free(destruction->parents);
+	free(destruction->sizes);
+	free(destruction->names);
+	free(destruction->members);
+	free(destruction->live);
+	free(destruction->live_positions);
+}
+
+// Path exploration by Boissinot et al.: every use of a variable is traced
+// upwards to the variable's definition. A phi reads its operands at the end of
+// the respective predecessor.
+static bool compute_liveness(struct destruction *destruction)
+{
+	struct mcc_tac_function *function = destruction->function;
+	const struct mcc_cfg *cfg = &destruction->cfg;
+	const struct mcc_ssa_def_use *def_use = &destruction->def_use;
+
+	struct pairs live_out = {0};
+	uint32_t *live_in = calloc(cfg->blocks_count, sizeof(*live_in));
+	uint32_t *live_out_marks = calloc(cfg->blocks_count, sizeof(*live_out_marks));
+	uint32_t *worklist = malloc((cfg->blocks_count + 1) * sizeof(*worklist));
+	bool ok = live_in && live_out_marks && worklist;
+
+	for (uint32_t v = 1; ok && v <= def_use->variables_count; v++) {
+		size_t definition = def_use->definitions[v];
+		uint32_t definition_block = MCC_CFG_NONE;
+		bool phi = false;
+		if (definition != MCC_SSA_NO_DEFINITION) {
+			definition_block = destruction->blocks[definition];
+			phi = function->instructions[definition].op == MCC_TAC_OP_PHI;
+		}
+
+		for (size_t u = def_use->uses_begin[v]; ok && u < def_use->uses_begin[v + 1]; u++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[def_use->uses[u]];
+
+			size_t pending = 0;
+			if (instruction->op != MCC_TAC_OP_PHI) {
+				worklist[pending++] = destruction->blocks[def_use->uses[u]];
+			} else {
+				for (uint32_t i = 0; ok && i < instruction->arg2; i++) {
+					const uint32_t *pair = &function->operands[instruction->arg1 + 2 * i];
+					uint32_t predecessor = cfg->label_blocks[pair[0]];
+					if (pair[1] == v && live_out_marks[predecessor] != v) {
+						live_out_marks[predecessor] = v;
+						ok = pairs_push(&live_out, predecessor, v);
+						worklist[pending++] = predecessor;
+					}
+				}
+			}
+
+			while (ok && pending > 0) {
+				uint32_t b = worklist[--pending];
+				if ((b == definition_block && !phi) || live_in[b] == v) {
+					continue;
+				}
+				live_in[b] = v;
+				if (b == definition_block) {
+					continue;
+				}
+
+				const uint32_t *predecessors = mcc_cfg_block_predecessors(cfg, b);
+				for (uint32_t p = 0; ok && p < cfg->blocks[b].predecessors_count; p++) {
+					uint32_t predecessor = predecessors[p];
+					if (live_out_marks[predecessor] != v) {
+						live_out_marks[predecessor] = v;
+						ok = pairs_push(&live_out, predecessor, v);
+						worklist[pending++] = predecessor;
+					}
+				}
+			}
+		}
+	}
+
+	ok = ok && groups_build(&destruction->live_out, &live_out, cfg->blocks_count);
+	free(live_out.items);
+	free(live_in);
+	free(live_out_marks);
+	free(worklist);
+	return ok;
+}
+
+static void live_add(struct destruction *destruction, uint32_t variable)
+{
+	uint32_t position = destruction->live_positions[variable];
+	if (position < destruction->live_count && destruction->live[position] == variable) {
+		return;
+	}
+	destruction->live_positions[variable] = (uint32_t)destruction->live_count;
+	destruction->live[destruction->live_count++] = variable;
+}
+
+static void live_remove(struct destruction *destruction, uint32_t variable)
+{
+	uint32_t position = destruction->live_positions[variable];
+	if (position < destruction->live_count && destruction->live[position] == variable) {
+		uint32_t last = destruction->live[--destruction->live_count];
+		destruction->live[position] = last;
+		destruction->live_positions[last] = position;
+	}
+}
+
+static void live_add_use(uint32_t *variable, void *userdata)
+{
+	live_add(userdata, *variable);
+}
+
+// Records that `variable`, defined at the current point, interferes with all
+// live variables except `except`.
+static void interfere_with_live(struct destruction *destruction, uint32_t variable, uint32_t except)
+{
+	for (size_t i = 0; i < destruction->live_count; i++) {
+		uint32_t other = destruction->live[i];
+		if (other != variable && other != except &&
+		    (!pairs_push(destruction->edges, variable, other) ||
+		     !pairs_push(destruction->edges, other, variable))) {
+			destruction->failed = true;
+		}
+	}
+}
+
+// Scans each block backwards. A copy does not make its destination interfere
+// with its source, they hold the same value. Phis of a block are defined in
+// parallel at its start, so they interfere with each other.
+static bool compute_interference(struct destruction *destruction)
+{
+	struct mcc_tac_function *function = destruction->function;
+	const struct mcc_cfg *cfg = &destruction->cfg;
+	size_t variables = (size_t)function->variables_count + 1;
+
+	struct pairs edges = {0};
+	destruction->edges = &edges;
+	destruction->live = malloc(variables * sizeof(*destruction->live));
+	destruction->live_positions = calloc(variables, sizeof(*destruction->live_positions));
+	if (!destruction->live || !destruction->live_positions) {
+		return false;
+	}
+
+	for (uint32_t b = 0; b < cfg->blocks_count && !destruction->failed; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		const struct groups *live_out = &destruction->live_out;
+
+		destruction->live_count = 0;
+		for (size_t i = live_out->begin[b]; i < live_out->begin[b + 1]; i++) {
+			live_add(destruction, live_out->values[i]);
+		}
+
+		size_t phis_end = block->begin;
+		while (phis_end < block->end && (function->instructions[phis_end].op == MCC_TAC_OP_LABEL ||
+		                                 function->instructions[phis_end].op == MCC_TAC_OP_PHI)) {
+			phis_end++;
+		}
+
+		for (size_t i = block->end; i > phis_end; i--) {
+			struct mcc_tac_instruction *instruction = &function->instructions[i - 1];
+			uint32_t definition = mcc_tac_instruction_definition(instruction);
+			if (definition != 0) {
+				uint32_t source = instruction->op == MCC_TAC_OP_ASSIGN ? instruction->arg1 : 0;
+				interfere_with_live(destruction, definition, source);
+				live_remove(destruction, definition);
+			}
+			mcc_tac_function_visit_uses(function, instruction, live_add_use, destruction);
+		}
+
+		for (size_t i = block->begin; i < phis_end; i++) {
+			const struct mcc_tac_instruction *phi = &function->instructions[i];
+			if (phi->op != MCC_TAC_OP_PHI) {
+				continue;
+			}
+			interfere_with_live(destruction, phi->result, 0);
+			for (size_t j = i + 1; j < phis_end; j++) {
+				uint32_t other = function->instructions[j].result;
+				if (function->instructions[j].op == MCC_TAC_OP_PHI &&
+				    (!pairs_push(&edges, phi->result, other) ||
+				     !pairs_push(&edges, other, phi->result))) {
+					destruction->failed = true;
+				}
+			}
+		}
+	}
+
+	bool ok = !destruction->failed && groups_build(&destruction->interference, &edges, variables);
+	free(edges.items);
+	return ok;
+}
+
+static uint32_t find_class(struct destruction *destruction, uint32_t variable)
+{
+	uint32_t root = variable;
+	while (destruction->parents[root] != root) {
+		root = destruction->parents[root];
+	}
+	while (destruction->parents[variable] != root) {
+		uint32_t parent = destruction->parents[variable];
+		destruction->parents[variable] = root;
+		variable = parent;
+	}
+	return root;
+}
+
+static bool classes_interfere(struct destruction *destruction, uint32_t small, uint32_t large)
+{
+	const struct groups *interference = &destruction->interference;
+
+	uint32_t member = small;
+	do {
+		for (size_t i = interference->begin[member]; i < interference->begin[member + 1]; i++) {
+			if (find_class(destruction, interference->values[i]) == large) {
+				return true;
+			}
+		}
+		member = destruction->members[member];
+	} while (member != small);
+	return false;
+}
+
+static void try_coalesce(struct destruction *destruction, uint32_t a, uint32_t b)
+{
+	const struct mcc_tac_function *function = destruction->function;
+	if (mcc_tac_function_variable_type(function, a) != mcc_tac_function_variable_type(function, b)) {
+		return;
+	}
+
+	a = find_class(destruction, a);
+	b = find_class(destruction, b);
+	if (a == b) {
+		return;
+	}
+	if (destruction->sizes[a] > destruction->sizes[b]) {
+		uint32_t tmp = a;
+		a = b;
+		b = tmp;
+	}
+	if (classes_interfere(destruction, a, b)) {
+		return;
+	}
+
+	destruction->parents[a] = b;
+	destruction->sizes[b] += destruction->sizes[a];
+	if (destruction->names[a] < destruction->names[b]) {
+		destruction->names[b] = destruction->names[a];
+	}
+
+	uint32_t next = destruction->members[a];
+	destruction->members[a] = destruction->members[b];
+	destruction->members[b] = next;
+}
+
+// Phi operands are coalesced first, removing those copies matters most.
+static bool coalesce(struct destruction *destruction)
+{
+	struct mcc_tac_function *function = destruction->function;
+	size_t variables = (size_t)function->variables_count + 1;
+
+	destruction->parents = malloc(variables * sizeof(*destruction->parents));
+	destruction->sizes = malloc(variables * sizeof(*destruction->sizes));
+	destruction->names = malloc(variables * sizeof(*destruction->names));
+	destruction->members = malloc(variables * sizeof(*destruction->members));
+	if (!destruction->parents || !destruction->sizes || !destruction->names || !destruction->members) {
+		return false;
+	}
+
+	for (size_t v = 0; v < variables; v++) {
+		destruction->parents[v] = destruction->names[v] = destruction->members[v] = (uint32_t)v;
+		destruction->sizes[v] = 1;
+	}
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_PHI) {
+			for (uint32_t j = 0; j < instruction->arg2; j++) {
+				try_coalesce(destruction, instruction->result,
+				             function->operands[instruction->arg1 + 2 * j + 1]);
+			}
+		}
+	}
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_ASSIGN) {
+			try_coalesce(destruction, instruction->result, instruction->arg1);
+		}
+	}
+	return true;
+}
+
+static uint32_t class_name(struct destruction *destruction, uint32_t variable)
+{
+	return destruction->names[find_class(destruction, variable)];
+}
+
+static void rename_to_class(uint32_t *variable, void *userdata)
+{
+	*variable = class_name(userdata, *variable);
+}
+
+struct copy {
+	uint32_t destination, source;
+};
+
+static struct mcc_tac_instruction copy_instruction(const struct mcc_tac_function *function, struct copy copy)
+{
+	return (struct mcc_tac_instruction){
+	    .op = MCC_TAC_OP_ASSIGN,
+	    .type = mcc_tac_function_variable_type(function, copy.destination),
+	    .result = copy.destination,
+	    .arg1 = copy.source,
+	};
+}
+
+// Emits the copies feeding the phis of `successor` when coming from
+// `predecessor`. All copies happen at once: a copy is emitted once no other
+// pending copy reads its destination, cycles are broken by a temporary.
+static bool emit_copies(struct destruction *destruction,
+                        uint32_t predecessor,
+                        uint32_t successor,
+                        struct instructions *out)
+{
+	struct mcc_tac_function *function = destruction->function;
+	const struct mcc_cfg_block *block = &destruction->cfg.blocks[successor];
+	uint32_t label = block_label(function, &destruction->cfg.blocks[predecessor]);
+
+	struct copy *copies = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+	bool ok = true;
+
+	for (size_t i = block->begin; ok && i < block->end; i++) {
+		const struct mcc_tac_instruction *phi = &function->instructions[i];
+		if (phi->op == MCC_TAC_OP_LABEL) {
+			continue;
+		} else if (phi->op != MCC_TAC_OP_PHI) {
+			break;
+		}
+
+		for (uint32_t j = 0; j < phi->arg2; j++) {
+			const uint32_t *pair = &function->operands[phi->arg1 + 2 * j];
+			if (pair[0] != label) {
+				continue;
+			}
+			struct copy copy = {class_name(destruction, phi->result), class_name(destruction, pair[1])};
+			if (copy.destination != copy.source) {
+				ok = mcc_array_push(copies, count, capacity, copy);
+			}
+			break;
+		}
+	}
+
+	while (ok && count > 0) {
+		size_t ready = count;
+		for (size_t i = 0; i < count && ready == count; i++) {
+			ready = i;
+			for (size_t j = 0; j < count; j++) {
+				if (j != i && copies[j].source == copies[i].destination) {
+					ready = count;
+					break;
+				}
+			}
+		}
+
+		if (ready < count) {
+			ok = instructions_push(out, copy_instruction(function, copies[ready]));
+			copies[ready] = copies[--count];
+			continue;
+		}
+
+		// Only cycles are left, save one source so its copy becomes ready.
+		uint32_t source = copies[0].source;
+		struct mcc_tac_variable temporary =
+		    mcc_tac_function_new_variable(function, mcc_tac_function_variable_type(function, source));
+		ok = temporary.identifier != 0 &&
+		     instructions_push(out, copy_instruction(function, (struct copy){temporary.identifier, source}));
+		for (size_t i = 0; i < count; i++) {
+			if (copies[i].source == source) {
+				copies[i].source = temporary.identifier;
+			}
+		}
+	}
+
+	free(copies);
+	return ok;
+}
+
+static bool is_jump(enum mcc_tac_op op)
+{
+	return op == MCC_TAC_OP_JUMP || op == MCC_TAC_OP_JUMP_IF || op == MCC_TAC_OP_JUMP_IF_NOT;
+}
+
+// Copies on the taken edge of a conditional jump go into a separate block
+// jumping to the original target, which is appended to `trampolines`.
+static bool emit_block(struct destruction *destruction,
+                       uint32_t b,
+                       struct instructions *out,
+                       struct instructions *trampolines)
+{
+	struct mcc_tac_function *function = destruction->function;
+	const struct mcc_cfg *cfg = &destruction->cfg;
+	const struct mcc_cfg_block *block = &cfg->blocks[b];
+	uint32_t next = b + 1 < cfg->blocks_count ? b + 1 : MCC_CFG_NONE;
+
+	struct mcc_tac_instruction terminator = {.op = MCC_TAC_OP_NOP};
+	bool ok = true;
+	for (size_t i = block->begin; ok && i < block->end; i++) {
+		struct mcc_tac_instruction instruction = function->instructions[i];
+		if (instruction.op == MCC_TAC_OP_NOP || instruction.op == MCC_TAC_OP_PHI) {
+			continue;
+		}
+
+		mcc_tac_function_visit_uses(function, &instruction, rename_to_class, destruction);
+		if (mcc_tac_instruction_definition(&instruction) != 0) {
+			instruction.result = class_name(destruction, instruction.result);
+		}
+
+		if (is_jump(instruction.op) || instruction.op == MCC_TAC_OP_RETURN) {
+			terminator = instruction;
+		} else if (instruction.op != MCC_TAC_OP_ASSIGN || instruction.result != instruction.arg1) {
+			ok = instructions_push(out, instruction);
+		}
+	}
+
+	switch ((enum mcc_tac_op)terminator.op) {
+	case MCC_TAC_OP_JUMP:
+		return ok && emit_copies(destruction, b, cfg->label_blocks[terminator.arg2], out) &&
+		       instructions_push(out, terminator);
+
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT: {
+		size_t start = trampolines->count;
+		uint32_t target = terminator.arg2;
+		ok = ok && instructions_push(trampolines, (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL}) &&
+		     emit_copies(destruction, b, cfg->label_blocks[target], trampolines);
+		if (ok && trampolines->count > start + 1) {
+			assert(function->labels_count < UINT32_MAX);
+			terminator.arg2 = ++function->labels_count;
+			trampolines->items[start].arg2 = terminator.arg2;
+			ok = instructions_push(trampolines,
+			                       (struct mcc_tac_instruction){.op = MCC_TAC_OP_JUMP, .arg2 = target});
+		} else {
+			trampolines->count = start;
+		}
+		ok = ok && instructions_push(out, terminator);
+		return ok && (next == MCC_CFG_NONE || emit_copies(destruction, b, next, out));
+	}
+
+	case MCC_TAC_OP_RETURN:
+		return ok && instructions_push(out, terminator);
+
+	default:
+		return ok && (next == MCC_CFG_NONE || emit_copies(destruction, b, next, out));
+	}
+}
+
+// Removes labels no jump refers to anymore.
+static bool remove_unused_labels(struct mcc_tac_function *function, struct instructions *instructions)
+{
+	bool *used = calloc((size_t)function->labels_count + 1, sizeof(*used));
+	if (!used) {
+		return false;
+	}
+
+	for (size_t i = 0; i < instructions->count; i++) {
+		if (is_jump(instructions->items[i].op)) {
+			used[instructions->items[i].arg2] = true;
+		}
+	}
+
+	size_t count = 0;
+	for (size_t i = 0; i < instructions->count; i++) {
+		const struct mcc_tac_instruction *instruction = &instructions->items[i];
+		if (instruction->op != MCC_TAC_OP_LABEL || used[instruction->arg2]) {
+			instructions->items[count++] = *instruction;
+		}
+	}
+	instructions->count = count;
+
+	free(used);
+	return true;
+}
+
+bool mcc_ssa_destruct(struct mcc_tac_function *function)
+{
+	assert(function);
+
+	struct destruction destruction = {.function = function};
+	uint32_t labels_count = function->labels_count;
+	bool ok = mcc_cfg_build(&destruction.cfg, function) && mcc_ssa_def_use_build(&destruction.def_use, function);
+
+	if (ok) {
+		destruction.blocks = malloc((function->instructions_count + 1) * sizeof(*destruction.blocks));
+		ok = destruction.blocks;
+	}
+	for (uint32_t b = 0; ok && b < destruction.cfg.blocks_count; b++) {
+		const struct mcc_cfg_block *block = &destruction.cfg.blocks[b];
+		for (size_t i = block->begin; i < block->end; i++) {
+			destruction.blocks[i] = b;
+		}
+	}
+
+	ok = ok && compute_liveness(&destruction) && compute_interference(&destruction) && coalesce(&destruction);
+
+	struct instructions out = {0};
+	struct instructions trampolines = {0};
+	for (uint32_t b = 0; ok && b < destruction.cfg.blocks_count; b++) {
+		ok = emit_block(&destruction, b, &out, &trampolines);
+	}
+	for (size_t i = 0; ok && i < trampolines.count; i++) {
+		ok = instructions_push(&out, trampolines.items[i]);
+	}
+	ok = ok && remove_unused_labels(function, &out);
+
+	if (ok) {
+		install(function, &out);
+	} else {
+		function->labels_count = labels_count;
+	}
+	free(out.items);
+	free(trampolines.items);
+	destruction_deinit(&destruction);
+	return ok;
+}
+
+// ---------------------------------------------------------------- Def-Use
+
+struct use_counter {
+	struct mcc_ssa_def_use *def_use;
+	size_t instruction;
+	size_t *cursor;
+};
+
+static void count_use(uint32_t *variable, void *userdata)
+{
+	struct use_counter *counter = userdata;
+	counter->def_use->uses_begin[*variable + 1]++;
+}
+
+static void record_use(uint32_t *variable, void *userdata)
+{
+	struct use_counter *counter = userdata;
+	counter->def_use->uses[counter->cursor[*variable]++] = counter->instruction;
+}
+
+bool mcc_ssa_def_use_build(struct mcc_ssa_def_use *def_use, struct mcc_tac_function *function)
+{
+	assert(def_use);
+	assert(function);
+
+	size_t variables = (size_t)function->variables_count + 1;
+	*def_use = (struct mcc_ssa_def_use){
+	    .variables_count = function->variables_count,
+	    .definitions = malloc(variables * sizeof(*def_use->definitions)),
+	    .uses_begin = calloc(variables + 1, sizeof(*def_use->uses_begin)),
+	};
+	if (!def_use->definitions || !def_use->uses_begin) {
+		return false;
+	}
+
+	struct use_counter counter = {.def_use = def_use};
+	for (size_t v = 0; v < variables; v++) {
+		def_use->definitions[v] = MCC_SSA_NO_DEFINITION;
+	}
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		mcc_tac_function_visit_uses(function, instruction, count_use, &counter);
+
+		uint32_t definition = mcc_tac_instruction_definition(instruction);
+		if (definition != 0) {
+			def_use->definitions[definition] = i;
+		}
+	}
+	for (size_t v = 0; v < variables; v++) {
+		def_use->uses_begin[v + 1] += def_use->uses_begin[v];
+	}
+
+	size_t uses = def_use->uses_begin[variables];
+	def_use->uses = malloc((uses ? uses : 1) * sizeof(*def_use->uses));
+	counter.cursor = malloc(variables * sizeof(*counter.cursor));
+	if (!def_use->uses || !counter.cursor) {
+		free(counter.cursor);
+		return false;
+	}
+
+	memcpy(counter.cursor, def_use->uses_begin, variables * sizeof(*counter.cursor));
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		counter.instruction = i;
+		mcc_tac_function_visit_uses(function, &function->instructions[i], record_use, &counter);
+	}
+
+	free(counter.cursor);
+	return true;
+}
+
+void mcc_ssa_def_use_deinit(struct mcc_ssa_def_use *def_use)
+{
+	if (!def_use) {
+		return;
+	}
+
+	free(def_use->definitions);
+	free(def_use->uses_begin);
+	free(def_use->uses);
+	*def_use = (struct mcc_ssa_def_use){0};
+}
@@ -0,0 +1,439 @@
+#include "mcc/strength.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "array.h"
+#include "mcc/cfg.h"
+#include "mcc/loops.h"
+
+// An invariant operand, either a variable or a constant's value.
+struct operand {
+	bool constant;
+	uint32_t variable;
+	int32_t value;
+};
+
+// A derived induction variable, the product of `basic` and `factor`, held
+// in `variable`.
+struct derived {
+	uint32_t basic;
+	struct operand factor;
+	uint32_t variable;
+};
+
+// An instruction inserted before `index`, instructions inserted at the same
+// index keep the order they were created in.
+struct insertion {
+	size_t index;
+	size_t sequence;
+	struct mcc_tac_instruction instruction;
+};
+
+// A multiplication replaced by copying `variable`.
+struct rewrite {
+	size_t index;
+	uint32_t variable;
+};
+
+struct strength {
+	struct mcc_tac_function *function;
+	struct mcc_cfg cfg;
+	struct mcc_loops loops;
+
+	// Assignments of each variable in the function and within the current
+	// loop, with the assigning instruction of variables assigned once.
+	uint32_t *definitions;
+	uint32_t *definition_instructions;
+	uint32_t *loop_definitions;
+	uint32_t *loop_definition_instructions;
+	uint32_t *instruction_blocks;
+
+	// Derived induction variables of the current loop.
+	struct derived *derived;
+	size_t derived_count;
+	size_t derived_capacity;
+
+	struct insertion *insertions;
+	size_t insertions_count;
+	size_t insertions_capacity;
+
+	struct rewrite *rewrites;
+	size_t rewrites_count;
+	size_t rewrites_capacity;
+
+	size_t variables;
+};
+
+static void strength_deinit(struct strength *strength)
+{
+	mcc_cfg_deinit(&strength->cfg);
+	mcc_loops_deinit(&strength->loops);
+	free(strength->definitions);
+	free(strength->definition_instructions);
+	free(strength->loop_definitions);
+	free(strength->loop_definition_instructions);
+	free(strength->instruction_blocks);
+	free(strength->derived);
+	free(strength->insertions);
+	free(strength->rewrites);
+}
+
+static bool strength_init(struct strength *strength)
+{
+	struct mcc_tac_function *function = strength->function;
+	if (!mcc_cfg_build(&strength->cfg, function) || !mcc_loops_find(&strength->loops, &strength->cfg)) {
+		return false;
+	}
+
+	size_t variables = function->variables_count + 1;
+	strength->definitions = calloc(variables, sizeof(*strength->definitions));
+	strength->definition_instructions = malloc(variables * sizeof(*strength->definition_instructions));
+	strength->loop_definitions = calloc(variables, sizeof(*strength->loop_definitions));
+	strength->loop_definition_instructions = malloc(variables * sizeof(*strength->loop_definition_instructions));
+	strength->instruction_blocks =
+	    malloc((function->instructions_count + 1) * sizeof(*strength->instruction_blocks));
+	if (!strength->definitions || !strength->definition_instructions || !strength->loop_definitions ||
+	    !strength->loop_definition_instructions || !strength->instruction_blocks) {
+		return false;
+	}
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		uint32_t variable = mcc_tac_instruction_definition(&function->instructions[i]);
+		strength->definitions[variable]++;
+		strength->definition_instructions[variable] = (uint32_t)i;
+		strength->instruction_blocks[i] = MCC_CFG_NONE;
+	}
+	for (uint32_t b = 0; b < strength->cfg.blocks_count; b++) {
+		const struct mcc_cfg_block *block = &strength->cfg.blocks[b];
+		for (size_t i = block->begin; i < block->end; i++) {
+			strength->instruction_blocks[i] = b;
+		}
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------- Operands
+
+// Returns whether `variable`, read by instruction `i` of the current loop,
+// has the same value in every iteration.
+static bool is_invariant(const struct strength *strength, uint32_t variable, size_t i, struct operand *operand)
+{
+	if (strength->loop_definitions[variable] == 0) {
+		*operand = (struct operand){.variable = variable};
+		return true;
+	}
+	if (strength->definitions[variable] != 1) {
+		return false;
+	}
+
+	// Constants assigned within the loop, read only where the assignment
+	// has run.
+	const struct mcc_tac_function *function = strength->function;
+	uint32_t d = strength->definition_instructions[variable];
+	const struct mcc_tac_instruction *definition = &function->instructions[d];
+	if (definition->op != MCC_TAC_OP_CONST || definition->type != MCC_TAC_TYPE_INT) {
+		return false;
+	}
+	uint32_t from = strength->instruction_blocks[d];
+	uint32_t to = strength->instruction_blocks[i];
+	if (from == MCC_CFG_NONE || strength->cfg.blocks[from].order == MCC_CFG_NONE ||
+	    (from == to ? d > i : !mcc_cfg_dominates(&strength->cfg, from, to))) {
+		return false;
+	}
+	*operand = (struct operand){
+	    .constant = true,
+	    .value = (int32_t)mcc_tac_bits_int(function->constants[definition->arg1]),
+	};
+	return true;
+}
+
+static bool operands_equal(struct operand a, struct operand b)
+{
+	return a.constant == b.constant && (a.constant ? a.value == b.value : a.variable == b.variable);
+}
+
+// Returns whether `variable` is a basic induction variable of the current
+// loop, with its step and whether the step is subtracted.
+static bool is_basic(const struct strength *strength, uint32_t variable, struct operand *step, bool *subtracted)
+{
+	if (strength->loop_definitions[variable] != 1 ||
+	    mcc_tac_function_variable_type(strength->function, variable) != MCC_TAC_TYPE_INT) {
+		return false;
+	}
+
+	uint32_t i = strength->loop_definition_instructions[variable];
+	const struct mcc_tac_instruction *definition = &strength->function->instructions[i];
+	uint32_t other;
+	if (definition->op == MCC_TAC_OP_ADD && definition->arg1 == variable) {
+		other = definition->arg2;
+	} else if (definition->op == MCC_TAC_OP_ADD && definition->arg2 == variable) {
+		other = definition->arg1;
+	} else if (definition->op == MCC_TAC_OP_SUB && definition->arg1 == variable) {
+		other = definition->arg2;
+	} else {
+		return false;
+	}
+	*subtracted = definition->op == MCC_TAC_OP_SUB;
+	return other != variable && is_invariant(strength, other, i, step);
+}
+
+// ------------------------------------------------------------------- Loops
+
+static bool insert(struct strength *strength, size_t index, struct mcc_tac_instruction instruction)
+{
+	struct insertion insertion = {
+	    .index = index,
+	    .sequence = strength->insertions_count,
+	    .instruction = instruction,
+	};
+	return mcc_array_push(strength->insertions, strength->insertions_count, strength->insertions_capacity,
+	                      insertion);
+}
+
+// Returns a variable holding `operand` at `index`, assigning constants
+// there.
+static uint32_t materialise(struct strength *strength, size_t index, struct operand operand)
+{
+	if (!operand.constant) {
+		return operand.variable;
+	}
+	struct mcc_tac_function *function = strength->function;
+	uint32_t constant;
+	uint32_t variable = mcc_tac_function_new_variable(function, MCC_TAC_TYPE_INT).identifier;
+	if (variable == 0 || !mcc_tac_function_add_constant(function, mcc_tac_int_bits(operand.value), &constant) ||
+	    !insert(strength, index,
+	            (struct mcc_tac_instruction){
+	                .op = MCC_TAC_OP_CONST,
+	                .type = MCC_TAC_TYPE_INT,
+	                .result = variable,
+	                .arg1 = constant,
+	            })) {
+		return 0;
+	}
+	return variable;
+}
+
+static struct mcc_tac_instruction arithmetic(enum mcc_tac_op op, uint32_t result, uint32_t a, uint32_t b)
+{
+	return (struct mcc_tac_instruction){
+	    .op = op,
+	    .type = MCC_TAC_TYPE_INT,
+	    .result = result,
+	    .arg1 = a,
+	    .arg2 = b,
+	};
+}
+
+// Introduces the derived induction variable `basic` times `factor`, computed
+// in the preheader before `index` and updated after each step of `basic`.
+// Returns 0 on allocation failure.
+static uint32_t derive(struct strength *strength, size_t index, uint32_t basic, struct operand factor)
+{
+	struct mcc_tac_function *function = strength->function;
+	struct operand step;
+	bool subtracted;
+	bool basic_ok = is_basic(strength, basic, &step, &subtracted);
+	assert(basic_ok);
+	(void)basic_ok;
+
+	uint32_t variable = mcc_tac_function_new_variable(function, MCC_TAC_TYPE_INT).identifier;
+	uint32_t factor_variable = materialise(strength, index, factor);
+	if (variable == 0 || factor_variable == 0 ||
+	    !insert(strength, index, arithmetic(MCC_TAC_OP_MUL, variable, basic, factor_variable))) {
+		return 0;
+	}
+
+	uint32_t increment;
+	if (step.constant && factor.constant) {
+		struct operand product = {
+		    .constant = true,
+		    .value = (int32_t)((uint32_t)step.value * (uint32_t)factor.value),
+		};
+		increment = materialise(strength, index, product);
+	} else {
+		increment = mcc_tac_function_new_variable(function, MCC_TAC_TYPE_INT).identifier;
+		uint32_t step_variable = materialise(strength, index, step);
+		if (increment == 0 || step_variable == 0 ||
+		    !insert(strength, index, arithmetic(MCC_TAC_OP_MUL, increment, step_variable, factor_variable))) {
+			return 0;
+		}
+	}
+
+	uint32_t update = strength->loop_definition_instructions[basic] + 1;
+	enum mcc_tac_op op = subtracted ? MCC_TAC_OP_SUB : MCC_TAC_OP_ADD;
+	if (increment == 0 || !insert(strength, update, arithmetic(op, variable, variable, increment))) {
+		return 0;
+	}
+
+	struct derived derived = {.basic = basic, .factor = factor, .variable = variable};
+	if (!mcc_array_push(strength->derived, strength->derived_count, strength->derived_capacity, derived)) {
+		return 0;
+	}
+	strength->variables++;
+	return variable;
+}
+
+// Replaces multiplication `i` by a derived induction variable if it is one.
+// Returns false on allocation failure.
+static bool reduce(struct strength *strength, size_t preheader_index, size_t i)
+{
+	const struct mcc_tac_instruction *instruction = &strength->function->instructions[i];
+	uint32_t operands[2] = {instruction->arg1, instruction->arg2};
+	for (int o = 0; o < 2; o++) {
+		uint32_t basic = operands[o];
+		struct operand factor, step;
+		bool subtracted;
+		if (operands[1 - o] == basic || !is_basic(strength, basic, &step, &subtracted) ||
+		    !is_invariant(strength, operands[1 - o], i, &factor)) {
+			continue;
+		}
+
+		uint32_t variable = 0;
+		for (size_t d = 0; d < strength->derived_count; d++) {
+			if (strength->derived[d].basic == basic &&
+			    operands_equal(strength->derived[d].factor, factor)) {
+				variable = strength->derived[d].variable;
+			}
+		}
+		if (variable == 0) {
+			variable = derive(strength, preheader_index, basic, factor);
+		}
+		struct rewrite rewrite = {.index = i, .variable = variable};
+		return variable != 0 &&
+		       mcc_array_push(strength->rewrites, strength->rewrites_count, strength->rewrites_capacity,
+		                      rewrite);
+	}
+	return true;
+}
+
+// Returns whether `block` runs in every iteration of `loop`, that is it
+// dominates the sources of all back edges.
+static bool runs_every_iteration(const struct strength *strength, uint32_t loop, uint32_t block)
+{
+	uint32_t header = strength->loops.loops[loop].header;
+	const uint32_t *predecessors = mcc_cfg_block_predecessors(&strength->cfg, header);
+	for (uint32_t p = 0; p < strength->cfg.blocks[header].predecessors_count; p++) {
+		if (mcc_loops_contains(&strength->loops, loop, predecessors[p]) &&
+		    !mcc_cfg_dominates(&strength->cfg, block, predecessors[p])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool reduce_loop(struct strength *strength, uint32_t loop)
+{
+	struct mcc_tac_function *function = strength->function;
+	uint32_t preheader = mcc_loops_preheader(&strength->loops, &strength->cfg, function, loop);
+	if (preheader == MCC_CFG_NONE) {
+		return true;
+	}
+	const struct mcc_cfg_block *preheader_block = &strength->cfg.blocks[preheader];
+	size_t last = mcc_cfg_block_last_instruction(function, preheader_block);
+	bool jumps = last < preheader_block->end && function->instructions[last].op == MCC_TAC_OP_JUMP;
+	size_t preheader_index = jumps ? last : preheader_block->end;
+
+	mcc_loops_count_definitions(&strength->loops, &strength->cfg, strength->function, loop, false,
+	                            strength->loop_definitions, strength->loop_definition_instructions);
+	strength->derived_count = 0;
+
+	bool ok = true;
+	const uint32_t *blocks = mcc_loops_blocks(&strength->loops, loop);
+	for (uint32_t b = 0; ok && b < strength->loops.loops[loop].blocks_count; b++) {
+		if (strength->loops.block_loops[blocks[b]] != loop ||
+		    !runs_every_iteration(strength, loop, blocks[b])) {
+			continue;
+		}
+		const struct mcc_cfg_block *block = &strength->cfg.blocks[blocks[b]];
+		for (size_t i = block->begin; ok && i < block->end; i++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[i];
+			if (instruction->op == MCC_TAC_OP_MUL && instruction->type == MCC_TAC_TYPE_INT) {
+				ok = reduce(strength, preheader_index, i);
+			}
+		}
+	}
+
+	mcc_loops_count_definitions(&strength->loops, &strength->cfg, strength->function, loop, true,
+	                            strength->loop_definitions, strength->loop_definition_instructions);
+	return ok;
+}
+
+static int compare_insertions(const void *a, const void *b)
+{
+	const struct insertion *x = a;
+	const struct insertion *y = b;
+	if (x->index != y->index) {
+		return x->index < y->index ? -1 : 1;
+	}
+	return x->sequence < y->sequence ? -1 : x->sequence > y->sequence;
+}
+
+// Replaces the multiplications and inserts the new instructions, in batches
+// from back to front.
+static bool apply(struct strength *strength)
+{
+	struct mcc_tac_function *function = strength->function;
+	size_t count = strength->insertions_count;
+	if (count == 0) {
+		return true;
+	}
+	struct mcc_tac_instruction *instructions = malloc(count * sizeof(*instructions));
+	if (!instructions || !mcc_tac_function_reserve(function, function->instructions_count + count)) {
+		free(instructions);
+		return false;
+	}
+
+	for (size_t r = 0; r < strength->rewrites_count; r++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[strength->rewrites[r].index];
+		*instruction = (struct mcc_tac_instruction){
+		    .op = MCC_TAC_OP_ASSIGN,
+		    .type = MCC_TAC_TYPE_INT,
+		    .result = instruction->result,
+		    .arg1 = strength->rewrites[r].variable,
+		};
+	}
+
+	qsort(strength->insertions, count, sizeof(*strength->insertions), compare_insertions);
+	for (size_t k = 0; k < count; k++) {
+		instructions[k] = strength->insertions[k].instruction;
+	}
+	for (size_t end = count; end > 0;) {
+		size_t begin = end - 1;
+		while (begin > 0 && strength->insertions[begin - 1].index == strength->insertions[end - 1].index) {
+			begin--;
+		}
+		bool inserted = mcc_tac_function_insert(function, strength->insertions[begin].index,
+		                                        &instructions[begin], end - begin);
+		assert(inserted);
+		(void)inserted;
+		end = begin;
+	}
+
+	free(instructions);
+	return true;
+}
+
+bool mcc_strength_reduce_function(struct mcc_tac_function *function, struct mcc_strength_stats *stats)
+{
+	assert(function);
+
+	if (!mcc_loops_insert_preheaders(function, NULL)) {
+		return false;
+	}
+
+	struct strength strength = {.function = function};
+	bool ok = strength_init(&strength);
+	for (uint32_t l = 0; ok && l < strength.loops.loops_count; l++) {
+		ok = reduce_loop(&strength, l);
+	}
+	ok = ok && apply(&strength);
+
+	if (ok && stats) {
+		stats->reduced += strength.rewrites_count;
+		stats->variables += strength.variables;
+	}
+	strength_deinit(&strength);
+	return ok;
+}
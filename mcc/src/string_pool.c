@@ -0,0 +1,120 @@
+#include "mcc/string_pool.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY 64
+
+// FNV-1a, see http://www.isthe.com/chongo/tech/comp/fnv/index.html
+static uint64_t hash_string(const char *s, size_t length)
+{
+	uint64_t hash = UINT64_C(14695981039346656037);
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char)s[i];
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+static bool slot_matches(const char *slot, const char *s, size_t length)
+{
+	return strncmp(slot, s, length) == 0 && slot[length] == '\0';
+}
+
+static size_t find_slot(char *const *slots, size_t capacity, const char *s, size_t length)
+{
+	assert(capacity > 0);
+
+	size_t mask = capacity - 1;
+	size_t index = hash_string(s, length) & mask;
+	while (slots[index] && !slot_matches(slots[index], s, length)) {
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+static bool grow_slots(struct mcc_string_pool *pool)
+{
+	assert(pool);
+
+	size_t new_capacity = pool->capacity ? pool->capacity * 2 : INITIAL_CAPACITY;
+	char **new_slots = calloc(new_capacity, sizeof(*new_slots));
+	if (!new_slots) {
+		return false;
+	}
+	pool->allocations++;
+
+	for (size_t i = 0; i < pool->capacity; i++) {
+		char *s = pool->slots[i];
+		if (s) {
+			new_slots[find_slot(new_slots, new_capacity, s, strlen(s))] = s;
+		}
+	}
+
+	free(pool->slots);
+	pool->slots = new_slots;
+	pool->capacity = new_capacity;
+	return true;
+}
+
+void mcc_string_pool_init(struct mcc_string_pool *pool)
+{
+	assert(pool);
+
+	*pool = (struct mcc_string_pool){0};
+}
+
+void mcc_string_pool_deinit(struct mcc_string_pool *pool)
+{
+	if (!pool) {
+		return;
+	}
+
+	for (size_t i = 0; i < pool->capacity; i++) {
+		free(pool->slots[i]);
+	}
+	free(pool->slots);
+
+	*pool = (struct mcc_string_pool){0};
+}
+
+const char *mcc_string_pool_intern(struct mcc_string_pool *pool, const char *s, size_t length)
+{
+	assert(pool);
+	assert(s);
+
+	// Keep the load factor below 3/4 to bound probe sequences.
+	if ((pool->count + 1) * 4 > pool->capacity * 3 && !grow_slots(pool)) {
+		return NULL;
+	}
+
+	size_t index = find_slot(pool->slots, pool->capacity, s, length);
+	if (pool->slots[index]) {
+		return pool->slots[index];
+	}
+
+	char *copy = strndup(s, length);
+	if (!copy) {
+		return NULL;
+	}
+	pool->allocations++;
+
+	pool->slots[index] = copy;
+	pool->count++;
+	pool->bytes += length + 1;
+	return copy;
+}
+
+const char *mcc_string_pool_find(const struct mcc_string_pool *pool, const char *s, size_t length)
+{
+	assert(pool);
+	assert(s);
+
+	if (pool->count == 0) {
+		return NULL;
+	}
+	return pool->slots[find_slot(pool->slots, pool->capacity, s, length)];
+}
@@ -0,0 +1,151 @@
+#include "mcc/symbol_table.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "array.h"
+
+#define INITIAL_CAPACITY 64
+
+// Names are interned, their addresses serve as keys. Fibonacci hashing
+// spreads the (aligned) addresses over the table.
+static size_t hash_name(const char *name)
+{
+	return (size_t)(((uint64_t)(uintptr_t)name * UINT64_C(11400714819323198485)) >> 32);
+}
+
+static size_t find_slot(const struct mcc_symbol_table_slot *slots, size_t capacity, const char *name)
+{
+	assert(capacity > 0);
+
+	size_t mask = capacity - 1;
+	size_t index = hash_name(name) & mask;
+	while (slots[index].name && slots[index].name != name) {
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+static bool grow_slots(struct mcc_symbol_table *table)
+{
+	assert(table);
+
+	size_t new_capacity = table->slots_capacity ? table->slots_capacity * 2 : INITIAL_CAPACITY;
+	struct mcc_symbol_table_slot *new_slots = calloc(new_capacity, sizeof(*new_slots));
+	if (!new_slots) {
+		return false;
+	}
+
+	for (size_t i = 0; i < table->slots_capacity; i++) {
+		const struct mcc_symbol_table_slot *slot = &table->slots[i];
+		if (slot->name) {
+			new_slots[find_slot(new_slots, new_capacity, slot->name)] = *slot;
+		}
+	}
+
+	free(table->slots);
+	table->slots = new_slots;
+	table->slots_capacity = new_capacity;
+	return true;
+}
+
+void mcc_symbol_table_init(struct mcc_symbol_table *table)
+{
+	assert(table);
+
+	*table = (struct mcc_symbol_table){0};
+}
+
+void mcc_symbol_table_deinit(struct mcc_symbol_table *table)
+{
+	if (!table) {
+		return;
+	}
+
+	free(table->slots);
+	free(table->entries);
+	free(table->scopes);
+
+	*table = (struct mcc_symbol_table){0};
+}
+
+bool mcc_symbol_table_enter_scope(struct mcc_symbol_table *table)
+{
+	assert(table);
+
+	return mcc_array_push(table->scopes, table->scopes_count, table->scopes_capacity, table->entries_count);
+}
+
+void mcc_symbol_table_exit_scope(struct mcc_symbol_table *table)
+{
+	assert(table);
+	assert(table->scopes_count > 0);
+
+	size_t mark = table->scopes[--table->scopes_count];
+
+	// Undo the scope's declarations in reverse, restoring shadowed ones.
+	while (table->entries_count > mark) {
+		const struct mcc_symbol_table_entry *entry = &table->entries[--table->entries_count];
+		size_t index = find_slot(table->slots, table->slots_capacity, entry->symbol.name);
+		table->slots[index].top = entry->shadowed;
+	}
+}
+
+size_t mcc_symbol_table_scope(const struct mcc_symbol_table *table)
+{
+	assert(table);
+
+	return table->scopes_count;
+}
+
+enum mcc_symbol_table_error mcc_symbol_table_declare(struct mcc_symbol_table *table, struct mcc_symbol symbol)
+{
+	assert(table);
+	assert(symbol.name);
+
+	// Keep the load factor below 3/4 to bound probe sequences.
+	if ((table->slots_count + 1) * 4 > table->slots_capacity * 3 && !grow_slots(table)) {
+		return MCC_SYMBOL_TABLE_ERROR_ALLOCATION_ERROR;
+	}
+
+	struct mcc_symbol_table_slot *slot = &table->slots[find_slot(table->slots, table->slots_capacity, symbol.name)];
+	if (slot->name && slot->top != MCC_SYMBOL_TABLE_NONE &&
+	    table->entries[slot->top].symbol.scope == table->scopes_count) {
+		return MCC_SYMBOL_TABLE_ERROR_REDECLARATION;
+	}
+
+	symbol.scope = table->scopes_count;
+	struct mcc_symbol_table_entry entry = {
+	    .symbol = symbol,
+	    .shadowed = slot->name ? slot->top : MCC_SYMBOL_TABLE_NONE,
+	};
+	if (!mcc_array_push(table->entries, table->entries_count, table->entries_capacity, entry)) {
+		return MCC_SYMBOL_TABLE_ERROR_ALLOCATION_ERROR;
+	}
+
+	if (!slot->name) {
+		slot->name = symbol.name;
+		table->slots_count++;
+	}
+	slot->top = table->entries_count - 1;
+
+	return MCC_SYMBOL_TABLE_ERROR_NONE;
+}
+
+const struct mcc_symbol *mcc_symbol_table_lookup(const struct mcc_symbol_table *table, const char *name)
+{
+	assert(table);
+	assert(name);
+
+	if (table->slots_capacity == 0) {
+		return NULL;
+	}
+
+	const struct mcc_symbol_table_slot *slot = &table->slots[find_slot(table->slots, table->slots_capacity, name)];
+	if (!slot->name || slot->top == MCC_SYMBOL_TABLE_NONE) {
+		return NULL;
+	}
+	return &table->entries[slot->top].symbol;
+}
@@ -0,0 +1,703 @@
+#include "mcc/tac.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+
+const char *mcc_tac_type_to_string(enum mcc_tac_type type)
+{
+	switch (type) {
+	case MCC_TAC_TYPE_VOID:
+		return "void";
+	case MCC_TAC_TYPE_BOOL:
+		return "bool";
+	case MCC_TAC_TYPE_INT:
+		return "int";
+	case MCC_TAC_TYPE_FLOAT:
+		return "float";
+	case MCC_TAC_TYPE_STRING:
+		return "string";
+	case MCC_TAC_TYPE_ARRAY:
+		return "array";
+	}
+
+	assert(false);
+	return "INVALID";
+}
+
+const char *mcc_tac_op_to_string(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_NOP:
+		return "NOP";
+	case MCC_TAC_OP_CONST:
+		return "CONST";
+	case MCC_TAC_OP_ASSIGN:
+		return "ASSIGN";
+	case MCC_TAC_OP_ADD:
+		return "ADD";
+	case MCC_TAC_OP_SUB:
+		return "SUB";
+	case MCC_TAC_OP_MUL:
+		return "MUL";
+	case MCC_TAC_OP_DIV:
+		return "DIV";
+	case MCC_TAC_OP_NEG:
+		return "NEG";
+	case MCC_TAC_OP_EQ:
+		return "EQ";
+	case MCC_TAC_OP_NE:
+		return "NE";
+	case MCC_TAC_OP_LT:
+		return "LT";
+	case MCC_TAC_OP_LE:
+		return "LE";
+	case MCC_TAC_OP_GT:
+		return "GT";
+	case MCC_TAC_OP_GE:
+		return "GE";
+	case MCC_TAC_OP_AND:
+		return "AND";
+	case MCC_TAC_OP_OR:
+		return "OR";
+	case MCC_TAC_OP_NOT:
+		return "NOT";
+	case MCC_TAC_OP_ARRAY:
+		return "ARRAY";
+	case MCC_TAC_OP_LOAD:
+		return "LOAD";
+	case MCC_TAC_OP_STORE:
+		return "STORE";
+	case MCC_TAC_OP_LABEL:
+		return "LABEL";
+	case MCC_TAC_OP_JUMP:
+		return "JUMP";
+	case MCC_TAC_OP_JUMP_IF:
+		return "JUMP_IF";
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		return "JUMP_IF_NOT";
+	case MCC_TAC_OP_PARAM:
+		return "PARAM";
+	case MCC_TAC_OP_CALL:
+		return "CALL";
+	case MCC_TAC_OP_RETURN:
+		return "RETURN";
+	case MCC_TAC_OP_PHI:
+		return "PHI";
+	}
+
+	assert(false);
+	return "INVALID";
+}
+
+bool mcc_tac_op_defines_result(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_NOP:
+	case MCC_TAC_OP_STORE:
+	case MCC_TAC_OP_LABEL:
+	case MCC_TAC_OP_JUMP:
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT:
+	case MCC_TAC_OP_RETURN:
+		return false;
+	default:
+		return true;
+	}
+}
+
+uint64_t mcc_tac_int_bits(long value)
+{
+	return (uint64_t)value;
+}
+
+uint64_t mcc_tac_float_bits(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+long mcc_tac_bits_int(uint64_t bits)
+{
+	return (long)bits;
+}
+
+double mcc_tac_bits_float(uint64_t bits)
+{
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// ------------------------------------------------------------------ Function
+
+_Static_assert(sizeof(double) == sizeof(uint64_t), "float constants are stored as 64-bit patterns");
+
+void mcc_tac_function_deinit(struct mcc_tac_function *function)
+{
+	if (!function) {
+		return;
+	}
+
+	free(function->instructions);
+	free(function->variable_types);
+	free(function->constants);
+	free(function->strings);
+	free(function->operands);
+}
+
+struct mcc_tac_variable mcc_tac_function_new_variable(struct mcc_tac_function *function, enum mcc_tac_type type)
+{
+	assert(function);
+	assert(type != MCC_TAC_TYPE_VOID);
+
+	// Entry 0 stands for the unused variable.
+	size_t count = (size_t)function->variables_count + 1;
+	if (function->variables_count == UINT32_MAX ||
+	    !mcc_array_reserve(&function->variable_types, &function->variable_types_capacity, count,
+	                       sizeof(*function->variable_types))) {
+		return (struct mcc_tac_variable){0};
+	}
+
+	function->variable_types[0] = MCC_TAC_TYPE_VOID;
+	function->variable_types[count] = (uint8_t)type;
+	function->variables_count++;
+	return (struct mcc_tac_variable){
+	    .type = type,
+	    .identifier = function->variables_count,
+	};
+}
+
+uint32_t mcc_tac_function_new_label(struct mcc_tac_function *function)
+{
+	assert(function);
+	assert(function->labels_count < UINT32_MAX);
+
+	return ++function->labels_count;
+}
+
+bool mcc_tac_function_add_constant(struct mcc_tac_function *function, uint64_t bits, uint32_t *index)
+{
+	assert(function);
+	assert(index);
+
+	if (function->constants_count == UINT32_MAX ||
+	    !mcc_array_push(function->constants, function->constants_count, function->constants_capacity, bits)) {
+		return false;
+	}
+	*index = (uint32_t)(function->constants_count - 1);
+	return true;
+}
+
+bool mcc_tac_function_add_string(struct mcc_tac_function *function, const char *string, uint32_t *index)
+{
+	assert(function);
+	assert(string);
+	assert(index);
+
+	if (function->strings_count == UINT32_MAX ||
+	    !mcc_array_push(function->strings, function->strings_count, function->strings_capacity, string)) {
+		return false;
+	}
+	*index = (uint32_t)(function->strings_count - 1);
+	return true;
+}
+
+bool mcc_tac_function_add_operands(struct mcc_tac_function *function,
+                                   const uint32_t *operands,
+                                   size_t count,
+                                   uint32_t *index)
+{
+	assert(function);
+	assert(operands || count == 0);
+	assert(index);
+
+	size_t start = function->operands_count;
+	if (count > UINT32_MAX - start) {
+		return false;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (!mcc_array_push(function->operands, function->operands_count, function->operands_capacity,
+		                    operands[i])) {
+			function->operands_count = start;
+			return false;
+		}
+	}
+	*index = (uint32_t)start;
+	return true;
+}
+
+enum mcc_tac_type mcc_tac_function_variable_type(const struct mcc_tac_function *function, uint32_t variable)
+{
+	assert(function);
+	assert(variable <= function->variables_count);
+
+	return variable == 0 ? MCC_TAC_TYPE_VOID : (enum mcc_tac_type)function->variable_types[variable];
+}
+
+bool mcc_tac_function_creates_arrays(const struct mcc_tac_function *function)
+{
+	assert(function);
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (function->instructions[i].op == MCC_TAC_OP_ARRAY) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool mcc_tac_function_reserve(struct mcc_tac_function *function, size_t count)
+{
+	assert(function);
+
+	if (count <= function->instructions_capacity) {
+		return true;
+	}
+
+	struct mcc_tac_instruction *instructions =
+	    realloc(function->instructions, count * sizeof(*function->instructions));
+	if (!instructions) {
+		return false;
+	}
+
+	function->instructions = instructions;
+	function->instructions_capacity = count;
+	return true;
+}
+
+bool mcc_tac_function_append(struct mcc_tac_function *function, struct mcc_tac_instruction instruction)
+{
+	assert(function);
+
+	return mcc_array_push(function->instructions, function->instructions_count, function->instructions_capacity,
+	                      instruction);
+}
+
+bool mcc_tac_function_insert(struct mcc_tac_function *function,
+                             size_t index,
+                             const struct mcc_tac_instruction *instructions,
+                             size_t count)
+{
+	assert(function);
+	assert(index <= function->instructions_count);
+	assert(instructions || count == 0);
+
+	size_t required = function->instructions_count + count;
+	if (required > function->instructions_capacity) {
+		size_t capacity = function->instructions_capacity ? function->instructions_capacity : 1;
+		while (capacity < required) {
+			capacity *= 2;
+		}
+		if (!mcc_tac_function_reserve(function, capacity)) {
+			return false;
+		}
+	}
+
+	struct mcc_tac_instruction *at = function->instructions + index;
+	memmove(at + count, at, (function->instructions_count - index) * sizeof(*at));
+	memcpy(at, instructions, count * sizeof(*at));
+	function->instructions_count += count;
+
+	for (size_t i = 0; i < count; i++) {
+		if (instructions[i].op == MCC_TAC_OP_NOP) {
+			function->removed_count++;
+		}
+	}
+	return true;
+}
+
+void mcc_tac_function_remove(struct mcc_tac_function *function, size_t index)
+{
+	assert(function);
+	assert(index < function->instructions_count);
+
+	struct mcc_tac_instruction *instruction = &function->instructions[index];
+	if (instruction->op != MCC_TAC_OP_NOP) {
+		*instruction = (struct mcc_tac_instruction){.op = MCC_TAC_OP_NOP};
+		function->removed_count++;
+	}
+}
+
+void mcc_tac_function_compact(struct mcc_tac_function *function)
+{
+	assert(function);
+
+	if (function->removed_count == 0) {
+		return;
+	}
+
+	size_t count = 0;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (function->instructions[i].op != MCC_TAC_OP_NOP) {
+			function->instructions[count++] = function->instructions[i];
+		}
+	}
+
+	function->instructions_count = count;
+	function->removed_count = 0;
+}
+
+uint32_t mcc_tac_instruction_definition(const struct mcc_tac_instruction *instruction)
+{
+	assert(instruction);
+
+	return mcc_tac_op_defines_result(instruction->op) ? instruction->result : 0;
+}
+
+void mcc_tac_function_visit_uses(struct mcc_tac_function *function,
+                                 struct mcc_tac_instruction *instruction,
+                                 mcc_tac_use_callback callback,
+                                 void *userdata)
+{
+	assert(function);
+	assert(instruction);
+	assert(callback);
+
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_NOP:
+	case MCC_TAC_OP_CONST:
+	case MCC_TAC_OP_ARRAY:
+	case MCC_TAC_OP_LABEL:
+	case MCC_TAC_OP_JUMP:
+	case MCC_TAC_OP_PARAM:
+		break;
+
+	case MCC_TAC_OP_ASSIGN:
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_NOT:
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		callback(&instruction->arg1, userdata);
+		break;
+
+	case MCC_TAC_OP_CALL: {
+		uint32_t *arguments = &function->operands[instruction->arg2];
+		for (uint32_t i = 1; i <= arguments[0]; i++) {
+			callback(&arguments[i], userdata);
+		}
+		break;
+	}
+
+	case MCC_TAC_OP_RETURN:
+		if (instruction->arg1 != 0) {
+			callback(&instruction->arg1, userdata);
+		}
+		break;
+
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+	case MCC_TAC_OP_LOAD:
+		callback(&instruction->arg1, userdata);
+		callback(&instruction->arg2, userdata);
+		break;
+
+	case MCC_TAC_OP_STORE:
+		callback(&instruction->result, userdata);
+		callback(&instruction->arg1, userdata);
+		callback(&instruction->arg2, userdata);
+		break;
+
+	case MCC_TAC_OP_PHI:
+		for (uint32_t i = 0; i < instruction->arg2; i++) {
+			callback(&function->operands[instruction->arg1 + 2 * i + 1], userdata);
+		}
+		break;
+	}
+}
+
+// ------------------------------------------------------------------- Program
+
+void mcc_tac_program_init(struct mcc_tac_program *program)
+{
+	assert(program);
+
+	*program = (struct mcc_tac_program){0};
+	mcc_string_pool_init(&program->strings);
+}
+
+void mcc_tac_program_deinit(struct mcc_tac_program *program)
+{
+	assert(program);
+
+	for (size_t i = 0; i < program->functions_count; i++) {
+		mcc_tac_function_deinit(&program->functions[i]);
+	}
+	free(program->functions);
+	mcc_string_pool_deinit(&program->strings);
+}
+
+struct mcc_tac_function *mcc_tac_program_add_function(struct mcc_tac_program *program,
+                                                      const char *name,
+                                                      enum mcc_tac_type return_type)
+{
+	assert(program);
+	assert(name);
+
+	struct mcc_tac_function function = {
+	    .name = mcc_string_pool_intern(&program->strings, name, strlen(name)),
+	    .return_type = return_type,
+	};
+	if (!function.name) {
+		return NULL;
+	}
+
+	if (!mcc_array_push(program->functions, program->functions_count, program->functions_capacity, function)) {
+		return NULL;
+	}
+	return &program->functions[program->functions_count - 1];
+}
+
+const struct mcc_tac_function *mcc_tac_program_find_function(const struct mcc_tac_program *program,
+                                                             const char *name)
+{
+	assert(program);
+	assert(name);
+
+	for (size_t i = 0; i < program->functions_count; i++) {
+		if (strcmp(program->functions[i].name, name) == 0) {
+			return &program->functions[i];
+		}
+	}
+	return NULL;
+}
+
+// ------------------------------------------------------------------ Printing
+
+static void print_variable(FILE *out, uint32_t variable)
+{
+	fprintf(out, "v%" PRIu32, variable);
+}
+
+// Floats are printed with full precision and always contain a '.' or an
+// exponent, telling them apart from ints.
+static void print_float(FILE *out, double value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.17g", value);
+	fputs(buffer, out);
+	if (!strpbrk(buffer, ".eni")) {
+		fputs(".0", out);
+	}
+}
+
+static void print_string(FILE *out, const char *s)
+{
+	fputc('"', out);
+	for (; *s; s++) {
+		switch (*s) {
+		case '"':
+			fputs("\\\"", out);
+			break;
+		case '\\':
+			fputs("\\\\", out);
+			break;
+		case '\n':
+			fputs("\\n", out);
+			break;
+		case '\t':
+			fputs("\\t", out);
+			break;
+		default:
+			fputc(*s, out);
+			break;
+		}
+	}
+	fputc('"', out);
+}
+
+static void print_constant(FILE *out,
+                           const struct mcc_tac_function *function,
+                           const struct mcc_tac_instruction *instruction)
+{
+	if (instruction->type == MCC_TAC_TYPE_STRING) {
+		print_string(out, function->strings[instruction->arg1]);
+		return;
+	}
+
+	uint64_t bits = function->constants[instruction->arg1];
+	switch (instruction->type) {
+	case MCC_TAC_TYPE_BOOL:
+		fputs(bits ? "true" : "false", out);
+		break;
+	case MCC_TAC_TYPE_INT:
+		fprintf(out, "%ld", mcc_tac_bits_int(bits));
+		break;
+	case MCC_TAC_TYPE_FLOAT:
+		print_float(out, mcc_tac_bits_float(bits));
+		break;
+	case MCC_TAC_TYPE_VOID:
+	case MCC_TAC_TYPE_STRING:
+	case MCC_TAC_TYPE_ARRAY:
+		assert(false);
+		break;
+	}
+}
+
+// Instructions print as `[result =] OP type operands`, the type is omitted for
+// control flow.
+static void print_instruction(FILE *out,
+                              const struct mcc_tac_function *function,
+                              const struct mcc_tac_instruction *instruction)
+{
+	enum mcc_tac_op op = instruction->op;
+
+	if (op == MCC_TAC_OP_LABEL) {
+		fprintf(out, "L%" PRIu32 ":\n", instruction->arg2);
+		return;
+	}
+
+	fputc('\t', out);
+	if (mcc_tac_op_defines_result(op) && instruction->result != 0) {
+		print_variable(out, instruction->result);
+		fputs(" = ", out);
+	}
+	fputs(mcc_tac_op_to_string(op), out);
+	if (op < MCC_TAC_OP_LABEL || op > MCC_TAC_OP_JUMP_IF_NOT) {
+		fprintf(out, " %s", mcc_tac_type_to_string(instruction->type));
+	}
+
+	switch (op) {
+	case MCC_TAC_OP_CONST:
+		fputc(' ', out);
+		print_constant(out, function, instruction);
+		break;
+
+	case MCC_TAC_OP_ASSIGN:
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_NOT:
+		fputc(' ', out);
+		print_variable(out, instruction->arg1);
+		break;
+
+	case MCC_TAC_OP_PARAM:
+		fprintf(out, " %" PRIu32, instruction->arg1);
+		break;
+
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+	case MCC_TAC_OP_LOAD:
+		fputc(' ', out);
+		print_variable(out, instruction->arg1);
+		fputs(", ", out);
+		print_variable(out, instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_ARRAY:
+		fprintf(out, " %ld", mcc_tac_bits_int(function->constants[instruction->arg1]));
+		break;
+
+	case MCC_TAC_OP_STORE:
+		fputc(' ', out);
+		print_variable(out, instruction->result);
+		fputs(", ", out);
+		print_variable(out, instruction->arg1);
+		fputs(", ", out);
+		print_variable(out, instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_JUMP:
+		fprintf(out, " L%" PRIu32, instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		fprintf(out, " L%" PRIu32 ", ", instruction->arg2);
+		print_variable(out, instruction->arg1);
+		break;
+
+	case MCC_TAC_OP_CALL: {
+		const uint32_t *arguments = &function->operands[instruction->arg2];
+		fprintf(out, " %s(", function->strings[instruction->arg1]);
+		for (uint32_t i = 1; i <= arguments[0]; i++) {
+			if (i > 1) {
+				fputs(", ", out);
+			}
+			print_variable(out, arguments[i]);
+		}
+		fputc(')', out);
+		break;
+	}
+
+	case MCC_TAC_OP_RETURN:
+		if (instruction->arg1 != 0) {
+			fputc(' ', out);
+			print_variable(out, instruction->arg1);
+		}
+		break;
+
+	case MCC_TAC_OP_PHI:
+		for (uint32_t i = 0; i < instruction->arg2; i++) {
+			const uint32_t *pair = &function->operands[instruction->arg1 + 2 * i];
+			fprintf(out, "%s [L%" PRIu32 ", ", i > 0 ? "," : "", pair[0]);
+			print_variable(out, pair[1]);
+			fputc(']', out);
+		}
+		break;
+
+	case MCC_TAC_OP_NOP:
+	case MCC_TAC_OP_LABEL:
+		break;
+	}
+
+	fputc('\n', out);
+}
+
+static void print_function(FILE *out, const struct mcc_tac_function *function)
+{
+	fprintf(out, "function %s %s(%zu)\n", mcc_tac_type_to_string(function->return_type), function->name,
+	        function->parameters_count);
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (function->instructions[i].op != MCC_TAC_OP_NOP) {
+			print_instruction(out, function, &function->instructions[i]);
+		}
+	}
+}
+
+bool mcc_tac_print_function(FILE *out, const struct mcc_tac_function *function)
+{
+	assert(out);
+	assert(function);
+
+	print_function(out, function);
+	return fflush(out) == 0 && !ferror(out);
+}
+
+bool mcc_tac_print_program(FILE *out, const struct mcc_tac_program *program)
+{
+	assert(out);
+	assert(program);
+
+	for (size_t i = 0; i < program->functions_count; i++) {
+		if (i > 0) {
+			fputc('\n', out);
+		}
+		print_function(out, &program->functions[i]);
+	}
+	return fflush(out) == 0 && !ferror(out);
+}
@@ -0,0 +1,948 @@
+#include "mcc/tac_binary.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define HOST_LITTLE_ENDIAN false
+#else
+#define HOST_LITTLE_ENDIAN true
+#endif
+
+static const char magic[8] = "MCCTAC\0";
+
+#define IMAGE_HEADER_SIZE 16
+
+// The record's size, the length of the function's name, its return type,
+// flags, and the counts listed in `struct record`.
+#define RECORD_HEADER_SIZE 64
+
+#define RECORD_HAS_CFG 1
+
+// Each block is stored as nine 32-bit integers, see `encode_cfg`.
+#define BLOCK_SIZE 36
+
+_Static_assert(offsetof(struct mcc_tac_instruction, result) == 4 && offsetof(struct mcc_tac_instruction, arg1) == 8 &&
+                   offsetof(struct mcc_tac_instruction, arg2) == 12,
+               "instructions are copied as is on little-endian hosts");
+
+struct record {
+	uint32_t name_length;
+	uint8_t return_type;
+	uint8_t flags;
+
+	uint32_t parameters_count;
+	uint32_t variables_count;
+	uint32_t labels_count;
+	uint32_t instructions_count;
+	uint32_t constants_count;
+	uint32_t operands_count;
+	uint32_t strings_count;
+	uint32_t strings_size; // including terminators
+	uint32_t blocks_count;
+	uint32_t predecessors_count;
+	uint32_t order_count;
+};
+
+static size_t padding(size_t size)
+{
+	return (8 - size % 8) % 8;
+}
+
+static void store_u32(uint8_t *bytes, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) {
+		bytes[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+static void store_u64(uint8_t *bytes, uint64_t value)
+{
+	for (int i = 0; i < 8; i++) {
+		bytes[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+static uint32_t load_u32(const uint8_t *bytes)
+{
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++) {
+		value |= (uint32_t)bytes[i] << (8 * i);
+	}
+	return value;
+}
+
+static uint64_t load_u64(const uint8_t *bytes)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++) {
+		value |= (uint64_t)bytes[i] << (8 * i);
+	}
+	return value;
+}
+
+// ------------------------------------------------------------------ Encoding
+
+// Allocation failures are sticky, like in the TAC builder.
+struct buffer {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+	bool failed;
+};
+
+// Appends `size` zeroed bytes, `size` must not be 0. Returns NULL on
+// allocation failure.
+static uint8_t *append(struct buffer *buffer, size_t size)
+{
+	assert(size > 0);
+
+	if (buffer->failed) {
+		return NULL;
+	}
+
+	if (size > buffer->capacity - buffer->size) {
+		size_t capacity = buffer->capacity ? buffer->capacity : 256;
+		while (size > capacity - buffer->size && capacity <= SIZE_MAX / 2) {
+			capacity *= 2;
+		}
+		uint8_t *data = size <= capacity - buffer->size ? realloc(buffer->data, capacity) : NULL;
+		if (!data) {
+			buffer->failed = true;
+			return NULL;
+		}
+		buffer->data = data;
+		buffer->capacity = capacity;
+	}
+
+	uint8_t *bytes = buffer->data + buffer->size;
+	memset(bytes, 0, size);
+	buffer->size += size;
+	return bytes;
+}
+
+static void pad(struct buffer *buffer)
+{
+	if (padding(buffer->size) > 0) {
+		append(buffer, padding(buffer->size));
+	}
+}
+
+static void put_bytes(struct buffer *buffer, const void *data, size_t size)
+{
+	uint8_t *bytes = size > 0 ? append(buffer, size) : NULL;
+	if (bytes) {
+		memcpy(bytes, data, size);
+	}
+}
+
+static void put_u32(struct buffer *buffer, uint32_t value)
+{
+	uint8_t *bytes = append(buffer, 4);
+	if (bytes) {
+		store_u32(bytes, value);
+	}
+}
+
+static void put_u32s(struct buffer *buffer, const uint32_t *values, size_t count)
+{
+	uint8_t *bytes = count > 0 ? append(buffer, count * 4) : NULL;
+	if (!bytes) {
+		return;
+	}
+
+	if (HOST_LITTLE_ENDIAN) {
+		memcpy(bytes, values, count * 4);
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			store_u32(bytes + 4 * i, values[i]);
+		}
+	}
+}
+
+static void put_u64s(struct buffer *buffer, const uint64_t *values, size_t count)
+{
+	uint8_t *bytes = count > 0 ? append(buffer, count * 8) : NULL;
+	if (!bytes) {
+		return;
+	}
+
+	if (HOST_LITTLE_ENDIAN) {
+		memcpy(bytes, values, count * 8);
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			store_u64(bytes + 8 * i, values[i]);
+		}
+	}
+}
+
+// Instructions are stored field by field, leaving their padding zeroed.
+static void put_instructions(struct buffer *buffer, const struct mcc_tac_instruction *instructions, size_t count)
+{
+	uint8_t *bytes = count > 0 ? append(buffer, count * sizeof(*instructions)) : NULL;
+	if (!bytes) {
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++, bytes += sizeof(*instructions)) {
+		bytes[0] = instructions[i].op;
+		bytes[1] = instructions[i].type;
+		store_u32(bytes + 4, instructions[i].result);
+		store_u32(bytes + 8, instructions[i].arg1);
+		store_u32(bytes + 12, instructions[i].arg2);
+	}
+}
+
+static void encode_cfg(struct buffer *buffer, const struct mcc_cfg *cfg, size_t predecessors_count)
+{
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		put_u32(buffer, (uint32_t)block->begin);
+		put_u32(buffer, (uint32_t)block->end);
+		put_u32(buffer, block->successors_count > 0 ? block->successors[0] : MCC_CFG_NONE);
+		put_u32(buffer, block->successors_count > 1 ? block->successors[1] : MCC_CFG_NONE);
+		put_u32(buffer, block->successors_count);
+		put_u32(buffer, (uint32_t)block->predecessors_begin);
+		put_u32(buffer, block->predecessors_count);
+		put_u32(buffer, block->idom);
+		put_u32(buffer, block->order);
+	}
+	pad(buffer);
+
+	put_u32s(buffer, cfg->predecessors, predecessors_count);
+	pad(buffer);
+	put_u32s(buffer, cfg->order, cfg->order_count);
+	pad(buffer);
+	put_u32s(buffer, cfg->label_blocks, cfg->labels_count + 1);
+	pad(buffer);
+}
+
+static bool fits(size_t count)
+{
+	return count <= UINT32_MAX;
+}
+
+static void encode_function(struct buffer *buffer, const struct mcc_tac_function *function, const struct mcc_cfg *cfg)
+{
+	assert(!cfg || cfg->labels_count == function->labels_count);
+
+	size_t name_length = strlen(function->name);
+	size_t strings_size = 0;
+	for (size_t i = 0; i < function->strings_count; i++) {
+		strings_size += strlen(function->strings[i]) + 1;
+	}
+	size_t predecessors_count = 0;
+	for (size_t b = 0; cfg && b < cfg->blocks_count; b++) {
+		predecessors_count += cfg->blocks[b].predecessors_count;
+	}
+
+	if (!fits(name_length) || !fits(function->parameters_count) || function->variables_count == UINT32_MAX ||
+	    !fits(function->instructions_count) || !fits(function->constants_count) ||
+	    !fits(function->operands_count) || !fits(function->strings_count) || !fits(strings_size) ||
+	    (cfg && (!fits(cfg->blocks_count) || !fits(predecessors_count)))) {
+		buffer->failed = true;
+		return;
+	}
+
+	size_t start = buffer->size;
+	uint8_t *header = append(buffer, RECORD_HEADER_SIZE);
+	if (!header) {
+		return;
+	}
+
+	// The record's size is filled in at the end.
+	store_u32(header + 8, (uint32_t)name_length);
+	header[12] = (uint8_t)function->return_type;
+	header[13] = cfg ? RECORD_HAS_CFG : 0;
+	const uint32_t counts[] = {
+	    (uint32_t)function->parameters_count,
+	    function->variables_count,
+	    function->labels_count,
+	    (uint32_t)function->instructions_count,
+	    (uint32_t)function->constants_count,
+	    (uint32_t)function->operands_count,
+	    (uint32_t)function->strings_count,
+	    (uint32_t)strings_size,
+	    cfg ? (uint32_t)cfg->blocks_count : 0,
+	    (uint32_t)predecessors_count,
+	    cfg ? (uint32_t)cfg->order_count : 0,
+	};
+	for (size_t i = 0; i < sizeof(counts) / sizeof(*counts); i++) {
+		store_u32(header + 16 + 4 * i, counts[i]);
+	}
+
+	put_bytes(buffer, function->name, name_length + 1);
+	pad(buffer);
+	put_instructions(buffer, function->instructions, function->instructions_count);
+	put_u64s(buffer, function->constants, function->constants_count);
+	put_u32s(buffer, function->operands, function->operands_count);
+	pad(buffer);
+
+	// Entry 0 of the variable types stays zeroed, i.e. void.
+	uint8_t *types = append(buffer, (size_t)function->variables_count + 1);
+	if (types && function->variables_count > 0) {
+		memcpy(types + 1, function->variable_types + 1, function->variables_count);
+	}
+	pad(buffer);
+
+	for (size_t i = 0; i < function->strings_count; i++) {
+		put_u32(buffer, (uint32_t)strlen(function->strings[i]));
+	}
+	pad(buffer);
+	for (size_t i = 0; i < function->strings_count; i++) {
+		put_bytes(buffer, function->strings[i], strlen(function->strings[i]) + 1);
+	}
+	pad(buffer);
+
+	if (cfg) {
+		encode_cfg(buffer, cfg, predecessors_count);
+	}
+
+	if (!buffer->failed) {
+		store_u64(buffer->data + start, buffer->size - start);
+	}
+}
+
+bool mcc_tac_binary_write(FILE *out,
+                          const struct mcc_tac_function *functions,
+                          size_t functions_count,
+                          const struct mcc_cfg *cfgs)
+{
+	assert(out);
+	assert(functions || functions_count == 0);
+
+	if (!fits(functions_count)) {
+		return false;
+	}
+
+	struct buffer buffer = {0};
+	put_bytes(&buffer, magic, sizeof(magic));
+	put_u32(&buffer, MCC_TAC_BINARY_VERSION);
+	put_u32(&buffer, (uint32_t)functions_count);
+	for (size_t i = 0; i < functions_count; i++) {
+		encode_function(&buffer, &functions[i], cfgs ? &cfgs[i] : NULL);
+	}
+
+	bool ok = !buffer.failed && fwrite(buffer.data, 1, buffer.size, out) == buffer.size && fflush(out) == 0;
+	free(buffer.data);
+	return ok;
+}
+
+bool mcc_tac_binary_hash(const struct mcc_tac_function *function, uint64_t *hash)
+{
+	assert(function);
+	assert(hash);
+
+	struct buffer buffer = {0};
+	encode_function(&buffer, function, NULL);
+	if (buffer.failed) {
+		free(buffer.data);
+		return false;
+	}
+
+	uint64_t h = UINT64_C(14695981039346656037);
+	for (size_t i = 0; i < buffer.size; i++) {
+		h ^= buffer.data[i];
+		h *= UINT64_C(1099511628211);
+	}
+	free(buffer.data);
+
+	*hash = h;
+	return true;
+}
+
+// ------------------------------------------------------------------ Decoding
+
+struct reader {
+	const uint8_t *data;
+	size_t size;
+	size_t position;
+};
+
+// Returns the next `count` items of `item_size` bytes and skips the padding
+// following them. Returns NULL if the image is too short.
+static const uint8_t *take(struct reader *reader, size_t count, size_t item_size)
+{
+	size_t available = reader->size - reader->position;
+	if (count > available / item_size) {
+		return NULL;
+	}
+
+	size_t size = count * item_size;
+	if (padding(size) > available - size) {
+		return NULL;
+	}
+
+	const uint8_t *bytes = reader->data + reader->position;
+	reader->position += size + padding(size);
+	return bytes;
+}
+
+// The `load_*` functions copy arrays out of the image into fresh allocations
+// holding at least one element. They return false on allocation failure.
+
+static bool load_bytes(uint8_t **values, const uint8_t *bytes, size_t count)
+{
+	*values = malloc(count ? count : 1);
+	if (*values && count > 0) {
+		memcpy(*values, bytes, count);
+	}
+	return *values != NULL;
+}
+
+static bool load_u32s(uint32_t **values, const uint8_t *bytes, size_t count)
+{
+	*values = malloc((count ? count : 1) * sizeof(**values));
+	if (!*values) {
+		return false;
+	}
+
+	if (HOST_LITTLE_ENDIAN && count > 0) {
+		memcpy(*values, bytes, count * 4);
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			(*values)[i] = load_u32(bytes + 4 * i);
+		}
+	}
+	return true;
+}
+
+static bool load_u64s(uint64_t **values, const uint8_t *bytes, size_t count)
+{
+	*values = malloc((count ? count : 1) * sizeof(**values));
+	if (!*values) {
+		return false;
+	}
+
+	if (HOST_LITTLE_ENDIAN && count > 0) {
+		memcpy(*values, bytes, count * 8);
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			(*values)[i] = load_u64(bytes + 8 * i);
+		}
+	}
+	return true;
+}
+
+static bool load_instructions(struct mcc_tac_instruction **instructions, const uint8_t *bytes, size_t count)
+{
+	*instructions = malloc((count ? count : 1) * sizeof(**instructions));
+	if (!*instructions) {
+		return false;
+	}
+
+	if (HOST_LITTLE_ENDIAN && count > 0) {
+		memcpy(*instructions, bytes, count * sizeof(**instructions));
+	} else {
+		for (size_t i = 0; i < count; i++, bytes += sizeof(**instructions)) {
+			(*instructions)[i] = (struct mcc_tac_instruction){
+			    .op = bytes[0],
+			    .type = bytes[1],
+			    .result = load_u32(bytes + 4),
+			    .arg1 = load_u32(bytes + 8),
+			    .arg2 = load_u32(bytes + 12),
+			};
+		}
+	}
+	return true;
+}
+
+static void read_record_header(struct record *record, const uint8_t *header)
+{
+	record->name_length = load_u32(header + 8);
+	record->return_type = header[12];
+	record->flags = header[13];
+
+	uint32_t *counts[] = {
+	    &record->parameters_count, &record->variables_count, &record->labels_count, &record->instructions_count,
+	    &record->constants_count,  &record->operands_count,  &record->strings_count, &record->strings_size,
+	    &record->blocks_count,     &record->predecessors_count, &record->order_count,
+	};
+	for (size_t i = 0; i < sizeof(counts) / sizeof(*counts); i++) {
+		*counts[i] = load_u32(header + 16 + 4 * i);
+	}
+}
+
+// Interns the `count` strings of `lengths` and `characters` into `pool`.
+static bool read_strings(struct mcc_tac_function *function,
+                         struct mcc_string_pool *pool,
+                         const uint8_t *lengths,
+                         const uint8_t *characters,
+                         const struct record *record)
+{
+	function->strings = malloc((record->strings_count ? record->strings_count : 1) * sizeof(*function->strings));
+	if (!function->strings) {
+		return false;
+	}
+	function->strings_capacity = record->strings_count ? record->strings_count : 1;
+
+	size_t offset = 0;
+	for (size_t i = 0; i < record->strings_count; i++) {
+		size_t length = load_u32(lengths + 4 * i);
+		const char *string = (const char *)characters + offset;
+		if (length >= record->strings_size - offset || string[length] != '\0' || memchr(string, '\0', length)) {
+			return false;
+		}
+		offset += length + 1;
+
+		function->strings[i] = mcc_string_pool_intern(pool, string, length);
+		if (!function->strings[i]) {
+			return false;
+		}
+		function->strings_count++;
+	}
+	return offset == record->strings_size;
+}
+
+static bool read_cfg(struct mcc_cfg *cfg, struct reader *reader, const struct record *record)
+{
+	const uint8_t *blocks = take(reader, record->blocks_count, BLOCK_SIZE);
+	const uint8_t *predecessors = blocks ? take(reader, record->predecessors_count, 4) : NULL;
+	const uint8_t *order = predecessors ? take(reader, record->order_count, 4) : NULL;
+	const uint8_t *label_blocks = order ? take(reader, (size_t)record->labels_count + 1, 4) : NULL;
+	if (!label_blocks || record->blocks_count == 0) {
+		return false;
+	}
+
+	cfg->blocks = calloc(record->blocks_count, sizeof(*cfg->blocks));
+	if (!cfg->blocks || !load_u32s(&cfg->predecessors, predecessors, record->predecessors_count) ||
+	    !load_u32s(&cfg->order, order, record->order_count) ||
+	    !load_u32s(&cfg->label_blocks, label_blocks, (size_t)record->labels_count + 1)) {
+		return false;
+	}
+	cfg->blocks_count = record->blocks_count;
+	cfg->order_count = record->order_count;
+	cfg->labels_count = record->labels_count;
+
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		const uint8_t *fields = blocks + BLOCK_SIZE * b;
+		cfg->blocks[b] = (struct mcc_cfg_block){
+		    .begin = load_u32(fields),
+		    .end = load_u32(fields + 4),
+		    .successors = {load_u32(fields + 8), load_u32(fields + 12)},
+		    .successors_count = load_u32(fields + 16),
+		    .predecessors_begin = load_u32(fields + 20),
+		    .predecessors_count = load_u32(fields + 24),
+		    .idom = load_u32(fields + 28),
+		    .order = load_u32(fields + 32),
+		};
+	}
+	return true;
+}
+
+struct use_check {
+	uint32_t variables_count;
+	bool valid;
+};
+
+static void check_use(uint32_t *variable, void *userdata)
+{
+	struct use_check *check = userdata;
+	if (*variable == 0 || *variable > check->variables_count) {
+		check->valid = false;
+	}
+}
+
+static bool is_label(const struct mcc_tac_function *function, uint32_t label)
+{
+	return label != 0 && label <= function->labels_count;
+}
+
+// Checks that the operands of `instruction` refer to existing variables,
+// placed labels, and side table entries.
+static bool validate_instruction(struct mcc_tac_function *function,
+                                 struct mcc_tac_instruction *instruction,
+                                 const bool *placed)
+{
+	if (instruction->op > MCC_TAC_OP_PHI || instruction->type > MCC_TAC_TYPE_ARRAY) {
+		return false;
+	}
+
+	uint32_t arg1 = instruction->arg1;
+	uint32_t arg2 = instruction->arg2;
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_CONST:
+		if (instruction->type == MCC_TAC_TYPE_VOID || instruction->type == MCC_TAC_TYPE_ARRAY ||
+		    arg1 >= (instruction->type == MCC_TAC_TYPE_STRING ? function->strings_count
+		                                                      : function->constants_count)) {
+			return false;
+		}
+		break;
+
+	case MCC_TAC_OP_ARRAY:
+		if (arg1 >= function->constants_count) {
+			return false;
+		}
+		break;
+
+	case MCC_TAC_OP_LABEL:
+	case MCC_TAC_OP_JUMP:
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		if (!is_label(function, arg2) || !placed[arg2]) {
+			return false;
+		}
+		break;
+
+	case MCC_TAC_OP_PARAM:
+		if (arg1 >= function->parameters_count) {
+			return false;
+		}
+		break;
+
+	case MCC_TAC_OP_CALL:
+		if (arg1 >= function->strings_count || arg2 >= function->operands_count ||
+		    function->operands[arg2] > function->operands_count - arg2 - 1) {
+			return false;
+		}
+		break;
+
+	case MCC_TAC_OP_PHI:
+		if (arg1 > function->operands_count || arg2 > (function->operands_count - arg1) / 2) {
+			return false;
+		}
+		for (uint32_t i = 0; i < arg2; i++) {
+			if (!is_label(function, function->operands[arg1 + 2 * i])) {
+				return false;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (mcc_tac_instruction_definition(instruction) > function->variables_count) {
+		return false;
+	}
+	struct use_check check = {.variables_count = function->variables_count, .valid = true};
+	mcc_tac_function_visit_uses(function, instruction, check_use, &check);
+	return check.valid;
+}
+
+// Marks the operands used by `instruction`, which has been validated.
+// Returns false if another instruction uses some of them already: passes
+// rename operands in place, a shared range would be renamed twice.
+static bool claim_operands(const struct mcc_tac_function *function,
+                           const struct mcc_tac_instruction *instruction,
+                           bool *claimed)
+{
+	size_t begin, count;
+	if (instruction->op == MCC_TAC_OP_CALL) {
+		begin = instruction->arg2;
+		count = (size_t)function->operands[begin] + 1;
+	} else if (instruction->op == MCC_TAC_OP_PHI) {
+		begin = instruction->arg1;
+		count = 2 * (size_t)instruction->arg2;
+	} else {
+		return true;
+	}
+
+	for (size_t i = begin; i < begin + count; i++) {
+		if (claimed[i]) {
+			return false;
+		}
+		claimed[i] = true;
+	}
+	return true;
+}
+
+static bool validate_function(struct mcc_tac_function *function)
+{
+	if (function->return_type > MCC_TAC_TYPE_ARRAY || function->variable_types[0] != MCC_TAC_TYPE_VOID) {
+		return false;
+	}
+	for (size_t v = 1; v <= function->variables_count; v++) {
+		if (function->variable_types[v] == MCC_TAC_TYPE_VOID ||
+		    function->variable_types[v] > MCC_TAC_TYPE_ARRAY) {
+			return false;
+		}
+	}
+
+	// Jumps must target placed labels, which building a graph relies on.
+	bool *placed = calloc((size_t)function->labels_count + 1, sizeof(*placed));
+	if (!placed) {
+		return false;
+	}
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_LABEL && is_label(function, instruction->arg2)) {
+			placed[instruction->arg2] = true;
+		}
+	}
+
+	// Each operand belongs to at most one instruction.
+	bool *claimed = calloc(function->operands_count + 1, sizeof(*claimed));
+	bool valid = claimed;
+	for (size_t i = 0; valid && i < function->instructions_count; i++) {
+		valid = validate_instruction(function, &function->instructions[i], placed) &&
+		        claim_operands(function, &function->instructions[i], claimed);
+		if (function->instructions[i].op == MCC_TAC_OP_NOP) {
+			function->removed_count++;
+		}
+	}
+	free(claimed);
+	free(placed);
+	return valid;
+}
+
+static bool is_block(const struct mcc_cfg *cfg, uint32_t block)
+{
+	return block < cfg->blocks_count;
+}
+
+static bool validate_cfg(const struct mcc_cfg *cfg, const struct mcc_tac_function *function, size_t predecessors_count)
+{
+	if (cfg->order_count > cfg->blocks_count) {
+		return false;
+	}
+
+	for (size_t b = 0; b < cfg->blocks_count; b++) {
+		const struct mcc_cfg_block *block = &cfg->blocks[b];
+		if (block->begin > block->end || block->end > function->instructions_count ||
+		    block->successors_count > 2 || block->predecessors_begin > predecessors_count ||
+		    block->predecessors_count > predecessors_count - block->predecessors_begin ||
+		    (block->idom != MCC_CFG_NONE && !is_block(cfg, block->idom)) ||
+		    (block->order != MCC_CFG_NONE && block->order >= cfg->order_count)) {
+			return false;
+		}
+		for (uint32_t s = 0; s < block->successors_count; s++) {
+			if (!is_block(cfg, block->successors[s])) {
+				return false;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < predecessors_count; i++) {
+		if (!is_block(cfg, cfg->predecessors[i])) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i < cfg->order_count; i++) {
+		if (!is_block(cfg, cfg->order[i])) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i <= cfg->labels_count; i++) {
+		if (cfg->label_blocks[i] != MCC_CFG_NONE && !is_block(cfg, cfg->label_blocks[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Decodes the arrays of a record into `function` and, if the record holds
+// one, `cfg`. Both have to be deinitialised by the caller, even on failure.
+static bool read_function(struct mcc_tac_function *function,
+                          struct mcc_cfg *cfg,
+                          struct mcc_string_pool *pool,
+                          struct reader *reader,
+                          const struct record *record)
+{
+	if (record->name_length == UINT32_MAX || record->variables_count == UINT32_MAX ||
+	    record->labels_count == UINT32_MAX || (record->flags & ~RECORD_HAS_CFG) != 0) {
+		return false;
+	}
+
+	const uint8_t *name = take(reader, (size_t)record->name_length + 1, 1);
+	const uint8_t *instructions = name ? take(reader, record->instructions_count, 16) : NULL;
+	const uint8_t *constants = instructions ? take(reader, record->constants_count, 8) : NULL;
+	const uint8_t *operands = constants ? take(reader, record->operands_count, 4) : NULL;
+	const uint8_t *types = operands ? take(reader, (size_t)record->variables_count + 1, 1) : NULL;
+	const uint8_t *lengths = types ? take(reader, record->strings_count, 4) : NULL;
+	const uint8_t *characters = lengths ? take(reader, record->strings_size, 1) : NULL;
+	if (!characters || name[record->name_length] != '\0' || memchr(name, '\0', record->name_length)) {
+		return false;
+	}
+
+	*function = (struct mcc_tac_function){
+	    .name = (const char *)name,
+	    .return_type = record->return_type,
+	    .parameters_count = record->parameters_count,
+	    .variables_count = record->variables_count,
+	    .labels_count = record->labels_count,
+	};
+	if (!load_instructions(&function->instructions, instructions, record->instructions_count) ||
+	    !load_u64s(&function->constants, constants, record->constants_count) ||
+	    !load_u32s(&function->operands, operands, record->operands_count) ||
+	    !load_bytes(&function->variable_types, types, (size_t)record->variables_count + 1)) {
+		return false;
+	}
+	function->instructions_count = function->instructions_capacity = record->instructions_count;
+	function->constants_count = function->constants_capacity = record->constants_count;
+	function->operands_count = function->operands_capacity = record->operands_count;
+	function->variable_types_capacity = (size_t)record->variables_count + 1;
+
+	if (!read_strings(function, pool, lengths, characters, record) || !validate_function(function)) {
+		return false;
+	}
+
+	if (record->flags & RECORD_HAS_CFG) {
+		if (record->labels_count != function->labels_count || !read_cfg(cfg, reader, record) ||
+		    !validate_cfg(cfg, function, record->predecessors_count)) {
+			return false;
+		}
+	}
+	return reader->position == reader->size;
+}
+
+// Reads the next record, appending its function to `program`. If `cfg` is
+// not NULL, it receives the function's graph and has to be deinitialised by
+// the caller, even on failure.
+static bool read_record(struct mcc_tac_program *program, struct mcc_cfg *cfg, struct reader *image)
+{
+	const uint8_t *header = take(image, 1, RECORD_HEADER_SIZE);
+	if (!header) {
+		return false;
+	}
+
+	uint64_t size = load_u64(header);
+	size_t available = image->size - image->position;
+	if (size < RECORD_HEADER_SIZE || size % 8 != 0 || size - RECORD_HEADER_SIZE > available) {
+		return false;
+	}
+	struct reader reader = {.data = header, .size = (size_t)size, .position = RECORD_HEADER_SIZE};
+	image->position += (size_t)size - RECORD_HEADER_SIZE;
+
+	struct record record;
+	read_record_header(&record, header);
+
+	struct mcc_tac_function function = {0};
+	struct mcc_cfg graph = {0};
+	struct mcc_tac_function *added = NULL;
+	if (read_function(&function, &graph, &program->strings, &reader, &record)) {
+		added = mcc_tac_program_add_function(program, function.name, function.return_type);
+	}
+	if (!added) {
+		mcc_tac_function_deinit(&function);
+		mcc_cfg_deinit(&graph);
+		return false;
+	}
+
+	const char *name = added->name;
+	*added = function;
+	added->name = name;
+
+	if (!cfg) {
+		mcc_cfg_deinit(&graph);
+		return true;
+	}
+	*cfg = graph;
+	return (record.flags & RECORD_HAS_CFG) || mcc_cfg_build(cfg, added);
+}
+
+// Checks that calls from or to the functions starting at index `first` pass
+// as many arguments as the callee takes. Calls of builtins are left to the
+// backends.
+static bool validate_calls(const struct mcc_tac_program *program, size_t first)
+{
+	for (size_t f = 0; f < program->functions_count; f++) {
+		const struct mcc_tac_function *function = &program->functions[f];
+		for (size_t i = 0; i < function->instructions_count; i++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[i];
+			if (instruction->op != MCC_TAC_OP_CALL) {
+				continue;
+			}
+
+			const char *name = function->strings[instruction->arg1];
+			const struct mcc_tac_function *callee = mcc_tac_program_find_function(program, name);
+			if (!callee || (f < first && (size_t)(callee - program->functions) < first)) {
+				continue;
+			}
+			if (function->operands[instruction->arg2] != callee->parameters_count) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool mcc_tac_binary_is_image(const void *data, size_t size)
+{
+	assert(data || size == 0);
+
+	return size >= sizeof(magic) && memcmp(data, magic, sizeof(magic)) == 0;
+}
+
+bool mcc_tac_binary_read(struct mcc_tac_program *program, struct mcc_cfg **cfgs, const void *data, size_t size)
+{
+	assert(program);
+	assert(data || size == 0);
+
+	if (cfgs) {
+		*cfgs = NULL;
+	}
+
+	struct reader reader = {.data = data, .size = size};
+	const uint8_t *header = take(&reader, 1, IMAGE_HEADER_SIZE);
+	if (!header || memcmp(header, magic, sizeof(magic)) != 0 || load_u32(header + 8) != MCC_TAC_BINARY_VERSION) {
+		return false;
+	}
+
+	// Each record takes at least its header, which bounds the allocation.
+	size_t count = load_u32(header + 12);
+	if (count > (size - IMAGE_HEADER_SIZE) / RECORD_HEADER_SIZE) {
+		return false;
+	}
+
+	struct mcc_cfg *graphs = NULL;
+	if (cfgs && count > 0) {
+		graphs = calloc(count, sizeof(*graphs));
+		if (!graphs) {
+			return false;
+		}
+	}
+
+	size_t first = program->functions_count;
+	bool ok = true;
+	for (size_t i = 0; ok && i < count; i++) {
+		ok = read_record(program, graphs ? &graphs[i] : NULL, &reader);
+	}
+	ok = ok && reader.position == reader.size && validate_calls(program, first);
+
+	if (!ok) {
+		for (size_t i = 0; graphs && i < count; i++) {
+			mcc_cfg_deinit(&graphs[i]);
+		}
+		free(graphs);
+		return false;
+	}
+
+	if (cfgs) {
+		*cfgs = graphs;
+	}
+	return true;
+}
+
+bool mcc_tac_binary_read_file(struct mcc_tac_program *program, struct mcc_cfg **cfgs, const char *path)
+{
+	assert(program);
+	assert(path);
+
+	if (cfgs) {
+		*cfgs = NULL;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	bool ok = fstat(fd, &st) == 0 && st.st_size > 0 && (uintmax_t)st.st_size <= SIZE_MAX;
+	size_t size = ok ? (size_t)st.st_size : 0;
+	void *data = ok ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	ok = mcc_tac_binary_read(program, cfgs, data, size);
+	munmap(data, size);
+	return ok;
+}
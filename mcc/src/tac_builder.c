@@ -0,0 +1,422 @@
+#include "mcc/tac_builder.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// ------------------------------------------------------------------- Pools
+
+static void pool_deinit(struct mcc_tac_builder_pool *pool)
+{
+	free(pool->entries);
+	*pool = (struct mcc_tac_builder_pool){0};
+}
+
+// Returns the slot holding `key`, or the empty slot it belongs into.
+static struct mcc_tac_builder_pool_entry *pool_slot(const struct mcc_tac_builder_pool *pool, uint64_t key)
+{
+	size_t mask = pool->capacity - 1;
+	size_t i = (size_t)((key * UINT64_C(11400714819323198485)) >> 32) & mask;
+	while (pool->entries[i].index != 0 && pool->entries[i].key != key) {
+		i = (i + 1) & mask;
+	}
+	return &pool->entries[i];
+}
+
+// Keeps the load factor at or below 1/2.
+static bool pool_reserve(struct mcc_tac_builder_pool *pool)
+{
+	if ((pool->count + 1) * 2 <= pool->capacity) {
+		return true;
+	}
+
+	struct mcc_tac_builder_pool grown = {
+	    .count = pool->count,
+	    .capacity = pool->capacity ? pool->capacity * 2 : 16,
+	};
+	grown.entries = calloc(grown.capacity, sizeof(*grown.entries));
+	if (!grown.entries) {
+		return false;
+	}
+
+	for (size_t i = 0; i < pool->capacity; i++) {
+		if (pool->entries[i].index != 0) {
+			*pool_slot(&grown, pool->entries[i].key) = pool->entries[i];
+		}
+	}
+
+	free(pool->entries);
+	*pool = grown;
+	return true;
+}
+
+static uint32_t intern_constant(struct mcc_tac_builder *builder, uint64_t bits)
+{
+	if (builder->failed || !pool_reserve(&builder->constants)) {
+		builder->failed = true;
+		return 0;
+	}
+
+	struct mcc_tac_builder_pool_entry *entry = pool_slot(&builder->constants, bits);
+	if (entry->index == 0) {
+		uint32_t index;
+		if (!mcc_tac_function_add_constant(&builder->function, bits, &index)) {
+			builder->failed = true;
+			return 0;
+		}
+		*entry = (struct mcc_tac_builder_pool_entry){.key = bits, .index = index + 1};
+		builder->constants.count++;
+	}
+	return entry->index - 1;
+}
+
+// Strings are compared by address, which is sufficient for interned ones.
+static uint32_t intern_string(struct mcc_tac_builder *builder, const char *string)
+{
+	if (builder->failed || !pool_reserve(&builder->strings)) {
+		builder->failed = true;
+		return 0;
+	}
+
+	uint64_t key = (uint64_t)(uintptr_t)string;
+	struct mcc_tac_builder_pool_entry *entry = pool_slot(&builder->strings, key);
+	if (entry->index == 0) {
+		uint32_t index;
+		if (!mcc_tac_function_add_string(&builder->function, string, &index)) {
+			builder->failed = true;
+			return 0;
+		}
+		*entry = (struct mcc_tac_builder_pool_entry){.key = key, .index = index + 1};
+		builder->strings.count++;
+	}
+	return entry->index - 1;
+}
+
+// ----------------------------------------------------------------- Builder
+
+void mcc_tac_builder_init(struct mcc_tac_builder *builder,
+                          const char *name,
+                          enum mcc_tac_type return_type,
+                          size_t parameters_count)
+{
+	assert(builder);
+	assert(name);
+
+	*builder = (struct mcc_tac_builder){
+	    .function =
+	        {
+	            .name = name,
+	            .return_type = return_type,
+	            .parameters_count = parameters_count,
+	        },
+	};
+}
+
+void mcc_tac_builder_deinit(struct mcc_tac_builder *builder)
+{
+	if (!builder) {
+		return;
+	}
+
+	mcc_tac_function_deinit(&builder->function);
+	pool_deinit(&builder->constants);
+	pool_deinit(&builder->strings);
+	builder->function = (struct mcc_tac_function){0};
+}
+
+bool mcc_tac_builder_finish(struct mcc_tac_builder *builder, struct mcc_tac_function *function)
+{
+	assert(builder);
+	assert(function);
+
+	bool ok = !builder->failed;
+	if (ok) {
+		*function = builder->function;
+	} else {
+		mcc_tac_function_deinit(&builder->function);
+	}
+	pool_deinit(&builder->constants);
+	pool_deinit(&builder->strings);
+
+	mcc_tac_builder_init(builder, builder->function.name, builder->function.return_type,
+	                     builder->function.parameters_count);
+	return ok;
+}
+
+struct mcc_tac_variable mcc_tac_builder_variable(struct mcc_tac_builder *builder, enum mcc_tac_type type)
+{
+	assert(builder);
+
+	struct mcc_tac_variable variable = mcc_tac_function_new_variable(&builder->function, type);
+	if (variable.identifier == 0) {
+		builder->failed = true;
+		variable.type = type;
+	}
+	return variable;
+}
+
+uint32_t mcc_tac_builder_label(struct mcc_tac_builder *builder)
+{
+	assert(builder);
+
+	return mcc_tac_function_new_label(&builder->function);
+}
+
+void mcc_tac_builder_emit(struct mcc_tac_builder *builder, struct mcc_tac_instruction instruction)
+{
+	assert(builder);
+
+	if (!builder->failed && !mcc_tac_function_append(&builder->function, instruction)) {
+		builder->failed = true;
+	}
+}
+
+// ---------------------------------------------------------------- Emitters
+
+static struct mcc_tac_variable emit_constant(struct mcc_tac_builder *builder, enum mcc_tac_type type, uint32_t index)
+{
+	struct mcc_tac_variable result = mcc_tac_builder_variable(builder, type);
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_CONST,
+	                                  .type = type,
+	                                  .result = result.identifier,
+	                                  .arg1 = index,
+	                              });
+	return result;
+}
+
+struct mcc_tac_variable mcc_tac_builder_const_int(struct mcc_tac_builder *builder, long value)
+{
+	assert(builder);
+
+	return emit_constant(builder, MCC_TAC_TYPE_INT, intern_constant(builder, mcc_tac_int_bits(value)));
+}
+
+struct mcc_tac_variable mcc_tac_builder_const_float(struct mcc_tac_builder *builder, double value)
+{
+	assert(builder);
+
+	return emit_constant(builder, MCC_TAC_TYPE_FLOAT, intern_constant(builder, mcc_tac_float_bits(value)));
+}
+
+struct mcc_tac_variable mcc_tac_builder_const_bool(struct mcc_tac_builder *builder, bool value)
+{
+	assert(builder);
+
+	return emit_constant(builder, MCC_TAC_TYPE_BOOL, intern_constant(builder, value ? 1 : 0));
+}
+
+struct mcc_tac_variable mcc_tac_builder_const_string(struct mcc_tac_builder *builder, const char *value)
+{
+	assert(builder);
+	assert(value);
+
+	return emit_constant(builder, MCC_TAC_TYPE_STRING, intern_string(builder, value));
+}
+
+void mcc_tac_builder_assign(struct mcc_tac_builder *builder,
+                            struct mcc_tac_variable destination,
+                            struct mcc_tac_variable source)
+{
+	assert(destination.type == source.type);
+
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_ASSIGN,
+	                                  .type = destination.type,
+	                                  .result = destination.identifier,
+	                                  .arg1 = source.identifier,
+	                              });
+}
+
+struct mcc_tac_variable mcc_tac_builder_unary(struct mcc_tac_builder *builder,
+                                              enum mcc_tac_op op,
+                                              enum mcc_tac_type type,
+                                              struct mcc_tac_variable operand)
+{
+	assert(op == MCC_TAC_OP_NEG || op == MCC_TAC_OP_NOT);
+	assert(operand.type == type);
+
+	struct mcc_tac_variable result = mcc_tac_builder_variable(builder, type);
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = op,
+	                                  .type = type,
+	                                  .result = result.identifier,
+	                                  .arg1 = operand.identifier,
+	                              });
+	return result;
+}
+
+struct mcc_tac_variable mcc_tac_builder_binary(struct mcc_tac_builder *builder,
+                                               enum mcc_tac_op op,
+                                               enum mcc_tac_type type,
+                                               struct mcc_tac_variable lhs,
+                                               struct mcc_tac_variable rhs)
+{
+	assert(op >= MCC_TAC_OP_ADD && op <= MCC_TAC_OP_OR && op != MCC_TAC_OP_NEG);
+	assert(lhs.type == rhs.type);
+
+	// Comparisons record the type of their operands.
+	struct mcc_tac_variable result = mcc_tac_builder_variable(builder, type);
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = op,
+	                                  .type = lhs.type,
+	                                  .result = result.identifier,
+	                                  .arg1 = lhs.identifier,
+	                                  .arg2 = rhs.identifier,
+	                              });
+	return result;
+}
+
+struct mcc_tac_variable mcc_tac_builder_array(struct mcc_tac_builder *builder, enum mcc_tac_type type, long size)
+{
+	assert(builder);
+	assert(size > 0);
+
+	uint32_t index = intern_constant(builder, mcc_tac_int_bits(size));
+	struct mcc_tac_variable result = mcc_tac_builder_variable(builder, MCC_TAC_TYPE_ARRAY);
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_ARRAY,
+	                                  .type = type,
+	                                  .result = result.identifier,
+	                                  .arg1 = index,
+	                              });
+	return result;
+}
+
+struct mcc_tac_variable mcc_tac_builder_load(struct mcc_tac_builder *builder,
+                                             enum mcc_tac_type type,
+                                             struct mcc_tac_variable array,
+                                             struct mcc_tac_variable index)
+{
+	assert(array.type == MCC_TAC_TYPE_ARRAY);
+	assert(index.type == MCC_TAC_TYPE_INT);
+
+	struct mcc_tac_variable result = mcc_tac_builder_variable(builder, type);
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_LOAD,
+	                                  .type = type,
+	                                  .result = result.identifier,
+	                                  .arg1 = array.identifier,
+	                                  .arg2 = index.identifier,
+	                              });
+	return result;
+}
+
+void mcc_tac_builder_store(struct mcc_tac_builder *builder,
+                           struct mcc_tac_variable array,
+                           struct mcc_tac_variable index,
+                           struct mcc_tac_variable value)
+{
+	assert(array.type == MCC_TAC_TYPE_ARRAY);
+	assert(index.type == MCC_TAC_TYPE_INT);
+
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_STORE,
+	                                  .type = value.type,
+	                                  .result = array.identifier,
+	                                  .arg1 = index.identifier,
+	                                  .arg2 = value.identifier,
+	                              });
+}
+
+void mcc_tac_builder_place_label(struct mcc_tac_builder *builder, uint32_t label)
+{
+	assert(label != 0);
+
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL, .arg2 = label});
+}
+
+void mcc_tac_builder_jump(struct mcc_tac_builder *builder, uint32_t label)
+{
+	assert(label != 0);
+
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){.op = MCC_TAC_OP_JUMP, .arg2 = label});
+}
+
+void mcc_tac_builder_jump_if(struct mcc_tac_builder *builder,
+                             uint32_t label,
+                             struct mcc_tac_variable condition,
+                             bool when)
+{
+	assert(label != 0);
+	assert(condition.type == MCC_TAC_TYPE_BOOL);
+
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = when ? MCC_TAC_OP_JUMP_IF : MCC_TAC_OP_JUMP_IF_NOT,
+	                                  .type = MCC_TAC_TYPE_BOOL,
+	                                  .arg1 = condition.identifier,
+	                                  .arg2 = label,
+	                              });
+}
+
+struct mcc_tac_variable mcc_tac_builder_param(struct mcc_tac_builder *builder, enum mcc_tac_type type, uint32_t index)
+{
+	assert(index < builder->function.parameters_count);
+
+	struct mcc_tac_variable result = mcc_tac_builder_variable(builder, type);
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_PARAM,
+	                                  .type = type,
+	                                  .result = result.identifier,
+	                                  .arg1 = index,
+	                              });
+	return result;
+}
+
+// Appends the argument count followed by the arguments to `operands`.
+static uint32_t add_arguments(struct mcc_tac_builder *builder,
+                              const struct mcc_tac_variable *arguments,
+                              size_t arguments_count)
+{
+	struct mcc_tac_function *function = &builder->function;
+	uint32_t count = (uint32_t)arguments_count;
+	uint32_t index = 0;
+	if (builder->failed || arguments_count >= UINT32_MAX ||
+	    !mcc_tac_function_add_operands(function, &count, 1, &index)) {
+		builder->failed = true;
+		return 0;
+	}
+
+	for (size_t i = 0; i < arguments_count; i++) {
+		uint32_t unused;
+		if (!mcc_tac_function_add_operands(function, &arguments[i].identifier, 1, &unused)) {
+			builder->failed = true;
+			return 0;
+		}
+	}
+	return index;
+}
+
+struct mcc_tac_variable mcc_tac_builder_call(struct mcc_tac_builder *builder,
+                                             const char *function,
+                                             enum mcc_tac_type type,
+                                             const struct mcc_tac_variable *arguments,
+                                             size_t arguments_count)
+{
+	assert(builder);
+	assert(function);
+	assert(arguments || arguments_count == 0);
+
+	uint32_t callee = intern_string(builder, function);
+	uint32_t list = add_arguments(builder, arguments, arguments_count);
+	struct mcc_tac_variable result = {.type = MCC_TAC_TYPE_VOID};
+	if (type != MCC_TAC_TYPE_VOID) {
+		result = mcc_tac_builder_variable(builder, type);
+	}
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_CALL,
+	                                  .type = type,
+	                                  .result = result.identifier,
+	                                  .arg1 = callee,
+	                                  .arg2 = list,
+	                              });
+	return result;
+}
+
+void mcc_tac_builder_return(struct mcc_tac_builder *builder, struct mcc_tac_variable value)
+{
+	mcc_tac_builder_emit(builder, (struct mcc_tac_instruction){
+	                                  .op = MCC_TAC_OP_RETURN,
+	                                  .type = value.type,
+	                                  .arg1 = value.identifier,
+	                              });
+}
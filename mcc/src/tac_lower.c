@@ -0,0 +1,568 @@
+#include "mcc/tac_lower.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mcc/ast_visit.h"
+#include "mcc/tac_builder.h"
+#include "parallel.h"
+
+#define INITIAL_CAPACITY 64
+
+// ------------------------------------------------------------- Variable Map
+
+// Maps declarations to their TAC variable. Open addressing hash table keyed
+// by the declaration's address, empty slots have no declaration.
+struct variable_map {
+	struct variable_map_slot {
+		const struct mcc_ast_declaration *declaration;
+		struct mcc_tac_variable variable;
+	} * slots;
+	size_t count;
+	size_t capacity;
+};
+
+static size_t hash_declaration(const struct mcc_ast_declaration *declaration)
+{
+	return (size_t)(((uint64_t)(uintptr_t)declaration * UINT64_C(11400714819323198485)) >> 32);
+}
+
+static size_t find_slot(const struct variable_map_slot *slots,
+                        size_t capacity,
+                        const struct mcc_ast_declaration *declaration)
+{
+	assert(capacity > 0);
+
+	size_t mask = capacity - 1;
+	size_t index = hash_declaration(declaration) & mask;
+	while (slots[index].declaration && slots[index].declaration != declaration) {
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+static bool variable_map_grow(struct variable_map *map)
+{
+	size_t new_capacity = map->capacity ? map->capacity * 2 : INITIAL_CAPACITY;
+	struct variable_map_slot *new_slots = calloc(new_capacity, sizeof(*new_slots));
+	if (!new_slots) {
+		return false;
+	}
+
+	for (size_t i = 0; i < map->capacity; i++) {
+		if (map->slots[i].declaration) {
+			new_slots[find_slot(new_slots, new_capacity, map->slots[i].declaration)] = map->slots[i];
+		}
+	}
+
+	free(map->slots);
+	map->slots = new_slots;
+	map->capacity = new_capacity;
+	return true;
+}
+
+static bool variable_map_insert(struct variable_map *map,
+                                const struct mcc_ast_declaration *declaration,
+                                struct mcc_tac_variable variable)
+{
+	// Keep the load factor below 3/4.
+	if (4 * (map->count + 1) > 3 * map->capacity && !variable_map_grow(map)) {
+		return false;
+	}
+
+	struct variable_map_slot *slot = &map->slots[find_slot(map->slots, map->capacity, declaration)];
+	if (!slot->declaration) {
+		map->count++;
+	}
+	*slot = (struct variable_map_slot){.declaration = declaration, .variable = variable};
+	return true;
+}
+
+static struct mcc_tac_variable variable_map_lookup(const struct variable_map *map,
+                                                   const struct mcc_ast_declaration *declaration)
+{
+	assert(map->capacity > 0);
+
+	const struct variable_map_slot *slot = &map->slots[find_slot(map->slots, map->capacity, declaration)];
+	assert(slot->declaration);
+	return slot->variable;
+}
+
+static void variable_map_clear(struct variable_map *map)
+{
+	if (map->count > 0) {
+		memset(map->slots, 0, map->capacity * sizeof(*map->slots));
+		map->count = 0;
+	}
+}
+
+// ----------------------------------------------------------------- Lowering
+
+struct lowering {
+	// Read-only while functions are lowered, all strings are interned upfront.
+	const struct mcc_tac_program *tac;
+
+	struct mcc_tac_builder builder;
+
+	// Scratch space of the worker running this lowering.
+	struct variable_map *variables;
+};
+
+static enum mcc_tac_type tac_type(const struct mcc_type *type)
+{
+	assert(type);
+
+	switch (type->kind) {
+	case MCC_TYPE_KIND_VOID:
+		return MCC_TAC_TYPE_VOID;
+	case MCC_TYPE_KIND_BOOL:
+		return MCC_TAC_TYPE_BOOL;
+	case MCC_TYPE_KIND_INT:
+		return MCC_TAC_TYPE_INT;
+	case MCC_TYPE_KIND_FLOAT:
+		return MCC_TAC_TYPE_FLOAT;
+	case MCC_TYPE_KIND_STRING:
+		return MCC_TAC_TYPE_STRING;
+	case MCC_TYPE_KIND_ARRAY:
+		return MCC_TAC_TYPE_ARRAY;
+	}
+
+	assert(false);
+	return MCC_TAC_TYPE_VOID;
+}
+
+static enum mcc_tac_type tac_type_from_data_type(enum mcc_ast_data_type data_type)
+{
+	switch (data_type) {
+	case MCC_AST_DATA_TYPE_VOID:
+		return MCC_TAC_TYPE_VOID;
+	case MCC_AST_DATA_TYPE_BOOL:
+		return MCC_TAC_TYPE_BOOL;
+	case MCC_AST_DATA_TYPE_INT:
+		return MCC_TAC_TYPE_INT;
+	case MCC_AST_DATA_TYPE_FLOAT:
+		return MCC_TAC_TYPE_FLOAT;
+	case MCC_AST_DATA_TYPE_STRING:
+		return MCC_TAC_TYPE_STRING;
+	}
+
+	assert(false);
+	return MCC_TAC_TYPE_VOID;
+}
+
+static const char *find_string(struct lowering *lowering, const char *s)
+{
+	const char *interned = mcc_string_pool_find(&lowering->tac->strings, s, strlen(s));
+	assert(interned);
+	return interned;
+}
+
+static void declare_variable(struct lowering *lowering,
+                             const struct mcc_ast_declaration *declaration,
+                             struct mcc_tac_variable variable)
+{
+	if (!variable_map_insert(lowering->variables, declaration, variable)) {
+		lowering->builder.failed = true;
+	}
+}
+
+static struct mcc_tac_variable lookup_variable(struct lowering *lowering, const struct mcc_ast_identifier *identifier)
+{
+	assert(identifier->declaration);
+
+	return variable_map_lookup(lowering->variables, identifier->declaration);
+}
+
+// --------------------------------------------------------------- Expressions
+
+static struct mcc_tac_variable lower_expression(struct lowering *lowering, const struct mcc_ast_expression *expression);
+
+static struct mcc_tac_variable lower_literal(struct lowering *lowering, const struct mcc_ast_literal *literal)
+{
+	switch (literal->type) {
+	case MCC_AST_LITERAL_TYPE_INT:
+		return mcc_tac_builder_const_int(&lowering->builder, literal->i_value);
+	case MCC_AST_LITERAL_TYPE_FLOAT:
+		return mcc_tac_builder_const_float(&lowering->builder, literal->f_value);
+	case MCC_AST_LITERAL_TYPE_BOOL:
+		return mcc_tac_builder_const_bool(&lowering->builder, literal->b_value);
+	case MCC_AST_LITERAL_TYPE_STRING:
+		return mcc_tac_builder_const_string(&lowering->builder, find_string(lowering, literal->s_value));
+	}
+
+	assert(false);
+	return (struct mcc_tac_variable){0};
+}
+
+static enum mcc_tac_op tac_binary_op(enum mcc_ast_binary_op op)
+{
+	switch (op) {
+	case MCC_AST_BINARY_OP_ADD:
+		return MCC_TAC_OP_ADD;
+	case MCC_AST_BINARY_OP_SUB:
+		return MCC_TAC_OP_SUB;
+	case MCC_AST_BINARY_OP_MUL:
+		return MCC_TAC_OP_MUL;
+	case MCC_AST_BINARY_OP_DIV:
+		return MCC_TAC_OP_DIV;
+	case MCC_AST_BINARY_OP_LT:
+		return MCC_TAC_OP_LT;
+	case MCC_AST_BINARY_OP_GT:
+		return MCC_TAC_OP_GT;
+	case MCC_AST_BINARY_OP_LE:
+		return MCC_TAC_OP_LE;
+	case MCC_AST_BINARY_OP_GE:
+		return MCC_TAC_OP_GE;
+	case MCC_AST_BINARY_OP_AND:
+		return MCC_TAC_OP_AND;
+	case MCC_AST_BINARY_OP_OR:
+		return MCC_TAC_OP_OR;
+	case MCC_AST_BINARY_OP_EQ:
+		return MCC_TAC_OP_EQ;
+	case MCC_AST_BINARY_OP_NE:
+		return MCC_TAC_OP_NE;
+	}
+
+	assert(false);
+	return MCC_TAC_OP_NOP;
+}
+
+static struct mcc_tac_variable lower_call(struct lowering *lowering, const struct mcc_ast_expression *call)
+{
+	// Arguments are evaluated left to right, then passed all at once.
+	struct mcc_tac_variable stack_arguments[8];
+	struct mcc_tac_variable *arguments = stack_arguments;
+	if (call->arguments_count > sizeof(stack_arguments) / sizeof(*stack_arguments)) {
+		arguments = malloc(call->arguments_count * sizeof(*arguments));
+		if (!arguments) {
+			// The result is discarded, yet it keeps its users consistent.
+			lowering->builder.failed = true;
+			enum mcc_tac_type type = tac_type(call->data_type);
+			return type == MCC_TAC_TYPE_VOID ? (struct mcc_tac_variable){0}
+			                                 : mcc_tac_builder_variable(&lowering->builder, type);
+		}
+	}
+
+	for (size_t i = 0; i < call->arguments_count; i++) {
+		arguments[i] = lower_expression(lowering, call->arguments[i]);
+	}
+
+	struct mcc_tac_variable result =
+	    mcc_tac_builder_call(&lowering->builder, find_string(lowering, call->callee->name),
+	                         tac_type(call->data_type), arguments, call->arguments_count);
+
+	if (arguments != stack_arguments) {
+		free(arguments);
+	}
+	return result;
+}
+
+static struct mcc_tac_variable lower_expression(struct lowering *lowering, const struct mcc_ast_expression *expression)
+{
+	assert(expression->data_type);
+
+	struct mcc_tac_builder *builder = &lowering->builder;
+	enum mcc_tac_type type = tac_type(expression->data_type);
+
+	switch (expression->type) {
+	case MCC_AST_EXPRESSION_TYPE_LITERAL:
+		return lower_literal(lowering, expression->literal);
+
+	case MCC_AST_EXPRESSION_TYPE_BINARY_OP: {
+		struct mcc_tac_variable lhs = lower_expression(lowering, expression->lhs);
+		struct mcc_tac_variable rhs = lower_expression(lowering, expression->rhs);
+		return mcc_tac_builder_binary(builder, tac_binary_op(expression->op), type, lhs, rhs);
+	}
+
+	case MCC_AST_EXPRESSION_TYPE_PARENTH:
+		return lower_expression(lowering, expression->expression);
+
+	case MCC_AST_EXPRESSION_TYPE_UNARY_OP: {
+		struct mcc_tac_variable operand = lower_expression(lowering, expression->operand);
+		enum mcc_tac_op op = expression->unary_op == MCC_AST_UNARY_OP_NEG ? MCC_TAC_OP_NEG : MCC_TAC_OP_NOT;
+		return mcc_tac_builder_unary(builder, op, type, operand);
+	}
+
+	case MCC_AST_EXPRESSION_TYPE_IDENTIFIER:
+		return lookup_variable(lowering, expression->identifier);
+
+	case MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT: {
+		struct mcc_tac_variable array = lookup_variable(lowering, expression->array);
+		struct mcc_tac_variable index = lower_expression(lowering, expression->index);
+		return mcc_tac_builder_load(builder, type, array, index);
+	}
+
+	case MCC_AST_EXPRESSION_TYPE_CALL:
+		return lower_call(lowering, expression);
+	}
+
+	assert(false);
+	return (struct mcc_tac_variable){0};
+}
+
+// ---------------------------------------------------------------- Statements
+
+static void lower_statement(struct lowering *lowering, const struct mcc_ast_statement *statement);
+
+static void lower_declaration(struct lowering *lowering, const struct mcc_ast_declaration *declaration)
+{
+	assert(declaration->resolved_type);
+
+	struct mcc_tac_variable variable;
+	if (declaration->is_array) {
+		variable = mcc_tac_builder_array(&lowering->builder, tac_type(declaration->resolved_type->element),
+		                                 declaration->array_size);
+	} else {
+		variable = mcc_tac_builder_variable(&lowering->builder, tac_type(declaration->resolved_type));
+	}
+	declare_variable(lowering, declaration, variable);
+}
+
+static void lower_assignment(struct lowering *lowering, const struct mcc_ast_assignment *assignment)
+{
+	struct mcc_tac_variable variable = lookup_variable(lowering, assignment->identifier);
+
+	if (assignment->index) {
+		struct mcc_tac_variable index = lower_expression(lowering, assignment->index);
+		struct mcc_tac_variable value = lower_expression(lowering, assignment->rhs);
+		mcc_tac_builder_store(&lowering->builder, variable, index, value);
+	} else {
+		struct mcc_tac_variable value = lower_expression(lowering, assignment->rhs);
+		mcc_tac_builder_assign(&lowering->builder, variable, value);
+	}
+}
+
+static void lower_if(struct lowering *lowering, const struct mcc_ast_statement *statement)
+{
+	struct mcc_tac_builder *builder = &lowering->builder;
+	struct mcc_tac_variable condition = lower_expression(lowering, statement->if_condition);
+
+	uint32_t end = mcc_tac_builder_label(builder);
+	if (!statement->if_on_false) {
+		mcc_tac_builder_jump_if(builder, end, condition, false);
+		lower_statement(lowering, statement->if_on_true);
+		mcc_tac_builder_place_label(builder, end);
+		return;
+	}
+
+	uint32_t on_false = mcc_tac_builder_label(builder);
+	mcc_tac_builder_jump_if(builder, on_false, condition, false);
+	lower_statement(lowering, statement->if_on_true);
+	mcc_tac_builder_jump(builder, end);
+	mcc_tac_builder_place_label(builder, on_false);
+	lower_statement(lowering, statement->if_on_false);
+	mcc_tac_builder_place_label(builder, end);
+}
+
+static void lower_while(struct lowering *lowering, const struct mcc_ast_statement *statement)
+{
+	struct mcc_tac_builder *builder = &lowering->builder;
+
+	uint32_t head = mcc_tac_builder_label(builder);
+	uint32_t end = mcc_tac_builder_label(builder);
+
+	mcc_tac_builder_place_label(builder, head);
+	struct mcc_tac_variable condition = lower_expression(lowering, statement->while_condition);
+	mcc_tac_builder_jump_if(builder, end, condition, false);
+	lower_statement(lowering, statement->while_body);
+	mcc_tac_builder_jump(builder, head);
+	mcc_tac_builder_place_label(builder, end);
+}
+
+static void lower_statement(struct lowering *lowering, const struct mcc_ast_statement *statement)
+{
+	// A failed declaration leaves uses of its variable unresolvable.
+	if (lowering->builder.failed) {
+		return;
+	}
+
+	switch (statement->type) {
+	case MCC_AST_STATEMENT_TYPE_IF:
+		lower_if(lowering, statement);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_WHILE:
+		lower_while(lowering, statement);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_RETURN: {
+		struct mcc_tac_variable value = {0};
+		if (statement->return_value) {
+			value = lower_expression(lowering, statement->return_value);
+		}
+		mcc_tac_builder_return(&lowering->builder, value);
+		break;
+	}
+
+	case MCC_AST_STATEMENT_TYPE_DECLARATION:
+		lower_declaration(lowering, statement->declaration);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_ASSIGNMENT:
+		lower_assignment(lowering, statement->assignment);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_EXPRESSION:
+		lower_expression(lowering, statement->expression);
+		break;
+
+	case MCC_AST_STATEMENT_TYPE_COMPOUND:
+		for (size_t i = 0; i < statement->statements_count; i++) {
+			lower_statement(lowering, statement->statements[i]);
+		}
+		break;
+	}
+}
+
+// ----------------------------------------------------------------- Functions
+
+// Lowers `function` into `tac_function`, which carries its signature already.
+static bool lower_function(const struct mcc_tac_program *tac,
+                           struct variable_map *variables,
+                           const struct mcc_ast_function *function,
+                           struct mcc_tac_function *tac_function)
+{
+	assert(function->body);
+
+	struct lowering lowering = {.tac = tac, .variables = variables};
+	mcc_tac_builder_init(&lowering.builder, tac_function->name, tac_function->return_type,
+	                     tac_function->parameters_count);
+	variable_map_clear(variables);
+
+	for (size_t i = 0; i < function->parameters_count; i++) {
+		const struct mcc_ast_declaration *parameter = function->parameters[i];
+		assert(parameter->resolved_type);
+
+		struct mcc_tac_variable variable =
+		    mcc_tac_builder_param(&lowering.builder, tac_type(parameter->resolved_type), (uint32_t)i);
+		declare_variable(&lowering, parameter, variable);
+	}
+
+	lower_statement(&lowering, function->body);
+
+	// Only void functions may run off their end.
+	const struct mcc_tac_function *built = &lowering.builder.function;
+	size_t count = built->instructions_count;
+	if (built->return_type == MCC_TAC_TYPE_VOID &&
+	    (count == 0 || built->instructions[count - 1].op != MCC_TAC_OP_RETURN)) {
+		mcc_tac_builder_return(&lowering.builder, (struct mcc_tac_variable){0});
+	}
+
+	return mcc_tac_builder_finish(&lowering.builder, tac_function);
+}
+
+// ------------------------------------------------------------------- Program
+
+struct interning {
+	struct mcc_tac_program *tac;
+	bool ok;
+};
+
+static void intern_string_literal(struct mcc_ast_literal *literal, void *data)
+{
+	struct interning *interning = data;
+	if (!mcc_string_pool_intern(&interning->tac->strings, literal->s_value, strlen(literal->s_value))) {
+		interning->ok = false;
+	}
+}
+
+// Adds all functions of `program` to `tac` and interns every string lowering
+// refers to, so `tac` is not modified while functions are lowered.
+static bool prepare(struct mcc_tac_program *tac, struct mcc_ast_program *program)
+{
+	for (size_t i = 0; i < program->builtins_count; i++) {
+		const char *name = program->builtins[i]->identifier->name;
+		if (!mcc_string_pool_intern(&tac->strings, name, strlen(name))) {
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < program->functions_count; i++) {
+		const struct mcc_ast_function *function = program->functions[i];
+		struct mcc_tac_function *tac_function = mcc_tac_program_add_function(
+		    tac, function->identifier->name, tac_type_from_data_type(function->return_type));
+		if (!tac_function) {
+			return false;
+		}
+		tac_function->parameters_count = function->parameters_count;
+	}
+
+	struct interning interning = {.tac = tac, .ok = true};
+	struct mcc_ast_visitor visitor = {
+	    .traversal = MCC_AST_VISIT_DEPTH_FIRST,
+	    .order = MCC_AST_VISIT_PRE_ORDER,
+	    .userdata = &interning,
+	    .literal_string = intern_string_literal,
+	};
+	for (size_t i = 0; i < program->functions_count && interning.ok; i++) {
+		mcc_ast_visit_function(program->functions[i], &visitor);
+	}
+	return interning.ok;
+}
+
+struct lowering_phase {
+	const struct mcc_tac_program *tac;
+	const struct mcc_ast_program *program;
+
+	// Receives the lowered functions. Each task writes its own function only,
+	// the program's function array is not resized during the phase.
+	struct mcc_tac_function *functions;
+
+	// One variable map per worker, reused for all functions it lowers.
+	struct variable_map *workers;
+
+	// One flag per function.
+	bool *failed;
+};
+
+static void lower_function_task(size_t task, size_t worker, void *data)
+{
+	struct lowering_phase *phase = data;
+
+	phase->failed[task] = !lower_function(phase->tac, &phase->workers[worker], phase->program->functions[task],
+	                                      &phase->functions[task]);
+}
+
+bool mcc_tac_lower_program(struct mcc_tac_program *tac,
+                           struct mcc_ast_program *program,
+                           const struct mcc_tac_lower_options *options)
+{
+	assert(tac);
+	assert(program);
+
+	size_t first = tac->functions_count;
+	if (!prepare(tac, program)) {
+		return false;
+	}
+
+	size_t count = program->functions_count;
+	size_t workers = options && options->threads > 1 ? options->threads : 1;
+	if (workers > count) {
+		workers = count ? count : 1;
+	}
+
+	struct lowering_phase phase = {
+	    .tac = tac,
+	    .program = program,
+	    .functions = tac->functions + first,
+	    .workers = calloc(workers, sizeof(*phase.workers)),
+	    .failed = calloc(count ? count : 1, sizeof(*phase.failed)),
+	};
+
+	bool ok = phase.workers && phase.failed;
+	if (ok) {
+		mcc_parallel_for(count, workers, lower_function_task, &phase);
+		for (size_t i = 0; i < count; i++) {
+			ok &= !phase.failed[i];
+		}
+		for (size_t i = 0; i < workers; i++) {
+			free(phase.workers[i].slots);
+		}
+	}
+
+	free(phase.workers);
+	free(phase.failed);
+	return ok;
+}
@@ -0,0 +1,832 @@
+#include "mcc/tac_parser.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+
+// Type of variables that only occurred where their type is unknown, namely as
+// call arguments. Never present in a finished function.
+#define TYPE_UNKNOWN 0xff
+
+struct parser {
+	struct mcc_tac_program *program;
+
+	// Filepath used for prefixing error messages.
+	const char *filepath;
+
+	// Current line, `cursor` points into it.
+	int line;
+	const char *line_start;
+	const char *cursor;
+
+	// The function under construction, if `in_function` is set. It is added to
+	// the program once complete.
+	struct mcc_tac_function function;
+	bool in_function;
+	int function_line;
+
+	enum mcc_tac_parser_error error;
+	char error_msg[1024];
+};
+
+static void parser_allocation_error(struct parser *parser)
+{
+	if (parser->error == MCC_TAC_PARSER_ERROR_NONE) {
+		parser->error = MCC_TAC_PARSER_ERROR_ALLOCATION_ERROR;
+	}
+}
+
+// Reports a parse error at `line` and `column`, unless there already is an
+// error. Arguments are forwarded to `vsnprintf`.
+static void parser_error_at(struct parser *parser, int line, int column, const char *format, ...)
+{
+	if (parser->error != MCC_TAC_PARSER_ERROR_NONE) {
+		return;
+	}
+
+	parser->error = MCC_TAC_PARSER_ERROR_PARSE_ERROR;
+
+	int prefix_length = snprintf(parser->error_msg, sizeof(parser->error_msg), "%s:%d:%d: error: ",
+	                             parser->filepath ? parser->filepath : "<string>", line, column);
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(parser->error_msg + prefix_length, sizeof(parser->error_msg) - prefix_length, format, args);
+	va_end(args);
+}
+
+#define error(...) \
+	parser_error_at(parser, parser->line, (int)(parser->cursor - parser->line_start) + 1, __VA_ARGS__)
+
+#define failed() (parser->error != MCC_TAC_PARSER_ERROR_NONE)
+
+// ----------------------------------------------------------------- Scanning
+
+static void skip_spaces(struct parser *parser)
+{
+	while (*parser->cursor == ' ' || *parser->cursor == '\t' || *parser->cursor == '\r') {
+		parser->cursor++;
+	}
+}
+
+static bool at_end(struct parser *parser)
+{
+	skip_spaces(parser);
+	return *parser->cursor == '\0' || *parser->cursor == '\n' || *parser->cursor == '#';
+}
+
+static bool accept(struct parser *parser, char c)
+{
+	skip_spaces(parser);
+	if (*parser->cursor != c) {
+		return false;
+	}
+	parser->cursor++;
+	return true;
+}
+
+static void expect(struct parser *parser, char c)
+{
+	if (!failed() && !accept(parser, c)) {
+		error("expected '%c'", c);
+	}
+}
+
+// Reads a word of letters, digits, and underscores. Returns its length, 0 if
+// there is none.
+static size_t word(struct parser *parser, const char **start)
+{
+	skip_spaces(parser);
+	*start = parser->cursor;
+	while (isalnum((unsigned char)*parser->cursor) || *parser->cursor == '_') {
+		parser->cursor++;
+	}
+	return (size_t)(parser->cursor - *start);
+}
+
+static bool word_equals(const char *start, size_t length, const char *s)
+{
+	return strlen(s) == length && memcmp(start, s, length) == 0;
+}
+
+static uint32_t number(struct parser *parser)
+{
+	skip_spaces(parser);
+	if (!isdigit((unsigned char)*parser->cursor)) {
+		error("expected a number");
+		return 0;
+	}
+
+	uint64_t value = 0;
+	while (isdigit((unsigned char)*parser->cursor)) {
+		value = value * 10 + (uint64_t)(*parser->cursor++ - '0');
+		if (value >= UINT32_MAX) {
+			error("number out of range");
+			return 0;
+		}
+	}
+	return (uint32_t)value;
+}
+
+// Reads a number prefixed by `prefix`, like the 3 in `v3` or `L3`.
+static uint32_t prefixed_number(struct parser *parser, char prefix, const char *what)
+{
+	skip_spaces(parser);
+	if (*parser->cursor != prefix || !isdigit((unsigned char)parser->cursor[1])) {
+		error("expected %s", what);
+		return 0;
+	}
+	parser->cursor++;
+
+	uint32_t value = number(parser);
+	if (!failed() && value == 0) {
+		error("%s 0 is reserved", what);
+	}
+	return value;
+}
+
+static enum mcc_tac_type type(struct parser *parser)
+{
+	const char *start;
+	size_t length = word(parser, &start);
+	for (int t = MCC_TAC_TYPE_VOID; t <= MCC_TAC_TYPE_ARRAY; t++) {
+		if (word_equals(start, length, mcc_tac_type_to_string(t))) {
+			return t;
+		}
+	}
+
+	parser->cursor = start;
+	error("expected a type");
+	return MCC_TAC_TYPE_VOID;
+}
+
+// ---------------------------------------------------------------- Variables
+
+// Grows the function's variables to include `variable`, new ones have no type
+// yet.
+static void add_variable(struct parser *parser, uint32_t variable)
+{
+	struct mcc_tac_function *function = &parser->function;
+	if (variable <= function->variables_count) {
+		return;
+	}
+
+	while (function->variable_types_capacity <= variable) {
+		if (!mcc_array_reserve(&function->variable_types, &function->variable_types_capacity,
+		                       function->variable_types_capacity, sizeof(*function->variable_types))) {
+			parser_allocation_error(parser);
+			return;
+		}
+	}
+
+	function->variable_types[0] = MCC_TAC_TYPE_VOID;
+	memset(function->variable_types + function->variables_count + 1, MCC_TAC_TYPE_VOID,
+	       variable - function->variables_count);
+	function->variables_count = variable;
+}
+
+// Records that `variable`, occurring at `at`, has `type`.
+static void set_type(struct parser *parser, uint32_t variable, int type, const char *at)
+{
+	if (failed()) {
+		return;
+	}
+
+	uint8_t *current = &parser->function.variable_types[variable];
+	if (type == MCC_TAC_TYPE_VOID) {
+		parser->cursor = at;
+		error("v%" PRIu32 " cannot be void", variable);
+	} else if (*current == MCC_TAC_TYPE_VOID || *current == TYPE_UNKNOWN) {
+		*current = (uint8_t)type;
+	} else if (type != TYPE_UNKNOWN && *current != type) {
+		parser->cursor = at;
+		error("v%" PRIu32 " is used as %s and %s", variable, mcc_tac_type_to_string(*current),
+		      mcc_tac_type_to_string(type));
+	}
+}
+
+// Reads a variable of `type`, TYPE_UNKNOWN if it is not known.
+static uint32_t variable(struct parser *parser, int type)
+{
+	skip_spaces(parser);
+	const char *start = parser->cursor;
+	uint32_t identifier = prefixed_number(parser, 'v', "variable");
+	if (!failed()) {
+		add_variable(parser, identifier);
+		set_type(parser, identifier, type, start);
+	}
+	return failed() ? 0 : identifier;
+}
+
+static uint32_t label(struct parser *parser)
+{
+	uint32_t identifier = prefixed_number(parser, 'L', "label");
+	if (identifier > parser->function.labels_count) {
+		parser->function.labels_count = identifier;
+	}
+	return identifier;
+}
+
+// ---------------------------------------------------------------- Constants
+
+static uint32_t add_constant(struct parser *parser, uint64_t bits)
+{
+	uint32_t index = 0;
+	if (!mcc_tac_function_add_constant(&parser->function, bits, &index)) {
+		parser_allocation_error(parser);
+	}
+	return index;
+}
+
+static uint32_t add_string(struct parser *parser, const char *string, size_t length)
+{
+	const char *interned = mcc_string_pool_intern(&parser->program->strings, string, length);
+	uint32_t index = 0;
+	if (!interned || !mcc_tac_function_add_string(&parser->function, interned, &index)) {
+		parser_allocation_error(parser);
+	}
+	return index;
+}
+
+// Reads a quoted string, undoing the escapes of `mcc_tac_print_program`.
+static uint32_t string_constant(struct parser *parser)
+{
+	expect(parser, '"');
+	if (failed()) {
+		return 0;
+	}
+
+	char *characters = NULL;
+	size_t length = 0;
+	size_t capacity = 0;
+	while (*parser->cursor != '"') {
+		char c = *parser->cursor++;
+		if (c == '\0' || c == '\n') {
+			parser->cursor--;
+			error("unterminated string");
+			break;
+		}
+		if (c == '\\') {
+			switch (*parser->cursor++) {
+			case '"':
+				c = '"';
+				break;
+			case '\\':
+				c = '\\';
+				break;
+			case 'n':
+				c = '\n';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			default:
+				parser->cursor--;
+				error("unknown escape sequence");
+				break;
+			}
+		}
+		if (failed() || !mcc_array_push(characters, length, capacity, c)) {
+			parser_allocation_error(parser);
+			break;
+		}
+	}
+
+	uint32_t index = 0;
+	if (!failed()) {
+		parser->cursor++;
+		index = add_string(parser, characters ? characters : "", length);
+	}
+	free(characters);
+	return index;
+}
+
+static uint32_t constant(struct parser *parser, enum mcc_tac_type type)
+{
+	skip_spaces(parser);
+	const char *start = parser->cursor;
+	char *end = NULL;
+	errno = 0;
+
+	switch (type) {
+	case MCC_TAC_TYPE_INT: {
+		long value = strtol(start, &end, 10);
+		if (end == start || errno != 0) {
+			error("expected an int");
+			return 0;
+		}
+		parser->cursor = end;
+		return add_constant(parser, mcc_tac_int_bits(value));
+	}
+
+	case MCC_TAC_TYPE_FLOAT: {
+		double value = strtod(start, &end);
+		if (end == start) {
+			error("expected a float");
+			return 0;
+		}
+		parser->cursor = end;
+		return add_constant(parser, mcc_tac_float_bits(value));
+	}
+
+	case MCC_TAC_TYPE_BOOL: {
+		size_t length = word(parser, &start);
+		if (!word_equals(start, length, "true") && !word_equals(start, length, "false")) {
+			parser->cursor = start;
+			error("expected true or false");
+			return 0;
+		}
+		return add_constant(parser, length == 4 ? 1 : 0);
+	}
+
+	case MCC_TAC_TYPE_STRING:
+		return string_constant(parser);
+
+	case MCC_TAC_TYPE_VOID:
+	case MCC_TAC_TYPE_ARRAY:
+		break;
+	}
+
+	error("there are no %s constants", mcc_tac_type_to_string(type));
+	return 0;
+}
+
+// ------------------------------------------------------------- Instructions
+
+static enum mcc_tac_op op(struct parser *parser)
+{
+	const char *start;
+	size_t length = word(parser, &start);
+	for (int op = MCC_TAC_OP_CONST; op <= MCC_TAC_OP_PHI; op++) {
+		if (op != MCC_TAC_OP_LABEL && word_equals(start, length, mcc_tac_op_to_string(op))) {
+			return op;
+		}
+	}
+
+	parser->cursor = start;
+	error("expected an instruction");
+	return MCC_TAC_OP_NOP;
+}
+
+static uint32_t add_operands(struct parser *parser, const uint32_t *operands, size_t count)
+{
+	uint32_t index = 0;
+	if (!failed() && !mcc_tac_function_add_operands(&parser->function, operands, count, &index)) {
+		parser_allocation_error(parser);
+	}
+	return index;
+}
+
+// Reads the callee and the parenthesised arguments of a call.
+static void call(struct parser *parser, struct mcc_tac_instruction *instruction)
+{
+	const char *name;
+	size_t length = word(parser, &name);
+	if (length == 0) {
+		error("expected a function name");
+		return;
+	}
+	instruction->arg1 = add_string(parser, name, length);
+
+	// The argument count comes first, it is filled in at the end.
+	uint32_t *operands = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+	if (!mcc_array_push(operands, count, capacity, 0)) {
+		parser_allocation_error(parser);
+	}
+
+	expect(parser, '(');
+	if (!failed() && !accept(parser, ')')) {
+		do {
+			uint32_t argument = variable(parser, TYPE_UNKNOWN);
+			if (!failed() && !mcc_array_push(operands, count, capacity, argument)) {
+				parser_allocation_error(parser);
+			}
+		} while (!failed() && accept(parser, ','));
+		expect(parser, ')');
+	}
+
+	if (!failed()) {
+		operands[0] = (uint32_t)(count - 1);
+		instruction->arg2 = add_operands(parser, operands, count);
+	}
+	free(operands);
+}
+
+// Reads the bracketed (label, value) pairs of a phi.
+static void phi(struct parser *parser, struct mcc_tac_instruction *instruction)
+{
+	uint32_t *operands = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+
+	do {
+		expect(parser, '[');
+		uint32_t pair[2] = {label(parser), 0};
+		expect(parser, ',');
+		pair[1] = failed() ? 0 : variable(parser, instruction->type);
+		expect(parser, ']');
+
+		for (int i = 0; i < 2 && !failed(); i++) {
+			if (!mcc_array_push(operands, count, capacity, pair[i])) {
+				parser_allocation_error(parser);
+			}
+		}
+	} while (!failed() && accept(parser, ','));
+
+	if (!failed()) {
+		instruction->arg1 = add_operands(parser, operands, count);
+		instruction->arg2 = (uint32_t)(count / 2);
+	}
+	free(operands);
+}
+
+// Reads the operands following the op and type of `instruction`.
+static void operands(struct parser *parser, struct mcc_tac_instruction *instruction)
+{
+	enum mcc_tac_type type = instruction->type;
+
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_CONST:
+		instruction->arg1 = constant(parser, type);
+		break;
+
+	case MCC_TAC_OP_ASSIGN:
+	case MCC_TAC_OP_NEG:
+	case MCC_TAC_OP_NOT:
+		instruction->arg1 = variable(parser, type);
+		break;
+
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+		instruction->arg1 = variable(parser, type);
+		expect(parser, ',');
+		instruction->arg2 = failed() ? 0 : variable(parser, type);
+		break;
+
+	case MCC_TAC_OP_ARRAY: {
+		skip_spaces(parser);
+		const char *start = parser->cursor;
+		uint32_t size = number(parser);
+		if (!failed() && size == 0) {
+			parser->cursor = start;
+			error("arrays cannot be empty");
+		}
+		instruction->arg1 = failed() ? 0 : add_constant(parser, mcc_tac_int_bits(size));
+		break;
+	}
+
+	case MCC_TAC_OP_LOAD:
+		instruction->arg1 = variable(parser, MCC_TAC_TYPE_ARRAY);
+		expect(parser, ',');
+		instruction->arg2 = failed() ? 0 : variable(parser, MCC_TAC_TYPE_INT);
+		break;
+
+	case MCC_TAC_OP_STORE:
+		instruction->result = variable(parser, MCC_TAC_TYPE_ARRAY);
+		expect(parser, ',');
+		instruction->arg1 = failed() ? 0 : variable(parser, MCC_TAC_TYPE_INT);
+		expect(parser, ',');
+		instruction->arg2 = failed() ? 0 : variable(parser, type);
+		break;
+
+	case MCC_TAC_OP_JUMP:
+		instruction->arg2 = label(parser);
+		break;
+
+	case MCC_TAC_OP_JUMP_IF:
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		instruction->type = MCC_TAC_TYPE_BOOL;
+		instruction->arg2 = label(parser);
+		expect(parser, ',');
+		instruction->arg1 = failed() ? 0 : variable(parser, MCC_TAC_TYPE_BOOL);
+		break;
+
+	case MCC_TAC_OP_PARAM:
+		instruction->arg1 = number(parser);
+		break;
+
+	case MCC_TAC_OP_CALL:
+		call(parser, instruction);
+		break;
+
+	case MCC_TAC_OP_RETURN:
+		if (type != MCC_TAC_TYPE_VOID) {
+			instruction->arg1 = variable(parser, type);
+		}
+		break;
+
+	case MCC_TAC_OP_PHI:
+		phi(parser, instruction);
+		break;
+
+	case MCC_TAC_OP_NOP:
+	case MCC_TAC_OP_LABEL:
+		assert(false);
+		break;
+	}
+}
+
+// The type of the value defined by `instruction`.
+static enum mcc_tac_type result_type(const struct mcc_tac_instruction *instruction)
+{
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+		return MCC_TAC_TYPE_BOOL;
+	case MCC_TAC_OP_ARRAY:
+		return MCC_TAC_TYPE_ARRAY;
+	default:
+		return instruction->type;
+	}
+}
+
+static void append(struct parser *parser, struct mcc_tac_instruction instruction)
+{
+	if (!failed() && !mcc_tac_function_append(&parser->function, instruction)) {
+		parser_allocation_error(parser);
+	}
+}
+
+// Parses `[vN =] OP [type] operands`.
+static void parse_instruction(struct parser *parser)
+{
+	uint32_t result = 0;
+	skip_spaces(parser);
+	const char *start = parser->cursor;
+	if (*start == 'v' && isdigit((unsigned char)start[1])) {
+		result = prefixed_number(parser, 'v', "variable");
+		expect(parser, '=');
+	}
+
+	const char *op_start = parser->cursor;
+	struct mcc_tac_instruction instruction = {.op = failed() ? MCC_TAC_OP_NOP : op(parser)};
+	if (failed()) {
+		return;
+	}
+
+	bool control_flow = instruction.op >= MCC_TAC_OP_JUMP && instruction.op <= MCC_TAC_OP_JUMP_IF_NOT;
+	instruction.type = control_flow ? MCC_TAC_TYPE_VOID : type(parser);
+
+	// Only calls of non-void functions may drop their result.
+	bool defines = mcc_tac_op_defines_result(instruction.op);
+	bool optional = instruction.op == MCC_TAC_OP_CALL && instruction.type != MCC_TAC_TYPE_VOID;
+	if (result != 0 && (!defines || (instruction.op == MCC_TAC_OP_CALL && !optional))) {
+		parser->cursor = start;
+		error("%s does not define a variable", mcc_tac_op_to_string(instruction.op));
+	} else if (result == 0 && defines && instruction.op != MCC_TAC_OP_CALL) {
+		parser->cursor = op_start;
+		error("%s has to define a variable", mcc_tac_op_to_string(instruction.op));
+	}
+
+	operands(parser, &instruction);
+	if (result != 0 && !failed()) {
+		instruction.result = result;
+		add_variable(parser, result);
+		set_type(parser, result, result_type(&instruction), start);
+	}
+
+	if (!failed() && !at_end(parser)) {
+		error("unexpected '%c'", *parser->cursor);
+	}
+	append(parser, instruction);
+}
+
+// ---------------------------------------------------------------- Functions
+
+// Completes the current function and adds it to the program.
+static void finish_function(struct parser *parser)
+{
+	if (!parser->in_function) {
+		return;
+	}
+	parser->in_function = false;
+
+	struct mcc_tac_function *function = &parser->function;
+	int line = parser->function_line;
+
+	for (uint32_t v = 1; !failed() && v <= function->variables_count; v++) {
+		if (function->variable_types[v] == TYPE_UNKNOWN) {
+			parser_error_at(parser, line, 1, "the type of v%" PRIu32 " cannot be inferred", v);
+		} else if (function->variable_types[v] == MCC_TAC_TYPE_VOID) {
+			function->variable_types[v] = MCC_TAC_TYPE_INT;
+		}
+	}
+
+	// Jumps have to target labels placed exactly once.
+	bool *placed = failed() ? NULL : calloc((size_t)function->labels_count + 1, sizeof(*placed));
+	if (!failed() && !placed) {
+		parser_allocation_error(parser);
+	}
+	for (size_t i = 0; !failed() && i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_LABEL) {
+			if (placed[instruction->arg2]) {
+				parser_error_at(parser, line, 1, "L%" PRIu32 " is placed twice in %s",
+				                instruction->arg2, function->name);
+			}
+			placed[instruction->arg2] = true;
+		}
+	}
+	for (size_t i = 0; !failed() && i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		bool jump = instruction->op >= MCC_TAC_OP_JUMP && instruction->op <= MCC_TAC_OP_JUMP_IF_NOT;
+		if (jump && !placed[instruction->arg2]) {
+			parser_error_at(parser, line, 1, "L%" PRIu32 " is not placed in %s", instruction->arg2,
+			                function->name);
+		}
+	}
+	free(placed);
+
+	if (!failed() && mcc_tac_program_find_function(parser->program, function->name)) {
+		parser_error_at(parser, line, 1, "%s is defined twice", function->name);
+	}
+
+	struct mcc_tac_function *added = NULL;
+	if (!failed()) {
+		added = mcc_tac_program_add_function(parser->program, function->name, function->return_type);
+		if (!added) {
+			parser_allocation_error(parser);
+		}
+	}
+
+	if (added) {
+		const char *name = added->name;
+		*added = *function;
+		added->name = name;
+	} else {
+		mcc_tac_function_deinit(function);
+	}
+	*function = (struct mcc_tac_function){0};
+}
+
+// Parses `function <type> <name>(<parameters>)`.
+static void parse_function(struct parser *parser)
+{
+	finish_function(parser);
+	if (failed()) {
+		return;
+	}
+
+	enum mcc_tac_type return_type = type(parser);
+	const char *name;
+	size_t length = failed() ? 0 : word(parser, &name);
+	if (!failed() && length == 0) {
+		error("expected a function name");
+	}
+	expect(parser, '(');
+	uint32_t parameters = failed() ? 0 : number(parser);
+	expect(parser, ')');
+	if (!failed() && !at_end(parser)) {
+		error("unexpected '%c'", *parser->cursor);
+	}
+	if (failed()) {
+		return;
+	}
+
+	const char *interned = mcc_string_pool_intern(&parser->program->strings, name, length);
+	if (!interned) {
+		parser_allocation_error(parser);
+		return;
+	}
+
+	parser->function = (struct mcc_tac_function){
+	    .name = interned,
+	    .return_type = return_type,
+	    .parameters_count = parameters,
+	};
+	parser->in_function = true;
+	parser->function_line = parser->line;
+}
+
+static void parse_line(struct parser *parser, const char *line)
+{
+	parser->line++;
+	parser->line_start = line;
+	parser->cursor = line;
+
+	if (at_end(parser)) {
+		return;
+	}
+
+	const char *start = parser->cursor;
+	const char *keyword;
+	size_t length = word(parser, &keyword);
+	if (word_equals(keyword, length, "function")) {
+		parse_function(parser);
+		return;
+	}
+	parser->cursor = start;
+
+	if (!parser->in_function) {
+		error("expected a function");
+		return;
+	}
+
+	if (*start == 'L' && isdigit((unsigned char)start[1])) {
+		uint32_t placed = label(parser);
+		expect(parser, ':');
+		if (!failed() && !at_end(parser)) {
+			error("unexpected '%c'", *parser->cursor);
+		}
+		append(parser, (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL, .arg2 = placed});
+		return;
+	}
+
+	parse_instruction(parser);
+}
+
+void mcc_tac_parser_result_print_error(FILE *out, const struct mcc_tac_parser_result *result)
+{
+	assert(out);
+	assert(result);
+
+	if (*result->error_msg) {
+		fprintf(out, "%s\n", result->error_msg);
+		return;
+	}
+
+	switch (result->error) {
+	case MCC_TAC_PARSER_ERROR_NONE:
+		fputs("no error\n", out);
+		break;
+	case MCC_TAC_PARSER_ERROR_PARSE_ERROR:
+		fputs("parser error\n", out);
+		break;
+	case MCC_TAC_PARSER_ERROR_ALLOCATION_ERROR:
+		fputs("allocation error\n", out);
+		break;
+	case MCC_TAC_PARSER_ERROR_UNABLE_TO_OPEN_STREAM:
+		fputs("unable to open stream\n", out);
+		break;
+	}
+}
+
+struct mcc_tac_parser_result mcc_tac_parse_file(struct mcc_tac_program *program, FILE *input, const char *filepath)
+{
+	assert(program);
+	assert(input);
+
+	struct parser parser = {
+	    .program = program,
+	    .filepath = filepath,
+	};
+
+	char *line = NULL;
+	size_t capacity = 0;
+	while (parser.error == MCC_TAC_PARSER_ERROR_NONE && getline(&line, &capacity, input) != -1) {
+		parse_line(&parser, line);
+	}
+	free(line);
+
+	if (parser.error == MCC_TAC_PARSER_ERROR_NONE) {
+		finish_function(&parser);
+	}
+	if (parser.in_function) {
+		mcc_tac_function_deinit(&parser.function);
+	}
+
+	struct mcc_tac_parser_result result = {.error = parser.error};
+	snprintf(result.error_msg, sizeof(result.error_msg), "%s", parser.error_msg);
+	return result;
+}
+
+struct mcc_tac_parser_result mcc_tac_parse_string(struct mcc_tac_program *program, const char *input)
+{
+	assert(program);
+	assert(input);
+
+	FILE *in = fmemopen((void *)input, strlen(input), "r");
+	if (!in) {
+		return (struct mcc_tac_parser_result){
+		    .error = MCC_TAC_PARSER_ERROR_UNABLE_TO_OPEN_STREAM,
+		};
+	}
+
+	struct mcc_tac_parser_result result = mcc_tac_parse_file(program, in, NULL);
+
+	fclose(in);
+
+	return result;
+}
@@ -0,0 +1,227 @@
+#include "mcc/tailrec.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+
+struct tailrec {
+	struct mcc_tac_function *function;
+
+	// Instruction index of each label, SIZE_MAX if not placed.
+	size_t *label_positions;
+
+	// Parameter variable of each parameter, 0 if it has no PARAM.
+	uint32_t *parameters;
+
+	// Index right after the PARAM instructions starting the function.
+	size_t start;
+};
+
+// Returns whether the call at `index` is a call of the function to itself
+// whose result is returned, following copies of the result and jumps.
+static bool is_tail_call(const struct tailrec *tailrec, size_t index)
+{
+	const struct mcc_tac_function *function = tailrec->function;
+	const struct mcc_tac_instruction *call = &function->instructions[index];
+	if (call->op != MCC_TAC_OP_CALL || strcmp(function->strings[call->arg1], function->name) != 0 ||
+	    function->operands[call->arg2] != function->parameters_count) {
+		return false;
+	}
+
+	// Every instruction is passed at most once unless the path loops.
+	uint32_t value = call->result;
+	size_t i = index + 1;
+	for (size_t steps = 0; i < function->instructions_count && steps < function->instructions_count; steps++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		switch ((enum mcc_tac_op)instruction->op) {
+		case MCC_TAC_OP_NOP:
+		case MCC_TAC_OP_LABEL:
+			i++;
+			continue;
+
+		case MCC_TAC_OP_JUMP:
+			if (instruction->arg2 > function->labels_count ||
+			    tailrec->label_positions[instruction->arg2] == SIZE_MAX) {
+				return false;
+			}
+			i = tailrec->label_positions[instruction->arg2];
+			continue;
+
+		case MCC_TAC_OP_ASSIGN:
+			if (value == 0 || instruction->arg1 != value) {
+				return false;
+			}
+			value = instruction->result;
+			i++;
+			continue;
+
+		case MCC_TAC_OP_RETURN:
+			return function->return_type == MCC_TAC_TYPE_VOID || (value != 0 && instruction->arg1 == value);
+
+		default:
+			return false;
+		}
+	}
+
+	// Void functions may run off their end.
+	return i == function->instructions_count && function->return_type == MCC_TAC_TYPE_VOID;
+}
+
+static bool is_parameter(const struct tailrec *tailrec, uint32_t variable)
+{
+	for (size_t p = 0; p < tailrec->function->parameters_count; p++) {
+		if (tailrec->parameters[p] != 0 && tailrec->parameters[p] == variable) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Replaces the call at `index` by copies of its arguments to the parameters
+// and a jump to `entry`.
+static bool replace_call(struct tailrec *tailrec, size_t index, uint32_t entry)
+{
+	struct mcc_tac_function *function = tailrec->function;
+	const struct mcc_tac_instruction call = function->instructions[index];
+	size_t count = function->parameters_count;
+
+	// At most a temporary and a copy per parameter, and the jump.
+	uint32_t *arguments = malloc((count + 1) * sizeof(*arguments));
+	struct mcc_tac_instruction *sequence = malloc((2 * count + 1) * sizeof(*sequence));
+	bool ok = arguments && sequence;
+	if (ok) {
+		memcpy(arguments, &function->operands[call.arg2 + 1], count * sizeof(*arguments));
+	}
+
+	// Arguments which are parameters themselves may be assigned before
+	// they are read, they are saved to temporaries first.
+	size_t length = 0;
+	for (size_t p = 0; ok && p < count; p++) {
+		uint32_t parameter = tailrec->parameters[p];
+		if (parameter == 0 || arguments[p] == parameter || !is_parameter(tailrec, arguments[p])) {
+			continue;
+		}
+
+		enum mcc_tac_type type = mcc_tac_function_variable_type(function, parameter);
+		uint32_t temporary = mcc_tac_function_new_variable(function, type).identifier;
+		ok = temporary != 0;
+		sequence[length++] = (struct mcc_tac_instruction){
+		    .op = MCC_TAC_OP_ASSIGN,
+		    .type = (uint8_t)type,
+		    .result = temporary,
+		    .arg1 = arguments[p],
+		};
+		arguments[p] = temporary;
+	}
+
+	for (size_t p = 0; ok && p < count; p++) {
+		uint32_t parameter = tailrec->parameters[p];
+		if (parameter == 0 || arguments[p] == parameter) {
+			continue;
+		}
+		sequence[length++] = (struct mcc_tac_instruction){
+		    .op = MCC_TAC_OP_ASSIGN,
+		    .type = (uint8_t)mcc_tac_function_variable_type(function, parameter),
+		    .result = parameter,
+		    .arg1 = arguments[p],
+		};
+	}
+
+	if (ok) {
+		sequence[length++] = (struct mcc_tac_instruction){.op = MCC_TAC_OP_JUMP, .arg2 = entry};
+		ok = mcc_tac_function_insert(function, index + 1, sequence, length);
+	}
+	if (ok) {
+		mcc_tac_function_remove(function, index);
+	}
+
+	free(arguments);
+	free(sequence);
+	return ok;
+}
+
+static bool find_parameters(struct tailrec *tailrec)
+{
+	const struct mcc_tac_function *function = tailrec->function;
+	tailrec->label_positions = malloc(((size_t)function->labels_count + 1) * sizeof(*tailrec->label_positions));
+	tailrec->parameters = calloc(function->parameters_count + 1, sizeof(*tailrec->parameters));
+	if (!tailrec->label_positions || !tailrec->parameters) {
+		return false;
+	}
+
+	for (size_t l = 0; l <= function->labels_count; l++) {
+		tailrec->label_positions[l] = SIZE_MAX;
+	}
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_LABEL && instruction->arg2 <= function->labels_count) {
+			tailrec->label_positions[instruction->arg2] = i;
+		}
+	}
+
+	while (tailrec->start < function->instructions_count) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[tailrec->start];
+		if (instruction->op == MCC_TAC_OP_PARAM && instruction->arg1 < function->parameters_count) {
+			tailrec->parameters[instruction->arg1] = instruction->result;
+		} else if (instruction->op != MCC_TAC_OP_NOP) {
+			break;
+		}
+		tailrec->start++;
+	}
+	return true;
+}
+
+bool mcc_tailrec_function(struct mcc_tac_function *function, struct mcc_tailrec_stats *stats)
+{
+	assert(function);
+
+	if (mcc_tac_function_creates_arrays(function)) {
+		return true;
+	}
+
+	struct tailrec tailrec = {.function = function};
+	size_t *calls = NULL;
+	size_t calls_count = 0;
+	size_t calls_capacity = 0;
+	bool ok = find_parameters(&tailrec);
+
+	for (size_t i = 0; ok && i < function->instructions_count; i++) {
+		if (is_tail_call(&tailrec, i)) {
+			ok = mcc_array_push(calls, calls_count, calls_capacity, i);
+		}
+	}
+
+	// Room for all insertions is reserved up front, so the label jumped to
+	// is certain to be placed once a call is replaced.
+	size_t inserted = calls_count * (2 * function->parameters_count + 1) + 1;
+	ok = ok && (calls_count == 0 || mcc_tac_function_reserve(function, function->instructions_count + inserted));
+
+	// Calls are replaced back to front, inserting leaves the indices of
+	// earlier ones intact. The label goes in last, in front of all of them.
+	size_t eliminated = 0;
+	if (ok && calls_count > 0) {
+		uint32_t entry = mcc_tac_function_new_label(function);
+		for (size_t c = calls_count; ok && c-- > 0;) {
+			ok = replace_call(&tailrec, calls[c], entry);
+			eliminated += ok;
+		}
+
+		// This cannot fail, the room is reserved.
+		struct mcc_tac_instruction label = {.op = MCC_TAC_OP_LABEL, .arg2 = entry};
+		if (eliminated > 0) {
+			mcc_tac_function_insert(function, tailrec.start, &label, 1);
+		}
+	}
+
+	if (stats) {
+		stats->eliminated += eliminated;
+	}
+
+	free(tailrec.label_positions);
+	free(tailrec.parameters);
+	free(calls);
+	return ok;
+}
@@ -0,0 +1,158 @@
+#include "mcc/type.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INITIAL_CAPACITY 16
+
+static const struct mcc_type scalars[] = {
+    [MCC_TYPE_KIND_VOID] = {.kind = MCC_TYPE_KIND_VOID, .size = 0, .alignment = 1},
+    [MCC_TYPE_KIND_BOOL] = {.kind = MCC_TYPE_KIND_BOOL, .size = 1, .alignment = 1},
+    [MCC_TYPE_KIND_INT] = {.kind = MCC_TYPE_KIND_INT, .size = 4, .alignment = 4},
+    [MCC_TYPE_KIND_FLOAT] = {.kind = MCC_TYPE_KIND_FLOAT, .size = 4, .alignment = 4},
+
+    // Strings are passed around as pointers.
+    [MCC_TYPE_KIND_STRING] = {.kind = MCC_TYPE_KIND_STRING, .size = 4, .alignment = 4},
+};
+
+const struct mcc_type *mcc_type_scalar(enum mcc_type_kind kind)
+{
+	assert(kind != MCC_TYPE_KIND_ARRAY);
+
+	return &scalars[kind];
+}
+
+static const char *kind_to_string(enum mcc_type_kind kind)
+{
+	switch (kind) {
+	case MCC_TYPE_KIND_VOID:
+		return "void";
+	case MCC_TYPE_KIND_BOOL:
+		return "bool";
+	case MCC_TYPE_KIND_INT:
+		return "int";
+	case MCC_TYPE_KIND_FLOAT:
+		return "float";
+	case MCC_TYPE_KIND_STRING:
+		return "string";
+	case MCC_TYPE_KIND_ARRAY:
+		return "array";
+	}
+
+	return "unknown type";
+}
+
+const char *mcc_type_to_string(const struct mcc_type *type, char *buffer, size_t size)
+{
+	assert(type);
+	assert(buffer);
+	assert(size > 0);
+
+	if (type->kind == MCC_TYPE_KIND_ARRAY) {
+		snprintf(buffer, size, "%s[%ld]", kind_to_string(type->element->kind), type->array_size);
+	} else {
+		snprintf(buffer, size, "%s", kind_to_string(type->kind));
+	}
+	return buffer;
+}
+
+// ----------------------------------------------------------------- Type Pool
+
+static size_t hash_array(const struct mcc_type *element, long size)
+{
+	uint64_t hash = (uint64_t)(uintptr_t)element ^ ((uint64_t)size * UINT64_C(0x9E3779B97F4A7C15));
+	return (size_t)((hash * UINT64_C(11400714819323198485)) >> 32);
+}
+
+static size_t find_slot(struct mcc_type **slots, size_t capacity, const struct mcc_type *element, long size)
+{
+	assert(capacity > 0);
+
+	size_t mask = capacity - 1;
+	size_t index = hash_array(element, size) & mask;
+	while (slots[index] && (slots[index]->element != element || slots[index]->array_size != size)) {
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+static bool grow_slots(struct mcc_type_pool *pool)
+{
+	assert(pool);
+
+	size_t new_capacity = pool->capacity ? pool->capacity * 2 : INITIAL_CAPACITY;
+	struct mcc_type **new_slots = calloc(new_capacity, sizeof(*new_slots));
+	if (!new_slots) {
+		return false;
+	}
+
+	for (size_t i = 0; i < pool->capacity; i++) {
+		struct mcc_type *type = pool->slots[i];
+		if (type) {
+			new_slots[find_slot(new_slots, new_capacity, type->element, type->array_size)] = type;
+		}
+	}
+
+	free(pool->slots);
+	pool->slots = new_slots;
+	pool->capacity = new_capacity;
+	return true;
+}
+
+void mcc_type_pool_init(struct mcc_type_pool *pool)
+{
+	assert(pool);
+
+	*pool = (struct mcc_type_pool){0};
+}
+
+void mcc_type_pool_deinit(struct mcc_type_pool *pool)
+{
+	if (!pool) {
+		return;
+	}
+
+	for (size_t i = 0; i < pool->capacity; i++) {
+		free(pool->slots[i]);
+	}
+	free(pool->slots);
+
+	*pool = (struct mcc_type_pool){0};
+}
+
+const struct mcc_type *mcc_type_pool_array(struct mcc_type_pool *pool, const struct mcc_type *element, long size)
+{
+	assert(pool);
+	assert(element);
+	assert(element->kind != MCC_TYPE_KIND_ARRAY && element->kind != MCC_TYPE_KIND_VOID);
+	assert(size >= 0);
+
+	// Keep the load factor below 3/4 to bound probe sequences.
+	if ((pool->count + 1) * 4 > pool->capacity * 3 && !grow_slots(pool)) {
+		return NULL;
+	}
+
+	size_t index = find_slot(pool->slots, pool->capacity, element, size);
+	if (pool->slots[index]) {
+		return pool->slots[index];
+	}
+
+	struct mcc_type *type = malloc(sizeof(*type));
+	if (!type) {
+		return NULL;
+	}
+
+	*type = (struct mcc_type){
+	    .kind = MCC_TYPE_KIND_ARRAY,
+	    .element = element,
+	    .array_size = size,
+	    .size = (size_t)size <= SIZE_MAX / element->size ? (size_t)size * element->size : SIZE_MAX,
+	    .alignment = element->alignment,
+	};
+
+	pool->slots[index] = type;
+	pool->count++;
+	return type;
+}
@@ -0,0 +1,688 @@
+#include "mcc/unroll.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/cfg.h"
+#include "mcc/loops.h"
+
+// A counted loop, running while `variable op bound` holds, with `variable`
+// advanced by `step` in every iteration.
+struct counted {
+	uint32_t header, body, preheader;
+	uint32_t label;
+	uint32_t variable;
+	int32_t step;
+	enum mcc_tac_op op;
+
+	uint32_t bound;
+	bool bound_constant;
+	int32_t bound_value;
+
+	bool initial_constant;
+	int32_t initial_value;
+
+	// Instructions of the body, without the jump back and tombstones.
+	size_t body_size;
+};
+
+// Instructions of `code` inserted before `index`.
+struct insertion {
+	size_t index;
+	size_t begin, count;
+};
+
+struct unroll {
+	struct mcc_tac_function *function;
+	uint32_t factor;
+	size_t budget;
+
+	struct mcc_cfg cfg;
+	struct mcc_loops loops;
+
+	// Assignments and reads of each variable in the function and in the body
+	// of the current loop.
+	uint32_t *definitions;
+	uint32_t *uses;
+	uint32_t *body_definitions;
+	uint32_t *body_uses;
+
+	// Variables assigned in the body and read before being assigned there
+	// are marked with `stamp`.
+	uint32_t *assigned;
+	uint32_t *exposed;
+	uint32_t stamp;
+
+	// Variables renamed in each copy of the body, with their current names.
+	uint32_t *locals;
+	size_t locals_count;
+	uint32_t *renames;
+
+	struct mcc_tac_instruction *code;
+	size_t code_count;
+	size_t code_capacity;
+	struct insertion *insertions;
+	size_t insertions_count;
+	size_t insertions_capacity;
+	bool failed;
+
+	size_t unrolled;
+	size_t copies;
+};
+
+static void unroll_deinit(struct unroll *unroll)
+{
+	mcc_cfg_deinit(&unroll->cfg);
+	mcc_loops_deinit(&unroll->loops);
+	free(unroll->definitions);
+	free(unroll->uses);
+	free(unroll->body_definitions);
+	free(unroll->body_uses);
+	free(unroll->assigned);
+	free(unroll->exposed);
+	free(unroll->locals);
+	free(unroll->renames);
+	free(unroll->code);
+	free(unroll->insertions);
+}
+
+static void count_use(uint32_t *variable, void *userdata)
+{
+	uint32_t *uses = userdata;
+	uses[*variable]++;
+}
+
+static void clear_use(uint32_t *variable, void *userdata)
+{
+	uint32_t *uses = userdata;
+	uses[*variable] = 0;
+}
+
+static bool unroll_init(struct unroll *unroll)
+{
+	struct mcc_tac_function *function = unroll->function;
+	if (!mcc_cfg_build(&unroll->cfg, function) || !mcc_loops_find(&unroll->loops, &unroll->cfg)) {
+		return false;
+	}
+
+	size_t variables = function->variables_count + 1;
+	unroll->definitions = calloc(variables, sizeof(*unroll->definitions));
+	unroll->uses = calloc(variables, sizeof(*unroll->uses));
+	unroll->body_definitions = calloc(variables, sizeof(*unroll->body_definitions));
+	unroll->body_uses = calloc(variables, sizeof(*unroll->body_uses));
+	unroll->assigned = calloc(variables, sizeof(*unroll->assigned));
+	unroll->exposed = calloc(variables, sizeof(*unroll->exposed));
+	unroll->locals = malloc(variables * sizeof(*unroll->locals));
+	unroll->renames = calloc(variables, sizeof(*unroll->renames));
+	if (!unroll->definitions || !unroll->uses || !unroll->body_definitions || !unroll->body_uses ||
+	    !unroll->assigned || !unroll->exposed || !unroll->locals || !unroll->renames) {
+		return false;
+	}
+
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		unroll->definitions[mcc_tac_instruction_definition(instruction)]++;
+		mcc_tac_function_visit_uses(function, instruction, count_use, unroll->uses);
+	}
+	return true;
+}
+
+// ------------------------------------------------------------ Recognition
+
+static bool is_int_constant(const struct mcc_tac_instruction *instruction)
+{
+	return instruction->op == MCC_TAC_OP_CONST && instruction->type == MCC_TAC_TYPE_INT;
+}
+
+// Returns whether `variable` is a constant assigned once, within the header
+// or the body before instruction `i`, and its value.
+static bool constant_value(const struct unroll *unroll,
+                           const struct counted *counted,
+                           uint32_t variable,
+                           size_t i,
+                           int32_t *value)
+{
+	if (unroll->definitions[variable] != 1) {
+		return false;
+	}
+	const struct mcc_tac_function *function = unroll->function;
+	const struct mcc_cfg_block *header = &unroll->cfg.blocks[counted->header];
+	const struct mcc_cfg_block *body = &unroll->cfg.blocks[counted->body];
+	for (size_t d = header->begin; d < body->end && d < i; d++) {
+		const struct mcc_tac_instruction *definition = &function->instructions[d];
+		if (mcc_tac_instruction_definition(definition) != variable) {
+			continue;
+		}
+		if (!is_int_constant(definition)) {
+			return false;
+		}
+		*value = (int32_t)mcc_tac_bits_int(function->constants[definition->arg1]);
+		return true;
+	}
+	return false;
+}
+
+// Returns whether `variable` is assigned once in the body, by adding a
+// constant to itself, and the step.
+static bool is_induction_variable(const struct unroll *unroll,
+                                  const struct counted *counted,
+                                  uint32_t variable,
+                                  int32_t *step)
+{
+	if (unroll->body_definitions[variable] != 1 ||
+	    mcc_tac_function_variable_type(unroll->function, variable) != MCC_TAC_TYPE_INT) {
+		return false;
+	}
+
+	const struct mcc_cfg_block *body = &unroll->cfg.blocks[counted->body];
+	for (size_t i = body->begin; i < body->end; i++) {
+		const struct mcc_tac_instruction *instruction = &unroll->function->instructions[i];
+		if (mcc_tac_instruction_definition(instruction) != variable) {
+			continue;
+		}
+		uint32_t other;
+		if (instruction->op == MCC_TAC_OP_ADD && instruction->arg1 == variable) {
+			other = instruction->arg2;
+		} else if (instruction->op == MCC_TAC_OP_ADD && instruction->arg2 == variable) {
+			other = instruction->arg1;
+		} else if (instruction->op == MCC_TAC_OP_SUB && instruction->arg1 == variable) {
+			other = instruction->arg2;
+		} else {
+			return false;
+		}
+		int32_t value;
+		if (other == variable || !constant_value(unroll, counted, other, i, &value) || value == 0 ||
+		    (instruction->op == MCC_TAC_OP_SUB && value == INT32_MIN)) {
+			return false;
+		}
+		*step = instruction->op == MCC_TAC_OP_SUB ? -value : value;
+		return true;
+	}
+	return false;
+}
+
+// Comparison holding if the operands are swapped.
+static enum mcc_tac_op swapped(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_LT:
+		return MCC_TAC_OP_GT;
+	case MCC_TAC_OP_LE:
+		return MCC_TAC_OP_GE;
+	case MCC_TAC_OP_GT:
+		return MCC_TAC_OP_LT;
+	default:
+		assert(op == MCC_TAC_OP_GE);
+		return MCC_TAC_OP_LE;
+	}
+}
+
+// Comparison holding if `op` does not.
+static enum mcc_tac_op negated(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_LT:
+		return MCC_TAC_OP_GE;
+	case MCC_TAC_OP_LE:
+		return MCC_TAC_OP_GT;
+	case MCC_TAC_OP_GT:
+		return MCC_TAC_OP_LE;
+	default:
+		assert(op == MCC_TAC_OP_GE);
+		return MCC_TAC_OP_LT;
+	}
+}
+
+static bool is_ascending(enum mcc_tac_op op)
+{
+	return op == MCC_TAC_OP_LT || op == MCC_TAC_OP_LE;
+}
+
+static bool holds(enum mcc_tac_op op, int32_t a, int32_t b)
+{
+	switch (op) {
+	case MCC_TAC_OP_LT:
+		return a < b;
+	case MCC_TAC_OP_LE:
+		return a <= b;
+	case MCC_TAC_OP_GT:
+		return a > b;
+	default:
+		assert(op == MCC_TAC_OP_GE);
+		return a >= b;
+	}
+}
+
+// Counts the assignments and reads within the body. Returns false unless the
+// body is straight-line code jumping back to the header.
+static bool scan_body(struct unroll *unroll, struct counted *counted)
+{
+	struct mcc_tac_function *function = unroll->function;
+	const struct mcc_cfg_block *body = &unroll->cfg.blocks[counted->body];
+	size_t last = mcc_cfg_block_last_instruction(function, body);
+	if (last == body->end || function->instructions[last].op != MCC_TAC_OP_JUMP ||
+	    function->instructions[last].arg2 != counted->label) {
+		return false;
+	}
+
+	counted->body_size = 0;
+	for (size_t i = body->begin; i < last; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		switch ((enum mcc_tac_op)instruction->op) {
+		case MCC_TAC_OP_NOP:
+			continue;
+		case MCC_TAC_OP_LABEL:
+		case MCC_TAC_OP_JUMP:
+		case MCC_TAC_OP_JUMP_IF:
+		case MCC_TAC_OP_JUMP_IF_NOT:
+		case MCC_TAC_OP_RETURN:
+		case MCC_TAC_OP_ARRAY:
+		case MCC_TAC_OP_PARAM:
+		case MCC_TAC_OP_PHI:
+			return false;
+		default:
+			break;
+		}
+		counted->body_size++;
+		unroll->body_definitions[mcc_tac_instruction_definition(instruction)]++;
+		mcc_tac_function_visit_uses(function, instruction, count_use, unroll->body_uses);
+	}
+	return true;
+}
+
+static void clear_body(struct unroll *unroll, const struct counted *counted)
+{
+	struct mcc_tac_function *function = unroll->function;
+	const struct mcc_cfg_block *body = &unroll->cfg.blocks[counted->body];
+	for (size_t i = body->begin; i < body->end; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		unroll->body_definitions[mcc_tac_instruction_definition(instruction)] = 0;
+		mcc_tac_function_visit_uses(function, instruction, clear_use, unroll->body_uses);
+	}
+}
+
+// Finds the test of the header, `variable op bound` continuing the loop.
+// Returns false unless the header holds nothing else but constants the body
+// does not read, the unrolled copy runs without them.
+static bool scan_header(struct unroll *unroll, struct counted *counted)
+{
+	const struct mcc_tac_function *function = unroll->function;
+	const struct mcc_cfg_block *header = &unroll->cfg.blocks[counted->header];
+	size_t last = mcc_cfg_block_last_instruction(function, header);
+	const struct mcc_tac_instruction *jump = &function->instructions[last];
+	if (jump->op != MCC_TAC_OP_JUMP_IF && jump->op != MCC_TAC_OP_JUMP_IF_NOT) {
+		return false;
+	}
+
+	size_t test = last - 1;
+	while (test > header->begin && function->instructions[test].op == MCC_TAC_OP_NOP) {
+		test--;
+	}
+	const struct mcc_tac_instruction *compare = &function->instructions[test];
+	if (test == header->begin || jump->arg1 != compare->result || compare->op < MCC_TAC_OP_LT ||
+	    compare->op > MCC_TAC_OP_GE || compare->type != MCC_TAC_TYPE_INT ||
+	    unroll->definitions[compare->result] != 1 || unroll->uses[compare->result] != 1) {
+		return false;
+	}
+
+	enum mcc_tac_op op = jump->op == MCC_TAC_OP_JUMP_IF ? negated(compare->op) : compare->op;
+	uint32_t variable = compare->arg1;
+	uint32_t bound = compare->arg2;
+	if (!is_induction_variable(unroll, counted, variable, &counted->step)) {
+		variable = compare->arg2;
+		bound = compare->arg1;
+		op = swapped(op);
+		if (!is_induction_variable(unroll, counted, variable, &counted->step)) {
+			return false;
+		}
+	}
+	if (bound == variable || unroll->body_definitions[bound] != 0 || (counted->step > 0) != is_ascending(op)) {
+		return false;
+	}
+	counted->variable = variable;
+	counted->op = op;
+	counted->bound = bound;
+	counted->bound_constant = constant_value(unroll, counted, bound, test, &counted->bound_value);
+
+	for (size_t i = header->begin + 1; i < test; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_NOP) {
+			continue;
+		}
+		if (!is_int_constant(instruction) || unroll->body_uses[instruction->result] != 0 ||
+		    (instruction->result == bound && !counted->bound_constant)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Finds the constant assigned to the induction variable last in the
+// preheader, if any.
+static void scan_preheader(const struct unroll *unroll, struct counted *counted)
+{
+	const struct mcc_tac_function *function = unroll->function;
+	const struct mcc_cfg_block *preheader = &unroll->cfg.blocks[counted->preheader];
+	counted->initial_constant = false;
+	for (size_t i = preheader->end; i > preheader->begin; i--) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i - 1];
+		if (mcc_tac_instruction_definition(instruction) == counted->variable) {
+			counted->initial_constant = is_int_constant(instruction);
+			if (counted->initial_constant) {
+				counted->initial_value =
+				    (int32_t)mcc_tac_bits_int(function->constants[instruction->arg1]);
+			}
+			return;
+		}
+	}
+}
+
+static void mark_exposed(uint32_t *variable, void *userdata)
+{
+	struct unroll *unroll = userdata;
+	if (unroll->assigned[*variable] != unroll->stamp) {
+		unroll->exposed[*variable] = unroll->stamp;
+	}
+}
+
+// Collects the variables of the body assigned before being read there and
+// used nowhere else, their values do not outlive an iteration.
+static void collect_locals(struct unroll *unroll, const struct counted *counted)
+{
+	struct mcc_tac_function *function = unroll->function;
+	const struct mcc_cfg_block *body = &unroll->cfg.blocks[counted->body];
+
+	unroll->stamp++;
+	unroll->locals_count = 0;
+	for (size_t i = body->begin; i < body->end; i++) {
+		struct mcc_tac_instruction *instruction = &function->instructions[i];
+		mcc_tac_function_visit_uses(function, instruction, mark_exposed, unroll);
+		uint32_t variable = mcc_tac_instruction_definition(instruction);
+		if (variable == 0 || unroll->assigned[variable] == unroll->stamp) {
+			continue;
+		}
+		unroll->assigned[variable] = unroll->stamp;
+		if (unroll->exposed[variable] != unroll->stamp &&
+		    unroll->definitions[variable] == unroll->body_definitions[variable] &&
+		    unroll->uses[variable] == unroll->body_uses[variable]) {
+			unroll->locals[unroll->locals_count++] = variable;
+		}
+	}
+}
+
+// Returns whether `loop` is counted, filling in `counted` and collecting the
+// locals of its body.
+static bool find_counted(struct unroll *unroll, uint32_t loop, struct counted *counted)
+{
+	const struct mcc_tac_function *function = unroll->function;
+	const struct mcc_loop *l = &unroll->loops.loops[loop];
+	const uint32_t *blocks = mcc_loops_blocks(&unroll->loops, loop);
+	*counted = (struct counted){
+	    .header = l->header,
+	    .body = l->header + 1,
+	    .preheader = mcc_loops_preheader(&unroll->loops, &unroll->cfg, function, loop),
+	};
+
+	// The body follows the header, which exits the loop by a conditional
+	// jump.
+	const struct mcc_cfg_block *header = &unroll->cfg.blocks[counted->header];
+	if (l->blocks_count != 2 || blocks[0] != counted->header || blocks[1] != counted->body ||
+	    counted->preheader == MCC_CFG_NONE || header->successors_count != 2 ||
+	    function->instructions[header->begin].op != MCC_TAC_OP_LABEL) {
+		return false;
+	}
+	counted->label = function->instructions[header->begin].arg2;
+
+	bool found = scan_body(unroll, counted) && scan_header(unroll, counted);
+	if (found) {
+		scan_preheader(unroll, counted);
+		collect_locals(unroll, counted);
+	}
+	clear_body(unroll, counted);
+	return found;
+}
+
+// ---------------------------------------------------------------- Copying
+
+static void emit(struct unroll *unroll, struct mcc_tac_instruction instruction)
+{
+	if (!mcc_array_push(unroll->code, unroll->code_count, unroll->code_capacity, instruction)) {
+		unroll->failed = true;
+	}
+}
+
+static uint32_t new_variable(struct unroll *unroll, enum mcc_tac_type type)
+{
+	uint32_t variable = mcc_tac_function_new_variable(unroll->function, type).identifier;
+	unroll->failed = unroll->failed || variable == 0;
+	return variable;
+}
+
+// Assigns `value` to a new variable, returns it.
+static uint32_t emit_constant(struct unroll *unroll, int32_t value)
+{
+	uint32_t variable = new_variable(unroll, MCC_TAC_TYPE_INT);
+	uint32_t constant = 0;
+	if (!mcc_tac_function_add_constant(unroll->function, mcc_tac_int_bits(value), &constant)) {
+		unroll->failed = true;
+	}
+	emit(unroll,
+	     (struct mcc_tac_instruction){
+	         .op = MCC_TAC_OP_CONST,
+	         .type = MCC_TAC_TYPE_INT,
+	         .result = variable,
+	         .arg1 = constant,
+	     });
+	return variable;
+}
+
+// Compares `a` with `b` into a new variable and jumps on it.
+static void emit_branch(struct unroll *unroll, enum mcc_tac_op op, uint32_t a, uint32_t b, bool when, uint32_t label)
+{
+	uint32_t condition = new_variable(unroll, MCC_TAC_TYPE_BOOL);
+	emit(unroll,
+	     (struct mcc_tac_instruction){
+	         .op = op,
+	         .type = MCC_TAC_TYPE_INT,
+	         .result = condition,
+	         .arg1 = a,
+	         .arg2 = b,
+	     });
+	emit(unroll,
+	     (struct mcc_tac_instruction){
+	         .op = when ? MCC_TAC_OP_JUMP_IF : MCC_TAC_OP_JUMP_IF_NOT,
+	         .arg1 = condition,
+	         .arg2 = label,
+	     });
+}
+
+static void rename_use(uint32_t *variable, void *userdata)
+{
+	const uint32_t *renames = userdata;
+	if (renames[*variable] != 0) {
+		*variable = renames[*variable];
+	}
+}
+
+// Emits a copy of the body with fresh names for its locals.
+static void emit_body(struct unroll *unroll, const struct counted *counted)
+{
+	struct mcc_tac_function *function = unroll->function;
+	for (size_t l = 0; l < unroll->locals_count; l++) {
+		uint32_t local = unroll->locals[l];
+		unroll->renames[local] = new_variable(unroll, mcc_tac_function_variable_type(function, local));
+	}
+
+	const struct mcc_cfg_block *body = &unroll->cfg.blocks[counted->body];
+	size_t last = mcc_cfg_block_last_instruction(function, body);
+	for (size_t i = body->begin; i < last && !unroll->failed; i++) {
+		struct mcc_tac_instruction copy = function->instructions[i];
+		if (copy.op == MCC_TAC_OP_NOP) {
+			continue;
+		}
+
+		// Calls get their own argument lists to rename.
+		if (copy.op == MCC_TAC_OP_CALL) {
+			uint32_t count = function->operands[copy.arg2] + 1;
+			uint32_t *arguments = malloc(count * sizeof(*arguments));
+			if (!arguments) {
+				unroll->failed = true;
+				break;
+			}
+			memcpy(arguments, &function->operands[copy.arg2], count * sizeof(*arguments));
+			unroll->failed =
+			    !mcc_tac_function_add_operands(function, arguments, count, &copy.arg2) || unroll->failed;
+			free(arguments);
+		}
+
+		mcc_tac_function_visit_uses(function, &copy, rename_use, unroll->renames);
+		uint32_t variable = mcc_tac_instruction_definition(&copy);
+		if (variable != 0 && unroll->renames[variable] != 0) {
+			copy.result = unroll->renames[variable];
+		}
+		emit(unroll, copy);
+	}
+
+	for (size_t l = 0; l < unroll->locals_count; l++) {
+		unroll->renames[unroll->locals[l]] = 0;
+	}
+}
+
+// Places the unrolled copy of `counted` in its preheader. Returns false if
+// it would not run at least once.
+static bool unroll_loop(struct unroll *unroll, const struct counted *counted, uint32_t factor)
+{
+	struct mcc_tac_function *function = unroll->function;
+
+	// The copy runs while `variable + distance op bound` holds, the last
+	// iteration of the copy would be run by the loop too. The limit is
+	// `bound - distance` unless that wraps around.
+	int64_t distance = (int64_t)(factor - 1) * counted->step;
+	int64_t edge = is_ascending(counted->op) ? INT32_MIN + distance : INT32_MAX + distance;
+	if (distance < INT32_MIN / 2 || distance > INT32_MAX / 2) {
+		return false;
+	}
+
+	bool entered = false;
+	if (counted->bound_constant) {
+		int64_t bound = counted->bound_value;
+		if (is_ascending(counted->op) ? bound < edge : bound > edge) {
+			return false;
+		}
+		int32_t limit = (int32_t)(bound - distance);
+		if (counted->initial_constant) {
+			entered = holds(counted->op, counted->initial_value, limit);
+			if (!entered) {
+				return false;
+			}
+		}
+	}
+
+	const struct mcc_cfg_block *preheader = &unroll->cfg.blocks[counted->preheader];
+	size_t last = mcc_cfg_block_last_instruction(function, preheader);
+	bool jumps = last < preheader->end && function->instructions[last].op == MCC_TAC_OP_JUMP;
+	struct insertion insertion = {
+	    .index = jumps ? last : preheader->end,
+	    .begin = unroll->code_count,
+	};
+
+	uint32_t limit;
+	if (counted->bound_constant) {
+		limit = emit_constant(unroll, (int32_t)(counted->bound_value - distance));
+	} else {
+		uint32_t edge_variable = emit_constant(unroll, (int32_t)edge);
+		emit_branch(unroll, is_ascending(counted->op) ? MCC_TAC_OP_LT : MCC_TAC_OP_GT, counted->bound,
+		            edge_variable, true, counted->label);
+		uint32_t distance_variable = emit_constant(unroll, (int32_t)distance);
+		limit = new_variable(unroll, MCC_TAC_TYPE_INT);
+		emit(unroll,
+		     (struct mcc_tac_instruction){
+		         .op = MCC_TAC_OP_SUB,
+		         .type = MCC_TAC_TYPE_INT,
+		         .result = limit,
+		         .arg1 = counted->bound,
+		         .arg2 = distance_variable,
+		     });
+	}
+	if (!entered) {
+		emit_branch(unroll, counted->op, counted->variable, limit, false, counted->label);
+	}
+
+	uint32_t label = mcc_tac_function_new_label(function);
+	emit(unroll, (struct mcc_tac_instruction){.op = MCC_TAC_OP_LABEL, .arg2 = label});
+	for (uint32_t c = 0; c < factor; c++) {
+		emit_body(unroll, counted);
+	}
+	emit_branch(unroll, counted->op, counted->variable, limit, true, label);
+
+	insertion.count = unroll->code_count - insertion.begin;
+	if (!mcc_array_push(unroll->insertions, unroll->insertions_count, unroll->insertions_capacity, insertion)) {
+		unroll->failed = true;
+	}
+	unroll->copies += factor;
+	return true;
+}
+
+// Inserts the unrolled copies, back to front.
+static bool insert_copies(struct unroll *unroll)
+{
+	struct mcc_tac_function *function = unroll->function;
+	if (!mcc_tac_function_reserve(function, function->instructions_count + unroll->code_count)) {
+		return false;
+	}
+	for (size_t i = 0; i < unroll->insertions_count; i++) {
+		size_t latest = i;
+		for (size_t j = i + 1; j < unroll->insertions_count; j++) {
+			if (unroll->insertions[j].index > unroll->insertions[latest].index) {
+				latest = j;
+			}
+		}
+		struct insertion insertion = unroll->insertions[latest];
+		unroll->insertions[latest] = unroll->insertions[i];
+		bool inserted =
+		    mcc_tac_function_insert(function, insertion.index, &unroll->code[insertion.begin], insertion.count);
+		assert(inserted);
+		(void)inserted;
+	}
+	return true;
+}
+
+bool mcc_unroll_function(struct mcc_tac_function *function,
+                         const struct mcc_unroll_options *options,
+                         struct mcc_unroll_stats *stats)
+{
+	assert(function);
+
+	if (!mcc_loops_insert_preheaders(function, NULL)) {
+		return false;
+	}
+
+	struct unroll unroll = {
+	    .function = function,
+	    .factor = options && options->factor != 0 ? options->factor : MCC_UNROLL_DEFAULT_FACTOR,
+	    .budget = options && options->budget != 0 ? options->budget : MCC_UNROLL_DEFAULT_BUDGET,
+	};
+	bool ok = unroll_init(&unroll);
+
+	for (uint32_t l = 0; ok && !unroll.failed && l < unroll.loops.loops_count; l++) {
+		struct counted counted;
+		if (!find_counted(&unroll, l, &counted)) {
+			continue;
+		}
+		size_t fitting = unroll.budget / counted.body_size;
+		uint32_t factor = fitting < unroll.factor ? (uint32_t)fitting : unroll.factor;
+		if (factor >= 2 && unroll_loop(&unroll, &counted, factor)) {
+			unroll.unrolled++;
+		}
+	}
+
+	ok = ok && !unroll.failed && insert_copies(&unroll);
+	if (ok && stats) {
+		stats->unrolled += unroll.unrolled;
+		stats->copies += unroll.copies;
+	}
+	unroll_deinit(&unroll);
+	return ok;
+}
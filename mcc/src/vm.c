@@ -0,0 +1,1200 @@
+#include "mcc/vm.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "mcc/memoize.h"
+#include "memo_table.h"
+
+#if defined(__GNUC__) && !defined(MCC_VM_SWITCH)
+#define THREADED 1
+// Labels as values are a GNU extension.
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+// ------------------------------------------------------------------ Bytecode
+
+// Suffixes denote the operand types: _I for int and bool, _F for float, and
+// a trailing K for an immediate right-hand side. Variants of a family are
+// kept in this order, opcodes are computed from it.
+#define OPCODES(X) \
+	X(MOV) \
+	X(LOADI) \
+	X(LOADK) \
+	X(ADD_I) X(SUB_I) X(MUL_I) X(DIV_I) \
+	X(ADD_IK) X(SUB_IK) X(MUL_IK) X(DIV_IK) \
+	X(ADD_F) X(SUB_F) X(MUL_F) X(DIV_F) \
+	X(ADD_FK) X(SUB_FK) X(MUL_FK) X(DIV_FK) \
+	X(NEG_I) \
+	X(NEG_F) \
+	X(NOT) \
+	X(AND) \
+	X(OR) \
+	X(EQ_I) X(NE_I) X(LT_I) X(LE_I) X(GT_I) X(GE_I) \
+	X(EQ_IK) X(NE_IK) X(LT_IK) X(LE_IK) X(GT_IK) X(GE_IK) \
+	X(EQ_F) X(NE_F) X(LT_F) X(LE_F) X(GT_F) X(GE_F) \
+	X(EQ_FK) X(NE_FK) X(LT_FK) X(LE_FK) X(GT_FK) X(GE_FK) \
+	X(ARRAY) \
+	X(LOAD) \
+	X(STORE) \
+	X(JUMP) \
+	X(JUMP_IF) \
+	X(JUMP_IF_NOT) \
+	X(JEQ_I) X(JNE_I) X(JLT_I) X(JLE_I) X(JGT_I) X(JGE_I) \
+	X(JEQ_IK) X(JNE_IK) X(JLT_IK) X(JLE_IK) X(JGT_IK) X(JGE_IK) \
+	X(JNEQ_F) X(JNNE_F) X(JNLT_F) X(JNLE_F) X(JNGT_F) X(JNGE_F) \
+	X(JNEQ_FK) X(JNNE_FK) X(JNLT_FK) X(JNLE_FK) X(JNGT_FK) X(JNGE_FK) \
+	X(CALL) \
+	X(RET) \
+	X(RET_VOID) \
+	X(PRINT) \
+	X(PRINT_NL) \
+	X(PRINT_INT) \
+	X(PRINT_FLOAT) \
+	X(READ_INT) \
+	X(READ_FLOAT) \
+	X(MEMO_FIND) \
+	X(MEMO_GET) \
+	X(MEMO_PUT)
+
+#define OPCODE_ENUM(name) OP_##name,
+
+enum opcode { OPCODES(OPCODE_ENUM) };
+
+// Families are indexed by variant, then by the TAC operation.
+enum variant {
+	VARIANT_INT,
+	VARIANT_INT_IMMEDIATE,
+	VARIANT_FLOAT,
+	VARIANT_FLOAT_IMMEDIATE,
+};
+
+_Static_assert(OP_DIV_FK == OP_ADD_I + 4 * VARIANT_FLOAT_IMMEDIATE + 3, "arithmetic family is out of order");
+_Static_assert(OP_GE_FK == OP_EQ_I + 6 * VARIANT_FLOAT_IMMEDIATE + 5, "comparison family is out of order");
+_Static_assert(OP_JNGE_FK == OP_JEQ_I + 6 * VARIANT_FLOAT_IMMEDIATE + 5, "branch family is out of order");
+
+// Operands are registers unless noted otherwise. Arithmetic and comparisons
+// compute `a` from `b` and `c`. Branches compare `a` with `b` and jump to the
+// instruction at index `c`.
+struct vm_instruction {
+	// Address of the handler with threaded dispatch.
+	const void *handler;
+	uint16_t op;
+	uint32_t a, b, c;
+};
+
+struct mcc_vm_function {
+	const char *name;
+
+	struct vm_instruction *code;
+	size_t code_count;
+	size_t code_capacity;
+
+	// Argument lists of calls, each is its length followed by the registers
+	// passed. Calls refer to them by index.
+	uint32_t *arguments;
+	size_t arguments_count;
+	size_t arguments_capacity;
+
+	// Register receiving each parameter.
+	uint32_t *parameters;
+	size_t parameters_count;
+
+	// String constants, indexed like the TAC function's `strings`.
+	union mcc_vm_value *constants;
+
+	// Registers of all variables, followed by the storage of all arrays.
+	uint32_t frame_size;
+};
+
+static bool is_jump(enum opcode op)
+{
+	return op == OP_JUMP || op == OP_JUMP_IF || op == OP_JUMP_IF_NOT || (op >= OP_JEQ_I && op <= OP_JNGE_FK);
+}
+
+static uint32_t float_immediate(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static float immediate_float(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// --------------------------------------------------------------------- Errors
+
+static void vm_error(struct mcc_vm_result *result, enum mcc_vm_error error, const char *format, ...)
+{
+	result->error = error;
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(result->error_msg, sizeof(result->error_msg), format, args);
+	va_end(args);
+}
+
+void mcc_vm_result_print_error(FILE *out, const struct mcc_vm_result *result)
+{
+	assert(out);
+	assert(result);
+
+	if (*result->error_msg) {
+		fprintf(out, "%s\n", result->error_msg);
+		return;
+	}
+
+	switch (result->error) {
+	case MCC_VM_ERROR_NONE:
+		fputs("no error\n", out);
+		break;
+	case MCC_VM_ERROR_ALLOCATION_ERROR:
+		fputs("allocation error\n", out);
+		break;
+	case MCC_VM_ERROR_INVALID_PROGRAM:
+		fputs("invalid program\n", out);
+		break;
+	case MCC_VM_ERROR_UNKNOWN_FUNCTION:
+		fputs("unknown function\n", out);
+		break;
+	case MCC_VM_ERROR_DIVISION_BY_ZERO:
+		fputs("division by zero\n", out);
+		break;
+	case MCC_VM_ERROR_INVALID_ACCESS:
+		fputs("invalid access\n", out);
+		break;
+	case MCC_VM_ERROR_STACK_OVERFLOW:
+		fputs("stack overflow\n", out);
+		break;
+	case MCC_VM_ERROR_OUT_OF_FUEL:
+		fputs("out of fuel\n", out);
+		break;
+	}
+}
+
+// ---------------------------------------------------------------- Interpreter
+
+struct frame {
+	const struct mcc_vm_function *function;
+	const struct vm_instruction *ip;
+	union mcc_vm_value *registers;
+};
+
+struct run {
+	const struct mcc_vm *vm;
+	FILE *in;
+	FILE *out;
+
+	union mcc_vm_value *stack;
+	union mcc_vm_value *stack_end;
+
+	// Callers of the running function, the first entry is unused.
+	struct frame *frames;
+	struct frame *frames_end;
+
+	// Taken jumps and calls left.
+	size_t fuel;
+
+	struct mcc_memo_table memo;
+
+	struct mcc_vm_result *result;
+};
+
+#ifdef THREADED
+#define CASE(name) do_##name:
+#define DISPATCH() goto *ip->handler
+#define HANDLER(name) &&do_##name,
+#else
+#define CASE(name) case OP_##name:
+#define DISPATCH() continue
+#endif
+
+#define NEXT() \
+	{ \
+		ip++; \
+		DISPATCH(); \
+	}
+#define JUMP() \
+	{ \
+		if (--fuel == 0) \
+			OUT_OF_FUEL(); \
+		ip = code + ip->c; \
+		DISPATCH(); \
+	}
+
+#define ARITHMETIC(name, operator) \
+	CASE(name##_I) \
+	{ \
+		r[ip->a].i = (int32_t)((uint32_t)r[ip->b].i operator (uint32_t)r[ip->c].i); \
+		NEXT(); \
+	} \
+	CASE(name##_IK) \
+	{ \
+		r[ip->a].i = (int32_t)((uint32_t)r[ip->b].i operator ip->c); \
+		NEXT(); \
+	} \
+	CASE(name##_F) \
+	{ \
+		r[ip->a].f = r[ip->b].f operator r[ip->c].f; \
+		NEXT(); \
+	} \
+	CASE(name##_FK) \
+	{ \
+		r[ip->a].f = r[ip->b].f operator immediate_float(ip->c); \
+		NEXT(); \
+	}
+
+#define COMPARISON(name, operator) \
+	CASE(name##_I) \
+	{ \
+		r[ip->a].i = r[ip->b].i operator r[ip->c].i; \
+		NEXT(); \
+	} \
+	CASE(name##_IK) \
+	{ \
+		r[ip->a].i = r[ip->b].i operator (int32_t)ip->c; \
+		NEXT(); \
+	} \
+	CASE(name##_F) \
+	{ \
+		r[ip->a].i = r[ip->b].f operator r[ip->c].f; \
+		NEXT(); \
+	} \
+	CASE(name##_FK) \
+	{ \
+		r[ip->a].i = r[ip->b].f operator immediate_float(ip->c); \
+		NEXT(); \
+	} \
+	CASE(J##name##_I) \
+	{ \
+		if (r[ip->a].i operator r[ip->b].i) \
+			JUMP(); \
+		NEXT(); \
+	} \
+	CASE(J##name##_IK) \
+	{ \
+		if (r[ip->a].i operator (int32_t)ip->b) \
+			JUMP(); \
+		NEXT(); \
+	} \
+	CASE(JN##name##_F) \
+	{ \
+		if (!(r[ip->a].f operator r[ip->b].f)) \
+			JUMP(); \
+		NEXT(); \
+	} \
+	CASE(JN##name##_FK) \
+	{ \
+		if (!(r[ip->a].f operator immediate_float(ip->b))) \
+			JUMP(); \
+		NEXT(); \
+	}
+
+// Returns the element at `index` of `array`, NULL if it lies outside the
+// stack. As in C, indices are not checked against the size of the array:
+// accessing elements past its end reaches into the rest of the stack, but
+// never beyond.
+static inline union mcc_vm_value *element(const struct run *run, union mcc_vm_value *array, int32_t index)
+{
+	uintptr_t address = (uintptr_t)array + (uintptr_t)((intptr_t)index * (intptr_t)sizeof(*array));
+	if (address - (uintptr_t)run->stack >= (uintptr_t)run->stack_end - (uintptr_t)run->stack) {
+		return NULL;
+	}
+	return (union mcc_vm_value *)address;
+}
+
+#define OUT_OF_FUEL() \
+	{ \
+		vm_error(run->result, MCC_VM_ERROR_OUT_OF_FUEL, "out of fuel in %s", function->name); \
+		return; \
+	}
+
+#define INVALID_ACCESS(index) \
+	{ \
+		vm_error(run->result, MCC_VM_ERROR_INVALID_ACCESS, "index %" PRId32 " is outside the stack in %s", \
+		         (index), function->name); \
+		return; \
+	}
+
+// Runs `function`, whose frame starts at `r` and holds its arguments. The
+// returned value is stored in the result of `run`.
+//
+// With threaded dispatch, `link` being not NULL makes the interpreter fill in
+// the handlers of `link`'s code instead.
+static void interpret(struct run *run,
+                      const struct mcc_vm_function *function,
+                      union mcc_vm_value *r,
+                      struct mcc_vm_function *link)
+{
+#ifdef THREADED
+	static const void *const handlers[] = {OPCODES(HANDLER)};
+	if (link) {
+		for (size_t i = 0; i < link->code_count; i++) {
+			link->code[i].handler = handlers[link->code[i].op];
+		}
+		return;
+	}
+#else
+	if (link) {
+		return;
+	}
+#endif
+
+	const struct vm_instruction *code = function->code;
+	const struct vm_instruction *ip = code;
+	struct frame *frame = run->frames;
+	size_t fuel = run->fuel;
+
+#ifdef THREADED
+	DISPATCH();
+#else
+	for (;;) {
+		switch ((enum opcode)ip->op) {
+#endif
+
+	CASE(MOV)
+	{
+		r[ip->a] = r[ip->b];
+		NEXT();
+	}
+	CASE(LOADI)
+	{
+		r[ip->a].i = (int32_t)ip->b;
+		NEXT();
+	}
+	CASE(LOADK)
+	{
+		r[ip->a] = function->constants[ip->b];
+		NEXT();
+	}
+
+	ARITHMETIC(ADD, +)
+	ARITHMETIC(SUB, -)
+	ARITHMETIC(MUL, *)
+
+	CASE(DIV_I)
+	{
+		int32_t divisor = r[ip->c].i;
+		if (divisor == 0) {
+			vm_error(run->result, MCC_VM_ERROR_DIVISION_BY_ZERO, "division by zero in %s", function->name);
+			return;
+		}
+		// Dividing the smallest int by -1 wraps around.
+		r[ip->a].i = divisor == -1 ? (int32_t)(0u - (uint32_t)r[ip->b].i) : r[ip->b].i / divisor;
+		NEXT();
+	}
+	CASE(DIV_IK)
+	{
+		// The immediate is neither 0 nor -1.
+		r[ip->a].i = r[ip->b].i / (int32_t)ip->c;
+		NEXT();
+	}
+	CASE(DIV_F)
+	{
+		r[ip->a].f = r[ip->b].f / r[ip->c].f;
+		NEXT();
+	}
+	CASE(DIV_FK)
+	{
+		r[ip->a].f = r[ip->b].f / immediate_float(ip->c);
+		NEXT();
+	}
+
+	CASE(NEG_I)
+	{
+		r[ip->a].i = (int32_t)(0u - (uint32_t)r[ip->b].i);
+		NEXT();
+	}
+	CASE(NEG_F)
+	{
+		r[ip->a].f = -r[ip->b].f;
+		NEXT();
+	}
+	CASE(NOT)
+	{
+		r[ip->a].i = !r[ip->b].i;
+		NEXT();
+	}
+	CASE(AND)
+	{
+		r[ip->a].i = r[ip->b].i & r[ip->c].i;
+		NEXT();
+	}
+	CASE(OR)
+	{
+		r[ip->a].i = r[ip->b].i | r[ip->c].i;
+		NEXT();
+	}
+
+	COMPARISON(EQ, ==)
+	COMPARISON(NE, !=)
+	COMPARISON(LT, <)
+	COMPARISON(LE, <=)
+	COMPARISON(GT, >)
+	COMPARISON(GE, >=)
+
+	CASE(ARRAY)
+	{
+		// `b` is the offset of the array's storage in the frame.
+		r[ip->a].a = r + ip->b;
+		NEXT();
+	}
+	CASE(LOAD)
+	{
+		union mcc_vm_value *value = element(run, r[ip->b].a, r[ip->c].i);
+		if (!value)
+			INVALID_ACCESS(r[ip->c].i);
+		r[ip->a] = *value;
+		NEXT();
+	}
+	CASE(STORE)
+	{
+		union mcc_vm_value *value = element(run, r[ip->a].a, r[ip->b].i);
+		if (!value)
+			INVALID_ACCESS(r[ip->b].i);
+		*value = r[ip->c];
+		NEXT();
+	}
+
+	CASE(JUMP)
+	{
+		JUMP();
+	}
+	CASE(JUMP_IF)
+	{
+		if (r[ip->a].i)
+			JUMP();
+		NEXT();
+	}
+	CASE(JUMP_IF_NOT)
+	{
+		if (!r[ip->a].i)
+			JUMP();
+		NEXT();
+	}
+
+	CASE(CALL)
+	{
+		// `a` receives the result, `b` is the callee's index, and `c` the
+		// index of the argument list.
+		const struct mcc_vm_function *callee = &run->vm->functions[ip->b];
+		union mcc_vm_value *callee_r = r + function->frame_size;
+		if (--fuel == 0)
+			OUT_OF_FUEL();
+		if (frame + 1 == run->frames_end || (size_t)(run->stack_end - callee_r) < callee->frame_size) {
+			vm_error(run->result, MCC_VM_ERROR_STACK_OVERFLOW, "stack overflow calling %s", callee->name);
+			return;
+		}
+
+		memset(callee_r, 0, callee->frame_size * sizeof(*callee_r));
+		const uint32_t *arguments = &function->arguments[ip->c];
+		for (uint32_t i = 0; i < arguments[0]; i++) {
+			callee_r[callee->parameters[i]] = r[arguments[i + 1]];
+		}
+
+		frame++;
+		*frame = (struct frame){.function = function, .ip = ip, .registers = r};
+		function = callee;
+		r = callee_r;
+		code = ip = callee->code;
+		DISPATCH();
+	}
+	CASE(RET)
+	{
+		union mcc_vm_value value = r[ip->a];
+		if (frame == run->frames) {
+			run->result->value = value;
+			return;
+		}
+
+		function = frame->function;
+		code = function->code;
+		ip = frame->ip;
+		r = frame->registers;
+		frame--;
+		r[ip->a] = value;
+		NEXT();
+	}
+	CASE(RET_VOID)
+	{
+		if (frame == run->frames) {
+			return;
+		}
+
+		function = frame->function;
+		code = function->code;
+		ip = frame->ip;
+		r = frame->registers;
+		frame--;
+		r[ip->a] = (union mcc_vm_value){0};
+		NEXT();
+	}
+
+	// Builtins take their argument from `b` and store their result in `a`,
+	// their output matches resources/mc_builtins.c.
+	CASE(PRINT)
+	{
+		// Registers start zeroed, strings never assigned print as empty.
+		fputs(r[ip->b].s ? r[ip->b].s : "", run->out);
+		NEXT();
+	}
+	CASE(PRINT_NL)
+	{
+		fputc('\n', run->out);
+		NEXT();
+	}
+	CASE(PRINT_INT)
+	{
+		fprintf(run->out, "%" PRId32, r[ip->b].i);
+		NEXT();
+	}
+	CASE(PRINT_FLOAT)
+	{
+		fprintf(run->out, "%.2f", (double)r[ip->b].f);
+		NEXT();
+	}
+	CASE(READ_INT)
+	{
+		int value;
+		if (fscanf(run->in, "%d", &value) != 1) {
+			value = 0;
+		}
+		r[ip->a].i = value;
+		NEXT();
+	}
+	CASE(READ_FLOAT)
+	{
+		float value;
+		if (fscanf(run->in, "%f", &value) != 1) {
+			value = 0.0f;
+		}
+		r[ip->a].f = value;
+		NEXT();
+	}
+
+	// The runtime functions of memoisation take their arguments from the
+	// argument list `c`. Keys and values are handled as bit patterns.
+	CASE(MEMO_FIND)
+	{
+		const uint32_t *arguments = &function->arguments[ip->c];
+		r[ip->a].i = mcc_memo_table_find(&run->memo, (uint32_t)r[arguments[1]].i, (uint32_t)r[arguments[2]].i,
+		                                  (uint32_t)r[arguments[3]].i);
+		NEXT();
+	}
+	CASE(MEMO_GET)
+	{
+		r[ip->a].i = (int32_t)mcc_memo_table_get(&run->memo);
+		NEXT();
+	}
+	CASE(MEMO_PUT)
+	{
+		const uint32_t *arguments = &function->arguments[ip->c];
+		mcc_memo_table_put(&run->memo, (uint32_t)r[arguments[1]].i, (uint32_t)r[arguments[2]].i,
+		                   (uint32_t)r[arguments[3]].i, (uint32_t)r[arguments[4]].i);
+		NEXT();
+	}
+
+#ifndef THREADED
+		}
+	}
+#endif
+}
+
+// ------------------------------------------------------------------ Compiler
+
+static const struct builtin {
+	const char *name;
+	enum opcode op;
+	size_t parameters_count;
+} builtins[] = {
+    {"print", OP_PRINT, 1},
+    {"print_nl", OP_PRINT_NL, 0},
+    {"print_int", OP_PRINT_INT, 1},
+    {"print_float", OP_PRINT_FLOAT, 1},
+    {"read_int", OP_READ_INT, 0},
+    {"read_float", OP_READ_FLOAT, 0},
+    {MCC_MEMOIZE_FIND, OP_MEMO_FIND, 3},
+    {MCC_MEMOIZE_GET, OP_MEMO_GET, 0},
+    {MCC_MEMOIZE_PUT, OP_MEMO_PUT, 4},
+};
+
+struct compiler {
+	const struct mcc_vm *vm;
+	const struct mcc_tac_function *function;
+	struct mcc_vm_function *out;
+	struct mcc_vm_result *result;
+
+	// Number of definitions and uses of each variable.
+	uint32_t *definitions;
+	uint32_t *uses;
+
+	// Code index of each label.
+	uint32_t *labels;
+
+	// Indices of the instructions that are not tombstones, pairs are fused
+	// along this sequence.
+	size_t *live;
+	size_t live_count;
+
+	// Size of the frame so far.
+	uint64_t frame_size;
+
+	// Variable defined by a constant that is folded into the next
+	// instruction, 0 if there is none, along with the immediate.
+	uint32_t folded;
+	uint32_t folded_immediate;
+};
+
+static void compiler_allocation_error(struct compiler *compiler)
+{
+	compiler->result->error = MCC_VM_ERROR_ALLOCATION_ERROR;
+}
+
+#define failed() (compiler->result->error != MCC_VM_ERROR_NONE)
+
+static void emit(struct compiler *compiler, enum opcode op, uint32_t a, uint32_t b, uint32_t c)
+{
+	struct vm_instruction instruction = {.op = (uint16_t)op, .a = a, .b = b, .c = c};
+	if (!failed() && !mcc_array_push(compiler->out->code, compiler->out->code_count, compiler->out->code_capacity,
+	                                 instruction)) {
+		compiler_allocation_error(compiler);
+	}
+}
+
+static void count_use(uint32_t *variable, void *userdata)
+{
+	uint32_t *uses = userdata;
+	uses[*variable]++;
+}
+
+// Counts definitions and uses, and collects the instructions that are not
+// tombstones.
+static void count_variables(struct compiler *compiler)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		struct mcc_tac_instruction instruction = function->instructions[i];
+		if (instruction.op == MCC_TAC_OP_NOP) {
+			continue;
+		}
+		compiler->live[compiler->live_count++] = i;
+		compiler->definitions[mcc_tac_instruction_definition(&instruction)]++;
+
+		// Visiting uses does not modify the function, only the callback
+		// could.
+		mcc_tac_function_visit_uses((struct mcc_tac_function *)function, &instruction, count_use,
+		                            compiler->uses);
+	}
+}
+
+static const struct mcc_tac_instruction *instruction_at(const struct compiler *compiler, size_t k)
+{
+	return &compiler->function->instructions[compiler->live[k]];
+}
+
+// Returns the instruction following the `k`th, NULL if there is none.
+static const struct mcc_tac_instruction *peek(const struct compiler *compiler, size_t k)
+{
+	return k + 1 < compiler->live_count ? instruction_at(compiler, k + 1) : NULL;
+}
+
+// Returns whether `variable` is a temporary, defined and used exactly once.
+static bool is_temporary(const struct compiler *compiler, uint32_t variable)
+{
+	return variable != 0 && compiler->definitions[variable] == 1 && compiler->uses[variable] == 1;
+}
+
+// Returns the register receiving `result` of the `k`th instruction. If the
+// next instruction merely copies the result, which is a temporary, into
+// another variable, the copy is fused and `k` advanced past it.
+static uint32_t destination(const struct compiler *compiler, size_t *k, uint32_t result)
+{
+	const struct mcc_tac_instruction *next = peek(compiler, *k);
+	if (next && next->op == MCC_TAC_OP_ASSIGN && next->arg1 == result && is_temporary(compiler, result)) {
+		(*k)++;
+		return next->result;
+	}
+	return result;
+}
+
+static bool is_commutative(enum mcc_tac_op op)
+{
+	return op == MCC_TAC_OP_ADD || op == MCC_TAC_OP_MUL || op == MCC_TAC_OP_EQ || op == MCC_TAC_OP_NE;
+}
+
+// Returns `op` with its operands swapped, `op` is commutative or ordering.
+static enum mcc_tac_op swapped(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_LT:
+		return MCC_TAC_OP_GT;
+	case MCC_TAC_OP_LE:
+		return MCC_TAC_OP_GE;
+	case MCC_TAC_OP_GT:
+		return MCC_TAC_OP_LT;
+	case MCC_TAC_OP_GE:
+		return MCC_TAC_OP_LE;
+	default:
+		assert(is_commutative(op));
+		return op;
+	}
+}
+
+// Returns the comparison that holds if `op` does not, on ints.
+static enum mcc_tac_op inverted(enum mcc_tac_op op)
+{
+	switch (op) {
+	case MCC_TAC_OP_EQ:
+		return MCC_TAC_OP_NE;
+	case MCC_TAC_OP_NE:
+		return MCC_TAC_OP_EQ;
+	case MCC_TAC_OP_LT:
+		return MCC_TAC_OP_GE;
+	case MCC_TAC_OP_LE:
+		return MCC_TAC_OP_GT;
+	case MCC_TAC_OP_GT:
+		return MCC_TAC_OP_LE;
+	case MCC_TAC_OP_GE:
+		return MCC_TAC_OP_LT;
+	default:
+		assert(false);
+		return op;
+	}
+}
+
+static bool is_comparison(enum mcc_tac_op op)
+{
+	return op >= MCC_TAC_OP_EQ && op <= MCC_TAC_OP_GE;
+}
+
+static bool is_arithmetic(enum mcc_tac_op op)
+{
+	return op >= MCC_TAC_OP_ADD && op <= MCC_TAC_OP_DIV;
+}
+
+// Returns the immediate encoding a numeric or bool constant.
+static uint32_t constant_immediate(const struct mcc_tac_function *function, const struct mcc_tac_instruction *constant)
+{
+	uint64_t bits = function->constants[constant->arg1];
+	if (constant->type == MCC_TAC_TYPE_FLOAT) {
+		return float_immediate((float)mcc_tac_bits_float(bits));
+	}
+	return (uint32_t)mcc_tac_bits_int(bits);
+}
+
+// Returns whether the constant defined by the `k`th instruction can become
+// the immediate operand of the next one.
+static bool is_foldable(const struct compiler *compiler, size_t k, const struct mcc_tac_instruction *constant)
+{
+	const struct mcc_tac_instruction *next = peek(compiler, k);
+	uint32_t variable = constant->result;
+	if (!next || !is_temporary(compiler, variable) || constant->type == MCC_TAC_TYPE_STRING ||
+	    (!is_arithmetic(next->op) && !is_comparison(next->op))) {
+		return false;
+	}
+
+	// Division by an immediate skips the checks for 0 and -1.
+	if (next->op == MCC_TAC_OP_DIV && constant->type == MCC_TAC_TYPE_INT) {
+		int32_t divisor = (int32_t)constant_immediate(compiler->function, constant);
+		if (divisor == 0 || divisor == -1) {
+			return false;
+		}
+	}
+
+	return next->arg2 == variable ||
+	       (next->arg1 == variable && (is_commutative(next->op) || is_comparison(next->op)));
+}
+
+static void compile_binary(struct compiler *compiler, size_t *k, const struct mcc_tac_instruction *instruction)
+{
+	enum mcc_tac_op op = instruction->op;
+	uint32_t lhs = instruction->arg1;
+	uint32_t rhs = instruction->arg2;
+
+	bool immediate = compiler->folded != 0;
+	if (immediate) {
+		if (lhs == compiler->folded) {
+			lhs = rhs;
+			op = swapped(op);
+		}
+		rhs = compiler->folded_immediate;
+		compiler->folded = 0;
+	}
+
+	if (op == MCC_TAC_OP_AND || op == MCC_TAC_OP_OR) {
+		emit(compiler, op == MCC_TAC_OP_AND ? OP_AND : OP_OR, destination(compiler, k, instruction->result),
+		     lhs, rhs);
+		return;
+	}
+
+	bool floating = instruction->type == MCC_TAC_TYPE_FLOAT;
+	if (!floating && instruction->type != MCC_TAC_TYPE_INT &&
+	    !(instruction->type == MCC_TAC_TYPE_BOOL && (op == MCC_TAC_OP_EQ || op == MCC_TAC_OP_NE))) {
+		vm_error(compiler->result, MCC_VM_ERROR_INVALID_PROGRAM, "%s on %s is not supported in %s",
+		         mcc_tac_op_to_string(op), mcc_tac_type_to_string(instruction->type), compiler->function->name);
+		return;
+	}
+	unsigned variant = (floating ? VARIANT_FLOAT : VARIANT_INT) + immediate;
+
+	if (is_arithmetic(op)) {
+		emit(compiler, OP_ADD_I + 4 * variant + (op - MCC_TAC_OP_ADD),
+		     destination(compiler, k, instruction->result), lhs, rhs);
+		return;
+	}
+
+	// A comparison followed by a conditional jump on its result becomes a
+	// branch. Floats only branch on a failed comparison, as inverting it
+	// would not hold for NaN.
+	const struct mcc_tac_instruction *next = peek(compiler, *k);
+	if (next && next->arg1 == instruction->result && is_temporary(compiler, instruction->result) &&
+	    (next->op == MCC_TAC_OP_JUMP_IF_NOT || (next->op == MCC_TAC_OP_JUMP_IF && !floating))) {
+		enum mcc_tac_op condition = floating || next->op == MCC_TAC_OP_JUMP_IF ? op : inverted(op);
+		emit(compiler, OP_JEQ_I + 6 * variant + (condition - MCC_TAC_OP_EQ), lhs, rhs, next->arg2);
+		(*k)++;
+		return;
+	}
+
+	emit(compiler, OP_EQ_I + 6 * variant + (op - MCC_TAC_OP_EQ), destination(compiler, k, instruction->result), lhs,
+	     rhs);
+}
+
+// Copies the argument list `arguments`, returns its index.
+static uint32_t add_arguments(struct compiler *compiler, const uint32_t *arguments)
+{
+	struct mcc_vm_function *out = compiler->out;
+	uint32_t index = (uint32_t)out->arguments_count;
+	for (uint32_t i = 0; i <= arguments[0] && !failed(); i++) {
+		if (!mcc_array_push(out->arguments, out->arguments_count, out->arguments_capacity, arguments[i])) {
+			compiler_allocation_error(compiler);
+		}
+	}
+	return index;
+}
+
+static void compile_call(struct compiler *compiler, size_t *k, const struct mcc_tac_instruction *instruction)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	const char *name = function->strings[instruction->arg1];
+	const uint32_t *arguments = &function->operands[instruction->arg2];
+	uint32_t result = instruction->result ? destination(compiler, k, instruction->result) : 0;
+
+	const struct mcc_tac_function *callee = mcc_tac_program_find_function(compiler->vm->program, name);
+	if (callee) {
+		if (callee->parameters_count != arguments[0]) {
+			vm_error(compiler->result, MCC_VM_ERROR_INVALID_PROGRAM,
+			         "%s calls %s with %" PRIu32 " arguments", function->name, name, arguments[0]);
+			return;
+		}
+
+		emit(compiler, OP_CALL, result, (uint32_t)(callee - compiler->vm->program->functions),
+		     add_arguments(compiler, arguments));
+		return;
+	}
+
+	for (size_t i = 0; i < sizeof(builtins) / sizeof(*builtins); i++) {
+		if (strcmp(builtins[i].name, name) != 0 || builtins[i].parameters_count != arguments[0]) {
+			continue;
+		}
+		if (arguments[0] > 1) {
+			emit(compiler, builtins[i].op, result, 0, add_arguments(compiler, arguments));
+		} else {
+			emit(compiler, builtins[i].op, result, arguments[0] ? arguments[1] : 0, 0);
+		}
+		return;
+	}
+
+	vm_error(compiler->result, MCC_VM_ERROR_UNKNOWN_FUNCTION, "%s calls unknown function %s", function->name, name);
+}
+
+// Compiles the `k`th instruction, advancing `k` past all instructions fused
+// with it.
+static void compile_instruction(struct compiler *compiler, size_t *k)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	const struct mcc_tac_instruction *instruction = instruction_at(compiler, *k);
+
+	switch ((enum mcc_tac_op)instruction->op) {
+	case MCC_TAC_OP_NOP:
+		break;
+
+	case MCC_TAC_OP_CONST:
+		if (instruction->type == MCC_TAC_TYPE_STRING) {
+			emit(compiler, OP_LOADK, destination(compiler, k, instruction->result), instruction->arg1, 0);
+		} else if (is_foldable(compiler, *k, instruction)) {
+			compiler->folded = instruction->result;
+			compiler->folded_immediate = constant_immediate(function, instruction);
+		} else {
+			uint32_t immediate = constant_immediate(function, instruction);
+			emit(compiler, OP_LOADI, destination(compiler, k, instruction->result), immediate, 0);
+		}
+		break;
+
+	case MCC_TAC_OP_ASSIGN:
+		emit(compiler, OP_MOV, destination(compiler, k, instruction->result), instruction->arg1, 0);
+		break;
+
+	case MCC_TAC_OP_ADD:
+	case MCC_TAC_OP_SUB:
+	case MCC_TAC_OP_MUL:
+	case MCC_TAC_OP_DIV:
+	case MCC_TAC_OP_EQ:
+	case MCC_TAC_OP_NE:
+	case MCC_TAC_OP_LT:
+	case MCC_TAC_OP_LE:
+	case MCC_TAC_OP_GT:
+	case MCC_TAC_OP_GE:
+	case MCC_TAC_OP_AND:
+	case MCC_TAC_OP_OR:
+		compile_binary(compiler, k, instruction);
+		break;
+
+	case MCC_TAC_OP_NEG:
+		emit(compiler, instruction->type == MCC_TAC_TYPE_FLOAT ? OP_NEG_F : OP_NEG_I,
+		     destination(compiler, k, instruction->result), instruction->arg1, 0);
+		break;
+
+	case MCC_TAC_OP_NOT:
+		emit(compiler, OP_NOT, destination(compiler, k, instruction->result), instruction->arg1, 0);
+		break;
+
+	case MCC_TAC_OP_ARRAY: {
+		uint64_t size = function->constants[instruction->arg1];
+		uint64_t offset = compiler->frame_size;
+		compiler->frame_size += size;
+		if (size > INT32_MAX || compiler->frame_size > UINT32_MAX) {
+			vm_error(compiler->result, MCC_VM_ERROR_INVALID_PROGRAM, "frame of %s is too large",
+			         function->name);
+			break;
+		}
+		emit(compiler, OP_ARRAY, destination(compiler, k, instruction->result), (uint32_t)offset, 0);
+		break;
+	}
+
+	case MCC_TAC_OP_LOAD:
+		emit(compiler, OP_LOAD, destination(compiler, k, instruction->result), instruction->arg1,
+		     instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_STORE:
+		emit(compiler, OP_STORE, instruction->result, instruction->arg1, instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_LABEL:
+		compiler->labels[instruction->arg2] = (uint32_t)compiler->out->code_count;
+		break;
+
+	case MCC_TAC_OP_JUMP:
+		emit(compiler, OP_JUMP, 0, 0, instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_JUMP_IF:
+		emit(compiler, OP_JUMP_IF, instruction->arg1, 0, instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_JUMP_IF_NOT:
+		emit(compiler, OP_JUMP_IF_NOT, instruction->arg1, 0, instruction->arg2);
+		break;
+
+	case MCC_TAC_OP_PARAM:
+		if (instruction->arg1 >= function->parameters_count) {
+			vm_error(compiler->result, MCC_VM_ERROR_INVALID_PROGRAM, "%s has no parameter %" PRIu32,
+			         function->name, instruction->arg1);
+			break;
+		}
+		compiler->out->parameters[instruction->arg1] = instruction->result;
+		break;
+
+	case MCC_TAC_OP_CALL:
+		compile_call(compiler, k, instruction);
+		break;
+
+	case MCC_TAC_OP_RETURN:
+		if (instruction->arg1) {
+			emit(compiler, OP_RET, instruction->arg1, 0, 0);
+		} else {
+			emit(compiler, OP_RET_VOID, 0, 0, 0);
+		}
+		break;
+
+	case MCC_TAC_OP_PHI:
+		vm_error(compiler->result, MCC_VM_ERROR_INVALID_PROGRAM, "%s is in SSA form", function->name);
+		break;
+	}
+
+	(*k)++;
+}
+
+static void compile_function(struct compiler *compiler)
+{
+	const struct mcc_tac_function *function = compiler->function;
+	struct mcc_vm_function *out = compiler->out;
+
+	out->name = function->name;
+	out->parameters_count = function->parameters_count;
+	out->parameters = calloc(function->parameters_count + 1, sizeof(*out->parameters));
+	out->constants = calloc(function->strings_count + 1, sizeof(*out->constants));
+	compiler->definitions = calloc((size_t)function->variables_count + 1, sizeof(*compiler->definitions));
+	compiler->uses = calloc((size_t)function->variables_count + 1, sizeof(*compiler->uses));
+	compiler->labels = malloc(((size_t)function->labels_count + 1) * sizeof(*compiler->labels));
+	compiler->live = malloc((function->instructions_count + 1) * sizeof(*compiler->live));
+	if (!out->parameters || !out->constants || !compiler->definitions || !compiler->uses || !compiler->labels ||
+	    !compiler->live) {
+		compiler_allocation_error(compiler);
+		return;
+	}
+
+	for (size_t i = 0; i < function->strings_count; i++) {
+		out->constants[i].s = function->strings[i];
+	}
+	for (size_t i = 0; i <= function->labels_count; i++) {
+		compiler->labels[i] = UINT32_MAX;
+	}
+	count_variables(compiler);
+	compiler->frame_size = (uint64_t)function->variables_count + 1;
+
+	for (size_t k = 0; k < compiler->live_count && !failed();) {
+		compile_instruction(compiler, &k);
+	}
+
+	// Functions may run off their end only if they are void, the return
+	// keeps the frame from being left otherwise.
+	emit(compiler, OP_RET_VOID, 0, 0, 0);
+	if (failed()) {
+		return;
+	}
+
+	for (size_t i = 0; i < out->code_count; i++) {
+		struct vm_instruction *instruction = &out->code[i];
+		if (!is_jump(instruction->op)) {
+			continue;
+		}
+		if (instruction->c > function->labels_count || compiler->labels[instruction->c] == UINT32_MAX) {
+			vm_error(compiler->result, MCC_VM_ERROR_INVALID_PROGRAM,
+			         "%s jumps to L%" PRIu32 ", which is not placed", function->name, instruction->c);
+			return;
+		}
+		instruction->c = compiler->labels[instruction->c];
+	}
+	out->frame_size = (uint32_t)compiler->frame_size;
+
+	interpret(NULL, NULL, NULL, out);
+}
+
+struct mcc_vm_result mcc_vm_compile(struct mcc_vm *vm, const struct mcc_tac_program *program)
+{
+	assert(vm);
+	assert(program);
+
+	struct mcc_vm_result result = {0};
+	*vm = (struct mcc_vm){
+	    .functions = calloc(program->functions_count + 1, sizeof(*vm->functions)),
+	    .functions_count = program->functions_count,
+	    .program = program,
+	};
+	if (!vm->functions) {
+		vm->functions_count = 0;
+		result.error = MCC_VM_ERROR_ALLOCATION_ERROR;
+		return result;
+	}
+
+	for (size_t i = 0; i < program->functions_count && !result.error; i++) {
+		struct compiler compiler = {
+		    .vm = vm,
+		    .function = &program->functions[i],
+		    .out = &vm->functions[i],
+		    .result = &result,
+		};
+		compile_function(&compiler);
+
+		free(compiler.definitions);
+		free(compiler.uses);
+		free(compiler.labels);
+		free(compiler.live);
+	}
+	return result;
+}
+
+void mcc_vm_deinit(struct mcc_vm *vm)
+{
+	assert(vm);
+
+	for (size_t i = 0; i < vm->functions_count; i++) {
+		free(vm->functions[i].code);
+		free(vm->functions[i].arguments);
+		free(vm->functions[i].parameters);
+		free(vm->functions[i].constants);
+	}
+	free(vm->functions);
+}
+
+// ------------------------------------------------------------------- Calling
+
+struct mcc_vm_result mcc_vm_call(const struct mcc_vm *vm,
+                                 const char *name,
+                                 const union mcc_vm_value *arguments,
+                                 size_t arguments_count,
+                                 const struct mcc_vm_options *options)
+{
+	assert(vm);
+	assert(name);
+	assert(arguments || arguments_count == 0);
+
+	struct mcc_vm_result result = {0};
+	const struct mcc_tac_function *tac_function = mcc_tac_program_find_function(vm->program, name);
+	if (!tac_function) {
+		vm_error(&result, MCC_VM_ERROR_UNKNOWN_FUNCTION, "unknown function %s", name);
+		return result;
+	}
+	const struct mcc_vm_function *function = &vm->functions[tac_function - vm->program->functions];
+	if (function->parameters_count != arguments_count) {
+		vm_error(&result, MCC_VM_ERROR_INVALID_PROGRAM, "%s takes %zu arguments", name,
+		         function->parameters_count);
+		return result;
+	}
+
+	size_t stack_size = options && options->stack_size ? options->stack_size : MCC_VM_DEFAULT_STACK_SIZE;
+	if (stack_size < function->frame_size) {
+		vm_error(&result, MCC_VM_ERROR_STACK_OVERFLOW, "stack overflow calling %s", name);
+		return result;
+	}
+
+	// Frames take at least a few registers, deeper recursion overflows the
+	// stack anyway.
+	size_t frames_count = stack_size / 4 + 2;
+	struct run run = {
+	    .vm = vm,
+	    .in = options && options->in ? options->in : stdin,
+	    .out = options && options->out ? options->out : stdout,
+	    .stack = calloc(stack_size, sizeof(*run.stack)),
+	    .frames = malloc(frames_count * sizeof(*run.frames)),
+	    .fuel = options && options->fuel ? options->fuel : SIZE_MAX,
+	    .result = &result,
+	};
+	if (!run.stack || !run.frames) {
+		free(run.stack);
+		free(run.frames);
+		result.error = MCC_VM_ERROR_ALLOCATION_ERROR;
+		return result;
+	}
+	run.stack_end = run.stack + stack_size;
+	run.frames_end = run.frames + frames_count;
+
+	for (size_t i = 0; i < arguments_count; i++) {
+		run.stack[function->parameters[i]] = arguments[i];
+	}
+	interpret(&run, function, run.stack, NULL);
+
+	mcc_memo_table_deinit(&run.memo);
+	free(run.stack);
+	free(run.frames);
+	return result;
+}
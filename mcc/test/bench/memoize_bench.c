@@ -0,0 +1,152 @@
+// Runs doubly recursive mC functions in the bytecode VM, as lowered and after
+// automatic memoisation, and reports the time taken for growing inputs.
+//
+// usage: memoize_bench [n]
+//
+// Computes Fibonacci and Lucas numbers for inputs from 5 up to `n` in steps
+// of 5, `n` defaults to 30. Plain runs are skipped once they take longer
+// than a second, their time grows exponentially while memoised runs grow
+// linearly.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mcc/memoize.h"
+#include "mcc/parser.h"
+#include "mcc/semantic.h"
+#include "mcc/tac.h"
+#include "mcc/tac_lower.h"
+#include "mcc/vm.h"
+
+#define DEFAULT_N 30
+
+static const char source[] = "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+                             "int lucas(int n) {\n"
+                             "  if (n == 0) return 2;\n"
+                             "  if (n == 1) return 1;\n"
+                             "  return lucas(n - 1) + lucas(n - 2);\n"
+                             "}\n"
+                             "int main() { return 0; }\n";
+
+static const char *const functions[] = {"fib", "lucas"};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool lower(struct mcc_tac_program *tac)
+{
+	struct mcc_parser_result parser_result = mcc_parse_program_string(source);
+	if (parser_result.error) {
+		mcc_parser_result_print_error(stderr, &parser_result);
+		return false;
+	}
+
+	struct mcc_semantic_result semantic_result = mcc_semantic_check(parser_result.program, NULL);
+	if (semantic_result.error) {
+		mcc_semantic_result_print_errors(stderr, &semantic_result, "<generated>");
+		mcc_semantic_result_deinit(&semantic_result);
+		mcc_ast_delete_program(parser_result.program);
+		return false;
+	}
+	mcc_semantic_result_deinit(&semantic_result);
+
+	mcc_tac_program_init(tac);
+	bool ok = mcc_tac_lower_program(tac, parser_result.program, NULL);
+	mcc_ast_delete_program(parser_result.program);
+	if (!ok) {
+		fprintf(stderr, "out of memory\n");
+		mcc_tac_program_deinit(tac);
+	}
+	return ok;
+}
+
+// Returns the time taken by `name(n)` in seconds, negative on errors.
+static double measure(const struct mcc_vm *vm, const char *name, int n, int *value)
+{
+	union mcc_vm_value argument = {.i = n};
+
+	double start = now();
+	struct mcc_vm_result result = mcc_vm_call(vm, name, &argument, 1, NULL);
+	double elapsed = now() - start;
+
+	if (result.error) {
+		mcc_vm_result_print_error(stderr, &result);
+		return -1;
+	}
+	*value = result.value.i;
+	return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+	int n = DEFAULT_N;
+	if (argc > 1) {
+		n = atoi(argv[1]);
+	}
+
+	struct mcc_tac_program plain, memoized;
+	if (!lower(&plain)) {
+		return EXIT_FAILURE;
+	}
+	if (!lower(&memoized)) {
+		mcc_tac_program_deinit(&plain);
+		return EXIT_FAILURE;
+	}
+
+	bool ok = mcc_memoize_program(&memoized, NULL);
+	struct mcc_vm plain_vm, memoized_vm;
+	struct mcc_vm_result result = mcc_vm_compile(&plain_vm, &plain);
+	if (!result.error) {
+		result = mcc_vm_compile(&memoized_vm, &memoized);
+		if (result.error) {
+			mcc_vm_deinit(&memoized_vm);
+		}
+	}
+	if (!ok || result.error) {
+		mcc_vm_result_print_error(stderr, &result);
+		mcc_vm_deinit(&plain_vm);
+		mcc_tac_program_deinit(&plain);
+		mcc_tac_program_deinit(&memoized);
+		return EXIT_FAILURE;
+	}
+
+	printf("%-10s %5s %12s %14s %14s\n", "function", "n", "value", "plain (ms)", "memoised (ms)");
+	for (size_t f = 0; ok && f < sizeof(functions) / sizeof(*functions); f++) {
+		bool skip_plain = false;
+		for (int i = 5; ok && i <= n; i += 5) {
+			int value = 0, memoized_value = 0;
+			double plain_time = -1;
+			if (!skip_plain) {
+				plain_time = measure(&plain_vm, functions[f], i, &value);
+				ok = plain_time >= 0;
+				skip_plain = plain_time > 1.0;
+			}
+			double memoized_time = measure(&memoized_vm, functions[f], i, &memoized_value);
+			ok = ok && memoized_time >= 0;
+
+			if (plain_time >= 0) {
+				printf("%-10s %5d %12d %14.3f %14.3f\n", functions[f], i, memoized_value, plain_time * 1e3,
+				       memoized_time * 1e3);
+			} else {
+				printf("%-10s %5d %12d %14s %14.3f\n", functions[f], i, memoized_value, "-", memoized_time * 1e3);
+			}
+			if (plain_time >= 0 && value != memoized_value) {
+				fprintf(stderr, "%s(%d): memoised result %d differs from %d\n", functions[f], i, memoized_value,
+				        value);
+				ok = false;
+			}
+		}
+	}
+
+	mcc_vm_deinit(&plain_vm);
+	mcc_vm_deinit(&memoized_vm);
+	mcc_tac_program_deinit(&plain);
+	mcc_tac_program_deinit(&memoized);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
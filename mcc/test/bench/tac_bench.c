@@ -0,0 +1,105 @@
+// Lowers a single, huge function to TAC and reports the time taken.
+//
+// usage: tac_bench [instructions]
+//
+// The generated `main` increments a variable over and over, each increment
+// lowering to three instructions.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mcc/parser.h"
+#include "mcc/semantic.h"
+#include "mcc/tac.h"
+#include "mcc/tac_lower.h"
+
+#define DEFAULT_INSTRUCTIONS 1000000
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static char *generate_source(size_t statements)
+{
+	static const char head[] = "int main() { int x; x = 0;\n";
+	static const char statement[] = "x = x + 1;\n";
+	static const char tail[] = "return x; }\n";
+
+	size_t size = sizeof(head) + statements * (sizeof(statement) - 1) + sizeof(tail);
+	char *source = malloc(size);
+	if (!source) {
+		return NULL;
+	}
+
+	char *p = source;
+	memcpy(p, head, sizeof(head) - 1);
+	p += sizeof(head) - 1;
+	for (size_t i = 0; i < statements; i++) {
+		memcpy(p, statement, sizeof(statement) - 1);
+		p += sizeof(statement) - 1;
+	}
+	memcpy(p, tail, sizeof(tail));
+	return source;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t instructions = DEFAULT_INSTRUCTIONS;
+	if (argc > 1) {
+		instructions = strtoul(argv[1], NULL, 10);
+	}
+
+	char *source = generate_source(instructions / 3);
+	if (!source) {
+		fprintf(stderr, "out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	struct mcc_parser_result parser_result = mcc_parse_program_string(source);
+	free(source);
+	if (parser_result.error) {
+		mcc_parser_result_print_error(stderr, &parser_result);
+		return EXIT_FAILURE;
+	}
+
+	struct mcc_semantic_result semantic_result = mcc_semantic_check(parser_result.program, NULL);
+	if (semantic_result.error) {
+		mcc_semantic_result_print_errors(stderr, &semantic_result, "<generated>");
+		mcc_semantic_result_deinit(&semantic_result);
+		mcc_ast_delete_program(parser_result.program);
+		return EXIT_FAILURE;
+	}
+	mcc_semantic_result_deinit(&semantic_result);
+
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+
+	double start = now();
+	bool ok = mcc_tac_lower_program(&tac, parser_result.program, NULL);
+	double elapsed = now() - start;
+
+	if (ok) {
+		const struct mcc_tac_function *function = &tac.functions[0];
+		size_t bytes = function->instructions_capacity * sizeof(*function->instructions) +
+		               function->variable_types_capacity * sizeof(*function->variable_types) +
+		               function->constants_capacity * sizeof(*function->constants) +
+		               function->strings_capacity * sizeof(*function->strings);
+		printf("lowered %zu instructions in %.3f ms (%.1f ns/instruction)\n", function->instructions_count,
+		       elapsed * 1e3, elapsed * 1e9 / (double)function->instructions_count);
+		printf("storage: %zu bytes including side tables (%zu bytes/instruction packed, %.1f bytes/instruction "
+		       "overall)\n",
+		       bytes, sizeof(*function->instructions), (double)bytes / (double)function->instructions_count);
+	} else {
+		fprintf(stderr, "out of memory\n");
+	}
+
+	mcc_tac_program_deinit(&tac);
+	mcc_ast_delete_program(parser_result.program);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
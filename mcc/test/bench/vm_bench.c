@@ -0,0 +1,97 @@
+// Runs call- and loop-heavy mC programs in the bytecode VM and reports the
+// time taken.
+//
+// usage: vm_bench [n]
+//
+// Computes fib(n) recursively, then sums the numbers below 1000 * n in a loop
+// with a small array. `n` defaults to 27.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mcc/parser.h"
+#include "mcc/semantic.h"
+#include "mcc/tac.h"
+#include "mcc/tac_lower.h"
+#include "mcc/vm.h"
+
+#define DEFAULT_N 27
+
+static const char source[] = "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+                             "int loop(int n) {\n"
+                             "  int[2] a; int i; a[0] = 0; a[1] = 0; i = 0;\n"
+                             "  while (i < 1000 * n) { a[i - i / 2 * 2] = a[i - i / 2 * 2] + i; i = i + 1; }\n"
+                             "  return a[0] - a[1];\n"
+                             "}\n"
+                             "int main() { return 0; }\n";
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool bench(const struct mcc_vm *vm, const char *name, int n)
+{
+	union mcc_vm_value argument = {.i = n};
+
+	double start = now();
+	struct mcc_vm_result result = mcc_vm_call(vm, name, &argument, 1, NULL);
+	double elapsed = now() - start;
+
+	if (result.error) {
+		mcc_vm_result_print_error(stderr, &result);
+		return false;
+	}
+	printf("%s(%d) = %d in %.3f ms\n", name, n, result.value.i, elapsed * 1e3);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	int n = DEFAULT_N;
+	if (argc > 1) {
+		n = atoi(argv[1]);
+	}
+
+	struct mcc_parser_result parser_result = mcc_parse_program_string(source);
+	if (parser_result.error) {
+		mcc_parser_result_print_error(stderr, &parser_result);
+		return EXIT_FAILURE;
+	}
+
+	struct mcc_semantic_result semantic_result = mcc_semantic_check(parser_result.program, NULL);
+	if (semantic_result.error) {
+		mcc_semantic_result_print_errors(stderr, &semantic_result, "<generated>");
+		mcc_semantic_result_deinit(&semantic_result);
+		mcc_ast_delete_program(parser_result.program);
+		return EXIT_FAILURE;
+	}
+	mcc_semantic_result_deinit(&semantic_result);
+
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	bool ok = mcc_tac_lower_program(&tac, parser_result.program, NULL);
+	mcc_ast_delete_program(parser_result.program);
+	if (!ok) {
+		fprintf(stderr, "out of memory\n");
+		mcc_tac_program_deinit(&tac);
+		return EXIT_FAILURE;
+	}
+
+	struct mcc_vm vm;
+	struct mcc_vm_result result = mcc_vm_compile(&vm, &tac);
+	if (result.error) {
+		mcc_vm_result_print_error(stderr, &result);
+		ok = false;
+	} else {
+		ok = bench(&vm, "fib", n) && bench(&vm, "loop", n);
+	}
+
+	mcc_vm_deinit(&vm);
+	mcc_tac_program_deinit(&tac);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
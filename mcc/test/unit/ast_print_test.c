@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <CuTest.h>
+
+#include "mcc/ast_print.h"
+#include "mcc/parser.h"
+
+// Prints `input` with the given options into a freshly allocated string.
+static char *print_expression(CuTest *tc, const char *input, const struct mcc_ast_print_options *options)
+{
+	struct mcc_parser_result result = mcc_parse_string(input);
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, result.error);
+
+	char *output = NULL;
+	size_t output_size = 0;
+	FILE *out = open_memstream(&output, &output_size);
+	CuAssertPtrNotNull(tc, out);
+
+	CuAssertTrue(tc, mcc_ast_print_expression(out, result.expression, options));
+	fclose(out);
+
+	mcc_ast_delete_expression(result.expression);
+	mcc_string_pool_deinit(&result.strings);
+	return output;
+}
+
+void Print_Dot(CuTest *tc)
+{
+	char *output = print_expression(tc, "-a", NULL);
+
+	CuAssertStrEquals(tc,
+	                  "digraph \"AST\" {\n"
+	                  "\tnodesep=0.6\n"
+	                  "\tnode [shape=box];\n"
+	                  "\t0 [label=\"expr: -\"];\n"
+	                  "\t1 [label=\"expr\"];\n"
+	                  "\t0 -> 1 [label=\"operand\"];\n"
+	                  "\t2 [label=\"ident: a\"];\n"
+	                  "\t1 -> 2 [label=\"identifier\"];\n"
+	                  "}\n",
+	                  output);
+
+	free(output);
+}
+
+void Print_Json(CuTest *tc)
+{
+	struct mcc_ast_print_options options = {.format = MCC_AST_PRINT_FORMAT_JSON};
+	char *output = print_expression(tc, "f(1, \"x\")", &options);
+
+	CuAssertStrEquals(tc,
+	                  "{\"id\":0,\"kind\":\"expr\",\"label\":\"call\",\"children\":["
+	                  "{\"id\":1,\"edge\":\"callee\",\"kind\":\"ident\",\"label\":\"f\"},"
+	                  "{\"id\":2,\"edge\":\"0\",\"kind\":\"expr\",\"children\":["
+	                  "{\"id\":3,\"edge\":\"literal\",\"kind\":\"lit\",\"label\":\"1\"}]},"
+	                  "{\"id\":4,\"edge\":\"1\",\"kind\":\"expr\",\"children\":["
+	                  "{\"id\":5,\"edge\":\"literal\",\"kind\":\"lit\",\"label\":\"\\\"x\\\"\"}]}]}\n",
+	                  output);
+
+	free(output);
+}
+
+void Print_SexprDepthLimit(CuTest *tc)
+{
+	struct mcc_ast_print_options options = {.format = MCC_AST_PRINT_FORMAT_SEXPR, .max_depth = 1};
+	char *output = print_expression(tc, "1 + 2 * 3", &options);
+
+	CuAssertStrEquals(tc, "(expr \"+\" :lhs (expr :literal ...) :rhs (expr \"*\" :lhs ... :rhs ...))\n", output);
+
+	free(output);
+}
+
+#define TESTS \
+	TEST(Print_Dot) \
+	TEST(Print_Json) \
+	TEST(Print_SexprDepthLimit)
+
+#include "main_stub.inc"
@@ -0,0 +1,40 @@
+#include <CuTest.h>
+
+#include "mcc/ast_stats.h"
+#include "mcc/parser.h"
+
+void Stats_Counts(CuTest *tc)
+{
+	const char input[] = "int main() { int a; a = 1 + 2; print_int(a); return a; }";
+	struct mcc_parser_result result = mcc_parse_program_string(input);
+
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, result.error);
+
+	struct mcc_ast_stats stats;
+	mcc_ast_stats_collect(&stats, result.program, &result.lexer_stats);
+
+	CuAssertIntEquals(tc, 1, stats.kinds[MCC_AST_STATS_KIND_PROGRAM].count);
+	CuAssertIntEquals(tc, 1, stats.kinds[MCC_AST_STATS_KIND_FUNCTION].count);
+	CuAssertIntEquals(tc, 1, stats.kinds[MCC_AST_STATS_KIND_DECLARATION].count);
+	CuAssertIntEquals(tc, 1, stats.kinds[MCC_AST_STATS_KIND_ASSIGNMENT].count);
+	CuAssertIntEquals(tc, 5, stats.kinds[MCC_AST_STATS_KIND_STATEMENT].count);
+	CuAssertIntEquals(tc, 6, stats.kinds[MCC_AST_STATS_KIND_EXPRESSION].count);
+	CuAssertIntEquals(tc, 2, stats.kinds[MCC_AST_STATS_KIND_LITERAL].count);
+	CuAssertIntEquals(tc, 6, stats.kinds[MCC_AST_STATS_KIND_IDENTIFIER].count);
+
+	// program's functions, the body's statements, and the call's arguments
+	CuAssertIntEquals(tc, 3, stats.kinds[MCC_AST_STATS_KIND_ARRAY].count);
+
+	// "main", "a", and "print_int"
+	CuAssertIntEquals(tc, 3, stats.strings.count);
+
+	CuAssertIntEquals(tc, sizeof(struct mcc_ast_expression) * 6, stats.kinds[MCC_AST_STATS_KIND_EXPRESSION].bytes);
+	CuAssertIntEquals(tc, 9, stats.lexer.buffer_high_water);
+	CuAssertIntEquals(tc, 24, stats.lexer.lexemes);
+
+	mcc_ast_delete_program(result.program);
+}
+
+#define TESTS TEST(Stats_Counts)
+
+#include "main_stub.inc"
@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <CuTest.h>
+
+#include "mcc/cfg.h"
+#include "mcc/dce.h"
+#include "mcc/liveness.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+void Dce_Liveness(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int f(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = CONST int 0\n"
+	      "L1:\n"
+	      "	v3 = GT int v1, v2\n"
+	      "	JUMP_IF_NOT L2, v3\n"
+	      "	v4 = CONST int 1\n"
+	      "	v1 = SUB int v1, v4\n"
+	      "	v5 = ADD int v1, v4\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	RETURN int v5\n");
+
+	struct mcc_tac_function *function = &tac.functions[0];
+	struct mcc_cfg cfg;
+	CuAssertTrue(tc, mcc_cfg_build(&cfg, function));
+	struct mcc_liveness liveness;
+	CuAssertTrue(tc, mcc_liveness_compute(&liveness, &cfg, function));
+
+	// v5 is read after the loop, before any assignment if it never runs.
+	const uint64_t *entry_in = mcc_liveness_in(&liveness, 0);
+	CuAssertTrue(tc, !mcc_liveness_set_contains(entry_in, 1));
+	CuAssertTrue(tc, mcc_liveness_set_contains(entry_in, 5));
+
+	uint32_t header = cfg.label_blocks[1];
+	const uint64_t *header_in = mcc_liveness_in(&liveness, header);
+	CuAssertTrue(tc, mcc_liveness_set_contains(header_in, 1));
+	CuAssertTrue(tc, mcc_liveness_set_contains(header_in, 2));
+	CuAssertTrue(tc, !mcc_liveness_set_contains(header_in, 3));
+	CuAssertTrue(tc, !mcc_liveness_set_contains(header_in, 4));
+	CuAssertTrue(tc, mcc_liveness_set_contains(header_in, 5));
+
+	const uint64_t *body_out = mcc_liveness_out(&liveness, header + 1);
+	CuAssertTrue(tc, mcc_liveness_set_contains(body_out, 1));
+	CuAssertTrue(tc, !mcc_liveness_set_contains(body_out, 4));
+
+	const uint64_t *exit_out = mcc_liveness_out(&liveness, cfg.label_blocks[2]);
+	for (uint32_t v = 1; v <= function->variables_count; v++) {
+		CuAssertTrue(tc, !mcc_liveness_set_contains(exit_out, v));
+	}
+
+	mcc_liveness_deinit(&liveness);
+	mcc_cfg_deinit(&cfg);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Dce_CopyPropagation(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int f(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = ASSIGN int v1\n"
+	      "	v3 = ASSIGN int v2\n"
+	      "	v4 = ADD int v3, v2\n"
+	      "	v1 = CONST int 5\n"
+	      "	v5 = ADD int v3, v1\n"
+	      "	v6 = GT int v5, v1\n"
+	      "	JUMP_IF_NOT L1, v6\n"
+	      "	v3 = ASSIGN int v1\n"
+	      "L1:\n"
+	      "	v7 = ADD int v3, v4\n"
+	      "	RETURN int v7\n");
+
+	size_t propagated = 0;
+	CuAssertTrue(tc, mcc_dce_propagate_copies(&tac.functions[0], &propagated));
+	CuAssertIntEquals(tc, 4, (int)propagated);
+
+	// Copies of v1 stop at its assignment, copies into v3 at the merge.
+	assert_printed(tc,
+	               "function int f(1)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = ASSIGN int v1\n"
+	               "	v3 = ASSIGN int v1\n"
+	               "	v4 = ADD int v1, v1\n"
+	               "	v1 = CONST int 5\n"
+	               "	v5 = ADD int v2, v1\n"
+	               "	v6 = GT int v5, v1\n"
+	               "	JUMP_IF_NOT L1, v6\n"
+	               "	v3 = ASSIGN int v1\n"
+	               "L1:\n"
+	               "	v7 = ADD int v3, v4\n"
+	               "	RETURN int v7\n",
+	               &tac.functions[0]);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Dce_Eliminate(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int g(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = ARRAY int 8\n"
+	      "	v3 = CONST int 0\n"
+	      "	v4 = MUL int v1, v1\n"
+	      "	STORE int v2, v3, v4\n"
+	      "	v5 = DIV int v1, v3\n"
+	      "	v6 = CALL int g(v4)\n"
+	      "	v7 = ADD int v1, v3\n"
+	      "	v11 = GT int v1, v3\n"
+	      "	JUMP_IF_NOT L1, v11\n"
+	      "	v8 = ASSIGN int v7\n"
+	      "	v7 = ASSIGN int v8\n"
+	      "L1:\n"
+	      "	v9 = SUB int v1, v7\n"
+	      "	v10 = ASSIGN int v9\n"
+	      "	RETURN int v10\n");
+
+	struct mcc_dce_stats stats = {0};
+	CuAssertTrue(tc, mcc_dce_function(&tac.functions[0], &stats));
+	CuAssertIntEquals(tc, 5, (int)stats.removed);
+	CuAssertTrue(tc, stats.propagated > 0);
+
+	// Integer division and calls stay, the array is only ever stored into.
+	mcc_tac_function_compact(&tac.functions[0]);
+	assert_printed(tc,
+	               "function int g(1)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v3 = CONST int 0\n"
+	               "	v4 = MUL int v1, v1\n"
+	               "	v5 = DIV int v1, v3\n"
+	               "	v6 = CALL int g(v4)\n"
+	               "	v7 = ADD int v1, v3\n"
+	               "	v11 = GT int v1, v3\n"
+	               "	JUMP_IF_NOT L1, v11\n"
+	               "L1:\n"
+	               "	v9 = SUB int v1, v7\n"
+	               "	RETURN int v9\n",
+	               &tac.functions[0]);
+
+	// Nothing is left to do.
+	stats = (struct mcc_dce_stats){0};
+	CuAssertTrue(tc, mcc_dce_function(&tac.functions[0], &stats));
+	CuAssertIntEquals(tc, 0, (int)stats.removed);
+	CuAssertIntEquals(tc, 0, (int)stats.propagated);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Dce_Lowered(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int main() {\n"
+	      "  int i; int s; float f; int[4] a; int[4] b;\n"
+	      "  i = 0; s = 0; f = 0.5;\n"
+	      "  while (i < 10) {\n"
+	      "    int t; t = i * 2;\n"
+	      "    a[i / 3] = t; b[i - i / 4 * 4] = s;\n"
+	      "    s = s + t + b[0];\n"
+	      "    if (s > 20) f = f * 2.0; else { int u; u = s; }\n"
+	      "    i = i + 1;\n"
+	      "  }\n"
+	      "  print_int(s); print(\" \"); print_float(f);\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	// The expected output is given by the program as lowered.
+	char *expected = run(tc, &tac);
+
+	struct mcc_tac_function *function = &tac.functions[0];
+	size_t before = function->instructions_count;
+	struct mcc_dce_stats stats = {0};
+	CuAssertTrue(tc, mcc_dce_function(function, &stats));
+	CuAssertTrue(tc, stats.removed > 0);
+	CuAssertIntEquals(tc, (int)before, (int)function->instructions_count);
+	CuAssertIntEquals(tc, (int)stats.removed, (int)function->removed_count);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(expected);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Dce_Liveness) \
+	TEST(Dce_CopyPropagation) \
+	TEST(Dce_Eliminate) \
+	TEST(Dce_Lowered)
+
+#include "main_stub.inc"
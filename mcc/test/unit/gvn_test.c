@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/gvn.h"
+#include "mcc/ssa.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+void Gvn_Block(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function bool f(2)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = PARAM int 1\n"
+	      "	v3 = ADD int v1, v2\n"
+	      "	v4 = ADD int v2, v1\n"
+	      "	v5 = ASSIGN int v4\n"
+	      "	v6 = MUL int v5, v3\n"
+	      "	v7 = MUL int v3, v3\n"
+	      "	v8 = SUB int v1, v2\n"
+	      "	v9 = SUB int v2, v1\n"
+	      "	v10 = LT int v1, v2\n"
+	      "	v11 = GT int v2, v1\n"
+	      "	v12 = CONST int 1\n"
+	      "	v13 = CONST int 1\n"
+	      "	v14 = DIV int v1, v12\n"
+	      "	v15 = DIV int v1, v13\n"
+	      "	v16 = EQ bool v10, v11\n"
+	      "	RETURN bool v16\n");
+
+	struct mcc_gvn_stats stats = {0};
+	CuAssertTrue(tc, mcc_gvn_function(&tac.functions[0], &stats));
+	CuAssertIntEquals(tc, 4, (int)stats.eliminated);
+
+	// Subtraction does not commute, constants are only numbered.
+	assert_printed(tc,
+	               "function bool f(2)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = PARAM int 1\n"
+	               "	v3 = ADD int v1, v2\n"
+	               "	v4 = ASSIGN int v3\n"
+	               "	v5 = ASSIGN int v4\n"
+	               "	v6 = MUL int v5, v3\n"
+	               "	v7 = ASSIGN int v6\n"
+	               "	v8 = SUB int v1, v2\n"
+	               "	v9 = SUB int v2, v1\n"
+	               "	v10 = LT int v1, v2\n"
+	               "	v11 = ASSIGN bool v10\n"
+	               "	v12 = CONST int 1\n"
+	               "	v13 = CONST int 1\n"
+	               "	v14 = DIV int v1, v12\n"
+	               "	v15 = ASSIGN int v14\n"
+	               "	v16 = EQ bool v10, v11\n"
+	               "	RETURN bool v16\n",
+	               &tac.functions[0]);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+// Values computed in a branch are not available after it, values computed
+// before are.
+void Gvn_Dominators(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function float f(2)\n"
+	      "L3:\n"
+	      "	v1 = PARAM float 0\n"
+	      "	v2 = PARAM bool 1\n"
+	      "	v3 = MUL float v1, v1\n"
+	      "	v4 = NEG float v1\n"
+	      "	JUMP_IF_NOT L1, v2\n"
+	      "L4:\n"
+	      "	v5 = MUL float v1, v1\n"
+	      "	v6 = ADD float v5, v1\n"
+	      "	v7 = NEG float v1\n"
+	      "	JUMP L2\n"
+	      "L1:\n"
+	      "	v8 = ADD float v3, v1\n"
+	      "L2:\n"
+	      "	v9 = PHI float [L4, v6], [L1, v8]\n"
+	      "	v10 = ADD float v3, v1\n"
+	      "	v11 = NEG float v1\n"
+	      "	v12 = ADD float v10, v9\n"
+	      "	v13 = SUB float v12, v11\n"
+	      "	RETURN float v13\n");
+
+	struct mcc_gvn_stats stats = {0};
+	CuAssertTrue(tc, mcc_gvn_function(&tac.functions[0], &stats));
+	CuAssertIntEquals(tc, 3, (int)stats.eliminated);
+
+	const struct mcc_tac_instruction *instructions = tac.functions[0].instructions;
+	CuAssertIntEquals(tc, MCC_TAC_OP_ASSIGN, instructions[7].op);
+	CuAssertIntEquals(tc, 3, (int)instructions[7].arg1);
+	CuAssertIntEquals(tc, MCC_TAC_OP_ASSIGN, instructions[9].op);
+	CuAssertIntEquals(tc, 4, (int)instructions[9].arg1);
+	CuAssertIntEquals(tc, MCC_TAC_OP_ADD, instructions[12].op);
+	CuAssertIntEquals(tc, MCC_TAC_OP_ADD, instructions[15].op);
+	CuAssertIntEquals(tc, MCC_TAC_OP_ASSIGN, instructions[16].op);
+	CuAssertIntEquals(tc, 4, (int)instructions[16].arg1);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+// The products of the loop condition are reused in the body, as in the
+// Mandelbrot iteration.
+void Gvn_Loop(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int main() {\n"
+	      "  float x; float y; float t; int i; int n;\n"
+	      "  x = 0.0; y = 0.0; i = 0; n = 0;\n"
+	      "  while (x * x + y * y <= 4.0 && i < 50) {\n"
+	      "    t = x * x - y * y + 0.25;\n"
+	      "    y = 2.0 * x * y + 0.5;\n"
+	      "    x = t;\n"
+	      "    if (x * y > 0.0) n = n + 1;\n"
+	      "    if (y * x > 0.0) n = n + 1;\n"
+	      "    i = i + 1;\n"
+	      "  }\n"
+	      "  print_int(i); print(\" \"); print_int(n); print(\" \"); print_float(x * y);\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	char *expected = run(tc, &tac);
+
+	struct mcc_tac_function *function = &tac.functions[0];
+	CuAssertTrue(tc, mcc_ssa_construct(function));
+	struct mcc_gvn_stats stats = {0};
+	CuAssertTrue(tc, mcc_gvn_function(function, &stats));
+	CuAssertTrue(tc, mcc_ssa_destruct(function));
+	mcc_tac_function_compact(function);
+
+	// x * x, y * y, y * x, and its comparison.
+	CuAssertIntEquals(tc, 4, (int)stats.eliminated);
+	size_t products = 0;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (function->instructions[i].op == MCC_TAC_OP_MUL) {
+			products++;
+		}
+	}
+	CuAssertIntEquals(tc, 6, (int)products);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(expected);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Gvn_Block) \
+	TEST(Gvn_Dominators) \
+	TEST(Gvn_Loop)
+
+#include "main_stub.inc"
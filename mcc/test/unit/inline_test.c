@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/callgraph.h"
+#include "mcc/inline.h"
+#include "mcc/pass.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+void Inline_CallGraph(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function void a(0)\n"
+	      "	CALL void b()\n"
+	      "	CALL void d()\n"
+	      "	CALL void print_nl()\n"
+	      "	RETURN void\n"
+	      "\n"
+	      "function void b(0)\n"
+	      "	CALL void c()\n"
+	      "	RETURN void\n"
+	      "\n"
+	      "function void c(0)\n"
+	      "	CALL void b()\n"
+	      "	CALL void d()\n"
+	      "	RETURN void\n"
+	      "\n"
+	      "function void d(0)\n"
+	      "	CALL void d()\n"
+	      "	RETURN void\n"
+	      "\n"
+	      "function void e(0)\n"
+	      "	RETURN void\n");
+
+	struct mcc_callgraph graph;
+	CuAssertTrue(tc, mcc_callgraph_build(&graph, &tac));
+
+	// Builtins are not part of the graph.
+	CuAssertIntEquals(tc, 2, (int)mcc_callgraph_callees_count(&graph, 0));
+	CuAssertIntEquals(tc, 1, (int)mcc_callgraph_callees(&graph, 0)[0]);
+	CuAssertIntEquals(tc, 3, (int)mcc_callgraph_callees(&graph, 0)[1]);
+	CuAssertIntEquals(tc, 0, (int)mcc_callgraph_callees_count(&graph, 4));
+
+	// d comes first, then b and c together, then their caller a.
+	CuAssertIntEquals(tc, 4, (int)graph.components_count);
+	CuAssertIntEquals(tc, 0, (int)graph.components[3]);
+	CuAssertIntEquals(tc, 1, (int)graph.components[1]);
+	CuAssertIntEquals(tc, 1, (int)graph.components[2]);
+	CuAssertIntEquals(tc, 2, (int)graph.components[0]);
+	CuAssertIntEquals(tc, 3, (int)graph.components[4]);
+	CuAssertIntEquals(tc, 3, (int)graph.order[0]);
+	CuAssertIntEquals(tc, 0, (int)graph.order[3]);
+	CuAssertIntEquals(tc, 4, (int)graph.order[4]);
+
+	CuAssertTrue(tc, !graph.recursive[0]);
+	CuAssertTrue(tc, graph.recursive[1]);
+	CuAssertTrue(tc, graph.recursive[2]);
+	CuAssertTrue(tc, graph.recursive[3]);
+	CuAssertTrue(tc, !graph.recursive[4]);
+
+	mcc_callgraph_deinit(&graph);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Inline_Basic(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int max(2)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = PARAM int 1\n"
+	      "	v3 = GT int v1, v2\n"
+	      "	JUMP_IF_NOT L1, v3\n"
+	      "	RETURN int v1\n"
+	      "L1:\n"
+	      "	RETURN int v2\n"
+	      "\n"
+	      "function void set(2)\n"
+	      "	v1 = PARAM array 0\n"
+	      "	v2 = PARAM int 1\n"
+	      "	STORE int v1, v2, v2\n"
+	      "	v2 = CONST int 7\n"
+	      "	RETURN void\n"
+	      "\n"
+	      "function int main(0)\n"
+	      "	v1 = ARRAY int 4\n"
+	      "	v2 = CONST int 3\n"
+	      "	v3 = CONST int 2\n"
+	      "	v4 = CALL int max(v2, v3)\n"
+	      "	CALL void set(v1, v4)\n"
+	      "	v5 = LOAD int v1, v4\n"
+	      "	CALL void print_int(v5)\n"
+	      "	CALL void print_int(v4)\n"
+	      "	RETURN int v4\n");
+
+	struct mcc_inline_stats stats = {0};
+	CuAssertTrue(tc, mcc_inline_program(&tac, NULL, &stats));
+	CuAssertIntEquals(tc, 2, (int)stats.inlined);
+	CuAssertIntEquals(tc, 14, (int)stats.instructions);
+
+	// The array parameter refers to main's array, the assignment of the int
+	// parameter leaves v4 alone.
+	assert_printed(tc,
+	               "function int main(0)\n"
+	               "	v1 = ARRAY int 4\n"
+	               "	v2 = CONST int 3\n"
+	               "	v3 = CONST int 2\n"
+	               "	v8 = ASSIGN int v2\n"
+	               "	v9 = ASSIGN int v3\n"
+	               "	v10 = GT int v8, v9\n"
+	               "	JUMP_IF_NOT L2, v10\n"
+	               "	v4 = ASSIGN int v8\n"
+	               "	JUMP L3\n"
+	               "L2:\n"
+	               "	v4 = ASSIGN int v9\n"
+	               "L3:\n"
+	               "	v6 = ASSIGN array v1\n"
+	               "	v7 = ASSIGN int v4\n"
+	               "	STORE int v6, v7, v7\n"
+	               "	v7 = CONST int 7\n"
+	               "L1:\n"
+	               "	v5 = LOAD int v1, v4\n"
+	               "	CALL void print_int(v5)\n"
+	               "	CALL void print_int(v4)\n"
+	               "	RETURN int v4\n",
+	               &tac.functions[2]);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, "33", output);
+	free(output);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Inline_Lowered(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "float scale(float x) { return x * 0.5; }\n"
+	      "int clamp(int x, int lo, int hi) {\n"
+	      "  if (x < lo) return lo;\n"
+	      "  if (x > hi) return hi;\n"
+	      "  return x;\n"
+	      "}\n"
+	      "void fill(int[8] a, int n) {\n"
+	      "  while (n > 0) { n = n - 1; a[n] = clamp(n * n, 2, 30); }\n"
+	      "}\n"
+	      "int sum(int[8] a) {\n"
+	      "  int i; int s; i = 0; s = 0;\n"
+	      "  while (i < 8) { s = s + a[i]; i = i + 1; }\n"
+	      "  return s;\n"
+	      "}\n"
+	      "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+	      "int main() {\n"
+	      "  int[8] a; int n; n = 8;\n"
+	      "  fill(a, n);\n"
+	      "  print_int(n); print_nl();\n"
+	      "  print_int(sum(a)); print_nl();\n"
+	      "  print_float(scale(3.0)); print_nl();\n"
+	      "  while (n > 0) { print_int(clamp(fib(n), 3, 10)); n = n - 1; }\n"
+	      "  print_nl();\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	char *expected = run(tc, &tac);
+
+	// clamp is inlined into fill first, which makes fill too large to be
+	// inlined into main.
+	struct mcc_inline_stats stats = {0};
+	CuAssertTrue(tc, mcc_inline_program(&tac, NULL, &stats));
+	CuAssertIntEquals(tc, 5, (int)stats.inlined);
+
+	// fib keeps calling itself, main gets one level of it and calls it twice.
+	for (size_t f = 0; f < tac.functions_count; f++) {
+		const struct mcc_tac_function *function = &tac.functions[f];
+		size_t calls = 0;
+		for (size_t i = 0; i < function->instructions_count; i++) {
+			const struct mcc_tac_instruction *instruction = &function->instructions[i];
+			calls += instruction->op == MCC_TAC_OP_CALL &&
+			         strcmp(function->strings[instruction->arg1], "fib") == 0;
+		}
+		CuAssertIntEquals(tc, strcmp(function->name, "fib") == 0 || strcmp(function->name, "main") == 0 ? 2 : 0,
+		                  (int)calls);
+	}
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(output);
+
+	// The default pipeline inlines as well.
+	CuAssertTrue(tc, mcc_pass_run_pipeline(mcc_pass_default_pipeline, &tac));
+	output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(expected);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Inline_CallGraph) \
+	TEST(Inline_Basic) \
+	TEST(Inline_Lowered)
+
+#include "main_stub.inc"
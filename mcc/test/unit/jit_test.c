@@ -0,0 +1,326 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/jit.h"
+#include "mcc/ssa.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+// Runs `main` of `input` reading `stdin`, returns the output.
+static char *run_source(CuTest *tc, const char *input, const char *stdin_text, struct mcc_jit_result *result)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, input);
+
+	struct mcc_jit jit;
+	*result = mcc_jit_compile(&jit, &tac);
+	CuAssertStrEquals(tc, "", result->error_msg);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result->error);
+
+	char *output = NULL;
+	size_t output_size = 0;
+	struct mcc_jit_options options = {
+	    .in = fmemopen((void *)stdin_text, strlen(stdin_text) + 1, "r"),
+	    .out = open_memstream(&output, &output_size),
+	};
+	CuAssertPtrNotNull(tc, options.in);
+	CuAssertPtrNotNull(tc, options.out);
+
+	*result = mcc_jit_call(&jit, "main", NULL, 0, &options);
+	fclose(options.in);
+	fclose(options.out);
+
+	mcc_jit_deinit(&jit);
+	mcc_tac_program_deinit(&tac);
+	return output;
+}
+
+static void assert_output(CuTest *tc, const char *input, const char *stdin_text, const char *expected)
+{
+	struct mcc_jit_result result;
+	char *output = run_source(tc, input, stdin_text, &result);
+	CuAssertStrEquals(tc, "", result.error_msg);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result.error);
+	CuAssertStrEquals(tc, expected, output);
+	free(output);
+}
+
+void Jit_Arithmetic(CuTest *tc)
+{
+	assert_output(tc,
+	              "int main() {\n"
+	              "  int x; x = 2147483647;\n"
+	              "  print_int(x + 1); print_nl();\n"
+	              "  print_int(-7 / 2); print_nl();\n"
+	              "  print_int(10 - x / 1000000000 * 3); print_nl();\n"
+	              "  print_float(1.0 / 3.0 - 2.5 * 2.0); print_nl();\n"
+	              "  print_float(-(0.5 - 0.25)); print_nl();\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "", "-2147483648\n-3\n4\n-4.67\n-0.25\n");
+
+	// The divisor is only known at run time.
+	assert_output(tc,
+	              "int main() {\n"
+	              "  int x; x = -2147483647 - 1;\n"
+	              "  int d; d = read_int();\n"
+	              "  print_int(x / d); print_nl();\n"
+	              "  print_int(7 / d); print_nl();\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "-1", "-2147483648\n-7\n");
+}
+
+void Jit_UnassignedString(CuTest *tc)
+{
+	assert_output(tc,
+	              "void show(string s) { print(s); }\n"
+	              "int main() {\n"
+	              "  string s; string[2] a;\n"
+	              "  print(\"<\"); print(s); print(a[1]); show(s); print(\">\");\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "", "<>");
+}
+
+void Jit_Comparisons(CuTest *tc)
+{
+	assert_output(tc,
+	              "int main() {\n"
+	              "  int i; i = 0;\n"
+	              "  while (3 > i) { print_int(i); i = i + 1; }\n"
+	              "  bool b; b = i >= 3 && !(i == 4);\n"
+	              "  if (b) print(\"b\");\n"
+	              "  bool c; c = i < 3 || i != 3;\n"
+	              "  if (!c) print(\"c\");\n"
+	              "  float f; f = 0.5;\n"
+	              "  while (!(f >= 2.0)) f = f * 2.0;\n"
+	              "  if (f == 2.0) print(\"f\");\n"
+	              "  if (f != 2.0) print(\"!\");\n"
+	              "  if (1.0 < f) print(\"<\");\n"
+	              "  if (f <= 1.0) print(\">\");\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "", "012bcf<");
+}
+
+void Jit_Calls(CuTest *tc)
+{
+	assert_output(tc,
+	              "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+	              "void fill(int[4] a, int v) { int i; i = 0; while (i < 4) { a[i] = v + i; i = i + 1; } }\n"
+	              "float half(float x) { return x / 2.0; }\n"
+	              "string pick(bool b, string x, string y) { if (b) return x; return y; }\n"
+	              "int main() {\n"
+	              "  int[4] a; fill(a, read_int());\n"
+	              "  print_int(a[0] + a[3]); print_nl();\n"
+	              "  print_int(fib(15)); print_nl();\n"
+	              "  print_float(half(read_float())); print_nl();\n"
+	              "  string[2] s; s[1] = pick(a[0] > 5, \"done\", \"oops\");\n"
+	              "  print(s[1]);\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "10 5.5", "23\n610\n2.75\ndone");
+}
+
+void Jit_SiblingCalls(CuTest *tc)
+{
+	// Ten million frames would overflow the stack. sum passes main's array
+	// along, ends creates its own and must not pass it as a sibling call,
+	// spread takes more arguments than wide has slots for.
+	assert_output(tc,
+	              "bool odd(int n) { if (n == 0) return false; return even(n - 1); }\n"
+	              "bool even(int n) { if (n == 0) return true; return odd(n - 1); }\n"
+	              "int sum(int[4] a, int i, int s) { if (i == 4) return s; return sum(a, i + 1, s + a[i]); }\n"
+	              "int first(int[2] a) { return a[0] + a[1]; }\n"
+	              "int ends(int x) { int[2] a; a[0] = x; a[1] = x * 2; return first(a); }\n"
+	              "int spread(int a, int b, int c) { return a * 100 + b * 10 + c; }\n"
+	              "int wide(int a) { return spread(a, a + 1, a + 2); }\n"
+	              "void count(int n) { if (n == 0) return; print_int(n); count(n - 1); }\n"
+	              "int main() {\n"
+	              "  int[4] a; a[0] = 1; a[1] = 2; a[2] = 3; a[3] = 4;\n"
+	              "  if (even(10000000)) print(\"even \");\n"
+	              "  print_int(sum(a, 0, 0)); print_nl();\n"
+	              "  print_int(ends(read_int())); print_nl();\n"
+	              "  print_int(wide(1)); print_nl();\n"
+	              "  count(3);\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "7", "even 10\n21\n123\n321");
+}
+
+void Jit_ReturnValue(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int square(int x) { return x * x; }\n"
+	      "float scale(float x, int n) { float r; r = x; while (n > 1) { r = r + x; n = n - 1; } return r; }\n"
+	      "int main() { return square(7); }");
+
+	struct mcc_jit jit;
+	struct mcc_jit_result result = mcc_jit_compile(&jit, &tac);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result.error);
+
+	result = mcc_jit_call(&jit, "main", NULL, 0, NULL);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result.error);
+	CuAssertIntEquals(tc, 49, result.value.i);
+
+	union mcc_vm_value argument = {.i = -12};
+	result = mcc_jit_call(&jit, "square", &argument, 1, NULL);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result.error);
+	CuAssertIntEquals(tc, 144, result.value.i);
+
+	union mcc_vm_value arguments[] = {{.f = 1.5f}, {.i = 3}};
+	result = mcc_jit_call(&jit, "scale", arguments, 2, NULL);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result.error);
+	CuAssertDblEquals(tc, 4.5, result.value.f, 0.0);
+
+	result = mcc_jit_call(&jit, "cube", &argument, 1, NULL);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_UNKNOWN_FUNCTION, result.error);
+
+	mcc_jit_deinit(&jit);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Jit_DivisionByConstant(CuTest *tc)
+{
+	static const int32_t divisors[] = {1, -1, 2, -2, 3, -3, 5, 6, 7, -7, 10, 16, -16, 641, 1 << 30, 1000000007,
+	                                   INT32_MAX, INT32_MIN};
+	static const int32_t dividends[] = {0, 1, -1, 2, -2, 3, -7, 100, -100, 12345678, -87654321, INT32_MAX,
+	                                    INT32_MIN};
+	size_t count = sizeof(divisors) / sizeof(*divisors);
+
+	// One function per divisor, the constant separated from the division.
+	char *input = NULL;
+	size_t input_size = 0;
+	FILE *out = open_memstream(&input, &input_size);
+	CuAssertPtrNotNull(tc, out);
+	for (size_t d = 0; d < count; d++) {
+		fprintf(out,
+		        "function int d%zu(1)\n"
+		        "\tv1 = PARAM int 0\n"
+		        "\tv2 = CONST int %" PRId32 "\n"
+		        "\tv3 = NEG int v1\n"
+		        "\tv4 = DIV int v1, v2\n"
+		        "\tRETURN int v4\n\n",
+		        d, divisors[d]);
+	}
+	fclose(out);
+
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	struct mcc_tac_parser_result parser_result = mcc_tac_parse_string(&tac, input);
+	CuAssertIntEquals(tc, MCC_TAC_PARSER_ERROR_NONE, parser_result.error);
+	free(input);
+
+	struct mcc_jit jit;
+	struct mcc_jit_result result = mcc_jit_compile(&jit, &tac);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result.error);
+
+	for (size_t d = 0; d < count; d++) {
+		char name[16];
+		snprintf(name, sizeof(name), "d%zu", d);
+		for (size_t n = 0; n < sizeof(dividends) / sizeof(*dividends); n++) {
+			int32_t dividend = dividends[n];
+			int32_t expected =
+			    divisors[d] == -1 ? (int32_t)(0u - (uint32_t)dividend) : dividend / divisors[d];
+			union mcc_vm_value argument = {.i = dividend};
+			result = mcc_jit_call(&jit, name, &argument, 1, NULL);
+			CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, result.error);
+			CuAssertIntEquals(tc, expected, result.value.i);
+		}
+	}
+
+	mcc_jit_deinit(&jit);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Jit_DivisionMatchesVm(CuTest *tc)
+{
+	static const int32_t values[] = {0, 1, -1, 2, -2, 7, -7, INT32_MAX, INT32_MIN};
+	size_t count = sizeof(values) / sizeof(*values);
+
+	// Both operands are parameters, so neither backend sees a constant.
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int divide(2)\n"
+	      "\tv1 = PARAM int 0\n"
+	      "\tv2 = PARAM int 1\n"
+	      "\tv3 = DIV int v1, v2\n"
+	      "\tRETURN int v3\n");
+
+	struct mcc_vm vm;
+	struct mcc_vm_result vm_result = mcc_vm_compile(&vm, &tac);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, vm_result.error);
+	struct mcc_jit jit;
+	struct mcc_jit_result jit_result = mcc_jit_compile(&jit, &tac);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, jit_result.error);
+
+	for (size_t n = 0; n < count; n++) {
+		for (size_t d = 0; d < count; d++) {
+			if (values[d] == 0) {
+				continue;
+			}
+			union mcc_vm_value arguments[] = {{.i = values[n]}, {.i = values[d]}};
+			vm_result = mcc_vm_call(&vm, "divide", arguments, 2, NULL);
+			CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, vm_result.error);
+			jit_result = mcc_jit_call(&jit, "divide", arguments, 2, NULL);
+			CuAssertIntEquals(tc, MCC_JIT_ERROR_NONE, jit_result.error);
+			CuAssertIntEquals(tc, vm_result.value.i, jit_result.value.i);
+		}
+	}
+
+	// The smallest int divided by -1 wraps around.
+	union mcc_vm_value arguments[] = {{.i = INT32_MIN}, {.i = -1}};
+	jit_result = mcc_jit_call(&jit, "divide", arguments, 2, NULL);
+	CuAssertIntEquals(tc, INT32_MIN, jit_result.value.i);
+
+	mcc_jit_deinit(&jit);
+	mcc_vm_deinit(&vm);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Jit_CompileErrors(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	struct mcc_tac_parser_result parser_result = mcc_tac_parse_string(&tac,
+	                                                                  "function int main(0)\n"
+	                                                                  "\tv1 = CALL int g()\n"
+	                                                                  "\tRETURN int v1\n");
+	CuAssertIntEquals(tc, MCC_TAC_PARSER_ERROR_NONE, parser_result.error);
+
+	struct mcc_jit jit;
+	struct mcc_jit_result result = mcc_jit_compile(&jit, &tac);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_UNKNOWN_FUNCTION, result.error);
+	CuAssertStrEquals(tc, "main calls unknown function g", result.error_msg);
+	mcc_jit_deinit(&jit);
+	mcc_tac_program_deinit(&tac);
+
+	// SSA form is rejected.
+	lower(tc, &tac, "int main() { int x; x = 1; if (read_int() > 0) x = 2; return x; }");
+	CuAssertTrue(tc, mcc_ssa_construct(&tac.functions[0]));
+	result = mcc_jit_compile(&jit, &tac);
+	CuAssertIntEquals(tc, MCC_JIT_ERROR_INVALID_PROGRAM, result.error);
+	CuAssertStrEquals(tc, "main is in SSA form", result.error_msg);
+	mcc_jit_deinit(&jit);
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Jit_Arithmetic) \
+	TEST(Jit_UnassignedString) \
+	TEST(Jit_Comparisons) \
+	TEST(Jit_Calls) \
+	TEST(Jit_SiblingCalls) \
+	TEST(Jit_ReturnValue) \
+	TEST(Jit_DivisionByConstant) \
+	TEST(Jit_DivisionMatchesVm) \
+	TEST(Jit_CompileErrors)
+
+#include "main_stub.inc"
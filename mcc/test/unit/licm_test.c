@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/cfg.h"
+#include "mcc/licm.h"
+#include "mcc/loops.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+void Loops_Nest(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int f(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = CONST int 0\n"
+	      "L1:\n"
+	      "	v3 = LT int v2, v1\n"
+	      "	JUMP_IF_NOT L2, v3\n"
+	      "	v4 = CONST int 0\n"
+	      "L3:\n"
+	      "	v5 = LT int v4, v2\n"
+	      "	JUMP_IF_NOT L4, v5\n"
+	      "	v6 = CONST int 1\n"
+	      "	v4 = ADD int v4, v6\n"
+	      "	JUMP L3\n"
+	      "L4:\n"
+	      "	v7 = CONST int 1\n"
+	      "	v2 = ADD int v2, v7\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	RETURN int v2\n");
+	const struct mcc_tac_function *function = &tac.functions[0];
+
+	struct mcc_cfg cfg;
+	CuAssertTrue(tc, mcc_cfg_build(&cfg, function));
+	struct mcc_loops loops;
+	CuAssertTrue(tc, mcc_loops_find(&loops, &cfg));
+	CuAssertIntEquals(tc, 2, (int)loops.loops_count);
+
+	const struct mcc_loop *outer = &loops.loops[0];
+	CuAssertIntEquals(tc, (int)cfg.label_blocks[1], (int)outer->header);
+	CuAssertIntEquals(tc, (int)MCC_CFG_NONE, (int)outer->parent);
+	CuAssertIntEquals(tc, 1, (int)outer->depth);
+	CuAssertIntEquals(tc, 5, (int)outer->blocks_count);
+
+	const struct mcc_loop *inner = &loops.loops[1];
+	CuAssertIntEquals(tc, (int)cfg.label_blocks[3], (int)inner->header);
+	CuAssertIntEquals(tc, 0, (int)inner->parent);
+	CuAssertIntEquals(tc, 2, (int)inner->depth);
+	CuAssertIntEquals(tc, 2, (int)inner->blocks_count);
+	CuAssertIntEquals(tc, (int)inner->header, (int)mcc_loops_blocks(&loops, 1)[0]);
+
+	CuAssertIntEquals(tc, (int)MCC_CFG_NONE, (int)loops.block_loops[0]);
+	CuAssertIntEquals(tc, 0, (int)loops.block_loops[cfg.label_blocks[4]]);
+	CuAssertIntEquals(tc, 1, (int)loops.block_loops[inner->header + 1]);
+	CuAssertIntEquals(tc, (int)MCC_CFG_NONE, (int)loops.block_loops[cfg.label_blocks[2]]);
+	CuAssertTrue(tc, mcc_loops_contains(&loops, 0, inner->header));
+	CuAssertTrue(tc, !mcc_loops_contains(&loops, 1, outer->header));
+
+	// The blocks falling through to the headers are their preheaders.
+	CuAssertIntEquals(tc, 0, (int)mcc_loops_preheader(&loops, &cfg, function, 0));
+	CuAssertIntEquals(tc, (int)inner->header - 1, (int)mcc_loops_preheader(&loops, &cfg, function, 1));
+
+	mcc_loops_deinit(&loops);
+	mcc_cfg_deinit(&cfg);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Loops_Preheaders(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int f(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = CONST int 0\n"
+	      "	v3 = GT int v1, v2\n"
+	      "	JUMP_IF L1, v3\n"
+	      "	v1 = NEG int v1\n"
+	      "L1:\n"
+	      "	v4 = GT int v1, v2\n"
+	      "	JUMP_IF_NOT L2, v4\n"
+	      "	v5 = CONST int 1\n"
+	      "	v1 = SUB int v1, v5\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	RETURN int v1\n"
+	      "\n"
+	      "function int g(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = CONST int 0\n"
+	      "	v3 = GT int v1, v2\n"
+	      "	JUMP_IF L1, v3\n"
+	      "	RETURN int v2\n"
+	      "L2:\n"
+	      "	v4 = CONST int 1\n"
+	      "	v1 = SUB int v1, v4\n"
+	      "L1:\n"
+	      "	v5 = GT int v1, v2\n"
+	      "	JUMP_IF L2, v5\n"
+	      "	RETURN int v1\n"
+	      "\n"
+	      "function int h(0)\n"
+	      "L1:\n"
+	      "	JUMP L1\n");
+
+	size_t inserted = 0;
+	for (size_t f = 0; f < tac.functions_count; f++) {
+		CuAssertTrue(tc, mcc_loops_insert_preheaders(&tac.functions[f], &inserted));
+	}
+	CuAssertIntEquals(tc, 3, (int)inserted);
+
+	// Entered from two blocks, from a conditional jump with the latch falling
+	// through, and from the function's entry.
+	assert_printed(tc,
+	               "function int f(1)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = CONST int 0\n"
+	               "	v3 = GT int v1, v2\n"
+	               "	JUMP_IF L3, v3\n"
+	               "	v1 = NEG int v1\n"
+	               "L3:\n"
+	               "L1:\n"
+	               "	v4 = GT int v1, v2\n"
+	               "	JUMP_IF_NOT L2, v4\n"
+	               "	v5 = CONST int 1\n"
+	               "	v1 = SUB int v1, v5\n"
+	               "	JUMP L1\n"
+	               "L2:\n"
+	               "	RETURN int v1\n",
+	               &tac.functions[0]);
+	assert_printed(tc,
+	               "function int g(1)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = CONST int 0\n"
+	               "	v3 = GT int v1, v2\n"
+	               "	JUMP_IF L3, v3\n"
+	               "	RETURN int v2\n"
+	               "L2:\n"
+	               "	v4 = CONST int 1\n"
+	               "	v1 = SUB int v1, v4\n"
+	               "	JUMP L1\n"
+	               "L3:\n"
+	               "L1:\n"
+	               "	v5 = GT int v1, v2\n"
+	               "	JUMP_IF L2, v5\n"
+	               "	RETURN int v1\n",
+	               &tac.functions[1]);
+	assert_printed(tc,
+	               "function int h(0)\n"
+	               "L2:\n"
+	               "L1:\n"
+	               "	JUMP L1\n",
+	               &tac.functions[2]);
+
+	// Every loop has a preheader now.
+	for (size_t f = 0; f < tac.functions_count; f++) {
+		CuAssertTrue(tc, mcc_loops_insert_preheaders(&tac.functions[f], &inserted));
+	}
+	CuAssertIntEquals(tc, 3, (int)inserted);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+// Divisions by a variable may fail, they are only hoisted from the header.
+// The product is read after the loop, which may be left before computing it.
+void Licm_Conditions(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int f(2)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = PARAM int 1\n"
+	      "	v3 = CONST int 0\n"
+	      "L1:\n"
+	      "	v4 = DIV int v1, v2\n"
+	      "	v5 = LT int v3, v4\n"
+	      "	JUMP_IF_NOT L2, v5\n"
+	      "	v6 = DIV int v2, v1\n"
+	      "	v7 = MUL int v1, v2\n"
+	      "	v8 = ADD int v1, v1\n"
+	      "	v9 = ADD int v3, v8\n"
+	      "	v3 = ADD int v9, v6\n"
+	      "	v11 = CONST int 2\n"
+	      "	v12 = DIV int v3, v11\n"
+	      "	v13 = NEG int v11\n"
+	      "	v14 = CONST int 1\n"
+	      "	v3 = ADD int v12, v14\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	v10 = ADD int v3, v7\n"
+	      "	RETURN int v10\n");
+
+	struct mcc_licm_stats stats = {0};
+	CuAssertTrue(tc, mcc_licm_function(&tac.functions[0], NULL, NULL, &stats));
+	CuAssertIntEquals(tc, 0, (int)stats.preheaders);
+	CuAssertIntEquals(tc, 4, (int)stats.hoisted);
+
+	// Constants only leave the loop along with an instruction reading them.
+	mcc_tac_function_compact(&tac.functions[0]);
+	assert_printed(tc,
+	               "function int f(2)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = PARAM int 1\n"
+	               "	v3 = CONST int 0\n"
+	               "	v4 = DIV int v1, v2\n"
+	               "	v8 = ADD int v1, v1\n"
+	               "	v11 = CONST int 2\n"
+	               "	v13 = NEG int v11\n"
+	               "L1:\n"
+	               "	v5 = LT int v3, v4\n"
+	               "	JUMP_IF_NOT L2, v5\n"
+	               "	v6 = DIV int v2, v1\n"
+	               "	v7 = MUL int v1, v2\n"
+	               "	v9 = ADD int v3, v8\n"
+	               "	v3 = ADD int v9, v6\n"
+	               "	v12 = DIV int v3, v11\n"
+	               "	v14 = CONST int 1\n"
+	               "	v3 = ADD int v12, v14\n"
+	               "	JUMP L1\n"
+	               "L2:\n"
+	               "	v10 = ADD int v3, v7\n"
+	               "	RETURN int v10\n",
+	               &tac.functions[0]);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Licm_Lowered(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int square(int x) { return x * x; }\n"
+	      "int main() {\n"
+	      "  int n; int i; int j; int s; int[10] a;\n"
+	      "  n = 3; i = 0; s = 0;\n"
+	      "  while (i < square(n)) {\n"
+	      "    j = 0;\n"
+	      "    while (j < 10) {\n"
+	      "      a[j] = n * 3 + i;\n"
+	      "      s = s + a[j] + n * 2;\n"
+	      "      print_int(j / n);\n"
+	      "      j = j + 1;\n"
+	      "    }\n"
+	      "    i = i + 1;\n"
+	      "  }\n"
+	      "  print_nl(); print_int(s);\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	char *expected = run(tc, &tac);
+
+	struct mcc_licm_stats stats = {0};
+	CuAssertTrue(tc, mcc_licm_program(&tac, &stats));
+
+	// The call of square, n * 3 and n * 2 out of both loops, n * 3 + i out
+	// of the inner one. The constants read count along.
+	CuAssertTrue(tc, stats.hoisted >= 6);
+
+	struct mcc_tac_function *function = &tac.functions[1];
+	mcc_tac_function_compact(function);
+	char *printed = print(tc, function);
+	char *call = strstr(printed, "CALL int square(");
+	char *loop = strstr(printed, "L1:\n");
+	CuAssertTrue(tc, call && loop && call < loop);
+	free(printed);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(expected);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Loops_Nest) \
+	TEST(Loops_Preheaders) \
+	TEST(Licm_Conditions) \
+	TEST(Licm_Lowered)
+
+#include "main_stub.inc"
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/jit.h"
+#include "mcc/memoize.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+static bool is_memoized(const struct mcc_tac_program *tac, const char *name)
+{
+	const struct mcc_tac_function *function = mcc_tac_program_find_function(tac, name);
+	for (size_t i = 0; function && i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_CALL &&
+		    strcmp(function->strings[instruction->arg1], MCC_MEMOIZE_FIND) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Runs `main` in the VM and the JIT, asserting both print `expected`.
+static void assert_output(CuTest *tc, const struct mcc_tac_program *tac, const char *expected)
+{
+	char *output = NULL;
+	size_t output_size = 0;
+
+	struct mcc_vm vm;
+	struct mcc_vm_result vm_result = mcc_vm_compile(&vm, tac);
+	CuAssertStrEquals(tc, "", vm_result.error_msg);
+	struct mcc_vm_options vm_options = {.out = open_memstream(&output, &output_size)};
+	CuAssertPtrNotNull(tc, vm_options.out);
+	vm_result = mcc_vm_call(&vm, "main", NULL, 0, &vm_options);
+	fclose(vm_options.out);
+	mcc_vm_deinit(&vm);
+	CuAssertStrEquals(tc, "", vm_result.error_msg);
+	CuAssertStrEquals(tc, expected, output);
+	free(output);
+
+	struct mcc_jit jit;
+	struct mcc_jit_result jit_result = mcc_jit_compile(&jit, tac);
+	CuAssertStrEquals(tc, "", jit_result.error_msg);
+	struct mcc_jit_options jit_options = {.out = open_memstream(&output, &output_size)};
+	CuAssertPtrNotNull(tc, jit_options.out);
+	jit_result = mcc_jit_call(&jit, "main", NULL, 0, &jit_options);
+	fclose(jit_options.out);
+	mcc_jit_deinit(&jit);
+	CuAssertStrEquals(tc, "", jit_result.error_msg);
+	CuAssertStrEquals(tc, expected, output);
+	free(output);
+}
+
+void Memoize_Qualification(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+	      "int binomial(int n, int k) {\n"
+	      "  if (k == 0 || k == n) return 1;\n"
+	      "  return binomial(n - 1, k - 1) + binomial(n - 1, k);\n"
+	      "}\n"
+	      "float decay(float x, bool half) {\n"
+	      "  if (x < 1.0) return x;\n"
+	      "  if (half) return decay(x / 2.0, false) + decay(x / 2.0, true);\n"
+	      "  return decay(x - 1.0, true);\n"
+	      "}\n"
+	      "int factorial(int n) { if (n < 2) return 1; return n * factorial(n - 1); }\n"
+	      "int noisy(int n) { print_int(n); if (n < 2) return n; return noisy(n - 1) + noisy(n - 2); }\n"
+	      "int three(int a, int b, int c) { if (a < 1) return b + c; "
+	      "return three(a - 1, b, c) + three(a - 2, c, b); }\n"
+	      "string label(int n) { if (n < 1) return \"x\"; label(n - 1); return label(n - 2); }\n"
+	      "int main() { return 0; }\n");
+
+	size_t memoized = 0;
+	CuAssertTrue(tc, mcc_memoize_program(&tac, &memoized));
+	CuAssertIntEquals(tc, 3, (int)memoized);
+
+	CuAssertTrue(tc, is_memoized(&tac, "fib"));
+	CuAssertTrue(tc, is_memoized(&tac, "binomial"));
+	CuAssertTrue(tc, is_memoized(&tac, "decay"));
+	CuAssertTrue(tc, !is_memoized(&tac, "factorial"));
+	CuAssertTrue(tc, !is_memoized(&tac, "noisy"));
+	CuAssertTrue(tc, !is_memoized(&tac, "three"));
+	CuAssertTrue(tc, !is_memoized(&tac, "label"));
+	CuAssertTrue(tc, !is_memoized(&tac, "main"));
+
+	// Memoised functions are not memoised again.
+	memoized = 0;
+	CuAssertTrue(tc, mcc_memoize_program(&tac, &memoized));
+	CuAssertIntEquals(tc, 0, (int)memoized);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Memoize_Results(CuTest *tc)
+{
+	static const char input[] =
+	    "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+	    "int binomial(int n, int k) {\n"
+	    "  if (k == 0 || k == n) return 1;\n"
+	    "  return binomial(n - 1, k - 1) + binomial(n - 1, k);\n"
+	    "}\n"
+	    "float decay(float x, bool half) {\n"
+	    "  if (x < 1.0) return x;\n"
+	    "  if (half) return decay(x / 2.0, false) + decay(x / 2.0, true);\n"
+	    "  return decay(x - 1.0, true);\n"
+	    "}\n"
+	    "int main() {\n"
+	    "  int n; n = 0;\n"
+	    "  while (n < 25) { print_int(fib(n)); print(\" \"); n = n + 5; }\n"
+	    "  print_int(binomial(20, 10)); print(\" \"); print_int(binomial(6, 3)); print(\" \");\n"
+	    "  print_float(decay(9.0, true)); print(\" \"); print_float(decay(9.0, false));\n"
+	    "  return 0;\n"
+	    "}\n";
+	static const char expected[] = "0 5 55 610 6765 184756 20 5.00 4.00";
+
+	struct mcc_tac_program tac;
+	lower(tc, &tac, input);
+	assert_output(tc, &tac, expected);
+
+	size_t memoized = 0;
+	CuAssertTrue(tc, mcc_memoize_program(&tac, &memoized));
+	CuAssertIntEquals(tc, 3, (int)memoized);
+	assert_output(tc, &tac, expected);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Memoize_Qualification) \
+	TEST(Memoize_Results)
+
+#include "main_stub.inc"
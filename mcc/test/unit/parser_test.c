@@ -181,12 +181,84 @@ void Precedence_1(CuTest *tc)
 	mcc_ast_delete_expression(expr);
 }
 
+void Program_DanglingElse(CuTest *tc)
+{
+	const char input[] = "void f() { if (a) if (b) g(); else h(); }";
+	struct mcc_parser_result result = mcc_parse_program_string(input);
+
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, result.error);
+
+	struct mcc_ast_program *program = result.program;
+	CuAssertIntEquals(tc, 1, program->functions_count);
+
+	struct mcc_ast_statement *body = program->functions[0]->body;
+	CuAssertIntEquals(tc, 1, body->statements_count);
+
+	struct mcc_ast_statement *outer = body->statements[0];
+	CuAssertIntEquals(tc, MCC_AST_STATEMENT_TYPE_IF, outer->type);
+	CuAssertPtrEquals(tc, NULL, outer->if_on_false);
+
+	struct mcc_ast_statement *inner = outer->if_on_true;
+	CuAssertIntEquals(tc, MCC_AST_STATEMENT_TYPE_IF, inner->type);
+	CuAssertPtrNotNull(tc, inner->if_on_false);
+
+	mcc_ast_delete_program(program);
+}
+
+void Program_Function(CuTest *tc)
+{
+	const char input[] = "int f(int n, float[4] a) { int x; x = a[n] * -2; return x; }";
+	struct mcc_parser_result result = mcc_parse_program_string(input);
+
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, result.error);
+
+	struct mcc_ast_program *program = result.program;
+	CuAssertIntEquals(tc, 1, program->functions_count);
+
+	struct mcc_ast_function *function = program->functions[0];
+	CuAssertIntEquals(tc, MCC_AST_DATA_TYPE_INT, function->return_type);
+	CuAssertStrEquals(tc, "f", function->identifier->name);
+	CuAssertIntEquals(tc, 2, function->parameters_count);
+	CuAssertIntEquals(tc, MCC_AST_DATA_TYPE_FLOAT, function->parameters[1]->data_type);
+	CuAssertTrue(tc, function->parameters[1]->is_array);
+	CuAssertIntEquals(tc, 4, function->parameters[1]->array_size);
+
+	struct mcc_ast_statement *body = function->body;
+	CuAssertIntEquals(tc, 3, body->statements_count);
+	CuAssertIntEquals(tc, MCC_AST_STATEMENT_TYPE_DECLARATION, body->statements[0]->type);
+	CuAssertIntEquals(tc, MCC_AST_STATEMENT_TYPE_ASSIGNMENT, body->statements[1]->type);
+	CuAssertIntEquals(tc, MCC_AST_STATEMENT_TYPE_RETURN, body->statements[2]->type);
+
+	struct mcc_ast_expression *rhs = body->statements[1]->assignment->rhs;
+	CuAssertIntEquals(tc, MCC_AST_BINARY_OP_MUL, rhs->op);
+	CuAssertIntEquals(tc, MCC_AST_EXPRESSION_TYPE_ARRAY_ELEMENT, rhs->lhs->type);
+	CuAssertIntEquals(tc, MCC_AST_EXPRESSION_TYPE_UNARY_OP, rhs->rhs->type);
+
+	// identifiers are interned
+	CuAssertPtrEquals(tc, (void *)body->statements[0]->declaration->identifier->name,
+	                  (void *)body->statements[2]->return_value->identifier->name);
+
+	mcc_ast_delete_program(program);
+}
+
+void Program_MissingSemicolon(CuTest *tc)
+{
+	const char input[] = "int main() { return 0 }";
+	struct mcc_parser_result result = mcc_parse_program_string(input);
+
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_PARSE_ERROR, result.error);
+	CuAssertPtrEquals(tc, NULL, result.program);
+}
+
 #define TESTS \
 	TEST(BinaryOp_1) \
 	TEST(NestedExpression_1) \
 	TEST(NestedExpression_2) \
 	TEST(MissingClosingParenthesis_1) \
 	TEST(SourceLocation_SingleLineColumn) \
-	TEST(Precedence_1)
+	TEST(Precedence_1) \
+	TEST(Program_DanglingElse) \
+	TEST(Program_Function) \
+	TEST(Program_MissingSemicolon)
 
 #include "main_stub.inc"
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/purity.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+// Asserts whether the IR of function `name` contains `text`.
+static void assert_contains(CuTest *tc, const struct mcc_tac_program *tac, const char *name, const char *text, bool yes)
+{
+	const struct mcc_tac_function *function = mcc_tac_program_find_function(tac, name);
+	CuAssertPtrNotNull(tc, function);
+	char *output = print(tc, function);
+	if ((strstr(output, text) != NULL) != yes) {
+		fprintf(stderr, "%s", output);
+	}
+	CuAssertTrue(tc, (strstr(output, text) != NULL) == yes);
+	free(output);
+}
+
+void Purity_Analysis(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int square(int x) { return x * x; }\n"
+	      "void hello() { print(\"hi\"); }\n"
+	      "int noisy(int x) { hello(); return x; }\n"
+	      "void set(int[2] a) { a[0] = 1; }\n"
+	      "int local() { int[2] a; set(a); return a[0]; }\n"
+	      "int forward(int[2] a) { set(a); return 0; }\n"
+	      "int sum(int[2] a) { return a[0] + a[1]; }\n"
+	      "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+	      "int countdown(int n) { if (n == 0) { print_nl(); return 0; } return countdown(n - 1); }\n"
+	      "int main() { return 0; }\n");
+
+	bool pure[10];
+	CuAssertIntEquals(tc, 10, (int)tac.functions_count);
+	CuAssertTrue(tc, mcc_purity_analyse(&tac, pure));
+
+	CuAssertTrue(tc, pure[0]);
+	CuAssertTrue(tc, !pure[1]);
+	CuAssertTrue(tc, !pure[2]);
+	CuAssertTrue(tc, !pure[3]);
+	CuAssertTrue(tc, pure[4]);
+	CuAssertTrue(tc, !pure[5]);
+	CuAssertTrue(tc, pure[6]);
+	CuAssertTrue(tc, pure[7]);
+	CuAssertTrue(tc, !pure[8]);
+	CuAssertTrue(tc, pure[9]);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Purity_Fold(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "float scale(float x, int n) { float r; r = x; while (n > 1) { r = r + x; n = n - 1; } return r; }\n"
+	      "int square(int x) { return x * x; }\n"
+	      "string pick(bool b) { if (b) return \"yes\"; return \"no\"; }\n"
+	      "void nothing(int x) { x = x + 1; }\n"
+	      "int main() {\n"
+	      "  print_float(scale(1.5, 3)); print_nl();\n"
+	      "  print_int(square(square(3))); print_nl();\n"
+	      "  print(pick(true)); nothing(1);\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	size_t folded = 0;
+	CuAssertTrue(tc, mcc_purity_fold_calls(&tac, 0, &folded));
+	CuAssertIntEquals(tc, 5, (int)folded);
+
+	assert_contains(tc, &tac, "main", "CONST float 4.5", true);
+	assert_contains(tc, &tac, "main", "CONST int 81", true);
+	assert_contains(tc, &tac, "main", "CONST string \"yes\"", true);
+	assert_contains(tc, &tac, "main", "scale", false);
+	assert_contains(tc, &tac, "main", "square", false);
+	assert_contains(tc, &tac, "main", "pick", false);
+	assert_contains(tc, &tac, "main", "nothing", false);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, "4.50\n81\nyes", output);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Purity_FoldLimits(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int spin(int n) { while (n > 0) n = n + 0; return n; }\n"
+	      "int divide(int n) { return 10 / n; }\n"
+	      "int square(int x) { return x * x; }\n"
+	      "int noisy(int x) { print_int(x); return x; }\n"
+	      "int main() {\n"
+	      "  int x; x = 2;\n"
+	      "  if (x > 1) print_int(square(x));\n"
+	      "  print_int(divide(0) + spin(1) + square(read_int()) + noisy(3));\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	size_t folded = 0;
+	CuAssertTrue(tc, mcc_purity_fold_calls(&tac, 1000, &folded));
+	CuAssertIntEquals(tc, 0, (int)folded);
+
+	assert_contains(tc, &tac, "main", "CALL int square(", true);
+	assert_contains(tc, &tac, "main", "CALL int divide(", true);
+	assert_contains(tc, &tac, "main", "CALL int spin(", true);
+	assert_contains(tc, &tac, "main", "CALL int noisy(", true);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Purity_Analysis) \
+	TEST(Purity_Fold) \
+	TEST(Purity_FoldLimits)
+
+#include "main_stub.inc"
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/sccp.h"
+#include "mcc/ssa.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+static const char loop_input[] = "function int f(1)\n"
+                                 "	v1 = PARAM int 0\n"
+                                 "	v2 = CONST int 1\n"
+                                 "	v3 = CONST int 0\n"
+                                 "	v4 = CONST bool false\n"
+                                 "L1:\n"
+                                 "	v5 = LT int v3, v1\n"
+                                 "	JUMP_IF_NOT L2, v5\n"
+                                 "	v6 = CONST int 1\n"
+                                 "	v7 = NE int v2, v6\n"
+                                 "	JUMP_IF_NOT L3, v7\n"
+                                 "	v2 = CONST int 2\n"
+                                 "L3:\n"
+                                 "	JUMP_IF L4, v4\n"
+                                 "	v8 = ADD int v3, v6\n"
+                                 "	v3 = ASSIGN int v8\n"
+                                 "	JUMP L1\n"
+                                 "L4:\n"
+                                 "	v2 = CONST int 3\n"
+                                 "L2:\n"
+                                 "	v9 = MUL int v2, v2\n"
+                                 "	RETURN int v9\n";
+
+// v2 stays 1 around the loop since the branch assigning 2 never executes.
+void Sccp_Loop(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac, loop_input);
+
+	struct mcc_sccp_stats stats = {0};
+	CuAssertTrue(tc, mcc_sccp_function(&tac.functions[0], &stats));
+	CuAssertIntEquals(tc, 2, (int)stats.constants);
+	CuAssertIntEquals(tc, 2, (int)stats.branches);
+	CuAssertIntEquals(tc, 2, (int)stats.unreachable);
+
+	mcc_tac_function_compact(&tac.functions[0]);
+	assert_printed(tc,
+	               "function int f(1)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = CONST int 1\n"
+	               "	v3 = CONST int 0\n"
+	               "	v4 = CONST bool false\n"
+	               "L1:\n"
+	               "	v5 = LT int v3, v1\n"
+	               "	JUMP_IF_NOT L2, v5\n"
+	               "	v6 = CONST int 1\n"
+	               "	v7 = CONST bool false\n"
+	               "L3:\n"
+	               "	v8 = ADD int v3, v6\n"
+	               "	v3 = ASSIGN int v8\n"
+	               "	JUMP L1\n"
+	               "L2:\n"
+	               "	v9 = CONST int 1\n"
+	               "	RETURN int v9\n",
+	               &tac.functions[0]);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Sccp_Ssa(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac, loop_input);
+	struct mcc_tac_function *function = &tac.functions[0];
+	CuAssertTrue(tc, mcc_ssa_construct(function));
+
+	struct mcc_sccp_stats stats = {0};
+	CuAssertTrue(tc, mcc_sccp_function(function, &stats));
+	CuAssertIntEquals(tc, 2, (int)stats.branches);
+	CuAssertIntEquals(tc, 2, (int)stats.unreachable);
+
+	// Only the phi of the loop counter is left, the result is constant.
+	mcc_tac_function_compact(function);
+	size_t phis = 0;
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		const struct mcc_tac_instruction *instruction = &function->instructions[i];
+		if (instruction->op == MCC_TAC_OP_PHI) {
+			CuAssertIntEquals(tc, 2, (int)instruction->arg2);
+			phis++;
+		}
+		if (instruction->op == MCC_TAC_OP_MUL) {
+			CuFail(tc, "multiplication not folded");
+		}
+	}
+	CuAssertIntEquals(tc, 1, (int)phis);
+	CuAssertTrue(tc, mcc_ssa_destruct(function));
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Sccp_Folding(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function bool f(0)\n"
+	      "	v1 = CONST int 2147483647\n"
+	      "	v2 = CONST int 1\n"
+	      "	v3 = ADD int v1, v2\n"
+	      "	v4 = CONST int 0\n"
+	      "	v5 = DIV int v1, v4\n"
+	      "	v6 = CONST float 0.1\n"
+	      "	v7 = MUL float v6, v6\n"
+	      "	v8 = LT int v3, v4\n"
+	      "	v9 = CALL bool g()\n"
+	      "	v10 = AND bool v9, v8\n"
+	      "	v11 = NOT bool v8\n"
+	      "	v12 = OR bool v8, v9\n"
+	      "	v13 = AND bool v9, v11\n"
+	      "	RETURN bool v13\n"
+	      "\n"
+	      "function bool g(0)\n"
+	      "	v1 = CONST bool true\n"
+	      "	RETURN bool v1\n");
+
+	struct mcc_sccp_stats stats = {0};
+	CuAssertTrue(tc, mcc_sccp_function(&tac.functions[0], &stats));
+	CuAssertIntEquals(tc, 0, (int)stats.branches);
+	CuAssertIntEquals(tc, 6, (int)stats.constants);
+
+	// Ints wrap around, division by zero and calls stay, floats are single
+	// precision.
+	char *output = print(tc, &tac.functions[0]);
+	CuAssertPtrNotNull(tc, strstr(output, "v3 = CONST int -2147483648\n"));
+	CuAssertPtrNotNull(tc, strstr(output, "v5 = DIV int v1, v4\n"));
+	CuAssertPtrNotNull(tc, strstr(output, "v8 = CONST bool true\n"));
+	CuAssertPtrNotNull(tc, strstr(output, "v9 = CALL bool g()\n"));
+	CuAssertPtrNotNull(tc, strstr(output, "v10 = AND bool v9, v8\n"));
+	CuAssertPtrNotNull(tc, strstr(output, "v12 = CONST bool true\n"));
+	CuAssertPtrNotNull(tc, strstr(output, "v13 = CONST bool false\n"));
+	free(output);
+
+	const struct mcc_tac_instruction *product = &tac.functions[0].instructions[6];
+	CuAssertIntEquals(tc, MCC_TAC_OP_CONST, product->op);
+	CuAssertTrue(tc, mcc_tac_bits_float(tac.functions[0].constants[product->arg1]) == (double)(0.1f * 0.1f));
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Sccp_Configuration(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int main() {\n"
+	      "  int mode; bool verbose; float scale; int i; int total;\n"
+	      "  mode = 2; verbose = false; scale = 1.5; total = 0; i = 0;\n"
+	      "  while (i < 4) {\n"
+	      "    if (mode == 1) total = total + i;\n"
+	      "    else if (mode == 2) total = total + 2 * i;\n"
+	      "    else total = 0;\n"
+	      "    if (verbose) { print(\"step \"); print_int(i); print_nl(); }\n"
+	      "    i = i + 1;\n"
+	      "  }\n"
+	      "  if (scale > 1.0 && !verbose) print_int(total);\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	char *expected = run(tc, &tac);
+	CuAssertStrEquals(tc, "12", expected);
+
+	struct mcc_sccp_stats stats = {0};
+	CuAssertTrue(tc, mcc_sccp_function(&tac.functions[0], &stats));
+	CuAssertIntEquals(tc, 4, (int)stats.branches);
+	CuAssertTrue(tc, stats.unreachable >= 3);
+
+	char *printed = print(tc, &tac.functions[0]);
+	CuAssertTrue(tc, !strstr(printed, "step"));
+	free(printed);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(expected);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Sccp_Loop) \
+	TEST(Sccp_Ssa) \
+	TEST(Sccp_Folding) \
+	TEST(Sccp_Configuration)
+
+#include "main_stub.inc"
@@ -0,0 +1,217 @@
+#include <CuTest.h>
+
+#include "mcc/parser.h"
+#include "mcc/semantic.h"
+
+// Parses and checks `input`, the program is returned via `program`.
+static struct mcc_semantic_result check(CuTest *tc,
+                                        const char *input,
+                                        bool collect_all,
+                                        struct mcc_ast_program **program)
+{
+	struct mcc_parser_result parser_result = mcc_parse_program_string(input);
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, parser_result.error);
+	*program = parser_result.program;
+
+	struct mcc_semantic_options options = {.collect_all = collect_all};
+	return mcc_semantic_check(*program, &options);
+}
+
+void Semantic_Annotations(CuTest *tc)
+{
+	const char input[] = "int main() { float[2] a; a[1] = 1.5; print_float(a[1] * 2.0); return 0; }";
+
+	struct mcc_ast_program *program;
+	struct mcc_semantic_result result = check(tc, input, false, &program);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_NONE, result.error);
+
+	struct mcc_ast_statement *body = program->functions[0]->body;
+	struct mcc_ast_declaration *a = body->statements[0]->declaration;
+
+	// a[1] = 1.5;
+	CuAssertPtrEquals(tc, a, body->statements[1]->assignment->identifier->declaration);
+
+	// print_float(a[1] * 2.0);
+	struct mcc_ast_expression *call = body->statements[2]->expression;
+	CuAssertPtrNotNull(tc, call->callee->function);
+	CuAssertPtrEquals(tc, NULL, call->callee->function->body);
+	CuAssertPtrEquals(tc, (void *)mcc_type_scalar(MCC_TYPE_KIND_VOID), (void *)call->data_type);
+
+	struct mcc_ast_expression *product = call->arguments[0];
+	CuAssertPtrEquals(tc, (void *)mcc_type_scalar(MCC_TYPE_KIND_FLOAT), (void *)product->data_type);
+	CuAssertPtrEquals(tc, a, product->lhs->array->declaration);
+
+	// Array types are canonical.
+	CuAssertPtrEquals(tc, (void *)a->resolved_type, (void *)product->lhs->array->declaration->resolved_type);
+	CuAssertPtrEquals(tc, (void *)mcc_type_scalar(MCC_TYPE_KIND_FLOAT), (void *)a->resolved_type->element);
+	CuAssertIntEquals(tc, 8, a->resolved_type->size);
+
+	mcc_semantic_result_deinit(&result);
+	mcc_ast_delete_program(program);
+}
+
+void Semantic_Shadowing(CuTest *tc)
+{
+	const char input[] = "int main() { int x; { x = 2; bool x; x = true; } x = 1; return x; }";
+
+	struct mcc_ast_program *program;
+	struct mcc_semantic_result result = check(tc, input, false, &program);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_NONE, result.error);
+
+	struct mcc_ast_statement *body = program->functions[0]->body;
+	struct mcc_ast_declaration *outer = body->statements[0]->declaration;
+	struct mcc_ast_statement *block = body->statements[1];
+	struct mcc_ast_declaration *inner = block->statements[1]->declaration;
+
+	CuAssertPtrEquals(tc, outer, block->statements[0]->assignment->identifier->declaration);
+	CuAssertPtrEquals(tc, inner, block->statements[2]->assignment->identifier->declaration);
+	CuAssertPtrEquals(tc, outer, body->statements[2]->assignment->identifier->declaration);
+
+	mcc_semantic_result_deinit(&result);
+	mcc_ast_delete_program(program);
+}
+
+void Semantic_ArraySizeIsPartOfType(CuTest *tc)
+{
+	const char input[] = "void f(int[10] a) {} int main() { int[11] a; f(a); return 0; }";
+
+	struct mcc_ast_program *program;
+	struct mcc_semantic_result result = check(tc, input, false, &program);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_CHECK_FAILED, result.error);
+	CuAssertIntEquals(tc, 1, result.diagnostics_count);
+	CuAssertIntEquals(tc, 48, result.diagnostics[0].sloc.column);
+	CuAssertStrEquals(tc, "passing 'int[11]' to parameter of incompatible type 'int[10]'",
+	                  result.diagnostics[0].message);
+
+	mcc_semantic_result_deinit(&result);
+	mcc_ast_delete_program(program);
+}
+
+void Semantic_StopOnFirstError(CuTest *tc)
+{
+	const char input[] = "int main() { x = 1; y = 2; return 0; }";
+
+	struct mcc_ast_program *program;
+	struct mcc_semantic_result result = check(tc, input, false, &program);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_CHECK_FAILED, result.error);
+	CuAssertIntEquals(tc, 1, result.diagnostics_count);
+	CuAssertStrEquals(tc, "use of undeclared identifier 'x'", result.diagnostics[0].message);
+
+	mcc_semantic_result_deinit(&result);
+	mcc_ast_delete_program(program);
+}
+
+void Semantic_StopOnGlobalError(CuTest *tc)
+{
+	// Functions after a redefinition are still declared, the call of g is
+	// not reported before the redefinition.
+	const char input[] = "int main() { return g(); }\n"
+	                     "void f() {}\n"
+	                     "void f() {}\n"
+	                     "int g() { return 1; }";
+
+	for (size_t threads = 1; threads <= 2; threads++) {
+		struct mcc_parser_result parser_result = mcc_parse_program_string(input);
+		CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, parser_result.error);
+
+		struct mcc_semantic_options options = {.threads = threads};
+		struct mcc_semantic_result result = mcc_semantic_check(parser_result.program, &options);
+		CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_CHECK_FAILED, result.error);
+		CuAssertIntEquals(tc, 1, result.diagnostics_count);
+		CuAssertStrEquals(tc, "redefinition of function 'f'", result.diagnostics[0].message);
+		CuAssertIntEquals(tc, 3, result.diagnostics[0].sloc.line);
+		CuAssertIntEquals(tc, 6, result.diagnostics[0].sloc.column);
+
+		mcc_semantic_result_deinit(&result);
+		mcc_ast_delete_program(parser_result.program);
+	}
+}
+
+void Semantic_CollectAll(CuTest *tc)
+{
+	const char input[] = "int f() { if (1) return 1; }\n"
+	                     "int main() { x = 1 + true; return f(1); }";
+
+	struct mcc_ast_program *program;
+	struct mcc_semantic_result result = check(tc, input, true, &program);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_CHECK_FAILED, result.error);
+	CuAssertIntEquals(tc, 5, result.diagnostics_count);
+
+	CuAssertStrEquals(tc, "non-void function 'f' does not return a value on all paths",
+	                  result.diagnostics[0].message);
+	CuAssertStrEquals(tc, "condition of type 'int', expected 'bool'", result.diagnostics[1].message);
+	CuAssertStrEquals(tc, "use of undeclared identifier 'x'", result.diagnostics[2].message);
+	CuAssertStrEquals(tc, "invalid operands to binary '+' (have 'int' and 'bool')", result.diagnostics[3].message);
+	CuAssertStrEquals(tc, "too many arguments to function 'f', expected 0, have 1", result.diagnostics[4].message);
+
+	mcc_semantic_result_deinit(&result);
+	mcc_ast_delete_program(program);
+}
+
+void Semantic_Main(CuTest *tc)
+{
+	struct mcc_ast_program *program;
+	struct mcc_semantic_result result = check(tc, "", false, &program);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_CHECK_FAILED, result.error);
+	CuAssertStrEquals(tc, "missing 'main' function", result.diagnostics[0].message);
+	mcc_semantic_result_deinit(&result);
+	mcc_ast_delete_program(program);
+
+	result = check(tc, "void main() {}", false, &program);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_CHECK_FAILED, result.error);
+	CuAssertStrEquals(tc, "'main' must return 'int' and take no parameters", result.diagnostics[0].message);
+	mcc_semantic_result_deinit(&result);
+	mcc_ast_delete_program(program);
+}
+
+void Semantic_Threads(CuTest *tc)
+{
+	const char input[] = "int f(int[4] a) { return a[0] + x; }\n"
+	                     "float g() { int[8] c; return c[1]; }\n"
+	                     "bool h(float x) { return x; }\n"
+	                     "void f() {}\n"
+	                     "int main() { int[4] a; return f(a) + y; }";
+
+	for (int collect_all = 0; collect_all <= 1; collect_all++) {
+		struct mcc_parser_result sequential_parse = mcc_parse_program_string(input);
+		struct mcc_parser_result parallel_parse = mcc_parse_program_string(input);
+		CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, sequential_parse.error);
+		CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, parallel_parse.error);
+
+		struct mcc_semantic_options options = {.collect_all = collect_all, .threads = 1};
+		struct mcc_semantic_result sequential = mcc_semantic_check(sequential_parse.program, &options);
+		options.threads = 4;
+		struct mcc_semantic_result parallel = mcc_semantic_check(parallel_parse.program, &options);
+
+		CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_CHECK_FAILED, sequential.error);
+		CuAssertIntEquals(tc, sequential.error, parallel.error);
+		CuAssertIntEquals(tc, collect_all ? 5 : 1, sequential.diagnostics_count);
+		CuAssertIntEquals(tc, sequential.diagnostics_count, parallel.diagnostics_count);
+		for (size_t i = 0; i < sequential.diagnostics_count; i++) {
+			CuAssertIntEquals(tc, sequential.diagnostics[i].sloc.line, parallel.diagnostics[i].sloc.line);
+			CuAssertIntEquals(tc, sequential.diagnostics[i].sloc.column,
+			                  parallel.diagnostics[i].sloc.column);
+			CuAssertStrEquals(tc, sequential.diagnostics[i].message, parallel.diagnostics[i].message);
+		}
+
+		// The first error in source order is reported.
+		CuAssertStrEquals(tc, "use of undeclared identifier 'x'", sequential.diagnostics[0].message);
+
+		mcc_semantic_result_deinit(&sequential);
+		mcc_semantic_result_deinit(&parallel);
+		mcc_ast_delete_program(sequential_parse.program);
+		mcc_ast_delete_program(parallel_parse.program);
+	}
+}
+
+#define TESTS \
+	TEST(Semantic_Annotations) \
+	TEST(Semantic_Shadowing) \
+	TEST(Semantic_ArraySizeIsPartOfType) \
+	TEST(Semantic_StopOnFirstError) \
+	TEST(Semantic_StopOnGlobalError) \
+	TEST(Semantic_CollectAll) \
+	TEST(Semantic_Main) \
+	TEST(Semantic_Threads)
+
+#include "main_stub.inc"
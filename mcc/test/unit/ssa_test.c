@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <CuTest.h>
+
+#include "mcc/cfg.h"
+#include "mcc/ssa.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+static uint32_t variable(struct mcc_tac_function *function, enum mcc_tac_type type)
+{
+	return mcc_tac_function_new_variable(function, type).identifier;
+}
+
+static void append(CuTest *tc,
+                   struct mcc_tac_function *function,
+                   enum mcc_tac_op op,
+                   enum mcc_tac_type type,
+                   uint32_t result,
+                   uint32_t arg1,
+                   uint32_t arg2)
+{
+	struct mcc_tac_instruction instruction = {.op = op, .type = type, .result = result, .arg1 = arg1, .arg2 = arg2};
+	CuAssertTrue(tc, mcc_tac_function_append(function, instruction));
+}
+
+static void append_phi(CuTest *tc, struct mcc_tac_function *function, uint32_t result, const uint32_t pairs[4])
+{
+	uint32_t index;
+	CuAssertTrue(tc, mcc_tac_function_add_operands(function, pairs, 4, &index));
+	append(tc, function, MCC_TAC_OP_PHI, MCC_TAC_TYPE_INT, result, index, 2);
+}
+
+static void append_int(CuTest *tc, struct mcc_tac_function *function, uint32_t result, long value)
+{
+	uint32_t index;
+	CuAssertTrue(tc, mcc_tac_function_add_constant(function, mcc_tac_int_bits(value), &index));
+	append(tc, function, MCC_TAC_OP_CONST, MCC_TAC_TYPE_INT, result, index, 0);
+}
+
+void Cfg_Dominators(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, "int main() { int i; i = 0; while (i < 3) { if (i == 1) return i; i = i + 1; } return 0; }");
+
+	struct mcc_cfg cfg;
+	CuAssertTrue(tc, mcc_cfg_build(&cfg, &tac.functions[0]));
+
+	// entry, loop head, if, then, increment, exit
+	CuAssertIntEquals(tc, 6, cfg.blocks_count);
+	CuAssertIntEquals(tc, 6, cfg.order_count);
+	CuAssertIntEquals(tc, 2, cfg.blocks[1].predecessors_count);
+	CuAssertIntEquals(tc, 0, cfg.blocks[3].successors_count);
+
+	CuAssertIntEquals(tc, 0, cfg.blocks[1].idom);
+	CuAssertIntEquals(tc, 1, cfg.blocks[2].idom);
+	CuAssertIntEquals(tc, 2, cfg.blocks[4].idom);
+	CuAssertIntEquals(tc, 1, cfg.blocks[5].idom);
+	CuAssertTrue(tc, mcc_cfg_dominates(&cfg, 1, 4));
+	CuAssertTrue(tc, !mcc_cfg_dominates(&cfg, 4, 1));
+	CuAssertTrue(tc, !mcc_cfg_dominates(&cfg, 3, 4));
+
+	mcc_cfg_deinit(&cfg);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Ssa_Loop(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, "int main() { int i; i = 0; while (i < 10) i = i + 1; return i; }");
+	struct mcc_tac_function *function = &tac.functions[0];
+
+	CuAssertTrue(tc, mcc_ssa_construct(function));
+	assert_printed(tc,
+	               "function int main(0)\n"
+	               "L3:\n"
+	               "\tv2 = CONST int 0\n"
+	               "\tv1 = ASSIGN int v2\n"
+	               "L1:\n"
+	               "\tv7 = PHI int [L3, v1], [L4, v8]\n"
+	               "\tv3 = CONST int 10\n"
+	               "\tv4 = LT int v7, v3\n"
+	               "\tJUMP_IF_NOT L2, v4\n"
+	               "L4:\n"
+	               "\tv5 = CONST int 1\n"
+	               "\tv6 = ADD int v7, v5\n"
+	               "\tv8 = ASSIGN int v6\n"
+	               "\tJUMP L1\n"
+	               "L2:\n"
+	               "\tRETURN int v7\n",
+	               function);
+
+	// Every variable is defined once.
+	struct mcc_ssa_def_use def_use;
+	CuAssertTrue(tc, mcc_ssa_def_use_build(&def_use, function));
+	CuAssertIntEquals(tc, 4, def_use.definitions[7]);
+	CuAssertIntEquals(tc, 3, def_use.uses_begin[8] - def_use.uses_begin[7]);
+	CuAssertIntEquals(tc, 14, def_use.uses[def_use.uses_begin[8] - 1]);
+	mcc_ssa_def_use_deinit(&def_use);
+
+	// All copies are coalesced away.
+	CuAssertTrue(tc, mcc_ssa_destruct(function));
+	assert_printed(tc,
+	               "function int main(0)\n"
+	               "\tv1 = CONST int 0\n"
+	               "L1:\n"
+	               "\tv3 = CONST int 10\n"
+	               "\tv4 = LT int v1, v3\n"
+	               "\tJUMP_IF_NOT L2, v4\n"
+	               "\tv5 = CONST int 1\n"
+	               "\tv1 = ADD int v1, v5\n"
+	               "\tJUMP L1\n"
+	               "L2:\n"
+	               "\tRETURN int v1\n",
+	               function);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Ssa_Undefined(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, "int main() { int x; bool c; c = true; if (c) x = 1; return x; }");
+	struct mcc_tac_function *function = &tac.functions[0];
+
+	CuAssertTrue(tc, mcc_ssa_construct(function));
+	assert_printed(tc,
+	               "function int main(0)\n"
+	               "L2:\n"
+	               "\tv5 = CONST int 0\n"
+	               "\tv3 = CONST bool true\n"
+	               "\tv2 = ASSIGN bool v3\n"
+	               "\tJUMP_IF_NOT L1, v2\n"
+	               "L3:\n"
+	               "\tv4 = CONST int 1\n"
+	               "\tv1 = ASSIGN int v4\n"
+	               "L1:\n"
+	               "\tv6 = PHI int [L2, v5], [L3, v1]\n"
+	               "\tRETURN int v6\n",
+	               function);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Ssa_Swap(CuTest *tc)
+{
+	// A loop swapping two values, the copies on the back edge form a cycle.
+	struct mcc_tac_function function = {.name = "f", .return_type = MCC_TAC_TYPE_INT, .parameters_count = 1};
+	uint32_t a0 = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t b0 = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t flag = variable(&function, MCC_TAC_TYPE_BOOL);
+	uint32_t a = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t b = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t difference = variable(&function, MCC_TAC_TYPE_INT);
+	for (int i = 0; i < 4; i++) {
+		mcc_tac_function_new_label(&function);
+	}
+
+	append(tc, &function, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, 1);
+	append_int(tc, &function, a0, 1);
+	append_int(tc, &function, b0, 2);
+	append(tc, &function, MCC_TAC_OP_PARAM, MCC_TAC_TYPE_BOOL, flag, 0, 0);
+	append(tc, &function, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, 2);
+	append_phi(tc, &function, a, (uint32_t[]){1, a0, 3, b});
+	append_phi(tc, &function, b, (uint32_t[]){1, b0, 3, a});
+	append(tc, &function, MCC_TAC_OP_JUMP_IF_NOT, MCC_TAC_TYPE_BOOL, 0, flag, 4);
+	append(tc, &function, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, 3);
+	append(tc, &function, MCC_TAC_OP_JUMP, MCC_TAC_TYPE_VOID, 0, 0, 2);
+	append(tc, &function, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, 4);
+	append(tc, &function, MCC_TAC_OP_SUB, MCC_TAC_TYPE_INT, difference, a, b);
+	append(tc, &function, MCC_TAC_OP_RETURN, MCC_TAC_TYPE_INT, 0, difference, 0);
+
+	CuAssertTrue(tc, mcc_ssa_destruct(&function));
+	assert_printed(tc,
+	               "function int f(1)\n"
+	               "\tv1 = CONST int 1\n"
+	               "\tv2 = CONST int 2\n"
+	               "\tv3 = PARAM bool 0\n"
+	               "L2:\n"
+	               "\tJUMP_IF_NOT L4, v3\n"
+	               "\tv7 = ASSIGN int v2\n"
+	               "\tv2 = ASSIGN int v1\n"
+	               "\tv1 = ASSIGN int v7\n"
+	               "\tJUMP L2\n"
+	               "L4:\n"
+	               "\tv6 = SUB int v1, v2\n"
+	               "\tRETURN int v6\n",
+	               &function);
+
+	mcc_tac_function_deinit(&function);
+}
+
+void Ssa_CriticalEdge(CuTest *tc)
+{
+	// The phi operand from the conditional jump stays live across the phi,
+	// so a copy has to be placed on the jump's edge.
+	struct mcc_tac_function function = {.name = "f", .return_type = MCC_TAC_TYPE_INT, .parameters_count = 1};
+	uint32_t x = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t zero = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t positive = variable(&function, MCC_TAC_TYPE_BOOL);
+	uint32_t negated = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t absolute = variable(&function, MCC_TAC_TYPE_INT);
+	uint32_t sum = variable(&function, MCC_TAC_TYPE_INT);
+	for (int i = 0; i < 3; i++) {
+		mcc_tac_function_new_label(&function);
+	}
+
+	append(tc, &function, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, 1);
+	append(tc, &function, MCC_TAC_OP_PARAM, MCC_TAC_TYPE_INT, x, 0, 0);
+	append_int(tc, &function, zero, 0);
+	append(tc, &function, MCC_TAC_OP_GE, MCC_TAC_TYPE_INT, positive, x, zero);
+	append(tc, &function, MCC_TAC_OP_JUMP_IF, MCC_TAC_TYPE_BOOL, 0, positive, 2);
+	append(tc, &function, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, 3);
+	append(tc, &function, MCC_TAC_OP_NEG, MCC_TAC_TYPE_INT, negated, x, 0);
+	append(tc, &function, MCC_TAC_OP_LABEL, MCC_TAC_TYPE_VOID, 0, 0, 2);
+	append_phi(tc, &function, absolute, (uint32_t[]){1, x, 3, negated});
+	append(tc, &function, MCC_TAC_OP_ADD, MCC_TAC_TYPE_INT, sum, absolute, x);
+	append(tc, &function, MCC_TAC_OP_RETURN, MCC_TAC_TYPE_INT, 0, sum, 0);
+
+	CuAssertTrue(tc, mcc_ssa_destruct(&function));
+	assert_printed(tc,
+	               "function int f(1)\n"
+	               "\tv1 = PARAM int 0\n"
+	               "\tv2 = CONST int 0\n"
+	               "\tv3 = GE int v1, v2\n"
+	               "\tJUMP_IF L4, v3\n"
+	               "\tv4 = NEG int v1\n"
+	               "L2:\n"
+	               "\tv6 = ADD int v4, v1\n"
+	               "\tRETURN int v6\n"
+	               "L4:\n"
+	               "\tv4 = ASSIGN int v1\n"
+	               "\tJUMP L2\n",
+	               &function);
+
+	mcc_tac_function_deinit(&function);
+}
+
+void Ssa_RoundTrip(CuTest *tc)
+{
+	// Destruction after construction removes all copies introduced by
+	// lowering, which leaves fewer instructions than before.
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int f(int n) { int a; int b; int t; a = 0; b = 1;\n"
+	      "  while (n > 0) { t = a + b; a = b; b = t; n = n - 1; } return a; }\n"
+	      "int main() { int[3] a; int i; i = 0;\n"
+	      "  while (i < 3) { if (i == 1) a[i] = f(i); else a[i] = i; i = i + 1; }"
+	      "  return a[2]; }");
+
+	for (size_t i = 0; i < tac.functions_count; i++) {
+		struct mcc_tac_function *function = &tac.functions[i];
+		size_t count = function->instructions_count;
+
+		CuAssertTrue(tc, mcc_ssa_construct(function));
+		CuAssertTrue(tc, mcc_ssa_destruct(function));
+		CuAssertTrue(tc, function->instructions_count < count);
+
+		for (size_t j = 0; j < function->instructions_count; j++) {
+			CuAssertTrue(tc, function->instructions[j].op != MCC_TAC_OP_PHI);
+		}
+	}
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Cfg_Dominators) \
+	TEST(Ssa_Loop) \
+	TEST(Ssa_Undefined) \
+	TEST(Ssa_Swap) \
+	TEST(Ssa_CriticalEdge) \
+	TEST(Ssa_RoundTrip)
+
+#include "main_stub.inc"
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/pass.h"
+#include "mcc/strength.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+void Strength_Basic(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int f(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = CONST int 0\n"
+	      "	v3 = ASSIGN int v2\n"
+	      "	v4 = ASSIGN int v2\n"
+	      "L1:\n"
+	      "	v5 = LT int v3, v1\n"
+	      "	JUMP_IF_NOT L2, v5\n"
+	      "	v6 = CONST int 4\n"
+	      "	v7 = MUL int v3, v6\n"
+	      "	v4 = ADD int v4, v7\n"
+	      "	v8 = CONST int 1\n"
+	      "	v3 = ADD int v3, v8\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	RETURN int v4\n"
+	      "\n"
+	      "function int g(2)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = PARAM int 1\n"
+	      "	v3 = CONST int 0\n"
+	      "	v4 = ASSIGN int v3\n"
+	      "L1:\n"
+	      "	v5 = GT int v1, v3\n"
+	      "	JUMP_IF_NOT L2, v5\n"
+	      "	v6 = MUL int v2, v1\n"
+	      "	v4 = ADD int v4, v6\n"
+	      "	v7 = GT int v6, v2\n"
+	      "	JUMP_IF_NOT L3, v7\n"
+	      "	v8 = MUL int v1, v2\n"
+	      "	v4 = SUB int v4, v8\n"
+	      "L3:\n"
+	      "	v9 = MUL int v1, v1\n"
+	      "	v4 = ADD int v4, v9\n"
+	      "	v1 = SUB int v1, v2\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	RETURN int v4\n");
+
+	struct mcc_strength_stats stats = {0};
+	for (size_t f = 0; f < tac.functions_count; f++) {
+		CuAssertTrue(tc, mcc_strength_reduce_function(&tac.functions[f], &stats));
+	}
+	CuAssertIntEquals(tc, 2, (int)stats.reduced);
+	CuAssertIntEquals(tc, 2, (int)stats.variables);
+
+	// The step times the factor is folded if both are constants.
+	assert_printed(tc,
+	               "function int f(1)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = CONST int 0\n"
+	               "	v3 = ASSIGN int v2\n"
+	               "	v4 = ASSIGN int v2\n"
+	               "	v10 = CONST int 4\n"
+	               "	v9 = MUL int v3, v10\n"
+	               "	v11 = CONST int 4\n"
+	               "L1:\n"
+	               "	v5 = LT int v3, v1\n"
+	               "	JUMP_IF_NOT L2, v5\n"
+	               "	v6 = CONST int 4\n"
+	               "	v7 = ASSIGN int v9\n"
+	               "	v4 = ADD int v4, v7\n"
+	               "	v8 = CONST int 1\n"
+	               "	v3 = ADD int v3, v8\n"
+	               "	v9 = ADD int v9, v11\n"
+	               "	JUMP L1\n"
+	               "L2:\n"
+	               "	RETURN int v4\n",
+	               &tac.functions[0]);
+
+	// Multiplications by a variable step, skipping the one not running in
+	// every iteration and the square.
+	assert_printed(tc,
+	               "function int g(2)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = PARAM int 1\n"
+	               "	v3 = CONST int 0\n"
+	               "	v4 = ASSIGN int v3\n"
+	               "	v10 = MUL int v1, v2\n"
+	               "	v11 = MUL int v2, v2\n"
+	               "L1:\n"
+	               "	v5 = GT int v1, v3\n"
+	               "	JUMP_IF_NOT L2, v5\n"
+	               "	v6 = ASSIGN int v10\n"
+	               "	v4 = ADD int v4, v6\n"
+	               "	v7 = GT int v6, v2\n"
+	               "	JUMP_IF_NOT L3, v7\n"
+	               "	v8 = MUL int v1, v2\n"
+	               "	v4 = SUB int v4, v8\n"
+	               "L3:\n"
+	               "	v9 = MUL int v1, v1\n"
+	               "	v4 = ADD int v4, v9\n"
+	               "	v1 = SUB int v1, v2\n"
+	               "	v10 = SUB int v10, v11\n"
+	               "	JUMP L1\n"
+	               "L2:\n"
+	               "	RETURN int v4\n",
+	               &tac.functions[1]);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Strength_Lowered(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int main() {\n"
+	      "  int i; int j; int s; int[16] a;\n"
+	      "  i = 0;\n"
+	      "  while (i < 4) {\n"
+	      "    j = 0;\n"
+	      "    while (j < 4) {\n"
+	      "      a[i * 4 + j] = i * j - j * 3;\n"
+	      "      j = j + 1;\n"
+	      "    }\n"
+	      "    i = i + 1;\n"
+	      "  }\n"
+	      "  i = 15; s = 0;\n"
+	      "  while (i >= 0) {\n"
+	      "    s = s + a[i] * 7 + i * 2147483647;\n"
+	      "    if (s > 100) s = s - i * 3;\n"
+	      "    print_int(s); print_nl();\n"
+	      "    i = i - 1;\n"
+	      "  }\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	char *expected = run(tc, &tac);
+
+	// Copies of the incremented counters are coalesced in and out of SSA
+	// form, loop-invariant code motion moves i * 4 out of the inner loop,
+	// where it is reduced as part of the outer one.
+	CuAssertTrue(tc, mcc_pass_run_pipeline("sccp,gvn,licm", &tac));
+	struct mcc_strength_stats stats = {0};
+	CuAssertTrue(tc, mcc_strength_reduce_function(&tac.functions[0], &stats));
+
+	// i * 4, i * j, j * 3, and the overflowing i * 2147483647, but not the
+	// conditional i * 3.
+	CuAssertIntEquals(tc, 4, (int)stats.reduced);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(expected);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Strength_Basic) \
+	TEST(Strength_Lowered)
+
+#include "main_stub.inc"
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/string_pool.h"
+#include "mcc/symbol_table.h"
+
+static struct mcc_symbol variable(struct mcc_string_pool *pool,
+                                  const char *name,
+                                  struct mcc_ast_declaration *declaration)
+{
+	return (struct mcc_symbol){
+	    .name = mcc_string_pool_intern(pool, name, strlen(name)),
+	    .kind = MCC_SYMBOL_KIND_VARIABLE,
+	    .declaration = declaration,
+	};
+}
+
+// Mirrors examples/shadowing, declarations are told apart by address.
+void SymbolTable_Shadowing(CuTest *tc)
+{
+	struct mcc_string_pool pool;
+	mcc_string_pool_init(&pool);
+
+	struct mcc_symbol_table table;
+	mcc_symbol_table_init(&table);
+
+	struct mcc_ast_declaration x1, x2, x3;
+	const char *x = mcc_string_pool_intern(&pool, "x", 1);
+
+	CuAssertPtrEquals(tc, NULL, (void *)mcc_symbol_table_lookup(&table, x));
+
+	CuAssertIntEquals(tc, MCC_SYMBOL_TABLE_ERROR_NONE, mcc_symbol_table_declare(&table, variable(&pool, "x", &x1)));
+	CuAssertPtrEquals(tc, &x1, mcc_symbol_table_lookup(&table, x)->declaration);
+
+	CuAssertTrue(tc, mcc_symbol_table_enter_scope(&table));
+	CuAssertPtrEquals(tc, &x1, mcc_symbol_table_lookup(&table, x)->declaration);
+	CuAssertIntEquals(tc, MCC_SYMBOL_TABLE_ERROR_NONE, mcc_symbol_table_declare(&table, variable(&pool, "x", &x2)));
+	CuAssertPtrEquals(tc, &x2, mcc_symbol_table_lookup(&table, x)->declaration);
+
+	CuAssertTrue(tc, mcc_symbol_table_enter_scope(&table));
+	CuAssertPtrEquals(tc, &x2, mcc_symbol_table_lookup(&table, x)->declaration);
+	CuAssertIntEquals(tc, MCC_SYMBOL_TABLE_ERROR_NONE, mcc_symbol_table_declare(&table, variable(&pool, "x", &x3)));
+	CuAssertPtrEquals(tc, &x3, mcc_symbol_table_lookup(&table, x)->declaration);
+	CuAssertIntEquals(tc, 2, mcc_symbol_table_lookup(&table, x)->scope);
+	mcc_symbol_table_exit_scope(&table);
+
+	CuAssertPtrEquals(tc, &x2, mcc_symbol_table_lookup(&table, x)->declaration);
+	mcc_symbol_table_exit_scope(&table);
+
+	CuAssertPtrEquals(tc, &x1, mcc_symbol_table_lookup(&table, x)->declaration);
+
+	mcc_symbol_table_deinit(&table);
+	mcc_string_pool_deinit(&pool);
+}
+
+void SymbolTable_Redeclaration(CuTest *tc)
+{
+	struct mcc_string_pool pool;
+	mcc_string_pool_init(&pool);
+
+	struct mcc_symbol_table table;
+	mcc_symbol_table_init(&table);
+
+	struct mcc_ast_declaration a1, a2;
+
+	CuAssertTrue(tc, mcc_symbol_table_enter_scope(&table));
+	CuAssertIntEquals(tc, MCC_SYMBOL_TABLE_ERROR_NONE, mcc_symbol_table_declare(&table, variable(&pool, "a", &a1)));
+	CuAssertIntEquals(tc, MCC_SYMBOL_TABLE_ERROR_REDECLARATION,
+	                  mcc_symbol_table_declare(&table, variable(&pool, "a", &a2)));
+	mcc_symbol_table_exit_scope(&table);
+
+	// The name is visible again after leaving the scope.
+	CuAssertPtrEquals(tc, NULL, (void *)mcc_symbol_table_lookup(&table, mcc_string_pool_intern(&pool, "a", 1)));
+	CuAssertIntEquals(tc, MCC_SYMBOL_TABLE_ERROR_NONE, mcc_symbol_table_declare(&table, variable(&pool, "a", &a2)));
+
+	mcc_symbol_table_deinit(&table);
+	mcc_string_pool_deinit(&pool);
+}
+
+void SymbolTable_ManySymbols(CuTest *tc)
+{
+	struct mcc_string_pool pool;
+	mcc_string_pool_init(&pool);
+
+	struct mcc_symbol_table table;
+	mcc_symbol_table_init(&table);
+
+	enum { SYMBOLS = 1000 };
+	static struct mcc_ast_declaration declarations[SYMBOLS];
+	const char *names[SYMBOLS];
+
+	for (int i = 0; i < SYMBOLS; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "v%d", i);
+		names[i] = mcc_string_pool_intern(&pool, name, strlen(name));
+
+		CuAssertTrue(tc, mcc_symbol_table_enter_scope(&table));
+		CuAssertIntEquals(tc, MCC_SYMBOL_TABLE_ERROR_NONE,
+		                  mcc_symbol_table_declare(&table, variable(&pool, name, &declarations[i])));
+	}
+
+	for (int i = 0; i < SYMBOLS; i++) {
+		CuAssertPtrEquals(tc, &declarations[i], mcc_symbol_table_lookup(&table, names[i])->declaration);
+	}
+
+	for (int i = SYMBOLS - 1; i >= 0; i--) {
+		mcc_symbol_table_exit_scope(&table);
+		CuAssertPtrEquals(tc, NULL, (void *)mcc_symbol_table_lookup(&table, names[i]));
+	}
+	CuAssertIntEquals(tc, 0, mcc_symbol_table_scope(&table));
+
+	mcc_symbol_table_deinit(&table);
+	mcc_string_pool_deinit(&pool);
+}
+
+#define TESTS \
+	TEST(SymbolTable_Shadowing) \
+	TEST(SymbolTable_Redeclaration) \
+	TEST(SymbolTable_ManySymbols)
+
+#include "main_stub.inc"
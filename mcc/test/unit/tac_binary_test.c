@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <CuTest.h>
+
+#include "mcc/cfg.h"
+#include "mcc/ssa.h"
+#include "mcc/tac.h"
+#include "mcc/tac_binary.h"
+
+#include "tac_fixture.inc"
+
+static const char source[] = "void f(int[2] a, float x) { if (!(x < 1.5)) a[1] = 2; }\n"
+                             "int main() {\n"
+                             "  int[2] a; int i; i = 0;\n"
+                             "  while (i < 2) { f(a, 2.0); i = i + 1; }\n"
+                             "  print(\"done\\n\");\n"
+                             "  return a[i];\n"
+                             "}\n";
+
+static char *print_program(CuTest *tc, const struct mcc_tac_program *tac)
+{
+	char *output = NULL;
+	size_t output_size = 0;
+	FILE *out = open_memstream(&output, &output_size);
+	CuAssertPtrNotNull(tc, out);
+
+	CuAssertTrue(tc, mcc_tac_print_program(out, tac));
+	fclose(out);
+	return output;
+}
+
+// Encodes the functions of `tac` into a freshly allocated image.
+static char *encode(CuTest *tc, const struct mcc_tac_program *tac, const struct mcc_cfg *cfgs, size_t *size)
+{
+	char *image = NULL;
+	FILE *out = open_memstream(&image, size);
+	CuAssertPtrNotNull(tc, out);
+
+	CuAssertTrue(tc, mcc_tac_binary_write(out, tac->functions, tac->functions_count, cfgs));
+	fclose(out);
+	return image;
+}
+
+static void assert_cfgs_equal(CuTest *tc, const struct mcc_cfg *expected, const struct mcc_cfg *actual)
+{
+	CuAssertIntEquals(tc, expected->blocks_count, actual->blocks_count);
+	CuAssertIntEquals(tc, expected->order_count, actual->order_count);
+	CuAssertIntEquals(tc, expected->labels_count, actual->labels_count);
+
+	for (size_t b = 0; b < expected->blocks_count; b++) {
+		const struct mcc_cfg_block *e = &expected->blocks[b];
+		const struct mcc_cfg_block *a = &actual->blocks[b];
+		CuAssertIntEquals(tc, e->begin, a->begin);
+		CuAssertIntEquals(tc, e->end, a->end);
+		CuAssertIntEquals(tc, e->successors_count, a->successors_count);
+		for (uint32_t s = 0; s < e->successors_count; s++) {
+			CuAssertIntEquals(tc, e->successors[s], a->successors[s]);
+		}
+		CuAssertIntEquals(tc, e->predecessors_count, a->predecessors_count);
+		for (uint32_t p = 0; p < e->predecessors_count; p++) {
+			CuAssertIntEquals(tc, mcc_cfg_block_predecessors(expected, (uint32_t)b)[p],
+			                  mcc_cfg_block_predecessors(actual, (uint32_t)b)[p]);
+		}
+		CuAssertIntEquals(tc, e->idom, a->idom);
+		CuAssertIntEquals(tc, e->order, a->order);
+	}
+	for (size_t i = 0; i < expected->order_count; i++) {
+		CuAssertIntEquals(tc, expected->order[i], actual->order[i]);
+	}
+	for (size_t i = 0; i <= expected->labels_count; i++) {
+		CuAssertIntEquals(tc, expected->label_blocks[i], actual->label_blocks[i]);
+	}
+}
+
+void TacBinary_RoundTrip(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, source);
+	CuAssertTrue(tc, mcc_ssa_construct(&tac.functions[1]));
+
+	struct mcc_cfg cfgs[2] = {0};
+	for (size_t i = 0; i < 2; i++) {
+		CuAssertTrue(tc, mcc_cfg_build(&cfgs[i], &tac.functions[i]));
+	}
+
+	size_t size;
+	char *image = encode(tc, &tac, cfgs, &size);
+	CuAssertIntEquals(tc, 0, size % 8);
+
+	struct mcc_tac_program decoded;
+	mcc_tac_program_init(&decoded);
+	struct mcc_cfg *decoded_cfgs;
+	CuAssertTrue(tc, mcc_tac_binary_read(&decoded, &decoded_cfgs, image, size));
+	free(image);
+
+	char *expected = print_program(tc, &tac);
+	char *actual = print_program(tc, &decoded);
+	CuAssertStrEquals(tc, expected, actual);
+	free(expected);
+	free(actual);
+
+	// Strings end up in the pool of the receiving program.
+	const struct mcc_tac_function *main_function = mcc_tac_program_find_function(&decoded, "main");
+	CuAssertPtrNotNull(tc, main_function);
+	for (size_t i = 0; i < main_function->strings_count; i++) {
+		const char *string = main_function->strings[i];
+		CuAssertPtrEquals(tc, (void *)string,
+		                  (void *)mcc_string_pool_find(&decoded.strings, string, strlen(string)));
+	}
+
+	for (size_t i = 0; i < 2; i++) {
+		assert_cfgs_equal(tc, &cfgs[i], &decoded_cfgs[i]);
+		mcc_cfg_deinit(&cfgs[i]);
+		mcc_cfg_deinit(&decoded_cfgs[i]);
+	}
+	free(decoded_cfgs);
+
+	mcc_tac_program_deinit(&decoded);
+	mcc_tac_program_deinit(&tac);
+}
+
+void TacBinary_BuildMissingCfgs(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, source);
+
+	size_t size;
+	char *image = encode(tc, &tac, NULL, &size);
+
+	struct mcc_tac_program decoded;
+	mcc_tac_program_init(&decoded);
+	struct mcc_cfg *decoded_cfgs;
+	CuAssertTrue(tc, mcc_tac_binary_read(&decoded, &decoded_cfgs, image, size));
+	free(image);
+
+	for (size_t i = 0; i < 2; i++) {
+		struct mcc_cfg cfg;
+		CuAssertTrue(tc, mcc_cfg_build(&cfg, &tac.functions[i]));
+		assert_cfgs_equal(tc, &cfg, &decoded_cfgs[i]);
+		mcc_cfg_deinit(&cfg);
+		mcc_cfg_deinit(&decoded_cfgs[i]);
+	}
+	free(decoded_cfgs);
+
+	mcc_tac_program_deinit(&decoded);
+	mcc_tac_program_deinit(&tac);
+}
+
+void TacBinary_File(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, source);
+
+	char path[] = "/tmp/tac_binary_test_XXXXXX";
+	int fd = mkstemp(path);
+	CuAssertTrue(tc, fd >= 0);
+	FILE *out = fdopen(fd, "w");
+	CuAssertPtrNotNull(tc, out);
+	CuAssertTrue(tc, mcc_tac_binary_write(out, tac.functions, tac.functions_count, NULL));
+	fclose(out);
+
+	struct mcc_tac_program decoded;
+	mcc_tac_program_init(&decoded);
+	CuAssertTrue(tc, mcc_tac_binary_read_file(&decoded, NULL, path));
+	unlink(path);
+
+	char *expected = print_program(tc, &tac);
+	char *actual = print_program(tc, &decoded);
+	CuAssertStrEquals(tc, expected, actual);
+	free(expected);
+	free(actual);
+
+	mcc_tac_program_deinit(&decoded);
+	mcc_tac_program_deinit(&tac);
+}
+
+void TacBinary_Hash(CuTest *tc)
+{
+	struct mcc_tac_program a, b, c;
+	lower(tc, &a, source);
+	lower(tc, &b, "int main() { return 1; }\nvoid f(int[2] a, float x) { if (!(x < 1.5)) a[1] = 2; }");
+	lower(tc, &c, "void f(int[2] a, float x) { if (!(x < 1.5)) a[1] = 3; }\nint main() { return 1; }");
+
+	// Equal functions hash equally, wherever they are placed.
+	uint64_t hash_a, hash_b, hash_c;
+	CuAssertTrue(tc, mcc_tac_binary_hash(&a.functions[0], &hash_a));
+	CuAssertTrue(tc, mcc_tac_binary_hash(&b.functions[1], &hash_b));
+	CuAssertTrue(tc, mcc_tac_binary_hash(&c.functions[0], &hash_c));
+	CuAssertTrue(tc, hash_a == hash_b);
+	CuAssertTrue(tc, hash_a != hash_c);
+
+	mcc_tac_program_deinit(&a);
+	mcc_tac_program_deinit(&b);
+	mcc_tac_program_deinit(&c);
+}
+
+void TacBinary_Malformed(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, source);
+
+	struct mcc_cfg cfgs[2] = {0};
+	for (size_t i = 0; i < 2; i++) {
+		CuAssertTrue(tc, mcc_cfg_build(&cfgs[i], &tac.functions[i]));
+	}
+
+	size_t size;
+	char *image = encode(tc, &tac, cfgs, &size);
+
+	// Truncated images are rejected.
+	for (size_t length = 0; length < size; length++) {
+		struct mcc_tac_program decoded;
+		mcc_tac_program_init(&decoded);
+		CuAssertTrue(tc, !mcc_tac_binary_read(&decoded, NULL, image, length));
+		mcc_tac_program_deinit(&decoded);
+	}
+
+	// Flipping bits never leads to out-of-bounds accesses, whether or not
+	// the result is accepted.
+	for (size_t i = 0; i < size; i++) {
+		image[i] ^= 0x40;
+
+		struct mcc_tac_program decoded;
+		mcc_tac_program_init(&decoded);
+		struct mcc_cfg *decoded_cfgs = NULL;
+		if (mcc_tac_binary_read(&decoded, &decoded_cfgs, image, size)) {
+			for (size_t f = 0; f < decoded.functions_count; f++) {
+				mcc_cfg_deinit(&decoded_cfgs[f]);
+			}
+			free(decoded_cfgs);
+		}
+		mcc_tac_program_deinit(&decoded);
+
+		image[i] ^= 0x40;
+	}
+
+	// Images of other versions are rejected.
+	image[8]++;
+	struct mcc_tac_program decoded;
+	mcc_tac_program_init(&decoded);
+	CuAssertTrue(tc, !mcc_tac_binary_read(&decoded, NULL, image, size));
+	mcc_tac_program_deinit(&decoded);
+
+	free(image);
+	for (size_t i = 0; i < 2; i++) {
+		mcc_cfg_deinit(&cfgs[i]);
+	}
+	mcc_tac_program_deinit(&tac);
+}
+
+// Asserts that the image of `tac` is rejected, then deinitialises `tac`.
+static void assert_rejected(CuTest *tc, struct mcc_tac_program *tac)
+{
+	size_t size;
+	char *image = encode(tc, tac, NULL, &size);
+
+	struct mcc_tac_program decoded;
+	mcc_tac_program_init(&decoded);
+	CuAssertTrue(tc, !mcc_tac_binary_read(&decoded, NULL, image, size));
+	mcc_tac_program_deinit(&decoded);
+
+	free(image);
+	mcc_tac_program_deinit(tac);
+}
+
+// Returns the `nth` instruction of `function` with opcode `op`, counting
+// from 0.
+static struct mcc_tac_instruction *find_instruction(CuTest *tc,
+                                                    struct mcc_tac_function *function,
+                                                    enum mcc_tac_op op,
+                                                    size_t nth)
+{
+	for (size_t i = 0; i < function->instructions_count; i++) {
+		if (function->instructions[i].op == op && nth-- == 0) {
+			return &function->instructions[i];
+		}
+	}
+	CuFail(tc, "instruction not found");
+	return NULL;
+}
+
+void TacBinary_ReservedVariable(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, "int main() { int a; a = 3; return a * a; }");
+
+	// Variable 0 is reserved and must not be used as an operand.
+	find_instruction(tc, &tac.functions[0], MCC_TAC_OP_MUL, 0)->arg2 = 0;
+	assert_rejected(tc, &tac);
+}
+
+void TacBinary_SharedOperands(CuTest *tc)
+{
+	// Passes rename operands in place, two calls sharing their arguments
+	// would have them renamed twice.
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function void main(0)\n"
+	      "	v1 = CONST int 1\n"
+	      "	CALL void print_int(v1)\n"
+	      "	CALL void print_int(v1)\n"
+	      "	RETURN void\n");
+	uint32_t arguments = find_instruction(tc, &tac.functions[0], MCC_TAC_OP_CALL, 0)->arg2;
+	find_instruction(tc, &tac.functions[0], MCC_TAC_OP_CALL, 1)->arg2 = arguments;
+	assert_rejected(tc, &tac);
+
+	parse(tc, &tac,
+	      "function int f(1)\n"
+	      "L1:\n"
+	      "	v1 = PARAM bool 0\n"
+	      "	v2 = CONST int 1\n"
+	      "	JUMP_IF_NOT L3, v1\n"
+	      "L2:\n"
+	      "	v3 = CONST int 2\n"
+	      "L3:\n"
+	      "	v4 = PHI int [L1, v2], [L2, v3]\n"
+	      "	v5 = PHI int [L1, v3], [L2, v2]\n"
+	      "	v6 = ADD int v4, v5\n"
+	      "	RETURN int v6\n");
+	uint32_t operands = find_instruction(tc, &tac.functions[0], MCC_TAC_OP_PHI, 0)->arg1;
+	find_instruction(tc, &tac.functions[0], MCC_TAC_OP_PHI, 1)->arg1 = operands;
+	assert_rejected(tc, &tac);
+}
+
+void TacBinary_ParameterIndex(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int f(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	RETURN int v1\n");
+	find_instruction(tc, &tac.functions[0], MCC_TAC_OP_PARAM, 0)->arg1 = 1;
+	assert_rejected(tc, &tac);
+}
+
+void TacBinary_Arity(CuTest *tc)
+{
+	static const char callee[] = "function int g(1)\n"
+	                             "	v1 = PARAM int 0\n"
+	                             "	RETURN int v1\n";
+	static const char caller[] = "function int main(0)\n"
+	                             "	v1 = CONST int 1\n"
+	                             "	v2 = CALL int g(v1, v1)\n"
+	                             "	RETURN int v2\n";
+
+	struct mcc_tac_program tac;
+	parse(tc, &tac, callee);
+	CuAssertStrEquals(tc, "", mcc_tac_parse_string(&tac, caller).error_msg);
+	assert_rejected(tc, &tac);
+
+	// Calls are also checked against functions read before, in both
+	// directions.
+	struct mcc_tac_program callee_tac, caller_tac;
+	parse(tc, &callee_tac, callee);
+	parse(tc, &caller_tac, caller);
+	size_t callee_size, caller_size;
+	char *callee_image = encode(tc, &callee_tac, NULL, &callee_size);
+	char *caller_image = encode(tc, &caller_tac, NULL, &caller_size);
+
+	struct mcc_tac_program decoded;
+	mcc_tac_program_init(&decoded);
+	CuAssertTrue(tc, mcc_tac_binary_read(&decoded, NULL, callee_image, callee_size));
+	CuAssertTrue(tc, !mcc_tac_binary_read(&decoded, NULL, caller_image, caller_size));
+	mcc_tac_program_deinit(&decoded);
+
+	mcc_tac_program_init(&decoded);
+	CuAssertTrue(tc, mcc_tac_binary_read(&decoded, NULL, caller_image, caller_size));
+	CuAssertTrue(tc, !mcc_tac_binary_read(&decoded, NULL, callee_image, callee_size));
+	mcc_tac_program_deinit(&decoded);
+
+	free(callee_image);
+	free(caller_image);
+	mcc_tac_program_deinit(&callee_tac);
+	mcc_tac_program_deinit(&caller_tac);
+}
+
+#define TESTS \
+	TEST(TacBinary_RoundTrip) \
+	TEST(TacBinary_BuildMissingCfgs) \
+	TEST(TacBinary_File) \
+	TEST(TacBinary_Hash) \
+	TEST(TacBinary_Malformed) \
+	TEST(TacBinary_ReservedVariable) \
+	TEST(TacBinary_SharedOperands) \
+	TEST(TacBinary_ParameterIndex) \
+	TEST(TacBinary_Arity)
+
+#include "main_stub.inc"
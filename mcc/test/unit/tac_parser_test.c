@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/parser.h"
+#include "mcc/pass.h"
+#include "mcc/semantic.h"
+#include "mcc/tac.h"
+#include "mcc/tac_lower.h"
+#include "mcc/tac_parser.h"
+
+static char *print(CuTest *tc, const struct mcc_tac_program *tac)
+{
+	char *output = NULL;
+	size_t output_size = 0;
+	FILE *out = open_memstream(&output, &output_size);
+	CuAssertPtrNotNull(tc, out);
+
+	CuAssertTrue(tc, mcc_tac_print_program(out, tac));
+	fclose(out);
+	return output;
+}
+
+// Lowers `input`, optionally runs `pass`, and returns the printed result.
+static char *lower(CuTest *tc, const char *input, const char *pass)
+{
+	struct mcc_parser_result parser_result = mcc_parse_program_string(input);
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, parser_result.error);
+
+	struct mcc_semantic_result semantic_result = mcc_semantic_check(parser_result.program, NULL);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_NONE, semantic_result.error);
+	mcc_semantic_result_deinit(&semantic_result);
+
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	CuAssertTrue(tc, mcc_tac_lower_program(&tac, parser_result.program, NULL));
+	mcc_ast_delete_program(parser_result.program);
+
+	if (pass) {
+		CuAssertTrue(tc, mcc_pass_run(mcc_pass_find(pass, strlen(pass)), &tac));
+	}
+
+	char *output = print(tc, &tac);
+	mcc_tac_program_deinit(&tac);
+	return output;
+}
+
+// Parses `input` and prints it again.
+static char *reprint(CuTest *tc, const char *input)
+{
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	struct mcc_tac_parser_result result = mcc_tac_parse_string(&tac, input);
+	CuAssertStrEquals(tc, "", result.error_msg);
+	CuAssertIntEquals(tc, MCC_TAC_PARSER_ERROR_NONE, result.error);
+
+	char *output = print(tc, &tac);
+	mcc_tac_program_deinit(&tac);
+	return output;
+}
+
+static void assert_error(CuTest *tc, const char *input, const char *expected)
+{
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	struct mcc_tac_parser_result result = mcc_tac_parse_string(&tac, input);
+	mcc_tac_program_deinit(&tac);
+
+	CuAssertIntEquals(tc, MCC_TAC_PARSER_ERROR_PARSE_ERROR, result.error);
+	CuAssertStrEquals(tc, expected, result.error_msg);
+}
+
+static const char source[] = "void f(int[2] a, float x) { if (!(x < 1.5)) a[1] = 2; }\n"
+                             "bool g(bool b, string s) { print(s); print_nl(); return !b && true; }\n"
+                             "int main() {\n"
+                             "  int[2] a; int i; i = 0;\n"
+                             "  while (i < 2) { f(a, -2.5); i = i + 1; }\n"
+                             "  if (g(false, \"say \\\\hi\\n\")) return -1;\n"
+                             "  return a[i];\n"
+                             "}\n";
+
+void TacParser_RoundTrip(CuTest *tc)
+{
+	char *printed = lower(tc, source, NULL);
+	char *reprinted = reprint(tc, printed);
+	CuAssertStrEquals(tc, printed, reprinted);
+	free(printed);
+	free(reprinted);
+}
+
+void TacParser_RoundTripSsa(CuTest *tc)
+{
+	char *printed = lower(tc, source, "ssa");
+	CuAssertTrue(tc, strstr(printed, "PHI") != NULL);
+
+	char *reprinted = reprint(tc, printed);
+	CuAssertStrEquals(tc, printed, reprinted);
+	free(printed);
+	free(reprinted);
+}
+
+void TacParser_Lenient(CuTest *tc)
+{
+	char *output = reprint(tc,
+	                       "# comments and blank lines are ignored\n"
+	                       "\n"
+	                       "function int f(1)\n"
+	                       "  v1 = PARAM int 0   # trailing comment\n"
+	                       "  v5 = CALL int f(v1)\n"
+	                       "  RETURN int v5\n");
+
+	// v2 to v4 do not occur, they are given type int.
+	CuAssertStrEquals(tc,
+	                  "function int f(1)\n"
+	                  "\tv1 = PARAM int 0\n"
+	                  "\tv5 = CALL int f(v1)\n"
+	                  "\tRETURN int v5\n",
+	                  output);
+	free(output);
+}
+
+void TacParser_Errors(CuTest *tc)
+{
+	assert_error(tc, "\tRETURN void\n", "<string>:1:2: error: expected a function");
+	assert_error(tc, "function void f(0)\n\tv1 = FOO int v2\n", "<string>:2:7: error: expected an instruction");
+	assert_error(tc, "function void f(0)\n\tv1 = ADD int v2 v3\n", "<string>:2:18: error: expected ','");
+	assert_error(tc, "function void f(0)\n\tv1 = CONST int 1\n\tv2 = NOT bool v1\n",
+	             "<string>:3:16: error: v1 is used as int and bool");
+	assert_error(tc, "function void f(0)\n\tSTORE int v1, v2, v3\n\tv4 = ARRAY int 0\n",
+	             "<string>:3:17: error: arrays cannot be empty");
+	assert_error(tc, "function void f(0)\n\tv1 = JUMP L1\n",
+	             "<string>:2:2: error: JUMP does not define a variable");
+	assert_error(tc, "function void f(0)\n\tCONST int 1\n", "<string>:2:2: error: CONST has to define a variable");
+	assert_error(tc, "function void f(0)\n\tv1 = CONST string \"a\n",
+	             "<string>:2:22: error: unterminated string");
+	assert_error(tc, "function void f(0)\n\tCALL void g(v1)\n\tRETURN void\n",
+	             "<string>:1:1: error: the type of v1 cannot be inferred");
+	assert_error(tc, "function void f(0)\n\tJUMP L2\nL1:\n", "<string>:1:1: error: L2 is not placed in f");
+	assert_error(tc, "function void f(0)\nL1:\nL1:\n", "<string>:1:1: error: L1 is placed twice in f");
+	assert_error(tc, "function void f(0)\n\tRETURN void\nfunction void f(0)\n\tRETURN void\n",
+	             "<string>:3:1: error: f is defined twice");
+}
+
+#define TESTS \
+	TEST(TacParser_RoundTrip) \
+	TEST(TacParser_RoundTripSsa) \
+	TEST(TacParser_Lenient) \
+	TEST(TacParser_Errors)
+
+#include "main_stub.inc"
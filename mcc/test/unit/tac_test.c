@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <CuTest.h>
+
+#include "mcc/parser.h"
+#include "mcc/semantic.h"
+#include "mcc/tac.h"
+#include "mcc/tac_builder.h"
+#include "mcc/tac_lower.h"
+
+// Parses, checks, and lowers `input` using `threads` threads, then prints the
+// resulting TAC into a freshly allocated string.
+static char *lower_threaded(CuTest *tc, const char *input, size_t threads)
+{
+	struct mcc_parser_result parser_result = mcc_parse_program_string(input);
+	CuAssertIntEquals(tc, MCC_PARSER_ERROR_NONE, parser_result.error);
+
+	struct mcc_semantic_result semantic_result = mcc_semantic_check(parser_result.program, NULL);
+	CuAssertIntEquals(tc, MCC_SEMANTIC_ERROR_NONE, semantic_result.error);
+	mcc_semantic_result_deinit(&semantic_result);
+
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	struct mcc_tac_lower_options options = {.threads = threads};
+	CuAssertTrue(tc, mcc_tac_lower_program(&tac, parser_result.program, &options));
+	mcc_ast_delete_program(parser_result.program);
+
+	char *output = NULL;
+	size_t output_size = 0;
+	FILE *out = open_memstream(&output, &output_size);
+	CuAssertPtrNotNull(tc, out);
+
+	CuAssertTrue(tc, mcc_tac_print_program(out, &tac));
+	fclose(out);
+
+	mcc_tac_program_deinit(&tac);
+	return output;
+}
+
+static char *lower(CuTest *tc, const char *input)
+{
+	return lower_threaded(tc, input, 1);
+}
+
+static struct mcc_tac_instruction jump(uint32_t label)
+{
+	return (struct mcc_tac_instruction){.op = MCC_TAC_OP_JUMP, .arg2 = label};
+}
+
+void Tac_Append(CuTest *tc)
+{
+	struct mcc_tac_function function = {0};
+
+	for (uint32_t i = 1; i <= 1000; i++) {
+		CuAssertTrue(tc, mcc_tac_function_append(&function, jump(i)));
+	}
+
+	CuAssertIntEquals(tc, 1000, function.instructions_count);
+	for (size_t i = 0; i < function.instructions_count; i++) {
+		CuAssertIntEquals(tc, i + 1, function.instructions[i].arg2);
+	}
+
+	mcc_tac_function_deinit(&function);
+}
+
+void Tac_RemoveCompact(CuTest *tc)
+{
+	struct mcc_tac_function function = {0};
+	for (uint32_t i = 1; i <= 10; i++) {
+		CuAssertTrue(tc, mcc_tac_function_append(&function, jump(i)));
+	}
+
+	// Indices stay valid until compaction.
+	mcc_tac_function_remove(&function, 0);
+	mcc_tac_function_remove(&function, 4);
+	mcc_tac_function_remove(&function, 4);
+	CuAssertIntEquals(tc, 10, function.instructions_count);
+	CuAssertIntEquals(tc, 2, function.removed_count);
+	CuAssertIntEquals(tc, MCC_TAC_OP_NOP, function.instructions[4].op);
+	CuAssertIntEquals(tc, 6, function.instructions[5].arg2);
+
+	mcc_tac_function_compact(&function);
+	CuAssertIntEquals(tc, 8, function.instructions_count);
+	CuAssertIntEquals(tc, 0, function.removed_count);
+
+	const uint32_t expected[] = {2, 3, 4, 6, 7, 8, 9, 10};
+	for (size_t i = 0; i < function.instructions_count; i++) {
+		CuAssertIntEquals(tc, expected[i], function.instructions[i].arg2);
+	}
+
+	mcc_tac_function_deinit(&function);
+}
+
+void Tac_Insert(CuTest *tc)
+{
+	struct mcc_tac_function function = {0};
+	CuAssertTrue(tc, mcc_tac_function_append(&function, jump(1)));
+	CuAssertTrue(tc, mcc_tac_function_append(&function, jump(4)));
+
+	const struct mcc_tac_instruction batch[] = {jump(2), jump(3)};
+	CuAssertTrue(tc, mcc_tac_function_insert(&function, 1, batch, 2));
+	CuAssertTrue(tc, mcc_tac_function_insert(&function, 4, batch, 0));
+
+	CuAssertIntEquals(tc, 4, function.instructions_count);
+	for (size_t i = 0; i < function.instructions_count; i++) {
+		CuAssertIntEquals(tc, i + 1, function.instructions[i].arg2);
+	}
+
+	mcc_tac_function_deinit(&function);
+}
+
+void Tac_Lower(CuTest *tc)
+{
+	char *output = lower(tc,
+	                     "void f(int[2] a, float x) { if (!(x < 1.5)) a[1] = 2; }\n"
+	                     "int main() { int[2] a; int i; i = 0; while (i < 2) { f(a, 2.0); i = i + 1; } "
+	                     "return a[i]; }");
+
+	CuAssertStrEquals(tc,
+	                  "function void f(2)\n"
+	                  "\tv1 = PARAM array 0\n"
+	                  "\tv2 = PARAM float 1\n"
+	                  "\tv3 = CONST float 1.5\n"
+	                  "\tv4 = LT float v2, v3\n"
+	                  "\tv5 = NOT bool v4\n"
+	                  "\tJUMP_IF_NOT L1, v5\n"
+	                  "\tv6 = CONST int 1\n"
+	                  "\tv7 = CONST int 2\n"
+	                  "\tSTORE int v1, v6, v7\n"
+	                  "L1:\n"
+	                  "\tRETURN void\n"
+	                  "\n"
+	                  "function int main(0)\n"
+	                  "\tv1 = ARRAY int 2\n"
+	                  "\tv3 = CONST int 0\n"
+	                  "\tv2 = ASSIGN int v3\n"
+	                  "L1:\n"
+	                  "\tv4 = CONST int 2\n"
+	                  "\tv5 = LT int v2, v4\n"
+	                  "\tJUMP_IF_NOT L2, v5\n"
+	                  "\tv6 = CONST float 2.0\n"
+	                  "\tCALL void f(v1, v6)\n"
+	                  "\tv7 = CONST int 1\n"
+	                  "\tv8 = ADD int v2, v7\n"
+	                  "\tv2 = ASSIGN int v8\n"
+	                  "\tJUMP L1\n"
+	                  "L2:\n"
+	                  "\tv9 = LOAD int v1, v2\n"
+	                  "\tRETURN int v9\n",
+	                  output);
+
+	free(output);
+}
+
+void Tac_LowerConstants(CuTest *tc)
+{
+	char *output = lower(tc, "int main() { bool b; string s; b = true; s = \"a\nb\"; return 0; }");
+
+	CuAssertStrEquals(tc,
+	                  "function int main(0)\n"
+	                  "\tv3 = CONST bool true\n"
+	                  "\tv1 = ASSIGN bool v3\n"
+	                  "\tv4 = CONST string \"a\\nb\"\n"
+	                  "\tv2 = ASSIGN string v4\n"
+	                  "\tv5 = CONST int 0\n"
+	                  "\tRETURN int v5\n",
+	                  output);
+
+	free(output);
+}
+
+void Tac_Builder(CuTest *tc)
+{
+	// Interleaved builders number their variables and labels independently.
+	struct mcc_tac_builder a, b;
+	mcc_tac_builder_init(&a, "a", MCC_TAC_TYPE_INT, 0);
+	mcc_tac_builder_init(&b, "b", MCC_TAC_TYPE_VOID, 0);
+
+	struct mcc_tac_variable one = mcc_tac_builder_const_int(&a, 1);
+	uint32_t label = mcc_tac_builder_label(&b);
+	mcc_tac_builder_place_label(&b, label);
+	struct mcc_tac_variable two = mcc_tac_builder_const_int(&a, 2);
+	struct mcc_tac_variable flag = mcc_tac_builder_const_bool(&b, true);
+	mcc_tac_builder_jump_if(&b, label, flag, true);
+	mcc_tac_builder_return(&a, mcc_tac_builder_binary(&a, MCC_TAC_OP_ADD, MCC_TAC_TYPE_INT, one, two));
+	mcc_tac_builder_return(&b, (struct mcc_tac_variable){0});
+
+	struct mcc_tac_function function_a, function_b;
+	CuAssertTrue(tc, mcc_tac_builder_finish(&a, &function_a));
+	CuAssertTrue(tc, mcc_tac_builder_finish(&b, &function_b));
+
+	CuAssertIntEquals(tc, 3, function_a.variables_count);
+	CuAssertIntEquals(tc, 0, function_a.labels_count);
+	CuAssertIntEquals(tc, 4, function_a.instructions_count);
+	CuAssertIntEquals(tc, 1, function_b.variables_count);
+	CuAssertIntEquals(tc, 1, function_b.labels_count);
+	CuAssertIntEquals(tc, 4, function_b.instructions_count);
+	CuAssertIntEquals(tc, 1, function_b.instructions[2].arg1);
+
+	mcc_tac_builder_deinit(&a);
+	mcc_tac_builder_deinit(&b);
+	mcc_tac_function_deinit(&function_a);
+	mcc_tac_function_deinit(&function_b);
+}
+
+void Tac_BuilderPools(CuTest *tc)
+{
+	static const char name[] = "f";
+
+	struct mcc_tac_builder builder;
+	mcc_tac_builder_init(&builder, "main", MCC_TAC_TYPE_VOID, 0);
+
+	// Constants and callee names are stored once, regardless of their type.
+	for (int i = 0; i < 100; i++) {
+		mcc_tac_builder_const_int(&builder, i % 3);
+		mcc_tac_builder_const_float(&builder, 0.5);
+		mcc_tac_builder_const_bool(&builder, true);
+		mcc_tac_builder_call(&builder, name, MCC_TAC_TYPE_VOID, NULL, 0);
+	}
+
+	struct mcc_tac_function function;
+	CuAssertTrue(tc, mcc_tac_builder_finish(&builder, &function));
+
+	CuAssertIntEquals(tc, 400, function.instructions_count);
+	CuAssertIntEquals(tc, 300, function.variables_count);
+	CuAssertIntEquals(tc, 4, function.constants_count);
+	CuAssertIntEquals(tc, 1, function.strings_count);
+	CuAssertPtrEquals(tc, (void *)name, (void *)function.strings[function.instructions[3].arg1]);
+	CuAssertIntEquals(tc, 0, function.operands[function.instructions[3].arg2]);
+
+	const struct mcc_tac_instruction *half = &function.instructions[1];
+	CuAssertIntEquals(tc, MCC_TAC_TYPE_FLOAT, half->type);
+	CuAssertDblEquals(tc, 0.5, mcc_tac_bits_float(function.constants[half->arg1]), 0.0);
+	CuAssertIntEquals(tc, MCC_TAC_TYPE_FLOAT, mcc_tac_function_variable_type(&function, half->result));
+
+	mcc_tac_builder_deinit(&builder);
+	mcc_tac_function_deinit(&function);
+}
+
+void Tac_LowerThreads(CuTest *tc)
+{
+	const char input[] = "int f(int n) { if (n < 2) return n; return f(n - 1) + f(n - 2); }\n"
+	                     "float g(float x) { while (x > 1.0) x = x / 2.0; return x; }\n"
+	                     "void h(string s) { print(s); print_nl(); }\n"
+	                     "bool k(bool a, bool b) { return a && !b || a == b; }\n"
+	                     "int main() { h(\"x\"); print_float(g(10.0)); return f(5); }";
+
+	char *sequential = lower_threaded(tc, input, 1);
+	char *parallel = lower_threaded(tc, input, 4);
+	CuAssertStrEquals(tc, sequential, parallel);
+
+	free(sequential);
+	free(parallel);
+}
+
+#define TESTS \
+	TEST(Tac_Append) \
+	TEST(Tac_RemoveCompact) \
+	TEST(Tac_Insert) \
+	TEST(Tac_Lower) \
+	TEST(Tac_LowerConstants) \
+	TEST(Tac_Builder) \
+	TEST(Tac_BuilderPools) \
+	TEST(Tac_LowerThreads)
+
+#include "main_stub.inc"
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <CuTest.h>
+
+#include "mcc/pass.h"
+#include "mcc/tac.h"
+#include "mcc/tailrec.h"
+
+#include "tac_fixture.inc"
+
+void Tailrec_Basic(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int gcd(2)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = PARAM int 1\n"
+	      "	v3 = CONST int 0\n"
+	      "	v4 = EQ int v2, v3\n"
+	      "	JUMP_IF_NOT L1, v4\n"
+	      "	RETURN int v1\n"
+	      "L1:\n"
+	      "	v5 = DIV int v1, v2\n"
+	      "	v6 = MUL int v5, v2\n"
+	      "	v7 = SUB int v1, v6\n"
+	      "	v8 = CALL int gcd(v2, v7)\n"
+	      "	v9 = ASSIGN int v8\n"
+	      "	JUMP L2\n"
+	      "L2:\n"
+	      "	RETURN int v9\n"
+	      "\n"
+	      "function int fact(1)\n"
+	      "	v1 = PARAM int 0\n"
+	      "	v2 = CONST int 1\n"
+	      "	v3 = LE int v1, v2\n"
+	      "	JUMP_IF_NOT L1, v3\n"
+	      "	RETURN int v2\n"
+	      "L1:\n"
+	      "	v4 = SUB int v1, v2\n"
+	      "	v5 = CALL int fact(v4)\n"
+	      "	v6 = MUL int v1, v5\n"
+	      "	RETURN int v6\n"
+	      "\n"
+	      "function void echo(0)\n"
+	      "	v1 = CALL int read_int()\n"
+	      "	v2 = CONST int 0\n"
+	      "	v3 = EQ int v1, v2\n"
+	      "	JUMP_IF_NOT L1, v3\n"
+	      "	RETURN void\n"
+	      "L1:\n"
+	      "	CALL void print_int(v1)\n"
+	      "	CALL void echo()\n"
+	      "\n"
+	      "function int main(0)\n"
+	      "	v1 = CONST int 84\n"
+	      "	v2 = CONST int 60\n"
+	      "	v3 = CALL int gcd(v1, v2)\n"
+	      "	CALL void print_int(v3)\n"
+	      "	v4 = CONST int 5\n"
+	      "	v5 = CALL int fact(v4)\n"
+	      "	CALL void print_int(v5)\n"
+	      "	CALL void echo()\n"
+	      "	RETURN int v3\n");
+
+	struct mcc_tailrec_stats stats = {0};
+	for (size_t f = 0; f < tac.functions_count; f++) {
+		CuAssertTrue(tc, mcc_tailrec_function(&tac.functions[f], &stats));
+	}
+	CuAssertIntEquals(tc, 2, (int)stats.eliminated);
+
+	// The first argument is the second parameter, which is assigned as well.
+	assert_printed(tc,
+	               "function int gcd(2)\n"
+	               "	v1 = PARAM int 0\n"
+	               "	v2 = PARAM int 1\n"
+	               "L3:\n"
+	               "	v3 = CONST int 0\n"
+	               "	v4 = EQ int v2, v3\n"
+	               "	JUMP_IF_NOT L1, v4\n"
+	               "	RETURN int v1\n"
+	               "L1:\n"
+	               "	v5 = DIV int v1, v2\n"
+	               "	v6 = MUL int v5, v2\n"
+	               "	v7 = SUB int v1, v6\n"
+	               "	v10 = ASSIGN int v2\n"
+	               "	v1 = ASSIGN int v10\n"
+	               "	v2 = ASSIGN int v7\n"
+	               "	JUMP L3\n"
+	               "	v9 = ASSIGN int v8\n"
+	               "	JUMP L2\n"
+	               "L2:\n"
+	               "	RETURN int v9\n",
+	               &tac.functions[0]);
+
+	// Without parameters, the loop starts at the first instruction.
+	assert_printed(tc,
+	               "function void echo(0)\n"
+	               "L2:\n"
+	               "	v1 = CALL int read_int()\n"
+	               "	v2 = CONST int 0\n"
+	               "	v3 = EQ int v1, v2\n"
+	               "	JUMP_IF_NOT L1, v3\n"
+	               "	RETURN void\n"
+	               "L1:\n"
+	               "	CALL void print_int(v1)\n"
+	               "	JUMP L2\n",
+	               &tac.functions[2]);
+
+	char *output = run_with_input(tc, &tac, "1 2 3 0");
+	CuAssertStrEquals(tc, "12120123", output);
+	free(output);
+
+	// The loops are optimised like any other.
+	CuAssertTrue(tc, mcc_pass_run_pipeline(mcc_pass_default_pipeline, &tac));
+	output = run_with_input(tc, &tac, "4 5 0");
+	CuAssertStrEquals(tc, "1212045", output);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+void Tailrec_Lowered(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int sum(int n, int s) { if (n == 0) return s; return sum(n - 1, s + n); }\n"
+	      "int collatz(int n, int steps) {\n"
+	      "  if (n == 1) return steps;\n"
+	      "  int m;\n"
+	      "  if (n / 2 * 2 == n) m = n / 2; else m = 3 * n + 1;\n"
+	      "  return collatz(m, steps + 1);\n"
+	      "}\n"
+	      "float halve(float x, int n) { if (n == 0) return x; return halve(x / 2.0, n - 1); }\n"
+	      "int largest(int[4] a, int i, int m) {\n"
+	      "  if (i == 4) return m;\n"
+	      "  if (a[i] > m) return largest(a, i + 1, a[i]);\n"
+	      "  return largest(a, i + 1, m);\n"
+	      "}\n"
+	      "int local(int n) { int[1] a; a[0] = n; if (n == 0) return 0; return local(n - 1); }\n"
+	      "int main() {\n"
+	      "  int[4] a; a[0] = 3; a[1] = 9; a[2] = 4; a[3] = 7;\n"
+	      "  print_int(sum(1000000, 0)); print_nl();\n"
+	      "  print_int(collatz(27, 0)); print_nl();\n"
+	      "  print_float(halve(10.0, 3)); print_nl();\n"
+	      "  print_int(largest(a, 0, 0)); print_nl();\n"
+	      "  print_int(local(3)); print_nl();\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	// local creates an array and keeps its call.
+	struct mcc_tailrec_stats stats = {0};
+	for (size_t f = 0; f < tac.functions_count; f++) {
+		CuAssertTrue(tc, mcc_tailrec_function(&tac.functions[f], &stats));
+	}
+	CuAssertIntEquals(tc, 5, (int)stats.eliminated);
+
+	// A million calls of sum run without growing the stack.
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, "1784293664\n111\n1.25\n9\n0\n", output);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Tailrec_Basic) \
+	TEST(Tailrec_Lowered)
+
+#include "main_stub.inc"
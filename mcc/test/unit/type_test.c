@@ -0,0 +1,52 @@
+#include <CuTest.h>
+
+#include "mcc/type.h"
+
+void Type_Scalars(CuTest *tc)
+{
+	const struct mcc_type *type = mcc_type_scalar(MCC_TYPE_KIND_INT);
+
+	CuAssertPtrEquals(tc, (void *)type, (void *)mcc_type_scalar(MCC_TYPE_KIND_INT));
+	CuAssertTrue(tc, type != mcc_type_scalar(MCC_TYPE_KIND_FLOAT));
+	CuAssertIntEquals(tc, 4, type->size);
+	CuAssertIntEquals(tc, 4, type->alignment);
+}
+
+void Type_Arrays(CuTest *tc)
+{
+	struct mcc_type_pool pool;
+	mcc_type_pool_init(&pool);
+
+	const struct mcc_type *element = mcc_type_scalar(MCC_TYPE_KIND_BOOL);
+	const struct mcc_type *a10 = mcc_type_pool_array(&pool, element, 10);
+	const struct mcc_type *a11 = mcc_type_pool_array(&pool, element, 11);
+
+	CuAssertPtrNotNull(tc, a10);
+	CuAssertPtrNotNull(tc, a11);
+	CuAssertTrue(tc, a10 != a11);
+	CuAssertPtrEquals(tc, (void *)a10, (void *)mcc_type_pool_array(&pool, element, 10));
+	CuAssertTrue(tc, a10 != mcc_type_pool_array(&pool, mcc_type_scalar(MCC_TYPE_KIND_INT), 10));
+
+	CuAssertIntEquals(tc, MCC_TYPE_KIND_ARRAY, a10->kind);
+	CuAssertPtrEquals(tc, (void *)element, (void *)a10->element);
+	CuAssertIntEquals(tc, 10, a10->size);
+	CuAssertIntEquals(tc, 1, a10->alignment);
+
+	char buffer[32];
+	CuAssertStrEquals(tc, "bool[11]", mcc_type_to_string(a11, buffer, sizeof(buffer)));
+
+	// Enough distinct types to trigger growth.
+	for (long i = 0; i < 1000; i++) {
+		CuAssertPtrNotNull(tc, mcc_type_pool_array(&pool, element, i));
+	}
+	CuAssertPtrEquals(tc, (void *)a10, (void *)mcc_type_pool_array(&pool, element, 10));
+	CuAssertIntEquals(tc, 1001, pool.count);
+
+	mcc_type_pool_deinit(&pool);
+}
+
+#define TESTS \
+	TEST(Type_Scalars) \
+	TEST(Type_Arrays)
+
+#include "main_stub.inc"
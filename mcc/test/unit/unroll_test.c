@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/pass.h"
+#include "mcc/tac.h"
+#include "mcc/unroll.h"
+
+#include "tac_fixture.inc"
+
+void Unroll_Constant(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int main(0)\n"
+	      "	v1 = CONST int 0\n"
+	      "	v2 = CONST int 0\n"
+	      "L1:\n"
+	      "	v3 = CONST int 10\n"
+	      "	v4 = LT int v1, v3\n"
+	      "	JUMP_IF_NOT L2, v4\n"
+	      "	v5 = MUL int v1, v1\n"
+	      "	v2 = ADD int v2, v5\n"
+	      "	v6 = CONST int 1\n"
+	      "	v1 = ADD int v1, v6\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	RETURN int v2\n");
+
+	struct mcc_unroll_stats stats = {0};
+	CuAssertTrue(tc, mcc_unroll_function(&tac.functions[0], NULL, &stats));
+	CuAssertIntEquals(tc, 1, (int)stats.unrolled);
+	CuAssertIntEquals(tc, 4, (int)stats.copies);
+
+	// Four iterations run as long as i < 7, which holds initially. The loop
+	// runs the remaining two.
+	assert_printed(tc,
+	               "function int main(0)\n"
+	               "	v1 = CONST int 0\n"
+	               "	v2 = CONST int 0\n"
+	               "	v7 = CONST int 7\n"
+	               "L3:\n"
+	               "	v8 = MUL int v1, v1\n"
+	               "	v2 = ADD int v2, v8\n"
+	               "	v9 = CONST int 1\n"
+	               "	v1 = ADD int v1, v9\n"
+	               "	v10 = MUL int v1, v1\n"
+	               "	v2 = ADD int v2, v10\n"
+	               "	v11 = CONST int 1\n"
+	               "	v1 = ADD int v1, v11\n"
+	               "	v12 = MUL int v1, v1\n"
+	               "	v2 = ADD int v2, v12\n"
+	               "	v13 = CONST int 1\n"
+	               "	v1 = ADD int v1, v13\n"
+	               "	v14 = MUL int v1, v1\n"
+	               "	v2 = ADD int v2, v14\n"
+	               "	v15 = CONST int 1\n"
+	               "	v1 = ADD int v1, v15\n"
+	               "	v16 = LT int v1, v7\n"
+	               "	JUMP_IF L3, v16\n"
+	               "L1:\n"
+	               "	v3 = CONST int 10\n"
+	               "	v4 = LT int v1, v3\n"
+	               "	JUMP_IF_NOT L2, v4\n"
+	               "	v5 = MUL int v1, v1\n"
+	               "	v2 = ADD int v2, v5\n"
+	               "	v6 = CONST int 1\n"
+	               "	v1 = ADD int v1, v6\n"
+	               "	JUMP L1\n"
+	               "L2:\n"
+	               "	RETURN int v2\n",
+	               &tac.functions[0]);
+
+	char *output = run(tc, &tac);
+	free(output);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Unroll_Budget(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	parse(tc, &tac,
+	      "function int main(0)\n"
+	      "	v1 = CONST int 0\n"
+	      "L1:\n"
+	      "	v2 = CONST int 3\n"
+	      "	v3 = LT int v1, v2\n"
+	      "	JUMP_IF_NOT L2, v3\n"
+	      "	CALL void print_int(v1)\n"
+	      "	v4 = CONST int 1\n"
+	      "	v1 = ADD int v1, v4\n"
+	      "	JUMP L1\n"
+	      "L2:\n"
+	      "	RETURN int v1\n");
+
+	// Three iterations are too few for four copies, a budget of five
+	// instructions is too small for two.
+	struct mcc_unroll_stats stats = {0};
+	CuAssertTrue(tc, mcc_unroll_function(&tac.functions[0], NULL, &stats));
+	struct mcc_unroll_options options = {.factor = 2, .budget = 5};
+	CuAssertTrue(tc, mcc_unroll_function(&tac.functions[0], &options, &stats));
+	CuAssertIntEquals(tc, 0, (int)stats.unrolled);
+
+	// Three copies fit into a budget of nine.
+	options.budget = 9;
+	options.factor = 8;
+	CuAssertTrue(tc, mcc_unroll_function(&tac.functions[0], &options, &stats));
+	CuAssertIntEquals(tc, 1, (int)stats.unrolled);
+	CuAssertIntEquals(tc, 3, (int)stats.copies);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, "012", output);
+	free(output);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Unroll_Lowered(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int up(int n, int step) {\n"
+	      "  int i; int s; int[64] a;\n"
+	      "  i = 0; s = 0;\n"
+	      "  while (i < n) { a[i] = i * 3; s = s + a[i]; i = i + 1; }\n"
+	      "  i = 1;\n"
+	      "  while (i <= n) { s = s + i; i = i + 2; }\n"
+	      "  return s;\n"
+	      "}\n"
+	      "int down(int n, int start) {\n"
+	      "  int i; int s;\n"
+	      "  i = start; s = 0;\n"
+	      "  while (i > n) { s = s + i / 7; i = i - 3; }\n"
+	      "  while (n >= i) { s = s + 1; i = i + 5; }\n"
+	      "  return s;\n"
+	      "}\n"
+	      "int main() {\n"
+	      "  int n; n = 0;\n"
+	      "  while (n < 12) { print_int(up(n, 1)); print_nl(); n = n + 1; }\n"
+	      "  print_int(up(64, 1)); print_nl();\n"
+	      "  print_int(up(-2147483647 - 1, 1)); print_nl();\n"
+	      "  print_int(down(-20, 20)); print_nl();\n"
+	      "  print_int(down(2147483640, 2147483647)); print_nl();\n"
+	      "  print_int(down(-2147483643, -2147483640)); print_nl();\n"
+	      "  return 0;\n"
+	      "}\n");
+
+	char *expected = run(tc, &tac);
+
+	// Copies of the incremented counters are coalesced in and out of SSA
+	// form.
+	CuAssertTrue(tc, mcc_pass_run_pipeline("sccp,gvn", &tac));
+	struct mcc_unroll_stats stats = {0};
+	for (size_t f = 0; f < tac.functions_count; f++) {
+		CuAssertTrue(tc, mcc_unroll_function(&tac.functions[f], NULL, &stats));
+	}
+
+	// Every loop, the remaining iterations differ between the calls.
+	CuAssertIntEquals(tc, 5, (int)stats.unrolled);
+
+	char *output = run(tc, &tac);
+	CuAssertStrEquals(tc, expected, output);
+	free(expected);
+	free(output);
+
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Unroll_Constant) \
+	TEST(Unroll_Budget) \
+	TEST(Unroll_Lowered)
+
+#include "main_stub.inc"
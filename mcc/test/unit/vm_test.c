@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CuTest.h>
+
+#include "mcc/ssa.h"
+#include "mcc/tac.h"
+
+#include "tac_fixture.inc"
+
+// Runs `main` of `input` reading `stdin`, returns the output.
+static char *run_source(CuTest *tc, const char *input, const char *stdin_text, struct mcc_vm_result *result)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, input);
+
+	struct mcc_vm vm;
+	*result = mcc_vm_compile(&vm, &tac);
+	CuAssertStrEquals(tc, "", result->error_msg);
+
+	char *output = NULL;
+	size_t output_size = 0;
+	struct mcc_vm_options options = {
+	    .in = fmemopen((void *)stdin_text, strlen(stdin_text) + 1, "r"),
+	    .out = open_memstream(&output, &output_size),
+	    .stack_size = 4096,
+	};
+	CuAssertPtrNotNull(tc, options.in);
+	CuAssertPtrNotNull(tc, options.out);
+
+	*result = mcc_vm_call(&vm, "main", NULL, 0, &options);
+	fclose(options.in);
+	fclose(options.out);
+
+	mcc_vm_deinit(&vm);
+	mcc_tac_program_deinit(&tac);
+	return output;
+}
+
+static void assert_output(CuTest *tc, const char *input, const char *stdin_text, const char *expected)
+{
+	struct mcc_vm_result result;
+	char *output = run_source(tc, input, stdin_text, &result);
+	CuAssertStrEquals(tc, "", result.error_msg);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, result.error);
+	CuAssertStrEquals(tc, expected, output);
+	free(output);
+}
+
+static void assert_run_error(CuTest *tc, const char *input, enum mcc_vm_error error, const char *message)
+{
+	struct mcc_vm_result result;
+	char *output = run_source(tc, input, "", &result);
+	CuAssertIntEquals(tc, error, result.error);
+	CuAssertStrEquals(tc, message, result.error_msg);
+	free(output);
+}
+
+void Vm_Arithmetic(CuTest *tc)
+{
+	assert_output(tc,
+	              "int main() {\n"
+	              "  int x; x = 2147483647;\n"
+	              "  print_int(x + 1); print_nl();\n"
+	              "  print_int(-7 / 2); print_nl();\n"
+	              "  print_int(10 - x / 1000000000 * 3); print_nl();\n"
+	              "  print_int((-2147483647 - 1) / (0 - 1)); print_nl();\n"
+	              "  print_float(1.0 / 3.0 - 2.5 * 2.0); print_nl();\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "", "-2147483648\n-3\n4\n-2147483648\n-4.67\n");
+}
+
+void Vm_Comparisons(CuTest *tc)
+{
+	// Constants on either side, comparisons feeding jumps and values.
+	assert_output(tc,
+	              "int main() {\n"
+	              "  int i; i = 0;\n"
+	              "  while (3 > i) { print_int(i); i = i + 1; }\n"
+	              "  bool b; b = i >= 3 && !(i == 4);\n"
+	              "  if (b) print(\"b\");\n"
+	              "  float f; f = 0.5;\n"
+	              "  while (!(f >= 2.0)) f = f * 2.0;\n"
+	              "  if (f == 2.0) print(\"f\");\n"
+	              "  if (1.0 < f) print(\"<\");\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "", "012bf<");
+}
+
+void Vm_Calls(CuTest *tc)
+{
+	assert_output(tc,
+	              "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+	              "void fill(int[4] a, int v) { int i; i = 0; while (i < 4) { a[i] = v + i; i = i + 1; } }\n"
+	              "float half(float x) { return x / 2.0; }\n"
+	              "int main() {\n"
+	              "  int[4] a; fill(a, read_int());\n"
+	              "  print_int(a[0] + a[3]); print_nl();\n"
+	              "  print_int(fib(15)); print_nl();\n"
+	              "  print_float(half(read_float())); print_nl();\n"
+	              "  print(\"done\");\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "10 5.5", "23\n610\n2.75\ndone");
+}
+
+void Vm_UnassignedString(CuTest *tc)
+{
+	assert_output(tc,
+	              "void show(string s) { print(s); }\n"
+	              "int main() {\n"
+	              "  string s; string[2] a;\n"
+	              "  print(\"<\"); print(s); print(a[1]); show(s); print(\">\");\n"
+	              "  return 0;\n"
+	              "}\n",
+	              "", "<>");
+}
+
+void Vm_ReturnValue(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac, "int square(int x) { return x * x; }\nint main() { return square(7); }");
+
+	struct mcc_vm vm;
+	struct mcc_vm_result result = mcc_vm_compile(&vm, &tac);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, result.error);
+
+	result = mcc_vm_call(&vm, "main", NULL, 0, NULL);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, result.error);
+	CuAssertIntEquals(tc, 49, result.value.i);
+
+	union mcc_vm_value argument = {.i = -12};
+	result = mcc_vm_call(&vm, "square", &argument, 1, NULL);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, result.error);
+	CuAssertIntEquals(tc, 144, result.value.i);
+
+	result = mcc_vm_call(&vm, "cube", &argument, 1, NULL);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_UNKNOWN_FUNCTION, result.error);
+
+	mcc_vm_deinit(&vm);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Vm_RuntimeErrors(CuTest *tc)
+{
+	assert_run_error(tc, "int main() { int x; x = 0; return 1 / x; }", MCC_VM_ERROR_DIVISION_BY_ZERO,
+	                 "division by zero in main");
+	assert_run_error(tc, "void f() { f(); }\nint main() { f(); return 0; }", MCC_VM_ERROR_STACK_OVERFLOW,
+	                 "stack overflow calling f");
+	assert_run_error(tc, "int main() { int[4] a; a[-1000000] = 1; return 0; }", MCC_VM_ERROR_INVALID_ACCESS,
+	                 "index -1000000 is outside the stack in main");
+}
+
+void Vm_Fuel(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	lower(tc, &tac,
+	      "int loop(int n) { int i; i = 0; while (i < n) i = i + 1; return i; }\n"
+	      "int depth(int n) { if (n == 0) return 0; return depth(n - 1) + 1; }\n"
+	      "int main() { return 0; }");
+
+	struct mcc_vm vm;
+	struct mcc_vm_result result = mcc_vm_compile(&vm, &tac);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, result.error);
+
+	// A loop of n iterations takes n + 1 jumps.
+	struct mcc_vm_options options = {.fuel = 12};
+	union mcc_vm_value argument = {.i = 10};
+	result = mcc_vm_call(&vm, "loop", &argument, 1, &options);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_NONE, result.error);
+	CuAssertIntEquals(tc, 10, result.value.i);
+
+	argument.i = 11;
+	result = mcc_vm_call(&vm, "loop", &argument, 1, &options);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_OUT_OF_FUEL, result.error);
+	CuAssertStrEquals(tc, "out of fuel in loop", result.error_msg);
+
+	result = mcc_vm_call(&vm, "depth", &argument, 1, &options);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_OUT_OF_FUEL, result.error);
+
+	mcc_vm_deinit(&vm);
+	mcc_tac_program_deinit(&tac);
+}
+
+void Vm_CompileErrors(CuTest *tc)
+{
+	struct mcc_tac_program tac;
+	mcc_tac_program_init(&tac);
+	struct mcc_tac_parser_result parser_result = mcc_tac_parse_string(&tac,
+	                                                                  "function int main(0)\n"
+	                                                                  "\tv1 = CALL int g()\n"
+	                                                                  "\tRETURN int v1\n");
+	CuAssertIntEquals(tc, MCC_TAC_PARSER_ERROR_NONE, parser_result.error);
+
+	struct mcc_vm vm;
+	struct mcc_vm_result result = mcc_vm_compile(&vm, &tac);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_UNKNOWN_FUNCTION, result.error);
+	CuAssertStrEquals(tc, "main calls unknown function g", result.error_msg);
+	mcc_vm_deinit(&vm);
+	mcc_tac_program_deinit(&tac);
+
+	// SSA form is rejected.
+	lower(tc, &tac, "int main() { int x; x = 1; if (read_int() > 0) x = 2; return x; }");
+	CuAssertTrue(tc, mcc_ssa_construct(&tac.functions[0]));
+	result = mcc_vm_compile(&vm, &tac);
+	CuAssertIntEquals(tc, MCC_VM_ERROR_INVALID_PROGRAM, result.error);
+	mcc_vm_deinit(&vm);
+	mcc_tac_program_deinit(&tac);
+}
+
+#define TESTS \
+	TEST(Vm_Arithmetic) \
+	TEST(Vm_Comparisons) \
+	TEST(Vm_Calls) \
+	TEST(Vm_UnassignedString) \
+	TEST(Vm_ReturnValue) \
+	TEST(Vm_RuntimeErrors) \
+	TEST(Vm_Fuel) \
+	TEST(Vm_CompileErrors)
+
+#include "main_stub.inc"